@@ -0,0 +1,114 @@
+/**
+ * @file ethernet_frame_benchmark.cpp
+ * @brief Benchmarks for Ethernet frame parsing and serialization
+ */
+
+#include "project/ethernet_frame.hpp"
+#include "project/frame_classifier.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+using namespace project;
+
+namespace
+{
+  std::vector<uint8_t> make_frame(size_t frame_size)
+  {
+    std::vector<uint8_t> payload(frame_size - ETHERNET_HEADER_SIZE, 0x5a);
+    EthernetFrame frame(MacAddress({ 0x02, 0x00, 0x00, 0x00, 0x00, 0x02 }),
+                        MacAddress({ 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 }), EtherType::IPv4, std::move(payload));
+    return frame.serialize();
+  }
+}  // namespace
+
+static void BM_EthernetFrameParse(benchmark::State& state)
+{
+  const std::vector<uint8_t> data = make_frame(static_cast<size_t>(state.range(0)));
+  for (auto _ : state)
+  {
+    EthernetFrame frame = EthernetFrame::parse(data);
+    benchmark::DoNotOptimize(frame);
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_EthernetFrameParse)->Arg(64)->Arg(512)->Arg(1518);
+
+static void BM_EthernetFrameSerialize(benchmark::State& state)
+{
+  const EthernetFrame frame = EthernetFrame::parse(make_frame(static_cast<size_t>(state.range(0))));
+  for (auto _ : state)
+  {
+    std::vector<uint8_t> data = frame.serialize();
+    benchmark::DoNotOptimize(data.data());
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_EthernetFrameSerialize)->Arg(64)->Arg(512)->Arg(1518);
+
+// The zero-copy header view used by the forwarding path, for comparison with parse()
+static void BM_EthernetFrameView(benchmark::State& state)
+{
+  const std::vector<uint8_t> data = make_frame(static_cast<size_t>(state.range(0)));
+  for (auto _ : state)
+  {
+    EthernetFrameView frame(data.data(), data.size());
+    MacAddress dst = frame.dst_mac();
+    MacAddress src = frame.src_mac();
+    benchmark::DoNotOptimize(dst);
+    benchmark::DoNotOptimize(src);
+  }
+}
+BENCHMARK(BM_EthernetFrameView)->Arg(64)->Arg(1518);
+
+static void BM_MacAddressFromString(benchmark::State& state)
+{
+  for (auto _ : state)
+  {
+    MacAddress mac = MacAddress::from_string("02:42:ac:11:00:02");
+    benchmark::DoNotOptimize(mac);
+  }
+}
+BENCHMARK(BM_MacAddressFromString);
+
+static void BM_MacAddressToString(benchmark::State& state)
+{
+  const MacAddress mac({ 0x02, 0x42, 0xac, 0x11, 0x00, 0x02 });
+  for (auto _ : state)
+  {
+    std::string text = mac.to_string();
+    benchmark::DoNotOptimize(text.data());
+  }
+}
+BENCHMARK(BM_MacAddressToString);
+
+// A received burst of 64-byte frames classified at each instruction set (unsupported ones run scalar)
+static void BM_ClassifyBurst(benchmark::State& state)
+{
+  const auto level = static_cast<SimdLevel>(state.range(0));
+  constexpr size_t burst = 32;
+  std::vector<std::vector<uint8_t>> storage(burst, make_frame(64));
+  std::vector<const uint8_t*> frames;
+  std::vector<size_t> sizes;
+  for (const auto& frame : storage)
+  {
+    frames.push_back(frame.data());
+    sizes.push_back(frame.size());
+  }
+  std::vector<FrameKeys> keys(burst);
+
+  for (auto _ : state)
+  {
+    classify_frames(level, frames.data(), sizes.data(), burst, keys.data());
+    benchmark::DoNotOptimize(keys.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetLabel(simd_level_supported(level) ? to_string(level) : "scalar (unsupported)");
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(burst));
+}
+BENCHMARK(BM_ClassifyBurst)
+    ->Arg(static_cast<int>(SimdLevel::Scalar))
+    ->Arg(static_cast<int>(SimdLevel::Ssse3))
+    ->Arg(static_cast<int>(SimdLevel::Avx2))
+    ->Arg(static_cast<int>(SimdLevel::Neon));
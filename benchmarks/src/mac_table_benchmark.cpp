@@ -0,0 +1,180 @@
+/**
+ * @file mac_table_benchmark.cpp
+ * @brief Benchmarks for MAC learning tables under 1..N threads and varying sizes
+ *
+ * Each benchmark shares one table between all its threads, as forwarding
+ * workers do. The table is filled in a Setup hook, before any thread starts
+ * timing.
+ */
+
+#include "project/concurrent_mac_table.hpp"
+#include "project/mac_table.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <vector>
+
+using namespace project;
+
+namespace
+{
+  std::vector<MacAddress> g_macs;
+  std::vector<Endpoint> g_endpoints;
+  std::unique_ptr<MacTable> g_mac_table;
+  std::unique_ptr<ConcurrentMacTable> g_concurrent_table;
+
+  Endpoint endpoint_for(size_t i)
+  {
+    return Endpoint("10.0." + std::to_string((i >> 8) & 0xff) + "." + std::to_string(i & 0xff), 4789);
+  }
+
+  void make_macs(size_t count)
+  {
+    g_macs.clear();
+    g_endpoints.clear();
+    for (size_t i = 0; i < count; ++i)
+    {
+      // Locally administered, sequential NIC part: the OUI-heavy pattern real networks show
+      g_macs.push_back(MacAddress::from_u64(0x020000000000ull | i));
+      g_endpoints.push_back(endpoint_for(i));
+    }
+  }
+
+  void setup_mac_table(const benchmark::State& state)
+  {
+    make_macs(static_cast<size_t>(state.range(0)));
+    g_mac_table = std::make_unique<MacTable>();
+    for (size_t i = 0; i < g_macs.size(); ++i)
+    {
+      g_mac_table->insert(g_macs[i], g_endpoints[i]);
+    }
+  }
+
+  void teardown_mac_table(const benchmark::State&)
+  {
+    g_mac_table.reset();
+  }
+
+  void setup_concurrent_table(const benchmark::State& state)
+  {
+    make_macs(static_cast<size_t>(state.range(0)));
+    g_concurrent_table = std::make_unique<ConcurrentMacTable>();
+    for (size_t i = 0; i < g_macs.size(); ++i)
+    {
+      g_concurrent_table->insert(g_macs[i], g_endpoints[i]);
+    }
+  }
+
+  void teardown_concurrent_table(const benchmark::State&)
+  {
+    g_concurrent_table.reset();
+  }
+
+  /**
+   * @brief Index sequence that visits the table in a scattered, per-thread order
+   */
+  size_t next_index(size_t index, size_t count) noexcept
+  {
+    return (index + 7919) % count;  // Prime stride
+  }
+}  // namespace
+
+static void BM_MacTableLookup(benchmark::State& state)
+{
+  const size_t count = g_macs.size();
+  size_t index = static_cast<size_t>(state.thread_index()) % count;
+  for (auto _ : state)
+  {
+    auto endpoint = g_mac_table->lookup(g_macs[index]);
+    benchmark::DoNotOptimize(endpoint);
+    index = next_index(index, count);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MacTableLookup)
+    ->Setup(setup_mac_table)
+    ->Teardown(teardown_mac_table)
+    ->RangeMultiplier(16)
+    ->Range(16, 65536)
+    ->ThreadRange(1, 4)
+    ->UseRealTime();
+
+// Re-learning a known MAC: what every received frame does to its source address
+static void BM_MacTableRelearn(benchmark::State& state)
+{
+  const size_t count = g_macs.size();
+  size_t index = static_cast<size_t>(state.thread_index()) % count;
+  for (auto _ : state)
+  {
+    bool is_new = g_mac_table->insert(g_macs[index], g_endpoints[index]);
+    benchmark::DoNotOptimize(is_new);
+    index = next_index(index, count);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MacTableRelearn)
+    ->Setup(setup_mac_table)
+    ->Teardown(teardown_mac_table)
+    ->RangeMultiplier(16)
+    ->Range(16, 65536)
+    ->ThreadRange(1, 4)
+    ->UseRealTime();
+
+static void BM_ConcurrentMacTableLookup(benchmark::State& state)
+{
+  const size_t count = g_macs.size();
+  size_t index = static_cast<size_t>(state.thread_index()) % count;
+  for (auto _ : state)
+  {
+    auto endpoint = g_concurrent_table->lookup(g_macs[index]);
+    benchmark::DoNotOptimize(endpoint);
+    index = next_index(index, count);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ConcurrentMacTableLookup)
+    ->Setup(setup_concurrent_table)
+    ->Teardown(teardown_concurrent_table)
+    ->RangeMultiplier(16)
+    ->Range(16, 65536)
+    ->ThreadRange(1, 4)
+    ->UseRealTime();
+
+static void BM_ConcurrentMacTableRelearn(benchmark::State& state)
+{
+  const size_t count = g_macs.size();
+  size_t index = static_cast<size_t>(state.thread_index()) % count;
+  for (auto _ : state)
+  {
+    bool is_new = g_concurrent_table->insert(g_macs[index], g_endpoints[index]);
+    benchmark::DoNotOptimize(is_new);
+    index = next_index(index, count);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ConcurrentMacTableRelearn)
+    ->Setup(setup_concurrent_table)
+    ->Teardown(teardown_concurrent_table)
+    ->RangeMultiplier(16)
+    ->Range(16, 65536)
+    ->ThreadRange(1, 4)
+    ->UseRealTime();
+
+// Learning fresh MACs into an empty table, including growth
+static void BM_ConcurrentMacTableFill(benchmark::State& state)
+{
+  make_macs(static_cast<size_t>(state.range(0)));
+
+  for (auto _ : state)
+  {
+    ConcurrentMacTable table;
+    for (size_t i = 0; i < g_macs.size(); ++i)
+    {
+      table.insert(g_macs[i], g_endpoints[i]);
+    }
+    benchmark::DoNotOptimize(table.size());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ConcurrentMacTableFill)->RangeMultiplier(16)->Range(16, 65536);
@@ -0,0 +1,145 @@
+/**
+ * @file vswitch_benchmark.cpp
+ * @brief End-to-end forwarding benchmarks through a VSwitch on loopback
+ *
+ * Two UDP sockets stand in for VPorts. One sends bursts of unicast frames
+ * to the other through a running VSwitch, so each iteration covers receive,
+ * process_frame() (learning and lookup) and send on the switch side.
+ */
+
+#include "project/frame_pool.hpp"
+#include "project/logger.hpp"
+#include "project/udp_socket.hpp"
+#include "project/vswitch.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace project;
+
+namespace
+{
+  const MacAddress PORT_A_MAC({ 0x02, 0x00, 0x00, 0x00, 0x00, 0x0a });
+  const MacAddress PORT_B_MAC({ 0x02, 0x00, 0x00, 0x00, 0x00, 0x0b });
+
+  /**
+   * @brief A running VSwitch with two learned loopback ports
+   */
+  struct Loopback
+  {
+    VSwitch vswitch;
+    std::thread switch_thread;
+    UdpSocket port_a;
+    UdpSocket port_b;
+    Endpoint switch_endpoint;
+
+    bool open(size_t workers)
+    {
+      Logger::instance().set_level(LogLevel::Warn);  // Keep start/stop messages out of the report
+
+      VSwitchConfig config;
+      config.workers = workers;
+      auto vswitch_result = VSwitch::create(config);
+      auto a_result = UdpSocket::create();
+      auto b_result = UdpSocket::create();
+      if (!vswitch_result || !a_result || !b_result)
+      {
+        return false;
+      }
+
+      vswitch = std::move(*vswitch_result);
+      port_a = std::move(*a_result);
+      port_b = std::move(*b_result);
+      if (!port_a.bind("127.0.0.1", 0) || !port_b.bind("127.0.0.1", 0) ||
+          !port_b.set_receive_timeout(std::chrono::milliseconds(500)))
+      {
+        return false;
+      }
+
+      switch_endpoint = Endpoint("127.0.0.1", vswitch.port());
+      switch_thread = std::thread([this]() { [[maybe_unused]] auto result = vswitch.start(); });
+
+      // Teach the switch where both MACs live; the frames themselves are unknown unicast
+      const MacAddress nobody({ 0x02, 0x00, 0x00, 0x00, 0xff, 0xff });
+      auto learn_a = EthernetFrame(nobody, PORT_A_MAC, EtherType::IPv4).serialize();
+      auto learn_b = EthernetFrame(nobody, PORT_B_MAC, EtherType::IPv4).serialize();
+      for (int attempt = 0; attempt < 200 && vswitch.learned_macs() < 2; ++attempt)
+      {
+        [[maybe_unused]] auto sent_a = port_a.send_to(learn_a, switch_endpoint);
+        [[maybe_unused]] auto sent_b = port_b.send_to(learn_b, switch_endpoint);
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      }
+      return vswitch.learned_macs() == 2;
+    }
+
+    ~Loopback()
+    {
+      vswitch.stop();
+      if (switch_thread.joinable())
+      {
+        switch_thread.join();
+      }
+    }
+  };
+}  // namespace
+
+// Args: frame size, burst size, switch workers
+static void BM_VSwitchUnicastForward(benchmark::State& state)
+{
+  const auto frame_size = static_cast<size_t>(state.range(0));
+  const auto burst = static_cast<size_t>(state.range(1));
+
+  Loopback loopback;
+  if (!loopback.open(static_cast<size_t>(state.range(2))))
+  {
+    state.SkipWithError("Could not set up the loopback switch");
+    return;
+  }
+
+  std::vector<uint8_t> payload(frame_size - ETHERNET_HEADER_SIZE, 0x5a);
+  const auto frame = EthernetFrame(PORT_B_MAC, PORT_A_MAC, EtherType::IPv4, payload).serialize();
+  std::vector<OutboundDatagram> tx(burst, OutboundDatagram{ frame.data(), frame.size(), loopback.switch_endpoint });
+
+  FramePool pool(burst);
+  std::vector<FrameBuffer> buffers;
+  std::vector<InboundDatagram> rx(burst);
+  for (size_t i = 0; i < burst; ++i)
+  {
+    buffers.push_back(pool.acquire());
+    rx[i].data = buffers[i].data();
+    rx[i].capacity = buffers[i].capacity();
+  }
+
+  uint64_t lost = 0;
+  for (auto _ : state)
+  {
+    [[maybe_unused]] auto sent = loopback.port_a.send_batch(tx);
+
+    size_t received = 0;
+    while (received < burst)
+    {
+      auto result = loopback.port_b.receive_batch(rx);
+      if (!result)
+      {
+        break;  // Timed out: the rest of the burst was dropped somewhere
+      }
+      received += *result;
+    }
+    lost += burst - received;
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(1));
+  state.SetBytesProcessed(state.iterations() * state.range(1) * state.range(0));
+  state.counters["lost_frames"] = static_cast<double>(lost);
+}
+BENCHMARK(BM_VSwitchUnicastForward)
+    ->ArgNames({ "frame_size", "burst", "workers" })
+    ->Args({ 64, 1, 1 })
+    ->Args({ 64, 32, 1 })
+    ->Args({ 1518, 1, 1 })
+    ->Args({ 1518, 32, 1 })
+    ->Args({ 64, 32, 2 })
+    ->UseRealTime();
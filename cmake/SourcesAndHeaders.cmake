@@ -1,12 +1,32 @@
 set(sources
     src/tmp.cpp
     src/sys_utils.cpp
+    src/logger.cpp
+    src/traffic_stats.cpp
+    src/latency_histogram.cpp
+    src/frame_pool.cpp
+    src/offload.cpp
     src/tap_device.cpp
     src/ethernet_frame.cpp
+    src/frame_classifier.cpp
+    src/frame_coalescing.cpp
     src/udp_socket.cpp
+    src/event_loop.cpp
+    src/io_uring.cpp
     src/vport.cpp
+    src/mac_aging.cpp
     src/mac_table.cpp
+    src/concurrent_mac_table.cpp
+    src/mac_snapshot.cpp
+    src/vlan.cpp
+    src/multicast_snooping.cpp
+    src/qos.cpp
+    src/socket_handoff.cpp
+    src/packet_ring.cpp
+    src/tunnel_crypto.cpp
+    src/cluster.cpp
     src/vswitch.cpp
+    src/load_generator.cpp
 )
 
 set(exe_sources
@@ -19,12 +39,35 @@ set(headers
     include/project/expected.hpp
     include/project/joining_thread.hpp
     include/project/sys_utils.hpp
+    include/project/logger.hpp
+    include/project/traffic_stats.hpp
+    include/project/latency_histogram.hpp
+    include/project/frame_pool.hpp
+    include/project/offload.hpp
     include/project/tap_device.hpp
     include/project/ethernet_frame.hpp
+    include/project/frame_classifier.hpp
+    include/project/frame_coalescing.hpp
+    include/project/hash.hpp
     include/project/udp_socket.hpp
+    include/project/event_loop.hpp
+    include/project/io_uring.hpp
     include/project/vport.hpp
+    include/project/flat_mac_map.hpp
+    include/project/mac_aging.hpp
     include/project/mac_table.hpp
+    include/project/concurrent_mac_table.hpp
+    include/project/flow_cache.hpp
+    include/project/mac_snapshot.hpp
+    include/project/vlan.hpp
+    include/project/multicast_snooping.hpp
+    include/project/qos.hpp
+    include/project/socket_handoff.hpp
+    include/project/packet_ring.hpp
+    include/project/tunnel_crypto.hpp
+    include/project/cluster.hpp
     include/project/vswitch.hpp
+    include/project/load_generator.hpp
 )
 
 set(test_sources
@@ -32,9 +75,37 @@ set(test_sources
   src/expected_test.cpp
   src/joining_thread_test.cpp
   src/sys_utils_test.cpp
+  src/logger_test.cpp
+  src/traffic_stats_test.cpp
+  src/latency_histogram_test.cpp
+  src/frame_pool_test.cpp
+  src/offload_test.cpp
   src/tap_device_test.cpp
   src/ethernet_frame_test.cpp
+  src/frame_classifier_test.cpp
+  src/frame_coalescing_test.cpp
   src/udp_socket_test.cpp
+  src/event_loop_test.cpp
+  src/io_uring_test.cpp
+  src/flat_mac_map_test.cpp
+  src/mac_aging_test.cpp
   src/mac_table_test.cpp
+  src/concurrent_mac_table_test.cpp
+  src/flow_cache_test.cpp
+  src/mac_snapshot_test.cpp
+  src/vlan_test.cpp
+  src/multicast_snooping_test.cpp
+  src/qos_test.cpp
+  src/socket_handoff_test.cpp
+  src/packet_ring_test.cpp
+  src/tunnel_crypto_test.cpp
+  src/cluster_test.cpp
+  src/load_generator_test.cpp
   src/integration_test.cpp
 )
+
+set(benchmark_sources
+  src/ethernet_frame_benchmark.cpp
+  src/mac_table_benchmark.cpp
+  src/vswitch_benchmark.cpp
+)
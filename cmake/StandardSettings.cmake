@@ -32,6 +32,13 @@ option(${PROJECT_NAME}_USE_GOOGLE_MOCK "Use the GoogleMock project for extending
 
 option(${PROJECT_NAME}_USE_CATCH2 "Use the Catch2 project for creating unit tests." OFF)
 
+#
+# Benchmarks
+#
+# Currently supporting: Google Benchmark.
+
+option(${PROJECT_NAME}_ENABLE_BENCHMARKS "Build the micro-benchmarks (from the `benchmarks` folder)." OFF)
+
 #
 # Static analyzers
 #
@@ -59,6 +66,22 @@ option(${PROJECT_NAME}_ENABLE_DOXYGEN "Enable Doxygen documentation builds of so
 # Generate compile_commands.json for clang based tools
 set(CMAKE_EXPORT_COMPILE_COMMANDS ON)
 
+# Messages below this level are compiled out; TRACE enables the per-frame forwarding logs
+set(${PROJECT_NAME}_LOG_LEVEL "DEBUG" CACHE STRING "Lowest log level compiled in (TRACE, DEBUG, INFO, WARN, ERROR, OFF).")
+set_property(CACHE ${PROJECT_NAME}_LOG_LEVEL PROPERTY STRINGS TRACE DEBUG INFO WARN ERROR OFF)
+
+# Per-frame receive-to-send latency histograms in VSwitch and VPort; compiled out when OFF
+option(${PROJECT_NAME}_ENABLE_LATENCY_HISTOGRAMS "Record per-frame forwarding latency histograms." OFF)
+
+# io_uring I/O backend for VPort and VSwitch; only built if the kernel headers are recent enough (Linux 6.0+)
+option(${PROJECT_NAME}_ENABLE_IO_URING "Build the io_uring I/O backend when the kernel headers support it." ON)
+
+# SSSE3/AVX2/NEON burst classification, picked at run time; OFF builds only the scalar code
+option(${PROJECT_NAME}_ENABLE_SIMD "Classify received bursts with SIMD instructions when the CPU supports them." ON)
+
+# Encrypted VPort/VSwitch transport; only built if OpenSSL (libcrypto 1.1.1 or later) is found
+option(${PROJECT_NAME}_ENABLE_ENCRYPTION "Build the AEAD-encrypted tunnel transport when OpenSSL is found." ON)
+
 option(${PROJECT_NAME}_VERBOSE_OUTPUT "Enable verbose output, allowing for a better understanding of each step taken." ON)
 option(${PROJECT_NAME}_GENERATE_EXPORT_HEADER "Create a `project_export.h` file containing all exported symbols." OFF)
 
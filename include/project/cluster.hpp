@@ -0,0 +1,251 @@
+/**
+ * @file cluster.hpp
+ * @brief Several VSwitch nodes acting as one switch
+ *
+ * Each node serves the VPorts connected to it and tells its peers which
+ * MACs it learned behind them; a peer maps those MACs to the node's own
+ * address, so frames for them cross over node to node and are forwarded
+ * there like any frame from a VPort. What changed over a sync interval
+ * goes to every peer in update datagrams of fixed-size records:
+ *
+ *   00:00:00:00:00:00 | 00:00:00:00:00:00 | 0x88B6 | version (1) | records
+ *   record: kind (1 learn, 2 withdraw) | u16 VLAN (network order) | 6-byte MAC
+ *
+ * Only changes are sent, plus every entry again each refresh interval,
+ * which also keeps the peers' copies from aging out and brings a
+ * restarted peer up to date. Like an aggregate (frame_coalescing.hpp),
+ * an update looks like a frame to an unknown MAC to anything that does
+ * not know the format; 0x88B6 is the second IEEE local experimental EtherType.
+ *
+ * A VPort given several nodes moves to the next one when it has heard
+ * nothing for a while, and the node it reaches announces its MACs.
+ */
+
+#ifndef PROJECT_CLUSTER_HPP_
+#define PROJECT_CLUSTER_HPP_
+
+#include "project/concurrent_mac_table.hpp"
+#include "project/ethernet_frame.hpp"
+#include "project/expected.hpp"
+#include "project/frame_classifier.hpp"
+#include "project/udp_socket.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace project
+{
+  /**
+   * @brief EtherType of a MAC update (IEEE 802 local experimental 2)
+   */
+  constexpr uint16_t CLUSTER_ETHERTYPE = 0x88B6;
+
+  /**
+   * @brief Update format version
+   */
+  constexpr uint8_t CLUSTER_VERSION = 1;
+
+  /**
+   * @brief Bytes in front of the first record: Ethernet header and version
+   */
+  constexpr size_t CLUSTER_HEADER_SIZE = 15;
+
+  /**
+   * @brief Size of one record in bytes
+   */
+  constexpr size_t CLUSTER_RECORD_SIZE = 9;
+
+  /**
+   * @brief Largest update datagram: a 1500-byte MTU less IPv4 and UDP headers
+   */
+  constexpr size_t CLUSTER_MAX_DATAGRAM_SIZE = 1472;
+
+  /**
+   * @brief Most records in one update datagram
+   */
+  constexpr size_t CLUSTER_MAX_RECORDS = (CLUSTER_MAX_DATAGRAM_SIZE - CLUSTER_HEADER_SIZE) / CLUSTER_RECORD_SIZE;
+
+  /**
+   * @brief Default time between two rounds of updates
+   */
+  constexpr std::chrono::milliseconds CLUSTER_DEFAULT_SYNC_INTERVAL{ 100 };
+
+  /**
+   * @brief Longest time between two announcements of an unchanged entry
+   */
+  constexpr std::chrono::seconds CLUSTER_REFRESH_INTERVAL{ 10 };
+
+  /**
+   * @brief Default silence after which a VPort moves to the next node
+   */
+  constexpr std::chrono::milliseconds FAILOVER_DEFAULT_TIMEOUT{ 3000 };
+
+  /**
+   * @brief Error codes for cluster operations
+   */
+  enum class ClusterError
+  {
+    NotAnUpdate,
+    Malformed,
+    InvalidNode
+  };
+
+  /**
+   * @brief Convert ClusterError to string representation
+   * @param error The error code
+   * @return String description of the error
+   */
+  [[nodiscard]] const char* to_string(ClusterError error) noexcept;
+
+  /**
+   * @brief What a record says about a MAC
+   */
+  enum class MacUpdateKind : uint8_t
+  {
+    Learn = 1,    ///< The MAC is behind the sending node
+    Withdraw = 2  ///< It no longer is
+  };
+
+  /**
+   * @brief One record of a MAC update
+   */
+  struct MacUpdate
+  {
+    MacUpdateKind kind = MacUpdateKind::Learn;
+    uint16_t vlan = 0;
+    MacAddress mac;
+  };
+
+  /**
+   * @brief Check whether classified keys are those of a MAC update (a cheap first test)
+   */
+  [[nodiscard]] inline bool is_cluster_update(const FrameKeys& keys) noexcept
+  {
+    return keys.dst == 0 && keys.src == 0 && keys.ethertype == CLUSTER_ETHERTYPE && keys.kind == FrameClass::Unicast;
+  }
+
+  /**
+   * @brief Parse a node address, "IPV4:PORT"
+   *
+   * VSwitch and VPort sockets are IPv4 only, so an IPv6 node is refused
+   * here rather than becoming a peer no datagram can reach.
+   * @return expected<Endpoint, ClusterError> The endpoint or InvalidNode
+   */
+  [[nodiscard]] expected<Endpoint, ClusterError> parse_cluster_node(std::string_view text);
+
+  /**
+   * @brief Encode records into as few update datagrams as they fit in
+   * @param updates The records
+   * @return The datagrams (none without records)
+   */
+  [[nodiscard]] std::vector<std::vector<uint8_t>> encode_mac_updates(const std::vector<MacUpdate>& updates);
+
+  /**
+   * @brief Decode an update datagram
+   *
+   * Records of an unknown kind or for a VLAN above VLAN_MAX_ID are
+   * skipped.
+   *
+   * @param data The datagram
+   * @param size Its size
+   * @param updates Replaced with the records
+   * @return expected<size_t, ClusterError> Number of records, NotAnUpdate or Malformed
+   */
+  [[nodiscard]] expected<size_t, ClusterError> decode_mac_updates(const uint8_t* data, size_t size,
+                                                                  std::vector<MacUpdate>& updates);
+
+  /**
+   * @brief Remembers what a node announced, to send only what changed
+   *
+   * Not thread-safe; the VSwitch calls it from one thread.
+   */
+  class MacSyncTracker
+  {
+  private:
+    std::unordered_set<uint64_t> announced_;  // VLAN << 48 | MAC
+
+  public:
+    /**
+     * @brief Compare the entries a node owns with what it announced last
+     * @param owned The entries learned from the node's own VPorts
+     * @param refresh Announce every entry, not only new ones
+     * @return Learn records for new (or, with refresh, all) entries, Withdraw records for vanished ones
+     */
+    [[nodiscard]] std::vector<MacUpdate> changes(const std::vector<LearnedMac>& owned, bool refresh);
+
+    /**
+     * @brief Get the number of entries announced and not withdrawn
+     */
+    [[nodiscard]] size_t announced() const noexcept
+    {
+      return announced_.size();
+    }
+  };
+
+  /**
+   * @brief Picks which node of a cluster a VPort sends to
+   *
+   * A VPort sends to active() and reports everything it receives with
+   * heard(). When poll() finds that nothing was heard for the timeout
+   * since the active node was chosen, the next node takes over. Since
+   * all nodes form one switch, moving while merely idle costs only the
+   * MAC updates that follow.
+   */
+  class VSwitchFailover
+  {
+  private:
+    std::vector<Endpoint> nodes_;
+    uint64_t timeout_ns_;
+    size_t active_ = 0;
+    uint64_t since_ns_ = 0;                // When active_ was chosen, 0 before the first poll()
+    std::atomic<uint64_t> heard_ns_{ 0 };  // Written by the receiving side
+
+  public:
+    /**
+     * @brief Construct a failover over nodes, the first one active
+     * @param nodes The nodes in order of preference (at least one)
+     * @param timeout Silence after which the next node takes over
+     */
+    VSwitchFailover(std::vector<Endpoint> nodes, std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Get the node to send to
+     */
+    [[nodiscard]] const Endpoint& active() const noexcept
+    {
+      return nodes_[active_];
+    }
+
+    /**
+     * @brief Get the number of nodes
+     */
+    [[nodiscard]] size_t size() const noexcept
+    {
+      return nodes_.size();
+    }
+
+    /**
+     * @brief Note that a datagram came in (any thread)
+     * @param now_ns Current steady clock time in nanoseconds
+     */
+    void heard(uint64_t now_ns) noexcept
+    {
+      heard_ns_.store(now_ns, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Move to the next node if the active one has been silent too long (sending thread)
+     * @param now_ns Current steady clock time in nanoseconds
+     * @return true if the active node changed
+     */
+    bool poll(uint64_t now_ns) noexcept;
+  };
+
+}  // namespace project
+
+#endif  // PROJECT_CLUSTER_HPP_
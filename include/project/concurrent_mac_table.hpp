@@ -0,0 +1,416 @@
+/**
+ * @file concurrent_mac_table.hpp
+ * @brief MAC learning table with lock-free lookups
+ *
+ * Provides an open-addressing MAC → endpoint table for read-mostly
+ * forwarding paths. Lookups never take a lock or write shared memory, so
+ * any number of forwarding threads can query it without bouncing cache
+ * lines between cores; writers serialize on a mutex.
+ */
+
+#ifndef PROJECT_CONCURRENT_MAC_TABLE_HPP_
+#define PROJECT_CONCURRENT_MAC_TABLE_HPP_
+
+#include "project/ethernet_frame.hpp"
+#include "project/mac_aging.hpp"
+#include "project/udp_socket.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace project
+{
+  /**
+   * @brief Initial number of slots in a ConcurrentMacTable (a power of two)
+   */
+  constexpr size_t CONCURRENT_MAC_TABLE_INITIAL_CAPACITY = 256;
+
+  /**
+   * @brief One learned MAC with everything the table knows about it
+   */
+  struct LearnedMac
+  {
+    uint16_t vlan = 0;
+    MacAddress mac;
+    Endpoint endpoint;
+    MacTimestamp last_seen = 0;
+  };
+
+  /**
+   * @brief MAC learning table with lock-free reads
+   *
+   * Drop-in alternative to MacTable for the forwarding path. Entries live in
+   * a linear-probing array of cache-line-sized slots, each guarded by its own
+   * sequence lock:
+   * - lookup() probes the array without locking; a torn read is detected
+   *   via the slot sequence number and simply retried.
+   * - insert() first checks for an identical entry without locking, so
+   *   re-learning an unchanged MAC (the common case) costs at most one
+   *   relaxed store to refresh the entry's coarse timestamp.
+   * - Real changes take a writer mutex and touch only the affected slot.
+   * - expire() evicts entries not refreshed within the aging time; it is
+   *   meant to run from a background AgingSweeper.
+   * - Writers also maintain the deduplicated list of endpoints (the flood
+   *   list). Its generation changes only when an endpoint appears or
+   *   disappears, so forwarding threads can cache a copy and refresh it
+   *   only when flood_generation() moves.
+   * - generation() moves whenever a mapping appears, changes or goes away,
+   *   but not when an age is merely refreshed, so forwarding threads can
+   *   cache lookups (see FlowCache) and trust them while it stands still.
+   *
+   * When the load factor would exceed 3/4 the writer builds a table of
+   * twice the size and publishes it with a single atomic store (RCU style).
+   * Readers still probing the old table finish against a consistent but
+   * stale copy. Retired tables are freed with the ConcurrentMacTable; since
+   * capacity only doubles their total size is bounded by the live table.
+   * remove() uses backward-shift deletion instead of tombstones, so churn
+   * never forces a rebuild.
+   *
+   * Example:
+   * @code
+   * ConcurrentMacTable table;
+   * table.insert(mac, Endpoint("192.168.1.2", 8080));  // writer
+   * if (auto ep = table.lookup(mac)) {                  // any thread, lock-free
+   *   socket.send_to(data, size, *ep);
+   * }
+   * @endcode
+   */
+  class ConcurrentMacTable
+  {
+  private:
+    static constexpr size_t ENDPOINT_WORDS = 4;
+
+    static_assert(std::is_trivially_copyable_v<Endpoint>, "Endpoint is copied word-wise into slots");
+    static_assert(sizeof(Endpoint) <= ENDPOINT_WORDS * sizeof(uint64_t), "Endpoint does not fit in a slot");
+
+    /**
+     * @brief One table entry, sized and aligned to a cache line
+     *
+     * key is 0 for an empty slot, otherwise the packed MAC and VLAN ID
+     * with the occupied bit set. All fields are atomics so that concurrent
+     * seqlock readers are well-defined. last_seen is refreshed outside
+     * the sequence lock; a refresh racing with a slot move can be lost,
+     * which at worst ages the entry out one sweep early.
+     */
+    struct alignas(64) Slot
+    {
+      std::atomic<uint32_t> seq{ 0 };
+      std::atomic<MacTimestamp> last_seen{ 0 };
+      std::atomic<uint64_t> key{ 0 };
+      std::atomic<uint64_t> endpoint[ENDPOINT_WORDS] = {};
+    };
+
+    /**
+     * @brief A fixed-capacity slot array
+     */
+    struct Table
+    {
+      size_t mask;
+      std::unique_ptr<Slot[]> slots;
+
+      explicit Table(size_t capacity) : mask(capacity - 1), slots(new Slot[capacity])
+      {
+      }
+    };
+
+    // Read-mostly state, shared by all lookups
+    alignas(64) std::atomic<Table*> current_{ nullptr };
+
+    // Bumped (odd while in progress) around every operation that moves
+    // entries between slots; lets a reader tell a true miss from a race
+    std::atomic<uint64_t> shift_version_{ 0 };
+
+    // Bumped whenever the set of distinct endpoints changes
+    std::atomic<uint64_t> flood_generation_{ 0 };
+
+    // Bumped after every change to a mapping, once the slots show it
+    std::atomic<uint64_t> generation_{ 0 };
+
+    // Writer-only state, kept off the readers' cache line
+    alignas(64) mutable std::mutex write_mutex_;
+    std::vector<std::unique_ptr<Table>> tables_;  // tables_.back() is current_
+    std::atomic<size_t> size_{ 0 };
+    size_t initial_capacity_ = CONCURRENT_MAC_TABLE_INITIAL_CAPACITY;
+
+    // Number of MACs learned behind each endpoint, and those endpoints in a flat list
+    std::unordered_map<Endpoint, size_t> endpoint_refs_;
+    std::vector<Endpoint> flood_list_;
+
+    /**
+     * @brief Pack a VLAN ID and a MAC address into a non-zero slot key
+     */
+    [[nodiscard]] static uint64_t make_key(uint16_t vlan, const MacAddress& mac) noexcept;
+
+    /**
+     * @brief Consistently read a slot's key and endpoint
+     */
+    static void read_slot(const Slot& slot, uint64_t& key, Endpoint& endpoint) noexcept;
+
+    /**
+     * @brief Write a slot's key and endpoint (writer mutex held)
+     */
+    static void write_slot(Slot& slot, uint64_t key, const Endpoint& endpoint, MacTimestamp last_seen) noexcept;
+
+    /**
+     * @brief Lock-free search of the current table
+     * @param key Packed key to search for
+     * @param endpoint Receives the endpoint on a hit
+     * @return The slot holding the key, or nullptr on a miss
+     */
+    [[nodiscard]] const Slot* find(uint64_t key, Endpoint& endpoint) const noexcept;
+
+    /**
+     * @brief Locate a key in a table (writer mutex held)
+     * @return Slot index of the key, or of the empty slot where it would go
+     */
+    [[nodiscard]] static size_t probe(const Table& table, uint64_t key, bool& found) noexcept;
+
+    /**
+     * @brief Publish a table of twice the capacity (writer mutex held)
+     */
+    void grow();
+
+    /**
+     * @brief Empty a slot with backward-shift deletion (writer mutex held)
+     */
+    void erase_at(Table& table, size_t hole) noexcept;
+
+    /**
+     * @brief Count one more MAC behind an endpoint (writer mutex held)
+     */
+    void add_endpoint_ref(const Endpoint& endpoint);
+
+    /**
+     * @brief Count one MAC less behind an endpoint (writer mutex held)
+     */
+    void release_endpoint_ref(const Endpoint& endpoint) noexcept;
+
+    /**
+     * @brief Visit a consistent copy of every occupied slot of the current table
+     */
+    template <typename Visitor>
+    void for_each(Visitor&& visitor) const;
+
+  public:
+    /**
+     * @brief Construct an empty table
+     * @param initial_capacity Initial number of slots (rounded up to a power of two)
+     */
+    explicit ConcurrentMacTable(size_t initial_capacity = CONCURRENT_MAC_TABLE_INITIAL_CAPACITY);
+
+    /**
+     * @brief Deleted copy constructor
+     */
+    ConcurrentMacTable(const ConcurrentMacTable&) = delete;
+
+    /**
+     * @brief Deleted copy assignment
+     */
+    ConcurrentMacTable& operator=(const ConcurrentMacTable&) = delete;
+
+    /**
+     * @brief Move constructor
+     *
+     * Not safe against concurrent use of either table. The moved-from
+     * table is empty and allocates again on its next insert.
+     */
+    ConcurrentMacTable(ConcurrentMacTable&& other) noexcept;
+
+    /**
+     * @brief Move assignment operator
+     *
+     * Not safe against concurrent use of either table.
+     */
+    ConcurrentMacTable& operator=(ConcurrentMacTable&& other) noexcept;
+
+    /**
+     * @brief Destructor
+     */
+    ~ConcurrentMacTable() = default;
+
+    /**
+     * @brief Insert or update a MAC → endpoint mapping and refresh its age
+     *
+     * Returns without locking when the MAC is already mapped to the same
+     * endpoint; the only write is the timestamp store, and only when the
+     * coarse timestamp has moved on.
+     *
+     * @param mac The MAC address
+     * @param endpoint The endpoint associated with this MAC
+     * @param now Current coarse timestamp
+     * @return true if this is a new entry, false if it already existed
+     */
+    bool insert(const MacAddress& mac, const Endpoint& endpoint, MacTimestamp now = mac_timestamp_now());
+
+    /**
+     * @brief Insert or update a mapping in one VLAN's address space
+     *
+     * A MAC learned in one VLAN is invisible to lookups in another, so the
+     * same station may sit behind different endpoints per VLAN. VLAN 0 is
+     * the space the VLAN-less overloads use.
+     *
+     * @param vlan The VLAN ID (only the low 12 bits count)
+     * @param mac The MAC address
+     * @param endpoint The endpoint associated with this MAC in this VLAN
+     * @param now Current coarse timestamp
+     * @return true if this is a new entry, false if it already existed
+     */
+    bool insert(uint16_t vlan, const MacAddress& mac, const Endpoint& endpoint, MacTimestamp now = mac_timestamp_now());
+
+    /**
+     * @brief Lookup endpoint for a MAC address (lock-free)
+     *
+     * @param mac The MAC address to look up
+     * @return optional<Endpoint> The endpoint if found, empty if not found
+     */
+    [[nodiscard]] std::optional<Endpoint> lookup(const MacAddress& mac) const noexcept;
+
+    /**
+     * @brief Lookup the endpoint for a MAC address in one VLAN (lock-free)
+     *
+     * @param vlan The VLAN ID
+     * @param mac The MAC address to look up
+     * @return optional<Endpoint> The endpoint if learned in this VLAN, empty if not
+     */
+    [[nodiscard]] std::optional<Endpoint> lookup(uint16_t vlan, const MacAddress& mac) const noexcept;
+
+    /**
+     * @brief Remove a MAC address from the table
+     *
+     * @param mac The MAC address to remove
+     * @return true if an entry was removed, false if it didn't exist
+     */
+    bool remove(const MacAddress& mac);
+
+    /**
+     * @brief Remove a MAC address from one VLAN
+     *
+     * @param vlan The VLAN ID
+     * @param mac The MAC address to remove
+     * @return true if an entry was removed, false if it didn't exist
+     */
+    bool remove(uint16_t vlan, const MacAddress& mac);
+
+    /**
+     * @brief Evict every entry not refreshed within max_age
+     *
+     * Candidates are found with a lock-free scan; each is re-checked and
+     * removed under the writer mutex, so entries refreshed meanwhile survive.
+     *
+     * @param max_age Aging time
+     * @param now Current coarse timestamp
+     * @return Number of entries evicted
+     */
+    size_t expire(std::chrono::seconds max_age, MacTimestamp now = mac_timestamp_now());
+
+    /**
+     * @brief Check if a MAC address exists in the table (lock-free)
+     */
+    [[nodiscard]] bool contains(const MacAddress& mac) const noexcept
+    {
+      return lookup(mac).has_value();
+    }
+
+    /**
+     * @brief Get all endpoints in the table
+     *
+     * Lock-free; entries changed during the scan may or may not be included.
+     */
+    [[nodiscard]] std::vector<Endpoint> get_all_endpoints() const;
+
+    /**
+     * @brief Get all endpoints except the one learned for a MAC
+     *
+     * @param exclude_mac MAC address to exclude from the result
+     * @return Vector of endpoints (excluding the specified MAC)
+     */
+    [[nodiscard]] std::vector<Endpoint> get_all_endpoints_except(const MacAddress& exclude_mac) const;
+
+    /**
+     * @brief Get the generation of the flood list
+     *
+     * Cheap enough to check on every broadcast; it only changes when an
+     * endpoint gains its first MAC or loses its last one.
+     */
+    [[nodiscard]] uint64_t flood_generation() const noexcept
+    {
+      return flood_generation_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Get the generation of the mappings
+     *
+     * Read it before a lookup: a result cached under this generation stays
+     * right for as long as generation() returns the same value.
+     */
+    [[nodiscard]] uint64_t generation() const noexcept
+    {
+      return generation_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Get the distinct endpoints that have learned MACs
+     *
+     * Takes the writer mutex briefly; callers should cache the result and
+     * refetch only when flood_generation() differs from the generation
+     * returned here.
+     *
+     * @param generation Receives the generation of the returned list
+     * @return Each endpoint exactly once
+     */
+    [[nodiscard]] std::vector<Endpoint> flood_endpoints(uint64_t& generation) const;
+
+    /**
+     * @brief Get a copy of the entire table
+     *
+     * A MAC learned in several VLANs appears once, with one of its endpoints.
+     */
+    [[nodiscard]] std::unordered_map<MacAddress, Endpoint> get_all_entries() const;
+
+    /**
+     * @brief Get a copy of every entry, with its VLAN and when it was last seen
+     */
+    [[nodiscard]] std::vector<LearnedMac> learned() const;
+
+    /**
+     * @brief Get the number of entries in the table
+     */
+    [[nodiscard]] size_t size() const noexcept
+    {
+      return size_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Check if the table is empty
+     */
+    [[nodiscard]] bool empty() const noexcept
+    {
+      return size() == 0;
+    }
+
+    /**
+     * @brief Get the number of slots in the current table
+     */
+    [[nodiscard]] size_t capacity() const noexcept
+    {
+      const Table* table = current_.load(std::memory_order_acquire);
+      return table != nullptr ? table->mask + 1 : 0;
+    }
+
+    /**
+     * @brief Remove all entries (capacity is kept)
+     */
+    void clear() noexcept;
+  };
+
+}  // namespace project
+
+#endif  // PROJECT_CONCURRENT_MAC_TABLE_HPP_
@@ -8,6 +8,8 @@
 #ifndef PROJECT_ETHERNET_FRAME_HPP_
 #define PROJECT_ETHERNET_FRAME_HPP_
 
+#include "project/hash.hpp"
+
 #include <array>
 #include <cstdint>
 #include <iosfwd>
@@ -27,6 +29,11 @@ namespace project
    */
   constexpr size_t ETHERNET_HEADER_SIZE = 14;
 
+  /**
+   * @brief Size of an 802.1Q VLAN tag (TPID + TCI) in bytes
+   */
+  constexpr size_t VLAN_TAG_SIZE = 4;
+
   /**
    * @brief Represents a MAC (Media Access Control) address
    * 
@@ -48,7 +55,7 @@ namespace project
     /**
      * @brief Default constructor - creates a zero MAC address
      */
-    MacAddress() noexcept : bytes_{0, 0, 0, 0, 0, 0}
+    constexpr MacAddress() noexcept : bytes_{0, 0, 0, 0, 0, 0}
     {
     }
 
@@ -56,7 +63,7 @@ namespace project
      * @brief Construct from a byte array
      * @param bytes The 6 bytes of the MAC address
      */
-    explicit MacAddress(const std::array<uint8_t, MAC_ADDRESS_SIZE>& bytes) noexcept : bytes_(bytes)
+    explicit constexpr MacAddress(const std::array<uint8_t, MAC_ADDRESS_SIZE>& bytes) noexcept : bytes_(bytes)
     {
     }
 
@@ -91,6 +98,32 @@ namespace project
       return bytes_;
     }
 
+    /**
+     * @brief Pack the address into the low 48 bits of an integer (first byte most significant)
+     */
+    [[nodiscard]] constexpr uint64_t to_u64() const noexcept
+    {
+      uint64_t value = 0;
+      for (size_t i = 0; i < MAC_ADDRESS_SIZE; ++i)
+      {
+        value = (value << 8) | bytes_[i];
+      }
+      return value;
+    }
+
+    /**
+     * @brief Unpack an address produced by to_u64() (bits above 47 are ignored)
+     */
+    [[nodiscard]] static constexpr MacAddress from_u64(uint64_t value) noexcept
+    {
+      MacAddress mac;
+      for (size_t i = 0; i < MAC_ADDRESS_SIZE; ++i)
+      {
+        mac.bytes_[i] = static_cast<uint8_t>(value >> ((MAC_ADDRESS_SIZE - 1 - i) * 8));
+      }
+      return mac;
+    }
+
     /**
      * @brief Get a pointer to the raw bytes
      * @return Const pointer to the first byte
@@ -291,9 +324,199 @@ namespace project
   {
     constexpr uint16_t IPv4 = 0x0800;
     constexpr uint16_t ARP = 0x0806;
+    constexpr uint16_t VLAN = 0x8100;
     constexpr uint16_t IPv6 = 0x86DD;
+    constexpr uint16_t QinQ = 0x88A8;
   }  // namespace EtherType
 
+  /**
+   * @brief Non-owning, zero-copy view over a raw Ethernet frame
+   * 
+   * Gives inline access to the header fields of a frame that lives in some
+   * other buffer (a FrameBuffer, a receive slot, a vector) without copying
+   * the payload the way EthernetFrame::parse() does. The view is only valid
+   * while the underlying buffer is.
+   * 
+   * If the frame carries an 802.1Q (or 802.1ad) tag, ethertype() reports the
+   * encapsulated EtherType and the tag is available through vlan_id() and
+   * priority().
+   * 
+   * Example:
+   * @code
+   * EthernetFrameView view(buffer.data(), buffer.size());
+   * if (view.is_valid() && !view.is_broadcast()) {
+   *   table.lookup(view.dst_mac());
+   * }
+   * @endcode
+   */
+  class EthernetFrameView
+  {
+  private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+
+    [[nodiscard]] constexpr uint16_t read_u16(size_t offset) const noexcept
+    {
+      return static_cast<uint16_t>((data_[offset] << 8) | data_[offset + 1]);
+    }
+
+  public:
+    /**
+     * @brief Default constructor - creates an empty (invalid) view
+     */
+    constexpr EthernetFrameView() noexcept = default;
+
+    /**
+     * @brief Construct a view over a raw buffer
+     * @param data Pointer to the first byte of the frame
+     * @param size Size of the frame in bytes
+     */
+    constexpr EthernetFrameView(const uint8_t* data, size_t size) noexcept : data_(data), size_(size)
+    {
+    }
+
+    /**
+     * @brief Construct a view over a byte vector
+     * @param frame The frame bytes (must outlive the view)
+     */
+    explicit EthernetFrameView(const std::vector<uint8_t>& frame) noexcept : data_(frame.data()), size_(frame.size())
+    {
+    }
+
+    /**
+     * @brief Check that the buffer holds at least a full Ethernet header
+     */
+    [[nodiscard]] constexpr bool is_valid() const noexcept
+    {
+      return data_ != nullptr && size_ >= ETHERNET_HEADER_SIZE;
+    }
+
+    /**
+     * @brief Get a pointer to the raw frame
+     */
+    [[nodiscard]] constexpr const uint8_t* data() const noexcept
+    {
+      return data_;
+    }
+
+    /**
+     * @brief Get the total frame size in bytes
+     */
+    [[nodiscard]] constexpr size_t size() const noexcept
+    {
+      return size_;
+    }
+
+    /**
+     * @brief Get the destination MAC address (view must be valid)
+     */
+    [[nodiscard]] MacAddress dst_mac() const noexcept
+    {
+      return MacAddress(data_);
+    }
+
+    /**
+     * @brief Get the source MAC address (view must be valid)
+     */
+    [[nodiscard]] MacAddress src_mac() const noexcept
+    {
+      return MacAddress(data_ + MAC_ADDRESS_SIZE);
+    }
+
+    /**
+     * @brief Check if the destination is the broadcast address
+     */
+    [[nodiscard]] constexpr bool is_broadcast() const noexcept
+    {
+      return (data_[0] & data_[1] & data_[2] & data_[3] & data_[4] & data_[5]) == 0xff;
+    }
+
+    /**
+     * @brief Check if the destination is a group (multicast or broadcast) address
+     */
+    [[nodiscard]] constexpr bool is_multicast() const noexcept
+    {
+      return (data_[0] & 0x01) != 0;
+    }
+
+    /**
+     * @brief Check if the frame carries an 802.1Q/802.1ad VLAN tag
+     */
+    [[nodiscard]] constexpr bool has_vlan_tag() const noexcept
+    {
+      if (size_ < ETHERNET_HEADER_SIZE + VLAN_TAG_SIZE)
+      {
+        return false;
+      }
+      uint16_t tpid = read_u16(12);
+      return tpid == EtherType::VLAN || tpid == EtherType::QinQ;
+    }
+
+    /**
+     * @brief Get the VLAN tag control information (0 if untagged)
+     */
+    [[nodiscard]] constexpr uint16_t vlan_tci() const noexcept
+    {
+      return has_vlan_tag() ? read_u16(14) : 0;
+    }
+
+    /**
+     * @brief Get the 12-bit VLAN identifier (0 if untagged)
+     */
+    [[nodiscard]] constexpr uint16_t vlan_id() const noexcept
+    {
+      return static_cast<uint16_t>(vlan_tci() & 0x0fff);
+    }
+
+    /**
+     * @brief Get the 3-bit 802.1p priority code point (0 if untagged)
+     */
+    [[nodiscard]] constexpr uint8_t priority() const noexcept
+    {
+      return static_cast<uint8_t>(vlan_tci() >> 13);
+    }
+
+    /**
+     * @brief Get the EtherType of the payload (after any VLAN tag)
+     */
+    [[nodiscard]] constexpr uint16_t ethertype() const noexcept
+    {
+      return has_vlan_tag() ? read_u16(16) : read_u16(12);
+    }
+
+    /**
+     * @brief Get the header size, including a VLAN tag if present
+     */
+    [[nodiscard]] constexpr size_t header_size() const noexcept
+    {
+      return has_vlan_tag() ? ETHERNET_HEADER_SIZE + VLAN_TAG_SIZE : ETHERNET_HEADER_SIZE;
+    }
+
+    /**
+     * @brief Get a pointer to the payload (after the header)
+     */
+    [[nodiscard]] constexpr const uint8_t* payload() const noexcept
+    {
+      return data_ + header_size();
+    }
+
+    /**
+     * @brief Get the payload size in bytes
+     */
+    [[nodiscard]] constexpr size_t payload_size() const noexcept
+    {
+      return size_ - header_size();
+    }
+
+    /**
+     * @brief Copy the viewed frame into an owning EthernetFrame
+     */
+    [[nodiscard]] EthernetFrame to_frame() const
+    {
+      return EthernetFrame::parse(data_, size_);
+    }
+  };
+
 }  // namespace project
 
 // Hash function for MacAddress (to use in unordered_map)
@@ -304,13 +527,7 @@ namespace std
   {
     size_t operator()(const project::MacAddress& mac) const noexcept
     {
-      const auto& bytes = mac.bytes();
-      size_t hash = 0;
-      for (size_t i = 0; i < project::MAC_ADDRESS_SIZE; ++i)
-      {
-        hash ^= static_cast<size_t>(bytes[i]) << (i * 8);
-      }
-      return hash;
+      return project::mix64(mac.to_u64());
     }
   };
 }  // namespace std
@@ -0,0 +1,205 @@
+/**
+ * @file event_loop.hpp
+ * @brief Single-threaded epoll event loop
+ *
+ * EventLoop multiplexes any number of non-blocking file descriptors on one
+ * thread. Each registered descriptor has a handler that is called with the
+ * epoll events it became ready for. An eventfd is registered alongside, so
+ * stop() can wake a blocked loop from any thread (or a signal handler)
+ * instead of waiting for traffic or a timeout.
+ *
+ * Linux only; elsewhere create() fails with EventLoopError::CreateFailed.
+ */
+
+#ifndef PROJECT_EVENT_LOOP_HPP_
+#define PROJECT_EVENT_LOOP_HPP_
+
+#include "project/expected.hpp"
+#include "project/sys_utils.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+
+namespace project
+{
+  /**
+   * @brief Error codes for event loop operations
+   */
+  enum class EventLoopError
+  {
+    CreateFailed,
+    AddFailed,
+    RemoveFailed,
+    WaitFailed,
+    AlreadyRegistered,
+    NotRegistered,
+    InvalidLoop
+  };
+
+  /**
+   * @brief Convert EventLoopError to string representation
+   * @param error The error code
+   * @return String description of the error
+   */
+  [[nodiscard]] const char* to_string(EventLoopError error) noexcept;
+
+  /**
+   * @brief Maximum number of ready descriptors handled per epoll_wait()
+   */
+  constexpr size_t EVENT_LOOP_MAX_EVENTS = 64;
+
+  /**
+   * @brief Called with the ready epoll events (EPOLLIN, EPOLLERR, ...) of a descriptor
+   */
+  using EventHandler = std::function<void(uint32_t events)>;
+
+  /**
+   * @brief epoll-based event loop for non-blocking descriptors
+   *
+   * Descriptors are level-triggered: a handler that leaves data unread is
+   * called again on the next iteration, so handlers may stop after a fixed
+   * budget to keep one busy descriptor from starving the others.
+   *
+   * add() and remove() must be called from the loop thread (typically from
+   * a handler) or while the loop is not running. A handler may remove its
+   * own or any other descriptor. stop() may be called from anywhere.
+   *
+   * Example usage:
+   * @code
+   * auto loop = EventLoop::create();
+   * loop->add(socket.get_fd(), EPOLLIN, [&](uint32_t) { drain(socket); });
+   * loop->run();  // Until loop->stop()
+   * @endcode
+   */
+  class EventLoop
+  {
+  private:
+    /**
+     * @brief A registered descriptor; stays allocated until the end of the dispatch round that removed it
+     */
+    struct Registration
+    {
+      bool active = true;
+      EventHandler handler;
+    };
+
+    FileDescriptor epoll_fd_;
+    FileDescriptor wake_fd_;
+    std::unordered_map<int, std::unique_ptr<Registration>> registrations_;
+    std::vector<std::unique_ptr<Registration>> retired_;
+    std::atomic<bool> stop_requested_;
+
+    /**
+     * @brief Private constructor (use create() instead)
+     */
+    EventLoop(FileDescriptor epoll_fd, FileDescriptor wake_fd);
+
+  public:
+    /**
+     * @brief Create the epoll instance and its wake-up eventfd
+     * @return expected<EventLoop, EventLoopError> The created loop or an error
+     */
+    [[nodiscard]] static expected<EventLoop, EventLoopError> create();
+
+    /**
+     * @brief Move constructor (not while the loop is running)
+     */
+    EventLoop(EventLoop&& other) noexcept;
+
+    /**
+     * @brief Move assignment operator (not while either loop is running)
+     */
+    EventLoop& operator=(EventLoop&& other) noexcept;
+
+    /**
+     * @brief Deleted copy constructor
+     */
+    EventLoop(const EventLoop&) = delete;
+
+    /**
+     * @brief Deleted copy assignment
+     */
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    /**
+     * @brief Destructor
+     */
+    ~EventLoop() = default;
+
+    /**
+     * @brief Watch a descriptor
+     * @param fd The descriptor; should be non-blocking
+     * @param events epoll events to wait for (e.g. EPOLLIN)
+     * @param handler Called whenever the descriptor is ready
+     * @return expected<void, EventLoopError> Success or error
+     */
+    [[nodiscard]] expected<void, EventLoopError> add(int fd, uint32_t events, EventHandler handler);
+
+    /**
+     * @brief Stop watching a descriptor
+     *
+     * Its handler is not called again, even for events already collected in
+     * the current round.
+     *
+     * @param fd The descriptor
+     * @return expected<void, EventLoopError> Success or error
+     */
+    [[nodiscard]] expected<void, EventLoopError> remove(int fd);
+
+    /**
+     * @brief Wait for ready descriptors once and dispatch their handlers
+     * @param timeout Maximum time to wait (negative waits indefinitely)
+     * @return expected<size_t, EventLoopError> Number of handlers called or error
+     */
+    [[nodiscard]] expected<size_t, EventLoopError> run_once(std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Dispatch events until stop() is called
+     *
+     * A stop() issued before run() makes it return immediately; the request
+     * is consumed, so the loop can be run again afterwards.
+     *
+     * @return expected<void, EventLoopError> Success or a wait error
+     */
+    [[nodiscard]] expected<void, EventLoopError> run();
+
+    /**
+     * @brief Make run() return (thread- and async-signal-safe)
+     */
+    void stop() noexcept;
+
+    /**
+     * @brief Number of watched descriptors (excluding the wake-up eventfd)
+     */
+    [[nodiscard]] size_t size() const noexcept
+    {
+      return registrations_.size();
+    }
+
+    /**
+     * @brief Check if the loop was created successfully
+     */
+    [[nodiscard]] bool is_valid() const noexcept
+    {
+      return epoll_fd_.is_valid();
+    }
+
+  private:
+    /**
+     * @brief Reset the eventfd after a wake-up
+     */
+    void drain_wake_fd() noexcept;
+  };
+
+}  // namespace project
+
+#endif  // PROJECT_EVENT_LOOP_HPP_
@@ -0,0 +1,320 @@
+/**
+ * @file flat_mac_map.hpp
+ * @brief Flat open-addressing hash map keyed by MAC address
+ *
+ * Provides a cache-friendly replacement for std::unordered_map<MacAddress, T>:
+ * keys are packed 48-bit integers in a contiguous array and values are
+ * stored inline in a parallel array, so a lookup touches one or two cache
+ * lines instead of chasing bucket and node pointers.
+ */
+
+#ifndef PROJECT_FLAT_MAC_MAP_HPP_
+#define PROJECT_FLAT_MAC_MAP_HPP_
+
+#include "project/ethernet_frame.hpp"
+#include "project/hash.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace project
+{
+  /**
+   * @brief Open-addressing MAC → T map with linear probing
+   *
+   * - Keys are MacAddress::to_u64() with a marker bit set; 0 marks an empty slot.
+   * - Slots are chosen by mix64() of the key, so OUI-heavy address sets do
+   *   not cluster.
+   * - The load factor is kept at or below 3/4; erase() uses backward-shift
+   *   deletion, so there are no tombstones and churn never degrades probing.
+   *
+   * Not thread-safe; MacTable wraps it with a lock.
+   *
+   * @tparam T Mapped type (must be default-constructible and copyable)
+   */
+  template <typename T>
+  class FlatMacMap
+  {
+  private:
+    static constexpr uint64_t KEY_OCCUPIED = uint64_t{ 1 } << 63;
+    static constexpr size_t MIN_CAPACITY = 16;
+
+    std::vector<uint64_t> keys_;
+    std::vector<T> values_;
+    size_t size_ = 0;
+
+    [[nodiscard]] static uint64_t make_key(const MacAddress& mac) noexcept
+    {
+      return mac.to_u64() | KEY_OCCUPIED;
+    }
+
+    [[nodiscard]] size_t mask() const noexcept
+    {
+      return keys_.size() - 1;
+    }
+
+    /**
+     * @brief Index of the key, or of the empty slot where it would be inserted
+     */
+    [[nodiscard]] size_t probe(uint64_t key, bool& found) const noexcept
+    {
+      size_t i = mix64(key) & mask();
+      for (;;)
+      {
+        if (keys_[i] == key || keys_[i] == 0)
+        {
+          found = (keys_[i] == key);
+          return i;
+        }
+        i = (i + 1) & mask();
+      }
+    }
+
+    void rehash(size_t capacity)
+    {
+      std::vector<uint64_t> old_keys(capacity, 0);
+      std::vector<T> old_values(capacity);
+      old_keys.swap(keys_);
+      old_values.swap(values_);
+
+      for (size_t i = 0; i < old_keys.size(); ++i)
+      {
+        if (old_keys[i] != 0)
+        {
+          bool found;
+          size_t index = probe(old_keys[i], found);
+          keys_[index] = old_keys[i];
+          values_[index] = std::move(old_values[i]);
+        }
+      }
+    }
+
+  public:
+    /**
+     * @brief Construct an empty map
+     * @param initial_capacity Number of entries to make room for without rehashing
+     */
+    explicit FlatMacMap(size_t initial_capacity = 0)
+    {
+      reserve(initial_capacity);
+    }
+
+    /**
+     * @brief Copy constructor
+     */
+    FlatMacMap(const FlatMacMap&) = default;
+
+    /**
+     * @brief Copy assignment
+     */
+    FlatMacMap& operator=(const FlatMacMap&) = default;
+
+    /**
+     * @brief Move constructor - leaves other empty
+     */
+    FlatMacMap(FlatMacMap&& other) noexcept
+        : keys_(std::move(other.keys_)), values_(std::move(other.values_)), size_(other.size_)
+    {
+      other.keys_.clear();
+      other.values_.clear();
+      other.size_ = 0;
+    }
+
+    /**
+     * @brief Move assignment - leaves other empty
+     */
+    FlatMacMap& operator=(FlatMacMap&& other) noexcept
+    {
+      if (this != &other)
+      {
+        keys_ = std::move(other.keys_);
+        values_ = std::move(other.values_);
+        size_ = other.size_;
+        other.keys_.clear();
+        other.values_.clear();
+        other.size_ = 0;
+      }
+      return *this;
+    }
+
+    /**
+     * @brief Destructor
+     */
+    ~FlatMacMap() = default;
+
+    /**
+     * @brief Find the value mapped to a MAC address
+     * @return Pointer to the value, or nullptr if not present
+     */
+    [[nodiscard]] T* find(const MacAddress& mac) noexcept
+    {
+      return const_cast<T*>(std::as_const(*this).find(mac));
+    }
+
+    /**
+     * @brief Find the value mapped to a MAC address
+     * @return Pointer to the value, or nullptr if not present
+     */
+    [[nodiscard]] const T* find(const MacAddress& mac) const noexcept
+    {
+      if (size_ == 0)
+      {
+        return nullptr;
+      }
+
+      bool found;
+      size_t index = probe(make_key(mac), found);
+      return found ? &values_[index] : nullptr;
+    }
+
+    /**
+     * @brief Check whether a MAC address is present
+     */
+    [[nodiscard]] bool contains(const MacAddress& mac) const noexcept
+    {
+      return find(mac) != nullptr;
+    }
+
+    /**
+     * @brief Insert a mapping or overwrite an existing one
+     * @return true if the MAC was not present before
+     */
+    bool insert_or_assign(const MacAddress& mac, const T& value)
+    {
+      const uint64_t key = make_key(mac);
+
+      if (size_ != 0)
+      {
+        bool found;
+        size_t index = probe(key, found);
+        if (found)
+        {
+          values_[index] = value;
+          return false;
+        }
+      }
+
+      reserve(size_ + 1);
+
+      bool found;
+      size_t index = probe(key, found);
+      keys_[index] = key;
+      values_[index] = value;
+      ++size_;
+      return true;
+    }
+
+    /**
+     * @brief Remove a MAC address
+     * @return true if an entry was removed
+     */
+    bool erase(const MacAddress& mac)
+    {
+      if (size_ == 0)
+      {
+        return false;
+      }
+
+      bool found;
+      size_t hole = probe(make_key(mac), found);
+      if (!found)
+      {
+        return false;
+      }
+
+      // Backward-shift deletion: pull later entries of the probe run into the hole
+      for (size_t j = (hole + 1) & mask(); keys_[j] != 0; j = (j + 1) & mask())
+      {
+        size_t home = mix64(keys_[j]) & mask();
+        if (((j - home) & mask()) >= ((j - hole) & mask()))
+        {
+          keys_[hole] = keys_[j];
+          values_[hole] = std::move(values_[j]);
+          hole = j;
+        }
+      }
+
+      keys_[hole] = 0;
+      values_[hole] = T{};
+      --size_;
+      return true;
+    }
+
+    /**
+     * @brief Remove all entries (capacity is kept)
+     */
+    void clear() noexcept
+    {
+      for (size_t i = 0; i < keys_.size(); ++i)
+      {
+        if (keys_[i] != 0)
+        {
+          keys_[i] = 0;
+          values_[i] = T{};
+        }
+      }
+      size_ = 0;
+    }
+
+    /**
+     * @brief Make room for at least count entries without rehashing
+     */
+    void reserve(size_t count)
+    {
+      size_t capacity = keys_.empty() ? MIN_CAPACITY : keys_.size();
+      while (count * 4 > capacity * 3)
+      {
+        capacity *= 2;
+      }
+
+      if (capacity != keys_.size())
+      {
+        rehash(capacity);
+      }
+    }
+
+    /**
+     * @brief Call visitor(mac, value) for every entry, in slot order
+     */
+    template <typename Visitor>
+    void for_each(Visitor&& visitor) const
+    {
+      for (size_t i = 0; i < keys_.size(); ++i)
+      {
+        if (keys_[i] != 0)
+        {
+          visitor(MacAddress::from_u64(keys_[i]), values_[i]);
+        }
+      }
+    }
+
+    /**
+     * @brief Get the number of entries
+     */
+    [[nodiscard]] size_t size() const noexcept
+    {
+      return size_;
+    }
+
+    /**
+     * @brief Check if the map is empty
+     */
+    [[nodiscard]] bool empty() const noexcept
+    {
+      return size_ == 0;
+    }
+
+    /**
+     * @brief Get the number of slots
+     */
+    [[nodiscard]] size_t capacity() const noexcept
+    {
+      return keys_.size();
+    }
+  };
+
+}  // namespace project
+
+#endif  // PROJECT_FLAT_MAC_MAP_HPP_
@@ -0,0 +1,124 @@
+/**
+ * @file flow_cache.hpp
+ * @brief Direct-mapped cache of where a flow's unicast frames go
+ *
+ * Most traffic is long-lived pairs of stations, so a forwarding thread
+ * keeps, per (VLAN, source MAC, destination MAC, ingress endpoint), the
+ * egress endpoint it resolved last time. A hit costs one hash and one
+ * cache line instead of the learn probe and the lookup probe in the MAC
+ * table. Entries carry the table's generation (see
+ * ConcurrentMacTable::generation()) and are trusted only while it has not
+ * moved, so learning, station moves, removals and aging all invalidate
+ * them at once without visiting them.
+ */
+
+#ifndef PROJECT_FLOW_CACHE_HPP_
+#define PROJECT_FLOW_CACHE_HPP_
+
+#include "project/hash.hpp"
+#include "project/mac_aging.hpp"
+#include "project/udp_socket.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace project
+{
+  /**
+   * @brief Number of entries in a FlowCache (a power of two)
+   */
+  constexpr size_t FLOW_CACHE_SIZE = 256;
+
+  /**
+   * @brief Direct-mapped flow → egress endpoint cache
+   *
+   * A colliding flow simply replaces the entry. An entry also records the
+   * coarse timestamp it was filled at and is honoured only within that
+   * second: the caller then takes the slow path, whose learning refreshes
+   * the source's age, so a busy flow never lets its MAC age out.
+   *
+   * Not thread-safe; each VSwitch worker owns one.
+   *
+   * Example:
+   * @code
+   * const uint64_t generation = table.generation();  // Before learning
+   * if (const Endpoint* egress = cache.find(vlan, src, dst, sender, generation, now)) {
+   *   socket.send_to(data, size, *egress);
+   * }
+   * @endcode
+   */
+  class FlowCache
+  {
+  private:
+    struct Entry
+    {
+      uint64_t generation = ~uint64_t{ 0 };  // Never a table generation: empty
+      uint64_t src = 0;
+      uint64_t dst = 0;
+      uint16_t vlan = 0;
+      MacTimestamp filled = 0;
+      Endpoint ingress;
+      Endpoint egress;
+    };
+
+    std::vector<Entry> entries_;
+
+    [[nodiscard]] Entry& slot(uint16_t vlan, uint64_t src, uint64_t dst, const Endpoint& ingress) noexcept
+    {
+      const uint64_t h = mix64(src ^ mix64(dst ^ (uint64_t{ vlan } << 48)) ^ ingress.hash());
+      return entries_[h & (FLOW_CACHE_SIZE - 1)];
+    }
+
+  public:
+    /**
+     * @brief Construct an empty cache
+     */
+    FlowCache() : entries_(FLOW_CACHE_SIZE)
+    {
+    }
+
+    /**
+     * @brief Look a flow up
+     * @param vlan The frame's VLAN
+     * @param src Source MAC (MacAddress::to_u64())
+     * @param dst Destination MAC (MacAddress::to_u64())
+     * @param ingress Where the frame came from
+     * @param generation The MAC table's current generation
+     * @param now Current coarse timestamp
+     * @return The egress endpoint, or nullptr to resolve the frame through the table
+     */
+    [[nodiscard]] const Endpoint* find(uint16_t vlan, uint64_t src, uint64_t dst, const Endpoint& ingress,
+                                       uint64_t generation, MacTimestamp now) noexcept
+    {
+      const Entry& entry = slot(vlan, src, dst, ingress);
+      if (entry.generation != generation || entry.filled != now || entry.src != src || entry.dst != dst ||
+          entry.vlan != vlan || entry.ingress != ingress)
+      {
+        return nullptr;
+      }
+      return &entry.egress;
+    }
+
+    /**
+     * @brief Remember where a flow's frames went
+     * @param generation The MAC table's generation read before the frame was learned and looked up
+     * @param now The coarse timestamp the frame was learned at
+     */
+    void store(uint16_t vlan, uint64_t src, uint64_t dst, const Endpoint& ingress, const Endpoint& egress,
+               uint64_t generation, MacTimestamp now) noexcept
+    {
+      Entry& entry = slot(vlan, src, dst, ingress);
+      entry.generation = generation;
+      entry.src = src;
+      entry.dst = dst;
+      entry.vlan = vlan;
+      entry.filled = now;
+      entry.ingress = ingress;
+      entry.egress = egress;
+    }
+  };
+
+}  // namespace project
+
+#endif  // PROJECT_FLOW_CACHE_HPP_
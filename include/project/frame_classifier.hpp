@@ -0,0 +1,128 @@
+/**
+ * @file frame_classifier.hpp
+ * @brief Burst classification of Ethernet headers with SIMD
+ *
+ * The forwarding path needs the same few facts about every received frame:
+ * the destination and source MACs packed as table keys, whether the
+ * destination is broadcast or multicast, and the EtherType. For a burst,
+ * classify_frames() derives them with one 16-byte load and shuffle per
+ * frame (two frames per instruction with AVX2) instead of byte-by-byte.
+ * The instruction set is picked once at run time; every path produces
+ * exactly what the scalar one does.
+ */
+
+#ifndef PROJECT_FRAME_CLASSIFIER_HPP_
+#define PROJECT_FRAME_CLASSIFIER_HPP_
+
+#include "project/ethernet_frame.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace project
+{
+  /**
+   * @brief What a frame's destination address is, as far as forwarding cares
+   */
+  enum class FrameClass : uint8_t
+  {
+    Runt,  // Shorter than an Ethernet header: drop
+    Unicast,
+    Multicast,  // Group bit set, but not broadcast
+    Broadcast
+  };
+
+  /**
+   * @brief The classified header of one frame
+   *
+   * dst and src are MacAddress::to_u64() of the addresses. They are zero for
+   * a runt.
+   */
+  struct FrameKeys
+  {
+    uint64_t dst = 0;
+    uint64_t src = 0;
+    uint16_t ethertype = 0;
+    FrameClass kind = FrameClass::Runt;
+
+    /**
+     * @brief The destination address
+     */
+    [[nodiscard]] MacAddress dst_mac() const noexcept
+    {
+      return MacAddress::from_u64(dst);
+    }
+
+    /**
+     * @brief The source address
+     */
+    [[nodiscard]] MacAddress src_mac() const noexcept
+    {
+      return MacAddress::from_u64(src);
+    }
+  };
+
+  /**
+   * @brief Instruction sets classify_frames() can run on
+   */
+  enum class SimdLevel
+  {
+    Scalar,
+    Ssse3,
+    Avx2,
+    Neon
+  };
+
+  /**
+   * @brief Convert SimdLevel to string representation
+   * @param level The instruction set
+   * @return Lower-case name (e.g., "avx2")
+   */
+  [[nodiscard]] const char* to_string(SimdLevel level) noexcept;
+
+  /**
+   * @brief The best instruction set this CPU supports (Scalar when built with Project_ENABLE_SIMD=OFF)
+   */
+  [[nodiscard]] SimdLevel detected_simd_level() noexcept;
+
+  /**
+   * @brief Whether classify_frames() can run at the given level on this CPU
+   */
+  [[nodiscard]] bool simd_level_supported(SimdLevel level) noexcept;
+
+  /**
+   * @brief Classify one frame (scalar)
+   * @param frame Pointer to the frame
+   * @param size Size of the frame
+   * @return The frame's keys
+   */
+  [[nodiscard]] FrameKeys classify_frame(const uint8_t* frame, size_t size) noexcept;
+
+  /**
+   * @brief Classify a burst of frames with the best instruction set available
+   *
+   * @param frames Pointers to the frames
+   * @param sizes Size of each frame (0 marks a slot to skip as a runt)
+   * @param count Number of frames
+   * @param keys Output, one entry per frame
+   */
+  void classify_frames(const uint8_t* const* frames, const size_t* sizes, size_t count, FrameKeys* keys) noexcept;
+
+  /**
+   * @brief Classify a burst of frames at a given level
+   *
+   * Levels the CPU does not support fall back to scalar. Meant for tests
+   * and benchmarks comparing the implementations.
+   *
+   * @param level Instruction set to use
+   * @param frames Pointers to the frames
+   * @param sizes Size of each frame
+   * @param count Number of frames
+   * @param keys Output, one entry per frame
+   */
+  void classify_frames(SimdLevel level, const uint8_t* const* frames, const size_t* sizes, size_t count,
+                       FrameKeys* keys) noexcept;
+
+}  // namespace project
+
+#endif  // PROJECT_FRAME_CLASSIFIER_HPP_
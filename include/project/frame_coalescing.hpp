@@ -0,0 +1,207 @@
+/**
+ * @file frame_coalescing.hpp
+ * @brief Several small Ethernet frames in one underlay datagram
+ *
+ * A VPort may send an aggregate instead of a single frame:
+ *
+ *   00:00:00:00:00:00 | 00:00:00:00:00:00 | 0x88B5 | version (1) | records
+ *
+ * where each record is a 16-bit length in network byte order followed by
+ * that many bytes of frame. The Ethernet header makes the aggregate look
+ * like a frame to anything that does not know the format: the all-zero
+ * destination is never learned, so a switch unaware of aggregates drops
+ * them like unknown unicast. 0x88B5 is the IEEE local experimental
+ * EtherType; the version byte tells this format apart from other uses.
+ *
+ * Frames are stored whole, so a receiver can forward each record straight
+ * from its receive buffer. The saving is on the underlay: one IP and UDP
+ * header and one system call per aggregate instead of per frame, which is
+ * most of the cost of a TCP ACK or an ARP request.
+ */
+
+#ifndef PROJECT_FRAME_COALESCING_HPP_
+#define PROJECT_FRAME_COALESCING_HPP_
+
+#include "project/expected.hpp"
+#include "project/frame_classifier.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace project
+{
+  /**
+   * @brief EtherType of an aggregate (IEEE 802 local experimental)
+   */
+  constexpr uint16_t COALESCE_ETHERTYPE = 0x88B5;
+
+  /**
+   * @brief Aggregate format version
+   */
+  constexpr uint8_t COALESCE_VERSION = 1;
+
+  /**
+   * @brief Bytes in front of the first record: Ethernet header and version
+   */
+  constexpr size_t COALESCE_HEADER_SIZE = 15;
+
+  /**
+   * @brief Bytes in front of each frame in an aggregate
+   */
+  constexpr size_t COALESCE_RECORD_HEADER_SIZE = 2;
+
+  /**
+   * @brief Largest aggregate a VPort builds: a 1500-byte MTU less IPv4 and UDP headers
+   */
+  constexpr size_t COALESCE_MAX_DATAGRAM_SIZE = 1472;
+
+  /**
+   * @brief Largest frame that waits to be coalesced; bigger ones go out alone
+   */
+  constexpr size_t COALESCE_MAX_FRAME_SIZE = 512;
+
+  /**
+   * @brief Most frames in one aggregate (receivers reject more)
+   */
+  constexpr size_t COALESCE_MAX_FRAMES = 64;
+
+  /**
+   * @brief Error codes for reading aggregates
+   */
+  enum class CoalesceError
+  {
+    NotAnAggregate,
+    Malformed,
+    TooManyFrames
+  };
+
+  /**
+   * @brief Convert CoalesceError to string representation
+   * @param error The error code
+   * @return String description of the error
+   */
+  [[nodiscard]] const char* to_string(CoalesceError error) noexcept;
+
+  /**
+   * @brief Check whether classified keys are those of an aggregate (a cheap first test)
+   */
+  [[nodiscard]] inline bool is_coalesced(const FrameKeys& keys) noexcept
+  {
+    return keys.dst == 0 && keys.src == 0 && keys.ethertype == COALESCE_ETHERTYPE && keys.kind == FrameClass::Unicast;
+  }
+
+  /**
+   * @brief Find the frames of an aggregate, in place
+   *
+   * @param data The aggregate
+   * @param size Its size
+   * @param frames Set to where each frame starts, inside data
+   * @param sizes Set to the size of each frame
+   * @param capacity Room in frames and sizes (COALESCE_MAX_FRAMES suffices for any valid aggregate)
+   * @return expected<size_t, CoalesceError> Number of frames, or an error (nothing is to be forwarded then)
+   */
+  [[nodiscard]] expected<size_t, CoalesceError> split_coalesced(const uint8_t* data, size_t size,
+                                                                const uint8_t** frames, size_t* sizes,
+                                                                size_t capacity) noexcept;
+
+  /**
+   * @brief Builds one aggregate in caller-provided memory
+   *
+   * Example:
+   * @code
+   * FrameCoalescer coalescer(buffer, COALESCE_MAX_DATAGRAM_SIZE);
+   * if (!coalescer.add(frame, size))
+   * {
+   *   send(coalescer.data(), coalescer.size());
+   *   coalescer.clear();
+   *   coalescer.add(frame, size);
+   * }
+   * @endcode
+   */
+  class FrameCoalescer
+  {
+  private:
+    uint8_t* out_ = nullptr;
+    size_t capacity_ = 0;
+    size_t size_ = 0;
+    size_t frames_ = 0;
+
+  public:
+    /**
+     * @brief Construct a coalescer without memory (add() always fails)
+     */
+    FrameCoalescer() = default;
+
+    /**
+     * @brief Construct a coalescer writing to out
+     * @param out Where the aggregate goes
+     * @param capacity Largest aggregate to build (at least COALESCE_HEADER_SIZE to hold anything)
+     */
+    FrameCoalescer(uint8_t* out, size_t capacity) noexcept : out_(out), capacity_(capacity)
+    {
+    }
+
+    /**
+     * @brief Check whether a frame of this size would still fit
+     */
+    [[nodiscard]] bool fits(size_t frame_size) const noexcept;
+
+    /**
+     * @brief Append a frame
+     * @return false if it does not fit (the aggregate is unchanged)
+     */
+    bool add(const uint8_t* frame, size_t frame_size) noexcept;
+
+    /**
+     * @brief Start a new aggregate
+     */
+    void clear() noexcept
+    {
+      size_ = 0;
+      frames_ = 0;
+    }
+
+    /**
+     * @brief Get the aggregate
+     */
+    [[nodiscard]] const uint8_t* data() const noexcept
+    {
+      return out_;
+    }
+
+    /**
+     * @brief Get the aggregate's size (0 while empty)
+     */
+    [[nodiscard]] size_t size() const noexcept
+    {
+      return size_;
+    }
+
+    /**
+     * @brief Get the number of frames added
+     */
+    [[nodiscard]] size_t frames() const noexcept
+    {
+      return frames_;
+    }
+
+    /**
+     * @brief Check whether no frame was added
+     */
+    [[nodiscard]] bool empty() const noexcept
+    {
+      return frames_ == 0;
+    }
+
+    /**
+     * @brief Check whether another frame would be too many
+     */
+    [[nodiscard]] bool full() const noexcept
+    {
+      return frames_ == COALESCE_MAX_FRAMES;
+    }
+  };
+
+}  // namespace project
+
+#endif  // PROJECT_FRAME_COALESCING_HPP_
@@ -0,0 +1,275 @@
+/**
+ * @file frame_pool.hpp
+ * @brief Preallocated pool of fixed-size frame buffers
+ *
+ * Provides a slab of MTU-sized slots handed out as move-only FrameBuffer
+ * handles, so the forwarding paths can receive frames without touching the
+ * heap in steady state.
+ */
+
+#ifndef PROJECT_FRAME_POOL_HPP_
+#define PROJECT_FRAME_POOL_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace project
+{
+  /**
+   * @brief Default size of a frame pool slot in bytes
+   *
+   * Large enough for a maximum-size Ethernet frame plus VLAN tags.
+   */
+  constexpr size_t FRAME_BUFFER_SIZE = 2048;
+
+  class FramePool;
+
+  /**
+   * @brief Move-only handle to one slot of a FramePool
+   *
+   * The slot is returned to its pool when the handle is destroyed or reset.
+   * A default-constructed handle (or one acquired from an exhausted pool)
+   * is invalid and has zero capacity.
+   *
+   * Example:
+   * @code
+   * FramePool pool(16);
+   * FrameBuffer buffer = pool.acquire();
+   * if (buffer) {
+   *   auto n = tap.read_frame(buffer);  // fills buffer.data(), sets buffer.size()
+   * }
+   * // Slot goes back to the pool when buffer goes out of scope
+   * @endcode
+   */
+  class FrameBuffer
+  {
+  private:
+    FramePool* pool_ = nullptr;
+    uint8_t* data_ = nullptr;
+    size_t capacity_ = 0;
+    size_t size_ = 0;
+
+    friend class FramePool;
+
+    /**
+     * @brief Private constructor (use FramePool::acquire() instead)
+     */
+    FrameBuffer(FramePool* pool, uint8_t* data, size_t capacity) noexcept
+        : pool_(pool), data_(data), capacity_(capacity)
+    {
+    }
+
+  public:
+    /**
+     * @brief Default constructor - creates an invalid buffer
+     */
+    FrameBuffer() noexcept = default;
+
+    /**
+     * @brief Move constructor
+     */
+    FrameBuffer(FrameBuffer&& other) noexcept
+        : pool_(other.pool_), data_(other.data_), capacity_(other.capacity_), size_(other.size_)
+    {
+      other.pool_ = nullptr;
+      other.data_ = nullptr;
+      other.capacity_ = 0;
+      other.size_ = 0;
+    }
+
+    /**
+     * @brief Move assignment operator
+     *
+     * Returns the currently held slot (if any) to its pool before taking over.
+     */
+    FrameBuffer& operator=(FrameBuffer&& other) noexcept
+    {
+      if (this != &other)
+      {
+        reset();
+        pool_ = other.pool_;
+        data_ = other.data_;
+        capacity_ = other.capacity_;
+        size_ = other.size_;
+        other.pool_ = nullptr;
+        other.data_ = nullptr;
+        other.capacity_ = 0;
+        other.size_ = 0;
+      }
+      return *this;
+    }
+
+    /**
+     * @brief Deleted copy constructor
+     */
+    FrameBuffer(const FrameBuffer&) = delete;
+
+    /**
+     * @brief Deleted copy assignment
+     */
+    FrameBuffer& operator=(const FrameBuffer&) = delete;
+
+    /**
+     * @brief Destructor - returns the slot to its pool
+     */
+    ~FrameBuffer()
+    {
+      reset();
+    }
+
+    /**
+     * @brief Return the slot to its pool and invalidate this handle
+     */
+    void reset() noexcept;
+
+    /**
+     * @brief Get a pointer to the slot memory
+     */
+    [[nodiscard]] uint8_t* data() noexcept
+    {
+      return data_;
+    }
+
+    /**
+     * @brief Get a const pointer to the slot memory
+     */
+    [[nodiscard]] const uint8_t* data() const noexcept
+    {
+      return data_;
+    }
+
+    /**
+     * @brief Get the number of valid bytes in the buffer
+     */
+    [[nodiscard]] size_t size() const noexcept
+    {
+      return size_;
+    }
+
+    /**
+     * @brief Set the number of valid bytes (clamped to capacity)
+     */
+    void set_size(size_t size) noexcept
+    {
+      size_ = size < capacity_ ? size : capacity_;
+    }
+
+    /**
+     * @brief Get the size of the slot in bytes
+     */
+    [[nodiscard]] size_t capacity() const noexcept
+    {
+      return capacity_;
+    }
+
+    /**
+     * @brief Check if the buffer holds a slot
+     */
+    [[nodiscard]] bool is_valid() const noexcept
+    {
+      return data_ != nullptr;
+    }
+
+    /**
+     * @brief Explicit conversion to bool for validity checking
+     */
+    explicit operator bool() const noexcept
+    {
+      return is_valid();
+    }
+  };
+
+  /**
+   * @brief Fixed-size slab of frame buffers with recycle-on-release handles
+   *
+   * All slots are allocated once at construction. acquire() and slot
+   * recycling only push/pop a free list under a short lock, so steady-state
+   * forwarding performs no heap allocation.
+   *
+   * The pool is neither copyable nor movable because outstanding
+   * FrameBuffer handles point back at it; it must outlive all of them.
+   */
+  class FramePool
+  {
+  private:
+    std::unique_ptr<uint8_t[]> storage_;
+    size_t slot_size_;
+    size_t slot_count_;
+
+    std::vector<uint8_t*> free_list_;
+    mutable std::mutex mutex_;
+
+    friend class FrameBuffer;
+
+    /**
+     * @brief Return a slot to the free list
+     */
+    void recycle(uint8_t* slot) noexcept;
+
+  public:
+    /**
+     * @brief Construct a pool
+     * @param slot_count Number of slots to preallocate
+     * @param slot_size Size of each slot in bytes (rounded up to a cache line)
+     */
+    explicit FramePool(size_t slot_count, size_t slot_size = FRAME_BUFFER_SIZE);
+
+    /**
+     * @brief Deleted copy constructor
+     */
+    FramePool(const FramePool&) = delete;
+
+    /**
+     * @brief Deleted copy assignment
+     */
+    FramePool& operator=(const FramePool&) = delete;
+
+    /**
+     * @brief Deleted move constructor (handles hold a pointer to the pool)
+     */
+    FramePool(FramePool&&) = delete;
+
+    /**
+     * @brief Deleted move assignment
+     */
+    FramePool& operator=(FramePool&&) = delete;
+
+    /**
+     * @brief Destructor
+     */
+    ~FramePool() = default;
+
+    /**
+     * @brief Take a slot from the pool
+     * @return A valid buffer, or an invalid one if the pool is exhausted
+     */
+    [[nodiscard]] FrameBuffer acquire() noexcept;
+
+    /**
+     * @brief Get the number of slots currently available
+     */
+    [[nodiscard]] size_t available() const noexcept;
+
+    /**
+     * @brief Get the size of each slot in bytes
+     */
+    [[nodiscard]] size_t slot_size() const noexcept
+    {
+      return slot_size_;
+    }
+
+    /**
+     * @brief Get the total number of slots
+     */
+    [[nodiscard]] size_t slot_count() const noexcept
+    {
+      return slot_count_;
+    }
+  };
+
+}  // namespace project
+
+#endif  // PROJECT_FRAME_POOL_HPP_
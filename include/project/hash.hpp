@@ -0,0 +1,32 @@
+/**
+ * @file hash.hpp
+ * @brief Integer mixing functions shared by the hash tables
+ */
+
+#ifndef PROJECT_HASH_HPP_
+#define PROJECT_HASH_HPP_
+
+#include <cstdint>
+
+namespace project
+{
+  /**
+   * @brief 64-bit finalizer (MurmurHash3 fmix64)
+   *
+   * Every input bit affects every output bit, so structured keys such as
+   * MAC addresses sharing an OUI still spread evenly when the low bits of
+   * the result are used as a table index.
+   */
+  [[nodiscard]] constexpr uint64_t mix64(uint64_t h) noexcept
+  {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+  }
+
+}  // namespace project
+
+#endif  // PROJECT_HASH_HPP_
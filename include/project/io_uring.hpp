@@ -0,0 +1,468 @@
+/**
+ * @file io_uring.hpp
+ * @brief Minimal io_uring wrapper for the TAP and UDP forwarding paths
+ *
+ * Talks to the kernel through the raw io_uring_setup/io_uring_enter/
+ * io_uring_register system calls, so no liburing is needed. CMake defines
+ * PROJECT_HAVE_IO_URING when the kernel headers provide everything used
+ * here (provided buffer rings, multishot receives, timed waits); without
+ * it only IoBackend and io_uring_available() are declared, and callers
+ * fall back to plain system calls.
+ *
+ * Even when compiled in, the running kernel may lack io_uring or have it
+ * disabled (kernel.io_uring_disabled); io_uring_available() checks that.
+ */
+
+#ifndef PROJECT_IO_URING_HPP_
+#define PROJECT_IO_URING_HPP_
+
+#include "project/expected.hpp"
+#include "project/sys_utils.hpp"
+#include "project/udp_socket.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#if PROJECT_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+#endif
+
+namespace project
+{
+  /**
+   * @brief How a VPort or VSwitch moves frames between the kernel and user space
+   */
+  enum class IoBackend
+  {
+    Syscalls,  ///< read()/write()/recvmmsg()/sendmmsg() on the calling threads
+    IoUring    ///< Multishot receives and asynchronous sends on an io_uring
+  };
+
+  /**
+   * @brief Convert IoBackend to string representation
+   */
+  [[nodiscard]] const char* to_string(IoBackend backend) noexcept;
+
+  /**
+   * @brief Check whether the io_uring backend is compiled in and the kernel lets us create a ring
+   */
+  [[nodiscard]] bool io_uring_available() noexcept;
+
+  /**
+   * @brief Error codes for io_uring operations
+   */
+  enum class IoUringError
+  {
+    Unsupported,
+    SetupFailed,
+    MapFailed,
+    RegisterFailed,
+    SubmitFailed,
+    InvalidRing
+  };
+
+  /**
+   * @brief Convert IoUringError to string representation
+   * @param error The error code
+   * @return String description of the error
+   */
+  [[nodiscard]] const char* to_string(IoUringError error) noexcept;
+
+#if PROJECT_HAVE_IO_URING
+  /**
+   * @brief Pack a request kind and a 56-bit payload (slot index, buffer id, ...) into sqe->user_data
+   */
+  [[nodiscard]] constexpr uint64_t io_uring_tag(uint8_t kind, uint64_t payload = 0) noexcept
+  {
+    return (uint64_t{ kind } << 56) | (payload & ((uint64_t{ 1 } << 56) - 1));
+  }
+
+  /**
+   * @brief Get the request kind of a CQE tagged with io_uring_tag()
+   */
+  [[nodiscard]] constexpr uint8_t io_uring_tag_kind(uint64_t user_data) noexcept
+  {
+    return static_cast<uint8_t>(user_data >> 56);
+  }
+
+  /**
+   * @brief Get the payload of a CQE tagged with io_uring_tag()
+   */
+  [[nodiscard]] constexpr uint64_t io_uring_tag_payload(uint64_t user_data) noexcept
+  {
+    return user_data & ((uint64_t{ 1 } << 56) - 1);
+  }
+
+  /**
+   * @brief A submission/completion queue pair
+   *
+   * Single-threaded: one thread fills SQEs, submits and reaps CQEs.
+   *
+   * Example usage:
+   * @code
+   * auto ring = IoUring::create(256);
+   * io_uring_sqe* sqe = ring->get_sqe();
+   * sqe->opcode = IORING_OP_NOP;
+   * ring->submit_and_wait(std::chrono::milliseconds(100));
+   * ring->for_each_completion([](const io_uring_cqe& cqe) { ... });
+   * @endcode
+   */
+  class IoUring
+  {
+  private:
+    FileDescriptor ring_fd_;
+    MemoryMapping rings_;  // SQ and CQ rings share one mapping (IORING_FEAT_SINGLE_MMAP)
+    MemoryMapping sqes_mapping_;
+
+    unsigned* sq_head_ = nullptr;
+    unsigned* sq_tail_ = nullptr;
+    unsigned* sq_array_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned sq_entries_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    unsigned cq_mask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+
+    // SQEs handed out by get_sqe() but not yet passed to the kernel
+    unsigned unsubmitted_ = 0;
+
+    /**
+     * @brief Private constructor (use create() instead)
+     */
+    IoUring() = default;
+
+    /**
+     * @brief Pass queued SQEs to the kernel, optionally waiting for a completion
+     */
+    [[nodiscard]] expected<unsigned, IoUringError> enter(unsigned min_complete, const void* timeout);
+
+  public:
+    /**
+     * @brief Set up a ring
+     * @param entries Submission queue size (the kernel rounds it up to a power of 2);
+     *                the completion queue is four times larger, for multishot receives
+     * @return expected<IoUring, IoUringError> The ring or an error
+     */
+    [[nodiscard]] static expected<IoUring, IoUringError> create(unsigned entries);
+
+    /**
+     * @brief Move constructor
+     */
+    IoUring(IoUring&& other) noexcept = default;
+
+    /**
+     * @brief Move assignment operator
+     */
+    IoUring& operator=(IoUring&& other) noexcept = default;
+
+    /**
+     * @brief Deleted copy constructor
+     */
+    IoUring(const IoUring&) = delete;
+
+    /**
+     * @brief Deleted copy assignment
+     */
+    IoUring& operator=(const IoUring&) = delete;
+
+    /**
+     * @brief Destructor - the kernel cancels whatever is still in flight
+     */
+    ~IoUring() = default;
+
+    /**
+     * @brief Get a zeroed submission queue entry to fill in
+     *
+     * Submits what is queued first when the queue is full.
+     *
+     * @return The entry, or nullptr if the queue is full and could not be submitted
+     */
+    [[nodiscard]] io_uring_sqe* get_sqe() noexcept;
+
+    /**
+     * @brief Pass all queued SQEs to the kernel without waiting
+     * @return expected<unsigned, IoUringError> Number of SQEs submitted or error
+     */
+    [[nodiscard]] expected<unsigned, IoUringError> submit();
+
+    /**
+     * @brief Submit queued SQEs and wait until at least one CQE is ready or the timeout expires
+     * @param timeout Maximum time to wait
+     * @return expected<unsigned, IoUringError> Number of SQEs submitted or error; a
+     *         timeout or signal is not an error
+     */
+    [[nodiscard]] expected<unsigned, IoUringError> submit_and_wait(std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Call handler(const io_uring_cqe&) for every ready CQE and consume them
+     * @return Number of CQEs handled
+     */
+    template <typename Handler>
+    size_t for_each_completion(Handler&& handler)
+    {
+      size_t handled = 0;
+      unsigned head = *cq_head_;
+      const unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+      for (; head != tail; ++head, ++handled)
+      {
+        handler(cqes_[head & cq_mask_]);
+      }
+      __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+      return handled;
+    }
+
+    /**
+     * @brief Queue a request cancelling everything in flight on this ring
+     *
+     * Each cancelled request still completes (with -ECANCELED), so callers
+     * keep reaping until their own in-flight counts reach zero.
+     *
+     * @param user_data Tag for the cancel request's own CQE
+     * @return true if the request was queued
+     */
+    [[nodiscard]] bool cancel_all(uint64_t user_data) noexcept;
+
+    /**
+     * @brief Register memory for IORING_OP_READ_FIXED/WRITE_FIXED (buffer index = position in the array)
+     * @param buffers The regions; the kernel pins them until the ring is closed
+     * @param count Number of regions
+     * @return expected<void, IoUringError> Success or error
+     */
+    [[nodiscard]] expected<void, IoUringError> register_buffers(const struct iovec* buffers, unsigned count);
+
+    /**
+     * @brief Get the raw ring descriptor (for io_uring_register)
+     */
+    [[nodiscard]] int get_fd() const noexcept
+    {
+      return ring_fd_.get();
+    }
+
+    /**
+     * @brief Check if the ring was set up successfully
+     */
+    [[nodiscard]] bool is_valid() const noexcept
+    {
+      return ring_fd_.is_valid();
+    }
+  };
+
+  /**
+   * @brief Fixed-size receive buffers the kernel picks from (IORING_REGISTER_PBUF_RING)
+   *
+   * Receives submitted with IOSQE_BUFFER_SELECT and this group take a buffer
+   * when data arrives rather than when the request is posted, so a multishot
+   * receive can stay armed without tying up memory. A completed receive
+   * reports the buffer id in its CQE flags.
+   *
+   * Buffers are reference-counted so a received frame can back several
+   * asynchronous sends; a buffer goes back to the kernel when the last
+   * reference is released. No request may still use the buffers when this
+   * object is destroyed.
+   */
+  class IoUringBufferRing
+  {
+  private:
+    MemoryMapping ring_;   // struct io_uring_buf entries shared with the kernel
+    MemoryMapping arena_;  // count * buffer_size bytes of frame storage
+    std::vector<uint32_t> references_;
+    size_t buffer_size_ = 0;
+    uint16_t count_ = 0;
+    uint16_t group_ = 0;
+    uint16_t tail_ = 0;
+
+    /**
+     * @brief Private constructor (use create() instead)
+     */
+    IoUringBufferRing() = default;
+
+    /**
+     * @brief Give a buffer back to the kernel
+     */
+    void recycle(uint16_t id) noexcept;
+
+  public:
+    /**
+     * @brief Allocate the buffers and register them with a ring
+     * @param ring The ring whose requests will use the buffers
+     * @param group Buffer group id for sqe->buf_group
+     * @param count Number of buffers; must be a power of 2, at most 32768
+     * @param buffer_size Size of each buffer
+     * @return expected<IoUringBufferRing, IoUringError> The buffers or an error
+     */
+    [[nodiscard]] static expected<IoUringBufferRing, IoUringError> create(IoUring& ring, uint16_t group, uint16_t count,
+                                                                           size_t buffer_size);
+
+    /**
+     * @brief Move constructor
+     */
+    IoUringBufferRing(IoUringBufferRing&& other) noexcept = default;
+
+    /**
+     * @brief Move assignment operator
+     */
+    IoUringBufferRing& operator=(IoUringBufferRing&& other) noexcept = default;
+
+    /**
+     * @brief Deleted copy constructor
+     */
+    IoUringBufferRing(const IoUringBufferRing&) = delete;
+
+    /**
+     * @brief Deleted copy assignment
+     */
+    IoUringBufferRing& operator=(const IoUringBufferRing&) = delete;
+
+    /**
+     * @brief Destructor
+     */
+    ~IoUringBufferRing() = default;
+
+    /**
+     * @brief Get the storage of a buffer
+     */
+    [[nodiscard]] uint8_t* buffer(uint16_t id) const noexcept
+    {
+      return static_cast<uint8_t*>(arena_.data()) + size_t{ id } * buffer_size_;
+    }
+
+    /**
+     * @brief Get the buffer id of a completed receive, or -1 if the kernel picked none
+     */
+    [[nodiscard]] static int buffer_id(const io_uring_cqe& cqe) noexcept
+    {
+      return (cqe.flags & IORING_CQE_F_BUFFER) != 0 ? static_cast<int>(cqe.flags >> IORING_CQE_BUFFER_SHIFT) : -1;
+    }
+
+    /**
+     * @brief Take a reference to a buffer (a completed receive starts with none)
+     */
+    void hold(uint16_t id) noexcept
+    {
+      ++references_[id];
+    }
+
+    /**
+     * @brief Drop a reference; the last one returns the buffer to the kernel
+     */
+    void release(uint16_t id) noexcept
+    {
+      if (--references_[id] == 0)
+      {
+        recycle(id);
+      }
+    }
+
+    /**
+     * @brief The whole arena, for IoUring::register_buffers()
+     */
+    [[nodiscard]] struct iovec arena() const noexcept
+    {
+      return { arena_.data(), arena_.size() };
+    }
+
+    /**
+     * @brief Size of each buffer
+     */
+    [[nodiscard]] size_t buffer_size() const noexcept
+    {
+      return buffer_size_;
+    }
+
+    /**
+     * @brief Buffer group id
+     */
+    [[nodiscard]] uint16_t group() const noexcept
+    {
+      return group_;
+    }
+
+    /**
+     * @brief Number of buffers
+     */
+    [[nodiscard]] uint16_t count() const noexcept
+    {
+      return count_;
+    }
+  };
+
+  /**
+   * @brief Per-send state that must stay put until an IORING_OP_SENDMSG completes
+   */
+  struct IoUringSendSlot
+  {
+    struct msghdr message{};
+    std::array<struct iovec, UDP_MAX_DATAGRAM_IOVECS> iov{};
+    std::array<uint8_t, UDP_MAX_SPLICE_SIZE> splice{};  // Copy of the datagram's spliced bytes
+    Endpoint destination;
+    uint16_t buffer_id = 0;
+  };
+
+  /**
+   * @brief A fixed pool of send slots, so in-flight sends are bounded like a NIC TX ring
+   */
+  class IoUringSendSlots
+  {
+  private:
+    std::vector<IoUringSendSlot> slots_;
+    std::vector<uint32_t> free_;
+
+  public:
+    /**
+     * @brief Sentinel returned by acquire() when every slot is in flight
+     */
+    static constexpr uint32_t NONE = ~uint32_t{ 0 };
+
+    /**
+     * @brief Create a pool of the given size
+     */
+    explicit IoUringSendSlots(uint32_t count);
+
+    /**
+     * @brief Fill a free slot for sending one datagram and return its index (or NONE)
+     */
+    [[nodiscard]] uint32_t acquire(const uint8_t* data, size_t size, const Endpoint& destination,
+                                   uint16_t buffer_id) noexcept;
+
+    /**
+     * @brief Fill a free slot for sending a possibly spliced datagram and return its index (or NONE)
+     *
+     * The spliced bytes are copied into the slot; data must stay valid until the send completes.
+     */
+    [[nodiscard]] uint32_t acquire(const OutboundDatagram& datagram, uint16_t buffer_id) noexcept;
+
+    /**
+     * @brief Get a slot by index
+     */
+    [[nodiscard]] IoUringSendSlot& operator[](uint32_t index) noexcept
+    {
+      return slots_[index];
+    }
+
+    /**
+     * @brief Return a completed slot to the pool
+     */
+    void release(uint32_t index) noexcept
+    {
+      free_.push_back(index);
+    }
+
+    /**
+     * @brief Number of sends still in flight
+     */
+    [[nodiscard]] size_t in_flight() const noexcept
+    {
+      return slots_.size() - free_.size();
+    }
+  };
+#endif  // PROJECT_HAVE_IO_URING
+
+}  // namespace project
+
+#endif  // PROJECT_IO_URING_HPP_
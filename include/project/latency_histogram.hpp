@@ -0,0 +1,209 @@
+/**
+ * @file latency_histogram.hpp
+ * @brief Log-bucketed latency histograms for the forwarding paths
+ *
+ * Forwarding threads stamp a frame when it is received and again when it
+ * has been sent, and record the difference in a per-thread histogram.
+ * Histograms of all threads are merged when a snapshot is taken.
+ *
+ * The instrumentation in VSwitch and VPort is compiled in only when
+ * PROJECT_LATENCY_HISTOGRAMS is non-zero (CMake option
+ * Project_ENABLE_LATENCY_HISTOGRAMS); otherwise their latency snapshots
+ * are simply empty and the forwarding paths are unchanged.
+ */
+
+#ifndef PROJECT_LATENCY_HISTOGRAM_HPP_
+#define PROJECT_LATENCY_HISTOGRAM_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+
+#ifndef PROJECT_LATENCY_HISTOGRAMS
+#define PROJECT_LATENCY_HISTOGRAMS 0
+#endif
+
+namespace project
+{
+  /**
+   * @brief Read the latency clock (raw ticks)
+   *
+   * The TSC on x86, a single unserialized instruction; CLOCK_MONOTONIC_COARSE
+   * (nanoseconds, vDSO, no syscall) elsewhere. Ticks are converted to time
+   * only at snapshot time.
+   */
+  [[nodiscard]] inline uint64_t latency_clock_ticks() noexcept
+  {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000u + static_cast<uint64_t>(ts.tv_nsec);
+#endif
+  }
+
+  /**
+   * @brief Nanoseconds per latency clock tick
+   *
+   * The TSC rate is measured against the steady clock on first use, which
+   * takes about 10 ms; call it once at startup to keep that off a snapshot.
+   */
+  [[nodiscard]] double latency_ns_per_tick();
+
+  /**
+   * @brief Linear sub-buckets per power of two (2^5: values within ~3%)
+   */
+  constexpr unsigned LATENCY_SUB_BUCKET_BITS = 5;
+
+  /**
+   * @brief Number of buckets covering the full 64-bit tick range
+   */
+  constexpr size_t LATENCY_BUCKET_COUNT = (64 - LATENCY_SUB_BUCKET_BITS + 1) << LATENCY_SUB_BUCKET_BITS;
+
+  /**
+   * @brief Bucket holding a tick value
+   *
+   * Values below 2^LATENCY_SUB_BUCKET_BITS get a bucket each; above that,
+   * each power of two is split into 2^LATENCY_SUB_BUCKET_BITS equal buckets,
+   * as in an HDR histogram.
+   */
+  [[nodiscard]] constexpr size_t latency_bucket_index(uint64_t ticks) noexcept
+  {
+    constexpr uint64_t SUB_BUCKETS = uint64_t{ 1 } << LATENCY_SUB_BUCKET_BITS;
+    if (ticks < SUB_BUCKETS)
+    {
+      return ticks;
+    }
+
+    const unsigned exponent = 63u - static_cast<unsigned>(__builtin_clzll(ticks));
+    const unsigned shift = exponent - LATENCY_SUB_BUCKET_BITS;
+    const uint64_t sub_bucket = (ticks >> shift) & (SUB_BUCKETS - 1);
+    return ((uint64_t{ shift } + 1) << LATENCY_SUB_BUCKET_BITS) + sub_bucket;
+  }
+
+  /**
+   * @brief Highest tick value that falls into a bucket
+   */
+  [[nodiscard]] constexpr uint64_t latency_bucket_upper_bound(size_t index) noexcept
+  {
+    constexpr size_t SUB_BUCKETS = size_t{ 1 } << LATENCY_SUB_BUCKET_BITS;
+    const size_t group = index >> LATENCY_SUB_BUCKET_BITS;
+    if (group == 0)
+    {
+      return index;
+    }
+
+    const unsigned shift = static_cast<unsigned>(group - 1);
+    const uint64_t lower = uint64_t{ SUB_BUCKETS + (index & (SUB_BUCKETS - 1)) } << shift;
+    return lower + ((uint64_t{ 1 } << shift) - 1);
+  }
+
+  /**
+   * @brief Merged, read-only copy of one or more histograms
+   */
+  struct LatencySnapshot
+  {
+    /**
+     * @brief Samples per bucket (empty if nothing was recorded)
+     */
+    std::vector<uint64_t> counts;
+
+    /**
+     * @brief Total number of samples
+     */
+    uint64_t count = 0;
+
+    /**
+     * @brief Add another snapshot's samples to this one
+     */
+    LatencySnapshot& operator+=(const LatencySnapshot& other);
+
+    /**
+     * @brief Upper bound of the bucket holding the given percentile, in ticks
+     * @param percentile In [0, 100]
+     * @return 0 if there are no samples
+     */
+    [[nodiscard]] uint64_t percentile_ticks(double percentile) const noexcept;
+
+    /**
+     * @brief The given percentile in nanoseconds
+     */
+    [[nodiscard]] uint64_t percentile_ns(double percentile) const;
+  };
+
+  /**
+   * @brief Histogram of latencies written by exactly one thread
+   *
+   * Like TrafficCounters, record() uses a relaxed load and store instead of
+   * a locked increment; snapshot() may run concurrently on any thread.
+   */
+  class LatencyHistogram
+  {
+  private:
+    std::unique_ptr<std::atomic<uint64_t>[]> counts_;
+
+  public:
+    /**
+     * @brief Construct an empty histogram
+     */
+    LatencyHistogram();
+
+    /**
+     * @brief Copy the current counts (lets containers of workers relocate)
+     */
+    LatencyHistogram(const LatencyHistogram& other);
+
+    /**
+     * @brief Copy the current counts
+     */
+    LatencyHistogram& operator=(const LatencyHistogram& other);
+
+    /**
+     * @brief Destructor
+     */
+    ~LatencyHistogram() = default;
+
+    /**
+     * @brief Record samples of the same latency (owning thread only)
+     * @param ticks Latency in latency_clock_ticks() units
+     * @param samples Number of frames that saw this latency
+     */
+    void record(uint64_t ticks, uint64_t samples = 1) noexcept
+    {
+      std::atomic<uint64_t>& bucket = counts_[latency_bucket_index(ticks)];
+      bucket.store(bucket.load(std::memory_order_relaxed) + samples, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Copy the current counts (any thread)
+     */
+    [[nodiscard]] LatencySnapshot snapshot() const;
+  };
+
+  /**
+   * @brief Render a snapshot as a Prometheus summary in seconds
+   *
+   * Emits <prefix>_latency_seconds{<labels>,quantile="..."} for the median,
+   * p90, p99 and p99.9, plus the _count sample.
+   *
+   * @param prefix Metric name prefix
+   * @param series Label set (without braces; may be empty) and snapshot of each series
+   */
+  [[nodiscard]] std::string format_prometheus_latency(
+      std::string_view prefix, const std::vector<std::pair<std::string, LatencySnapshot>>& series);
+
+}  // namespace project
+
+#endif  // PROJECT_LATENCY_HISTOGRAM_HPP_
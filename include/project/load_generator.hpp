@@ -0,0 +1,333 @@
+/**
+ * @file load_generator.hpp
+ * @brief RFC 2544 traffic generator speaking the VPort-to-VSwitch encapsulation
+ *
+ * The generator emulates a number of VPorts, each a UDP socket owning one or
+ * more MAC addresses, and sends raw Ethernet frames to a VSwitch exactly as
+ * VPort does: one frame per datagram, no extra header. Ports are paired
+ * (0<->1, 2<->3, ...) and every frame goes from a MAC of one port to the
+ * matching MAC of its peer, so a working switch delivers each frame to
+ * exactly one socket.
+ *
+ * Every test frame carries a signature with the trial number, a sequence
+ * number and a latency_clock_ticks() timestamp, which lets the receiver count
+ * delivered frames per trial and measure one-way latency on a single clock.
+ *
+ * The four RFC 2544 benchmarks are built from run_trial():
+ * - throughput(): binary search for the highest rate with no loss (26.1)
+ * - latency(): latency distribution at a given rate (26.2)
+ * - frame_loss(): loss at 100%, 90%, ... of the maximum rate (26.3)
+ * - back_to_back(): longest unpaced burst with no loss (26.4)
+ */
+
+#ifndef PROJECT_LOAD_GENERATOR_HPP_
+#define PROJECT_LOAD_GENERATOR_HPP_
+
+#include "project/ethernet_frame.hpp"
+#include "project/expected.hpp"
+#include "project/latency_histogram.hpp"
+#include "project/udp_socket.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace project
+{
+  /**
+   * @brief Error codes for load generator operations
+   */
+  enum class LoadgenError
+  {
+    InvalidConfig,
+    InvalidFrameSize,
+    SocketCreationFailed,
+    BindFailed,
+    ReceiveFailed
+  };
+
+  /**
+   * @brief Convert LoadgenError to string representation
+   * @param error The error code
+   * @return String description of the error
+   */
+  [[nodiscard]] const char* to_string(LoadgenError error) noexcept;
+
+  /**
+   * @brief Frame check sequence length, counted in RFC 2544 frame sizes but not sent
+   */
+  constexpr size_t ETHERNET_FCS_SIZE = 4;
+
+  /**
+   * @brief Smallest test frame (RFC 2544 sizes include the FCS)
+   */
+  constexpr size_t LOADGEN_MIN_FRAME_SIZE = 64;
+
+  /**
+   * @brief Largest test frame (RFC 2544 sizes include the FCS)
+   */
+  constexpr size_t LOADGEN_MAX_FRAME_SIZE = 1518;
+
+  /**
+   * @brief The frame sizes RFC 2544 section 9.1 recommends for Ethernet
+   */
+  constexpr size_t RFC2544_FRAME_SIZES[] = { 64, 128, 256, 512, 1024, 1280, 1518 };
+
+  /**
+   * @brief EtherType of test frames (IEEE 802 local experimental 2)
+   */
+  constexpr uint16_t LOADGEN_ETHERTYPE = 0x88B6;
+
+  /**
+   * @brief Configuration for a LoadGenerator
+   */
+  struct LoadgenConfig
+  {
+    /**
+     * @brief The VSwitch under test
+     */
+    Endpoint vswitch;
+
+    /**
+     * @brief Local address the emulated ports bind to
+     */
+    std::string bind_address = "127.0.0.1";
+
+    /**
+     * @brief Number of emulated VPorts (one UDP socket each); must be even
+     */
+    size_t ports = 2;
+
+    /**
+     * @brief MAC addresses behind each port
+     */
+    size_t macs_per_port = 1;
+
+    /**
+     * @brief Frames per send syscall, clamped to [1, UDP_MAX_BATCH_SIZE]
+     */
+    size_t batch_size = 32;
+
+    /**
+     * @brief Offered load, in frames per second, that counts as 100%
+     *
+     * There is no line rate over UDP, so the throughput search runs between
+     * zero and this rate.
+     */
+    double max_rate = 100000.0;
+
+    /**
+     * @brief How long each trial sends for
+     *
+     * RFC 2544 asks for at least 60 s in reported results; shorter trials
+     * are fine for a quick look.
+     */
+    std::chrono::milliseconds trial_duration{ 2000 };
+
+    /**
+     * @brief How long to keep receiving after the last frame of a trial (RFC 2544: 2 s)
+     */
+    std::chrono::milliseconds drain_time{ 500 };
+
+    /**
+     * @brief Pause after the learning frames that start each trial
+     */
+    std::chrono::milliseconds learning_time{ 50 };
+
+    /**
+     * @brief Fraction of frames a trial may lose and still pass (0 per RFC 2544)
+     */
+    double loss_tolerance = 0.0;
+
+    /**
+     * @brief The throughput search stops once its bounds are this fraction of max_rate apart
+     */
+    double resolution = 0.01;
+
+    /**
+     * @brief How many times back_to_back() repeats its search (RFC 2544: 50)
+     */
+    size_t back_to_back_trials = 5;
+
+    /**
+     * @brief Longest burst back_to_back() tries; 0 means max_rate * trial_duration
+     */
+    uint64_t back_to_back_max_frames = 0;
+  };
+
+  /**
+   * @brief Outcome of a single trial
+   */
+  struct TrialResult
+  {
+    /**
+     * @brief Frame size, including the FCS
+     */
+    size_t frame_size = 0;
+
+    /**
+     * @brief Offered rate in frames per second (0 for an unpaced burst)
+     */
+    double offered_rate = 0.0;
+
+    /**
+     * @brief Frames the kernel accepted for sending
+     */
+    uint64_t frames_sent = 0;
+
+    /**
+     * @brief Test frames delivered to the port owning their destination MAC
+     */
+    uint64_t frames_received = 0;
+
+    /**
+     * @brief Test frames delivered to any other port (flooded or misforwarded)
+     */
+    uint64_t frames_misdelivered = 0;
+
+    /**
+     * @brief Time from the first to the last frame sent
+     */
+    std::chrono::nanoseconds send_time{ 0 };
+
+    /**
+     * @brief One-way latency of every received frame
+     */
+    LatencySnapshot latency;
+
+    /**
+     * @brief Frames lost as a fraction of those sent
+     */
+    [[nodiscard]] double loss_ratio() const noexcept;
+
+    /**
+     * @brief Rate the frames actually left at, in frames per second
+     */
+    [[nodiscard]] double achieved_rate() const noexcept;
+
+    /**
+     * @brief Whether this trial lost no more than the given fraction
+     */
+    [[nodiscard]] bool passed(double loss_tolerance) const noexcept;
+  };
+
+  /**
+   * @brief Outcome of the back-to-back benchmark
+   */
+  struct BackToBackResult
+  {
+    /**
+     * @brief Frame size, including the FCS
+     */
+    size_t frame_size = 0;
+
+    /**
+     * @brief Longest loss-free burst found by each repetition
+     */
+    std::vector<uint64_t> bursts;
+
+    /**
+     * @brief Mean of bursts (what RFC 2544 reports)
+     */
+    [[nodiscard]] double mean() const noexcept;
+  };
+
+  /**
+   * @brief RFC 2544 load generator for a VSwitch
+   *
+   * Not thread-safe: runs one trial at a time, receiving on a helper thread
+   * for the duration of each trial.
+   */
+  class LoadGenerator
+  {
+  private:
+    LoadgenConfig config_;
+    std::vector<UdpSocket> ports_;
+    uint32_t next_trial_ = 1;
+
+  public:
+    /**
+     * @brief Open and bind the emulated ports
+     * @param config Generator configuration
+     * @return expected<LoadGenerator, LoadgenError> The generator or error
+     */
+    [[nodiscard]] static expected<LoadGenerator, LoadgenError> create(const LoadgenConfig& config);
+
+    LoadGenerator(LoadGenerator&& other) noexcept = default;
+
+    LoadGenerator& operator=(LoadGenerator&& other) noexcept = default;
+
+    LoadGenerator(const LoadGenerator&) = delete;
+
+    LoadGenerator& operator=(const LoadGenerator&) = delete;
+
+    ~LoadGenerator() = default;
+
+    /**
+     * @brief MAC address of an emulated host
+     * @param port Port index
+     * @param host Host index within the port
+     */
+    [[nodiscard]] MacAddress mac_address(size_t port, size_t host) const noexcept;
+
+    /**
+     * @brief Send one frame from every emulated MAC so the switch learns them all
+     *
+     * The frames go to a MAC nobody owns, so a learning switch drops them as
+     * unknown unicast instead of flooding them.
+     */
+    void learn();
+
+    /**
+     * @brief Run one trial
+     *
+     * Sends learning frames, then test frames for trial_duration (or until
+     * frame_count frames are sent), then keeps receiving for drain_time.
+     *
+     * @param frame_size Frame size including the FCS, in [64, 1518]
+     * @param rate Frames per second; 0 sends as fast as possible
+     * @param frame_count Stop after this many frames (0: no limit)
+     * @return expected<TrialResult, LoadgenError> Trial result or error
+     */
+    [[nodiscard]] expected<TrialResult, LoadgenError> run_trial(size_t frame_size, double rate,
+                                                                uint64_t frame_count = 0);
+
+    /**
+     * @brief Highest rate that passes, by binary search up to max_rate
+     * @return The best passing trial, or the last failing one if none passed
+     */
+    [[nodiscard]] expected<TrialResult, LoadgenError> throughput(size_t frame_size);
+
+    /**
+     * @brief Latency distribution at a given rate (normally the throughput)
+     */
+    [[nodiscard]] expected<TrialResult, LoadgenError> latency(size_t frame_size, double rate);
+
+    /**
+     * @brief Loss at 100%, 90%, ... of max_rate, until two trials in a row lose nothing
+     */
+    [[nodiscard]] expected<std::vector<TrialResult>, LoadgenError> frame_loss(size_t frame_size);
+
+    /**
+     * @brief Longest unpaced burst that passes, repeated back_to_back_trials times
+     */
+    [[nodiscard]] expected<BackToBackResult, LoadgenError> back_to_back(size_t frame_size);
+
+    /**
+     * @brief The configuration in use
+     */
+    [[nodiscard]] const LoadgenConfig& config() const noexcept
+    {
+      return config_;
+    }
+
+  private:
+    LoadGenerator(const LoadgenConfig& config, std::vector<UdpSocket> ports) : config_(config), ports_(std::move(ports))
+    {
+    }
+  };
+
+}  // namespace project
+
+#endif  // PROJECT_LOAD_GENERATOR_HPP_
@@ -0,0 +1,263 @@
+/**
+ * @file logger.hpp
+ * @brief Leveled asynchronous logging for the forwarding paths
+ *
+ * Log calls format into a slot of a fixed-size lock-free ring buffer and
+ * return; a background thread writes the slots out. Forwarding threads thus
+ * never block on the stdout/stderr stream lock, and levels below the
+ * compile-time minimum cost nothing at all.
+ */
+
+#ifndef PROJECT_LOGGER_HPP_
+#define PROJECT_LOGGER_HPP_
+
+#include "project/joining_thread.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string_view>
+
+/**
+ * @brief Lowest level compiled into the binary (0 = Trace ... 5 = Off)
+ *
+ * Set through the Project_LOG_LEVEL CMake cache variable. The default
+ * compiles out Trace, i.e. the per-frame lines of the forwarding paths.
+ */
+#ifndef PROJECT_LOG_MIN_LEVEL
+#define PROJECT_LOG_MIN_LEVEL 1
+#endif
+
+namespace project
+{
+  /**
+   * @brief Log severity, in increasing order
+   */
+  enum class LogLevel : uint8_t
+  {
+    Trace = 0,  // Per-frame events on the forwarding paths
+    Debug = 1,  // Per-MAC events such as learning
+    Info = 2,
+    Warn = 3,
+    Error = 4,
+    Off = 5
+  };
+
+  /**
+   * @brief Convert log level to lowercase name
+   */
+  [[nodiscard]] const char* to_string(LogLevel level) noexcept;
+
+  /**
+   * @brief Parse a level name ("trace", "debug", "info", "warn", "error", "off")
+   */
+  [[nodiscard]] std::optional<LogLevel> parse_log_level(std::string_view name) noexcept;
+
+  /**
+   * @brief Lowest level that is compiled in
+   */
+  constexpr LogLevel LOG_COMPILED_MIN_LEVEL = static_cast<LogLevel>(PROJECT_LOG_MIN_LEVEL);
+
+  /**
+   * @brief Check at compile time whether a level is compiled in
+   */
+  [[nodiscard]] constexpr bool log_compiled_in(LogLevel level) noexcept
+  {
+    return level >= LOG_COMPILED_MIN_LEVEL && level != LogLevel::Off;
+  }
+
+  /**
+   * @brief Default number of messages the ring buffer holds (a power of two)
+   */
+  constexpr size_t LOG_DEFAULT_CAPACITY = 1024;
+
+  /**
+   * @brief Longest message kept; longer messages are truncated
+   */
+  constexpr size_t LOG_MAX_MESSAGE_SIZE = 240;
+
+  /**
+   * @brief How often the drain thread looks for new messages
+   */
+  constexpr std::chrono::milliseconds LOG_DRAIN_INTERVAL{ 10 };
+
+  /**
+   * @brief Receives every drained message, on the drain thread only
+   */
+  using LogSink = std::function<void(LogLevel level, std::string_view message)>;
+
+  /**
+   * @brief Asynchronous logger backed by a bounded lock-free ring buffer
+   *
+   * - log() claims a slot with one CAS, formats into it with vsnprintf and
+   *   publishes it with a release store; it never locks or allocates.
+   * - When the buffer is full the message is dropped and counted rather
+   *   than stalling the caller.
+   * - A background thread drains the buffer every LOG_DRAIN_INTERVAL and
+   *   on destruction, passing each message to the sink in order.
+   *
+   * The process-wide instance() writes Info and below to stdout and Warn
+   * and above to stderr. Use the PROJECT_LOG_* macros rather than calling
+   * log() directly so that compiled-out levels do not evaluate arguments.
+   *
+   * Example:
+   * @code
+   * PROJECT_LOG_INFO("[VSwitch] Started at port %u", unsigned{ port });
+   * PROJECT_LOG_TRACE("[VSwitch] Received frame: size=%zu", size);  // compiled out by default
+   * @endcode
+   */
+  class Logger
+  {
+  private:
+    /**
+     * @brief One message; seq tells producers and the consumer whose turn it is
+     */
+    struct alignas(64) Slot
+    {
+      std::atomic<size_t> seq{ 0 };
+      LogLevel level = LogLevel::Info;
+      uint16_t length = 0;
+      char text[LOG_MAX_MESSAGE_SIZE];
+    };
+
+    size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+    LogSink sink_;
+
+    alignas(64) std::atomic<size_t> enqueue_pos_{ 0 };
+    alignas(64) std::atomic<size_t> dequeue_pos_{ 0 };
+    std::atomic<LogLevel> level_{ LogLevel::Info };
+    std::atomic<uint64_t> dropped_{ 0 };
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_ = false;
+    joining_thread drain_thread_;  // Declared last: started after everything above
+
+    /**
+     * @brief Hand every published message to the sink (drain thread only)
+     */
+    void drain();
+
+    /**
+     * @brief Drain thread body
+     */
+    void run();
+
+  public:
+    /**
+     * @brief Construct a logger and start its drain thread
+     * @param capacity Messages the ring buffer holds (rounded up to a power of two)
+     * @param sink Destination of drained messages
+     */
+    explicit Logger(size_t capacity = LOG_DEFAULT_CAPACITY, LogSink sink = LogSink());
+
+    /**
+     * @brief Deleted copy constructor
+     */
+    Logger(const Logger&) = delete;
+
+    /**
+     * @brief Deleted copy assignment
+     */
+    Logger& operator=(const Logger&) = delete;
+
+    /**
+     * @brief Deleted move constructor (the drain thread refers to this)
+     */
+    Logger(Logger&&) = delete;
+
+    /**
+     * @brief Deleted move assignment
+     */
+    Logger& operator=(Logger&&) = delete;
+
+    /**
+     * @brief Destructor - drains remaining messages and stops the thread
+     */
+    ~Logger();
+
+    /**
+     * @brief Get the process-wide logger
+     */
+    [[nodiscard]] static Logger& instance();
+
+    /**
+     * @brief Set the lowest level that is recorded at run time
+     *
+     * Levels below LOG_COMPILED_MIN_LEVEL stay compiled out regardless.
+     */
+    void set_level(LogLevel level) noexcept
+    {
+      level_.store(level, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get the lowest level that is recorded at run time
+     */
+    [[nodiscard]] LogLevel level() const noexcept
+    {
+      return level_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Check whether a message at this level would be recorded
+     */
+    [[nodiscard]] bool enabled(LogLevel level) const noexcept
+    {
+      return log_compiled_in(level) && level >= this->level();
+    }
+
+    /**
+     * @brief Format a message into the ring buffer (printf syntax)
+     * @return false if the buffer was full and the message was dropped
+     */
+    bool log(LogLevel level, const char* format, ...) noexcept __attribute__((format(printf, 3, 4)));
+
+    /**
+     * @brief Wait until every message logged before the call has reached the sink
+     */
+    void flush();
+
+    /**
+     * @brief Number of messages dropped because the buffer was full
+     */
+    [[nodiscard]] uint64_t dropped() const noexcept
+    {
+      return dropped_.load(std::memory_order_relaxed);
+    }
+  };
+
+}  // namespace project
+
+/**
+ * @brief Log through the process-wide logger if the level is compiled in and enabled
+ *
+ * Arguments are not evaluated unless the message is recorded.
+ */
+#define PROJECT_LOG(level, ...)                                        \
+  do                                                                   \
+  {                                                                    \
+    if constexpr (::project::log_compiled_in(level))                   \
+    {                                                                  \
+      ::project::Logger& project_log_ = ::project::Logger::instance(); \
+      if (project_log_.enabled(level))                                 \
+      {                                                                \
+        project_log_.log(level, __VA_ARGS__);                          \
+      }                                                                \
+    }                                                                  \
+  } while (false)
+
+#define PROJECT_LOG_TRACE(...) PROJECT_LOG(::project::LogLevel::Trace, __VA_ARGS__)
+#define PROJECT_LOG_DEBUG(...) PROJECT_LOG(::project::LogLevel::Debug, __VA_ARGS__)
+#define PROJECT_LOG_INFO(...) PROJECT_LOG(::project::LogLevel::Info, __VA_ARGS__)
+#define PROJECT_LOG_WARN(...) PROJECT_LOG(::project::LogLevel::Warn, __VA_ARGS__)
+#define PROJECT_LOG_ERROR(...) PROJECT_LOG(::project::LogLevel::Error, __VA_ARGS__)
+
+#endif  // PROJECT_LOGGER_HPP_
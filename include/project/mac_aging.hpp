@@ -0,0 +1,130 @@
+/**
+ * @file mac_aging.hpp
+ * @brief Coarse timestamps and a background sweeper for MAC aging
+ *
+ * Learned entries carry a 32-bit timestamp in seconds that the hot path
+ * refreshes with a single store; a background thread periodically evicts
+ * entries whose timestamp is older than the aging time.
+ */
+
+#ifndef PROJECT_MAC_AGING_HPP_
+#define PROJECT_MAC_AGING_HPP_
+
+#include "project/joining_thread.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+namespace project
+{
+  /**
+   * @brief Coarse monotonic timestamp in seconds
+   *
+   * Wraps after ~136 years; comparisons use unsigned differences.
+   */
+  using MacTimestamp = uint32_t;
+
+  /**
+   * @brief Default time after which an unrefreshed MAC entry is evicted
+   *
+   * Matches the customary bridge aging time of five minutes.
+   */
+  constexpr std::chrono::seconds MAC_DEFAULT_AGING_TIME{ 300 };
+
+  /**
+   * @brief Get the current coarse timestamp (steady clock, seconds)
+   */
+  [[nodiscard]] MacTimestamp mac_timestamp_now() noexcept;
+
+  /**
+   * @brief Get the coarse timestamp of a steady clock reading in nanoseconds, as mac_timestamp_now() would
+   */
+  [[nodiscard]] constexpr MacTimestamp mac_timestamp_at(uint64_t steady_ns) noexcept
+  {
+    return static_cast<MacTimestamp>(steady_ns / 1'000'000'000);
+  }
+
+  /**
+   * @brief Check whether an entry last seen at last_seen has outlived max_age
+   */
+  [[nodiscard]] constexpr bool mac_entry_expired(MacTimestamp last_seen, MacTimestamp now,
+                                                 std::chrono::seconds max_age) noexcept
+  {
+    const MacTimestamp age = now - last_seen;
+    return static_cast<int64_t>(age) > max_age.count();
+  }
+
+  /**
+   * @brief Runs a sweep function periodically on a background thread
+   *
+   * The thread is woken immediately by stop() or destruction, so shutdown
+   * never waits for a full interval.
+   *
+   * Example:
+   * @code
+   * ConcurrentMacTable table;
+   * AgingSweeper sweeper(std::chrono::seconds(30), [&table]() {
+   *   table.expire(MAC_DEFAULT_AGING_TIME);
+   * });
+   * @endcode
+   */
+  class AgingSweeper
+  {
+  private:
+    std::chrono::milliseconds interval_;
+    std::function<void()> sweep_;
+
+    std::mutex mutex_;
+    std::condition_variable wakeup_;
+    bool stopping_ = false;
+
+    // Declared last so it is joined before the members above are destroyed
+    joining_thread thread_;
+
+    void run();
+
+  public:
+    /**
+     * @brief Start sweeping
+     * @param interval Time between sweeps
+     * @param sweep Function called once per interval on the sweeper thread
+     */
+    AgingSweeper(std::chrono::milliseconds interval, std::function<void()> sweep);
+
+    /**
+     * @brief Deleted copy constructor
+     */
+    AgingSweeper(const AgingSweeper&) = delete;
+
+    /**
+     * @brief Deleted copy assignment
+     */
+    AgingSweeper& operator=(const AgingSweeper&) = delete;
+
+    /**
+     * @brief Deleted move constructor (the thread refers to this object)
+     */
+    AgingSweeper(AgingSweeper&&) = delete;
+
+    /**
+     * @brief Deleted move assignment
+     */
+    AgingSweeper& operator=(AgingSweeper&&) = delete;
+
+    /**
+     * @brief Destructor - stops and joins the sweeper thread
+     */
+    ~AgingSweeper();
+
+    /**
+     * @brief Stop sweeping and join the thread (idempotent)
+     */
+    void stop() noexcept;
+  };
+
+}  // namespace project
+
+#endif  // PROJECT_MAC_AGING_HPP_
@@ -0,0 +1,145 @@
+/**
+ * @file mac_snapshot.hpp
+ * @brief Binary snapshots of the MAC table for warm restarts
+ *
+ * A restarted switch with an empty table drops every unicast frame until
+ * each host has sent something again, and the broadcasts that follow
+ * arrive all at once. Saving the table on the way down and loading it on
+ * the way up lets the switch forward immediately; entries keep their age,
+ * so aging removes whatever moved in the meantime.
+ *
+ * File layout (little-endian, 32-byte header then 32-byte records):
+ * @code
+ * header: magic "VSWMACS\0" | u32 version | u32 record count | u64 wall clock (unix s) | u64 records checksum
+ * record: 6-byte MAC | u16 VLAN | u8 family (4/6) | u8 0 | u16 port | 16-byte address | u32 age (s)
+ * @endcode
+ * An IPv4 address takes the first 4 address bytes. Ages are relative to
+ * the wall clock in the header, so the time the switch was down counts.
+ */
+
+#ifndef PROJECT_MAC_SNAPSHOT_HPP_
+#define PROJECT_MAC_SNAPSHOT_HPP_
+
+#include "project/concurrent_mac_table.hpp"
+#include "project/expected.hpp"
+#include "project/mac_aging.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace project
+{
+  /**
+   * @brief Size of the snapshot header in bytes
+   */
+  constexpr size_t MAC_SNAPSHOT_HEADER_SIZE = 32;
+
+  /**
+   * @brief Size of one snapshot record in bytes
+   */
+  constexpr size_t MAC_SNAPSHOT_RECORD_SIZE = 32;
+
+  /**
+   * @brief Current snapshot format version
+   */
+  constexpr uint32_t MAC_SNAPSHOT_VERSION = 1;
+
+  /**
+   * @brief Error codes for snapshot operations
+   */
+  enum class MacSnapshotError
+  {
+    OpenFailed,
+    WriteFailed,
+    RenameFailed,
+    MapFailed,
+    BadFormat
+  };
+
+  /**
+   * @brief Convert MacSnapshotError to string representation
+   * @param error The error code
+   * @return String description of the error
+   */
+  [[nodiscard]] const char* to_string(MacSnapshotError error) noexcept;
+
+  /**
+   * @brief Encode entries into snapshot bytes
+   *
+   * @param entries The entries
+   * @param now Current coarse timestamp, to turn last_seen into ages (an
+   *            entry seen after now counts as just seen)
+   * @param wall_clock Current time in seconds since the epoch
+   * @return The snapshot
+   */
+  [[nodiscard]] std::vector<uint8_t> encode_mac_snapshot(const std::vector<LearnedMac>& entries, MacTimestamp now,
+                                                         uint64_t wall_clock);
+
+  /**
+   * @brief Decode snapshot bytes
+   *
+   * Records with an unknown address family or an invalid endpoint are
+   * skipped; a bad magic, version, size or checksum rejects the snapshot.
+   *
+   * @param data The snapshot
+   * @param size Size of the snapshot
+   * @param now Current coarse timestamp, the base of the decoded last_seen values
+   * @param wall_clock Current time in seconds since the epoch
+   * @return expected<std::vector<LearnedMac>, MacSnapshotError> The entries or BadFormat
+   */
+  [[nodiscard]] expected<std::vector<LearnedMac>, MacSnapshotError>
+  decode_mac_snapshot(const uint8_t* data, size_t size, MacTimestamp now, uint64_t wall_clock);
+
+  /**
+   * @brief Encode a table's current entries
+   * @param table The table
+   * @return The snapshot
+   */
+  [[nodiscard]] std::vector<uint8_t> snapshot_mac_table(const ConcurrentMacTable& table);
+
+  /**
+   * @brief Insert the entries of snapshot bytes into a table
+   *
+   * @param data The snapshot
+   * @param size Size of the snapshot
+   * @param table The table to insert into
+   * @param max_age The table's aging time; older entries are left out (0 keeps every entry)
+   * @return expected<size_t, MacSnapshotError> Number of entries inserted or BadFormat
+   */
+  [[nodiscard]] expected<size_t, MacSnapshotError> restore_mac_table(const uint8_t* data, size_t size,
+                                                                     ConcurrentMacTable& table,
+                                                                     std::chrono::seconds max_age);
+
+  /**
+   * @brief Write a table's snapshot to a file, atomically
+   *
+   * Writes a temporary file next to path, syncs it and renames it over
+   * path, so a crash leaves either the old snapshot or the new one.
+   *
+   * @param path The snapshot file
+   * @param table The table
+   * @return expected<size_t, MacSnapshotError> Number of entries written or an error
+   */
+  [[nodiscard]] expected<size_t, MacSnapshotError> save_mac_snapshot(const std::string& path,
+                                                                     const ConcurrentMacTable& table);
+
+  /**
+   * @brief Load a snapshot file into a table
+   *
+   * The file is mapped read-only rather than read, and entries older than
+   * max_age are left out.
+   *
+   * @param path The snapshot file
+   * @param table The table to insert into
+   * @param max_age The table's aging time (0 keeps every entry)
+   * @return expected<size_t, MacSnapshotError> Number of entries loaded or an error
+   */
+  [[nodiscard]] expected<size_t, MacSnapshotError> load_mac_snapshot(const std::string& path, ConcurrentMacTable& table,
+                                                                     std::chrono::seconds max_age);
+
+}  // namespace project
+
+#endif  // PROJECT_MAC_SNAPSHOT_HPP_
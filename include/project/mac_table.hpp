@@ -10,8 +10,11 @@
 #define PROJECT_MAC_TABLE_HPP_
 
 #include "project/ethernet_frame.hpp"
+#include "project/flat_mac_map.hpp"
+#include "project/mac_aging.hpp"
 #include "project/udp_socket.hpp"
 
+#include <chrono>
 #include <mutex>
 #include <optional>
 #include <shared_mutex>
@@ -23,13 +26,15 @@ namespace project
    * @brief Thread-safe MAC address learning table
    * 
    * Maintains a mapping from MAC addresses to endpoints (IP:port).
-   * Uses a shared read/write lock for efficient concurrent access.
+   * Entries live in a flat open-addressing map with inline endpoint
+   * storage. Uses a shared read/write lock for efficient concurrent access.
    * 
    * This follows the learning switch pattern:
    * 1. When a frame arrives, learn the source MAC → endpoint mapping
    * 2. When forwarding, lookup destination MAC in the table
    * 3. If found, forward to that endpoint only (unicast)
    * 4. If not found or broadcast, forward to all endpoints (broadcast)
+   * 5. Periodically expire() entries that have not been refreshed
    * 
    * Example:
    * @code
@@ -53,8 +58,17 @@ namespace project
   class MacTable
   {
   private:
+    /**
+     * @brief A learned endpoint and when it was last refreshed
+     */
+    struct Entry
+    {
+      Endpoint endpoint;
+      MacTimestamp last_seen = 0;
+    };
+
     // Mapping from MAC address to endpoint
-    std::unordered_map<MacAddress, Endpoint> table_;
+    FlatMacMap<Entry> table_;
 
     // Read/write mutex for thread-safe access
     // Uses shared_mutex for concurrent reads, exclusive writes
@@ -90,13 +104,15 @@ namespace project
      * @brief Insert or update a MAC → endpoint mapping
      * 
      * If the MAC address already exists, updates the endpoint.
-     * If it doesn't exist, creates a new entry.
+     * If it doesn't exist, creates a new entry. Either way the entry's
+     * age is reset.
      * 
      * @param mac The MAC address
      * @param endpoint The endpoint associated with this MAC
+     * @param now Current coarse timestamp
      * @return true if this is a new entry, false if it was updated
      */
-    bool insert(const MacAddress& mac, const Endpoint& endpoint);
+    bool insert(const MacAddress& mac, const Endpoint& endpoint, MacTimestamp now = mac_timestamp_now());
 
     /**
      * @brief Lookup endpoint for a MAC address
@@ -114,6 +130,15 @@ namespace project
      */
     bool remove(const MacAddress& mac);
 
+    /**
+     * @brief Remove every entry not refreshed within max_age
+     * 
+     * @param max_age Aging time
+     * @param now Current coarse timestamp
+     * @return Number of entries removed
+     */
+    size_t expire(std::chrono::seconds max_age, MacTimestamp now = mac_timestamp_now());
+
     /**
      * @brief Check if a MAC address exists in the table
      * 
@@ -179,11 +204,7 @@ namespace project
      * 
      * @return Copy of the MAC → endpoint map
      */
-    [[nodiscard]] std::unordered_map<MacAddress, Endpoint> get_all_entries() const
-    {
-      std::shared_lock lock(mutex_);
-      return table_;
-    }
+    [[nodiscard]] std::unordered_map<MacAddress, Endpoint> get_all_entries() const;
   };
 
 }  // namespace project
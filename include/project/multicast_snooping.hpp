@@ -0,0 +1,227 @@
+/**
+ * @file multicast_snooping.hpp
+ * @brief IGMP/MLD snooping: which ports want which multicast groups
+ *
+ * A learning switch never sees a multicast MAC as a source, so it can only
+ * drop multicast or flood it like a broadcast. Snooping listens in on the
+ * group membership protocols instead: hosts announce the groups they want
+ * with IGMP (IPv4) or MLD (IPv6) reports, and multicast routers reveal
+ * themselves by sending queries. The switch then replicates a group's
+ * frames only to the ports that reported it, plus the router ports.
+ */
+
+#ifndef PROJECT_MULTICAST_SNOOPING_HPP_
+#define PROJECT_MULTICAST_SNOOPING_HPP_
+
+#include "project/ethernet_frame.hpp"
+#include "project/mac_aging.hpp"
+#include "project/udp_socket.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace project
+{
+  /**
+   * @brief How long a membership report or a query keeps a port subscribed
+   *
+   * The IGMP/MLD group membership interval with default timers: robustness
+   * 2 times the 125 s query interval, plus 10 s of query response time.
+   */
+  constexpr std::chrono::seconds MULTICAST_MEMBERSHIP_TIME{ 260 };
+
+  /**
+   * @brief How long a port stays subscribed after leaving a group
+   *
+   * Long enough for the querier's group-specific queries to be answered by
+   * any other host behind the same port, which re-subscribes it.
+   */
+  constexpr std::chrono::seconds MULTICAST_LEAVE_LATENCY{ 2 };
+
+  /**
+   * @brief What a snooped IGMP or MLD message was
+   */
+  enum class SnoopingKind
+  {
+    None,   // Not a membership message
+    Query,  // Sent by a multicast router
+    Report  // Joins and leaves, listed in SnoopingMessage::groups
+  };
+
+  /**
+   * @brief One group a report joins or leaves
+   */
+  struct SnoopedGroup
+  {
+    MacAddress group;
+    bool join = true;
+  };
+
+  /**
+   * @brief The parsed content of an IGMP or MLD message
+   *
+   * Reused between calls so that parsing does not allocate once groups has
+   * grown to the largest report seen.
+   */
+  struct SnoopingMessage
+  {
+    SnoopingKind kind = SnoopingKind::None;
+    std::vector<SnoopedGroup> groups;
+  };
+
+  /**
+   * @brief Parse a frame as an IGMP (v1-v3) or MLD (v1-v2) message
+   *
+   * Handles an optional VLAN tag, IPv4 options and an IPv6 hop-by-hop
+   * header (where MLD carries its router alert). IGMPv3 and MLDv2 records
+   * are reduced to group granularity: a record joins its group unless it
+   * asks for no sources at all. Source-specific blocks and link-local
+   * groups (always flooded) are skipped.
+   *
+   * @param frame The Ethernet frame
+   * @param size Size of the frame
+   * @param message Output: the message's kind and groups
+   * @return true if the frame is an IGMP or MLD message
+   */
+  bool parse_snooping_message(const uint8_t* frame, size_t size, SnoopingMessage& message);
+
+  /**
+   * @brief Whether a multicast address must reach every port regardless of snooping
+   *
+   * True for 224.0.0.0/24 (01:00:5e:00:00:xx) and the reserved IPv6 groups
+   * mapped to 33:33:00:00:00:xx, such as all-nodes and mDNS: hosts do not
+   * report them, so snooping cannot know who listens.
+   */
+  [[nodiscard]] bool multicast_always_flooded(const MacAddress& mac) noexcept;
+
+  /**
+   * @brief Group → subscribed endpoints, per VLAN, with router ports
+   *
+   * Written from the forwarding threads when they snoop a membership
+   * message, which is rare next to data traffic, so writers and readers
+   * share one mutex. Forwarding threads cache members() per group and
+   * refetch only when generation() moves; it moves whenever a subscription
+   * or a router port appears or disappears, but not when one is refreshed.
+   */
+  class MulticastGroupTable
+  {
+  private:
+    // Endpoint → time after which it is no longer subscribed
+    using Subscribers = std::unordered_map<Endpoint, MacTimestamp>;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<uint64_t, Subscribers> groups_;  // Keyed by VLAN and group MAC
+    std::unordered_map<uint16_t, Subscribers> routers_;
+    std::atomic<uint64_t> generation_{ 0 };
+    std::chrono::seconds membership_time_ = MULTICAST_MEMBERSHIP_TIME;
+
+    /**
+     * @brief Pack a VLAN ID and a group MAC into a map key
+     */
+    [[nodiscard]] static uint64_t make_key(uint16_t vlan, const MacAddress& group) noexcept;
+
+    /**
+     * @brief Bump the generation (mutex held)
+     */
+    void changed() noexcept;
+
+  public:
+    /**
+     * @brief Construct an empty table
+     * @param membership_time How long a report or a query keeps a port subscribed
+     */
+    explicit MulticastGroupTable(std::chrono::seconds membership_time = MULTICAST_MEMBERSHIP_TIME);
+
+    /**
+     * @brief Move constructor (not safe against concurrent use of either table)
+     */
+    MulticastGroupTable(MulticastGroupTable&& other) noexcept;
+
+    /**
+     * @brief Move assignment operator (not safe against concurrent use of either table)
+     */
+    MulticastGroupTable& operator=(MulticastGroupTable&& other) noexcept;
+
+    /**
+     * @brief Deleted copy constructor
+     */
+    MulticastGroupTable(const MulticastGroupTable&) = delete;
+
+    /**
+     * @brief Deleted copy assignment
+     */
+    MulticastGroupTable& operator=(const MulticastGroupTable&) = delete;
+
+    /**
+     * @brief Destructor
+     */
+    ~MulticastGroupTable() = default;
+
+    /**
+     * @brief Subscribe an endpoint to a group, or refresh its subscription
+     * @return true if the endpoint was not subscribed before
+     */
+    bool join(uint16_t vlan, const MacAddress& group, const Endpoint& member, MacTimestamp now = mac_timestamp_now());
+
+    /**
+     * @brief Let an endpoint's subscription lapse within MULTICAST_LEAVE_LATENCY
+     *
+     * Another host behind the same endpoint keeps it subscribed by answering
+     * the querier's group-specific query before then.
+     *
+     * @return true if the endpoint was subscribed
+     */
+    bool leave(uint16_t vlan, const MacAddress& group, const Endpoint& member, MacTimestamp now = mac_timestamp_now());
+
+    /**
+     * @brief Record an endpoint a query came from as a router port of a VLAN
+     *
+     * Router ports receive every multicast frame of their VLAN, and the
+     * membership reports that the hosts send.
+     *
+     * @return true if the endpoint was not a router port before
+     */
+    bool add_router(uint16_t vlan, const Endpoint& router, MacTimestamp now = mac_timestamp_now());
+
+    /**
+     * @brief Drop subscriptions and router ports that have lapsed
+     * @return Number of entries removed
+     */
+    size_t expire(MacTimestamp now = mac_timestamp_now());
+
+    /**
+     * @brief Get the endpoints a group's frames go to: its subscribers and the VLAN's router ports
+     * @param vlan The VLAN ID
+     * @param group The group MAC
+     * @param out Output, each endpoint once
+     * @return true if anyone subscribed to the group
+     */
+    bool members(uint16_t vlan, const MacAddress& group, std::vector<Endpoint>& out) const;
+
+    /**
+     * @brief Get the router ports of a VLAN
+     */
+    void routers(uint16_t vlan, std::vector<Endpoint>& out) const;
+
+    /**
+     * @brief Get the generation of the subscriptions
+     */
+    [[nodiscard]] uint64_t generation() const noexcept
+    {
+      return generation_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Number of groups with at least one subscriber
+     */
+    [[nodiscard]] size_t group_count() const;
+  };
+
+}  // namespace project
+
+#endif  // PROJECT_MULTICAST_SNOOPING_HPP_
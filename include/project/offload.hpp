@@ -0,0 +1,126 @@
+/**
+ * @file offload.hpp
+ * @brief Segmentation and checksum offload helpers for TAP devices
+ *
+ * A TAP device opened with IFF_VNET_HDR prefixes every frame with a
+ * virtio-net header. With offloads enabled through TUNSETOFFLOAD, the kernel
+ * may then hand over TCP super-frames of up to 64 KiB (GSO) and leave the
+ * transport checksum to be filled in. These helpers turn such a frame into
+ * ordinary Ethernet frames for the wire, laid out back to back so that one
+ * UDP GSO send (UDP_SEGMENT) carries all of them.
+ */
+
+#ifndef PROJECT_OFFLOAD_HPP_
+#define PROJECT_OFFLOAD_HPP_
+
+#include "project/expected.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace project
+{
+  /**
+   * @brief Buffer size for a GSO super-frame, or for the frames it is cut into
+   *
+   * A super-frame is at most 64 KiB; its segments repeat the headers, which
+   * for gso_size ≥ 536 adds well under another 64 KiB.
+   */
+  constexpr size_t OFFLOAD_BUFFER_SIZE = 128 * 1024;
+
+  /**
+   * @brief The virtio-net header a TAP device with IFF_VNET_HDR puts before each frame
+   *
+   * Field for field struct virtio_net_hdr, in host byte order.
+   */
+  struct VnetHeader
+  {
+    uint8_t flags = 0;
+    uint8_t gso_type = 0;
+    uint16_t hdr_len = 0;      // Length of the headers to repeat in each segment (a hint)
+    uint16_t gso_size = 0;     // Payload bytes per segment
+    uint16_t csum_start = 0;   // Offset of the transport header whose checksum is missing
+    uint16_t csum_offset = 0;  // Offset of the checksum field from csum_start
+  };
+  static_assert(sizeof(VnetHeader) == 10, "VnetHeader must match struct virtio_net_hdr");
+
+  /**
+   * @brief VnetHeader::flags bit: the checksum at csum_start + csum_offset is still to be completed
+   */
+  constexpr uint8_t VNET_HDR_F_NEEDS_CSUM = 1;
+
+  /**
+   * @brief VnetHeader::gso_type values (the top bit is VNET_HDR_GSO_ECN)
+   */
+  constexpr uint8_t VNET_HDR_GSO_NONE = 0;
+  constexpr uint8_t VNET_HDR_GSO_TCPV4 = 1;
+  constexpr uint8_t VNET_HDR_GSO_TCPV6 = 4;
+  constexpr uint8_t VNET_HDR_GSO_ECN = 0x80;
+
+  /**
+   * @brief Error codes for offload processing
+   */
+  enum class OffloadError
+  {
+    Truncated,
+    UnsupportedGso,
+    BufferTooSmall
+  };
+
+  /**
+   * @brief Convert OffloadError to string representation
+   * @param error The error code
+   * @return String description of the error
+   */
+  [[nodiscard]] const char* to_string(OffloadError error) noexcept;
+
+  /**
+   * @brief The frames segment_frame() wrote
+   *
+   * Every frame is segment_size bytes except possibly the last, which is
+   * what UDP_SEGMENT expects.
+   */
+  struct SegmentedFrames
+  {
+    size_t size = 0;
+    size_t segment_size = 0;
+    size_t segments = 0;
+  };
+
+  /**
+   * @brief Fill in a checksum the kernel left to the device
+   *
+   * Without VNET_HDR_F_NEEDS_CSUM this does nothing. Otherwise the field
+   * holds the pseudo-header sum, and the checksum over everything from
+   * csum_start is folded into it, as a NIC would.
+   *
+   * @param header The frame's virtio-net header
+   * @param frame The Ethernet frame, changed in place
+   * @param size Size of the frame
+   * @return expected<void, OffloadError> Success, or Truncated if the offsets lie outside the frame
+   */
+  [[nodiscard]] expected<void, OffloadError> complete_checksum(const VnetHeader& header, uint8_t* frame, size_t size);
+
+  /**
+   * @brief Cut a TCP GSO super-frame into Ethernet frames of at most gso_size payload bytes
+   *
+   * Each segment repeats the Ethernet (and VLAN), IP and TCP headers with the
+   * IP length, IPv4 identification and checksum, TCP sequence number and
+   * checksum rewritten. FIN and PSH stay on the last segment only, CWR on the
+   * first. IPv6 extension headers must not sit between the IPv6 and TCP
+   * headers. A frame of at most one segment comes out as one frame with its
+   * checksum complete.
+   *
+   * @param header The super-frame's virtio-net header (TCPv4 or TCPv6 GSO)
+   * @param frame The super-frame, starting at the Ethernet header
+   * @param size Size of the super-frame
+   * @param out Where the segments go, back to back
+   * @param capacity Size of out
+   * @return expected<SegmentedFrames, OffloadError> The segments written or an error
+   */
+  [[nodiscard]] expected<SegmentedFrames, OffloadError> segment_frame(const VnetHeader& header, const uint8_t* frame,
+                                                                      size_t size, uint8_t* out, size_t capacity);
+
+}  // namespace project
+
+#endif  // PROJECT_OFFLOAD_HPP_
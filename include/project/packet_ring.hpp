@@ -0,0 +1,219 @@
+/**
+ * @file packet_ring.hpp
+ * @brief Memory-mapped AF_PACKET rings (TPACKET_V3) for the VSwitch underlay
+ *
+ * A PacketRing receives the UDP datagrams for one local port straight off
+ * an interface and sends UDP datagrams by writing whole frames into a ring
+ * shared with the kernel. Receiving takes no system call while the ring
+ * holds packets, and a burst of sends takes one, however long it is.
+ *
+ * The ring is used through UdpSocket::attach_packet_ring(): the socket
+ * keeps the port bound (so the kernel sends no port unreachables) and
+ * sends whatever the ring cannot, while receive_batch() and send_batch()
+ * go through the ring.
+ *
+ * Limits:
+ * - IPv4 only, and only unfragmented datagrams; larger sends use the
+ *   socket, which fragments.
+ * - Frames are addressed to the Ethernet source of the last datagram
+ *   received from the same IPv4 address (the peer, or the router in front
+ *   of it). Destinations not heard from yet go through the socket.
+ * - A block of the receive ring is handed over when it is full or 1 ms
+ *   after its first packet, so under light load datagrams wait up to that
+ *   long.
+ * - Datagrams still pass through the kernel's IP layer; the socket drops
+ *   its copy.
+ * - Not for 127.0.0.0/8 peers: the IP layer drops frames for loopback
+ *   addresses arriving on an interface (unless route_localnet is set).
+ */
+
+#ifndef PROJECT_PACKET_RING_HPP_
+#define PROJECT_PACKET_RING_HPP_
+
+#include "project/ethernet_frame.hpp"
+#include "project/expected.hpp"
+#include "project/sys_utils.hpp"
+#include "project/udp_socket.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace project
+{
+  /**
+   * @brief Size of one receive ring block
+   */
+  constexpr size_t PACKET_RING_BLOCK_SIZE = size_t{ 1 } << 20;
+
+  /**
+   * @brief Number of receive ring blocks
+   */
+  constexpr size_t PACKET_RING_RX_BLOCKS = 16;
+
+  /**
+   * @brief Number of send ring frames
+   */
+  constexpr size_t PACKET_RING_TX_FRAMES = 512;
+
+  /**
+   * @brief Error codes for packet ring setup
+   */
+  enum class PacketRingError
+  {
+    Unsupported,
+    SocketFailed,
+    InterfaceNotFound,
+    FilterFailed,
+    RingSetupFailed,
+    MapFailed,
+    BindFailed,
+    FanoutFailed
+  };
+
+  /**
+   * @brief Convert PacketRingError to string representation
+   * @param error The error code
+   * @return String description of the error
+   */
+  [[nodiscard]] const char* to_string(PacketRingError error) noexcept;
+
+  /**
+   * @brief Receive and send ring for the UDP datagrams of one local port
+   *
+   * Rings for the same port join one fanout group, so with several
+   * workers the kernel spreads flows across their rings by hash, as
+   * SO_REUSEPORT does across sockets. Not thread-safe: one worker uses a
+   * ring.
+   */
+  class PacketRing
+  {
+  private:
+    /**
+     * @brief What frames to a peer's address go out with
+     */
+    struct Neighbor
+    {
+      MacAddress mac;      // Next hop
+      uint32_t local = 0;  // Our address as the peer used it (network order)
+    };
+
+    SocketHandle socket_;
+    MemoryMapping mapping_;
+    uint8_t* rx_ = nullptr;
+    uint8_t* tx_ = nullptr;
+    size_t rx_blocks_ = 0;
+    size_t rx_block_size_ = 0;
+    size_t tx_frames_ = 0;
+    size_t tx_frame_size_ = 0;
+    size_t tx_next_ = 0;
+    size_t rx_block_ = 0;                 // Block being read
+    const uint8_t* rx_packet_ = nullptr;  // Next packet in it
+    uint32_t rx_left_ = 0;                // Packets left in it
+    MacAddress interface_mac_;
+    size_t mtu_ = 0;
+    uint32_t local_address_ = 0;  // Network order; 0 when bound to any address
+    uint16_t local_port_ = 0;     // Network order
+    uint16_t ip_id_ = 0;
+    std::unordered_map<uint32_t, Neighbor> neighbors_;
+
+  public:
+    /**
+     * @brief Default constructor - creates an invalid ring
+     */
+    PacketRing() = default;
+
+    /**
+     * @brief Set up rings on an interface for datagrams to a local endpoint
+     *
+     * Needs CAP_NET_RAW.
+     *
+     * @param interface Interface name (e.g., "eth0")
+     * @param local The bound IPv4 endpoint of the UDP socket
+     * @param max_frame_size Largest datagram to receive and send through the ring
+     * @return expected<PacketRing, PacketRingError> The ring or an error
+     */
+    [[nodiscard]] static expected<PacketRing, PacketRingError> create(const std::string& interface,
+                                                                      const Endpoint& local, size_t max_frame_size);
+
+    /**
+     * @brief Move constructor
+     */
+    PacketRing(PacketRing&& other) noexcept = default;
+
+    /**
+     * @brief Move assignment operator
+     */
+    PacketRing& operator=(PacketRing&& other) noexcept = default;
+
+    /**
+     * @brief Deleted copy constructor
+     */
+    PacketRing(const PacketRing&) = delete;
+
+    /**
+     * @brief Deleted copy assignment
+     */
+    PacketRing& operator=(const PacketRing&) = delete;
+
+    /**
+     * @brief Destructor - unmaps the rings and closes the socket
+     */
+    ~PacketRing() = default;
+
+    /**
+     * @brief Copy the datagrams waiting in the ring into receive slots
+     *
+     * Waits (poll) only when the ring is empty.
+     *
+     * @param datagrams Caller-owned receive slots
+     * @param count Number of slots
+     * @param timeout_ms Longest wait for the first datagram (-1: forever, 0: do not wait)
+     * @return Number of slots filled (0 when the wait timed out)
+     */
+    [[nodiscard]] size_t receive(InboundDatagram* datagrams, size_t count, int timeout_ms);
+
+    /**
+     * @brief Queue datagrams into the send ring and have the kernel send them, with one system call
+     *
+     * Datagrams the ring cannot send (IPv6, unknown next hop, larger than
+     * the MTU, ring full) are appended to fallback instead, in order.
+     * Invalid destinations are skipped.
+     *
+     * @param datagrams The datagrams
+     * @param count Number of datagrams
+     * @param fallback Receives the datagrams to send some other way
+     * @return Number of datagrams handed to the kernel
+     */
+    [[nodiscard]] size_t send(const OutboundDatagram* datagrams, size_t count,
+                              std::vector<OutboundDatagram>& fallback);
+
+    /**
+     * @brief Get the number of peers whose next hop is known
+     */
+    [[nodiscard]] size_t neighbors() const noexcept
+    {
+      return neighbors_.size();
+    }
+
+    /**
+     * @brief Check if the ring is valid
+     */
+    [[nodiscard]] bool is_valid() const noexcept
+    {
+      return socket_.is_valid();
+    }
+
+  private:
+    /**
+     * @brief Hand the block being read back to the kernel and move to the next one
+     */
+    void release_block() noexcept;
+  };
+
+}  // namespace project
+
+#endif  // PROJECT_PACKET_RING_HPP_
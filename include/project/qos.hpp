@@ -0,0 +1,165 @@
+/**
+ * @file qos.hpp
+ * @brief Per-port ingress policing and priority scheduling of the VSwitch's sends
+ *
+ * A worker processes its bursts in arrival order, so a VPort sending as
+ * fast as it can takes most of every burst and of every send batch. Two
+ * mechanisms keep it from starving the others:
+ *
+ * - IngressPolicer gives every source endpoint a token bucket and drops
+ *   what it sends beyond its rate before the frame costs a table lookup.
+ * - EgressScheduler splits each send batch into priority classes (from
+ *   the 802.1p bits of a VLAN tag, or else the IP DSCP) and interleaves
+ *   them with deficit round robin, so latency-sensitive frames go out
+ *   first without the bulk classes being starved.
+ */
+
+#ifndef PROJECT_QOS_HPP_
+#define PROJECT_QOS_HPP_
+
+#include "project/udp_socket.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace project
+{
+  /**
+   * @brief Number of egress priority classes
+   */
+  constexpr size_t QOS_CLASS_COUNT = 4;
+
+  /**
+   * @brief Bytes a class may send per DRR round, per unit of weight (one full-size Ethernet frame)
+   */
+  constexpr size_t QOS_DRR_QUANTUM = 1514;
+
+  /**
+   * @brief Default number of source endpoints an IngressPolicer tracks
+   */
+  constexpr size_t QOS_DEFAULT_POLICER_PORTS = 1024;
+
+  /**
+   * @brief Get the 802.1p priority of a frame (0-7)
+   *
+   * The PCP bits of a VLAN tag if there is one, otherwise the class
+   * selector bits (the top three) of the IPv4 or IPv6 DSCP. Anything else
+   * is 0, best effort.
+   *
+   * @param frame The Ethernet frame
+   * @param size Size of the frame
+   * @return The priority
+   */
+  [[nodiscard]] uint8_t frame_priority(const uint8_t* frame, size_t size) noexcept;
+
+  /**
+   * @brief Map an 802.1p priority to a class, 0 (lowest) to QOS_CLASS_COUNT - 1
+   *
+   * Follows the IEEE 802.1Q recommendation for four queues: priorities 1
+   * and 2 (background) rank below 0 (best effort) and 3, then 4-5, then 6-7.
+   */
+  [[nodiscard]] constexpr size_t priority_class(uint8_t priority) noexcept
+  {
+    constexpr uint8_t CLASSES[8] = { 1, 0, 0, 1, 2, 2, 3, 3 };
+    return CLASSES[priority & 7];
+  }
+
+  /**
+   * @brief Token-bucket policing per source endpoint
+   *
+   * Each endpoint's bucket holds at most burst bytes and refills at rate
+   * bytes per second; a frame is admitted if the bucket holds its size.
+   *
+   * The buckets live in a fixed array of cache-line-sized slots grouped
+   * into sets of four. An endpoint hashes to one set, so a lookup reads at
+   * most four adjacent lines, and the set's least recently seen endpoint
+   * makes room for a new one (which starts with a full bucket). The last
+   * sender's slot is remembered, since bursts tend to come from one port.
+   *
+   * Not thread-safe: every VSwitch worker owns one.
+   */
+  class IngressPolicer
+  {
+  private:
+    static constexpr size_t WAYS = 4;
+    static constexpr uint64_t NS_PER_SECOND = 1'000'000'000;
+
+    struct alignas(64) Slot
+    {
+      Endpoint endpoint;        // Invalid for a free slot
+      uint64_t tokens = 0;      // Bytes times NS_PER_SECOND, so refills keep their fractions
+      uint64_t updated_ns = 0;  // When tokens were last brought up to date
+    };
+
+    std::vector<Slot> slots_;
+    uint64_t rate_ = 0;
+    uint64_t burst_ = 0;
+    size_t last_ = 0;  // Slot of the most recent sender
+
+    [[nodiscard]] Slot& slot_for(const Endpoint& endpoint, uint64_t now_ns) noexcept;
+
+  public:
+    /**
+     * @brief Construct a policer that admits everything (rate 0)
+     */
+    IngressPolicer() = default;
+
+    /**
+     * @brief Construct a policer
+     * @param rate Bytes per second each endpoint may send (0 admits everything)
+     * @param burst Bytes an endpoint may send at once after being idle
+     * @param ports Endpoints to track before evicting (rounded up to whole sets)
+     */
+    IngressPolicer(uint64_t rate, uint64_t burst, size_t ports = QOS_DEFAULT_POLICER_PORTS);
+
+    /**
+     * @brief Whether policing is on
+     */
+    [[nodiscard]] bool enabled() const noexcept
+    {
+      return rate_ > 0;
+    }
+
+    /**
+     * @brief Decide whether to accept a frame, taking its size from the sender's bucket
+     * @param sender The endpoint the frame came from
+     * @param bytes Size of the frame
+     * @param now_ns Current time in nanoseconds (any monotonic origin)
+     * @return true to accept the frame, false to drop it
+     */
+    [[nodiscard]] bool admit(const Endpoint& sender, size_t bytes, uint64_t now_ns) noexcept;
+  };
+
+  /**
+   * @brief Deficit round robin over the priority classes of a send batch
+   *
+   * Each class gets a quantum of weight * QOS_DRR_QUANTUM bytes per round,
+   * with weights 1, 2, 4 and 8 from the lowest class up, and sends its
+   * queued datagrams in order while its deficit covers them. The highest
+   * class is visited first in every round. Datagrams of one class keep
+   * their order, so the copies of a flooded frame stay back to back.
+   *
+   * Not thread-safe: every VSwitch worker owns one.
+   */
+  class EgressScheduler
+  {
+  private:
+    std::array<std::vector<OutboundDatagram>, QOS_CLASS_COUNT> queues_;
+    std::vector<OutboundDatagram> order_;
+
+  public:
+    /**
+     * @brief Reorder a batch for sending
+     *
+     * Single-class batches are left untouched.
+     *
+     * @param batch The datagrams, reordered in place
+     */
+    void schedule(std::vector<OutboundDatagram>& batch);
+  };
+
+}  // namespace project
+
+#endif  // PROJECT_QOS_HPP_
@@ -0,0 +1,216 @@
+/**
+ * @file socket_handoff.hpp
+ * @brief Passing bound sockets and switch state to a successor process
+ *
+ * Restarting a switch to upgrade it closes its sockets: until the new
+ * process has bound the port again, every datagram sent to it is lost.
+ * Instead, the running process can hand its sockets over a Unix domain
+ * socket (SCM_RIGHTS). Both processes then hold the same kernel sockets,
+ * so datagrams that arrive while one stops and the other starts wait in
+ * the socket buffers rather than being refused.
+ *
+ * Protocol, on a SOCK_STREAM connection from successor to predecessor:
+ * @code
+ * predecessor: magic "VSWHAND\0" | u32 version | u32 socket count | u64 state size  (+ sockets as SCM_RIGHTS)
+ *              state bytes (a MAC table snapshot, see mac_snapshot.hpp)
+ * successor:   one ack byte, once it has adopted the sockets
+ * @endcode
+ * Integers are little-endian. The predecessor keeps forwarding until the
+ * ack arrives, so a successor that fails on the way costs nothing.
+ */
+
+#ifndef PROJECT_SOCKET_HANDOFF_HPP_
+#define PROJECT_SOCKET_HANDOFF_HPP_
+
+#include "project/expected.hpp"
+#include "project/sys_utils.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace project
+{
+  /**
+   * @brief Most sockets one handoff carries (the kernel's SCM_MAX_FD)
+   */
+  constexpr size_t HANDOFF_MAX_SOCKETS = 253;
+
+  /**
+   * @brief Current handoff protocol version
+   */
+  constexpr uint32_t HANDOFF_VERSION = 1;
+
+  /**
+   * @brief How long either side waits for the other before giving up
+   */
+  constexpr std::chrono::milliseconds HANDOFF_TIMEOUT{ 5000 };
+
+  /**
+   * @brief Error codes for handoff operations
+   */
+  enum class HandoffError
+  {
+    SocketFailed,
+    BindFailed,
+    ConnectFailed,
+    PeerRejected,
+    TooManySockets,
+    SendFailed,
+    ReceiveFailed,
+    Timeout,
+    BadMessage
+  };
+
+  /**
+   * @brief Convert HandoffError to string representation
+   * @param error The error code
+   * @return String description of the error
+   */
+  [[nodiscard]] const char* to_string(HandoffError error) noexcept;
+
+  /**
+   * @brief What a successor receives from its predecessor
+   */
+  struct Handoff
+  {
+    std::vector<SocketHandle> sockets;  ///< The predecessor's sockets, in its order
+    std::vector<uint8_t> state;         ///< Opaque state bytes
+  };
+
+  /**
+   * @brief Send sockets and state over a connected Unix stream socket
+   *
+   * The caller keeps its own descriptors; the peer receives duplicates
+   * of them.
+   *
+   * @param channel The connection
+   * @param sockets Descriptors to pass (at most HANDOFF_MAX_SOCKETS)
+   * @param state State bytes
+   * @return expected<void, HandoffError> Success or an error
+   */
+  [[nodiscard]] expected<void, HandoffError> send_handoff(int channel, const std::vector<int>& sockets,
+                                                          const std::vector<uint8_t>& state);
+
+  /**
+   * @brief Receive what send_handoff() sent
+   *
+   * @param channel The connection
+   * @param timeout Longest wait for each part of the message
+   * @return expected<Handoff, HandoffError> The sockets and state, or an error
+   */
+  [[nodiscard]] expected<Handoff, HandoffError> receive_handoff(int channel,
+                                                                std::chrono::milliseconds timeout = HANDOFF_TIMEOUT);
+
+  /**
+   * @brief Tell the predecessor its sockets are in use here now
+   * @param channel The connection
+   * @return expected<void, HandoffError> Success or SendFailed
+   */
+  [[nodiscard]] expected<void, HandoffError> send_handoff_ack(int channel);
+
+  /**
+   * @brief Wait for the successor's ack
+   *
+   * @param channel The connection
+   * @param timeout Longest wait
+   * @return expected<void, HandoffError> Success, Timeout, or ReceiveFailed if the peer closed first
+   */
+  [[nodiscard]] expected<void, HandoffError> wait_handoff_ack(int channel,
+                                                              std::chrono::milliseconds timeout = HANDOFF_TIMEOUT);
+
+  /**
+   * @brief Connect to a predecessor's HandoffListener
+   * @param path The listener's socket path
+   * @return expected<SocketHandle, HandoffError> The connection, or ConnectFailed if nothing listens there
+   */
+  [[nodiscard]] expected<SocketHandle, HandoffError> connect_handoff(const std::string& path);
+
+  /**
+   * @brief Unix socket on which a running process waits for its successor
+   *
+   * Listens at a filesystem path, readable and writable by the owner only;
+   * connections from processes of another user (other than root) are
+   * refused, since whoever connects gets the sockets. The path is removed
+   * on destruction unless a successor has bound a new listener there.
+   */
+  class HandoffListener
+  {
+  private:
+    SocketHandle socket_;
+    std::string path_;
+    uint64_t inode_ = 0;  // Of the socket file, to recognize a successor's listener at the same path
+
+  public:
+    /**
+     * @brief Default constructor - creates an invalid listener
+     */
+    HandoffListener() = default;
+
+    /**
+     * @brief Listen at a path, replacing a stale socket file there
+     * @param path The socket path
+     * @return expected<HandoffListener, HandoffError> The listener or an error
+     */
+    [[nodiscard]] static expected<HandoffListener, HandoffError> create(const std::string& path);
+
+    /**
+     * @brief Move constructor
+     */
+    HandoffListener(HandoffListener&& other) noexcept;
+
+    /**
+     * @brief Move assignment operator
+     */
+    HandoffListener& operator=(HandoffListener&& other) noexcept;
+
+    /**
+     * @brief Deleted copy constructor
+     */
+    HandoffListener(const HandoffListener&) = delete;
+
+    /**
+     * @brief Deleted copy assignment
+     */
+    HandoffListener& operator=(const HandoffListener&) = delete;
+
+    /**
+     * @brief Destructor - closes the socket and removes its path
+     */
+    ~HandoffListener();
+
+    /**
+     * @brief Wait for a successor to connect
+     * @param timeout Longest wait
+     * @return expected<SocketHandle, HandoffError> The connection, Timeout, or PeerRejected
+     */
+    [[nodiscard]] expected<SocketHandle, HandoffError> accept(std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Get the socket path
+     */
+    [[nodiscard]] const std::string& path() const noexcept
+    {
+      return path_;
+    }
+
+    /**
+     * @brief Check if the listener is valid
+     */
+    [[nodiscard]] bool is_valid() const noexcept
+    {
+      return socket_.is_valid();
+    }
+
+  private:
+    /**
+     * @brief Close the socket, removing the path if it still is ours
+     */
+    void close() noexcept;
+  };
+
+}  // namespace project
+
+#endif  // PROJECT_SOCKET_HANDOFF_HPP_
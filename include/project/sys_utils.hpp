@@ -9,6 +9,8 @@
 #ifndef PROJECT_SYS_UTILS_HPP_
 #define PROJECT_SYS_UTILS_HPP_
 
+#include <cerrno>
+#include <cstddef>
 #include <stdexcept>
 #include <string>
 #include <system_error>
@@ -301,6 +303,150 @@ namespace project
     }
   };
 
+  /**
+   * @brief RAII wrapper for an mmap()ed memory region
+   * 
+   * Unmaps the region when destroyed. Move-only, like FileDescriptor.
+   */
+  class MemoryMapping
+  {
+  private:
+    void* address_;
+    size_t size_;
+
+  public:
+    /**
+     * @brief Default constructor - creates an empty mapping
+     */
+    MemoryMapping() noexcept : address_(nullptr), size_(0)
+    {
+    }
+
+    /**
+     * @brief Takes ownership of the result of mmap()
+     * @param address The mapped address (MAP_FAILED or nullptr for an empty mapping)
+     * @param size The length passed to mmap()
+     */
+    MemoryMapping(void* address, size_t size) noexcept;
+
+    /**
+     * @brief Map anonymous, zero-filled, page-aligned read/write memory
+     * @param size Number of bytes (rounded up to whole pages by the kernel)
+     * @return The mapping; empty if mmap() failed
+     */
+    [[nodiscard]] static MemoryMapping anonymous(size_t size) noexcept;
+
+    /**
+     * @brief Move constructor
+     */
+    MemoryMapping(MemoryMapping&& other) noexcept : address_(other.address_), size_(other.size_)
+    {
+      other.address_ = nullptr;
+      other.size_ = 0;
+    }
+
+    /**
+     * @brief Move assignment operator
+     */
+    MemoryMapping& operator=(MemoryMapping&& other) noexcept
+    {
+      if (this != &other)
+      {
+        unmap();
+        address_ = other.address_;
+        size_ = other.size_;
+        other.address_ = nullptr;
+        other.size_ = 0;
+      }
+      return *this;
+    }
+
+    /**
+     * @brief Deleted copy constructor
+     */
+    MemoryMapping(const MemoryMapping&) = delete;
+
+    /**
+     * @brief Deleted copy assignment
+     */
+    MemoryMapping& operator=(const MemoryMapping&) = delete;
+
+    /**
+     * @brief Destructor - unmaps the region
+     */
+    ~MemoryMapping()
+    {
+      unmap();
+    }
+
+    /**
+     * @brief Unmap the region; safe to call multiple times
+     */
+    void unmap() noexcept;
+
+    /**
+     * @brief Get the start of the region
+     */
+    [[nodiscard]] void* data() const noexcept
+    {
+      return address_;
+    }
+
+    /**
+     * @brief Get the length of the region in bytes
+     */
+    [[nodiscard]] size_t size() const noexcept
+    {
+      return size_;
+    }
+
+    /**
+     * @brief Check if a region is mapped
+     */
+    [[nodiscard]] bool is_valid() const noexcept
+    {
+      return address_ != nullptr;
+    }
+
+    /**
+     * @brief Explicit conversion to bool for validity checking
+     */
+    explicit operator bool() const noexcept
+    {
+      return is_valid();
+    }
+  };
+
+  /**
+   * @brief Pin the calling thread to a single CPU
+   * 
+   * @param cpu Zero-based CPU index
+   * @return true on success, false if the CPU is unavailable or pinning is
+   *         unsupported on this platform
+   */
+  [[nodiscard]] bool pin_current_thread(size_t cpu) noexcept;
+
+  /**
+   * @brief Switch a file descriptor between blocking and non-blocking mode (O_NONBLOCK)
+   * 
+   * @param fd The descriptor to change
+   * @param enable true for non-blocking, false for blocking
+   * @return true on success, false if the flags could not be read or set
+   */
+  [[nodiscard]] bool set_nonblocking(int fd, bool enable) noexcept;
+
+  /**
+   * @brief Check whether an errno value means a non-blocking call would have blocked
+   */
+  [[nodiscard]] inline bool would_block(int error) noexcept
+  {
+#if EAGAIN == EWOULDBLOCK
+    return error == EAGAIN;
+#else
+    return error == EAGAIN || error == EWOULDBLOCK;
+#endif
+  }
+
 }  // namespace project
 
 #endif  // PROJECT_SYS_UTILS_HPP_
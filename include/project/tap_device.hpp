@@ -10,6 +10,8 @@
 #define PROJECT_TAP_DEVICE_HPP_
 
 #include "project/expected.hpp"
+#include "project/frame_pool.hpp"
+#include "project/offload.hpp"
 #include "project/sys_utils.hpp"
 
 #include <array>
@@ -25,6 +27,11 @@ namespace project
    */
   constexpr size_t ETHER_MAX_LEN = 1518;
 
+  /**
+   * @brief Most queues one multi-queue TAP device can have (the kernel's MAX_TAP_QUEUES)
+   */
+  constexpr size_t TAP_MAX_QUEUES = 256;
+
   /**
    * @brief Error codes for TAP device operations
    */
@@ -35,7 +42,9 @@ namespace project
     ReadFailed,
     WriteFailed,
     InvalidDevice,
-    PartialWrite
+    PartialWrite,
+    WouldBlock,
+    InvalidQueueCount
   };
 
   /**
@@ -76,12 +85,20 @@ namespace project
   private:
     FileDescriptor fd_;
     std::string device_name_;
+    bool nonblocking_ = false;
+    bool offloads_ = false;  // Frames carry a VnetHeader (IFF_VNET_HDR)
 
     /**
      * @brief Private constructor (use create() instead)
      */
     TapDevice(FileDescriptor fd, std::string device_name);
 
+    /**
+     * @brief Open /dev/net/tun and create or attach to the named device with TUNSETIFF flags
+     */
+    [[nodiscard]] static expected<TapDevice, TapError> open_queue(std::string_view device_name, int flags,
+                                                                  bool offloads);
+
   public:
     /**
      * @brief Create a TAP device with the specified name
@@ -89,10 +106,35 @@ namespace project
      * Creates a TAP device. If the name is empty, the kernel assigns a name.
      * The device is configured with IFF_TAP | IFF_NO_PI flags.
      * 
+     * With offloads, IFF_VNET_HDR is added and checksum and TCP segmentation
+     * offload are enabled (TUNSETOFFLOAD), so the kernel may hand over TCP
+     * super-frames of up to 64 KiB with the checksum left to us. Reads then
+     * need buffers of OFFLOAD_BUFFER_SIZE and the overload that returns the
+     * VnetHeader.
+     * 
      * @param device_name Desired device name (e.g., "tap0"), or empty for auto-assignment
+     * @param offloads Enable the virtio-net header and offloads
      * @return expected<TapDevice, TapError> The created device or an error
      */
-    [[nodiscard]] static expected<TapDevice, TapError> create(std::string_view device_name = "");
+    [[nodiscard]] static expected<TapDevice, TapError> create(std::string_view device_name = "", bool offloads = false);
+
+    /**
+     * @brief Create a multi-queue TAP device with one descriptor per queue
+     * 
+     * Creates the device with IFF_TAP | IFF_NO_PI | IFF_MULTI_QUEUE and
+     * attaches queues - 1 more descriptors to it. The kernel spreads the
+     * frames it sends out over the queues by flow, and frames written to any
+     * of them enter the same interface, so each queue can be served by its
+     * own thread. The device goes away when the last queue is closed.
+     * 
+     * @param device_name Desired device name, or empty for auto-assignment
+     * @param queues Number of queues, 1 to TAP_MAX_QUEUES
+     * @param offloads Enable the virtio-net header and offloads on every queue, as for create()
+     * @return expected<std::vector<TapDevice>, TapError> One TapDevice per queue, all with the same name
+     */
+    [[nodiscard]] static expected<std::vector<TapDevice>, TapError> create_multi_queue(std::string_view device_name,
+                                                                                       size_t queues,
+                                                                                       bool offloads = false);
 
     /**
      * @brief Default constructor - creates an invalid device
@@ -133,10 +175,47 @@ namespace project
      */
     [[nodiscard]] expected<std::vector<uint8_t>, TapError> read_frame();
 
+    /**
+     * @brief Read an Ethernet frame into a caller-provided pooled buffer
+     * 
+     * Reads directly into the buffer (no intermediate copy or allocation)
+     * and sets its size. Blocks unless the device is in non-blocking mode,
+     * where an empty queue fails with TapError::WouldBlock.
+     * 
+     * @param buffer The buffer to fill (must be valid)
+     * @return expected<size_t, TapError> Number of bytes read or an error
+     */
+    [[nodiscard]] expected<size_t, TapError> read_frame(FrameBuffer& buffer);
+
+    /**
+     * @brief Read an Ethernet frame and its virtio-net header
+     * 
+     * On a device with offloads the frame may be a GSO super-frame or lack
+     * its transport checksum, as the header says; otherwise the header is
+     * zeroed.
+     * 
+     * @param buffer The buffer to fill with the frame (must be valid)
+     * @param header Set to the frame's virtio-net header
+     * @return expected<size_t, TapError> Number of frame bytes read or an error
+     */
+    [[nodiscard]] expected<size_t, TapError> read_frame(FrameBuffer& buffer, VnetHeader& header);
+
+    /**
+     * @brief Read an Ethernet frame into raw memory (the virtio-net header of an offloading device is dropped)
+     * 
+     * Lets a caller keep headroom in front of the frame, as tunnel encryption does.
+     * 
+     * @param data Where to put the frame
+     * @param capacity Bytes available at data
+     * @return expected<size_t, TapError> Number of frame bytes read or an error
+     */
+    [[nodiscard]] expected<size_t, TapError> read_frame(uint8_t* data, size_t capacity);
+
     /**
      * @brief Write an Ethernet frame to the TAP device
      * 
-     * Writes a complete Ethernet frame to the device.
+     * Writes a complete Ethernet frame to the device; on a device with
+     * offloads, behind an empty virtio-net header.
      * 
      * @param frame The frame data to write
      * @return expected<size_t, TapError> Number of bytes written or an error
@@ -152,6 +231,17 @@ namespace project
      */
     [[nodiscard]] expected<size_t, TapError> write_frame(const uint8_t* data, size_t size);
 
+    /**
+     * @brief Switch the device between blocking and non-blocking mode
+     * 
+     * In non-blocking mode, reads and writes that would wait fail with
+     * TapError::WouldBlock instead, as an event loop needs.
+     * 
+     * @param enable true for non-blocking
+     * @return expected<void, TapError> Success or error
+     */
+    [[nodiscard]] expected<void, TapError> set_nonblocking(bool enable);
+
     /**
      * @brief Check if the device is valid
      * @return true if the device is valid and open
@@ -161,6 +251,14 @@ namespace project
       return fd_.is_valid();
     }
 
+    /**
+     * @brief Check whether frames carry a virtio-net header and may be offloaded
+     */
+    [[nodiscard]] bool offloads_enabled() const noexcept
+    {
+      return offloads_;
+    }
+
     /**
      * @brief Get the device name
      * @return The device name (e.g., "tap0")
@@ -0,0 +1,127 @@
+/**
+ * @file traffic_stats.hpp
+ * @brief Per-thread packet counters and their snapshots
+ *
+ * Each forwarding thread owns a TrafficCounters block on its own cache lines
+ * and is its only writer, so counting is a plain load and store with
+ * no locked instruction and no cache line shared with other threads.
+ * Readers take snapshots at any time and merge them.
+ */
+
+#ifndef PROJECT_TRAFFIC_STATS_HPP_
+#define PROJECT_TRAFFIC_STATS_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace project
+{
+  /**
+   * @brief A point-in-time copy of a set of traffic counters
+   */
+  struct TrafficStats
+  {
+    uint64_t rx_frames = 0;
+    uint64_t rx_bytes = 0;
+    uint64_t tx_frames = 0;
+    uint64_t tx_bytes = 0;
+    uint64_t floods = 0;                 // Frames copied to every other port (broadcasts, flooded unknowns)
+    uint64_t unknown_unicast_drops = 0;  // Frames to a MAC that has not been learned
+    uint64_t send_errors = 0;            // Datagrams or frames the kernel refused
+    uint64_t tap_partial_writes = 0;     // Frames the TAP device accepted only in part
+    uint64_t vlan_drops = 0;             // Frames outside the VLANs of the port they arrived on
+    uint64_t multicast_drops = 0;        // Multicast frames for a group no other port wants
+    uint64_t policed_drops = 0;          // Frames over their sender's ingress rate
+    uint64_t crypto_drops = 0;           // Datagrams failing authentication or replay checks, or with no key
+
+    /**
+     * @brief Add another snapshot to this one
+     */
+    TrafficStats& operator+=(const TrafficStats& other) noexcept;
+  };
+
+  /**
+   * @brief Counters written by exactly one thread
+   *
+   * add() is a relaxed load and store, not a read-modify-write: with a
+   * single writer no increment can be lost, and concurrent snapshot()
+   * readers still see whole values. Aligned to and padded out to whole
+   * cache lines so that the counters of different threads never share one.
+   */
+  struct alignas(64) TrafficCounters
+  {
+    std::atomic<uint64_t> rx_frames{ 0 };
+    std::atomic<uint64_t> rx_bytes{ 0 };
+    std::atomic<uint64_t> tx_frames{ 0 };
+    std::atomic<uint64_t> tx_bytes{ 0 };
+    std::atomic<uint64_t> floods{ 0 };
+    std::atomic<uint64_t> unknown_unicast_drops{ 0 };
+    std::atomic<uint64_t> send_errors{ 0 };
+    std::atomic<uint64_t> tap_partial_writes{ 0 };
+    std::atomic<uint64_t> vlan_drops{ 0 };
+    std::atomic<uint64_t> multicast_drops{ 0 };
+    std::atomic<uint64_t> policed_drops{ 0 };
+    std::atomic<uint64_t> crypto_drops{ 0 };
+
+    /**
+     * @brief Construct zeroed counters
+     */
+    TrafficCounters() = default;
+
+    /**
+     * @brief Copy the current values (lets containers of workers relocate)
+     */
+    TrafficCounters(const TrafficCounters& other) noexcept;
+
+    /**
+     * @brief Copy the current values
+     */
+    TrafficCounters& operator=(const TrafficCounters& other) noexcept;
+
+    /**
+     * @brief Destructor
+     */
+    ~TrafficCounters() = default;
+
+    /**
+     * @brief Add to a counter (owning thread only)
+     */
+    static void add(std::atomic<uint64_t>& counter, uint64_t amount) noexcept
+    {
+      counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Read every counter (any thread)
+     */
+    [[nodiscard]] TrafficStats snapshot() const noexcept;
+  };
+
+  static_assert(sizeof(TrafficCounters) % 64 == 0, "TrafficCounters should fill whole cache lines");
+
+  /**
+   * @brief Render snapshots in the Prometheus text exposition format
+   *
+   * Every counter becomes a metric family named <prefix>_<counter>_total
+   * with one sample per series. Counters that do not apply to a component
+   * (e.g. TAP writes on the switch) are simply reported as 0.
+   *
+   * Example output for prefix "vswitch" and series {"worker=\"0\"", stats}:
+   * @code
+   * # TYPE vswitch_rx_frames_total counter
+   * vswitch_rx_frames_total{worker="0"} 42
+   * @endcode
+   *
+   * @param prefix Metric name prefix
+   * @param series Label set (without braces; may be empty) and snapshot of each series
+   */
+  [[nodiscard]] std::string format_prometheus(std::string_view prefix,
+                                              const std::vector<std::pair<std::string, TrafficStats>>& series);
+
+}  // namespace project
+
+#endif  // PROJECT_TRAFFIC_STATS_HPP_
@@ -0,0 +1,482 @@
+/**
+ * @file tunnel_crypto.hpp
+ * @brief Authenticated encryption of the datagrams between VPorts and the VSwitch
+ *
+ * Every VPort socket has its own 256-bit key, identified by a number; the
+ * VSwitch holds all of them. A sealed datagram is
+ *
+ *   key id (4) | session (8) | sequence (8) | ciphertext | tag (16)
+ *
+ * in network byte order, with the 20-byte header as associated data. The
+ * cipher is AES-256-GCM or ChaCha20-Poly1305 (OpenSSL, which uses AES-NI,
+ * AVX2 and friends when the CPU has them) and is configured, not sent.
+ *
+ * Nonces must never repeat under a key, across restarts and in both
+ * directions. So nothing is encrypted with the configured key itself:
+ * each sender picks a session number when it starts (the time in
+ * milliseconds, plus random bits) and encrypts under a key derived from
+ * the configured one, the session and the direction with HKDF-SHA256. The
+ * nonce is then just the sequence number.
+ *
+ * A receiver keeps, per key, the newest session it authenticated and a
+ * window of the sequence numbers seen in it, and drops replays and
+ * datagrams from older sessions. Hence a key belongs to one sender per
+ * direction, and a sender whose clock went back must wait until it passes
+ * its previous start.
+ */
+
+#ifndef PROJECT_TUNNEL_CRYPTO_HPP_
+#define PROJECT_TUNNEL_CRYPTO_HPP_
+
+#include "project/expected.hpp"
+#include "project/udp_socket.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct evp_cipher_ctx_st;
+
+namespace project
+{
+  /**
+   * @brief Size of a tunnel key in bytes
+   */
+  constexpr size_t TUNNEL_KEY_SIZE = 32;
+
+  /**
+   * @brief Bytes in front of the ciphertext: key id, session and sequence number
+   */
+  constexpr size_t TUNNEL_HEADER_SIZE = 20;
+
+  /**
+   * @brief Size of the authentication tag behind the ciphertext
+   */
+  constexpr size_t TUNNEL_TAG_SIZE = 16;
+
+  /**
+   * @brief Bytes a sealed datagram is longer than its frame
+   */
+  constexpr size_t TUNNEL_OVERHEAD = TUNNEL_HEADER_SIZE + TUNNEL_TAG_SIZE;
+
+  /**
+   * @brief Sequence numbers behind the newest one that may still arrive (out of order) once
+   */
+  constexpr size_t TUNNEL_REPLAY_WINDOW = 256;
+
+  /**
+   * @brief AEAD algorithm of a tunnel
+   */
+  enum class TunnelCipher
+  {
+    Aes256Gcm,
+    ChaCha20Poly1305
+  };
+
+  /**
+   * @brief Convert TunnelCipher to its name ("aes-256-gcm", "chacha20-poly1305")
+   */
+  [[nodiscard]] const char* to_string(TunnelCipher cipher) noexcept;
+
+  /**
+   * @brief Parse a cipher name as printed by to_string()
+   */
+  [[nodiscard]] std::optional<TunnelCipher> parse_tunnel_cipher(std::string_view name) noexcept;
+
+  /**
+   * @brief Which way a datagram travels; each direction encrypts under its own keys
+   */
+  enum class TunnelRole : uint8_t
+  {
+    Port = 1,   // Seals for the VSwitch, opens what it sends
+    Switch = 2  // Seals for the VPorts, opens what they send
+  };
+
+  /**
+   * @brief Error codes for tunnel encryption
+   */
+  enum class TunnelError
+  {
+    Unsupported,
+    InvalidKey,
+    DuplicateKey,
+    KeyFileFailed,
+    CipherFailed,
+    UnknownKey,
+    Malformed,
+    AuthenticationFailed,
+    Replayed,
+    BufferTooSmall
+  };
+
+  /**
+   * @brief Convert TunnelError to string representation
+   * @param error The error code
+   * @return String description of the error
+   */
+  [[nodiscard]] const char* to_string(TunnelError error) noexcept;
+
+  /**
+   * @brief Key id that is never configured, standing for "no key"
+   */
+  constexpr uint32_t TUNNEL_NO_KEY = 0;
+
+  /**
+   * @brief A configured tunnel key
+   */
+  struct TunnelKey
+  {
+    uint32_t id = 0;
+    std::array<uint8_t, TUNNEL_KEY_SIZE> secret{};
+  };
+
+  /**
+   * @brief Parse tunnel keys, one "<id> <64 hex digits>" per line
+   *
+   * Blank lines and lines starting with '#' are skipped. Ids are 1 to 2^32 - 1.
+   *
+   * @param text The key file's contents
+   * @return expected<std::vector<TunnelKey>, TunnelError> The keys in file order, InvalidKey or DuplicateKey
+   */
+  [[nodiscard]] expected<std::vector<TunnelKey>, TunnelError> parse_tunnel_keys(std::string_view text);
+
+  /**
+   * @brief Read and parse a key file (see parse_tunnel_keys())
+   * @param path The file
+   * @return expected<std::vector<TunnelKey>, TunnelError> The keys, or KeyFileFailed if the file cannot be read
+   */
+  [[nodiscard]] expected<std::vector<TunnelKey>, TunnelError> load_tunnel_keys(const std::string& path);
+
+  /**
+   * @brief Sequence numbers accepted so far in one session
+   */
+  class ReplayWindow
+  {
+  private:
+    static constexpr size_t WORDS = TUNNEL_REPLAY_WINDOW / 64;
+
+    uint64_t next_ = 0;  // One past the newest sequence number accepted
+    std::array<uint64_t, WORDS> seen_{};
+
+  public:
+    /**
+     * @brief Accept a sequence number that was neither seen nor fell behind the window
+     * @return true if the datagram is new (and is now marked seen)
+     */
+    bool accept(uint64_t sequence) noexcept;
+  };
+
+  /**
+   * @brief One AEAD context with its key expanded, reused for every datagram
+   *
+   * Only the nonce changes between datagrams, so the key schedule runs
+   * once. Not thread-safe.
+   */
+  class AeadCipher
+  {
+  private:
+    struct ContextDeleter
+    {
+      void operator()(evp_cipher_ctx_st* context) const noexcept;
+    };
+
+    std::unique_ptr<evp_cipher_ctx_st, ContextDeleter> context_;
+
+  public:
+    /**
+     * @brief Default constructor - creates an invalid cipher
+     */
+    AeadCipher() = default;
+
+    /**
+     * @brief Set up a cipher for one direction
+     * @param cipher The algorithm
+     * @param key TUNNEL_KEY_SIZE bytes
+     * @param encrypt true to seal, false to open
+     * @return expected<AeadCipher, TunnelError> The cipher, Unsupported without OpenSSL, or CipherFailed
+     */
+    [[nodiscard]] static expected<AeadCipher, TunnelError> create(TunnelCipher cipher, const uint8_t* key,
+                                                                  bool encrypt);
+
+    /**
+     * @brief Encrypt gathered plaintext
+     *
+     * out may be the first piece's own memory (in place), but must not
+     * overlap any other piece.
+     *
+     * @param nonce 12 bytes
+     * @param aad Associated data
+     * @param aad_size Its size
+     * @param pieces The plaintext
+     * @param count Number of pieces
+     * @param out Receives the ciphertext, as long as the pieces together
+     * @param tag Receives TUNNEL_TAG_SIZE bytes
+     * @return false if the cipher failed
+     */
+    [[nodiscard]] bool seal(const uint8_t* nonce, const uint8_t* aad, size_t aad_size, const struct iovec* pieces,
+                            size_t count, uint8_t* out, uint8_t* tag) noexcept;
+
+    /**
+     * @brief Decrypt and authenticate, in place if out == in
+     * @return false if the tag did not match (out then holds garbage)
+     */
+    [[nodiscard]] bool open(const uint8_t* nonce, const uint8_t* aad, size_t aad_size, const uint8_t* in, size_t size,
+                            uint8_t* out, const uint8_t* tag) noexcept;
+
+    /**
+     * @brief Check if the cipher is valid
+     */
+    [[nodiscard]] bool is_valid() const noexcept
+    {
+      return context_ != nullptr;
+    }
+  };
+
+  /**
+   * @brief The keys of one side of the tunnel and the state shared by all its threads
+   *
+   * Holds each key's send sequence (atomic) and receive window (under a
+   * short per-key lock), and, for the VSwitch, which key each VPort
+   * endpoint authenticated with. The cipher contexts themselves are per
+   * thread, in TunnelContext. Neither copyable nor movable: contexts point
+   * at it.
+   */
+  class TunnelKeyring
+  {
+  private:
+    struct KeyState
+    {
+      TunnelKey key;
+      std::atomic<uint64_t> next_sequence{ 0 };
+      std::mutex receive_mutex;
+      uint64_t receive_session = 0;
+      ReplayWindow window;
+    };
+
+    TunnelCipher cipher_;
+    TunnelRole role_;
+    uint64_t session_;
+    std::unordered_map<uint32_t, std::unique_ptr<KeyState>> keys_;  // Fixed after construction
+
+    mutable std::mutex peers_mutex_;
+    std::unordered_map<Endpoint, uint32_t> peers_;
+    std::atomic<uint64_t> peers_generation_{ 0 };
+
+    TunnelKeyring(TunnelCipher cipher, TunnelRole role, uint64_t session);
+
+  public:
+    /**
+     * @brief Set up the keys of one side
+     * @param cipher The algorithm both sides use
+     * @param role Which side this is
+     * @param keys At least one key, ids unique
+     * @return expected<std::unique_ptr<TunnelKeyring>, TunnelError> The keyring, InvalidKey, DuplicateKey or Unsupported
+     */
+    [[nodiscard]] static expected<std::unique_ptr<TunnelKeyring>, TunnelError> create(TunnelCipher cipher,
+                                                                                      TunnelRole role,
+                                                                                      const std::vector<TunnelKey>& keys);
+
+    TunnelKeyring(const TunnelKeyring&) = delete;
+    TunnelKeyring& operator=(const TunnelKeyring&) = delete;
+    TunnelKeyring(TunnelKeyring&&) = delete;
+    TunnelKeyring& operator=(TunnelKeyring&&) = delete;
+    ~TunnelKeyring() = default;
+
+    /**
+     * @brief Get the algorithm
+     */
+    [[nodiscard]] TunnelCipher cipher() const noexcept
+    {
+      return cipher_;
+    }
+
+    /**
+     * @brief Get which side this is
+     */
+    [[nodiscard]] TunnelRole role() const noexcept
+    {
+      return role_;
+    }
+
+    /**
+     * @brief Get the session this side seals in
+     */
+    [[nodiscard]] uint64_t session() const noexcept
+    {
+      return session_;
+    }
+
+    /**
+     * @brief Get the number of keys
+     */
+    [[nodiscard]] size_t size() const noexcept
+    {
+      return keys_.size();
+    }
+
+    /**
+     * @brief Check whether a key id is configured
+     */
+    [[nodiscard]] bool contains(uint32_t key_id) const noexcept
+    {
+      return keys_.count(key_id) != 0;
+    }
+
+    /**
+     * @brief Derive the key one session seals in for one direction (HKDF-Expand, RFC 5869)
+     * @param key_id A configured key
+     * @param sender The side that seals with it
+     * @param session The sender's session
+     * @param out Receives TUNNEL_KEY_SIZE bytes
+     * @return false if key_id is not configured or hashing failed
+     */
+    [[nodiscard]] bool derive(uint32_t key_id, TunnelRole sender, uint64_t session, uint8_t* out) const noexcept;
+
+    /**
+     * @brief Take the next sequence number to seal with under a key
+     */
+    [[nodiscard]] uint64_t next_sequence(uint32_t key_id) noexcept;
+
+    /**
+     * @brief Record an authenticated datagram, rejecting replays and older sessions
+     * @return true if it is new
+     */
+    [[nodiscard]] bool accept(uint32_t key_id, uint64_t session, uint64_t sequence) noexcept;
+
+    /**
+     * @brief Remember that an endpoint authenticated with a key, so frames to it are sealed with that key
+     */
+    void bind(const Endpoint& endpoint, uint32_t key_id);
+
+    /**
+     * @brief Get the key an endpoint last authenticated with
+     */
+    [[nodiscard]] std::optional<uint32_t> key_of(const Endpoint& endpoint) const;
+
+    /**
+     * @brief Get a counter that moves whenever bind() changes an endpoint's key
+     */
+    [[nodiscard]] uint64_t peers_generation() const noexcept
+    {
+      return peers_generation_.load(std::memory_order_acquire);
+    }
+  };
+
+  /**
+   * @brief Where an opened datagram's frame is
+   */
+  struct TunnelFrame
+  {
+    uint8_t* data = nullptr;  // Inside the datagram; nullptr if it was dropped
+    size_t size = 0;
+    uint32_t key_id = 0;
+  };
+
+  /**
+   * @brief One thread's cipher contexts for a keyring
+   *
+   * Contexts are created on first use of a key (and again when a peer
+   * starts a new session), so a burst costs one nonce setup and one pass
+   * over the data per datagram. Not thread-safe: each forwarding thread
+   * has its own.
+   */
+  class TunnelContext
+  {
+  private:
+    struct Receiver
+    {
+      uint64_t session = 0;
+      AeadCipher cipher;
+    };
+
+    TunnelKeyring* keyring_ = nullptr;
+    std::unordered_map<uint32_t, AeadCipher> senders_;
+    std::unordered_map<uint32_t, Receiver> receivers_;
+
+  public:
+    /**
+     * @brief Default constructor - creates a context without keys
+     */
+    TunnelContext() = default;
+
+    /**
+     * @brief Create a context for a keyring, which must outlive it
+     */
+    explicit TunnelContext(TunnelKeyring& keyring) noexcept : keyring_(&keyring)
+    {
+    }
+
+    /**
+     * @brief Seal a frame
+     *
+     * For sealing in place, put the frame at out + TUNNEL_HEADER_SIZE and
+     * pass it as the only piece.
+     *
+     * @param key_id The key to seal with
+     * @param pieces The frame
+     * @param count Number of pieces
+     * @param out Receives the sealed datagram
+     * @param capacity Size of out
+     * @return expected<size_t, TunnelError> The datagram's size, or an error
+     */
+    [[nodiscard]] expected<size_t, TunnelError> seal(uint32_t key_id, const struct iovec* pieces, size_t count,
+                                                     uint8_t* out, size_t capacity);
+
+    /**
+     * @brief Authenticate and decrypt a datagram in place
+     * @param datagram The datagram; its frame is decrypted where the ciphertext was
+     * @param size Its size
+     * @return expected<TunnelFrame, TunnelError> The frame, or why the datagram must be dropped
+     */
+    [[nodiscard]] expected<TunnelFrame, TunnelError> open(uint8_t* datagram, size_t size);
+
+    /**
+     * @brief Open a received burst in place
+     *
+     * Truncated datagrams and those failing open() come out as frames
+     * with a null data pointer.
+     *
+     * @param datagrams The burst
+     * @param count Its size
+     * @param frames Receives one entry per datagram
+     * @return Number of datagrams opened
+     */
+    size_t open_batch(InboundDatagram* datagrams, size_t count, TunnelFrame* frames);
+
+    /**
+     * @brief Seal a burst of outgoing frames into an arena and point the burst at the results
+     *
+     * Datagram i is sealed with key_ids[i] into arena + i * stride and
+     * replaced by the sealed datagram. Datagrams that cannot be sealed are
+     * removed, keeping the order of the rest.
+     *
+     * @param datagrams The burst
+     * @param key_ids The key of each datagram
+     * @param count Its size
+     * @param arena At least count * stride bytes
+     * @param stride Room per datagram; at least its wire size plus TUNNEL_OVERHEAD
+     * @return Number of datagrams left at the front of the burst
+     */
+    size_t seal_batch(OutboundDatagram* datagrams, const uint32_t* key_ids, size_t count, uint8_t* arena,
+                      size_t stride);
+
+    /**
+     * @brief Check if the context has a keyring
+     */
+    [[nodiscard]] bool is_valid() const noexcept
+    {
+      return keyring_ != nullptr;
+    }
+  };
+
+}  // namespace project
+
+#endif  // PROJECT_TUNNEL_CRYPTO_HPP_
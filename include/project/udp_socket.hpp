@@ -9,9 +9,21 @@
 #define PROJECT_UDP_SOCKET_HPP_
 
 #include "project/expected.hpp"
+#include "project/frame_pool.hpp"
+#include "project/hash.hpp"
 #include "project/sys_utils.hpp"
 
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <array>
+#include <chrono>
 #include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -29,7 +41,9 @@ namespace project
     ReceiveFailed,
     InvalidEndpoint,
     AddressResolutionFailed,
-    InvalidSocket
+    InvalidSocket,
+    SocketOptionFailed,
+    WouldBlock
   };
 
   /**
@@ -43,62 +57,158 @@ namespace project
    * @brief Represents a network endpoint (IP address + port)
    * 
    * An endpoint is an address that can be used for UDP communication.
-   * Internally stores a sockaddr_in structure for IPv4 addresses.
+   * Internally stores a ready-to-use sockaddr_in or sockaddr_in6, so the
+   * socket hot path passes it straight to the kernel without parsing, and
+   * equality/hashing are a few integer compares. The textual form is only
+   * produced on demand (address(), to_string()) for logging.
+   * 
+   * The address is parsed once at construction. An address that is neither
+   * a numeric IPv4 nor IPv6 address yields an invalid endpoint.
    */
   class Endpoint
   {
   private:
-    std::string address_;
-    uint16_t port_;
+    union
+    {
+      struct sockaddr_in v4;
+      struct sockaddr_in6 v6;
+    } addr_;
 
   public:
     /**
      * @brief Default constructor - creates an invalid endpoint
      */
-    Endpoint() noexcept : address_(), port_(0)
+    Endpoint() noexcept
     {
+      std::memset(&addr_, 0, sizeof(addr_));
+      addr_.v4.sin_family = AF_UNSPEC;
     }
 
     /**
      * @brief Construct an endpoint from address and port
-     * @param address IP address (e.g., "127.0.0.1" or "0.0.0.0")
+     * @param address IP address (e.g., "127.0.0.1", "0.0.0.0" or "::1")
      * @param port Port number
      */
-    Endpoint(std::string address, uint16_t port) noexcept : address_(std::move(address)), port_(port)
+    Endpoint(std::string_view address, uint16_t port) noexcept;
+
+    /**
+     * @brief Construct from a kernel IPv4 socket address
+     */
+    explicit Endpoint(const struct sockaddr_in& addr) noexcept : Endpoint()
     {
+      addr_.v4 = addr;
     }
 
     /**
-     * @brief Get the IP address
-     * @return The IP address string
+     * @brief Construct from a kernel IPv6 socket address
      */
-    [[nodiscard]] const std::string& address() const noexcept
+    explicit Endpoint(const struct sockaddr_in6& addr) noexcept : Endpoint()
     {
-      return address_;
+      addr_.v6 = addr;
     }
 
+    /**
+     * @brief Get the IP address as text
+     * @return The IP address string (empty for an unspecified endpoint)
+     */
+    [[nodiscard]] std::string address() const;
+
     /**
      * @brief Get the port number
      * @return The port number
      */
     [[nodiscard]] uint16_t port() const noexcept
     {
-      return port_;
+      // sin_port and sin6_port share the common initial sequence of both structs
+      return ntohs(addr_.v4.sin_port);
+    }
+
+    /**
+     * @brief Get a copy of this endpoint with another port
+     */
+    [[nodiscard]] Endpoint with_port(uint16_t port) const noexcept
+    {
+      Endpoint copy = *this;
+      copy.addr_.v4.sin_port = htons(port);
+      return copy;
     }
 
     /**
-     * @brief Convert to string representation (e.g., "127.0.0.1:8080")
+     * @brief Get the address family (AF_INET, AF_INET6 or AF_UNSPEC)
+     */
+    [[nodiscard]] int family() const noexcept
+    {
+      return addr_.v4.sin_family;
+    }
+
+    /**
+     * @brief Get the stored socket address for passing to socket syscalls
+     */
+    [[nodiscard]] const struct sockaddr* as_sockaddr() const noexcept
+    {
+      return reinterpret_cast<const struct sockaddr*>(&addr_);
+    }
+
+    /**
+     * @brief Get writable storage for syscalls that fill in a sender address
+     * 
+     * Large enough for either family; after the syscall the endpoint reflects
+     * whatever address the kernel wrote.
+     */
+    [[nodiscard]] struct sockaddr* as_sockaddr() noexcept
+    {
+      return reinterpret_cast<struct sockaddr*>(&addr_);
+    }
+
+    /**
+     * @brief Get the length of the stored socket address for its family
+     */
+    [[nodiscard]] socklen_t sockaddr_size() const noexcept
+    {
+      return family() == AF_INET6 ? sizeof(struct sockaddr_in6) : sizeof(struct sockaddr_in);
+    }
+
+    /**
+     * @brief Get the size of the writable sockaddr storage
+     */
+    [[nodiscard]] static constexpr socklen_t sockaddr_capacity() noexcept
+    {
+      return sizeof(addr_);
+    }
+
+    /**
+     * @brief Convert to string representation (e.g., "127.0.0.1:8080" or "[::1]:8080")
      * @return String representation
      */
     [[nodiscard]] std::string to_string() const;
 
     /**
      * @brief Check if the endpoint is valid
-     * @return true if the endpoint has a non-empty address and non-zero port
+     * @return true if the endpoint has a parsed address and non-zero port
      */
     [[nodiscard]] bool is_valid() const noexcept
     {
-      return !address_.empty() && port_ != 0;
+      return (family() == AF_INET || family() == AF_INET6) && port() != 0;
+    }
+
+    /**
+     * @brief Cheap hash of the binary address and port
+     */
+    [[nodiscard]] size_t hash() const noexcept
+    {
+      uint64_t h = (static_cast<uint64_t>(family()) << 16) | addr_.v4.sin_port;
+      if (family() == AF_INET6)
+      {
+        uint64_t words[2];
+        std::memcpy(words, &addr_.v6.sin6_addr, sizeof(words));
+        h ^= words[0] ^ (words[1] * 0x9e3779b97f4a7c15ULL) ^ addr_.v6.sin6_scope_id;
+      }
+      else
+      {
+        h ^= static_cast<uint64_t>(addr_.v4.sin_addr.s_addr) << 24;
+      }
+
+      return mix64(h);
     }
 
     /**
@@ -106,7 +216,18 @@ namespace project
      */
     bool operator==(const Endpoint& other) const noexcept
     {
-      return address_ == other.address_ && port_ == other.port_;
+      if (family() != other.family() || addr_.v4.sin_port != other.addr_.v4.sin_port)
+      {
+        return false;
+      }
+
+      if (family() == AF_INET6)
+      {
+        return std::memcmp(&addr_.v6.sin6_addr, &other.addr_.v6.sin6_addr, sizeof(addr_.v6.sin6_addr)) == 0 &&
+               addr_.v6.sin6_scope_id == other.addr_.v6.sin6_scope_id;
+      }
+
+      return addr_.v4.sin_addr.s_addr == other.addr_.v4.sin_addr.s_addr;
     }
 
     /**
@@ -123,6 +244,102 @@ namespace project
    */
   std::ostream& operator<<(std::ostream& os, const Endpoint& endpoint);
 
+  /**
+   * @brief Maximum number of datagrams moved by a single batched syscall
+   *
+   * Larger batches passed to receive_batch()/send_batch() are split into
+   * chunks of this size.
+   */
+  constexpr size_t UDP_MAX_BATCH_SIZE = 64;
+
+  /**
+   * @brief Most datagrams handed to the kernel in one segmentation offload send (UDP_MAX_SEGMENTS on older kernels)
+   */
+  constexpr size_t UDP_GSO_MAX_SEGMENTS = 64;
+
+  /**
+   * @brief Smallest datagram sent with MSG_ZEROCOPY once UdpSocket::set_zerocopy() is on
+   *
+   * Pinning pages and reaping the completion costs more than copying below
+   * roughly this size, so only jumbo frames skip the copy.
+   */
+  constexpr size_t UDP_ZEROCOPY_MIN_SIZE = 8192;
+
+  /**
+   * @brief Most bytes an OutboundDatagram can splice into its data
+   */
+  constexpr size_t UDP_MAX_SPLICE_SIZE = 8;
+
+  /**
+   * @brief Most iovecs OutboundDatagram::to_iovecs() fills in (head, spliced bytes, tail)
+   */
+  constexpr size_t UDP_MAX_DATAGRAM_IOVECS = 3;
+
+  /**
+   * @brief A caller-owned receive slot for UdpSocket::receive_batch()
+   *
+   * The caller provides the storage behind data and its capacity (typically
+   * a FrameBuffer); receive_batch() fills in size, truncated and sender for
+   * every slot it completes.
+   */
+  struct InboundDatagram
+  {
+    uint8_t* data = nullptr;
+    size_t capacity = 0;
+    size_t size = 0;
+    bool truncated = false;
+    Endpoint sender;
+  };
+
+  /**
+   * @brief A datagram queued for UdpSocket::send_batch()
+   *
+   * The data is not copied; it must stay valid until send_batch() returns.
+   * Several entries may point at the same buffer (e.g., for broadcasts).
+   *
+   * An entry can also edit its copy on the way out without touching the
+   * shared buffer: at offset splice_at, splice_cut bytes of data are left
+   * out and the first splice_size bytes of splice_bytes go out instead
+   * (e.g., to push or pop a VLAN tag). The datagram is then gathered from
+   * up to three pieces.
+   */
+  struct OutboundDatagram
+  {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    Endpoint destination;
+    uint16_t splice_at = 0;
+    uint16_t splice_cut = 0;
+    uint8_t splice_size = 0;
+    std::array<uint8_t, UDP_MAX_SPLICE_SIZE> splice_bytes{};
+
+    /**
+     * @brief Whether the datagram differs from data on the wire
+     */
+    [[nodiscard]] bool spliced() const noexcept
+    {
+      return splice_cut != 0 || splice_size != 0;
+    }
+
+    /**
+     * @brief Size of the datagram as sent
+     */
+    [[nodiscard]] size_t wire_size() const noexcept
+    {
+      return size - splice_cut + splice_size;
+    }
+
+    /**
+     * @brief Describe the datagram as sent for sendmsg()
+     *
+     * The iovecs point into data and into splice_bytes of this entry.
+     *
+     * @param iov Output, room for UDP_MAX_DATAGRAM_IOVECS entries
+     * @return Number of iovecs filled in
+     */
+    size_t to_iovecs(struct iovec* iov) const noexcept;
+  };
+
   /**
    * @brief RAII wrapper for UDP sockets
    * 
@@ -153,17 +370,26 @@ namespace project
    * socket.send_to(data, dest);
    * @endcode
    */
+  class PacketRing;
+
   class UdpSocket
   {
   private:
     SocketHandle socket_;
     Endpoint local_endpoint_;
+    bool nonblocking_ = false;  // EAGAIN is WouldBlock only then; otherwise it is a receive timeout
+    bool zerocopy_ = false;
+    uint32_t zerocopy_issued_ = 0;     // MSG_ZEROCOPY sends so far (the kernel numbers them the same way)
+    uint32_t zerocopy_completed_ = 0;  // Of those, how many the kernel has released
+    std::chrono::microseconds receive_timeout_{ 0 };
+    std::unique_ptr<PacketRing> packet_ring_;          // Takes over receive_batch() and send_batch() when set
+    std::vector<OutboundDatagram> ring_fallback_;      // Datagrams the ring could not send, for sendmmsg()
 
   public:
     /**
      * @brief Default constructor - creates an invalid socket
      */
-    UdpSocket() = default;
+    UdpSocket() noexcept;
 
     /**
      * @brief Create a UDP socket
@@ -171,15 +397,28 @@ namespace project
      */
     [[nodiscard]] static expected<UdpSocket, UdpError> create();
 
+    /**
+     * @brief Take ownership of an existing UDP socket, e.g. one inherited from another process
+     *
+     * The socket keeps its binding and options; local_endpoint() reports
+     * the address it is bound to. That includes the drop-all filter of a
+     * previous owner's packet ring, which may still be forwarding; see
+     * detach_socket_filter().
+     *
+     * @param socket The socket
+     * @return expected<UdpSocket, UdpError> The socket, or InvalidSocket if it is not a bound UDP socket
+     */
+    [[nodiscard]] static expected<UdpSocket, UdpError> adopt(SocketHandle socket);
+
     /**
      * @brief Move constructor
      */
-    UdpSocket(UdpSocket&& other) noexcept = default;
+    UdpSocket(UdpSocket&& other) noexcept;
 
     /**
      * @brief Move assignment operator
      */
-    UdpSocket& operator=(UdpSocket&& other) noexcept = default;
+    UdpSocket& operator=(UdpSocket&& other) noexcept;
 
     /**
      * @brief Deleted copy constructor
@@ -194,7 +433,7 @@ namespace project
     /**
      * @brief Destructor - closes the socket
      */
-    ~UdpSocket() = default;
+    ~UdpSocket();
 
     /**
      * @brief Bind the socket to a local address and port
@@ -205,6 +444,144 @@ namespace project
      */
     [[nodiscard]] expected<void, UdpError> bind(std::string_view address, uint16_t port);
 
+    /**
+     * @brief Allow several sockets to bind the same address and port (SO_REUSEPORT)
+     * 
+     * Must be set on every socket before bind(). The kernel then spreads
+     * incoming datagrams across the sockets by flow hash.
+     * 
+     * @param enable Whether to enable port sharing
+     * @return expected<void, UdpError> Success or error
+     */
+    [[nodiscard]] expected<void, UdpError> set_reuse_port(bool enable);
+
+    /**
+     * @brief Receive and send batches through a memory-mapped packet ring
+     *
+     * From then on receive_batch() reads the ring and send_batch() writes
+     * it, sending what the ring cannot with sendmmsg() as before; the
+     * socket itself stops queueing datagrams (a drop-all socket filter).
+     * Other receive calls therefore see nothing while a ring is attached.
+     *
+     * @param ring A ring created for this socket's local endpoint
+     * @return expected<void, UdpError> Success or error
+     */
+    [[nodiscard]] expected<void, UdpError> attach_packet_ring(PacketRing ring);
+
+    /**
+     * @brief Whether a packet ring is attached
+     */
+    [[nodiscard]] bool packet_ring_attached() const noexcept
+    {
+      return packet_ring_ != nullptr;
+    }
+
+    /**
+     * @brief Let the socket queue datagrams again after a previous owner's packet ring closed it
+     *
+     * Call it only once that owner has stopped reading its ring, or both
+     * would forward every datagram. Without a filter it does nothing.
+     *
+     * @return expected<void, UdpError> Success or error
+     */
+    [[nodiscard]] expected<void, UdpError> detach_socket_filter();
+
+    /**
+     * @brief Bound blocking receives by a timeout (SO_RCVTIMEO)
+     * 
+     * Receives that time out fail with UdpError::ReceiveFailed, which lets a
+     * receive loop periodically re-check a stop flag.
+     * 
+     * @param timeout Maximum time to block (zero blocks indefinitely)
+     * @return expected<void, UdpError> Success or error
+     */
+    [[nodiscard]] expected<void, UdpError> set_receive_timeout(std::chrono::microseconds timeout);
+
+    /**
+     * @brief Request a kernel receive buffer of the given size (SO_RCVBUF)
+     * 
+     * The kernel caps the request at net.core.rmem_max, so this is a hint for
+     * bursty receivers rather than a guarantee.
+     * 
+     * @param bytes Requested buffer size
+     * @return expected<void, UdpError> Success or error
+     */
+    [[nodiscard]] expected<void, UdpError> set_receive_buffer_size(size_t bytes);
+
+    /**
+     * @brief Switch the socket between blocking and non-blocking mode
+     * 
+     * In non-blocking mode, sends and receives that would wait fail with
+     * UdpError::WouldBlock instead, as an event loop needs.
+     * 
+     * @param enable true for non-blocking
+     * @return expected<void, UdpError> Success or error
+     */
+    [[nodiscard]] expected<void, UdpError> set_nonblocking(bool enable);
+
+    /**
+     * @brief Let the kernel coalesce consecutive datagrams from one sender (UDP_GRO)
+     * 
+     * A coalesced receive is a run of datagrams of the same size (the last
+     * may be shorter), reported by the receive_from() overload that returns
+     * the segment size. Needs Linux 5.0.
+     * 
+     * @param enable true to coalesce
+     * @return expected<void, UdpError> Success or error
+     */
+    [[nodiscard]] expected<void, UdpError> set_gro(bool enable);
+
+    /**
+     * @brief Send large datagrams without copying the payload (SO_ZEROCOPY)
+     * 
+     * Once enabled, send_to_many() passes MSG_ZEROCOPY for datagrams of at
+     * least UDP_ZEROCOPY_MIN_SIZE bytes. The kernel then reads the payload
+     * straight from the caller's pages after the call returns, so the buffer
+     * must not be changed until reap_zerocopy() reports nothing pending.
+     * Needs Linux 5.0.
+     * 
+     * @param enable true to allow zero-copy sends
+     * @return expected<void, UdpError> Success or error
+     */
+    [[nodiscard]] expected<void, UdpError> set_zerocopy(bool enable);
+
+    /**
+     * @brief Whether set_zerocopy() is on
+     */
+    [[nodiscard]] bool zerocopy_enabled() const noexcept
+    {
+      return zerocopy_;
+    }
+
+    /**
+     * @brief Number of zero-copy sends whose buffers the kernel still holds
+     */
+    [[nodiscard]] size_t zerocopy_pending() const noexcept
+    {
+      return zerocopy_issued_ - zerocopy_completed_;
+    }
+
+    /**
+     * @brief Collect zero-copy completions from the socket error queue
+     * 
+     * Waits up to timeout for the kernel to release every pending buffer;
+     * a zero timeout only takes what has already arrived.
+     * 
+     * @param timeout Maximum time to wait
+     * @return expected<size_t, UdpError> Sends still pending afterwards, or error
+     */
+    [[nodiscard]] expected<size_t, UdpError> reap_zerocopy(std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Query the address the kernel actually bound (getsockname)
+     * 
+     * Unlike local_endpoint(), this reports the assigned port after
+     * binding to port 0.
+     * 
+     * @return expected<Endpoint, UdpError> The bound endpoint or error
+     */
+    [[nodiscard]] expected<Endpoint, UdpError> bound_endpoint() const;
+
     /**
      * @brief Send data to a remote endpoint
      * 
@@ -224,6 +601,23 @@ namespace project
      */
     [[nodiscard]] expected<size_t, UdpError> send_to(const uint8_t* data, size_t size, const Endpoint& endpoint);
 
+    /**
+     * @brief Send a buffer of back-to-back datagrams with segmentation offload (UDP_SEGMENT)
+     * 
+     * Every segment_size bytes of data become one datagram (the last may be
+     * shorter), but the stack is traversed once per UDP_GSO_MAX_SEGMENTS
+     * datagrams instead of once each. Where the kernel or route refuses GSO,
+     * the datagrams are sent one by one.
+     * 
+     * @param data The datagrams, back to back
+     * @param size Total size
+     * @param segment_size Size of every datagram but the last
+     * @param endpoint The destination endpoint
+     * @return expected<size_t, UdpError> Number of bytes sent or error
+     */
+    [[nodiscard]] expected<size_t, UdpError> send_segments(const uint8_t* data, size_t size, size_t segment_size,
+                                                           const Endpoint& endpoint);
+
     /**
      * @brief Receive data from any remote endpoint
      * 
@@ -241,6 +635,99 @@ namespace project
      */
     [[nodiscard]] expected<std::pair<std::vector<uint8_t>, Endpoint>, UdpError> receive_from(size_t max_size);
 
+    /**
+     * @brief Receive a datagram into a caller-provided pooled buffer
+     * 
+     * Fills the buffer up to its capacity and sets its size; no memory is
+     * allocated.
+     * 
+     * @param buffer The buffer to fill (must be valid)
+     * @return expected<Endpoint, UdpError> Sender endpoint or error
+     */
+    [[nodiscard]] expected<Endpoint, UdpError> receive_from(FrameBuffer& buffer);
+
+    /**
+     * @brief Receive one datagram, or a run of them coalesced by UDP_GRO
+     * 
+     * @param buffer The buffer to fill (must be valid)
+     * @param segment_size Set to the size of each coalesced datagram, or to
+     *        the buffer's size when nothing was coalesced
+     * @return expected<Endpoint, UdpError> Sender endpoint or error
+     */
+    [[nodiscard]] expected<Endpoint, UdpError> receive_from(FrameBuffer& buffer, size_t& segment_size);
+
+    /**
+     * @brief Receive a burst of datagrams with as few syscalls as possible
+     *
+     * Blocks until at least one datagram is available, then returns every
+     * datagram that is already queued, up to count (uses recvmmsg on Linux).
+     * A non-blocking socket with nothing queued fails with UdpError::WouldBlock.
+     * Datagrams larger than a slot's capacity are truncated and flagged.
+     *
+     * @param datagrams Array of caller-owned receive slots
+     * @param count Number of slots in the array
+     * @return expected<size_t, UdpError> Number of slots filled or error
+     */
+    [[nodiscard]] expected<size_t, UdpError> receive_batch(InboundDatagram* datagrams, size_t count);
+
+    /**
+     * @brief Receive a burst of datagrams into every slot of a vector
+     *
+     * @param datagrams The receive slots (the vector is not resized)
+     * @return expected<size_t, UdpError> Number of slots filled or error
+     */
+    [[nodiscard]] expected<size_t, UdpError> receive_batch(std::vector<InboundDatagram>& datagrams);
+
+    /**
+     * @brief Send a burst of datagrams with as few syscalls as possible
+     *
+     * Uses sendmmsg on Linux. Datagrams with an invalid destination, or that
+     * the kernel rejects, are skipped so that one bad destination does not
+     * hold back the rest of the burst.
+     *
+     * @param datagrams Array of datagrams to send
+     * @param count Number of datagrams in the array
+     * @return expected<size_t, UdpError> Number of datagrams sent or error
+     */
+    [[nodiscard]] expected<size_t, UdpError> send_batch(const OutboundDatagram* datagrams, size_t count);
+
+    /**
+     * @brief Send every datagram in a vector
+     *
+     * @param datagrams The datagrams to send
+     * @return expected<size_t, UdpError> Number of datagrams sent or error
+     */
+    [[nodiscard]] expected<size_t, UdpError> send_batch(const std::vector<OutboundDatagram>& datagrams);
+
+    /**
+     * @brief Send one datagram to many destinations with as few syscalls as possible
+     *
+     * Every message of the sendmmsg call points at the same iovec, so a
+     * flood to K endpoints is one syscall per UDP_MAX_BATCH_SIZE of them.
+     * With set_zerocopy() on and a datagram of at least UDP_ZEROCOPY_MIN_SIZE
+     * bytes, the payload is not copied (see reap_zerocopy()). Invalid or
+     * rejected destinations are skipped, as in send_batch().
+     *
+     * @param data The datagram
+     * @param size Size of the datagram
+     * @param destinations Array of destinations
+     * @param count Number of destinations
+     * @return expected<size_t, UdpError> Number of destinations sent to or error
+     */
+    [[nodiscard]] expected<size_t, UdpError> send_to_many(const uint8_t* data, size_t size,
+                                                          const Endpoint* destinations, size_t count);
+
+    /**
+     * @brief Send one datagram to every endpoint in a vector
+     *
+     * @param data The datagram
+     * @param size Size of the datagram
+     * @param destinations The destinations
+     * @return expected<size_t, UdpError> Number of destinations sent to or error
+     */
+    [[nodiscard]] expected<size_t, UdpError> send_to_many(const uint8_t* data, size_t size,
+                                                          const std::vector<Endpoint>& destinations);
+
     /**
      * @brief Check if the socket is valid
      * @return true if the socket is valid and open
@@ -271,11 +758,7 @@ namespace project
     /**
      * @brief Close the socket
      */
-    void close() noexcept
-    {
-      socket_.close();
-      local_endpoint_ = Endpoint{};
-    }
+    void close() noexcept;
 
     /**
      * @brief Explicit conversion to bool for validity checking
@@ -289,12 +772,28 @@ namespace project
     /**
      * @brief Private constructor for create()
      */
-    explicit UdpSocket(SocketHandle socket) : socket_(std::move(socket))
-    {
-    }
+    explicit UdpSocket(SocketHandle socket) noexcept;
+
+    /**
+     * @brief send_batch() with sendmmsg(), bypassing any packet ring
+     */
+    size_t send_batch_syscalls(const OutboundDatagram* datagrams, size_t count);
   };
 
 }  // namespace project
 
+// Hash function for Endpoint (to use in unordered containers)
+namespace std
+{
+  template<>
+  struct hash<project::Endpoint>
+  {
+    size_t operator()(const project::Endpoint& endpoint) const noexcept
+    {
+      return endpoint.hash();
+    }
+  };
+}  // namespace std
+
 #endif  // PROJECT_UDP_SOCKET_HPP_
 
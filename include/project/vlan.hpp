@@ -0,0 +1,245 @@
+/**
+ * @file vlan.hpp
+ * @brief 802.1Q port membership for a VLAN-aware VSwitch
+ *
+ * Each VPort endpoint is either an access port, carrying one VLAN untagged,
+ * or a trunk, carrying a set of VLANs tagged plus optionally one native
+ * VLAN untagged. A VlanMap resolves the sender of a frame to its port, so
+ * the switch can tell which VLAN the frame belongs to on the way in and
+ * whether a copy must carry a tag on the way out.
+ */
+
+#ifndef PROJECT_VLAN_HPP_
+#define PROJECT_VLAN_HPP_
+
+#include "project/expected.hpp"
+#include "project/udp_socket.hpp"
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace project
+{
+  /**
+   * @brief The VLAN of ports that are not configured
+   */
+  constexpr uint16_t VLAN_DEFAULT_ID = 1;
+
+  /**
+   * @brief Highest usable VLAN ID (4095 is reserved)
+   */
+  constexpr uint16_t VLAN_MAX_ID = 4094;
+
+  /**
+   * @brief The VLAN ID bits of a tag control information (TCI) field
+   */
+  constexpr uint16_t VLAN_VID_MASK = 0x0fff;
+
+  /**
+   * @brief Whether a port carries one VLAN untagged or several tagged
+   */
+  enum class VlanMode
+  {
+    Access,
+    Trunk
+  };
+
+  /**
+   * @brief Error codes for VLAN configuration
+   */
+  enum class VlanError
+  {
+    InvalidSpec,
+    InvalidAddress,
+    InvalidVlanId,
+    DuplicatePort
+  };
+
+  /**
+   * @brief Convert VlanError to string representation
+   * @param error The error code
+   * @return String description of the error
+   */
+  [[nodiscard]] const char* to_string(VlanError error) noexcept;
+
+  /**
+   * @brief Configuration of one switch port
+   *
+   * A port is identified by the VPort's UDP endpoint. VPorts send from an
+   * ephemeral port, so an endpoint with port 0 matches every port at its
+   * address; an exact endpoint takes precedence.
+   */
+  struct VlanPortConfig
+  {
+    Endpoint endpoint;
+    VlanMode mode = VlanMode::Access;
+
+    /**
+     * @brief Access: the port's VLAN. Trunk: the native VLAN for untagged frames, 0 for none
+     */
+    uint16_t vlan = VLAN_DEFAULT_ID;
+
+    /**
+     * @brief Trunk: the VLANs carried tagged (empty carries all of them)
+     */
+    std::vector<uint16_t> allowed;
+  };
+
+  /**
+   * @brief Parse a VLAN ID in [1, VLAN_MAX_ID]
+   */
+  [[nodiscard]] expected<uint16_t, VlanError> parse_vlan_id(std::string_view text);
+
+  /**
+   * @brief Parse a port specification from the command line
+   *
+   * Access: "ADDRESS[:PORT]=VLAN". Trunk: "ADDRESS[:PORT]=VLANS[/NATIVE]",
+   * where VLANS is "all" or a comma-separated list of IDs and ranges
+   * ("10,20-29"). IPv6 addresses with a port are written in brackets.
+   *
+   * @param mode Whether the port is an access port or a trunk
+   * @param spec The specification
+   * @return expected<VlanPortConfig, VlanError> The port or an error
+   */
+  [[nodiscard]] expected<VlanPortConfig, VlanError> parse_vlan_port(VlanMode mode, std::string_view spec);
+
+  /**
+   * @brief The resolved VLAN membership of one port
+   */
+  class VlanPort
+  {
+  private:
+    VlanMode mode_ = VlanMode::Access;
+    uint16_t untagged_ = VLAN_DEFAULT_ID;    // Access VLAN, or native VLAN of a trunk (0 for none)
+    std::bitset<VLAN_VID_MASK + 1> tagged_;  // VLANs a trunk carries tagged
+
+  public:
+    /**
+     * @brief An access port in the default VLAN
+     */
+    VlanPort() = default;
+
+    /**
+     * @brief An access port
+     */
+    [[nodiscard]] static VlanPort access(uint16_t vlan) noexcept;
+
+    /**
+     * @brief A trunk port
+     * @param native VLAN of untagged frames (0 drops them)
+     * @param allowed VLANs carried tagged (empty carries all of them)
+     */
+    [[nodiscard]] static VlanPort trunk(uint16_t native, const std::vector<uint16_t>& allowed) noexcept;
+
+    /**
+     * @brief The port mode
+     */
+    [[nodiscard]] VlanMode mode() const noexcept
+    {
+      return mode_;
+    }
+
+    /**
+     * @brief Classify a frame received on this port
+     *
+     * Untagged and priority-tagged frames (VID 0) belong to the access or
+     * native VLAN; tagged frames (802.1Q, or the outer tag of 802.1ad) to
+     * the VLAN in their tag. A frame in a VLAN the port does not carry, or
+     * whose tag is cut short, is not accepted.
+     *
+     * @param frame The Ethernet frame
+     * @param size Size of the frame (at least an Ethernet header)
+     * @return The frame's VLAN, or 0 to drop it
+     */
+    [[nodiscard]] uint16_t ingress_vlan(const uint8_t* frame, size_t size) const noexcept;
+
+    /**
+     * @brief Whether the port carries a VLAN
+     */
+    [[nodiscard]] bool member(uint16_t vlan) const noexcept
+    {
+      return vlan == untagged_ || (mode_ == VlanMode::Trunk && tagged_.test(vlan & VLAN_VID_MASK));
+    }
+
+    /**
+     * @brief Whether frames of a VLAN leave this port tagged
+     */
+    [[nodiscard]] bool egress_tagged(uint16_t vlan) const noexcept
+    {
+      return mode_ == VlanMode::Trunk && vlan != untagged_;
+    }
+  };
+
+  /**
+   * @brief Endpoint → port lookup for the whole switch
+   *
+   * Empty (the default) means the switch is not VLAN-aware: frames are
+   * forwarded with their tags untouched and all share one MAC table.
+   */
+  class VlanMap
+  {
+  private:
+    std::vector<VlanPort> ports_;
+    std::unordered_map<Endpoint, size_t> exact_;       // Index into ports_
+    std::unordered_map<Endpoint, size_t> by_address_;  // Keyed by the endpoint with port 0
+    VlanPort default_port_;
+
+  public:
+    /**
+     * @brief A map with no ports configured (VLAN-unaware)
+     */
+    VlanMap() = default;
+
+    /**
+     * @brief Resolve a port configuration
+     *
+     * @param ports The configured ports
+     * @param default_vlan Access VLAN of every other endpoint
+     * @return expected<VlanMap, VlanError> The map, or an error for an invalid ID or a port configured twice
+     */
+    [[nodiscard]] static expected<VlanMap, VlanError> create(const std::vector<VlanPortConfig>& ports,
+                                                             uint16_t default_vlan = VLAN_DEFAULT_ID);
+
+    /**
+     * @brief Whether any port is configured, making the switch VLAN-aware
+     */
+    [[nodiscard]] bool enabled() const noexcept
+    {
+      return !ports_.empty();
+    }
+
+    /**
+     * @brief Number of configured ports
+     */
+    [[nodiscard]] size_t size() const noexcept
+    {
+      return ports_.size();
+    }
+
+    /**
+     * @brief The port of an endpoint: exact match, then by address, then an access port in the default VLAN
+     */
+    [[nodiscard]] const VlanPort& port(const Endpoint& endpoint) const noexcept;
+  };
+
+  /**
+   * @brief Make an outgoing copy leave with or without a tag for its VLAN
+   *
+   * Edits the copy with a splice, so the frame shared by every copy of a
+   * flood stays untouched: an untagged frame gets a tag pushed (priority
+   * 0), a tagged one has its tag popped or its VID rewritten (keeping the
+   * priority bits). datagram.data must be a frame ingress_vlan() accepted.
+   *
+   * @param datagram The copy, with data and size set
+   * @param vlan The frame's VLAN
+   * @param tagged Whether the egress port wants it tagged
+   */
+  void set_vlan_egress(OutboundDatagram& datagram, uint16_t vlan, bool tagged) noexcept;
+
+}  // namespace project
+
+#endif  // PROJECT_VLAN_HPP_
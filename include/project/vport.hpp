@@ -3,23 +3,38 @@
  * @brief Virtual Port for connecting TAP devices to VSwitch
  * 
  * VPort creates a virtual port that bridges a TAP device (connected to the
- * kernel's network stack) with a VSwitch via UDP. It runs two forwarder threads:
- * - TAP → VSwitch: Reads Ethernet frames from TAP, sends via UDP
- * - VSwitch → TAP: Receives frames via UDP, writes to TAP
+ * kernel's network stack) with a VSwitch via UDP, in one of three modes:
+ * - start(): two blocking forwarder threads, TAP → VSwitch and VSwitch → TAP
+ * - start(IoBackend::IoUring): one thread driving an io_uring, with a read
+ *   posted on the TAP device, a multishot receive on the socket and
+ *   asynchronous sends and writes
+ * - attach(): non-blocking handlers on an EventLoop, which can host many
+ *   VPorts on a single thread
  */
 
 #ifndef PROJECT_VPORT_HPP_
 #define PROJECT_VPORT_HPP_
 
+#include "project/cluster.hpp"
 #include "project/ethernet_frame.hpp"
+#include "project/event_loop.hpp"
 #include "project/expected.hpp"
+#include "project/frame_coalescing.hpp"
+#include "project/frame_pool.hpp"
+#include "project/io_uring.hpp"
 #include "project/joining_thread.hpp"
+#include "project/latency_histogram.hpp"
 #include "project/tap_device.hpp"
+#include "project/traffic_stats.hpp"
+#include "project/tunnel_crypto.hpp"
 #include "project/udp_socket.hpp"
 
 #include <atomic>
+#include <chrono>
+#include <memory>
 #include <string>
 #include <string_view>
+#include <vector>
 
 namespace project
 {
@@ -32,7 +47,10 @@ namespace project
     SocketCreationFailed,
     InvalidVSwitchEndpoint,
     AlreadyRunning,
-    NotRunning
+    NotRunning,
+    EventLoopFailed,
+    EncryptionFailed,
+    CoalescingFailed
   };
 
   /**
@@ -42,6 +60,16 @@ namespace project
    */
   [[nodiscard]] const char* to_string(VPortError error) noexcept;
 
+  /**
+   * @brief Most frames an attached VPort moves per direction before yielding to other descriptors
+   */
+  constexpr size_t VPORT_EVENT_BUDGET = 64;
+
+  /**
+   * @brief How often the io_uring forwarder wakes up without traffic to check for stop()
+   */
+  constexpr std::chrono::milliseconds VPORT_STOP_POLL_INTERVAL{ 100 };
+
   /**
    * @brief Virtual Port that connects a TAP device to a VSwitch
    * 
@@ -73,6 +101,47 @@ namespace project
     Endpoint vswitch_endpoint_;
     std::string device_name_;
 
+    // One slot per direction; each forwarder reuses its slot for every frame. With
+    // offloads the slots hold super-frames, and a third takes the segments of one
+    std::unique_ptr<FramePool> frame_pool_;
+    FrameBuffer segment_buffer_;
+
+    // The slots of an attached VPort, held between events
+    FrameBuffer tap_buffer_;
+    FrameBuffer switch_buffer_;
+    EventLoop* event_loop_ = nullptr;
+
+    // Ring and buffers of the io_uring mode, owned by its thread while it runs
+    struct UringState;
+    std::unique_ptr<UringState> uring_;
+
+    // Tunnel key and a context per direction, unset without encryption
+    std::unique_ptr<TunnelKeyring> tunnel_;
+    uint32_t tunnel_key_id_ = TUNNEL_NO_KEY;
+    TunnelContext tunnel_seal_;
+    TunnelContext tunnel_open_;
+
+    // Small frames waiting to go to the VSwitch together, behind room for the tunnel header;
+    // the delay is 0 without coalescing
+    std::chrono::microseconds coalesce_delay_{ 0 };
+    std::vector<uint8_t> coalesce_buffer_;
+    FrameCoalescer coalescer_;
+    std::chrono::steady_clock::time_point coalesce_deadline_;
+#if PROJECT_LATENCY_HISTOGRAMS
+    uint64_t coalesce_ticks_ = 0;
+#endif
+
+    // The VSwitch nodes to move between when the active one falls silent, unset without standbys
+    std::unique_ptr<VSwitchFailover> failover_;
+
+    // Each written only by its forwarder thread
+    TrafficCounters tap_to_switch_counters_;
+    TrafficCounters switch_to_tap_counters_;
+#if PROJECT_LATENCY_HISTOGRAMS
+    LatencyHistogram tap_to_switch_latency_;
+    LatencyHistogram switch_to_tap_latency_;
+#endif
+
     std::atomic<bool> running_;
     joining_thread tap_to_switch_thread_;
     joining_thread switch_to_tap_thread_;
@@ -88,13 +157,44 @@ namespace project
      * 
      * Creates a TAP device and UDP socket, ready to start forwarding.
      * 
+     * With offloads, the TAP device hands over TCP super-frames of up to
+     * 64 KiB, which are cut into MSS-sized frames only here, right before
+     * they leave as one UDP GSO send. The socket has UDP_GRO on, so a run of
+     * frames arriving together is received at once and written to the TAP
+     * device frame by frame. The io_uring backend does not support offloads
+     * and falls back to the forwarder threads.
+     * 
      * @param device_name TAP device name (e.g., "tap0")
      * @param vswitch_address VSwitch IP address
      * @param vswitch_port VSwitch port number
+     * @param offloads Enable TAP checksum/segmentation offload and UDP GSO/GRO
      * @return expected<VPort, VPortError> The created VPort or an error
      */
     [[nodiscard]] static expected<VPort, VPortError> create(std::string_view device_name,
-                                                             std::string_view vswitch_address, uint16_t vswitch_port);
+                                                             std::string_view vswitch_address, uint16_t vswitch_port,
+                                                             bool offloads = false);
+
+    /**
+     * @brief Create one VPort per queue of a multi-queue TAP device
+     * 
+     * Every VPort owns one queue and its own UDP socket, so each is a
+     * complete pipeline that can be started or attached on a different core.
+     * The kernel spreads the device's flows across the queues; the VSwitch
+     * sees each socket as a separate port and learns a MAC behind whichever
+     * queue carried its latest frame.
+     * 
+     * @param device_name TAP device name (e.g., "tap0"), or empty for auto-assignment
+     * @param vswitch_address VSwitch IP address
+     * @param vswitch_port VSwitch port number
+     * @param queues Number of queues, 1 to TAP_MAX_QUEUES
+     * @param offloads Enable offloads on every queue, as for create()
+     * @return expected<std::vector<VPort>, VPortError> One VPort per queue, or an error
+     */
+    [[nodiscard]] static expected<std::vector<VPort>, VPortError> create_multi_queue(std::string_view device_name,
+                                                                                    std::string_view vswitch_address,
+                                                                                    uint16_t vswitch_port,
+                                                                                    size_t queues,
+                                                                                    bool offloads = false);
 
     /**
      * @brief Move constructor
@@ -124,24 +224,120 @@ namespace project
     /**
      * @brief Start the forwarder threads
      * 
-     * Spawns two threads:
+     * With IoBackend::Syscalls, spawns two threads:
      * - TAP → VSwitch forwarder
      * - VSwitch → TAP forwarder
      * 
+     * With IoBackend::IoUring, spawns a single thread that keeps a read
+     * posted on the TAP device and a multishot receive on the socket, both
+     * into registered buffers the kernel picks, and forwards each frame as an
+     * asynchronous send or write. If the ring cannot be set up, logs a
+     * warning and starts the two threads instead.
+     * 
+     * @param backend How frames are moved
+     * @return expected<void, VPortError> Success or error
+     */
+    [[nodiscard]] expected<void, VPortError> start(IoBackend backend = IoBackend::Syscalls);
+
+    /**
+     * @brief Seal every frame to the VSwitch with a key, and accept only frames sealed with it
+     * 
+     * The VSwitch must hold the same key under the same id (see
+     * tunnel_crypto.hpp). Frames then carry TUNNEL_OVERHEAD more bytes;
+     * datagrams that fail to open are dropped and counted in the
+     * crypto_drops of switch_to_tap_stats(). Not available with TAP
+     * offloads, and start() uses forwarder threads instead of io_uring.
+     * 
+     * @param cipher The AEAD both ends use
+     * @param key The key of this VPort's socket
+     * @return expected<void, VPortError> Success, AlreadyRunning or EncryptionFailed
+     */
+    [[nodiscard]] expected<void, VPortError> enable_encryption(TunnelCipher cipher, const TunnelKey& key);
+
+    /**
+     * @brief Check whether frames are encrypted
+     */
+    [[nodiscard]] bool encryption_enabled() const noexcept
+    {
+      return tunnel_ != nullptr;
+    }
+
+    /**
+     * @brief Send frames of up to COALESCE_MAX_FRAME_SIZE bytes to the VSwitch in aggregates
+     * 
+     * A small frame waits up to delay for others to share its datagram
+     * (see frame_coalescing.hpp); a larger one sends whatever is waiting
+     * ahead of it, so frames stay in order. Attached to an event loop,
+     * frames wait only until the TAP device has no more to read. Not
+     * available with TAP offloads, and start() uses forwarder threads
+     * instead of io_uring.
+     * 
+     * @param delay Longest a frame waits, 0 to send every frame alone
+     * @return expected<void, VPortError> Success, AlreadyRunning or CoalescingFailed
+     */
+    [[nodiscard]] expected<void, VPortError> enable_coalescing(std::chrono::microseconds delay);
+
+    /**
+     * @brief Move to a standby VSwitch when the active one has been silent for a while
+     *
+     * The VSwitch given to create() comes first, then each standby in
+     * turn, round and round (see VSwitchFailover). Meant for the nodes of
+     * one cluster (VSwitchConfig::cluster_peers), where any node reaches
+     * every station. A VPort that only sends and never hears back moves
+     * too, which costs nothing beyond the MAC updates that follow. start()
+     * uses forwarder threads instead of io_uring.
+     *
+     * @param standby The other VSwitch nodes (empty: stay with the first)
+     * @param timeout Silence after which the next node takes over
+     * @return expected<void, VPortError> Success, AlreadyRunning or InvalidVSwitchEndpoint
+     */
+    [[nodiscard]] expected<void, VPortError>
+    enable_failover(std::vector<Endpoint> standby, std::chrono::milliseconds timeout = FAILOVER_DEFAULT_TIMEOUT);
+
+    /**
+     * @brief Check whether small frames are coalesced
+     */
+    [[nodiscard]] bool coalescing_enabled() const noexcept
+    {
+      return coalesce_delay_.count() > 0;
+    }
+
+    /**
+     * @brief Check whether the VPort fails over to standby VSwitch nodes
+     */
+    [[nodiscard]] bool failover_enabled() const noexcept
+    {
+      return failover_ != nullptr;
+    }
+
+    /**
+     * @brief Forward frames from handlers on an event loop instead of threads
+     * 
+     * Puts the TAP device and socket in non-blocking mode and watches both on
+     * the loop; frames are then forwarded by whichever thread runs it. Each
+     * handler moves at most VPORT_EVENT_BUDGET frames per wake-up, so many
+     * VPorts can share one loop fairly.
+     * 
+     * Call from the loop thread or while the loop is not running. Neither the
+     * VPort nor the loop may be moved while attached.
+     * 
+     * @param loop The loop to forward on
      * @return expected<void, VPortError> Success or error
      */
-    [[nodiscard]] expected<void, VPortError> start();
+    [[nodiscard]] expected<void, VPortError> attach(EventLoop& loop);
 
     /**
-     * @brief Stop the forwarder threads
+     * @brief Stop forwarding
      * 
-     * Signals threads to stop and waits for them to complete.
+     * With threads, signals them to stop and waits for them to complete. When
+     * attached, removes the handlers from the loop (from the loop thread or
+     * while the loop is not running) and restores blocking mode.
      */
     void stop() noexcept;
 
     /**
      * @brief Check if the VPort is running
-     * @return true if forwarder threads are running
+     * @return true if forwarder threads are running or the VPort is attached
      */
     [[nodiscard]] bool is_running() const noexcept
     {
@@ -159,13 +355,56 @@ namespace project
 
     /**
      * @brief Get the VSwitch endpoint
-     * @return The VSwitch endpoint
+     * @return The VSwitch endpoint frames are sent to (with failover, the active node)
      */
     [[nodiscard]] const Endpoint& vswitch_endpoint() const noexcept
     {
       return vswitch_endpoint_;
     }
 
+    /**
+     * @brief Get the counters of the TAP → VSwitch direction
+     *
+     * rx counts frames read from the TAP device, tx datagrams sent to the VSwitch.
+     */
+    [[nodiscard]] TrafficStats tap_to_switch_stats() const noexcept
+    {
+      return tap_to_switch_counters_.snapshot();
+    }
+
+    /**
+     * @brief Get the counters of the VSwitch → TAP direction
+     *
+     * rx counts datagrams received from the VSwitch, tx frames written to the TAP device.
+     */
+    [[nodiscard]] TrafficStats switch_to_tap_stats() const noexcept
+    {
+      return switch_to_tap_counters_.snapshot();
+    }
+
+    /**
+     * @brief Get the TAP read to UDP send latency
+     *
+     * Empty unless built with PROJECT_LATENCY_HISTOGRAMS.
+     */
+    [[nodiscard]] LatencySnapshot tap_to_switch_latency() const;
+
+    /**
+     * @brief Get the UDP receive to TAP write latency
+     *
+     * Empty unless built with PROJECT_LATENCY_HISTOGRAMS.
+     */
+    [[nodiscard]] LatencySnapshot switch_to_tap_latency() const;
+
+    /**
+     * @brief Render the counters of both directions as Prometheus text
+     *
+     * Series are labelled with device="<name>" and direction="tap_to_switch"
+     * or direction="switch_to_tap". With PROJECT_LATENCY_HISTOGRAMS, latency
+     * summaries with the same labels follow.
+     */
+    [[nodiscard]] std::string stats_prometheus() const;
+
   private:
     /**
      * @brief Forward frames from TAP device to VSwitch
@@ -184,11 +423,74 @@ namespace project
     void forward_switch_to_tap();
 
     /**
-     * @brief Log an Ethernet frame
+     * @brief Forward both directions through the io_uring in uring_, until stop()
+     */
+    void forward_uring();
+
+    /**
+     * @brief Read one frame from the TAP device and send it to the VSwitch
+     * @param buffer The direction's buffer
+     * @return false if no frame could be read (none pending, or a read error)
+     */
+    bool relay_tap_to_switch(FrameBuffer& buffer);
+
+    /**
+     * @brief Seal (with encryption) and send a frame or an aggregate to the VSwitch
+     * 
+     * With encryption the frame is sealed in place: TUNNEL_HEADER_SIZE bytes
+     * in front of it and TUNNEL_TAG_SIZE behind it must be writable.
+     * 
+     * @param frames Number of frames it carries, for the counters
+     * @return true if it was sent
+     */
+    bool send_to_switch(uint8_t* frame, size_t size, size_t frames);
+
+    /**
+     * @brief Point the coalescer at its buffer, leaving room for the tunnel if encrypting
+     */
+    void reset_coalescer();
+
+    /**
+     * @brief Add a small frame to the waiting aggregate, sending it first if the frame does not fit
+     */
+    void coalesce(const uint8_t* frame, size_t size);
+
+    /**
+     * @brief Send the waiting aggregate, if any (a lone frame goes as itself)
+     */
+    void flush_coalesced();
+
+    /**
+     * @brief Wait for the TAP device to become readable, until a deadline
+     * @return false on timeout (or if the deadline has passed)
+     */
+    bool tap_readable_before(std::chrono::steady_clock::time_point deadline) const;
+
+    /**
+     * @brief Receive one frame from the VSwitch and write it to the TAP device
+     * @param buffer The direction's buffer
+     * @return false if no frame could be received (none pending, or a receive error)
+     */
+    bool relay_switch_to_tap(FrameBuffer& buffer);
+
+    /**
+     * @brief Cut a read super-frame into frames, or finish its checksum, and send the result
+     * @return Number of frames sent, 0 if the frame was dropped
+     */
+    size_t send_offloaded(FrameBuffer& buffer, const VnetHeader& header);
+
+    /**
+     * @brief Remove the handlers of an attached VPort and restore blocking mode
+     */
+    void detach() noexcept;
+
+    /**
+     * @brief Trace-log an Ethernet frame (a no-op unless Trace is compiled in and enabled)
      * @param direction Description of the direction (e.g., "Sent to VSwitch")
-     * @param frame The Ethernet frame to log
+     * @param data The frame to log
+     * @param size Size of the frame in bytes
      */
-    void log_frame(std::string_view direction, const EthernetFrame& frame) const;
+    void log_frame(const char* direction, const uint8_t* data, size_t size) const;
   };
 
 }  // namespace project
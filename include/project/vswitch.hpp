@@ -6,17 +6,46 @@
  * - Learns MAC addresses from incoming frames
  * - Forwards frames based on MAC address table
  * - Handles unicast and broadcast frames
+ * - Optionally keeps VLANs apart (802.1Q access and trunk ports)
+ * - Snoops IGMP/MLD to send multicast only to subscribed ports
+ * - Optionally polices each port's ingress rate and sends by priority
+ * - Optionally restarts warm from a snapshot of its MAC table
+ * - Hands its sockets and MAC table to a successor process for live upgrades
+ * - Optionally forms one logical switch with peer nodes, sharing MAC learning
  */
 
 #ifndef PROJECT_VSWITCH_HPP_
 #define PROJECT_VSWITCH_HPP_
 
+#include "project/cluster.hpp"
 #include "project/ethernet_frame.hpp"
-#include "project/mac_table.hpp"
+#include "project/flow_cache.hpp"
+#include "project/frame_classifier.hpp"
+#include "project/frame_coalescing.hpp"
+#include "project/frame_pool.hpp"
+#include "project/io_uring.hpp"
+#include "project/joining_thread.hpp"
+#include "project/latency_histogram.hpp"
+#include "project/mac_snapshot.hpp"
+#include "project/mac_aging.hpp"
+#include "project/concurrent_mac_table.hpp"
+#include "project/multicast_snooping.hpp"
+#include "project/qos.hpp"
+#include "project/socket_handoff.hpp"
+#include "project/traffic_stats.hpp"
+#include "project/tunnel_crypto.hpp"
 #include "project/udp_socket.hpp"
+#include "project/vlan.hpp"
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 namespace project
 {
@@ -28,7 +57,11 @@ namespace project
     SocketCreationFailed,
     BindFailed,
     AlreadyRunning,
-    NotRunning
+    NotRunning,
+    InvalidVlanConfig,
+    HandoffFailed,
+    EncryptionFailed,
+    InvalidClusterConfig
   };
 
   /**
@@ -38,6 +71,246 @@ namespace project
    */
   [[nodiscard]] const char* to_string(VSwitchError error) noexcept;
 
+  /**
+   * @brief What the switch does with a frame it has no specific destination for
+   */
+  enum class FloodPolicy
+  {
+    Drop,
+    Flood  ///< Copy to every port in the frame's VLAN but the one it came from
+  };
+
+  /**
+   * @brief Convert FloodPolicy to string representation
+   * @param policy The policy
+   * @return Lower-case name ("drop" or "flood")
+   */
+  [[nodiscard]] const char* to_string(FloodPolicy policy) noexcept;
+
+  /**
+   * @brief Parse a flood policy name as printed by to_string()
+   * @param name "drop" or "flood"
+   * @return The policy, or nullopt for an unknown name
+   */
+  [[nodiscard]] std::optional<FloodPolicy> parse_flood_policy(std::string_view name) noexcept;
+
+  /**
+   * @brief Default number of datagrams the VSwitch moves per receive/send syscall
+   */
+  constexpr size_t VSWITCH_DEFAULT_BATCH_SIZE = 32;
+
+  /**
+   * @brief How often a blocked worker wakes up to check for stop()
+   */
+  constexpr std::chrono::milliseconds VSWITCH_STOP_POLL_INTERVAL{ 100 };
+
+  /**
+   * @brief Largest frame a VSwitch can be configured to forward (a maximal UDP payload)
+   */
+  constexpr size_t VSWITCH_MAX_FRAME_SIZE = 65507;
+
+  /**
+   * @brief Default burst an ingress-policed port may send at once (bytes)
+   */
+  constexpr uint64_t VSWITCH_DEFAULT_INGRESS_BURST = 64 * 1024;
+
+  /**
+   * @brief Configuration for a VSwitch instance
+   */
+  struct VSwitchConfig
+  {
+    /**
+     * @brief UDP port to bind to (0 for ephemeral)
+     */
+    uint16_t port = 0;
+
+    /**
+     * @brief Maximum number of frames received, processed and flushed as one burst
+     *
+     * Clamped to [1, UDP_MAX_BATCH_SIZE]; 1 processes frames one at a time.
+     */
+    size_t batch_size = VSWITCH_DEFAULT_BATCH_SIZE;
+
+    /**
+     * @brief Number of forwarding threads
+     *
+     * Each worker owns a socket bound to the same port with SO_REUSEPORT,
+     * so the kernel shards incoming flows across them; all workers share
+     * one lock-free MAC table. 1 keeps a single plain socket.
+     */
+    size_t workers = 1;
+
+    /**
+     * @brief Pin worker i to CPU i (modulo the number of online CPUs)
+     */
+    bool pin_cpus = false;
+
+    /**
+     * @brief Evict learned MACs not seen for this long (0 disables aging)
+     *
+     * Bounds both the table size and the broadcast fan-out on long-running
+     * switches with churning VMs.
+     */
+    std::chrono::seconds mac_aging_time = MAC_DEFAULT_AGING_TIME;
+
+    /**
+     * @brief How workers receive and send
+     *
+     * IoBackend::IoUring keeps a multishot recvmsg posted on each worker's
+     * socket, receiving into kernel-selected registered buffers, and sends
+     * forwards asynchronously. A worker that cannot set up its ring (not
+     * compiled in, old kernel, io_uring disabled) logs a warning and uses
+     * recvmmsg()/sendmmsg() instead.
+     */
+    IoBackend io_backend = IoBackend::Syscalls;
+
+    /**
+     * @brief Largest frame forwarded; bigger datagrams are dropped
+     *
+     * Sizes each receive buffer. Raise it (e.g., to 9216) for VPorts on
+     * jumbo-frame networks; clamped to [FRAME_BUFFER_SIZE, VSWITCH_MAX_FRAME_SIZE].
+     */
+    size_t max_frame_size = FRAME_BUFFER_SIZE;
+
+    /**
+     * @brief Send frames of at least UDP_ZEROCOPY_MIN_SIZE bytes with MSG_ZEROCOPY
+     *
+     * All copies of such a frame leave in one sendmmsg() sharing a single
+     * iovec, and the kernel reads the payload from the receive buffer
+     * instead of copying it once per destination. A worker waits for the
+     * kernel to release its buffers before receiving the next burst. Only
+     * the syscall backend sends zero-copy; sockets that refuse SO_ZEROCOPY
+     * log a warning and copy.
+     */
+    bool zerocopy = false;
+
+    /**
+     * @brief Interface to receive and send the underlay through with TPACKET_V3 rings (empty: sockets only)
+     *
+     * Each worker gets a PacketRing on this interface for its port; the
+     * kernel fans flows out across them like SO_REUSEPORT. Needs
+     * CAP_NET_RAW and IPv4 underlay traffic. Without the privilege, or with
+     * the io_uring backend, the switch logs a warning and uses its sockets.
+     */
+    std::string packet_ring_interface;
+
+    /**
+     * @brief Keys of the VPorts allowed to connect (empty: cleartext)
+     *
+     * With keys every datagram must be sealed with one of them (see
+     * tunnel_crypto.hpp); anything else is dropped and counted in
+     * crypto_drops. Frames to a VPort are sealed with the key it last
+     * authenticated with, and copies for endpoints that never did are
+     * dropped. Encryption is not combined with the io_uring backend or
+     * zero-copy sends, which fall back to syscalls and copies.
+     */
+    std::vector<TunnelKey> tunnel_keys;
+
+    /**
+     * @brief AEAD the tunnel uses (both ends must agree)
+     */
+    TunnelCipher tunnel_cipher = TunnelCipher::Aes256Gcm;
+
+    /**
+     * @brief VLAN membership of VPort endpoints (empty: not VLAN-aware)
+     *
+     * With any port configured the switch learns and looks up MACs per
+     * VLAN, floods a broadcast only to the ports carrying its VLAN, and
+     * pushes or pops the 802.1Q tag of each copy to suit the egress port.
+     * Endpoints not listed are access ports in default_vlan. Without any,
+     * tags are forwarded untouched and all ports share one domain.
+     */
+    std::vector<VlanPortConfig> vlan_ports;
+
+    /**
+     * @brief Access VLAN of endpoints not in vlan_ports
+     */
+    uint16_t default_vlan = VLAN_DEFAULT_ID;
+
+    /**
+     * @brief What happens to frames for a unicast MAC that has not been learned
+     */
+    FloodPolicy unknown_unicast = FloodPolicy::Drop;
+
+    /**
+     * @brief Forward multicast only to the ports that subscribed with IGMP or MLD
+     *
+     * Membership reports subscribe the endpoint they came from to a group;
+     * endpoints that send queries become router ports, which get all of
+     * their VLAN's multicast. Reports are passed on to router ports only.
+     * The reserved link-local groups (224.0.0.x, ff02::1, mDNS, ...) are
+     * always flooded.
+     */
+    bool multicast_snooping = true;
+
+    /**
+     * @brief What happens to multicast frames for a group no port subscribed to
+     *
+     * With snooping, such frames reach the router ports either way. Without
+     * snooping, every multicast frame outside the link-local groups falls
+     * under this policy.
+     */
+    FloodPolicy unknown_multicast = FloodPolicy::Drop;
+
+    /**
+     * @brief Bytes per second each source endpoint may send (0 disables policing)
+     *
+     * Frames beyond the rate are dropped on arrival, before learning or
+     * lookup, so a flooding VPort costs the worker little and cannot crowd
+     * the others out of its send batches. See IngressPolicer.
+     */
+    uint64_t ingress_rate = 0;
+
+    /**
+     * @brief Bytes a policed endpoint may send at once after being idle
+     */
+    uint64_t ingress_burst = VSWITCH_DEFAULT_INGRESS_BURST;
+
+    /**
+     * @brief Send each batch in 802.1p/DSCP priority order with deficit round robin
+     *
+     * Applies to the system call backend, whose bursts are sent as one
+     * batch; io_uring sends every frame as soon as it was processed. See
+     * EgressScheduler.
+     */
+    bool priority_queues = false;
+
+    /**
+     * @brief File to keep the MAC table in across restarts (empty disables snapshots)
+     *
+     * Loaded by create(), dropping entries older than mac_aging_time, and
+     * written when start() returns. A missing or malformed file only costs
+     * the warm start.
+     */
+    std::string mac_snapshot_path;
+
+    /**
+     * @brief Also write the snapshot this often while running (0: only on shutdown)
+     *
+     * Limits what a crash loses.
+     */
+    std::chrono::seconds mac_snapshot_interval{ 0 };
+
+    /**
+     * @brief The other nodes of the same logical switch, at their VSwitch ports (empty: standalone)
+     *
+     * Each node tells the others which MACs it learned from its own VPorts
+     * (see cluster.hpp) and forwards frames for MACs behind another node
+     * to that node. Peers also get every broadcast and multicast frame from
+     * local VPorts, so that each node floods it to its own; frames that
+     * came from a peer are never passed on to another peer. Peer traffic
+     * is not policed. Every node must list every other one, with the
+     * address it sends from, and VLAN-aware nodes must configure their
+     * peers as trunks. Not combined with encryption.
+     */
+    std::vector<Endpoint> cluster_peers;
+
+    /**
+     * @brief How often MACs learned or lost since the last round are sent to the peers
+     */
+    std::chrono::milliseconds cluster_sync_interval = CLUSTER_DEFAULT_SYNC_INTERVAL;
+  };
+
   /**
    * @brief Virtual Switch - learning switch implementation
    * 
@@ -50,9 +323,16 @@ namespace project
    * 2. If destination MAC is known (in table):
    *    - Forward frame to that endpoint (unicast)
    * 3. If destination MAC is broadcast:
-   *    - Forward frame to all known endpoints except source (broadcast)
-   * 4. If destination MAC is unknown:
-   *    - Discard frame (unknown unicast)
+   *    - Forward one copy to every known endpoint except the source (broadcast)
+   * 4. If destination MAC is multicast:
+   *    - Forward one copy to every port subscribed to the group (see
+   *      VSwitchConfig::multicast_snooping)
+   * 5. If destination MAC is unknown:
+   *    - Discard frame (unknown unicast), unless configured to flood it
+   *
+   * When VSwitchConfig::vlan_ports is set, each step happens within the
+   * frame's VLAN: the MAC table is keyed by (VLAN, MAC) and a broadcast
+   * reaches only the ports that carry its VLAN.
    * 
    * Example:
    * @code
@@ -72,12 +352,130 @@ namespace project
   class VSwitch
   {
   private:
-    UdpSocket socket_;
-    MacTable mac_table_;
-    uint16_t port_;
+    /**
+     * @brief One port a broadcast in some VLAN goes out of
+     */
+    struct FloodTarget
+    {
+      Endpoint endpoint;
+      bool tagged = false;
+    };
+
+    /**
+     * @brief Where the frames of one multicast group go
+     */
+    struct GroupTargets
+    {
+      bool registered = false;  // Some port subscribed (otherwise targets holds the router ports)
+      std::vector<FloodTarget> targets;
+    };
+
+    /**
+     * @brief Per-thread forwarding state
+     *
+     * Burst state is allocated once when the worker starts. rx_buffers
+     * must be destroyed before the pool that owns their slots.
+     */
+    struct Worker
+    {
+      UdpSocket socket;
+      std::unique_ptr<FramePool> rx_pool;
+      std::vector<FrameBuffer> rx_buffers;
+      std::vector<InboundDatagram> rx_batch;
+      std::vector<const uint8_t*> rx_frames;  // rx_batch data pointers, fixed for the worker's lifetime
+      std::vector<size_t> rx_sizes;           // rx_batch sizes, 0 for truncated datagrams
+      std::vector<FrameKeys> rx_keys;         // What classify_frames() made of the burst
+
+      // The frames of one aggregate (see frame_coalescing.hpp), pointing into its receive buffer
+      std::vector<const uint8_t*> rx_records;
+      std::vector<size_t> rx_record_sizes;
+      std::vector<FrameKeys> rx_record_keys;
+      std::vector<OutboundDatagram> tx_batch;
+      std::vector<Endpoint> tx_destinations;  // Scratch for one zero-copy run of tx_batch
+
+      // Tunnel state, used only with keys: the sealed copies of tx_batch and the key each is sealed with
+      TunnelContext tunnel;
+      std::vector<TunnelFrame> rx_opened;
+      std::vector<uint8_t> tx_sealed;
+      std::vector<uint32_t> tx_keys;
+
+      // Private copy of the keyring's endpoint-to-key bindings, dropped when its generation moves
+      std::unordered_map<Endpoint, uint32_t> tunnel_peers;
+      uint64_t tunnel_peer_generation = ~uint64_t{ 0 };
+
+      // Where this worker's unicast flows went, valid while the MAC table's generation stands still
+      FlowCache flows;
+
+      // Private copy of the table's deduplicated flood list
+      std::vector<Endpoint> flood_list;
+      uint64_t flood_generation = ~uint64_t{ 0 };
+
+      // flood_list split per VLAN, built on first use and dropped when flood_list changes
+      std::unordered_map<uint16_t, std::vector<FloodTarget>> vlan_flood_lists;
+
+      // Per-group targets, keyed like MulticastGroupTable and dropped when its generation moves
+      std::unordered_map<uint64_t, GroupTargets> group_targets;
+      uint64_t group_generation = ~uint64_t{ 0 };
+      std::vector<Endpoint> group_members;  // Scratch for MulticastGroupTable queries
+      SnoopingMessage snooped;
+      std::vector<MacUpdate> cluster_updates;  // Scratch for update datagrams from peers
+
+      IngressPolicer policer;
+      EgressScheduler egress;
+      uint64_t rx_time_ns = 0;  // Receive time of the current burst, for the policer and MAC learning
+
+      // Written only by this worker's thread
+      TrafficCounters counters;
+#if PROJECT_LATENCY_HISTOGRAMS
+      LatencyHistogram latency;
+#endif
+    };
+
+    std::vector<Worker> workers_;
+    ConcurrentMacTable mac_table_;
+    MulticastGroupTable multicast_;
+    uint16_t port_ = 0;
+    size_t batch_size_ = VSWITCH_DEFAULT_BATCH_SIZE;
+    bool pin_cpus_ = false;
+    std::chrono::seconds mac_aging_time_ = MAC_DEFAULT_AGING_TIME;
+    IoBackend io_backend_ = IoBackend::Syscalls;
+    size_t max_frame_size_ = FRAME_BUFFER_SIZE;
+    VlanMap vlans_;
+    FloodPolicy unknown_unicast_ = FloodPolicy::Drop;
+    bool multicast_snooping_ = true;
+    FloodPolicy unknown_multicast_ = FloodPolicy::Drop;
+    uint64_t ingress_rate_ = 0;
+    uint64_t ingress_burst_ = VSWITCH_DEFAULT_INGRESS_BURST;
+    bool priority_queues_ = false;
+    std::string mac_snapshot_path_;
+    std::chrono::seconds mac_snapshot_interval_{ 0 };
+
+    // VPort keys, null without encryption; its address stays put when the VSwitch moves
+    std::unique_ptr<TunnelKeyring> tunnel_;
+
+    // The other nodes of the cluster, and what this one last told them (touched by the sync thread only)
+    std::vector<Endpoint> peers_;
+    std::chrono::milliseconds cluster_sync_interval_ = CLUSTER_DEFAULT_SYNC_INTERVAL;
+    MacSyncTracker cluster_sync_;
+    size_t cluster_rounds_ = 0;
 
     std::atomic<bool> running_;
 
+    // Threads for workers 1..N-1; worker 0 runs on the thread calling start()
+    std::vector<joining_thread> worker_threads_;
+
+    // Background MAC aging, alive while start() runs
+    std::unique_ptr<AgingSweeper> sweeper_;
+
+    // Lapses multicast subscriptions, alive while start() runs with snooping
+    std::unique_ptr<AgingSweeper> group_sweeper_;
+
+    // Writes periodic MAC table snapshots, alive while start() runs with an interval
+    std::unique_ptr<AgingSweeper> snapshot_writer_;
+
+    // Sends MAC updates to the peers, alive while start() runs in a cluster
+    std::unique_ptr<AgingSweeper> cluster_syncer_;
+
   public:
     /**
      * @brief Create a VSwitch instance
@@ -87,6 +485,29 @@ namespace project
      */
     [[nodiscard]] static expected<VSwitch, VSwitchError> create(uint16_t port);
 
+    /**
+     * @brief Create a VSwitch instance from a configuration
+     *
+     * @param config The switch configuration
+     * @return expected<VSwitch, VSwitchError> The created VSwitch or an error
+     */
+    [[nodiscard]] static expected<VSwitch, VSwitchError> create(const VSwitchConfig& config);
+
+    /**
+     * @brief Create a VSwitch from the sockets and MAC table of a running one
+     *
+     * Receives what the predecessor's hand_over() sends on channel (see
+     * socket_handoff.hpp), adopts its sockets with their port and worker
+     * count (overriding config.port and config.workers) and fills the MAC
+     * table from its state. The ack that makes the predecessor stop is
+     * sent last, so on any error the predecessor keeps running.
+     *
+     * @param config The switch configuration
+     * @param channel A connection to the predecessor's HandoffListener
+     * @return expected<VSwitch, VSwitchError> The created VSwitch or an error
+     */
+    [[nodiscard]] static expected<VSwitch, VSwitchError> take_over(const VSwitchConfig& config, int channel);
+
     /**
      * @brief Default constructor
      */
@@ -120,8 +541,12 @@ namespace project
     /**
      * @brief Start the VSwitch main processing loop
      * 
-     * Begins listening for incoming frames and processing them.
-     * This call blocks until stop() is called.
+     * Begins listening for incoming frames and processing them in bursts:
+     * up to batch_size frames are received with one syscall, forwarded
+     * through the learning logic, and all resulting sends are flushed
+     * together. With several workers, workers 1..N-1 run on their own
+     * threads and worker 0 on the calling thread. This call blocks until
+     * stop() is called and every worker thread has been joined.
      * 
      * @return expected<void, VSwitchError> Success or error
      */
@@ -134,6 +559,19 @@ namespace project
      */
     void stop() noexcept;
 
+    /**
+     * @brief Pass the sockets and MAC table to a successor's take_over(), then stop
+     *
+     * Safe to call from another thread while start() runs. The workers keep
+     * forwarding until the successor has acknowledged; datagrams arriving
+     * afterwards wait in the shared sockets until it starts. Workers on the
+     * io_uring backend drop what their rings already took in when stopping.
+     *
+     * @param channel A connection accepted on a HandoffListener
+     * @return expected<void, HandoffError> Success, or an error with the switch still running
+     */
+    [[nodiscard]] expected<void, HandoffError> hand_over(int channel);
+
     /**
      * @brief Check if the VSwitch is running
      * @return true if processing is running
@@ -145,13 +583,27 @@ namespace project
 
     /**
      * @brief Get the port the VSwitch is listening on
-     * @return The port number
+     * @return The port number (the kernel-assigned one when created with port 0)
      */
     [[nodiscard]] uint16_t port() const noexcept
     {
       return port_;
     }
 
+    /**
+     * @brief Get the number of forwarding workers
+     */
+    [[nodiscard]] size_t worker_count() const noexcept
+    {
+      return workers_.size();
+    }
+
+    /**
+     * @brief Write the MAC table to VSwitchConfig::mac_snapshot_path now
+     * @return expected<size_t, MacSnapshotError> Number of entries written, or an error (OpenFailed without a path)
+     */
+    expected<size_t, MacSnapshotError> save_mac_snapshot() const;
+
     /**
      * @brief Get the number of learned MAC addresses
      * @return Number of entries in MAC table
@@ -161,6 +613,53 @@ namespace project
       return mac_table_.size();
     }
 
+    /**
+     * @brief Get the number of multicast groups some port subscribed to
+     */
+    [[nodiscard]] size_t multicast_groups() const
+    {
+      return multicast_.group_count();
+    }
+
+    /**
+     * @brief Get the other nodes of the cluster (empty when standalone)
+     */
+    [[nodiscard]] const std::vector<Endpoint>& cluster_peers() const noexcept
+    {
+      return peers_;
+    }
+
+    /**
+     * @brief Get the traffic counters of every worker, indexed like the workers
+     *
+     * Safe to call while the switch is running; the forwarding threads are
+     * not slowed down by readers.
+     */
+    [[nodiscard]] std::vector<TrafficStats> worker_stats() const;
+
+    /**
+     * @brief Get the traffic counters summed over all workers
+     */
+    [[nodiscard]] TrafficStats stats() const;
+
+    /**
+     * @brief Get the receive-to-send latency of forwarded frames, merged over all workers
+     *
+     * A frame's latency runs from the return of the receive syscall that
+     * brought it in to the return of the send syscall of its burst. Empty
+     * unless built with PROJECT_LATENCY_HISTOGRAMS.
+     */
+    [[nodiscard]] LatencySnapshot latency() const;
+
+    /**
+     * @brief Render the per-worker counters and the table size as Prometheus text
+     *
+     * Counters are labelled worker="<index>"; vswitch_learned_macs and
+     * vswitch_multicast_groups are gauges.
+     * With PROJECT_LATENCY_HISTOGRAMS, per-worker latency summaries follow.
+     */
+    [[nodiscard]] std::string stats_prometheus() const;
+
     /**
      * @brief Get a copy of the MAC table
      * @return Copy of the MAC table entries
@@ -173,10 +672,81 @@ namespace project
   private:
     /**
      * @brief Private constructor for create()
-     * @param socket UDP socket to bind to
+     * @param sockets One bound UDP socket per worker
      * @param port The port number
+     * @param batch_size Frames per burst
+     * @param pin_cpus Whether to pin each worker to a CPU
+     * @param mac_aging_time Aging time for learned MACs (0 disables aging)
+     * @param io_backend How workers receive and send
+     * @param max_frame_size Largest frame forwarded
+     * @param vlans VLAN membership of the ports
+     * @param config The configuration, for its flood, snooping and QoS policies
+     * @param tunnel The VPort keys (null: cleartext)
+     */
+    VSwitch(std::vector<UdpSocket> sockets, uint16_t port, size_t batch_size, bool pin_cpus,
+            std::chrono::seconds mac_aging_time, IoBackend io_backend, size_t max_frame_size, VlanMap vlans,
+            const VSwitchConfig& config, std::unique_ptr<TunnelKeyring> tunnel);
+
+    /**
+     * @brief Build a VSwitch around bound sockets (the common part of create() and take_over())
+     * @param config The switch configuration
+     * @param sockets One bound UDP socket per worker
+     * @param port The port they are bound to
+     * @return expected<VSwitch, VSwitchError> The VSwitch, InvalidVlanConfig or EncryptionFailed
+     */
+    [[nodiscard]] static expected<VSwitch, VSwitchError> assemble(const VSwitchConfig& config,
+                                                                  std::vector<UdpSocket> sockets, uint16_t port);
+
+    /**
+     * @brief Receive/process/flush loop of one worker, until stop()
+     * @param index Index into workers_
      */
-    VSwitch(UdpSocket socket, uint16_t port) noexcept;
+    void run_worker(size_t index);
+
+    /**
+     * @brief io_uring variant of the worker loop, until stop()
+     * @param worker The worker to run
+     * @return false if the ring could not be set up and nothing was received (fall back to run_worker())
+     */
+    bool run_worker_uring(Worker& worker);
+
+    /**
+     * @brief Evict MACs older than the aging time (runs on the sweeper thread)
+     */
+    void expire_macs();
+
+    /**
+     * @brief Drop lapsed multicast subscriptions (runs on the group sweeper thread)
+     */
+    void expire_groups();
+
+    /**
+     * @brief Save a snapshot, logging the outcome (runs on the snapshot thread and at shutdown)
+     */
+    void write_mac_snapshot() const;
+
+    /**
+     * @brief Fill the MAC table from the snapshot file, if there is one
+     */
+    void restore_mac_snapshot();
+
+    /**
+     * @brief Send the peers what changed in the MACs of local VPorts (runs on the sync thread)
+     */
+    void sync_cluster();
+
+    /**
+     * @brief Apply a peer's update datagram to the MAC table
+     */
+    void apply_cluster_update(Worker& worker, const uint8_t* data, size_t size, const Endpoint& peer);
+
+    /**
+     * @brief Check whether an endpoint is another node of the cluster
+     */
+    [[nodiscard]] bool is_peer(const Endpoint& endpoint) const noexcept
+    {
+      return !peers_.empty() && std::find(peers_.begin(), peers_.end(), endpoint) != peers_.end();
+    }
 
     /**
      * @brief Process a single Ethernet frame
@@ -185,20 +755,93 @@ namespace project
      * 1. Learn source MAC → sender endpoint
      * 2. Forward based on destination MAC
      * 
-     * @param frame_data The raw frame data
+     * Outgoing copies are queued on the worker's transmit batch rather than
+     * sent immediately; they reference frame_data, which must stay valid
+     * until flush_tx_batch() runs.
+     * 
+     * @param worker The worker processing the frame
+     * @param frame_data Pointer to the raw frame data
+     * @param frame_size Size of the frame in bytes
+     * @param keys The frame's classified header (see classify_frames())
      * @param sender_endpoint The endpoint that sent the frame
      */
-    void process_frame(const std::vector<uint8_t>& frame_data, const Endpoint& sender_endpoint);
+    void process_frame(Worker& worker, const uint8_t* frame_data, size_t frame_size, const FrameKeys& keys,
+                       const Endpoint& sender_endpoint);
+
+    /**
+     * @brief Process a received datagram: one frame, each frame of an aggregate in turn, or a peer's update
+     *
+     * The frames of an aggregate are forwarded from where they lie in it,
+     * so the same lifetime rules as for process_frame() apply to the datagram.
+     */
+    void process_datagram(Worker& worker, const uint8_t* data, size_t size, const FrameKeys& keys,
+                          const Endpoint& sender_endpoint);
+
+    /**
+     * @brief Get the worker's copy of the flood list, refreshing it if the table changed
+     */
+    const std::vector<Endpoint>& cached_flood_list(Worker& worker) const;
+
+    /**
+     * @brief Get the worker's flood list for one VLAN, with the tagging of each port
+     */
+    const std::vector<FloodTarget>& cached_vlan_flood_list(Worker& worker, uint16_t vlan) const;
+
+    /**
+     * @brief Get the worker's cached targets of a multicast group, refreshing them if the group table changed
+     */
+    const GroupTargets& cached_group_targets(Worker& worker, uint16_t vlan, const MacAddress& group) const;
+
+    /**
+     * @brief Queue one copy of a frame to every port in its VLAN but the sender
+     * @return Number of copies queued (counted as a flood when non-zero)
+     */
+    size_t flood(Worker& worker, const uint8_t* frame_data, size_t frame_size, uint16_t vlan,
+                 const Endpoint& sender_endpoint) const;
+
+    /**
+     * @brief Forward a multicast frame, snooping it first if it is IGMP or MLD
+     */
+    void forward_multicast(Worker& worker, const uint8_t* frame_data, size_t frame_size, const MacAddress& group,
+                           uint16_t vlan, const Endpoint& sender_endpoint);
+
+    /**
+     * @brief Queue one copy of a frame, tagged or untagged as the egress port of its VLAN wants
+     * @param vlan The frame's VLAN (0 when the switch is not VLAN-aware: sent as received)
+     */
+    void enqueue(Worker& worker, const uint8_t* frame_data, size_t frame_size, const Endpoint& destination,
+                 uint16_t vlan) const;
+
+    /**
+     * @brief Send every queued outgoing frame of a worker (by priority with priority_queues) and clear the batch
+     */
+    void flush_tx_batch(Worker& worker) const;
+
+    /**
+     * @brief Open a burst of sealed datagrams in place, pointing rx_frames and rx_sizes at the frames inside
+     *
+     * Datagrams that fail to open get size 0 and are counted in crypto_drops;
+     * each sender that opened is bound to its key for the way back.
+     */
+    void open_rx_batch(Worker& worker, size_t received) const;
+
+    /**
+     * @brief Seal a worker's transmit batch into tx_sealed, dropping copies for endpoints without a key
+     */
+    void seal_tx_batch(Worker& worker) const;
 
     /**
-     * @brief Log a frame processing event
-     * @param frame The Ethernet frame
-     * @param sender_endpoint The sender's endpoint
-     * @param action Description of the action taken (e.g., "Forwarded", "Discarded")
-     * @param details Additional details about the action
+     * @brief Send a worker's transmit batch with large frames going out zero-copy
+     *
+     * Consecutive unspliced copies of one frame of at least UDP_ZEROCOPY_MIN_SIZE
+     * bytes go out with send_to_many(); everything else with send_batch(),
+     * so each destination still sees its frames in order. Returns once the
+     * kernel has released the burst's buffers, however long that takes, or
+     * once the switch is stopping and will receive nothing more into them.
+     *
+     * @return Number of datagrams sent
      */
-    void log_frame(const EthernetFrame& frame, const Endpoint& sender_endpoint, std::string_view action,
-                   std::string_view details = "") const;
+    size_t send_tx_batch_zerocopy(Worker& worker) const;
   };
 
 }  // namespace project
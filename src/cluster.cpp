@@ -0,0 +1,184 @@
+/**
+ * @file cluster.cpp
+ * @brief Implementation of MAC updates between VSwitch nodes and VPort failover
+ */
+
+#include "project/cluster.hpp"
+
+#include "project/vlan.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+namespace project
+{
+  namespace
+  {
+    uint64_t update_key(uint16_t vlan, const MacAddress& mac) noexcept
+    {
+      return (uint64_t{ vlan } << 48) | mac.to_u64();
+    }
+
+    void write_header(uint8_t* out) noexcept
+    {
+      std::memset(out, 0, 12);
+      out[12] = CLUSTER_ETHERTYPE >> 8;
+      out[13] = CLUSTER_ETHERTYPE & 0xff;
+      out[14] = CLUSTER_VERSION;
+    }
+  }  // namespace
+
+  const char* to_string(ClusterError error) noexcept
+  {
+    switch (error)
+    {
+      case ClusterError::NotAnUpdate:
+        return "Not a MAC update";
+      case ClusterError::Malformed:
+        return "Malformed MAC update";
+      case ClusterError::InvalidNode:
+        return "Invalid node address (expected IPV4:PORT)";
+      default:
+        return "Unknown cluster error";
+    }
+  }
+
+  expected<Endpoint, ClusterError> parse_cluster_node(std::string_view text)
+  {
+    size_t colon = text.rfind(':');
+    if (colon == std::string_view::npos)
+    {
+      return unexpected(ClusterError::InvalidNode);
+    }
+
+    std::string_view address = text.substr(0, colon);
+    std::string_view port = text.substr(colon + 1);
+
+    uint16_t port_number = 0;
+    auto [ptr, ec] = std::from_chars(port.data(), port.data() + port.size(), port_number);
+    if (ec != std::errc() || ptr != port.data() + port.size())
+    {
+      return unexpected(ClusterError::InvalidNode);
+    }
+
+    Endpoint endpoint(address, port_number);
+    if (!endpoint.is_valid() || endpoint.family() != AF_INET)  // The sockets nodes talk through are IPv4
+    {
+      return unexpected(ClusterError::InvalidNode);
+    }
+    return endpoint;
+  }
+
+  std::vector<std::vector<uint8_t>> encode_mac_updates(const std::vector<MacUpdate>& updates)
+  {
+    std::vector<std::vector<uint8_t>> datagrams;
+    for (size_t first = 0; first < updates.size(); first += CLUSTER_MAX_RECORDS)
+    {
+      const size_t count = std::min(CLUSTER_MAX_RECORDS, updates.size() - first);
+      std::vector<uint8_t>& datagram = datagrams.emplace_back(CLUSTER_HEADER_SIZE + count * CLUSTER_RECORD_SIZE);
+      write_header(datagram.data());
+
+      uint8_t* record = datagram.data() + CLUSTER_HEADER_SIZE;
+      for (size_t i = first; i < first + count; ++i, record += CLUSTER_RECORD_SIZE)
+      {
+        record[0] = static_cast<uint8_t>(updates[i].kind);
+        record[1] = static_cast<uint8_t>(updates[i].vlan >> 8);
+        record[2] = static_cast<uint8_t>(updates[i].vlan);
+        std::memcpy(record + 3, updates[i].mac.bytes().data(), MAC_ADDRESS_SIZE);
+      }
+    }
+    return datagrams;
+  }
+
+  expected<size_t, ClusterError> decode_mac_updates(const uint8_t* data, size_t size, std::vector<MacUpdate>& updates)
+  {
+    static constexpr uint8_t NO_ADDRESSES[12] = {};
+    if (size < CLUSTER_HEADER_SIZE || std::memcmp(data, NO_ADDRESSES, sizeof(NO_ADDRESSES)) != 0 ||
+        data[12] != (CLUSTER_ETHERTYPE >> 8) || data[13] != (CLUSTER_ETHERTYPE & 0xff) || data[14] != CLUSTER_VERSION)
+    {
+      return unexpected(ClusterError::NotAnUpdate);
+    }
+    if ((size - CLUSTER_HEADER_SIZE) % CLUSTER_RECORD_SIZE != 0)
+    {
+      return unexpected(ClusterError::Malformed);
+    }
+
+    updates.clear();
+    for (const uint8_t* record = data + CLUSTER_HEADER_SIZE; record < data + size; record += CLUSTER_RECORD_SIZE)
+    {
+      if (record[0] != static_cast<uint8_t>(MacUpdateKind::Learn) &&
+          record[0] != static_cast<uint8_t>(MacUpdateKind::Withdraw))
+      {
+        continue;
+      }
+      const auto vlan = static_cast<uint16_t>(record[1] << 8 | record[2]);
+      if (vlan > VLAN_MAX_ID)
+      {
+        continue;  // The MAC table keeps 12 bits: it would land on another VLAN
+      }
+
+      MacUpdate& update = updates.emplace_back();
+      update.kind = static_cast<MacUpdateKind>(record[0]);
+      update.vlan = vlan;
+      update.mac = MacAddress(record + 3);
+    }
+    return updates.size();
+  }
+
+  std::vector<MacUpdate> MacSyncTracker::changes(const std::vector<LearnedMac>& owned, bool refresh)
+  {
+    std::vector<MacUpdate> updates;
+    std::unordered_set<uint64_t> current;
+    current.reserve(owned.size());
+    for (const auto& entry : owned)
+    {
+      const uint64_t key = update_key(entry.vlan, entry.mac);
+      if (current.insert(key).second && (refresh || announced_.count(key) == 0))
+      {
+        updates.push_back({ MacUpdateKind::Learn, entry.vlan, entry.mac });
+      }
+    }
+
+    for (uint64_t key : announced_)
+    {
+      if (current.count(key) == 0)
+      {
+        updates.push_back({ MacUpdateKind::Withdraw, static_cast<uint16_t>(key >> 48), MacAddress::from_u64(key) });
+      }
+    }
+
+    announced_ = std::move(current);
+    return updates;
+  }
+
+  VSwitchFailover::VSwitchFailover(std::vector<Endpoint> nodes, std::chrono::milliseconds timeout)
+      : nodes_(std::move(nodes)),
+        timeout_ns_(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(timeout).count()))
+  {
+  }
+
+  bool VSwitchFailover::poll(uint64_t now_ns) noexcept
+  {
+    if (nodes_.size() < 2)
+    {
+      return false;
+    }
+    if (since_ns_ == 0)
+    {
+      since_ns_ = now_ns;
+      return false;
+    }
+
+    const uint64_t last = std::max(since_ns_, heard_ns_.load(std::memory_order_relaxed));
+    if (now_ns <= last || now_ns - last <= timeout_ns_)
+    {
+      return false;
+    }
+
+    active_ = (active_ + 1) % nodes_.size();
+    since_ns_ = now_ns;
+    return true;
+  }
+
+}  // namespace project
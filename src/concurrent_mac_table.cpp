@@ -0,0 +1,558 @@
+/**
+ * @file concurrent_mac_table.cpp
+ * @brief Implementation of the lock-free-read MAC learning table
+ */
+
+#include "project/concurrent_mac_table.hpp"
+#include "project/hash.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace project
+{
+  namespace
+  {
+    constexpr uint64_t KEY_OCCUPIED = uint64_t{ 1 } << 63;
+    constexpr unsigned KEY_VLAN_SHIFT = 48;  // The VLAN ID sits between the MAC and the occupied bit
+    constexpr uint64_t KEY_VLAN_MASK = 0xfff;
+    constexpr size_t MIN_CAPACITY = 8;
+
+    inline void cpu_relax() noexcept
+    {
+#if defined(__x86_64__) || defined(__i386__)
+      __builtin_ia32_pause();
+#endif
+    }
+
+    size_t round_up_capacity(size_t capacity) noexcept
+    {
+      size_t rounded = MIN_CAPACITY;
+      while (rounded < capacity)
+      {
+        rounded <<= 1;
+      }
+      return rounded;
+    }
+  }  // namespace
+
+  ConcurrentMacTable::ConcurrentMacTable(size_t initial_capacity)
+      : initial_capacity_(round_up_capacity(initial_capacity))
+  {
+    tables_.push_back(std::make_unique<Table>(initial_capacity_));
+    current_.store(tables_.back().get(), std::memory_order_release);
+  }
+
+  ConcurrentMacTable::ConcurrentMacTable(ConcurrentMacTable&& other) noexcept
+      : current_(other.current_.exchange(nullptr)),
+        tables_(std::move(other.tables_)),
+        size_(other.size_.exchange(0)),
+        initial_capacity_(other.initial_capacity_),
+        endpoint_refs_(std::move(other.endpoint_refs_)),
+        flood_list_(std::move(other.flood_list_))
+  {
+    // The entries move along unchanged, so lookups cached under the old generation stay right
+    generation_.store(other.generation_.fetch_add(1, std::memory_order_acq_rel), std::memory_order_relaxed);
+    other.tables_.clear();
+    other.endpoint_refs_.clear();
+    other.flood_list_.clear();
+    other.flood_generation_.fetch_add(1, std::memory_order_release);
+  }
+
+  ConcurrentMacTable& ConcurrentMacTable::operator=(ConcurrentMacTable&& other) noexcept
+  {
+    if (this != &other)
+    {
+      std::lock_guard lock(write_mutex_);
+      current_.store(other.current_.exchange(nullptr), std::memory_order_release);
+      tables_ = std::move(other.tables_);
+      other.tables_.clear();
+      size_.store(other.size_.exchange(0), std::memory_order_relaxed);
+      initial_capacity_ = other.initial_capacity_;
+      endpoint_refs_ = std::move(other.endpoint_refs_);
+      flood_list_ = std::move(other.flood_list_);
+      other.endpoint_refs_.clear();
+      other.flood_list_.clear();
+      flood_generation_.fetch_add(1, std::memory_order_release);
+      other.flood_generation_.fetch_add(1, std::memory_order_release);
+
+      // Past both old generations, so no lookup cached against either table matches
+      const uint64_t generation = std::max(generation_.load(std::memory_order_relaxed),
+                                           other.generation_.load(std::memory_order_relaxed)) + 1;
+      generation_.store(generation, std::memory_order_release);
+      other.generation_.store(generation, std::memory_order_release);
+    }
+    return *this;
+  }
+
+  uint64_t ConcurrentMacTable::make_key(uint16_t vlan, const MacAddress& mac) noexcept
+  {
+    return mac.to_u64() | ((vlan & KEY_VLAN_MASK) << KEY_VLAN_SHIFT) | KEY_OCCUPIED;
+  }
+
+  void ConcurrentMacTable::read_slot(const Slot& slot, uint64_t& key, Endpoint& endpoint) noexcept
+  {
+    uint64_t words[ENDPOINT_WORDS];
+
+    for (;;)
+    {
+      uint32_t before = slot.seq.load(std::memory_order_acquire);
+      if ((before & 1) != 0)
+      {
+        cpu_relax();  // Writer in progress
+        continue;
+      }
+
+      key = slot.key.load(std::memory_order_relaxed);
+      for (size_t i = 0; i < ENDPOINT_WORDS; ++i)
+      {
+        words[i] = slot.endpoint[i].load(std::memory_order_relaxed);
+      }
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot.seq.load(std::memory_order_relaxed) == before)
+      {
+        break;
+      }
+    }
+
+    std::memcpy(static_cast<void*>(&endpoint), words, sizeof(Endpoint));
+  }
+
+  void ConcurrentMacTable::write_slot(Slot& slot, uint64_t key, const Endpoint& endpoint,
+                                      MacTimestamp last_seen) noexcept
+  {
+    uint64_t words[ENDPOINT_WORDS] = {};
+    std::memcpy(words, static_cast<const void*>(&endpoint), sizeof(Endpoint));
+
+    uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+    slot.seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.key.store(key, std::memory_order_relaxed);
+    for (size_t i = 0; i < ENDPOINT_WORDS; ++i)
+    {
+      slot.endpoint[i].store(words[i], std::memory_order_relaxed);
+    }
+
+    slot.seq.store(seq + 2, std::memory_order_release);
+    slot.last_seen.store(last_seen, std::memory_order_relaxed);
+  }
+
+  const ConcurrentMacTable::Slot* ConcurrentMacTable::find(uint64_t key, Endpoint& endpoint) const noexcept
+  {
+    const size_t home = mix64(key);
+
+    for (;;)
+    {
+      uint64_t version = shift_version_.load(std::memory_order_acquire);
+      const Table* table = current_.load(std::memory_order_acquire);
+      if (table == nullptr)
+      {
+        return nullptr;
+      }
+
+      for (size_t n = 0, i = home & table->mask; n <= table->mask; ++n, i = (i + 1) & table->mask)
+      {
+        uint64_t slot_key;
+        read_slot(table->slots[i], slot_key, endpoint);
+
+        if (slot_key == key)
+        {
+          return &table->slots[i];
+        }
+        if (slot_key == 0)
+        {
+          break;
+        }
+      }
+
+      // A miss is only trustworthy if no entries were shifted while probing
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if ((version & 1) == 0 && shift_version_.load(std::memory_order_relaxed) == version)
+      {
+        return nullptr;
+      }
+      cpu_relax();
+    }
+  }
+
+  size_t ConcurrentMacTable::probe(const Table& table, uint64_t key, bool& found) noexcept
+  {
+    size_t i = mix64(key) & table.mask;
+    for (;;)
+    {
+      uint64_t slot_key = table.slots[i].key.load(std::memory_order_relaxed);
+      if (slot_key == key || slot_key == 0)
+      {
+        found = (slot_key == key);
+        return i;
+      }
+      i = (i + 1) & table.mask;
+    }
+  }
+
+  void ConcurrentMacTable::grow()
+  {
+    const Table* old_table = current_.load(std::memory_order_relaxed);
+    auto table = std::make_unique<Table>((old_table->mask + 1) * 2);
+
+    // The new table is private until published, but write_slot keeps it uniform
+    for (size_t i = 0; i <= old_table->mask; ++i)
+    {
+      uint64_t key;
+      Endpoint endpoint;
+      read_slot(old_table->slots[i], key, endpoint);
+      if (key != 0)
+      {
+        bool found;
+        write_slot(table->slots[probe(*table, key, found)], key, endpoint,
+                   old_table->slots[i].last_seen.load(std::memory_order_relaxed));
+      }
+    }
+
+    // Old tables stay allocated: readers may still be probing them
+    current_.store(table.get(), std::memory_order_release);
+    tables_.push_back(std::move(table));
+  }
+
+  bool ConcurrentMacTable::insert(const MacAddress& mac, const Endpoint& endpoint, MacTimestamp now)
+  {
+    return insert(0, mac, endpoint, now);
+  }
+
+  bool ConcurrentMacTable::insert(uint16_t vlan, const MacAddress& mac, const Endpoint& endpoint, MacTimestamp now)
+  {
+    const uint64_t key = make_key(vlan, mac);
+
+    // Fast path: already learned with the same endpoint, at most refresh the age
+    Endpoint existing;
+    const Slot* existing_slot = find(key, existing);
+    if (existing_slot != nullptr && existing == endpoint)
+    {
+      auto& last_seen = const_cast<Slot*>(existing_slot)->last_seen;
+      if (last_seen.load(std::memory_order_relaxed) != now)
+      {
+        last_seen.store(now, std::memory_order_relaxed);
+      }
+      return false;
+    }
+
+    std::lock_guard lock(write_mutex_);
+
+    if (current_.load(std::memory_order_relaxed) == nullptr)
+    {
+      tables_.push_back(std::make_unique<Table>(initial_capacity_));
+      current_.store(tables_.back().get(), std::memory_order_release);
+    }
+
+    Table* table = current_.load(std::memory_order_relaxed);
+    bool found;
+    size_t index = probe(*table, key, found);
+
+    if (found)
+    {
+      uint64_t slot_key;
+      Endpoint current_endpoint;
+      read_slot(table->slots[index], slot_key, current_endpoint);
+      if (current_endpoint != endpoint)
+      {
+        // Station moved
+        add_endpoint_ref(endpoint);
+        write_slot(table->slots[index], key, endpoint, now);
+        release_endpoint_ref(current_endpoint);
+        generation_.fetch_add(1, std::memory_order_release);
+      }
+      else
+      {
+        table->slots[index].last_seen.store(now, std::memory_order_relaxed);
+      }
+      return false;
+    }
+
+    const size_t count = size_.load(std::memory_order_relaxed);
+    if ((count + 1) * 4 > (table->mask + 1) * 3)
+    {
+      grow();
+      table = current_.load(std::memory_order_relaxed);
+      index = probe(*table, key, found);
+    }
+
+    add_endpoint_ref(endpoint);
+    write_slot(table->slots[index], key, endpoint, now);
+    size_.store(count + 1, std::memory_order_relaxed);
+    generation_.fetch_add(1, std::memory_order_release);
+    return true;
+  }
+
+  std::optional<Endpoint> ConcurrentMacTable::lookup(const MacAddress& mac) const noexcept
+  {
+    return lookup(0, mac);
+  }
+
+  std::optional<Endpoint> ConcurrentMacTable::lookup(uint16_t vlan, const MacAddress& mac) const noexcept
+  {
+    Endpoint endpoint;
+    if (find(make_key(vlan, mac), endpoint) == nullptr)
+    {
+      return std::nullopt;
+    }
+    return endpoint;
+  }
+
+  bool ConcurrentMacTable::remove(const MacAddress& mac)
+  {
+    return remove(0, mac);
+  }
+
+  bool ConcurrentMacTable::remove(uint16_t vlan, const MacAddress& mac)
+  {
+    const uint64_t key = make_key(vlan, mac);
+
+    std::lock_guard lock(write_mutex_);
+
+    Table* table = current_.load(std::memory_order_relaxed);
+    if (table == nullptr)
+    {
+      return false;
+    }
+
+    bool found;
+    size_t hole = probe(*table, key, found);
+    if (!found)
+    {
+      return false;
+    }
+
+    erase_at(*table, hole);
+    return true;
+  }
+
+  void ConcurrentMacTable::erase_at(Table& table, size_t hole) noexcept
+  {
+    {
+      uint64_t key;
+      Endpoint removed;
+      read_slot(table.slots[hole], key, removed);
+      release_endpoint_ref(removed);
+    }
+
+    uint64_t version = shift_version_.load(std::memory_order_relaxed);
+    shift_version_.store(version + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    // Backward-shift deletion: pull later entries of the probe run into the
+    // hole so lookups never need tombstones
+    for (size_t j = (hole + 1) & table.mask;; j = (j + 1) & table.mask)
+    {
+      uint64_t slot_key;
+      Endpoint endpoint;
+      read_slot(table.slots[j], slot_key, endpoint);
+      if (slot_key == 0)
+      {
+        break;
+      }
+
+      // The entry may move if the hole lies between its home slot and j
+      size_t home = mix64(slot_key) & table.mask;
+      if (((j - home) & table.mask) >= ((j - hole) & table.mask))
+      {
+        write_slot(table.slots[hole], slot_key, endpoint, table.slots[j].last_seen.load(std::memory_order_relaxed));
+        hole = j;
+      }
+    }
+
+    write_slot(table.slots[hole], 0, Endpoint{}, 0);
+
+    shift_version_.store(version + 2, std::memory_order_release);
+    size_.store(size_.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+    generation_.fetch_add(1, std::memory_order_release);
+  }
+
+  size_t ConcurrentMacTable::expire(std::chrono::seconds max_age, MacTimestamp now)
+  {
+    // Lock-free scan for candidates so learning is not blocked meanwhile
+    std::vector<uint64_t> stale;
+    const Table* scanned = current_.load(std::memory_order_acquire);
+    if (scanned == nullptr)
+    {
+      return 0;
+    }
+
+    for (size_t i = 0; i <= scanned->mask; ++i)
+    {
+      const Slot& slot = scanned->slots[i];
+      uint64_t key = slot.key.load(std::memory_order_relaxed);
+      if (key != 0 && mac_entry_expired(slot.last_seen.load(std::memory_order_relaxed), now, max_age))
+      {
+        stale.push_back(key);
+      }
+    }
+
+    if (stale.empty())
+    {
+      return 0;
+    }
+
+    std::lock_guard lock(write_mutex_);
+
+    Table* table = current_.load(std::memory_order_relaxed);
+    if (table == nullptr)
+    {
+      return 0;
+    }
+
+    size_t evicted = 0;
+    for (uint64_t key : stale)
+    {
+      bool found;
+      size_t index = probe(*table, key, found);
+      if (found && mac_entry_expired(table->slots[index].last_seen.load(std::memory_order_relaxed), now, max_age))
+      {
+        erase_at(*table, index);
+        ++evicted;
+      }
+    }
+
+    return evicted;
+  }
+
+  void ConcurrentMacTable::clear() noexcept
+  {
+    std::lock_guard lock(write_mutex_);
+
+    Table* table = current_.load(std::memory_order_relaxed);
+    if (table == nullptr)
+    {
+      return;
+    }
+
+    uint64_t version = shift_version_.load(std::memory_order_relaxed);
+    shift_version_.store(version + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (size_t i = 0; i <= table->mask; ++i)
+    {
+      if (table->slots[i].key.load(std::memory_order_relaxed) != 0)
+      {
+        write_slot(table->slots[i], 0, Endpoint{}, 0);
+      }
+    }
+
+    shift_version_.store(version + 2, std::memory_order_release);
+    size_.store(0, std::memory_order_relaxed);
+
+    endpoint_refs_.clear();
+    flood_list_.clear();
+    flood_generation_.fetch_add(1, std::memory_order_release);
+    generation_.fetch_add(1, std::memory_order_release);
+  }
+
+  void ConcurrentMacTable::add_endpoint_ref(const Endpoint& endpoint)
+  {
+    if (++endpoint_refs_[endpoint] == 1)
+    {
+      flood_list_.push_back(endpoint);
+      flood_generation_.fetch_add(1, std::memory_order_release);
+    }
+  }
+
+  void ConcurrentMacTable::release_endpoint_ref(const Endpoint& endpoint) noexcept
+  {
+    auto it = endpoint_refs_.find(endpoint);
+    if (it == endpoint_refs_.end() || --it->second > 0)
+    {
+      return;
+    }
+
+    endpoint_refs_.erase(it);
+    auto pos = std::find(flood_list_.begin(), flood_list_.end(), endpoint);
+    if (pos != flood_list_.end())
+    {
+      *pos = flood_list_.back();
+      flood_list_.pop_back();
+    }
+    flood_generation_.fetch_add(1, std::memory_order_release);
+  }
+
+  std::vector<Endpoint> ConcurrentMacTable::flood_endpoints(uint64_t& generation) const
+  {
+    std::lock_guard lock(write_mutex_);
+    generation = flood_generation_.load(std::memory_order_relaxed);
+    return flood_list_;
+  }
+
+  template <typename Visitor>
+  void ConcurrentMacTable::for_each(Visitor&& visitor) const
+  {
+    const Table* table = current_.load(std::memory_order_acquire);
+    if (table == nullptr)
+    {
+      return;
+    }
+
+    for (size_t i = 0; i <= table->mask; ++i)
+    {
+      uint64_t key;
+      Endpoint endpoint;
+      read_slot(table->slots[i], key, endpoint);
+      if (key != 0)
+      {
+        visitor(key, endpoint);
+      }
+    }
+  }
+
+  std::vector<Endpoint> ConcurrentMacTable::get_all_endpoints() const
+  {
+    std::vector<Endpoint> endpoints;
+    endpoints.reserve(size());
+    for_each([&endpoints](uint64_t, const Endpoint& endpoint) { endpoints.push_back(endpoint); });
+    return endpoints;
+  }
+
+  std::vector<Endpoint> ConcurrentMacTable::get_all_endpoints_except(const MacAddress& exclude_mac) const
+  {
+    const uint64_t exclude_key = make_key(0, exclude_mac);
+
+    std::vector<Endpoint> endpoints;
+    for_each(
+        [&endpoints, exclude_key](uint64_t key, const Endpoint& endpoint)
+        {
+          if (key != exclude_key)
+          {
+            endpoints.push_back(endpoint);
+          }
+        });
+    return endpoints;
+  }
+
+  std::unordered_map<MacAddress, Endpoint> ConcurrentMacTable::get_all_entries() const
+  {
+    std::unordered_map<MacAddress, Endpoint> entries;
+    entries.reserve(size());
+    for_each([&entries](uint64_t key, const Endpoint& endpoint) { entries.emplace(MacAddress::from_u64(key), endpoint); });
+    return entries;
+  }
+
+  std::vector<LearnedMac> ConcurrentMacTable::learned() const
+  {
+    std::vector<LearnedMac> entries;
+    entries.reserve(size());
+    const Table* table = current_.load(std::memory_order_acquire);
+    for (size_t i = 0; table != nullptr && i <= table->mask; ++i)
+    {
+      uint64_t key;
+      Endpoint endpoint;
+      read_slot(table->slots[i], key, endpoint);
+      if (key != 0)
+      {
+        entries.push_back({ static_cast<uint16_t>((key >> KEY_VLAN_SHIFT) & KEY_VLAN_MASK), MacAddress::from_u64(key),
+                            endpoint, table->slots[i].last_seen.load(std::memory_order_relaxed) });
+      }
+    }
+    return entries;
+  }
+
+}  // namespace project
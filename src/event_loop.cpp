@@ -0,0 +1,229 @@
+/**
+ * @file event_loop.cpp
+ * @brief Implementation of the epoll event loop
+ */
+
+#include "project/event_loop.hpp"
+
+#include <array>
+#include <cerrno>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
+namespace project
+{
+  const char* to_string(EventLoopError error) noexcept
+  {
+    switch (error)
+    {
+      case EventLoopError::CreateFailed:
+        return "Failed to create event loop";
+      case EventLoopError::AddFailed:
+        return "Failed to watch descriptor";
+      case EventLoopError::RemoveFailed:
+        return "Failed to stop watching descriptor";
+      case EventLoopError::WaitFailed:
+        return "Failed to wait for events";
+      case EventLoopError::AlreadyRegistered:
+        return "Descriptor is already watched";
+      case EventLoopError::NotRegistered:
+        return "Descriptor is not watched";
+      case EventLoopError::InvalidLoop:
+        return "Invalid event loop";
+      default:
+        return "Unknown event loop error";
+    }
+  }
+
+  EventLoop::EventLoop(FileDescriptor epoll_fd, FileDescriptor wake_fd)
+      : epoll_fd_(std::move(epoll_fd)), wake_fd_(std::move(wake_fd)), stop_requested_(false)
+  {
+  }
+
+  EventLoop::EventLoop(EventLoop&& other) noexcept
+      : epoll_fd_(std::move(other.epoll_fd_)),
+        wake_fd_(std::move(other.wake_fd_)),
+        registrations_(std::move(other.registrations_)),
+        retired_(std::move(other.retired_)),
+        stop_requested_(other.stop_requested_.load())
+  {
+  }
+
+  EventLoop& EventLoop::operator=(EventLoop&& other) noexcept
+  {
+    if (this != &other)
+    {
+      epoll_fd_ = std::move(other.epoll_fd_);
+      wake_fd_ = std::move(other.wake_fd_);
+      registrations_ = std::move(other.registrations_);
+      retired_ = std::move(other.retired_);
+      stop_requested_.store(other.stop_requested_.load());
+    }
+    return *this;
+  }
+
+  expected<EventLoop, EventLoopError> EventLoop::create()
+  {
+#ifdef __linux__
+    FileDescriptor epoll_fd(::epoll_create1(EPOLL_CLOEXEC));
+    if (!epoll_fd)
+    {
+      return unexpected(EventLoopError::CreateFailed);
+    }
+
+    FileDescriptor wake_fd(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC));
+    if (!wake_fd)
+    {
+      return unexpected(EventLoopError::CreateFailed);
+    }
+
+    // The wake-up eventfd is the only descriptor with a null handler pointer
+    struct epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.ptr = nullptr;
+    if (::epoll_ctl(epoll_fd.get(), EPOLL_CTL_ADD, wake_fd.get(), &event) < 0)
+    {
+      return unexpected(EventLoopError::CreateFailed);
+    }
+
+    return EventLoop(std::move(epoll_fd), std::move(wake_fd));
+#else
+    return unexpected(EventLoopError::CreateFailed);
+#endif
+  }
+
+  expected<void, EventLoopError> EventLoop::add(int fd, uint32_t events, EventHandler handler)
+  {
+    if (!is_valid())
+    {
+      return unexpected(EventLoopError::InvalidLoop);
+    }
+
+    if (registrations_.count(fd) != 0)
+    {
+      return unexpected(EventLoopError::AlreadyRegistered);
+    }
+
+#ifdef __linux__
+    auto registration = std::make_unique<Registration>();
+    registration->handler = std::move(handler);
+
+    struct epoll_event event{};
+    event.events = events;
+    event.data.ptr = registration.get();
+    if (::epoll_ctl(epoll_fd_.get(), EPOLL_CTL_ADD, fd, &event) < 0)
+    {
+      return unexpected(EventLoopError::AddFailed);
+    }
+
+    registrations_.emplace(fd, std::move(registration));
+    return expected<void, EventLoopError>();
+#else
+    (void)events;
+    (void)handler;
+    return unexpected(EventLoopError::AddFailed);
+#endif
+  }
+
+  expected<void, EventLoopError> EventLoop::remove(int fd)
+  {
+    auto it = registrations_.find(fd);
+    if (it == registrations_.end())
+    {
+      return unexpected(EventLoopError::NotRegistered);
+    }
+
+    // Events for this descriptor may already sit in the current round; keep the
+    // registration alive but inactive until the round is over
+    it->second->active = false;
+    retired_.push_back(std::move(it->second));
+    registrations_.erase(it);
+
+#ifdef __linux__
+    if (::epoll_ctl(epoll_fd_.get(), EPOLL_CTL_DEL, fd, nullptr) < 0)
+    {
+      return unexpected(EventLoopError::RemoveFailed);
+    }
+#endif
+
+    return expected<void, EventLoopError>();
+  }
+
+  expected<size_t, EventLoopError> EventLoop::run_once(std::chrono::milliseconds timeout)
+  {
+    if (!is_valid())
+    {
+      return unexpected(EventLoopError::InvalidLoop);
+    }
+
+#ifdef __linux__
+    std::array<struct epoll_event, EVENT_LOOP_MAX_EVENTS> events;
+    const int timeout_ms = timeout.count() < 0 ? -1 : static_cast<int>(timeout.count());
+    int ready = ::epoll_wait(epoll_fd_.get(), events.data(), static_cast<int>(events.size()), timeout_ms);
+    if (ready < 0)
+    {
+      if (errno == EINTR)
+      {
+        return size_t{ 0 };
+      }
+      return unexpected(EventLoopError::WaitFailed);
+    }
+
+    size_t dispatched = 0;
+    for (size_t i = 0; i < static_cast<size_t>(ready); ++i)
+    {
+      auto* registration = static_cast<Registration*>(events[i].data.ptr);
+      if (registration == nullptr)
+      {
+        drain_wake_fd();
+        continue;
+      }
+
+      if (registration->active)
+      {
+        registration->handler(events[i].events);
+        ++dispatched;
+      }
+    }
+
+    retired_.clear();
+    return dispatched;
+#else
+    (void)timeout;
+    return unexpected(EventLoopError::WaitFailed);
+#endif
+  }
+
+  expected<void, EventLoopError> EventLoop::run()
+  {
+    while (!stop_requested_.exchange(false))
+    {
+      auto result = run_once(std::chrono::milliseconds(-1));
+      if (!result)
+      {
+        return unexpected(result.error());
+      }
+    }
+
+    return expected<void, EventLoopError>();
+  }
+
+  void EventLoop::stop() noexcept
+  {
+    stop_requested_.store(true);
+
+    // write() on an eventfd is async-signal-safe, unlike anything that locks
+    const uint64_t one = 1;
+    [[maybe_unused]] ssize_t written = ::write(wake_fd_.get(), &one, sizeof(one));
+  }
+
+  void EventLoop::drain_wake_fd() noexcept
+  {
+    uint64_t count;
+    [[maybe_unused]] ssize_t n = ::read(wake_fd_.get(), &count, sizeof(count));
+  }
+
+}  // namespace project
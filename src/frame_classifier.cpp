@@ -0,0 +1,275 @@
+/**
+ * @file frame_classifier.cpp
+ * @brief Implementation of the burst frame classifier
+ */
+
+#include "project/frame_classifier.hpp"
+
+#if PROJECT_SIMD && defined(__x86_64__) && defined(__GNUC__)
+#define PROJECT_CLASSIFY_X86 1
+#include <immintrin.h>
+#elif PROJECT_SIMD && defined(__aarch64__) && defined(__ARM_NEON)
+#define PROJECT_CLASSIFY_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace project
+{
+  namespace
+  {
+    constexpr uint64_t BROADCAST_KEY = 0xffffffffffffULL;
+    constexpr uint64_t GROUP_BIT = uint64_t{ 1 } << 40;  // I/G bit of the first address byte
+
+    // Vector paths load 16 bytes: both addresses, the EtherType and two bytes more
+    constexpr size_t VECTOR_LOAD_SIZE = 16;
+
+    using ClassifyFn = void (*)(const uint8_t* const*, const size_t*, size_t, FrameKeys*);
+
+    FrameClass kind_of(uint64_t dst) noexcept
+    {
+      if (dst == BROADCAST_KEY)
+      {
+        return FrameClass::Broadcast;
+      }
+      return (dst & GROUP_BIT) != 0 ? FrameClass::Multicast : FrameClass::Unicast;
+    }
+
+    uint64_t load_mac(const uint8_t* data) noexcept
+    {
+      uint64_t value = 0;
+      for (size_t i = 0; i < MAC_ADDRESS_SIZE; ++i)
+      {
+        value = (value << 8) | data[i];
+      }
+      return value;
+    }
+
+    void classify_scalar(const uint8_t* const* frames, const size_t* sizes, size_t count, FrameKeys* keys) noexcept
+    {
+      for (size_t i = 0; i < count; ++i)
+      {
+        keys[i] = classify_frame(frames[i], sizes[i]);
+      }
+    }
+
+#if PROJECT_CLASSIFY_X86
+    uint16_t swap16(int value) noexcept
+    {
+      return static_cast<uint16_t>(((value & 0xff) << 8) | ((value >> 8) & 0xff));
+    }
+
+    /**
+     * @brief One frame per iteration: PSHUFB packs both addresses into the key byte order at once
+     */
+    __attribute__((target("ssse3"))) void classify_ssse3(const uint8_t* const* frames, const size_t* sizes,
+                                                         size_t count, FrameKeys* keys) noexcept
+    {
+      // Bytes 0-5 and 6-11 reversed into two little-endian 48-bit integers; -1 zeroes the top bytes
+      const __m128i pack = _mm_setr_epi8(5, 4, 3, 2, 1, 0, -1, -1, 11, 10, 9, 8, 7, 6, -1, -1);
+      const __m128i ones = _mm_set1_epi8(-1);
+
+      for (size_t i = 0; i < count; ++i)
+      {
+        if (sizes[i] < VECTOR_LOAD_SIZE)
+        {
+          keys[i] = classify_frame(frames[i], sizes[i]);
+          continue;
+        }
+
+        const __m128i header = _mm_loadu_si128(reinterpret_cast<const __m128i*>(frames[i]));
+        const __m128i packed = _mm_shuffle_epi8(header, pack);
+        keys[i].dst = static_cast<uint64_t>(_mm_cvtsi128_si64(packed));
+        keys[i].src = static_cast<uint64_t>(_mm_cvtsi128_si64(_mm_unpackhi_epi64(packed, packed)));
+        keys[i].ethertype = swap16(_mm_extract_epi16(header, 6));
+
+        // Broadcast: the six destination bytes are all ones; multicast: bit 0 of byte 0
+        const int all_ones = _mm_movemask_epi8(_mm_cmpeq_epi8(header, ones));
+        const int group = _mm_movemask_epi8(_mm_slli_epi16(header, 7));
+        keys[i].kind = (all_ones & 0x3f) == 0x3f ? FrameClass::Broadcast
+                       : (group & 1) != 0        ? FrameClass::Multicast
+                                                 : FrameClass::Unicast;
+      }
+    }
+
+    /**
+     * @brief Two frames per iteration, one in each 128-bit lane
+     */
+    __attribute__((target("avx2"))) void classify_avx2(const uint8_t* const* frames, const size_t* sizes,
+                                                       size_t count, FrameKeys* keys) noexcept
+    {
+      // VPSHUFB shuffles within each lane, so both lanes use the same pattern
+      const __m256i pack = _mm256_setr_epi8(5, 4, 3, 2, 1, 0, -1, -1, 11, 10, 9, 8, 7, 6, -1, -1, 5, 4, 3, 2, 1, 0,
+                                            -1, -1, 11, 10, 9, 8, 7, 6, -1, -1);
+      const __m256i ones = _mm256_set1_epi8(-1);
+
+      size_t i = 0;
+      for (; i + 1 < count; i += 2)
+      {
+        if (sizes[i] < VECTOR_LOAD_SIZE || sizes[i + 1] < VECTOR_LOAD_SIZE)
+        {
+          keys[i] = classify_frame(frames[i], sizes[i]);
+          keys[i + 1] = classify_frame(frames[i + 1], sizes[i + 1]);
+          continue;
+        }
+
+        const __m256i header = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(frames[i]))),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(frames[i + 1])), 1);
+        const __m256i packed = _mm256_shuffle_epi8(header, pack);
+        const auto all_ones = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(header, ones)));
+        const auto group = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_slli_epi16(header, 7)));
+
+        for (size_t lane = 0; lane < 2; ++lane)
+        {
+          FrameKeys& key = keys[i + lane];
+          const uint32_t shift = lane == 0 ? 0 : 16;
+          const __m128i half = lane == 0 ? _mm256_castsi256_si128(packed) : _mm256_extracti128_si256(packed, 1);
+          key.dst = static_cast<uint64_t>(_mm_cvtsi128_si64(half));
+          key.src = static_cast<uint64_t>(_mm_cvtsi128_si64(_mm_unpackhi_epi64(half, half)));
+          key.ethertype = swap16(lane == 0 ? _mm256_extract_epi16(header, 6) : _mm256_extract_epi16(header, 14));
+          key.kind = ((all_ones >> shift) & 0x3f) == 0x3f ? FrameClass::Broadcast
+                     : ((group >> shift) & 1) != 0        ? FrameClass::Multicast
+                                                          : FrameClass::Unicast;
+        }
+      }
+
+      if (i < count)
+      {
+        classify_ssse3(frames + i, sizes + i, count - i, keys + i);
+      }
+    }
+#endif  // PROJECT_CLASSIFY_X86
+
+#if PROJECT_CLASSIFY_NEON
+    /**
+     * @brief One frame per iteration: TBL packs both addresses (out-of-range indices give zero)
+     */
+    void classify_neon(const uint8_t* const* frames, const size_t* sizes, size_t count, FrameKeys* keys) noexcept
+    {
+      static const uint8_t pattern[16] = { 5, 4, 3, 2, 1, 0, 0xff, 0xff, 11, 10, 9, 8, 7, 6, 0xff, 0xff };
+      const uint8x16_t pack = vld1q_u8(pattern);
+
+      for (size_t i = 0; i < count; ++i)
+      {
+        if (sizes[i] < VECTOR_LOAD_SIZE)
+        {
+          keys[i] = classify_frame(frames[i], sizes[i]);
+          continue;
+        }
+
+        const uint8x16_t header = vld1q_u8(frames[i]);
+        const uint64x2_t packed = vreinterpretq_u64_u8(vqtbl1q_u8(header, pack));
+        keys[i].dst = vgetq_lane_u64(packed, 0);
+        keys[i].src = vgetq_lane_u64(packed, 1);
+        keys[i].ethertype = static_cast<uint16_t>((vgetq_lane_u8(header, 12) << 8) | vgetq_lane_u8(header, 13));
+        keys[i].kind = kind_of(keys[i].dst);
+      }
+    }
+#endif  // PROJECT_CLASSIFY_NEON
+
+    ClassifyFn implementation(SimdLevel level) noexcept
+    {
+      if (!simd_level_supported(level))
+      {
+        return classify_scalar;
+      }
+
+      switch (level)
+      {
+#if PROJECT_CLASSIFY_X86
+        case SimdLevel::Avx2:
+          return classify_avx2;
+        case SimdLevel::Ssse3:
+          return classify_ssse3;
+#endif
+#if PROJECT_CLASSIFY_NEON
+        case SimdLevel::Neon:
+          return classify_neon;
+#endif
+        default:
+          return classify_scalar;
+      }
+    }
+  }  // namespace
+
+  const char* to_string(SimdLevel level) noexcept
+  {
+    switch (level)
+    {
+      case SimdLevel::Scalar:
+        return "scalar";
+      case SimdLevel::Ssse3:
+        return "ssse3";
+      case SimdLevel::Avx2:
+        return "avx2";
+      case SimdLevel::Neon:
+        return "neon";
+      default:
+        return "unknown";
+    }
+  }
+
+  bool simd_level_supported(SimdLevel level) noexcept
+  {
+    switch (level)
+    {
+      case SimdLevel::Scalar:
+        return true;
+#if PROJECT_CLASSIFY_X86
+      case SimdLevel::Ssse3:
+        return __builtin_cpu_supports("ssse3") != 0;
+      case SimdLevel::Avx2:
+        return __builtin_cpu_supports("avx2") != 0;
+#endif
+#if PROJECT_CLASSIFY_NEON
+      case SimdLevel::Neon:
+        return true;  // Part of the AArch64 base architecture
+#endif
+      default:
+        return false;
+    }
+  }
+
+  SimdLevel detected_simd_level() noexcept
+  {
+    static const SimdLevel level = []() {
+      for (SimdLevel candidate : { SimdLevel::Avx2, SimdLevel::Ssse3, SimdLevel::Neon })
+      {
+        if (simd_level_supported(candidate))
+        {
+          return candidate;
+        }
+      }
+      return SimdLevel::Scalar;
+    }();
+    return level;
+  }
+
+  FrameKeys classify_frame(const uint8_t* frame, size_t size) noexcept
+  {
+    FrameKeys keys;
+    if (frame == nullptr || size < ETHERNET_HEADER_SIZE)
+    {
+      return keys;
+    }
+
+    keys.dst = load_mac(frame);
+    keys.src = load_mac(frame + MAC_ADDRESS_SIZE);
+    keys.ethertype = static_cast<uint16_t>((frame[12] << 8) | frame[13]);
+    keys.kind = kind_of(keys.dst);
+    return keys;
+  }
+
+  void classify_frames(const uint8_t* const* frames, const size_t* sizes, size_t count, FrameKeys* keys) noexcept
+  {
+    static const ClassifyFn classify = implementation(detected_simd_level());
+    classify(frames, sizes, count, keys);
+  }
+
+  void classify_frames(SimdLevel level, const uint8_t* const* frames, const size_t* sizes, size_t count,
+                       FrameKeys* keys) noexcept
+  {
+    implementation(level)(frames, sizes, count, keys);
+  }
+
+}  // namespace project
@@ -0,0 +1,100 @@
+/**
+ * @file frame_coalescing.cpp
+ * @brief Implementation of frame aggregates
+ */
+
+#include "project/frame_coalescing.hpp"
+
+#include <cstring>
+
+namespace project
+{
+  const char* to_string(CoalesceError error) noexcept
+  {
+    switch (error)
+    {
+      case CoalesceError::NotAnAggregate:
+        return "Not a frame aggregate";
+      case CoalesceError::Malformed:
+        return "Malformed frame aggregate";
+      case CoalesceError::TooManyFrames:
+        return "Too many frames in aggregate";
+      default:
+        return "Unknown coalescing error";
+    }
+  }
+
+  expected<size_t, CoalesceError> split_coalesced(const uint8_t* data, size_t size, const uint8_t** frames,
+                                                  size_t* sizes, size_t capacity) noexcept
+  {
+    static constexpr uint8_t NO_ADDRESSES[12] = {};
+    if (size < COALESCE_HEADER_SIZE || std::memcmp(data, NO_ADDRESSES, sizeof(NO_ADDRESSES)) != 0 ||
+        data[12] != (COALESCE_ETHERTYPE >> 8) || data[13] != (COALESCE_ETHERTYPE & 0xff) ||
+        data[14] != COALESCE_VERSION)
+    {
+      return unexpected(CoalesceError::NotAnAggregate);
+    }
+
+    size_t count = 0;
+    size_t offset = COALESCE_HEADER_SIZE;
+    while (offset < size)
+    {
+      if (size - offset < COALESCE_RECORD_HEADER_SIZE)
+      {
+        return unexpected(CoalesceError::Malformed);
+      }
+      const size_t length = size_t{ data[offset] } << 8 | data[offset + 1];
+      offset += COALESCE_RECORD_HEADER_SIZE;
+      if (length == 0 || length > size - offset)
+      {
+        return unexpected(CoalesceError::Malformed);
+      }
+      if (count == capacity || count == COALESCE_MAX_FRAMES)
+      {
+        return unexpected(CoalesceError::TooManyFrames);
+      }
+      frames[count] = data + offset;
+      sizes[count] = length;
+      ++count;
+      offset += length;
+    }
+
+    if (count == 0)
+    {
+      return unexpected(CoalesceError::Malformed);
+    }
+    return count;
+  }
+
+  bool FrameCoalescer::fits(size_t frame_size) const noexcept
+  {
+    const size_t used = size_ == 0 ? COALESCE_HEADER_SIZE : size_;
+    return !full() && frame_size > 0 && frame_size <= 0xffff && used <= capacity_ &&
+           COALESCE_RECORD_HEADER_SIZE + frame_size <= capacity_ - used;
+  }
+
+  bool FrameCoalescer::add(const uint8_t* frame, size_t frame_size) noexcept
+  {
+    if (!fits(frame_size))
+    {
+      return false;
+    }
+
+    if (size_ == 0)
+    {
+      std::memset(out_, 0, 12);
+      out_[12] = COALESCE_ETHERTYPE >> 8;
+      out_[13] = COALESCE_ETHERTYPE & 0xff;
+      out_[14] = COALESCE_VERSION;
+      size_ = COALESCE_HEADER_SIZE;
+    }
+
+    out_[size_] = static_cast<uint8_t>(frame_size >> 8);
+    out_[size_ + 1] = static_cast<uint8_t>(frame_size);
+    std::memcpy(out_ + size_ + COALESCE_RECORD_HEADER_SIZE, frame, frame_size);
+    size_ += COALESCE_RECORD_HEADER_SIZE + frame_size;
+    ++frames_;
+    return true;
+  }
+
+}  // namespace project
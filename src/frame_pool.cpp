@@ -0,0 +1,74 @@
+/**
+ * @file frame_pool.cpp
+ * @brief Implementation of the frame buffer pool
+ */
+
+#include "project/frame_pool.hpp"
+
+namespace project
+{
+  namespace
+  {
+    constexpr size_t CACHE_LINE_SIZE = 64;
+  }  // namespace
+
+  // FrameBuffer implementation
+
+  void FrameBuffer::reset() noexcept
+  {
+    if (pool_ != nullptr && data_ != nullptr)
+    {
+      pool_->recycle(data_);
+    }
+
+    pool_ = nullptr;
+    data_ = nullptr;
+    capacity_ = 0;
+    size_ = 0;
+  }
+
+  // FramePool implementation
+
+  FramePool::FramePool(size_t slot_count, size_t slot_size)
+      : slot_size_((slot_size + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE),
+        slot_count_(slot_count)
+  {
+    // Default-initialized: slots are not zeroed, they are always written before being read
+    storage_.reset(new uint8_t[slot_size_ * slot_count_]);
+
+    free_list_.reserve(slot_count_);
+    for (size_t i = slot_count_; i > 0; --i)
+    {
+      free_list_.push_back(storage_.get() + (i - 1) * slot_size_);
+    }
+  }
+
+  FrameBuffer FramePool::acquire() noexcept
+  {
+    std::lock_guard lock(mutex_);
+
+    if (free_list_.empty())
+    {
+      return FrameBuffer{};
+    }
+
+    uint8_t* slot = free_list_.back();
+    free_list_.pop_back();
+    return FrameBuffer(this, slot, slot_size_);
+  }
+
+  size_t FramePool::available() const noexcept
+  {
+    std::lock_guard lock(mutex_);
+    return free_list_.size();
+  }
+
+  void FramePool::recycle(uint8_t* slot) noexcept
+  {
+    std::lock_guard lock(mutex_);
+
+    // Capacity was reserved for every slot up front, so this never reallocates
+    free_list_.push_back(slot);
+  }
+
+}  // namespace project
@@ -0,0 +1,345 @@
+/**
+ * @file io_uring.cpp
+ * @brief Implementation of the io_uring wrapper
+ */
+
+#include "project/io_uring.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#if PROJECT_HAVE_IO_URING
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace project
+{
+  const char* to_string(IoBackend backend) noexcept
+  {
+    switch (backend)
+    {
+      case IoBackend::Syscalls:
+        return "syscalls";
+      case IoBackend::IoUring:
+        return "io_uring";
+      default:
+        return "unknown";
+    }
+  }
+
+  const char* to_string(IoUringError error) noexcept
+  {
+    switch (error)
+    {
+      case IoUringError::Unsupported:
+        return "io_uring is not supported";
+      case IoUringError::SetupFailed:
+        return "Failed to set up io_uring";
+      case IoUringError::MapFailed:
+        return "Failed to map io_uring queues";
+      case IoUringError::RegisterFailed:
+        return "Failed to register io_uring buffers";
+      case IoUringError::SubmitFailed:
+        return "Failed to submit to io_uring";
+      case IoUringError::InvalidRing:
+        return "Invalid io_uring";
+      default:
+        return "Unknown io_uring error";
+    }
+  }
+
+  bool io_uring_available() noexcept
+  {
+#if PROJECT_HAVE_IO_URING
+    return IoUring::create(2).has_value();
+#else
+    return false;
+#endif
+  }
+
+#if PROJECT_HAVE_IO_URING
+  namespace
+  {
+    int io_uring_setup(unsigned entries, struct io_uring_params* params) noexcept
+    {
+      return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+    }
+
+    int io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags, const void* arg,
+                       size_t arg_size) noexcept
+    {
+      return static_cast<int>(::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, arg_size));
+    }
+
+    int io_uring_register(int fd, unsigned opcode, const void* arg, unsigned count) noexcept
+    {
+      return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, count));
+    }
+
+    template <typename T>
+    T* at_offset(void* base, uint32_t offset) noexcept
+    {
+      return reinterpret_cast<T*>(static_cast<uint8_t*>(base) + offset);
+    }
+  }  // namespace
+
+  expected<IoUring, IoUringError> IoUring::create(unsigned entries)
+  {
+    struct io_uring_params params{};
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = entries * 4;
+
+    FileDescriptor ring_fd(io_uring_setup(entries, &params));
+    if (!ring_fd)
+    {
+      return unexpected(errno == ENOSYS || errno == EPERM ? IoUringError::Unsupported : IoUringError::SetupFailed);
+    }
+
+    // Timed waits need EXT_ARG (5.11); everything newer is probed by the requests themselves
+    if ((params.features & IORING_FEAT_SINGLE_MMAP) == 0 || (params.features & IORING_FEAT_EXT_ARG) == 0)
+    {
+      return unexpected(IoUringError::Unsupported);
+    }
+
+    const size_t sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    const size_t cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    MemoryMapping rings(::mmap(nullptr, std::max(sq_size, cq_size), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                               ring_fd.get(), IORING_OFF_SQ_RING),
+                        std::max(sq_size, cq_size));
+    MemoryMapping sqes(::mmap(nullptr, params.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_POPULATE, ring_fd.get(), IORING_OFF_SQES),
+                       params.sq_entries * sizeof(struct io_uring_sqe));
+    if (!rings || !sqes)
+    {
+      return unexpected(IoUringError::MapFailed);
+    }
+
+    IoUring ring;
+    ring.sq_head_ = at_offset<unsigned>(rings.data(), params.sq_off.head);
+    ring.sq_tail_ = at_offset<unsigned>(rings.data(), params.sq_off.tail);
+    ring.sq_array_ = at_offset<unsigned>(rings.data(), params.sq_off.array);
+    ring.sq_mask_ = *at_offset<unsigned>(rings.data(), params.sq_off.ring_mask);
+    ring.sq_entries_ = params.sq_entries;
+    ring.sqes_ = static_cast<struct io_uring_sqe*>(sqes.data());
+    ring.cq_head_ = at_offset<unsigned>(rings.data(), params.cq_off.head);
+    ring.cq_tail_ = at_offset<unsigned>(rings.data(), params.cq_off.tail);
+    ring.cq_mask_ = *at_offset<unsigned>(rings.data(), params.cq_off.ring_mask);
+    ring.cqes_ = at_offset<struct io_uring_cqe>(rings.data(), params.cq_off.cqes);
+
+    // SQE i always sits in array slot i, so the indirection array is filled once
+    for (unsigned i = 0; i < params.sq_entries; ++i)
+    {
+      ring.sq_array_[i] = i;
+    }
+
+    ring.ring_fd_ = std::move(ring_fd);
+    ring.rings_ = std::move(rings);
+    ring.sqes_mapping_ = std::move(sqes);
+    return ring;
+  }
+
+  io_uring_sqe* IoUring::get_sqe() noexcept
+  {
+    if (!is_valid())
+    {
+      return nullptr;
+    }
+
+    unsigned tail = *sq_tail_;
+    if (tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_)
+    {
+      if (!submit() || *sq_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_)
+      {
+        return nullptr;
+      }
+    }
+
+    io_uring_sqe* sqe = &sqes_[tail & sq_mask_];
+    std::memset(sqe, 0, sizeof(*sqe));
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    ++unsubmitted_;
+    return sqe;
+  }
+
+  expected<unsigned, IoUringError> IoUring::enter(unsigned min_complete, const void* timeout)
+  {
+    if (!is_valid())
+    {
+      return unexpected(IoUringError::InvalidRing);
+    }
+
+    unsigned flags = 0;
+    size_t arg_size = 0;
+    struct io_uring_getevents_arg arg{};
+    if (min_complete > 0)
+    {
+      flags = IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+      arg.ts = reinterpret_cast<uint64_t>(timeout);
+      arg_size = sizeof(arg);
+    }
+
+    int submitted = io_uring_enter(ring_fd_.get(), unsubmitted_, min_complete, flags, min_complete > 0 ? &arg : nullptr,
+                                   arg_size);
+    if (submitted < 0)
+    {
+      // ETIME: the wait timed out; EINTR: a signal; EBUSY/EAGAIN: completions must be reaped first
+      if (errno == ETIME || errno == EINTR || errno == EBUSY || errno == EAGAIN)
+      {
+        return 0u;
+      }
+      return unexpected(IoUringError::SubmitFailed);
+    }
+
+    unsubmitted_ -= std::min(unsubmitted_, static_cast<unsigned>(submitted));
+    return static_cast<unsigned>(submitted);
+  }
+
+  expected<unsigned, IoUringError> IoUring::submit()
+  {
+    if (unsubmitted_ == 0)
+    {
+      return 0u;
+    }
+    return enter(0, nullptr);
+  }
+
+  expected<unsigned, IoUringError> IoUring::submit_and_wait(std::chrono::milliseconds timeout)
+  {
+    const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+    struct __kernel_timespec ts{};
+    ts.tv_sec = seconds.count();
+    ts.tv_nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(timeout - seconds).count();
+    return enter(1, &ts);
+  }
+
+  bool IoUring::cancel_all(uint64_t user_data) noexcept
+  {
+    io_uring_sqe* sqe = get_sqe();
+    if (sqe == nullptr)
+    {
+      return false;
+    }
+
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->cancel_flags = IORING_ASYNC_CANCEL_ANY | IORING_ASYNC_CANCEL_ALL;
+    sqe->user_data = user_data;
+    return true;
+  }
+
+  expected<void, IoUringError> IoUring::register_buffers(const struct iovec* buffers, unsigned count)
+  {
+    if (io_uring_register(ring_fd_.get(), IORING_REGISTER_BUFFERS, buffers, count) < 0)
+    {
+      return unexpected(IoUringError::RegisterFailed);
+    }
+    return expected<void, IoUringError>();
+  }
+
+  expected<IoUringBufferRing, IoUringError> IoUringBufferRing::create(IoUring& ring, uint16_t group, uint16_t count,
+                                                                      size_t buffer_size)
+  {
+    if (count == 0 || count > 32768 || (count & (count - 1)) != 0 || buffer_size == 0)
+    {
+      return unexpected(IoUringError::SetupFailed);
+    }
+
+    IoUringBufferRing buffers;
+    buffers.ring_ = MemoryMapping::anonymous(size_t{ count } * sizeof(struct io_uring_buf));
+    buffers.arena_ = MemoryMapping::anonymous(size_t{ count } * buffer_size);
+    if (!buffers.ring_ || !buffers.arena_)
+    {
+      return unexpected(IoUringError::MapFailed);
+    }
+
+    struct io_uring_buf_reg reg{};
+    reg.ring_addr = reinterpret_cast<uint64_t>(buffers.ring_.data());
+    reg.ring_entries = count;
+    reg.bgid = group;
+    if (io_uring_register(ring.get_fd(), IORING_REGISTER_PBUF_RING, &reg, 1) < 0)
+    {
+      return unexpected(errno == EINVAL ? IoUringError::Unsupported : IoUringError::RegisterFailed);
+    }
+
+    buffers.references_.assign(count, 0);
+    buffers.buffer_size_ = buffer_size;
+    buffers.count_ = count;
+    buffers.group_ = group;
+    for (uint16_t id = 0; id < count; ++id)
+    {
+      buffers.recycle(id);
+    }
+    return buffers;
+  }
+
+  void IoUringBufferRing::recycle(uint16_t id) noexcept
+  {
+    // Not via struct io_uring_buf_ring: its flexible array member is laid out differently in C++
+    auto* entries = static_cast<struct io_uring_buf*>(ring_.data());
+    struct io_uring_buf& entry = entries[tail_ & (count_ - 1)];
+    entry.addr = reinterpret_cast<uint64_t>(buffer(id));
+    entry.len = static_cast<uint32_t>(buffer_size_);
+    entry.bid = id;
+
+    // The ring tail overlays the first entry's resv field; publish the entry before it
+    ++tail_;
+    __atomic_store_n(&entries[0].resv, tail_, __ATOMIC_RELEASE);
+  }
+
+  IoUringSendSlots::IoUringSendSlots(uint32_t count) : slots_(count)
+  {
+    free_.reserve(count);
+    for (uint32_t i = count; i > 0; --i)
+    {
+      free_.push_back(i - 1);
+    }
+  }
+
+  uint32_t IoUringSendSlots::acquire(const uint8_t* data, size_t size, const Endpoint& destination,
+                                     uint16_t buffer_id) noexcept
+  {
+    OutboundDatagram datagram;
+    datagram.data = data;
+    datagram.size = size;
+    datagram.destination = destination;
+    return acquire(datagram, buffer_id);
+  }
+
+  uint32_t IoUringSendSlots::acquire(const OutboundDatagram& datagram, uint16_t buffer_id) noexcept
+  {
+    if (free_.empty())
+    {
+      return NONE;
+    }
+
+    uint32_t index = free_.back();
+    free_.pop_back();
+
+    IoUringSendSlot& slot = slots_[index];
+    slot.destination = datagram.destination;
+    slot.buffer_id = buffer_id;
+    const size_t iov_count = datagram.to_iovecs(slot.iov.data());
+
+    // The spliced bytes live in the datagram, which goes away before the send completes
+    slot.splice = datagram.splice_bytes;
+    for (size_t i = 0; i < iov_count; ++i)
+    {
+      if (slot.iov[i].iov_base == datagram.splice_bytes.data())
+      {
+        slot.iov[i].iov_base = slot.splice.data();
+      }
+    }
+
+    slot.message = {};
+    slot.message.msg_name = slot.destination.as_sockaddr();
+    slot.message.msg_namelen = slot.destination.sockaddr_size();
+    slot.message.msg_iov = slot.iov.data();
+    slot.message.msg_iovlen = iov_count;
+    return index;
+  }
+#endif  // PROJECT_HAVE_IO_URING
+
+}  // namespace project
@@ -0,0 +1,144 @@
+/**
+ * @file latency_histogram.cpp
+ * @brief Implementation of latency histograms
+ */
+
+#include "project/latency_histogram.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include <utility>
+
+namespace project
+{
+  double latency_ns_per_tick()
+  {
+#if defined(__x86_64__) || defined(__i386__)
+    static const double ns_per_tick = []() {
+      auto start_time = std::chrono::steady_clock::now();
+      uint64_t start_ticks = latency_clock_ticks();
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      uint64_t end_ticks = latency_clock_ticks();
+      auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start_time);
+
+      uint64_t ticks = end_ticks - start_ticks;
+      return ticks > 0 ? elapsed.count() / static_cast<double>(ticks) : 1.0;
+    }();
+    return ns_per_tick;
+#else
+    return 1.0;
+#endif
+  }
+
+  LatencySnapshot& LatencySnapshot::operator+=(const LatencySnapshot& other)
+  {
+    if (other.counts.empty())
+    {
+      return *this;
+    }
+
+    counts.resize(LATENCY_BUCKET_COUNT, 0);
+    for (size_t i = 0; i < other.counts.size(); ++i)
+    {
+      counts[i] += other.counts[i];
+    }
+    count += other.count;
+    return *this;
+  }
+
+  uint64_t LatencySnapshot::percentile_ticks(double percentile) const noexcept
+  {
+    if (count == 0)
+    {
+      return 0;
+    }
+
+    // Rank of the sample at this percentile, 1-based
+    double fraction = std::clamp(percentile, 0.0, 100.0) / 100.0;
+    auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(count))));
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); ++i)
+    {
+      seen += counts[i];
+      if (seen >= rank)
+      {
+        return latency_bucket_upper_bound(i);
+      }
+    }
+    return latency_bucket_upper_bound(counts.size() - 1);
+  }
+
+  uint64_t LatencySnapshot::percentile_ns(double percentile) const
+  {
+    const uint64_t ticks = percentile_ticks(percentile);
+    return static_cast<uint64_t>(static_cast<double>(ticks) * latency_ns_per_tick());
+  }
+
+  LatencyHistogram::LatencyHistogram() : counts_(new std::atomic<uint64_t>[LATENCY_BUCKET_COUNT]())
+  {
+  }
+
+  LatencyHistogram::LatencyHistogram(const LatencyHistogram& other) : LatencyHistogram()
+  {
+    *this = other;
+  }
+
+  LatencyHistogram& LatencyHistogram::operator=(const LatencyHistogram& other)
+  {
+    if (this != &other)
+    {
+      for (size_t i = 0; i < LATENCY_BUCKET_COUNT; ++i)
+      {
+        counts_[i].store(other.counts_[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+      }
+    }
+    return *this;
+  }
+
+  LatencySnapshot LatencyHistogram::snapshot() const
+  {
+    LatencySnapshot result;
+    result.counts.resize(LATENCY_BUCKET_COUNT);
+    for (size_t i = 0; i < LATENCY_BUCKET_COUNT; ++i)
+    {
+      result.counts[i] = counts_[i].load(std::memory_order_relaxed);
+      result.count += result.counts[i];
+    }
+    return result;
+  }
+
+  std::string format_prometheus_latency(std::string_view prefix,
+                                        const std::vector<std::pair<std::string, LatencySnapshot>>& series)
+  {
+    static constexpr std::pair<const char*, double> QUANTILES[] = {
+      { "0.5", 50.0 }, { "0.9", 90.0 }, { "0.99", 99.0 }, { "0.999", 99.9 }
+    };
+
+    const std::string name = std::string(prefix) + "_latency_seconds";
+    std::string out = "# HELP " + name + " Receive-to-send latency of forwarded frames\n";
+    out += "# TYPE " + name + " summary\n";
+
+    for (const auto& [labels, snapshot] : series)
+    {
+      const std::string separator = labels.empty() ? "" : ",";
+      for (const auto& [quantile, percentile] : QUANTILES)
+      {
+        char value[32];
+        std::snprintf(value, sizeof(value), "%.9f", static_cast<double>(snapshot.percentile_ns(percentile)) / 1e9);
+        out += name + "{" + labels + separator + "quantile=\"" + quantile + "\"} " + value + "\n";
+      }
+      out += name + "_count";
+      if (!labels.empty())
+      {
+        out += "{" + labels + "}";
+      }
+      out += " " + std::to_string(snapshot.count) + "\n";
+    }
+    return out;
+  }
+
+}  // namespace project
@@ -0,0 +1,531 @@
+/**
+ * @file load_generator.cpp
+ * @brief Implementation of the RFC 2544 load generator
+ */
+
+#include "project/load_generator.hpp"
+
+#include "project/frame_pool.hpp"
+#include "project/joining_thread.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <thread>
+
+#include <poll.h>
+
+namespace project
+{
+  namespace
+  {
+    /**
+     * @brief Upper 24 bits of every emulated MAC (locally administered, 02:4c:47 "LG")
+     */
+    constexpr uint64_t LOADGEN_MAC_PREFIX = 0x024C47000000ull;
+
+    /**
+     * @brief Host part no emulated MAC uses; learning frames are sent to it
+     */
+    constexpr uint64_t LOADGEN_SINK_HOST = 0xffffff;
+
+    /**
+     * @brief Marks a payload as a test frame
+     */
+    constexpr uint32_t SIGNATURE_MAGIC = 0x32353434;  // "2544"
+
+    /**
+     * @brief Test frame payload: magic, trial, sequence number, send timestamp
+     */
+    constexpr size_t SIGNATURE_SIZE = 4 + 4 + 8 + 8;
+
+    static_assert(ETHERNET_HEADER_SIZE + SIGNATURE_SIZE + ETHERNET_FCS_SIZE <= LOADGEN_MIN_FRAME_SIZE,
+                  "The signature must fit in a minimum-size frame");
+
+    /**
+     * @brief How often an idle receiver re-checks its stop flag
+     */
+    constexpr int RECEIVE_POLL_TIMEOUT_MS = 10;
+
+    /**
+     * @brief Socket receive buffer requested for each port
+     */
+    constexpr size_t PORT_RECEIVE_BUFFER_SIZE = 4 * 1024 * 1024;
+
+    /**
+     * @brief What the receiving thread of one trial counted
+     */
+    struct ReceiveState
+    {
+      std::atomic<bool> stop{ false };
+      bool failed = false;
+      uint64_t received = 0;
+      uint64_t misdelivered = 0;
+      LatencyHistogram latency;
+    };
+
+    void write_header(uint8_t* frame, MacAddress dst, MacAddress src) noexcept
+    {
+      std::memcpy(frame, dst.data(), MAC_ADDRESS_SIZE);
+      std::memcpy(frame + MAC_ADDRESS_SIZE, src.data(), MAC_ADDRESS_SIZE);
+      frame[2 * MAC_ADDRESS_SIZE] = static_cast<uint8_t>(LOADGEN_ETHERTYPE >> 8);
+      frame[2 * MAC_ADDRESS_SIZE + 1] = static_cast<uint8_t>(LOADGEN_ETHERTYPE & 0xff);
+    }
+
+    // The signature never leaves the host that wrote it, so it stays in host byte order
+    void write_signature(uint8_t* frame, uint32_t trial, uint64_t sequence) noexcept
+    {
+      uint8_t* signature = frame + ETHERNET_HEADER_SIZE;
+      uint64_t ticks = latency_clock_ticks();
+      std::memcpy(signature, &SIGNATURE_MAGIC, 4);
+      std::memcpy(signature + 4, &trial, 4);
+      std::memcpy(signature + 8, &sequence, 8);
+      std::memcpy(signature + 16, &ticks, 8);
+    }
+
+    /**
+     * @brief Count one received datagram against the running trial
+     */
+    void classify(const InboundDatagram& datagram, size_t port, size_t macs_per_port, uint32_t trial,
+                  uint64_t now, ReceiveState& state) noexcept
+    {
+      if (datagram.truncated || datagram.size < ETHERNET_HEADER_SIZE + SIGNATURE_SIZE)
+      {
+        return;
+      }
+
+      EthernetFrameView frame(datagram.data, datagram.size);
+      if (frame.ethertype() != LOADGEN_ETHERTYPE)
+      {
+        return;
+      }
+
+      const uint8_t* signature = frame.data() + ETHERNET_HEADER_SIZE;
+      uint32_t magic;
+      uint32_t frame_trial;
+      uint64_t sent_ticks;
+      std::memcpy(&magic, signature, 4);
+      std::memcpy(&frame_trial, signature + 4, 4);
+      std::memcpy(&sent_ticks, signature + 16, 8);
+      if (magic != SIGNATURE_MAGIC || frame_trial != trial)
+      {
+        return;  // Stray traffic or a late frame from an earlier trial
+      }
+
+      const uint64_t dst = frame.dst_mac().to_u64();
+      if ((dst & ~LOADGEN_SINK_HOST) != LOADGEN_MAC_PREFIX || (dst & LOADGEN_SINK_HOST) / macs_per_port != port)
+      {
+        ++state.misdelivered;
+        return;
+      }
+
+      ++state.received;
+      state.latency.record(now > sent_ticks ? now - sent_ticks : 0);
+    }
+
+    /**
+     * @brief Receive on every port until told to stop
+     */
+    void receive_loop(std::vector<UdpSocket>& ports, size_t macs_per_port, uint32_t trial, ReceiveState& state)
+    {
+      std::vector<struct pollfd> fds(ports.size());
+      for (size_t i = 0; i < ports.size(); ++i)
+      {
+        fds[i].fd = ports[i].get_fd();
+        fds[i].events = POLLIN;
+      }
+
+      std::vector<uint8_t> storage(UDP_MAX_BATCH_SIZE * FRAME_BUFFER_SIZE);
+      std::vector<InboundDatagram> rx(UDP_MAX_BATCH_SIZE);
+      for (size_t i = 0; i < rx.size(); ++i)
+      {
+        rx[i].data = storage.data() + i * FRAME_BUFFER_SIZE;
+        rx[i].capacity = FRAME_BUFFER_SIZE;
+      }
+
+      while (!state.stop.load(std::memory_order_acquire))
+      {
+        int ready = ::poll(fds.data(), fds.size(), RECEIVE_POLL_TIMEOUT_MS);
+        if (ready < 0)
+        {
+          if (errno == EINTR)
+          {
+            continue;
+          }
+          state.failed = true;
+          return;
+        }
+
+        for (size_t i = 0; i < fds.size() && ready > 0; ++i)
+        {
+          if ((fds[i].revents & POLLIN) == 0)
+          {
+            continue;
+          }
+          --ready;
+
+          auto result = ports[i].receive_batch(rx);
+          if (!result)
+          {
+            continue;
+          }
+
+          const uint64_t now = latency_clock_ticks();
+          for (size_t j = 0; j < *result; ++j)
+          {
+            classify(rx[j], i, macs_per_port, trial, now, state);
+          }
+        }
+      }
+    }
+  }  // namespace
+
+  const char* to_string(LoadgenError error) noexcept
+  {
+    switch (error)
+    {
+      case LoadgenError::InvalidConfig:
+        return "Invalid load generator configuration";
+      case LoadgenError::InvalidFrameSize:
+        return "Frame size out of range";
+      case LoadgenError::SocketCreationFailed:
+        return "Failed to create socket";
+      case LoadgenError::BindFailed:
+        return "Failed to bind socket";
+      case LoadgenError::ReceiveFailed:
+        return "Failed to receive test frames";
+      default:
+        return "Unknown load generator error";
+    }
+  }
+
+  double TrialResult::loss_ratio() const noexcept
+  {
+    if (frames_sent == 0 || frames_received >= frames_sent)
+    {
+      return 0.0;
+    }
+    return static_cast<double>(frames_sent - frames_received) / static_cast<double>(frames_sent);
+  }
+
+  double TrialResult::achieved_rate() const noexcept
+  {
+    if (send_time.count() <= 0)
+    {
+      return 0.0;
+    }
+    return static_cast<double>(frames_sent) * 1e9 / static_cast<double>(send_time.count());
+  }
+
+  bool TrialResult::passed(double loss_tolerance) const noexcept
+  {
+    return frames_sent > 0 && loss_ratio() <= loss_tolerance;
+  }
+
+  double BackToBackResult::mean() const noexcept
+  {
+    if (bursts.empty())
+    {
+      return 0.0;
+    }
+
+    double sum = 0.0;
+    for (uint64_t burst : bursts)
+    {
+      sum += static_cast<double>(burst);
+    }
+    return sum / static_cast<double>(bursts.size());
+  }
+
+  expected<LoadGenerator, LoadgenError> LoadGenerator::create(const LoadgenConfig& config)
+  {
+    if (!config.vswitch.is_valid() || config.ports < 2 || config.ports % 2 != 0 || config.macs_per_port == 0 ||
+        config.ports > LOADGEN_SINK_HOST / config.macs_per_port || !(config.max_rate > 0.0) ||
+        config.trial_duration.count() <= 0 || config.loss_tolerance < 0.0 || !(config.resolution > 0.0))
+    {
+      return unexpected(LoadgenError::InvalidConfig);
+    }
+
+    LoadgenConfig clamped = config;
+    clamped.batch_size = std::clamp(config.batch_size, size_t{ 1 }, UDP_MAX_BATCH_SIZE);
+
+    std::vector<UdpSocket> ports;
+    ports.reserve(config.ports);
+    for (size_t i = 0; i < config.ports; ++i)
+    {
+      auto socket_result = UdpSocket::create();
+      if (!socket_result)
+      {
+        return unexpected(LoadgenError::SocketCreationFailed);
+      }
+
+      UdpSocket socket = std::move(*socket_result);
+
+      // Best effort: a larger buffer keeps the generator's own sockets from dropping bursts
+      [[maybe_unused]] auto buffer_result = socket.set_receive_buffer_size(PORT_RECEIVE_BUFFER_SIZE);
+
+      if (!socket.bind(config.bind_address, 0))
+      {
+        return unexpected(LoadgenError::BindFailed);
+      }
+
+      ports.push_back(std::move(socket));
+    }
+
+    return LoadGenerator(clamped, std::move(ports));
+  }
+
+  MacAddress LoadGenerator::mac_address(size_t port, size_t host) const noexcept
+  {
+    return MacAddress::from_u64(LOADGEN_MAC_PREFIX | (port * config_.macs_per_port + host));
+  }
+
+  void LoadGenerator::learn()
+  {
+    const MacAddress sink = MacAddress::from_u64(LOADGEN_MAC_PREFIX | LOADGEN_SINK_HOST);
+    const size_t datagram_size = LOADGEN_MIN_FRAME_SIZE - ETHERNET_FCS_SIZE;
+
+    std::vector<uint8_t> storage(config_.batch_size * datagram_size, 0);
+    std::vector<OutboundDatagram> tx(config_.batch_size);
+    for (size_t port = 0; port < ports_.size(); ++port)
+    {
+      for (size_t host = 0; host < config_.macs_per_port;)
+      {
+        size_t count = std::min(config_.batch_size, config_.macs_per_port - host);
+        for (size_t i = 0; i < count; ++i, ++host)
+        {
+          uint8_t* frame = storage.data() + i * datagram_size;
+          write_header(frame, sink, mac_address(port, host));
+          tx[i] = OutboundDatagram{ frame, datagram_size, config_.vswitch };
+        }
+        [[maybe_unused]] auto sent = ports_[port].send_batch(tx.data(), count);
+      }
+    }
+  }
+
+  expected<TrialResult, LoadgenError> LoadGenerator::run_trial(size_t frame_size, double rate, uint64_t frame_count)
+  {
+    if (frame_size < LOADGEN_MIN_FRAME_SIZE || frame_size > LOADGEN_MAX_FRAME_SIZE)
+    {
+      return unexpected(LoadgenError::InvalidFrameSize);
+    }
+
+    learn();
+    std::this_thread::sleep_for(config_.learning_time);
+
+    const uint32_t trial = next_trial_++;
+    const size_t datagram_size = frame_size - ETHERNET_FCS_SIZE;
+    const size_t batch_size = config_.batch_size;
+
+    // Payload bytes past the signature never change, so fill them once
+    std::vector<uint8_t> storage(batch_size * datagram_size, 0x5a);
+    std::vector<OutboundDatagram> tx(batch_size);
+    for (size_t i = 0; i < batch_size; ++i)
+    {
+      tx[i] = OutboundDatagram{ storage.data() + i * datagram_size, datagram_size, config_.vswitch };
+    }
+
+    ReceiveState state;
+    joining_thread receiver(receive_loop, std::ref(ports_), config_.macs_per_port, trial, std::ref(state));
+
+    TrialResult result;
+    result.frame_size = frame_size;
+    result.offered_rate = rate;
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto deadline = start + config_.trial_duration;
+    const double ns_per_frame = rate > 0.0 ? 1e9 / rate : 0.0;
+
+    uint64_t sequence = 0;
+    size_t port = 0;
+    size_t host = 0;
+    auto last_send = start;
+    while (frame_count == 0 || sequence < frame_count)
+    {
+      const auto now = std::chrono::steady_clock::now();
+      if (frame_count == 0 && now >= deadline)
+      {
+        break;
+      }
+
+      size_t count = batch_size;
+      if (frame_count != 0)
+      {
+        count = static_cast<size_t>(std::min<uint64_t>(count, frame_count - sequence));
+      }
+
+      if (rate > 0.0)
+      {
+        // Frames due by now on an evenly spaced schedule, counting the one at t=0
+        const double elapsed_ns = static_cast<double>((now - start).count());
+        const auto due = static_cast<uint64_t>(elapsed_ns / ns_per_frame) + 1;
+        if (due <= sequence)
+        {
+          // Ahead of schedule; sleep rather than spin so a co-located switch keeps its CPU
+          const auto next_due = start + std::chrono::nanoseconds(static_cast<int64_t>(
+                                            static_cast<double>(sequence) * ns_per_frame));
+          if (next_due - now > std::chrono::microseconds(50))
+          {
+            std::this_thread::sleep_until(next_due);
+          }
+          else
+          {
+            std::this_thread::yield();
+          }
+          continue;
+        }
+        count = static_cast<size_t>(std::min<uint64_t>(count, due - sequence));
+      }
+
+      // Consecutive hosts of one port talk to the same hosts of its peer
+      for (size_t i = 0; i < count; ++i)
+      {
+        uint8_t* frame = storage.data() + i * datagram_size;
+        write_header(frame, mac_address(port ^ 1, host), mac_address(port, host));
+        write_signature(frame, trial, sequence++);
+        host = host + 1 < config_.macs_per_port ? host + 1 : 0;
+      }
+
+      auto sent = ports_[port].send_batch(tx.data(), count);
+      if (sent)
+      {
+        result.frames_sent += *sent;
+      }
+      last_send = std::chrono::steady_clock::now();
+      port = port + 1 < ports_.size() ? port + 1 : 0;
+    }
+    result.send_time = std::chrono::duration_cast<std::chrono::nanoseconds>(last_send - start);
+
+    std::this_thread::sleep_for(config_.drain_time);
+    state.stop.store(true, std::memory_order_release);
+    receiver.join();
+
+    if (state.failed)
+    {
+      return unexpected(LoadgenError::ReceiveFailed);
+    }
+
+    result.frames_received = state.received;
+    result.frames_misdelivered = state.misdelivered;
+    result.latency = state.latency.snapshot();
+    return result;
+  }
+
+  expected<TrialResult, LoadgenError> LoadGenerator::throughput(size_t frame_size)
+  {
+    auto trial = run_trial(frame_size, config_.max_rate);
+    if (!trial || trial->passed(config_.loss_tolerance))
+    {
+      return trial;
+    }
+
+    TrialResult best = *trial;
+    bool found = false;
+    double low = 0.0;
+    double high = config_.max_rate;
+    while (high - low > config_.resolution * config_.max_rate)
+    {
+      const double rate = (low + high) / 2.0;
+      trial = run_trial(frame_size, rate);
+      if (!trial)
+      {
+        return trial;
+      }
+
+      if (trial->passed(config_.loss_tolerance))
+      {
+        low = rate;
+        best = *trial;
+        found = true;
+      }
+      else
+      {
+        high = rate;
+        if (!found)
+        {
+          best = *trial;
+        }
+      }
+    }
+
+    return best;
+  }
+
+  expected<TrialResult, LoadgenError> LoadGenerator::latency(size_t frame_size, double rate)
+  {
+    return run_trial(frame_size, rate);
+  }
+
+  expected<std::vector<TrialResult>, LoadgenError> LoadGenerator::frame_loss(size_t frame_size)
+  {
+    std::vector<TrialResult> trials;
+    size_t clean_in_a_row = 0;
+    for (int tenths = 10; tenths > 0 && clean_in_a_row < 2; --tenths)
+    {
+      auto trial = run_trial(frame_size, config_.max_rate * tenths / 10.0);
+      if (!trial)
+      {
+        return unexpected(trial.error());
+      }
+
+      clean_in_a_row = trial->passed(0.0) ? clean_in_a_row + 1 : 0;
+      trials.push_back(std::move(*trial));
+    }
+
+    return trials;
+  }
+
+  expected<BackToBackResult, LoadgenError> LoadGenerator::back_to_back(size_t frame_size)
+  {
+    uint64_t max_frames = config_.back_to_back_max_frames;
+    if (max_frames == 0)
+    {
+      const double seconds = static_cast<double>(config_.trial_duration.count()) / 1000.0;
+      max_frames = std::max<uint64_t>(1, static_cast<uint64_t>(config_.max_rate * seconds));
+    }
+    const uint64_t resolution = std::max<uint64_t>(1, max_frames / 100);
+
+    BackToBackResult result;
+    result.frame_size = frame_size;
+    for (size_t repetition = 0; repetition < config_.back_to_back_trials; ++repetition)
+    {
+      auto trial = run_trial(frame_size, 0.0, max_frames);
+      if (!trial)
+      {
+        return unexpected(trial.error());
+      }
+
+      uint64_t low = 0;
+      uint64_t high = max_frames;
+      if (trial->passed(config_.loss_tolerance))
+      {
+        low = max_frames;
+      }
+
+      while (high - low > resolution)
+      {
+        const uint64_t burst = low + (high - low) / 2;
+        trial = run_trial(frame_size, 0.0, burst);
+        if (!trial)
+        {
+          return unexpected(trial.error());
+        }
+
+        if (trial->passed(config_.loss_tolerance))
+        {
+          low = burst;
+        }
+        else
+        {
+          high = burst;
+        }
+      }
+
+      result.bursts.push_back(low);
+    }
+
+    return result;
+  }
+
+}  // namespace project
@@ -0,0 +1,458 @@
+/**
+ * @file loadgen_main.cpp
+ * @brief RFC 2544 load generator for qualifying a VSwitch
+ *
+ * Emulates many VPorts and MACs on UDP sockets and runs the RFC 2544
+ * throughput, latency, frame loss and back-to-back benchmarks against a
+ * VSwitch, either a remote one or one started in-process on loopback.
+ *
+ * Usage: loadgen (<vswitch_ip> <vswitch_port> | --loopback) [options]
+ */
+
+#include "project/joining_thread.hpp"
+#include "project/load_generator.hpp"
+#include "project/logger.hpp"
+#include "project/vswitch.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+  /**
+   * @brief Which benchmarks to run
+   */
+  struct TestSelection
+  {
+    bool throughput = false;
+    bool latency = false;
+    bool frame_loss = false;
+    bool back_to_back = false;
+  };
+
+  /**
+   * @brief Print usage information
+   */
+  void print_usage(const char* program_name)
+  {
+    std::cerr << "Usage: " << program_name << " (<vswitch_ip> <vswitch_port> | --loopback) [options]\n";
+    std::cerr << "\n";
+    std::cerr << "Options:\n";
+    std::cerr << "  --loopback         Test a VSwitch started in this process on 127.0.0.1\n";
+    std::cerr << "  --workers N        Worker threads of the --loopback switch (default 1)\n";
+    std::cerr << "  --bind ADDR        Local address of the emulated ports (default 127.0.0.1)\n";
+    std::cerr << "  --ports N          Emulated VPorts, one socket each; even (default 2)\n";
+    std::cerr << "  --macs-per-port N  MAC addresses behind each port (default 1)\n";
+    std::cerr << "  --rate FPS         Frames per second that count as 100% load (default 100000)\n";
+    std::cerr << "  --duration MS      Length of each trial (default 2000; RFC 2544 wants 60000)\n";
+    std::cerr << "  --drain MS         Receive time after each trial (default 500; RFC 2544 wants 2000)\n";
+    std::cerr << "  --batch N          Frames per send syscall (default 32)\n";
+    std::cerr << "  --loss-tolerance P Percentage of frames a trial may lose and pass (default 0)\n";
+    std::cerr << "  --b2b-trials N     Back-to-back repetitions (default 5; RFC 2544 wants 50)\n";
+    std::cerr << "  --sizes LIST       Comma-separated frame sizes, FCS included (default 64,128,256,512,1024,1280,1518)\n";
+    std::cerr << "  --tests LIST       Any of throughput,latency,loss,b2b (default all)\n";
+    std::cerr << "\n";
+    std::cerr << "Examples:\n";
+    std::cerr << "  " << program_name << " --loopback --sizes 64,1518 --duration 1000\n";
+    std::cerr << "  " << program_name << " 192.0.2.10 8080 --ports 1000 --macs-per-port 4 --rate 1000000\n";
+  }
+
+  /**
+   * @brief Parse a decimal integer within [min, max]
+   */
+  std::optional<long> parse_long(const char* text, long min, long max)
+  {
+    char* endptr;
+    long value = std::strtol(text, &endptr, 10);
+    if (*text == '\0' || *endptr != '\0' || value < min || value > max)
+    {
+      return std::nullopt;
+    }
+    return value;
+  }
+
+  /**
+   * @brief Parse a non-negative decimal number
+   */
+  std::optional<double> parse_double(const char* text)
+  {
+    char* endptr;
+    double value = std::strtod(text, &endptr);
+    if (*text == '\0' || *endptr != '\0' || !(value >= 0.0))
+    {
+      return std::nullopt;
+    }
+    return value;
+  }
+
+  /**
+   * @brief Split a comma-separated list
+   */
+  std::vector<std::string> split(const char* text)
+  {
+    std::vector<std::string> items;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ','))
+    {
+      items.push_back(item);
+    }
+    return items;
+  }
+
+  double microseconds(uint64_t ns)
+  {
+    return static_cast<double>(ns) / 1000.0;
+  }
+
+  void print_trial_header()
+  {
+    std::cout << std::setw(6) << "size" << std::setw(14) << "offered fps" << std::setw(14) << "sent fps"
+              << std::setw(12) << "sent" << std::setw(12) << "received" << std::setw(10) << "loss %" << "\n";
+  }
+
+  void print_trial(const project::TrialResult& trial)
+  {
+    std::cout << std::setw(6) << trial.frame_size << std::setw(14) << std::fixed << std::setprecision(0)
+              << trial.offered_rate << std::setw(14) << trial.achieved_rate() << std::setw(12) << trial.frames_sent
+              << std::setw(12) << trial.frames_received << std::setw(10) << std::setprecision(3)
+              << trial.loss_ratio() * 100.0;
+    if (trial.frames_misdelivered != 0)
+    {
+      std::cout << "  (" << trial.frames_misdelivered << " misdelivered)";
+    }
+    std::cout << "\n";
+  }
+
+  void print_latency_header()
+  {
+    std::cout << std::setw(6) << "size" << std::setw(14) << "offered fps" << std::setw(12) << "p50 us"
+              << std::setw(12) << "p90 us" << std::setw(12) << "p99 us" << std::setw(12) << "p99.9 us"
+              << std::setw(12) << "max us" << "\n";
+  }
+
+  void print_latency(const project::TrialResult& trial)
+  {
+    const project::LatencySnapshot& latency = trial.latency;
+    std::cout << std::setw(6) << trial.frame_size << std::setw(14) << std::fixed << std::setprecision(0)
+              << trial.offered_rate << std::setprecision(1);
+    for (double percentile : { 50.0, 90.0, 99.0, 99.9, 100.0 })
+    {
+      std::cout << std::setw(12) << microseconds(latency.percentile_ns(percentile));
+    }
+    std::cout << "\n";
+  }
+
+  /**
+   * @brief Run the selected benchmarks for one frame size
+   * @return false if a trial could not be run
+   */
+  bool run_frame_size(project::LoadGenerator& generator, size_t frame_size, const TestSelection& tests)
+  {
+    double latency_rate = generator.config().max_rate;
+
+    if (tests.throughput)
+    {
+      std::cout << "\n--- Throughput, " << frame_size << "-byte frames ---\n";
+      auto trial = generator.throughput(frame_size);
+      if (!trial)
+      {
+        std::cerr << "Error: " << project::to_string(trial.error()) << "\n";
+        return false;
+      }
+      print_trial_header();
+      print_trial(*trial);
+      if (trial->passed(generator.config().loss_tolerance))
+      {
+        latency_rate = trial->offered_rate;
+      }
+      else
+      {
+        std::cout << "No rate passed; the latency test runs at the full rate.\n";
+      }
+    }
+
+    if (tests.latency)
+    {
+      std::cout << "\n--- Latency, " << frame_size << "-byte frames ---\n";
+      auto trial = generator.latency(frame_size, latency_rate);
+      if (!trial)
+      {
+        std::cerr << "Error: " << project::to_string(trial.error()) << "\n";
+        return false;
+      }
+      print_latency_header();
+      print_latency(*trial);
+    }
+
+    if (tests.frame_loss)
+    {
+      std::cout << "\n--- Frame loss rate, " << frame_size << "-byte frames ---\n";
+      auto trials = generator.frame_loss(frame_size);
+      if (!trials)
+      {
+        std::cerr << "Error: " << project::to_string(trials.error()) << "\n";
+        return false;
+      }
+      print_trial_header();
+      for (const auto& trial : *trials)
+      {
+        print_trial(trial);
+      }
+    }
+
+    if (tests.back_to_back)
+    {
+      std::cout << "\n--- Back-to-back, " << frame_size << "-byte frames ---\n";
+      auto result = generator.back_to_back(frame_size);
+      if (!result)
+      {
+        std::cerr << "Error: " << project::to_string(result.error()) << "\n";
+        return false;
+      }
+      std::cout << "Longest loss-free bursts:";
+      for (uint64_t burst : result->bursts)
+      {
+        std::cout << " " << burst;
+      }
+      std::cout << "\nMean: " << std::fixed << std::setprecision(1) << result->mean() << " frames\n";
+    }
+
+    return true;
+  }
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  std::cout << "=== Loadgen - RFC 2544 benchmarks for VSwitch ===\n\n";
+
+  if (argc < 2)
+  {
+    print_usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  project::LoadgenConfig config;
+  std::vector<size_t> frame_sizes(std::begin(project::RFC2544_FRAME_SIZES), std::end(project::RFC2544_FRAME_SIZES));
+  TestSelection tests{ true, true, true, true };
+  bool loopback = false;
+  size_t loopback_workers = 1;
+
+  int first_option = 1;
+  if (std::strcmp(argv[1], "--loopback") == 0)
+  {
+    loopback = true;
+    first_option = 2;
+  }
+  else
+  {
+    if (argc < 3)
+    {
+      print_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+
+    auto port = parse_long(argv[2], 1, 65535);
+    if (!port)
+    {
+      std::cerr << "Error: Invalid port number '" << argv[2] << "'\n";
+      return EXIT_FAILURE;
+    }
+    config.vswitch = project::Endpoint(argv[1], static_cast<uint16_t>(*port));
+    if (!config.vswitch.is_valid())
+    {
+      std::cerr << "Error: Invalid VSwitch address '" << argv[1] << "'\n";
+      return EXIT_FAILURE;
+    }
+    first_option = 3;
+  }
+
+  for (int i = first_option; i < argc; ++i)
+  {
+    const char* option = argv[i];
+    const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (value == nullptr)
+    {
+      print_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+    ++i;
+
+    bool valid = true;
+    if (std::strcmp(option, "--workers") == 0)
+    {
+      auto workers = parse_long(value, 1, 1024);
+      valid = workers.has_value();
+      loopback_workers = valid ? static_cast<size_t>(*workers) : 0;
+    }
+    else if (std::strcmp(option, "--bind") == 0)
+    {
+      config.bind_address = value;
+    }
+    else if (std::strcmp(option, "--ports") == 0)
+    {
+      auto ports = parse_long(value, 2, 65536);
+      valid = ports.has_value() && *ports % 2 == 0;
+      config.ports = valid ? static_cast<size_t>(*ports) : 0;
+    }
+    else if (std::strcmp(option, "--macs-per-port") == 0)
+    {
+      auto macs = parse_long(value, 1, 65536);
+      valid = macs.has_value();
+      config.macs_per_port = valid ? static_cast<size_t>(*macs) : 0;
+    }
+    else if (std::strcmp(option, "--rate") == 0)
+    {
+      auto rate = parse_double(value);
+      valid = rate.has_value() && *rate > 0.0;
+      config.max_rate = valid ? *rate : 0.0;
+    }
+    else if (std::strcmp(option, "--duration") == 0)
+    {
+      auto duration = parse_long(value, 1, 3600000);
+      valid = duration.has_value();
+      config.trial_duration = std::chrono::milliseconds(valid ? *duration : 0);
+    }
+    else if (std::strcmp(option, "--drain") == 0)
+    {
+      auto drain = parse_long(value, 0, 60000);
+      valid = drain.has_value();
+      config.drain_time = std::chrono::milliseconds(valid ? *drain : 0);
+    }
+    else if (std::strcmp(option, "--batch") == 0)
+    {
+      auto batch = parse_long(value, 1, static_cast<long>(project::UDP_MAX_BATCH_SIZE));
+      valid = batch.has_value();
+      config.batch_size = valid ? static_cast<size_t>(*batch) : 0;
+    }
+    else if (std::strcmp(option, "--loss-tolerance") == 0)
+    {
+      auto percent = parse_double(value);
+      valid = percent.has_value() && *percent <= 100.0;
+      config.loss_tolerance = valid ? *percent / 100.0 : 0.0;
+    }
+    else if (std::strcmp(option, "--b2b-trials") == 0)
+    {
+      auto trials = parse_long(value, 1, 1000);
+      valid = trials.has_value();
+      config.back_to_back_trials = valid ? static_cast<size_t>(*trials) : 0;
+    }
+    else if (std::strcmp(option, "--sizes") == 0)
+    {
+      frame_sizes.clear();
+      for (const std::string& item : split(value))
+      {
+        auto size = parse_long(item.c_str(), static_cast<long>(project::LOADGEN_MIN_FRAME_SIZE),
+                               static_cast<long>(project::LOADGEN_MAX_FRAME_SIZE));
+        valid = valid && size.has_value();
+        if (size)
+        {
+          frame_sizes.push_back(static_cast<size_t>(*size));
+        }
+      }
+      valid = valid && !frame_sizes.empty();
+    }
+    else if (std::strcmp(option, "--tests") == 0)
+    {
+      tests = TestSelection{};
+      for (const std::string& item : split(value))
+      {
+        if (item == "throughput")
+        {
+          tests.throughput = true;
+        }
+        else if (item == "latency")
+        {
+          tests.latency = true;
+        }
+        else if (item == "loss")
+        {
+          tests.frame_loss = true;
+        }
+        else if (item == "b2b")
+        {
+          tests.back_to_back = true;
+        }
+        else
+        {
+          valid = false;
+        }
+      }
+    }
+    else
+    {
+      print_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+
+    if (!valid)
+    {
+      std::cerr << "Error: Invalid value '" << value << "' for " << option << "\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Keep per-frame switch logging out of the measurements
+  project::Logger::instance().set_level(project::LogLevel::Warn);
+
+  std::optional<project::VSwitch> vswitch;
+  project::joining_thread switch_thread;
+  if (loopback)
+  {
+    project::VSwitchConfig switch_config;
+    switch_config.workers = loopback_workers;
+    auto vswitch_result = project::VSwitch::create(switch_config);
+    if (!vswitch_result)
+    {
+      std::cerr << "Error: Failed to create VSwitch: " << project::to_string(vswitch_result.error()) << "\n";
+      return EXIT_FAILURE;
+    }
+    vswitch.emplace(std::move(*vswitch_result));
+    config.vswitch = project::Endpoint("127.0.0.1", vswitch->port());
+    switch_thread = project::joining_thread([&vswitch]() { [[maybe_unused]] auto result = vswitch->start(); });
+  }
+
+  auto generator = project::LoadGenerator::create(config);
+  if (!generator)
+  {
+    std::cerr << "Error: Failed to create load generator: " << project::to_string(generator.error()) << "\n";
+    if (vswitch)
+    {
+      vswitch->stop();
+    }
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "Configuration:\n";
+  std::cout << "  VSwitch: " << config.vswitch << (loopback ? " (in-process)" : "") << "\n";
+  std::cout << "  Ports: " << config.ports << " x " << config.macs_per_port << " MACs\n";
+  std::cout << "  Full rate: " << config.max_rate << " frames/s\n";
+  std::cout << "  Trial: " << config.trial_duration.count() << " ms, drain " << config.drain_time.count() << " ms\n";
+  std::cout << "  Loss tolerance: " << config.loss_tolerance * 100.0 << "%\n";
+
+  // Calibrate the latency clock before the first trial rather than during one
+  [[maybe_unused]] double ns_per_tick = project::latency_ns_per_tick();
+
+  bool ok = true;
+  for (size_t frame_size : frame_sizes)
+  {
+    if (!run_frame_size(*generator, frame_size, tests))
+    {
+      ok = false;
+      break;
+    }
+  }
+
+  if (vswitch)
+  {
+    vswitch->stop();
+  }
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
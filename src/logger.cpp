@@ -0,0 +1,191 @@
+/**
+ * @file logger.cpp
+ * @brief Implementation of the asynchronous logger
+ */
+
+#include "project/logger.hpp"
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <thread>
+
+namespace project
+{
+  const char* to_string(LogLevel level) noexcept
+  {
+    switch (level)
+    {
+      case LogLevel::Trace:
+        return "trace";
+      case LogLevel::Debug:
+        return "debug";
+      case LogLevel::Info:
+        return "info";
+      case LogLevel::Warn:
+        return "warn";
+      case LogLevel::Error:
+        return "error";
+      case LogLevel::Off:
+        return "off";
+      default:
+        return "unknown";
+    }
+  }
+
+  std::optional<LogLevel> parse_log_level(std::string_view name) noexcept
+  {
+    for (LogLevel level : { LogLevel::Trace, LogLevel::Debug, LogLevel::Info, LogLevel::Warn, LogLevel::Error,
+                            LogLevel::Off })
+    {
+      if (name == to_string(level))
+      {
+        return level;
+      }
+    }
+    return std::nullopt;
+  }
+
+  namespace
+  {
+    size_t round_up_to_power_of_two(size_t value) noexcept
+    {
+      size_t capacity = 2;
+      while (capacity < value)
+      {
+        capacity *= 2;
+      }
+      return capacity;
+    }
+
+    void write_to_console(LogLevel level, std::string_view message)
+    {
+      std::FILE* stream = level >= LogLevel::Warn ? stderr : stdout;
+      std::fwrite(message.data(), 1, message.size(), stream);
+      std::fputc('\n', stream);
+    }
+  }  // namespace
+
+  Logger::Logger(size_t capacity, LogSink sink)
+      : mask_(round_up_to_power_of_two(capacity) - 1),
+        slots_(new Slot[mask_ + 1]),
+        sink_(sink ? std::move(sink) : LogSink(write_to_console))
+  {
+    // Slot i is free for the producer holding position i
+    for (size_t i = 0; i <= mask_; ++i)
+    {
+      slots_[i].seq.store(i, std::memory_order_relaxed);
+    }
+    drain_thread_ = joining_thread([this]() { run(); });
+  }
+
+  Logger::~Logger()
+  {
+    {
+      std::lock_guard lock(mutex_);
+      stopping_ = true;
+    }
+    cv_.notify_all();
+    if (drain_thread_.joinable())
+    {
+      drain_thread_.join();
+    }
+  }
+
+  Logger& Logger::instance()
+  {
+    static Logger logger;
+    return logger;
+  }
+
+  bool Logger::log(LogLevel level, const char* format, ...) noexcept
+  {
+    // Claim the next position whose slot the consumer has released
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    Slot* slot;
+    for (;;)
+    {
+      slot = &slots_[pos & mask_];
+      const size_t seq = slot->seq.load(std::memory_order_acquire);
+      const auto lag = static_cast<std::ptrdiff_t>(seq - pos);
+      if (lag == 0)
+      {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        {
+          break;
+        }
+      }
+      else if (lag < 0)
+      {
+        // Full: the consumer has not released this slot from the previous lap
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+      else
+      {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+
+    va_list args;
+    va_start(args, format);
+    const int written = std::vsnprintf(slot->text, LOG_MAX_MESSAGE_SIZE, format, args);
+    va_end(args);
+
+    const size_t length = written < 0 ? 0 : std::min(static_cast<size_t>(written), LOG_MAX_MESSAGE_SIZE - 1);
+    slot->length = static_cast<uint16_t>(length);
+    slot->level = level;
+    slot->seq.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  void Logger::flush()
+  {
+    const size_t target = enqueue_pos_.load(std::memory_order_acquire);
+    while (dequeue_pos_.load(std::memory_order_acquire) < target)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+
+  void Logger::drain()
+  {
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    bool drained = false;
+    for (;;)
+    {
+      Slot& slot = slots_[pos & mask_];
+      if (slot.seq.load(std::memory_order_acquire) != pos + 1)
+      {
+        break;  // Empty, or the producer of this position is still formatting
+      }
+
+      sink_(slot.level, std::string_view(slot.text, slot.length));
+
+      // Hand the slot to the producer one lap ahead
+      slot.seq.store(pos + mask_ + 1, std::memory_order_release);
+      ++pos;
+      dequeue_pos_.store(pos, std::memory_order_release);
+      drained = true;
+    }
+
+    if (drained)
+    {
+      std::fflush(nullptr);
+    }
+  }
+
+  void Logger::run()
+  {
+    std::unique_lock lock(mutex_);
+    while (!cv_.wait_for(lock, LOG_DRAIN_INTERVAL, [this]() { return stopping_; }))
+    {
+      lock.unlock();
+      drain();
+      lock.lock();
+    }
+    lock.unlock();
+    drain();
+  }
+
+}  // namespace project
@@ -0,0 +1,52 @@
+/**
+ * @file mac_aging.cpp
+ * @brief Implementation of MAC aging helpers
+ */
+
+#include "project/mac_aging.hpp"
+
+#include <utility>
+
+namespace project
+{
+  MacTimestamp mac_timestamp_now() noexcept
+  {
+    auto seconds = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now().time_since_epoch());
+    return static_cast<MacTimestamp>(seconds.count());
+  }
+
+  AgingSweeper::AgingSweeper(std::chrono::milliseconds interval, std::function<void()> sweep)
+      : interval_(interval), sweep_(std::move(sweep)), thread_([this]() { run(); })
+  {
+  }
+
+  AgingSweeper::~AgingSweeper()
+  {
+    stop();
+  }
+
+  void AgingSweeper::stop() noexcept
+  {
+    {
+      std::lock_guard lock(mutex_);
+      stopping_ = true;
+    }
+    wakeup_.notify_all();
+    if (thread_.joinable())
+    {
+      thread_.join();
+    }
+  }
+
+  void AgingSweeper::run()
+  {
+    std::unique_lock lock(mutex_);
+    while (!wakeup_.wait_for(lock, interval_, [this]() { return stopping_; }))
+    {
+      lock.unlock();
+      sweep_();
+      lock.lock();
+    }
+  }
+
+}  // namespace project
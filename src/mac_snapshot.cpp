@@ -0,0 +1,306 @@
+/**
+ * @file mac_snapshot.cpp
+ * @brief Implementation of MAC table snapshots
+ */
+
+#include "project/mac_snapshot.hpp"
+
+#include "project/hash.hpp"
+#include "project/sys_utils.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace project
+{
+  namespace
+  {
+    constexpr uint8_t MAGIC[8] = { 'V', 'S', 'W', 'M', 'A', 'C', 'S', 0 };
+    constexpr uint8_t FAMILY_IPV4 = 4;
+    constexpr uint8_t FAMILY_IPV6 = 6;
+
+    void put16(uint8_t* out, uint16_t value) noexcept
+    {
+      out[0] = static_cast<uint8_t>(value);
+      out[1] = static_cast<uint8_t>(value >> 8);
+    }
+
+    void put32(uint8_t* out, uint32_t value) noexcept
+    {
+      put16(out, static_cast<uint16_t>(value));
+      put16(out + 2, static_cast<uint16_t>(value >> 16));
+    }
+
+    void put64(uint8_t* out, uint64_t value) noexcept
+    {
+      put32(out, static_cast<uint32_t>(value));
+      put32(out + 4, static_cast<uint32_t>(value >> 32));
+    }
+
+    uint16_t get16(const uint8_t* in) noexcept
+    {
+      return static_cast<uint16_t>(in[0] | (in[1] << 8));
+    }
+
+    uint32_t get32(const uint8_t* in) noexcept
+    {
+      return get16(in) | (static_cast<uint32_t>(get16(in + 2)) << 16);
+    }
+
+    uint64_t get64(const uint8_t* in) noexcept
+    {
+      return get32(in) | (static_cast<uint64_t>(get32(in + 4)) << 32);
+    }
+
+    uint64_t checksum(const uint8_t* records, size_t size) noexcept
+    {
+      uint64_t h = 0;
+      for (size_t offset = 0; offset + 8 <= size; offset += 8)
+      {
+        h = mix64(h ^ get64(records + offset));
+      }
+      return h;
+    }
+
+    uint64_t wall_clock_now() noexcept
+    {
+      return static_cast<uint64_t>(
+          std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch())
+              .count());
+    }
+
+    bool write_all(int fd, const uint8_t* data, size_t size) noexcept
+    {
+      while (size > 0)
+      {
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0)
+        {
+          if (errno == EINTR)
+          {
+            continue;
+          }
+          return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+      }
+      return true;
+    }
+
+    void encode_record(uint8_t* out, const LearnedMac& entry, MacTimestamp now) noexcept
+    {
+      std::memcpy(out, entry.mac.data(), MAC_ADDRESS_SIZE);
+      put16(out + 6, entry.vlan);
+      if (entry.endpoint.family() == AF_INET6)
+      {
+        const auto* v6 = reinterpret_cast<const struct sockaddr_in6*>(entry.endpoint.as_sockaddr());
+        out[8] = FAMILY_IPV6;
+        std::memcpy(out + 12, &v6->sin6_addr, 16);
+      }
+      else
+      {
+        const auto* v4 = reinterpret_cast<const struct sockaddr_in*>(entry.endpoint.as_sockaddr());
+        out[8] = FAMILY_IPV4;
+        std::memcpy(out + 12, &v4->sin_addr, 4);
+      }
+      put16(out + 10, entry.endpoint.port());
+      put32(out + 28, entry.last_seen > now ? 0 : now - entry.last_seen);  // Refreshed after now was read
+    }
+
+    bool decode_endpoint(const uint8_t* record, Endpoint& endpoint) noexcept
+    {
+      const uint16_t port = get16(record + 10);
+      if (record[8] == FAMILY_IPV4)
+      {
+        struct sockaddr_in v4{};
+        v4.sin_family = AF_INET;
+        v4.sin_port = htons(port);
+        std::memcpy(&v4.sin_addr, record + 12, 4);
+        endpoint = Endpoint(v4);
+      }
+      else if (record[8] == FAMILY_IPV6)
+      {
+        struct sockaddr_in6 v6{};
+        v6.sin6_family = AF_INET6;
+        v6.sin6_port = htons(port);
+        std::memcpy(&v6.sin6_addr, record + 12, 16);
+        endpoint = Endpoint(v6);
+      }
+      else
+      {
+        return false;
+      }
+      return endpoint.is_valid();
+    }
+  }  // namespace
+
+  const char* to_string(MacSnapshotError error) noexcept
+  {
+    switch (error)
+    {
+      case MacSnapshotError::OpenFailed:
+        return "Failed to open snapshot file";
+      case MacSnapshotError::WriteFailed:
+        return "Failed to write snapshot file";
+      case MacSnapshotError::RenameFailed:
+        return "Failed to replace snapshot file";
+      case MacSnapshotError::MapFailed:
+        return "Failed to map snapshot file";
+      case MacSnapshotError::BadFormat:
+        return "Malformed snapshot file";
+      default:
+        return "Unknown snapshot error";
+    }
+  }
+
+  std::vector<uint8_t> encode_mac_snapshot(const std::vector<LearnedMac>& entries, MacTimestamp now,
+                                           uint64_t wall_clock)
+  {
+    std::vector<uint8_t> snapshot(MAC_SNAPSHOT_HEADER_SIZE + entries.size() * MAC_SNAPSHOT_RECORD_SIZE, 0);
+    uint8_t* records = snapshot.data() + MAC_SNAPSHOT_HEADER_SIZE;
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+      encode_record(records + i * MAC_SNAPSHOT_RECORD_SIZE, entries[i], now);
+    }
+
+    std::memcpy(snapshot.data(), MAGIC, sizeof(MAGIC));
+    put32(snapshot.data() + 8, MAC_SNAPSHOT_VERSION);
+    put32(snapshot.data() + 12, static_cast<uint32_t>(entries.size()));
+    put64(snapshot.data() + 16, wall_clock);
+    put64(snapshot.data() + 24, checksum(records, entries.size() * MAC_SNAPSHOT_RECORD_SIZE));
+    return snapshot;
+  }
+
+  expected<std::vector<LearnedMac>, MacSnapshotError> decode_mac_snapshot(const uint8_t* data, size_t size,
+                                                                          MacTimestamp now, uint64_t wall_clock)
+  {
+    if (size < MAC_SNAPSHOT_HEADER_SIZE || std::memcmp(data, MAGIC, sizeof(MAGIC)) != 0 ||
+        get32(data + 8) != MAC_SNAPSHOT_VERSION)
+    {
+      return unexpected(MacSnapshotError::BadFormat);
+    }
+
+    const size_t count = get32(data + 12);
+    const uint8_t* records = data + MAC_SNAPSHOT_HEADER_SIZE;
+    if (size != MAC_SNAPSHOT_HEADER_SIZE + count * MAC_SNAPSHOT_RECORD_SIZE ||
+        get64(data + 24) != checksum(records, count * MAC_SNAPSHOT_RECORD_SIZE))
+    {
+      return unexpected(MacSnapshotError::BadFormat);
+    }
+
+    // Time spent down, in seconds; nothing if the wall clock went backwards
+    const uint64_t written = get64(data + 16);
+    const uint64_t downtime = wall_clock > written ? wall_clock - written : 0;
+
+    std::vector<LearnedMac> entries;
+    entries.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+      const uint8_t* record = records + i * MAC_SNAPSHOT_RECORD_SIZE;
+      LearnedMac entry;
+      if (!decode_endpoint(record, entry.endpoint))
+      {
+        continue;
+      }
+      entry.mac = MacAddress(record);
+      entry.vlan = get16(record + 6);
+      const uint64_t age = std::min<uint64_t>(get32(record + 28) + downtime, UINT32_MAX);
+      entry.last_seen = now - static_cast<MacTimestamp>(age);
+      entries.push_back(entry);
+    }
+    return entries;
+  }
+
+  std::vector<uint8_t> snapshot_mac_table(const ConcurrentMacTable& table)
+  {
+    // Taken first, so that now is not older than the entries refreshed while they are copied
+    const std::vector<LearnedMac> entries = table.learned();
+    return encode_mac_snapshot(entries, mac_timestamp_now(), wall_clock_now());
+  }
+
+  expected<size_t, MacSnapshotError> restore_mac_table(const uint8_t* data, size_t size, ConcurrentMacTable& table,
+                                                       std::chrono::seconds max_age)
+  {
+    const MacTimestamp now = mac_timestamp_now();
+    auto entries = decode_mac_snapshot(data, size, now, wall_clock_now());
+    if (!entries)
+    {
+      return unexpected(entries.error());
+    }
+
+    size_t loaded = 0;
+    for (const auto& entry : *entries)
+    {
+      if (max_age.count() > 0 && mac_entry_expired(entry.last_seen, now, max_age))
+      {
+        continue;
+      }
+      if (table.insert(entry.vlan, entry.mac, entry.endpoint, entry.last_seen))
+      {
+        ++loaded;
+      }
+    }
+    return loaded;
+  }
+
+  expected<size_t, MacSnapshotError> save_mac_snapshot(const std::string& path, const ConcurrentMacTable& table)
+  {
+    const std::vector<uint8_t> snapshot = snapshot_mac_table(table);
+
+    const std::string temporary = path + ".tmp";
+    {
+      FileDescriptor fd(::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+      if (!fd)
+      {
+        return unexpected(MacSnapshotError::OpenFailed);
+      }
+      if (!write_all(fd.get(), snapshot.data(), snapshot.size()) || ::fsync(fd.get()) != 0)
+      {
+        fd.close();
+        ::unlink(temporary.c_str());
+        return unexpected(MacSnapshotError::WriteFailed);
+      }
+    }
+
+    if (std::rename(temporary.c_str(), path.c_str()) != 0)
+    {
+      ::unlink(temporary.c_str());
+      return unexpected(MacSnapshotError::RenameFailed);
+    }
+    return (snapshot.size() - MAC_SNAPSHOT_HEADER_SIZE) / MAC_SNAPSHOT_RECORD_SIZE;
+  }
+
+  expected<size_t, MacSnapshotError> load_mac_snapshot(const std::string& path, ConcurrentMacTable& table,
+                                                       std::chrono::seconds max_age)
+  {
+    FileDescriptor fd(::open(path.c_str(), O_RDONLY | O_CLOEXEC));
+    struct stat info{};
+    if (!fd || ::fstat(fd.get(), &info) != 0)
+    {
+      return unexpected(MacSnapshotError::OpenFailed);
+    }
+    if (info.st_size < static_cast<off_t>(MAC_SNAPSHOT_HEADER_SIZE))
+    {
+      return unexpected(MacSnapshotError::BadFormat);
+    }
+
+    const auto size = static_cast<size_t>(info.st_size);
+    MemoryMapping mapping(::mmap(nullptr, size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd.get(), 0), size);
+    if (!mapping)
+    {
+      return unexpected(MacSnapshotError::MapFailed);
+    }
+
+    return restore_mac_table(static_cast<const uint8_t*>(mapping.data()), size, table, max_age);
+  }
+
+}  // namespace project
@@ -27,23 +27,21 @@ namespace project
     return *this;
   }
 
-  bool MacTable::insert(const MacAddress& mac, const Endpoint& endpoint)
+  bool MacTable::insert(const MacAddress& mac, const Endpoint& endpoint, MacTimestamp now)
   {
     std::unique_lock lock(mutex_);
 
-    bool is_new = (table_.find(mac) == table_.end());
-    table_[mac] = endpoint;
-    return is_new;
+    return table_.insert_or_assign(mac, Entry{ endpoint, now });
   }
 
   std::optional<Endpoint> MacTable::lookup(const MacAddress& mac) const
   {
     std::shared_lock lock(mutex_);
 
-    auto it = table_.find(mac);
-    if (it != table_.end())
+    const Entry* entry = table_.find(mac);
+    if (entry != nullptr)
     {
-      return it->second;
+      return entry->endpoint;
     }
 
     return std::nullopt;
@@ -53,20 +51,35 @@ namespace project
   {
     std::unique_lock lock(mutex_);
 
-    auto it = table_.find(mac);
-    if (it != table_.end())
+    return table_.erase(mac);
+  }
+
+  size_t MacTable::expire(std::chrono::seconds max_age, MacTimestamp now)
+  {
+    std::unique_lock lock(mutex_);
+
+    std::vector<MacAddress> stale;
+    table_.for_each(
+        [&stale, now, max_age](const MacAddress& mac, const Entry& entry)
+        {
+          if (mac_entry_expired(entry.last_seen, now, max_age))
+          {
+            stale.push_back(mac);
+          }
+        });
+
+    for (const auto& mac : stale)
     {
-      table_.erase(it);
-      return true;
+      table_.erase(mac);
     }
 
-    return false;
+    return stale.size();
   }
 
   bool MacTable::contains(const MacAddress& mac) const
   {
     std::shared_lock lock(mutex_);
-    return table_.find(mac) != table_.end();
+    return table_.contains(mac);
   }
 
   std::vector<Endpoint> MacTable::get_all_endpoints() const
@@ -76,10 +89,7 @@ namespace project
     std::vector<Endpoint> endpoints;
     endpoints.reserve(table_.size());
 
-    for (const auto& [mac, endpoint] : table_)
-    {
-      endpoints.push_back(endpoint);
-    }
+    table_.for_each([&endpoints](const MacAddress&, const Entry& entry) { endpoints.push_back(entry.endpoint); });
 
     return endpoints;
   }
@@ -90,16 +100,28 @@ namespace project
 
     std::vector<Endpoint> endpoints;
 
-    for (const auto& [mac, endpoint] : table_)
-    {
-      if (mac != exclude_mac)
-      {
-        endpoints.push_back(endpoint);
-      }
-    }
+    table_.for_each(
+        [&endpoints, &exclude_mac](const MacAddress& mac, const Entry& entry)
+        {
+          if (mac != exclude_mac)
+          {
+            endpoints.push_back(entry.endpoint);
+          }
+        });
 
     return endpoints;
   }
 
+  std::unordered_map<MacAddress, Endpoint> MacTable::get_all_entries() const
+  {
+    std::shared_lock lock(mutex_);
+
+    std::unordered_map<MacAddress, Endpoint> entries;
+    entries.reserve(table_.size());
+    table_.for_each([&entries](const MacAddress& mac, const Entry& entry) { entries.emplace(mac, entry.endpoint); });
+
+    return entries;
+  }
+
 }  // namespace project
 
@@ -0,0 +1,386 @@
+/**
+ * @file multicast_snooping.cpp
+ * @brief Implementation of IGMP/MLD snooping
+ */
+
+#include "project/multicast_snooping.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace project
+{
+  namespace
+  {
+    constexpr uint8_t IP_PROTOCOL_IGMP = 2;
+    constexpr uint8_t IPV6_HOP_BY_HOP = 0;
+    constexpr uint8_t IPV6_ICMP = 58;
+    constexpr size_t IPV4_MIN_HEADER_SIZE = 20;
+    constexpr size_t IPV6_HEADER_SIZE = 40;
+
+    // IGMP message types (RFC 2236, RFC 3376)
+    constexpr uint8_t IGMP_QUERY = 0x11;
+    constexpr uint8_t IGMP_V1_REPORT = 0x12;
+    constexpr uint8_t IGMP_V2_REPORT = 0x16;
+    constexpr uint8_t IGMP_LEAVE = 0x17;
+    constexpr uint8_t IGMP_V3_REPORT = 0x22;
+
+    // MLD message types (RFC 2710, RFC 3810)
+    constexpr uint8_t MLD_QUERY = 130;
+    constexpr uint8_t MLD_V1_REPORT = 131;
+    constexpr uint8_t MLD_DONE = 132;
+    constexpr uint8_t MLD_V2_REPORT = 143;
+
+    // IGMPv3/MLDv2 group record types
+    constexpr uint8_t RECORD_MODE_IS_INCLUDE = 1;
+    constexpr uint8_t RECORD_CHANGE_TO_INCLUDE = 3;
+    constexpr uint8_t RECORD_BLOCK_OLD_SOURCES = 6;
+
+    uint16_t read16(const uint8_t* data) noexcept
+    {
+      return static_cast<uint16_t>((data[0] << 8) | data[1]);
+    }
+
+    MacAddress ipv4_group_mac(const uint8_t* address) noexcept
+    {
+      return MacAddress({ 0x01, 0x00, 0x5e, static_cast<uint8_t>(address[1] & 0x7f), address[2], address[3] });
+    }
+
+    MacAddress ipv6_group_mac(const uint8_t* address) noexcept
+    {
+      return MacAddress({ 0x33, 0x33, address[12], address[13], address[14], address[15] });
+    }
+
+    /**
+     * @brief Add a group unless it is not multicast or is flooded anyway
+     */
+    void add_group(SnoopingMessage& message, bool multicast, const MacAddress& group, bool join)
+    {
+      if (multicast && !multicast_always_flooded(group))
+      {
+        message.groups.push_back({ group, join });
+      }
+    }
+
+    /**
+     * @brief Whether a v3/v2 record joins its group (see parse_snooping_message())
+     */
+    bool record_joins(uint8_t type, uint16_t sources) noexcept
+    {
+      return !(sources == 0 && (type == RECORD_MODE_IS_INCLUDE || type == RECORD_CHANGE_TO_INCLUDE));
+    }
+
+    void parse_igmp(const uint8_t* igmp, size_t size, SnoopingMessage& message)
+    {
+      if (size < 8)
+      {
+        return;
+      }
+
+      switch (igmp[0])
+      {
+        case IGMP_QUERY:
+          message.kind = SnoopingKind::Query;
+          return;
+        case IGMP_V1_REPORT:
+        case IGMP_V2_REPORT:
+        case IGMP_LEAVE:
+          message.kind = SnoopingKind::Report;
+          add_group(message, (igmp[4] & 0xf0) == 0xe0, ipv4_group_mac(igmp + 4), igmp[0] != IGMP_LEAVE);
+          return;
+        case IGMP_V3_REPORT:
+        {
+          message.kind = SnoopingKind::Report;
+          const size_t records = read16(igmp + 6);
+          size_t offset = 8;
+          for (size_t i = 0; i < records && offset + 8 <= size; ++i)
+          {
+            const uint8_t* record = igmp + offset;
+            const uint16_t sources = read16(record + 2);
+            if (record[0] != RECORD_BLOCK_OLD_SOURCES)
+            {
+              add_group(message, (record[4] & 0xf0) == 0xe0, ipv4_group_mac(record + 4),
+                        record_joins(record[0], sources));
+            }
+            offset += 8 + size_t{ sources } * 4 + size_t{ record[1] } * 4;
+          }
+          return;
+        }
+        default:
+          return;
+      }
+    }
+
+    void parse_mld(const uint8_t* mld, size_t size, SnoopingMessage& message)
+    {
+      if (size < 8)
+      {
+        return;
+      }
+
+      switch (mld[0])
+      {
+        case MLD_QUERY:
+          message.kind = SnoopingKind::Query;
+          return;
+        case MLD_V1_REPORT:
+        case MLD_DONE:
+          if (size >= 24)
+          {
+            message.kind = SnoopingKind::Report;
+            add_group(message, mld[8] == 0xff, ipv6_group_mac(mld + 8), mld[0] == MLD_V1_REPORT);
+          }
+          return;
+        case MLD_V2_REPORT:
+        {
+          message.kind = SnoopingKind::Report;
+          const size_t records = read16(mld + 6);
+          size_t offset = 8;
+          for (size_t i = 0; i < records && offset + 20 <= size; ++i)
+          {
+            const uint8_t* record = mld + offset;
+            const uint16_t sources = read16(record + 2);
+            if (record[0] != RECORD_BLOCK_OLD_SOURCES)
+            {
+              add_group(message, record[4] == 0xff, ipv6_group_mac(record + 4), record_joins(record[0], sources));
+            }
+            offset += 20 + size_t{ sources } * 16 + size_t{ record[1] } * 4;
+          }
+          return;
+        }
+        default:
+          return;  // Neighbor discovery and the rest of ICMPv6
+      }
+    }
+  }  // namespace
+
+  bool parse_snooping_message(const uint8_t* frame, size_t size, SnoopingMessage& message)
+  {
+    message.kind = SnoopingKind::None;
+    message.groups.clear();
+    if (size < ETHERNET_HEADER_SIZE)
+    {
+      return false;
+    }
+
+    size_t l3 = ETHERNET_HEADER_SIZE;
+    uint16_t ethertype = read16(frame + 12);
+    if (ethertype == EtherType::VLAN || ethertype == EtherType::QinQ)
+    {
+      if (size < ETHERNET_HEADER_SIZE + VLAN_TAG_SIZE)
+      {
+        return false;
+      }
+      l3 += VLAN_TAG_SIZE;
+      ethertype = read16(frame + 16);
+    }
+
+    if (ethertype == EtherType::IPv4)
+    {
+      if (size < l3 + IPV4_MIN_HEADER_SIZE || (frame[l3] >> 4) != 4 || frame[l3 + 9] != IP_PROTOCOL_IGMP)
+      {
+        return false;
+      }
+      const size_t header_size = size_t{ frame[l3] & 0x0fu } * 4;
+      const size_t total = std::min<size_t>(read16(frame + l3 + 2), size - l3);
+      if ((read16(frame + l3 + 6) & 0x3fff) != 0 || header_size < IPV4_MIN_HEADER_SIZE || total <= header_size)
+      {
+        return false;  // Fragment, or no room for a message
+      }
+      parse_igmp(frame + l3 + header_size, total - header_size, message);
+    }
+    else if (ethertype == EtherType::IPv6)
+    {
+      if (size < l3 + IPV6_HEADER_SIZE || (frame[l3] >> 4) != 6)
+      {
+        return false;
+      }
+      const size_t end = l3 + IPV6_HEADER_SIZE + std::min<size_t>(read16(frame + l3 + 4), size - l3 - IPV6_HEADER_SIZE);
+      uint8_t next = frame[l3 + 6];
+      size_t offset = l3 + IPV6_HEADER_SIZE;
+      if (next == IPV6_HOP_BY_HOP)
+      {
+        if (offset + 8 > end)
+        {
+          return false;
+        }
+        next = frame[offset];
+        offset += (size_t{ frame[offset + 1] } + 1) * 8;
+      }
+      if (next != IPV6_ICMP || offset >= end)
+      {
+        return false;
+      }
+      parse_mld(frame + offset, end - offset, message);
+    }
+
+    return message.kind != SnoopingKind::None;
+  }
+
+  bool multicast_always_flooded(const MacAddress& mac) noexcept
+  {
+    const uint64_t value = mac.to_u64();
+    return (value >> 8) == 0x01005e0000ULL || (value >> 8) == 0x3333000000ULL;
+  }
+
+  MulticastGroupTable::MulticastGroupTable(std::chrono::seconds membership_time) : membership_time_(membership_time)
+  {
+  }
+
+  MulticastGroupTable::MulticastGroupTable(MulticastGroupTable&& other) noexcept
+      : groups_(std::move(other.groups_)),
+        routers_(std::move(other.routers_)),
+        generation_(other.generation_.load()),
+        membership_time_(other.membership_time_)
+  {
+  }
+
+  MulticastGroupTable& MulticastGroupTable::operator=(MulticastGroupTable&& other) noexcept
+  {
+    if (this != &other)
+    {
+      groups_ = std::move(other.groups_);
+      routers_ = std::move(other.routers_);
+      generation_.store(other.generation_.load() + 1);
+      membership_time_ = other.membership_time_;
+    }
+    return *this;
+  }
+
+  uint64_t MulticastGroupTable::make_key(uint16_t vlan, const MacAddress& group) noexcept
+  {
+    return group.to_u64() | (uint64_t{ vlan } << 48);
+  }
+
+  void MulticastGroupTable::changed() noexcept
+  {
+    generation_.fetch_add(1, std::memory_order_release);
+  }
+
+  bool MulticastGroupTable::join(uint16_t vlan, const MacAddress& group, const Endpoint& member, MacTimestamp now)
+  {
+    const auto deadline = static_cast<MacTimestamp>(now + membership_time_.count());
+    std::lock_guard lock(mutex_);
+    auto [it, inserted] = groups_[make_key(vlan, group)].insert_or_assign(member, deadline);
+    if (inserted)
+    {
+      changed();
+    }
+    return inserted;
+  }
+
+  bool MulticastGroupTable::leave(uint16_t vlan, const MacAddress& group, const Endpoint& member, MacTimestamp now)
+  {
+    const auto deadline = static_cast<MacTimestamp>(now + MULTICAST_LEAVE_LATENCY.count());
+    std::lock_guard lock(mutex_);
+    auto group_it = groups_.find(make_key(vlan, group));
+    if (group_it == groups_.end())
+    {
+      return false;
+    }
+    auto it = group_it->second.find(member);
+    if (it == group_it->second.end())
+    {
+      return false;
+    }
+
+    // Only ever shorten: a leave must not extend a subscription
+    if (static_cast<int32_t>(it->second - deadline) > 0)
+    {
+      it->second = deadline;
+    }
+    return true;
+  }
+
+  bool MulticastGroupTable::add_router(uint16_t vlan, const Endpoint& router, MacTimestamp now)
+  {
+    const auto deadline = static_cast<MacTimestamp>(now + membership_time_.count());
+    std::lock_guard lock(mutex_);
+    auto [it, inserted] = routers_[vlan].insert_or_assign(router, deadline);
+    if (inserted)
+    {
+      changed();
+    }
+    return inserted;
+  }
+
+  size_t MulticastGroupTable::expire(MacTimestamp now)
+  {
+    auto sweep = [now](auto& map) {
+      size_t removed = 0;
+      for (auto outer = map.begin(); outer != map.end();)
+      {
+        auto& subscribers = outer->second;
+        for (auto it = subscribers.begin(); it != subscribers.end();)
+        {
+          if (static_cast<int32_t>(now - it->second) > 0)
+          {
+            it = subscribers.erase(it);
+            ++removed;
+          }
+          else
+          {
+            ++it;
+          }
+        }
+        outer = subscribers.empty() ? map.erase(outer) : std::next(outer);
+      }
+      return removed;
+    };
+
+    std::lock_guard lock(mutex_);
+    const size_t removed = sweep(groups_) + sweep(routers_);
+    if (removed > 0)
+    {
+      changed();
+    }
+    return removed;
+  }
+
+  bool MulticastGroupTable::members(uint16_t vlan, const MacAddress& group, std::vector<Endpoint>& out) const
+  {
+    out.clear();
+    std::lock_guard lock(mutex_);
+    auto group_it = groups_.find(make_key(vlan, group));
+    const bool registered = group_it != groups_.end();
+    if (registered)
+    {
+      for (const auto& [endpoint, deadline] : group_it->second)
+      {
+        out.push_back(endpoint);
+      }
+    }
+
+    if (auto routers = routers_.find(vlan); routers != routers_.end())
+    {
+      for (const auto& [endpoint, deadline] : routers->second)
+      {
+        if (!registered || group_it->second.count(endpoint) == 0)
+        {
+          out.push_back(endpoint);
+        }
+      }
+    }
+    return registered;
+  }
+
+  void MulticastGroupTable::routers(uint16_t vlan, std::vector<Endpoint>& out) const
+  {
+    out.clear();
+    std::lock_guard lock(mutex_);
+    if (auto routers = routers_.find(vlan); routers != routers_.end())
+    {
+      for (const auto& [endpoint, deadline] : routers->second)
+      {
+        out.push_back(endpoint);
+      }
+    }
+  }
+
+  size_t MulticastGroupTable::group_count() const
+  {
+    std::lock_guard lock(mutex_);
+    return groups_.size();
+  }
+
+}  // namespace project
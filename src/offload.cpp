@@ -0,0 +1,223 @@
+/**
+ * @file offload.cpp
+ * @brief Implementation of the segmentation and checksum offload helpers
+ */
+
+#include "project/offload.hpp"
+
+#include "project/ethernet_frame.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace project
+{
+  namespace
+  {
+    constexpr uint16_t ETHERTYPE_VLAN = 0x8100;
+    constexpr uint16_t ETHERTYPE_IPV4 = 0x0800;
+    constexpr uint16_t ETHERTYPE_IPV6 = 0x86DD;
+    constexpr uint8_t IP_PROTOCOL_TCP = 6;
+    constexpr size_t IPV6_HEADER_SIZE = 40;
+    constexpr size_t TCP_MIN_HEADER_SIZE = 20;
+    constexpr uint8_t TCP_FIN = 0x01;
+    constexpr uint8_t TCP_PSH = 0x08;
+    constexpr uint8_t TCP_CWR = 0x80;
+
+    uint16_t read16(const uint8_t* data) noexcept
+    {
+      return static_cast<uint16_t>((data[0] << 8) | data[1]);
+    }
+
+    uint32_t read32(const uint8_t* data) noexcept
+    {
+      return (uint32_t{ data[0] } << 24) | (uint32_t{ data[1] } << 16) | (uint32_t{ data[2] } << 8) | data[3];
+    }
+
+    void write16(uint8_t* data, uint16_t value) noexcept
+    {
+      data[0] = static_cast<uint8_t>(value >> 8);
+      data[1] = static_cast<uint8_t>(value);
+    }
+
+    void write32(uint8_t* data, uint32_t value) noexcept
+    {
+      data[0] = static_cast<uint8_t>(value >> 24);
+      data[1] = static_cast<uint8_t>(value >> 16);
+      data[2] = static_cast<uint8_t>(value >> 8);
+      data[3] = static_cast<uint8_t>(value);
+    }
+
+    /**
+     * @brief Add big-endian 16-bit words to a ones' complement sum (RFC 1071)
+     */
+    uint64_t checksum_add(uint64_t sum, const uint8_t* data, size_t size) noexcept
+    {
+      for (size_t i = 0; i + 1 < size; i += 2)
+      {
+        sum += read16(data + i);
+      }
+      if ((size & 1) != 0)
+      {
+        sum += uint64_t{ data[size - 1] } << 8;
+      }
+      return sum;
+    }
+
+    uint16_t checksum_fold(uint64_t sum) noexcept
+    {
+      while ((sum >> 16) != 0)
+      {
+        sum = (sum & 0xffff) + (sum >> 16);
+      }
+      return static_cast<uint16_t>(~sum);
+    }
+  }  // namespace
+
+  const char* to_string(OffloadError error) noexcept
+  {
+    switch (error)
+    {
+      case OffloadError::Truncated:
+        return "Offloaded frame is truncated";
+      case OffloadError::UnsupportedGso:
+        return "Unsupported GSO frame";
+      case OffloadError::BufferTooSmall:
+        return "Segments do not fit the buffer";
+      default:
+        return "Unknown offload error";
+    }
+  }
+
+  expected<void, OffloadError> complete_checksum(const VnetHeader& header, uint8_t* frame, size_t size)
+  {
+    if ((header.flags & VNET_HDR_F_NEEDS_CSUM) == 0)
+    {
+      return expected<void, OffloadError>();
+    }
+
+    const size_t start = header.csum_start;
+    const size_t field = start + header.csum_offset;
+    if (field + 2 > size)
+    {
+      return unexpected(OffloadError::Truncated);
+    }
+
+    // The field already holds the pseudo-header sum, so it is summed like the rest
+    write16(frame + field, checksum_fold(checksum_add(0, frame + start, size - start)));
+    return expected<void, OffloadError>();
+  }
+
+  expected<SegmentedFrames, OffloadError> segment_frame(const VnetHeader& header, const uint8_t* frame, size_t size,
+                                                        uint8_t* out, size_t capacity)
+  {
+    const uint8_t gso_type = static_cast<uint8_t>(header.gso_type & ~VNET_HDR_GSO_ECN);
+    if ((gso_type != VNET_HDR_GSO_TCPV4 && gso_type != VNET_HDR_GSO_TCPV6) || header.gso_size == 0)
+    {
+      return unexpected(OffloadError::UnsupportedGso);
+    }
+
+    // Find the IP and TCP headers behind the Ethernet header and an optional VLAN tag
+    if (size < ETHERNET_HEADER_SIZE + VLAN_TAG_SIZE)
+    {
+      return unexpected(OffloadError::Truncated);
+    }
+    size_t l3 = ETHERNET_HEADER_SIZE;
+    uint16_t ethertype = read16(frame + 12);
+    if (ethertype == ETHERTYPE_VLAN)
+    {
+      l3 += VLAN_TAG_SIZE;
+      ethertype = read16(frame + 16);
+    }
+
+    const bool ipv4 = gso_type == VNET_HDR_GSO_TCPV4;
+    if (ethertype != (ipv4 ? ETHERTYPE_IPV4 : ETHERTYPE_IPV6))
+    {
+      return unexpected(OffloadError::UnsupportedGso);
+    }
+    if (size < l3 + (ipv4 ? 20 : IPV6_HEADER_SIZE))
+    {
+      return unexpected(OffloadError::Truncated);
+    }
+
+    const size_t ip_header_size = ipv4 ? size_t{ frame[l3] & 0x0fu } * 4 : IPV6_HEADER_SIZE;
+    const uint8_t protocol = ipv4 ? frame[l3 + 9] : frame[l3 + 6];
+    if (protocol != IP_PROTOCOL_TCP || ip_header_size < 20)
+    {
+      return unexpected(OffloadError::UnsupportedGso);
+    }
+
+    const size_t l4 = l3 + ip_header_size;
+    if (size < l4 + TCP_MIN_HEADER_SIZE)
+    {
+      return unexpected(OffloadError::Truncated);
+    }
+    const size_t headers = l4 + static_cast<size_t>(frame[l4 + 12] >> 4) * 4;
+    if (headers < l4 + TCP_MIN_HEADER_SIZE || headers > size)
+    {
+      return unexpected(OffloadError::Truncated);
+    }
+
+    const size_t payload = size - headers;
+    const size_t mss = header.gso_size;
+    const size_t segments = std::max<size_t>(1, (payload + mss - 1) / mss);
+    if (segments * headers + payload > capacity)
+    {
+      return unexpected(OffloadError::BufferTooSmall);
+    }
+
+    const uint32_t sequence = read32(frame + l4 + 4);
+    const uint16_t identification = ipv4 ? read16(frame + l3 + 4) : 0;
+
+    // The addresses in the TCP pseudo-header are the same for every segment
+    const uint64_t address_sum =
+        ipv4 ? checksum_add(0, frame + l3 + 12, 8) : checksum_add(0, frame + l3 + 8, 32);
+
+    size_t offset = 0;
+    for (size_t i = 0; i < segments; ++i)
+    {
+      const size_t segment_payload = std::min(mss, payload - std::min(payload, i * mss));
+      const size_t segment_size = headers + segment_payload;
+      uint8_t* segment = out + offset;
+      std::memcpy(segment, frame, headers);
+      std::memcpy(segment + headers, frame + headers + i * mss, segment_payload);
+
+      if (ipv4)
+      {
+        write16(segment + l3 + 2, static_cast<uint16_t>(segment_size - l3));
+        write16(segment + l3 + 4, static_cast<uint16_t>(identification + i));
+        write16(segment + l3 + 10, 0);
+        write16(segment + l3 + 10, checksum_fold(checksum_add(0, segment + l3, ip_header_size)));
+      }
+      else
+      {
+        write16(segment + l3 + 4, static_cast<uint16_t>(segment_size - l4));
+      }
+
+      uint8_t& tcp_flags = segment[l4 + 13];
+      if (i + 1 < segments)
+      {
+        tcp_flags = static_cast<uint8_t>(tcp_flags & ~(TCP_FIN | TCP_PSH));
+      }
+      if (i > 0)
+      {
+        tcp_flags = static_cast<uint8_t>(tcp_flags & ~TCP_CWR);
+      }
+      write32(segment + l4 + 4, static_cast<uint32_t>(sequence + i * mss));
+
+      const size_t tcp_size = segment_size - l4;
+      write16(segment + l4 + 16, 0);
+      uint64_t sum = address_sum + IP_PROTOCOL_TCP + tcp_size;
+      write16(segment + l4 + 16, checksum_fold(checksum_add(sum, segment + l4, tcp_size)));
+
+      offset += segment_size;
+    }
+
+    SegmentedFrames result;
+    result.size = offset;
+    result.segment_size = segments == 1 ? offset : headers + mss;
+    result.segments = segments;
+    return result;
+  }
+
+}  // namespace project
@@ -0,0 +1,430 @@
+/**
+ * @file packet_ring.cpp
+ * @brief Implementation of AF_PACKET rings for the VSwitch underlay
+ */
+
+#include "project/packet_ring.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <linux/filter.h>
+#include <linux/if_packet.h>
+#include <net/ethernet.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Older C libraries lack the option (Linux 4.20)
+#ifndef PACKET_IGNORE_OUTGOING
+#define PACKET_IGNORE_OUTGOING 23
+#endif
+#endif
+
+namespace project
+{
+  const char* to_string(PacketRingError error) noexcept
+  {
+    switch (error)
+    {
+      case PacketRingError::Unsupported:
+        return "Packet rings are not supported on this platform";
+      case PacketRingError::SocketFailed:
+        return "Failed to create packet socket (needs CAP_NET_RAW)";
+      case PacketRingError::InterfaceNotFound:
+        return "Interface not found";
+      case PacketRingError::FilterFailed:
+        return "Failed to attach packet filter";
+      case PacketRingError::RingSetupFailed:
+        return "Failed to set up TPACKET_V3 rings";
+      case PacketRingError::MapFailed:
+        return "Failed to map packet rings";
+      case PacketRingError::BindFailed:
+        return "Failed to bind packet socket to the interface";
+      case PacketRingError::FanoutFailed:
+        return "Failed to join packet fanout group";
+      default:
+        return "Unknown packet ring error";
+    }
+  }
+
+#ifdef __linux__
+  namespace
+  {
+    constexpr size_t IPV4_HEADER_SIZE = 20;
+    constexpr size_t UDP_HEADER_SIZE = 8;
+    constexpr size_t HEADERS_SIZE = ETHERNET_HEADER_SIZE + IPV4_HEADER_SIZE + UDP_HEADER_SIZE;
+    constexpr uint8_t IPPROTO_UDP_NUMBER = 17;
+
+    // TPACKET_ALIGN() without its signed mask
+    constexpr size_t tpacket_align(size_t size) noexcept
+    {
+      return (size + size_t{ TPACKET_ALIGNMENT - 1 }) & ~size_t{ TPACKET_ALIGNMENT - 1 };
+    }
+
+    // Where the frame of a send ring slot starts (the kernel's default without PACKET_TX_HAS_OFF)
+    constexpr size_t TX_DATA_OFFSET = tpacket_align(sizeof(struct tpacket3_hdr));
+
+    uint16_t load16(const uint8_t* in) noexcept
+    {
+      return static_cast<uint16_t>((in[0] << 8) | in[1]);
+    }
+
+    void store16(uint8_t* out, uint16_t value) noexcept
+    {
+      out[0] = static_cast<uint8_t>(value >> 8);
+      out[1] = static_cast<uint8_t>(value);
+    }
+
+    uint16_t ipv4_checksum(const uint8_t* header) noexcept
+    {
+      uint32_t sum = 0;
+      for (size_t i = 0; i < IPV4_HEADER_SIZE; i += 2)
+      {
+        sum += load16(header + i);
+      }
+      while (sum > 0xffff)
+      {
+        sum = (sum & 0xffff) + (sum >> 16);
+      }
+      return static_cast<uint16_t>(~sum);
+    }
+
+    size_t round_up_pow2(size_t value) noexcept
+    {
+      size_t result = 1;
+      while (result < value)
+      {
+        result <<= 1;
+      }
+      return result;
+    }
+  }  // namespace
+
+  expected<PacketRing, PacketRingError> PacketRing::create(const std::string& interface, const Endpoint& local,
+                                                           size_t max_frame_size)
+  {
+    if (local.family() != AF_INET || !local.is_valid())
+    {
+      return unexpected(PacketRingError::Unsupported);
+    }
+
+    const unsigned int ifindex = ::if_nametoindex(interface.c_str());
+    if (ifindex == 0)
+    {
+      return unexpected(PacketRingError::InterfaceNotFound);
+    }
+
+    PacketRing ring;
+    ring.socket_ = SocketHandle(::socket(AF_PACKET, SOCK_RAW | SOCK_CLOEXEC, 0));
+    if (!ring.socket_)
+    {
+      return unexpected(PacketRingError::SocketFailed);
+    }
+    const int fd = ring.socket_.get();
+
+    struct ifreq request{};
+    std::strncpy(request.ifr_name, interface.c_str(), IFNAMSIZ - 1);
+    if (::ioctl(fd, SIOCGIFHWADDR, &request) < 0)
+    {
+      return unexpected(PacketRingError::InterfaceNotFound);
+    }
+    ring.interface_mac_ = MacAddress(reinterpret_cast<const uint8_t*>(request.ifr_hwaddr.sa_data));
+    if (::ioctl(fd, SIOCGIFMTU, &request) < 0 || request.ifr_mtu <= 0)
+    {
+      return unexpected(PacketRingError::InterfaceNotFound);
+    }
+    ring.mtu_ = static_cast<size_t>(request.ifr_mtu);
+
+    const auto* address = reinterpret_cast<const struct sockaddr_in*>(local.as_sockaddr());
+    ring.local_address_ = address->sin_addr.s_addr;
+    ring.local_port_ = address->sin_port;
+
+    // Unfragmented UDP over IPv4 to the local port: ethertype, protocol, fragment bits, destination port
+    struct sock_filter code[] = {
+      BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 12),
+      BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ETHERTYPE_IP, 0, 8),
+      BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 23),
+      BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_UDP_NUMBER, 0, 6),
+      BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 20),
+      BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, 0x3fff, 4, 0),
+      BPF_STMT(BPF_LDX | BPF_B | BPF_MSH, 14),
+      BPF_STMT(BPF_LD | BPF_H | BPF_IND, 16),
+      BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, local.port(), 0, 1),
+      BPF_STMT(BPF_RET | BPF_K, 0xffffffff),
+      BPF_STMT(BPF_RET | BPF_K, 0),
+    };
+    struct sock_fprog filter{};
+    filter.len = sizeof(code) / sizeof(code[0]);
+    filter.filter = code;
+    if (::setsockopt(fd, SOL_SOCKET, SO_ATTACH_FILTER, &filter, sizeof(filter)) < 0)
+    {
+      return unexpected(PacketRingError::FilterFailed);
+    }
+
+    int version = TPACKET_V3;
+    if (::setsockopt(fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0)
+    {
+      return unexpected(PacketRingError::RingSetupFailed);
+    }
+    int enable = 1;
+    static_cast<void>(::setsockopt(fd, SOL_PACKET, PACKET_IGNORE_OUTGOING, &enable, sizeof(enable)));
+    if (::setsockopt(fd, SOL_PACKET, PACKET_LOSS, &enable, sizeof(enable)) < 0)  // Skip a bad send slot, do not stall
+    {
+      return unexpected(PacketRingError::RingSetupFailed);
+    }
+
+    // A receive block holds several maximal frames; a send slot holds one
+    const size_t frame_room =
+        tpacket_align(TX_DATA_OFFSET + sizeof(struct sockaddr_ll) + HEADERS_SIZE + max_frame_size);
+    const size_t block_size = std::max(PACKET_RING_BLOCK_SIZE, round_up_pow2(frame_room));
+    struct tpacket_req3 rx_request{};
+    rx_request.tp_block_size = static_cast<unsigned int>(block_size);
+    rx_request.tp_block_nr = static_cast<unsigned int>(PACKET_RING_RX_BLOCKS);
+    rx_request.tp_frame_size = TPACKET_ALIGNMENT << 7;
+    rx_request.tp_frame_nr = static_cast<unsigned int>(block_size / rx_request.tp_frame_size * PACKET_RING_RX_BLOCKS);
+    rx_request.tp_retire_blk_tov = 1;
+    if (::setsockopt(fd, SOL_PACKET, PACKET_RX_RING, &rx_request, sizeof(rx_request)) < 0)
+    {
+      return unexpected(PacketRingError::RingSetupFailed);
+    }
+
+    ring.tx_frame_size_ = round_up_pow2(TX_DATA_OFFSET + HEADERS_SIZE + max_frame_size);
+    const size_t tx_block_size = std::max(PACKET_RING_BLOCK_SIZE, ring.tx_frame_size_);
+    const size_t tx_blocks = std::max<size_t>(1, PACKET_RING_TX_FRAMES * ring.tx_frame_size_ / tx_block_size);
+    ring.tx_frames_ = tx_blocks * (tx_block_size / ring.tx_frame_size_);
+    struct tpacket_req3 tx_request{};
+    tx_request.tp_block_size = static_cast<unsigned int>(tx_block_size);
+    tx_request.tp_block_nr = static_cast<unsigned int>(tx_blocks);
+    tx_request.tp_frame_size = static_cast<unsigned int>(ring.tx_frame_size_);
+    tx_request.tp_frame_nr = static_cast<unsigned int>(ring.tx_frames_);
+    if (::setsockopt(fd, SOL_PACKET, PACKET_TX_RING, &tx_request, sizeof(tx_request)) < 0)
+    {
+      return unexpected(PacketRingError::RingSetupFailed);
+    }
+
+    // The kernel maps the receive ring first, the send ring right after it
+    const size_t rx_size = block_size * PACKET_RING_RX_BLOCKS;
+    const size_t tx_size = tx_block_size * tx_blocks;
+    ring.mapping_ = MemoryMapping(
+        ::mmap(nullptr, rx_size + tx_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0), rx_size + tx_size);
+    if (!ring.mapping_)
+    {
+      return unexpected(PacketRingError::MapFailed);
+    }
+    ring.rx_ = static_cast<uint8_t*>(ring.mapping_.data());
+    ring.tx_ = ring.rx_ + rx_size;
+    ring.rx_blocks_ = PACKET_RING_RX_BLOCKS;
+    ring.rx_block_size_ = block_size;
+
+    struct sockaddr_ll link{};
+    link.sll_family = AF_PACKET;
+    link.sll_protocol = htons(ETH_P_IP);
+    link.sll_ifindex = static_cast<int>(ifindex);
+    if (::bind(fd, reinterpret_cast<const struct sockaddr*>(&link), sizeof(link)) < 0)
+    {
+      return unexpected(PacketRingError::BindFailed);
+    }
+
+    // Group id from the port: rings of one switch, even across a live upgrade, share flows rather than copy them
+    int fanout = static_cast<int>(local.port()) | (PACKET_FANOUT_HASH << 16);
+    if (::setsockopt(fd, SOL_PACKET, PACKET_FANOUT, &fanout, sizeof(fanout)) < 0)
+    {
+      return unexpected(PacketRingError::FanoutFailed);
+    }
+
+    return ring;
+  }
+
+  void PacketRing::release_block() noexcept
+  {
+    auto* block = reinterpret_cast<struct tpacket_block_desc*>(rx_ + rx_block_ * rx_block_size_);
+    __atomic_store_n(&block->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+    rx_block_ = (rx_block_ + 1) % rx_blocks_;
+    rx_packet_ = nullptr;
+    rx_left_ = 0;
+  }
+
+  size_t PacketRing::receive(InboundDatagram* datagrams, size_t count, int timeout_ms)
+  {
+    size_t filled = 0;
+    bool waited = false;
+    while (filled < count)
+    {
+      if (rx_packet_ == nullptr)
+      {
+        auto* block = reinterpret_cast<struct tpacket_block_desc*>(rx_ + rx_block_ * rx_block_size_);
+        if ((__atomic_load_n(&block->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER) == 0)
+        {
+          if (filled > 0 || waited || timeout_ms == 0)
+          {
+            break;
+          }
+          struct pollfd pfd{};
+          pfd.fd = socket_.get();
+          pfd.events = POLLIN | POLLERR;
+          static_cast<void>(::poll(&pfd, 1, timeout_ms));
+          waited = true;
+          continue;
+        }
+
+        rx_left_ = block->hdr.bh1.num_pkts;
+        rx_packet_ = reinterpret_cast<const uint8_t*>(block) + block->hdr.bh1.offset_to_first_pkt;
+        if (rx_left_ == 0)
+        {
+          release_block();
+          continue;
+        }
+      }
+
+      const auto* header = reinterpret_cast<const struct tpacket3_hdr*>(rx_packet_);
+      const uint8_t* frame = rx_packet_ + header->tp_mac;
+      const size_t length = header->tp_snaplen;
+      rx_packet_ += header->tp_next_offset;
+      const bool last = --rx_left_ == 0;
+
+      // The filter let only unfragmented UDP to our port through; check the lengths it did not
+      const size_t ihl = size_t{ frame[ETHERNET_HEADER_SIZE] & 0x0fu } * 4;
+      const uint8_t* ip = frame + ETHERNET_HEADER_SIZE;
+      const uint8_t* udp = ip + ihl;
+      if (length >= HEADERS_SIZE && (ip[0] >> 4) == 4 && ihl >= IPV4_HEADER_SIZE &&
+          length >= ETHERNET_HEADER_SIZE + ihl + UDP_HEADER_SIZE)
+      {
+        const size_t udp_length = load16(udp + 4);
+        uint32_t destination;
+        std::memcpy(&destination, ip + 16, sizeof(destination));
+        if (udp_length >= UDP_HEADER_SIZE && ETHERNET_HEADER_SIZE + ihl + udp_length <= length &&
+            (local_address_ == 0 || destination == local_address_))
+        {
+          InboundDatagram& datagram = datagrams[filled++];
+          const size_t payload = udp_length - UDP_HEADER_SIZE;
+          datagram.size = std::min(payload, datagram.capacity);
+          datagram.truncated = payload > datagram.capacity;
+          std::memcpy(datagram.data, udp + UDP_HEADER_SIZE, datagram.size);
+
+          struct sockaddr_in sender{};
+          sender.sin_family = AF_INET;
+          std::memcpy(&sender.sin_addr, ip + 12, 4);
+          std::memcpy(&sender.sin_port, udp, 2);
+          datagram.sender = Endpoint(sender);
+
+          Neighbor& neighbor = neighbors_[sender.sin_addr.s_addr];
+          neighbor.mac = MacAddress(frame + 6);
+          neighbor.local = destination;
+        }
+      }
+
+      if (last)
+      {
+        release_block();
+      }
+    }
+    return filled;
+  }
+
+  size_t PacketRing::send(const OutboundDatagram* datagrams, size_t count, std::vector<OutboundDatagram>& fallback)
+  {
+    size_t queued = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+      const OutboundDatagram& datagram = datagrams[i];
+      if (!datagram.destination.is_valid())
+      {
+        continue;
+      }
+
+      const auto* destination = reinterpret_cast<const struct sockaddr_in*>(datagram.destination.as_sockaddr());
+      const size_t size = datagram.wire_size();
+      auto neighbor = datagram.destination.family() == AF_INET ? neighbors_.find(destination->sin_addr.s_addr)
+                                                               : neighbors_.end();
+      uint8_t* slot = tx_ + tx_next_ * tx_frame_size_;
+      auto* header = reinterpret_cast<struct tpacket3_hdr*>(slot);
+      if (neighbor == neighbors_.end() || IPV4_HEADER_SIZE + UDP_HEADER_SIZE + size > mtu_ ||
+          TX_DATA_OFFSET + HEADERS_SIZE + size > tx_frame_size_ ||
+          __atomic_load_n(&header->tp_status, __ATOMIC_ACQUIRE) != TP_STATUS_AVAILABLE)
+      {
+        fallback.push_back(datagram);
+        continue;
+      }
+
+      uint8_t* frame = slot + TX_DATA_OFFSET;
+      std::memcpy(frame, neighbor->second.mac.data(), MAC_ADDRESS_SIZE);
+      std::memcpy(frame + 6, interface_mac_.data(), MAC_ADDRESS_SIZE);
+      store16(frame + 12, ETHERTYPE_IP);
+
+      uint8_t* ip = frame + ETHERNET_HEADER_SIZE;
+      ip[0] = 0x45;
+      ip[1] = 0;
+      store16(ip + 2, static_cast<uint16_t>(IPV4_HEADER_SIZE + UDP_HEADER_SIZE + size));
+      store16(ip + 4, ip_id_++);
+      store16(ip + 6, 0);
+      ip[8] = 64;
+      ip[9] = IPPROTO_UDP_NUMBER;
+      store16(ip + 10, 0);
+      const uint32_t source = local_address_ != 0 ? local_address_ : neighbor->second.local;
+      std::memcpy(ip + 12, &source, 4);
+      std::memcpy(ip + 16, &destination->sin_addr, 4);
+      store16(ip + 10, ipv4_checksum(ip));
+
+      // No UDP checksum (optional over IPv4): the payload is an Ethernet frame with its own
+      uint8_t* udp = ip + IPV4_HEADER_SIZE;
+      std::memcpy(udp, &local_port_, 2);
+      std::memcpy(udp + 2, &destination->sin_port, 2);
+      store16(udp + 4, static_cast<uint16_t>(UDP_HEADER_SIZE + size));
+      store16(udp + 6, 0);
+
+      struct iovec iov[UDP_MAX_DATAGRAM_IOVECS];
+      uint8_t* out = udp + UDP_HEADER_SIZE;
+      for (size_t piece = 0, pieces = datagram.to_iovecs(iov); piece < pieces; ++piece)
+      {
+        std::memcpy(out, iov[piece].iov_base, iov[piece].iov_len);
+        out += iov[piece].iov_len;
+      }
+
+      header->tp_len = static_cast<uint32_t>(HEADERS_SIZE + size);
+      __atomic_store_n(&header->tp_status, TP_STATUS_SEND_REQUEST, __ATOMIC_RELEASE);
+      tx_next_ = (tx_next_ + 1) % tx_frames_;
+      ++queued;
+    }
+
+    // One system call sends every queued frame
+    if (queued > 0)
+    {
+      ssize_t result;
+      do
+      {
+        result = ::sendto(socket_.get(), nullptr, 0, MSG_DONTWAIT, nullptr, 0);
+      } while (result < 0 && errno == EINTR);
+    }
+    return queued;
+  }
+#else
+  expected<PacketRing, PacketRingError> PacketRing::create(const std::string&, const Endpoint&, size_t)
+  {
+    return unexpected(PacketRingError::Unsupported);
+  }
+
+  void PacketRing::release_block() noexcept
+  {
+  }
+
+  size_t PacketRing::receive(InboundDatagram*, size_t, int)
+  {
+    return 0;
+  }
+
+  size_t PacketRing::send(const OutboundDatagram* datagrams, size_t count, std::vector<OutboundDatagram>& fallback)
+  {
+    fallback.insert(fallback.end(), datagrams, datagrams + count);
+    return 0;
+  }
+#endif
+
+}  // namespace project
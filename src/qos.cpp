@@ -0,0 +1,179 @@
+/**
+ * @file qos.cpp
+ * @brief Implementation of ingress policing and egress scheduling
+ */
+
+#include "project/qos.hpp"
+
+#include "project/ethernet_frame.hpp"
+#include "project/hash.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace project
+{
+  uint8_t frame_priority(const uint8_t* frame, size_t size) noexcept
+  {
+    if (size < ETHERNET_HEADER_SIZE)
+    {
+      return 0;
+    }
+
+    size_t l3 = ETHERNET_HEADER_SIZE;
+    uint16_t ethertype = static_cast<uint16_t>((frame[12] << 8) | frame[13]);
+    if (ethertype == EtherType::VLAN || ethertype == EtherType::QinQ)
+    {
+      return size >= ETHERNET_HEADER_SIZE + VLAN_TAG_SIZE ? static_cast<uint8_t>(frame[14] >> 5) : 0;
+    }
+
+    if (ethertype == EtherType::IPv4 && size >= l3 + 2 && (frame[l3] >> 4) == 4)
+    {
+      return static_cast<uint8_t>(frame[l3 + 1] >> 5);  // Top bits of the TOS byte
+    }
+    if (ethertype == EtherType::IPv6 && size >= l3 + 2 && (frame[l3] >> 4) == 6)
+    {
+      return static_cast<uint8_t>((frame[l3] & 0x0f) >> 1);  // Top bits of the traffic class
+    }
+    return 0;
+  }
+
+  IngressPolicer::IngressPolicer(uint64_t rate, uint64_t burst, size_t ports)
+      : slots_((std::max(ports, size_t{ 1 }) + WAYS - 1) / WAYS * WAYS),
+        rate_(rate),
+        burst_(std::min(burst, std::numeric_limits<uint64_t>::max() / NS_PER_SECOND))
+  {
+  }
+
+  IngressPolicer::Slot& IngressPolicer::slot_for(const Endpoint& endpoint, uint64_t now_ns) noexcept
+  {
+    if (slots_[last_].endpoint == endpoint)
+    {
+      return slots_[last_];
+    }
+
+    const size_t sets = slots_.size() / WAYS;
+    const size_t first = (mix64(endpoint.hash()) % sets) * WAYS;
+    size_t victim = first;
+    for (size_t i = first; i < first + WAYS; ++i)
+    {
+      if (slots_[i].endpoint == endpoint)
+      {
+        last_ = i;
+        return slots_[i];
+      }
+      if (!slots_[i].endpoint.is_valid())
+      {
+        victim = i;
+      }
+      else if (slots_[victim].endpoint.is_valid() && slots_[i].updated_ns < slots_[victim].updated_ns)
+      {
+        victim = i;
+      }
+    }
+
+    Slot& slot = slots_[victim];
+    slot.endpoint = endpoint;
+    slot.tokens = burst_ * NS_PER_SECOND;
+    slot.updated_ns = now_ns;
+    last_ = victim;
+    return slot;
+  }
+
+  bool IngressPolicer::admit(const Endpoint& sender, size_t bytes, uint64_t now_ns) noexcept
+  {
+    if (rate_ == 0)
+    {
+      return true;
+    }
+
+    Slot& slot = slot_for(sender, now_ns);
+
+    // Refill; past the time to fill the bucket from empty, the product is not needed (nor safe)
+    const uint64_t capacity = burst_ * NS_PER_SECOND;
+    const uint64_t elapsed = now_ns > slot.updated_ns ? now_ns - slot.updated_ns : 0;
+    if (elapsed >= capacity / rate_)
+    {
+      slot.tokens = capacity;
+    }
+    else
+    {
+      slot.tokens = std::min(capacity, slot.tokens + elapsed * rate_);
+    }
+    slot.updated_ns = std::max(now_ns, slot.updated_ns);
+
+    const uint64_t cost = uint64_t{ bytes } * NS_PER_SECOND;
+    if (cost > slot.tokens)
+    {
+      return false;
+    }
+    slot.tokens -= cost;
+    return true;
+  }
+
+  void EgressScheduler::schedule(std::vector<OutboundDatagram>& batch)
+  {
+    if (batch.size() < 2)
+    {
+      return;
+    }
+
+    // Copies of one frame are queued back to back: classify each frame once
+    const uint8_t* previous = nullptr;
+    size_t cls = 0;
+    size_t used = 0;  // Bit per non-empty class
+    for (const auto& datagram : batch)
+    {
+      if (datagram.data != previous)
+      {
+        previous = datagram.data;
+        cls = priority_class(frame_priority(datagram.data, datagram.size));
+      }
+      queues_[cls].push_back(datagram);
+      used |= size_t{ 1 } << cls;
+    }
+
+    if ((used & (used - 1)) == 0)
+    {
+      // One class: nothing to interleave, the batch already is in order
+      for (auto& queue : queues_)
+      {
+        queue.clear();
+      }
+      return;
+    }
+
+    order_.clear();
+    std::array<size_t, QOS_CLASS_COUNT> head{};
+    std::array<size_t, QOS_CLASS_COUNT> deficit{};
+    while (order_.size() < batch.size())
+    {
+      for (size_t c = QOS_CLASS_COUNT; c-- > 0;)
+      {
+        auto& queue = queues_[c];
+        if (head[c] == queue.size())
+        {
+          continue;
+        }
+
+        deficit[c] += (size_t{ 1 } << c) * QOS_DRR_QUANTUM;
+        while (head[c] < queue.size() && queue[head[c]].wire_size() <= deficit[c])
+        {
+          deficit[c] -= queue[head[c]].wire_size();
+          order_.push_back(queue[head[c]++]);
+        }
+        if (head[c] == queue.size())
+        {
+          deficit[c] = 0;  // An emptied class does not bank its leftover quantum
+        }
+      }
+    }
+
+    for (auto& queue : queues_)
+    {
+      queue.clear();
+    }
+    batch.swap(order_);
+  }
+
+}  // namespace project
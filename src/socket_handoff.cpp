@@ -0,0 +1,436 @@
+/**
+ * @file socket_handoff.cpp
+ * @brief Implementation of socket handoff between processes
+ */
+
+#include "project/socket_handoff.hpp"
+
+#include <array>
+#include <cerrno>
+#include <cstring>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace project
+{
+  namespace
+  {
+    constexpr uint8_t MAGIC[8] = { 'V', 'S', 'W', 'H', 'A', 'N', 'D', 0 };
+    constexpr size_t HEADER_SIZE = 24;
+    constexpr uint8_t ACK = 'A';
+    constexpr uint64_t MAX_STATE_SIZE = uint64_t{ 1 } << 32;
+
+    void put32(uint8_t* out, uint32_t value) noexcept
+    {
+      for (size_t i = 0; i < 4; ++i)
+      {
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+      }
+    }
+
+    void put64(uint8_t* out, uint64_t value) noexcept
+    {
+      put32(out, static_cast<uint32_t>(value));
+      put32(out + 4, static_cast<uint32_t>(value >> 32));
+    }
+
+    uint32_t get32(const uint8_t* in) noexcept
+    {
+      uint32_t value = 0;
+      for (size_t i = 0; i < 4; ++i)
+      {
+        value |= static_cast<uint32_t>(in[i]) << (8 * i);
+      }
+      return value;
+    }
+
+    uint64_t get64(const uint8_t* in) noexcept
+    {
+      return get32(in) | (static_cast<uint64_t>(get32(in + 4)) << 32);
+    }
+
+    HandoffError receive_error(ssize_t received) noexcept
+    {
+      if (received < 0 && would_block(errno))
+      {
+        return HandoffError::Timeout;
+      }
+      return HandoffError::ReceiveFailed;  // Including the peer closing early
+    }
+
+    bool send_all(int channel, const uint8_t* data, size_t size) noexcept
+    {
+      while (size > 0)
+      {
+        ssize_t sent = ::send(channel, data, size, MSG_NOSIGNAL);
+        if (sent < 0)
+        {
+          if (errno == EINTR)
+          {
+            continue;
+          }
+          return false;
+        }
+        data += sent;
+        size -= static_cast<size_t>(sent);
+      }
+      return true;
+    }
+
+    expected<void, HandoffError> receive_all(int channel, uint8_t* data, size_t size) noexcept
+    {
+      while (size > 0)
+      {
+        ssize_t received = ::recv(channel, data, size, 0);
+        if (received <= 0)
+        {
+          if (received < 0 && errno == EINTR)
+          {
+            continue;
+          }
+          return unexpected(receive_error(received));
+        }
+        data += received;
+        size -= static_cast<size_t>(received);
+      }
+      return expected<void, HandoffError>();
+    }
+
+    bool set_receive_timeout(int channel, std::chrono::milliseconds timeout) noexcept
+    {
+      struct timeval tv{};
+      tv.tv_sec = timeout.count() / 1000;
+      tv.tv_usec = (timeout.count() % 1000) * 1000;
+      return ::setsockopt(channel, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) == 0;
+    }
+
+    bool unix_address(const std::string& path, struct sockaddr_un& address) noexcept
+    {
+      address = {};
+      address.sun_family = AF_UNIX;
+      if (path.empty() || path.size() >= sizeof(address.sun_path))
+      {
+        return false;
+      }
+      std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+      return true;
+    }
+  }  // namespace
+
+  const char* to_string(HandoffError error) noexcept
+  {
+    switch (error)
+    {
+      case HandoffError::SocketFailed:
+        return "Failed to create handoff socket";
+      case HandoffError::BindFailed:
+        return "Failed to listen on handoff socket";
+      case HandoffError::ConnectFailed:
+        return "Failed to connect to handoff socket";
+      case HandoffError::PeerRejected:
+        return "Handoff peer belongs to another user";
+      case HandoffError::TooManySockets:
+        return "Too many sockets for one handoff";
+      case HandoffError::SendFailed:
+        return "Failed to send handoff";
+      case HandoffError::ReceiveFailed:
+        return "Failed to receive handoff";
+      case HandoffError::Timeout:
+        return "Handoff peer did not answer in time";
+      case HandoffError::BadMessage:
+        return "Malformed handoff message";
+      default:
+        return "Unknown handoff error";
+    }
+  }
+
+  expected<void, HandoffError> send_handoff(int channel, const std::vector<int>& sockets,
+                                            const std::vector<uint8_t>& state)
+  {
+    if (sockets.size() > HANDOFF_MAX_SOCKETS)
+    {
+      return unexpected(HandoffError::TooManySockets);
+    }
+
+    std::array<uint8_t, HEADER_SIZE> header{};
+    std::memcpy(header.data(), MAGIC, sizeof(MAGIC));
+    put32(header.data() + 8, HANDOFF_VERSION);
+    put32(header.data() + 12, static_cast<uint32_t>(sockets.size()));
+    put64(header.data() + 16, state.size());
+
+    struct iovec iov{};
+    iov.iov_base = header.data();
+    iov.iov_len = header.size();
+    struct msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+
+    // The descriptors ride along with the header's first byte
+    std::vector<char> control;
+    if (!sockets.empty())
+    {
+      control.resize(CMSG_SPACE(sockets.size() * sizeof(int)));
+      msg.msg_control = control.data();
+      msg.msg_controllen = control.size();
+      struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+      cmsg->cmsg_level = SOL_SOCKET;
+      cmsg->cmsg_type = SCM_RIGHTS;
+      cmsg->cmsg_len = CMSG_LEN(sockets.size() * sizeof(int));
+      std::memcpy(CMSG_DATA(cmsg), sockets.data(), sockets.size() * sizeof(int));
+    }
+
+    ssize_t sent;
+    do
+    {
+      sent = ::sendmsg(channel, &msg, MSG_NOSIGNAL);
+    } while (sent < 0 && errno == EINTR);
+    if (sent <= 0)
+    {
+      return unexpected(HandoffError::SendFailed);
+    }
+
+    const auto header_sent = static_cast<size_t>(sent);
+    if (!send_all(channel, header.data() + header_sent, header.size() - header_sent) ||
+        !send_all(channel, state.data(), state.size()))
+    {
+      return unexpected(HandoffError::SendFailed);
+    }
+    return expected<void, HandoffError>();
+  }
+
+  expected<Handoff, HandoffError> receive_handoff(int channel, std::chrono::milliseconds timeout)
+  {
+    if (!set_receive_timeout(channel, timeout))
+    {
+      return unexpected(HandoffError::SocketFailed);
+    }
+
+    std::array<uint8_t, HEADER_SIZE> header{};
+    struct iovec iov{};
+    iov.iov_base = header.data();
+    iov.iov_len = header.size();
+    alignas(struct cmsghdr) std::array<char, CMSG_SPACE(HANDOFF_MAX_SOCKETS * sizeof(int))> control{};
+    struct msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.data();
+    msg.msg_controllen = control.size();
+
+    ssize_t received;
+    do
+    {
+      received = ::recvmsg(channel, &msg, MSG_CMSG_CLOEXEC);
+    } while (received < 0 && errno == EINTR);
+    if (received <= 0)
+    {
+      return unexpected(receive_error(received));
+    }
+
+    // Own the descriptors first, so they are closed on any error below
+    Handoff handoff;
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg))
+    {
+      if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+      {
+        continue;
+      }
+      const size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+      for (size_t i = 0; i < count; ++i)
+      {
+        int fd;
+        std::memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(fd));
+        handoff.sockets.emplace_back(fd);
+      }
+    }
+    if ((msg.msg_flags & MSG_CTRUNC) != 0)
+    {
+      return unexpected(HandoffError::BadMessage);
+    }
+
+    const auto header_received = static_cast<size_t>(received);
+    if (auto rest = receive_all(channel, header.data() + header_received, header.size() - header_received); !rest)
+    {
+      return unexpected(rest.error());
+    }
+
+    if (std::memcmp(header.data(), MAGIC, sizeof(MAGIC)) != 0 || get32(header.data() + 8) != HANDOFF_VERSION ||
+        get32(header.data() + 12) != handoff.sockets.size() || get64(header.data() + 16) > MAX_STATE_SIZE)
+    {
+      return unexpected(HandoffError::BadMessage);
+    }
+
+    handoff.state.resize(get64(header.data() + 16));
+    if (auto state = receive_all(channel, handoff.state.data(), handoff.state.size()); !state)
+    {
+      return unexpected(state.error());
+    }
+    return handoff;
+  }
+
+  expected<void, HandoffError> send_handoff_ack(int channel)
+  {
+    if (!send_all(channel, &ACK, 1))
+    {
+      return unexpected(HandoffError::SendFailed);
+    }
+    return expected<void, HandoffError>();
+  }
+
+  expected<void, HandoffError> wait_handoff_ack(int channel, std::chrono::milliseconds timeout)
+  {
+    if (!set_receive_timeout(channel, timeout))
+    {
+      return unexpected(HandoffError::SocketFailed);
+    }
+
+    uint8_t ack = 0;
+    if (auto received = receive_all(channel, &ack, 1); !received)
+    {
+      return unexpected(received.error());
+    }
+    if (ack != ACK)
+    {
+      return unexpected(HandoffError::BadMessage);
+    }
+    return expected<void, HandoffError>();
+  }
+
+  expected<SocketHandle, HandoffError> connect_handoff(const std::string& path)
+  {
+    struct sockaddr_un address;
+    if (!unix_address(path, address))
+    {
+      return unexpected(HandoffError::ConnectFailed);
+    }
+
+    SocketHandle socket(::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0));
+    if (!socket)
+    {
+      return unexpected(HandoffError::SocketFailed);
+    }
+
+    if (::connect(socket.get(), reinterpret_cast<const struct sockaddr*>(&address), sizeof(address)) < 0)
+    {
+      return unexpected(HandoffError::ConnectFailed);
+    }
+    return socket;
+  }
+
+  // HandoffListener implementation
+
+  expected<HandoffListener, HandoffError> HandoffListener::create(const std::string& path)
+  {
+    struct sockaddr_un address;
+    if (!unix_address(path, address))
+    {
+      return unexpected(HandoffError::BindFailed);
+    }
+
+    HandoffListener listener;
+    listener.socket_ = SocketHandle(::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0));
+    if (!listener.socket_)
+    {
+      return unexpected(HandoffError::SocketFailed);
+    }
+
+    // A predecessor that is still listening keeps its (now unnamed) socket; it no longer gets connections
+    ::unlink(path.c_str());
+    if (::bind(listener.socket_.get(), reinterpret_cast<const struct sockaddr*>(&address), sizeof(address)) < 0)
+    {
+      return unexpected(HandoffError::BindFailed);
+    }
+
+    struct stat info{};
+    if (::chmod(path.c_str(), S_IRUSR | S_IWUSR) != 0 || ::stat(path.c_str(), &info) != 0 ||
+        ::listen(listener.socket_.get(), 1) < 0)
+    {
+      ::unlink(path.c_str());
+      return unexpected(HandoffError::BindFailed);
+    }
+
+    listener.path_ = path;
+    listener.inode_ = info.st_ino;
+    return listener;
+  }
+
+  HandoffListener::HandoffListener(HandoffListener&& other) noexcept
+      : socket_(std::move(other.socket_)),
+        path_(std::move(other.path_)),
+        inode_(other.inode_)
+  {
+  }
+
+  HandoffListener& HandoffListener::operator=(HandoffListener&& other) noexcept
+  {
+    if (this != &other)
+    {
+      close();
+      socket_ = std::move(other.socket_);
+      path_ = std::move(other.path_);
+      inode_ = other.inode_;
+    }
+    return *this;
+  }
+
+  HandoffListener::~HandoffListener()
+  {
+    close();
+  }
+
+  void HandoffListener::close() noexcept
+  {
+    if (!socket_)
+    {
+      return;
+    }
+
+    struct stat info{};
+    if (::stat(path_.c_str(), &info) == 0 && info.st_ino == inode_)
+    {
+      ::unlink(path_.c_str());
+    }
+    socket_.close();
+  }
+
+  expected<SocketHandle, HandoffError> HandoffListener::accept(std::chrono::milliseconds timeout)
+  {
+    if (!socket_)
+    {
+      return unexpected(HandoffError::SocketFailed);
+    }
+
+    struct pollfd pfd{};
+    pfd.fd = socket_.get();
+    pfd.events = POLLIN;
+    int ready = ::poll(&pfd, 1, static_cast<int>(timeout.count()));
+    if (ready == 0 || (ready < 0 && errno == EINTR))
+    {
+      return unexpected(HandoffError::Timeout);
+    }
+    if (ready < 0)
+    {
+      return unexpected(HandoffError::ReceiveFailed);
+    }
+
+    SocketHandle connection(::accept4(socket_.get(), nullptr, nullptr, SOCK_CLOEXEC));
+    if (!connection)
+    {
+      return unexpected(HandoffError::ReceiveFailed);
+    }
+
+    struct ucred peer{};
+    socklen_t peer_size = sizeof(peer);
+    if (::getsockopt(connection.get(), SOL_SOCKET, SO_PEERCRED, &peer, &peer_size) < 0 ||
+        (peer.uid != ::geteuid() && peer.uid != 0))
+    {
+      return unexpected(HandoffError::PeerRejected);
+    }
+    return connection;
+  }
+
+}  // namespace project
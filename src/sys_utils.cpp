@@ -5,8 +5,15 @@
 
 #include "project/sys_utils.hpp"
 
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <unistd.h>
 
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 namespace project
 {
   FileDescriptor::~FileDescriptor()
@@ -23,5 +30,55 @@ namespace project
     }
   }
 
+  MemoryMapping::MemoryMapping(void* address, size_t size) noexcept
+      : address_(address == MAP_FAILED ? nullptr : address), size_(address_ == nullptr ? 0 : size)
+  {
+  }
+
+  MemoryMapping MemoryMapping::anonymous(size_t size) noexcept
+  {
+    return MemoryMapping(::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0), size);
+  }
+
+  void MemoryMapping::unmap() noexcept
+  {
+    if (address_ != nullptr)
+    {
+      ::munmap(address_, size_);
+      address_ = nullptr;
+      size_ = 0;
+    }
+  }
+
+  bool pin_current_thread(size_t cpu) noexcept
+  {
+#ifdef __linux__
+    if (cpu >= CPU_SETSIZE)
+    {
+      return false;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+  }
+
+  bool set_nonblocking(int fd, bool enable) noexcept
+  {
+    int flags = ::fcntl(fd, F_GETFL);
+    if (flags < 0)
+    {
+      return false;
+    }
+
+    flags = enable ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+    return ::fcntl(fd, F_SETFL, flags) == 0;
+  }
+
 }  // namespace project
 
@@ -5,10 +5,12 @@
 
 #include "project/tap_device.hpp"
 
+#include <algorithm>
 #include <cstring>
 #include <errno.h>
 #include <fcntl.h>
 #include <sys/ioctl.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #include <vector>
 
@@ -47,6 +49,10 @@ namespace project
         return "Invalid TAP device";
       case TapError::PartialWrite:
         return "Partial write to TAP device";
+      case TapError::WouldBlock:
+        return "TAP device not ready (non-blocking)";
+      case TapError::InvalidQueueCount:
+        return "Invalid number of TAP queues";
       default:
         return "Unknown TAP error";
     }
@@ -57,20 +63,18 @@ namespace project
   {
   }
 
-  expected<TapDevice, TapError> TapDevice::create(std::string_view device_name)
+  expected<TapDevice, TapError> TapDevice::open_queue(std::string_view device_name, int flags, bool offloads)
   {
 #ifdef __linux__
-    // Linux implementation using /dev/net/tun
     int fd = ::open("/dev/net/tun", O_RDWR);
     if (fd < 0)
     {
       return unexpected(TapError::DeviceOpenFailed);
     }
 
-    // Configure the device as TAP (Layer 2, Ethernet frames)
     struct ifreq ifr;
     std::memset(&ifr, 0, sizeof(ifr));
-    ifr.ifr_flags = IFF_TAP | IFF_NO_PI;  // TAP device, no packet information
+    ifr.ifr_flags = static_cast<short>(offloads ? flags | IFF_VNET_HDR : flags);
 
     // Set device name if provided
     if (!device_name.empty())
@@ -80,22 +84,49 @@ namespace project
         ::close(fd);
         return unexpected(TapError::IoctlFailed);
       }
-      std::strncpy(ifr.ifr_name, device_name.data(), IFNAMSIZ - 1);
+      std::memcpy(ifr.ifr_name, device_name.data(), device_name.size());
     }
 
-    // Create the TAP device
+    // Create the TAP device, or attach another queue to it
     if (::ioctl(fd, TUNSETIFF, &ifr) < 0)
     {
       ::close(fd);
       return unexpected(TapError::IoctlFailed);
     }
 
+    // Checksum and TCP segmentation offload: the kernel may now send unfinished super-frames
+    if (offloads)
+    {
+      int header_size = static_cast<int>(sizeof(VnetHeader));
+      const unsigned int features = TUN_F_CSUM | TUN_F_TSO4 | TUN_F_TSO6 | TUN_F_TSO_ECN;
+      if (::ioctl(fd, TUNSETVNETHDRSZ, &header_size) < 0 || ::ioctl(fd, TUNSETOFFLOAD, features) < 0)
+      {
+        ::close(fd);
+        return unexpected(TapError::IoctlFailed);
+      }
+    }
+
     // Get the actual device name (kernel may have assigned one)
-    std::string actual_name(ifr.ifr_name);
+    TapDevice device(FileDescriptor(fd), std::string(ifr.ifr_name));
+    device.offloads_ = offloads;
+    return device;
+#else
+    (void)device_name;  // Suppress unused parameter warning
+    (void)flags;
+    (void)offloads;
+    return unexpected(TapError::DeviceOpenFailed);
+#endif
+  }
 
-    return TapDevice(FileDescriptor(fd), std::move(actual_name));
+  expected<TapDevice, TapError> TapDevice::create(std::string_view device_name, bool offloads)
+  {
+#ifdef __linux__
+    // Linux implementation using /dev/net/tun: TAP (Layer 2, Ethernet frames), no packet information
+    return open_queue(device_name, IFF_TAP | IFF_NO_PI, offloads);
 
 #elif __APPLE__
+    (void)offloads;  // utun has no virtio-net header
+
     // macOS implementation using utun devices
     // Note: macOS requires third-party drivers for TAP devices
     // We'll use utun (TUN) as a fallback, or require tuntap installation
@@ -153,10 +184,59 @@ namespace project
 #else
     // Unsupported platform
     (void)device_name;  // Suppress unused parameter warning
+    (void)offloads;
+    return unexpected(TapError::DeviceOpenFailed);
+#endif
+  }
+
+  expected<std::vector<TapDevice>, TapError> TapDevice::create_multi_queue(std::string_view device_name, size_t queues,
+                                                                           bool offloads)
+  {
+    if (queues == 0 || queues > TAP_MAX_QUEUES)
+    {
+      return unexpected(TapError::InvalidQueueCount);
+    }
+
+#ifdef __linux__
+    // The first queue creates the device (and learns its name); the others attach by name
+    std::vector<TapDevice> devices;
+    devices.reserve(queues);
+    for (size_t i = 0; i < queues; ++i)
+    {
+      auto queue = open_queue(devices.empty() ? device_name : std::string_view(devices.front().device_name()),
+                              IFF_TAP | IFF_NO_PI | IFF_MULTI_QUEUE, offloads);
+      if (!queue)
+      {
+        return unexpected(queue.error());
+      }
+      devices.push_back(std::move(*queue));
+    }
+
+    return devices;
+#else
+    (void)device_name;  // Suppress unused parameter warning
+    (void)offloads;
     return unexpected(TapError::DeviceOpenFailed);
 #endif
   }
 
+  expected<void, TapError> TapDevice::set_nonblocking(bool enable)
+  {
+    if (!is_valid())
+    {
+      return unexpected(TapError::InvalidDevice);
+    }
+
+    if (!project::set_nonblocking(fd_.get(), enable))
+    {
+      return unexpected(TapError::IoctlFailed);
+    }
+
+    nonblocking_ = enable;
+
+    return expected<void, TapError>();
+  }
+
   expected<std::vector<uint8_t>, TapError> TapDevice::read_frame()
   {
     if (!is_valid())
@@ -165,7 +245,10 @@ namespace project
     }
 
     std::array<uint8_t, ETHER_MAX_LEN> buffer;
-    ssize_t n = ::read(fd_.get(), buffer.data(), buffer.size());
+    VnetHeader header;
+    struct iovec iov[2] = { { &header, sizeof(header) }, { buffer.data(), buffer.size() } };
+    ssize_t n = offloads_ ? ::readv(fd_.get(), iov, 2) - static_cast<ssize_t>(sizeof(header))
+                          : ::read(fd_.get(), buffer.data(), buffer.size());
 
     if (n < 0)
     {
@@ -176,6 +259,72 @@ namespace project
     return frame;
   }
 
+  expected<size_t, TapError> TapDevice::read_frame(FrameBuffer& buffer)
+  {
+    VnetHeader header;
+    return read_frame(buffer, header);
+  }
+
+  expected<size_t, TapError> TapDevice::read_frame(FrameBuffer& buffer, VnetHeader& header)
+  {
+    if (!is_valid() || !buffer.is_valid())
+    {
+      return unexpected(TapError::InvalidDevice);
+    }
+
+    header = VnetHeader();
+    ssize_t n;
+    if (offloads_)
+    {
+      struct iovec iov[2] = { { &header, sizeof(header) }, { buffer.data(), buffer.capacity() } };
+      n = ::readv(fd_.get(), iov, 2);
+      if (n >= 0 && static_cast<size_t>(n) < sizeof(header))
+      {
+        buffer.set_size(0);
+        return unexpected(TapError::ReadFailed);
+      }
+      n = n < 0 ? n : n - static_cast<ssize_t>(sizeof(header));
+    }
+    else
+    {
+      n = ::read(fd_.get(), buffer.data(), buffer.capacity());
+    }
+
+    if (n < 0)
+    {
+      buffer.set_size(0);
+      return unexpected(nonblocking_ && would_block(errno) ? TapError::WouldBlock : TapError::ReadFailed);
+    }
+
+    buffer.set_size(static_cast<size_t>(n));
+    return static_cast<size_t>(n);
+  }
+
+  expected<size_t, TapError> TapDevice::read_frame(uint8_t* data, size_t capacity)
+  {
+    if (!is_valid() || data == nullptr)
+    {
+      return unexpected(TapError::InvalidDevice);
+    }
+
+    VnetHeader header;
+    struct iovec iov[2] = { { &header, sizeof(header) }, { data, capacity } };
+    ssize_t n = offloads_ ? ::readv(fd_.get(), iov, 2) : ::read(fd_.get(), data, capacity);
+    if (n < 0)
+    {
+      return unexpected(nonblocking_ && would_block(errno) ? TapError::WouldBlock : TapError::ReadFailed);
+    }
+    if (offloads_)
+    {
+      if (static_cast<size_t>(n) < sizeof(header))
+      {
+        return unexpected(TapError::ReadFailed);
+      }
+      n -= static_cast<ssize_t>(sizeof(header));
+    }
+    return static_cast<size_t>(n);
+  }
+
   expected<size_t, TapError> TapDevice::write_frame(const std::vector<uint8_t>& frame)
   {
     return write_frame(frame.data(), frame.size());
@@ -188,11 +337,23 @@ namespace project
       return unexpected(TapError::InvalidDevice);
     }
 
-    ssize_t n = ::write(fd_.get(), data, size);
+    // A complete frame needs nothing from the kernel, so its header stays empty
+    ssize_t n;
+    if (offloads_)
+    {
+      VnetHeader header;
+      struct iovec iov[2] = { { &header, sizeof(header) }, { const_cast<uint8_t*>(data), size } };
+      n = ::writev(fd_.get(), iov, 2);
+      n = n < 0 ? n : std::max<ssize_t>(0, n - static_cast<ssize_t>(sizeof(header)));
+    }
+    else
+    {
+      n = ::write(fd_.get(), data, size);
+    }
 
     if (n < 0)
     {
-      return unexpected(TapError::WriteFailed);
+      return unexpected(nonblocking_ && would_block(errno) ? TapError::WouldBlock : TapError::WriteFailed);
     }
 
     if (static_cast<size_t>(n) != size)
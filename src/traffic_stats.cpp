@@ -0,0 +1,112 @@
+/**
+ * @file traffic_stats.cpp
+ * @brief Implementation of traffic counters and their export
+ */
+
+#include "project/traffic_stats.hpp"
+
+namespace project
+{
+  namespace
+  {
+    /**
+     * @brief One exported counter: its name, help text and snapshot field
+     */
+    struct CounterField
+    {
+      const char* name;
+      const char* help;
+      uint64_t TrafficStats::*value;
+    };
+
+    constexpr CounterField COUNTER_FIELDS[] = {
+      { "rx_frames", "Frames received", &TrafficStats::rx_frames },
+      { "rx_bytes", "Bytes received", &TrafficStats::rx_bytes },
+      { "tx_frames", "Frames sent", &TrafficStats::tx_frames },
+      { "tx_bytes", "Bytes sent", &TrafficStats::tx_bytes },
+      { "floods", "Frames flooded to all ports", &TrafficStats::floods },
+      { "unknown_unicast_drops", "Frames dropped for an unlearned destination MAC",
+        &TrafficStats::unknown_unicast_drops },
+      { "send_errors", "Frames the kernel failed to send", &TrafficStats::send_errors },
+      { "tap_partial_writes", "Frames only partially written to the TAP device", &TrafficStats::tap_partial_writes },
+      { "vlan_drops", "Frames dropped for a VLAN their port does not carry", &TrafficStats::vlan_drops },
+      { "multicast_drops", "Multicast frames no other port subscribed to", &TrafficStats::multicast_drops },
+      { "policed_drops", "Frames dropped for exceeding the ingress rate", &TrafficStats::policed_drops },
+      { "crypto_drops", "Datagrams dropped by tunnel authentication, replay or key checks",
+        &TrafficStats::crypto_drops },
+    };
+  }  // namespace
+
+  TrafficStats& TrafficStats::operator+=(const TrafficStats& other) noexcept
+  {
+    for (const auto& field : COUNTER_FIELDS)
+    {
+      this->*field.value += other.*field.value;
+    }
+    return *this;
+  }
+
+  TrafficCounters::TrafficCounters(const TrafficCounters& other) noexcept
+  {
+    *this = other;
+  }
+
+  TrafficCounters& TrafficCounters::operator=(const TrafficCounters& other) noexcept
+  {
+    TrafficStats values = other.snapshot();
+    rx_frames.store(values.rx_frames, std::memory_order_relaxed);
+    rx_bytes.store(values.rx_bytes, std::memory_order_relaxed);
+    tx_frames.store(values.tx_frames, std::memory_order_relaxed);
+    tx_bytes.store(values.tx_bytes, std::memory_order_relaxed);
+    floods.store(values.floods, std::memory_order_relaxed);
+    unknown_unicast_drops.store(values.unknown_unicast_drops, std::memory_order_relaxed);
+    send_errors.store(values.send_errors, std::memory_order_relaxed);
+    tap_partial_writes.store(values.tap_partial_writes, std::memory_order_relaxed);
+    vlan_drops.store(values.vlan_drops, std::memory_order_relaxed);
+    multicast_drops.store(values.multicast_drops, std::memory_order_relaxed);
+    policed_drops.store(values.policed_drops, std::memory_order_relaxed);
+    crypto_drops.store(values.crypto_drops, std::memory_order_relaxed);
+    return *this;
+  }
+
+  TrafficStats TrafficCounters::snapshot() const noexcept
+  {
+    TrafficStats stats;
+    stats.rx_frames = rx_frames.load(std::memory_order_relaxed);
+    stats.rx_bytes = rx_bytes.load(std::memory_order_relaxed);
+    stats.tx_frames = tx_frames.load(std::memory_order_relaxed);
+    stats.tx_bytes = tx_bytes.load(std::memory_order_relaxed);
+    stats.floods = floods.load(std::memory_order_relaxed);
+    stats.unknown_unicast_drops = unknown_unicast_drops.load(std::memory_order_relaxed);
+    stats.send_errors = send_errors.load(std::memory_order_relaxed);
+    stats.tap_partial_writes = tap_partial_writes.load(std::memory_order_relaxed);
+    stats.vlan_drops = vlan_drops.load(std::memory_order_relaxed);
+    stats.multicast_drops = multicast_drops.load(std::memory_order_relaxed);
+    stats.policed_drops = policed_drops.load(std::memory_order_relaxed);
+    stats.crypto_drops = crypto_drops.load(std::memory_order_relaxed);
+    return stats;
+  }
+
+  std::string format_prometheus(std::string_view prefix,
+                                const std::vector<std::pair<std::string, TrafficStats>>& series)
+  {
+    std::string out;
+    for (const auto& field : COUNTER_FIELDS)
+    {
+      std::string name = std::string(prefix) + "_" + field.name + "_total";
+      out += "# HELP " + name + " " + field.help + "\n";
+      out += "# TYPE " + name + " counter\n";
+      for (const auto& [labels, stats] : series)
+      {
+        out += name;
+        if (!labels.empty())
+        {
+          out += "{" + labels + "}";
+        }
+        out += " " + std::to_string(stats.*field.value) + "\n";
+      }
+    }
+    return out;
+  }
+
+}  // namespace project
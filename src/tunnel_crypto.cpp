@@ -0,0 +1,668 @@
+/**
+ * @file tunnel_crypto.cpp
+ * @brief Implementation of tunnel encryption
+ */
+
+#include "project/tunnel_crypto.hpp"
+
+#include "project/sys_utils.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#if PROJECT_HAVE_OPENSSL
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+#endif
+
+namespace project
+{
+  namespace
+  {
+    constexpr size_t NONCE_SIZE = 12;
+    constexpr char KDF_LABEL[] = "vswitch tunnel v1";
+
+    // Random low bits of a session number, below its start time in milliseconds
+    constexpr uint8_t SESSION_RANDOM_BITS = 20;
+
+    void put32(uint8_t* out, uint32_t value) noexcept
+    {
+      out[0] = static_cast<uint8_t>(value >> 24);
+      out[1] = static_cast<uint8_t>(value >> 16);
+      out[2] = static_cast<uint8_t>(value >> 8);
+      out[3] = static_cast<uint8_t>(value);
+    }
+
+    void put64(uint8_t* out, uint64_t value) noexcept
+    {
+      put32(out, static_cast<uint32_t>(value >> 32));
+      put32(out + 4, static_cast<uint32_t>(value));
+    }
+
+    uint32_t get32(const uint8_t* in) noexcept
+    {
+      return (static_cast<uint32_t>(in[0]) << 24) | (static_cast<uint32_t>(in[1]) << 16) |
+             (static_cast<uint32_t>(in[2]) << 8) | in[3];
+    }
+
+    uint64_t get64(const uint8_t* in) noexcept
+    {
+      return (static_cast<uint64_t>(get32(in)) << 32) | get32(in + 4);
+    }
+
+    // Nonce of a sequence number: four zero bytes, then the number
+    void make_nonce(uint64_t sequence, uint8_t* nonce) noexcept
+    {
+      std::memset(nonce, 0, NONCE_SIZE - 8);
+      put64(nonce + NONCE_SIZE - 8, sequence);
+    }
+
+    int hex_digit(char c) noexcept
+    {
+      if (c >= '0' && c <= '9')
+      {
+        return c - '0';
+      }
+      if (c >= 'a' && c <= 'f')
+      {
+        return c - 'a' + 10;
+      }
+      if (c >= 'A' && c <= 'F')
+      {
+        return c - 'A' + 10;
+      }
+      return -1;
+    }
+
+    std::string_view trim(std::string_view text) noexcept
+    {
+      const auto first = text.find_first_not_of(" \t\r");
+      if (first == std::string_view::npos)
+      {
+        return {};
+      }
+      const auto last = text.find_last_not_of(" \t\r");
+      return text.substr(first, last - first + 1);
+    }
+
+    TunnelRole peer_of(TunnelRole role) noexcept
+    {
+      return role == TunnelRole::Port ? TunnelRole::Switch : TunnelRole::Port;
+    }
+
+    void wipe(uint8_t* data, size_t size) noexcept
+    {
+#if PROJECT_HAVE_OPENSSL
+      OPENSSL_cleanse(data, size);
+#else
+      volatile uint8_t* bytes = data;
+      for (size_t i = 0; i < size; ++i)
+      {
+        bytes[i] = 0;
+      }
+#endif
+    }
+
+#if PROJECT_HAVE_OPENSSL
+    const EVP_CIPHER* evp_cipher(TunnelCipher cipher) noexcept
+    {
+      return cipher == TunnelCipher::ChaCha20Poly1305 ? EVP_chacha20_poly1305() : EVP_aes_256_gcm();
+    }
+#endif
+
+    // Milliseconds since the epoch with random low bits, and never twice the same in one process
+    uint64_t new_session() noexcept
+    {
+      static std::atomic<uint64_t> last{ 0 };
+
+      const auto now = std::chrono::system_clock::now().time_since_epoch();
+      uint64_t session = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(now).count())
+                         << SESSION_RANDOM_BITS;
+#if PROJECT_HAVE_OPENSSL
+      uint32_t random = 0;
+      if (RAND_bytes(reinterpret_cast<unsigned char*>(&random), sizeof(random)) == 1)
+      {
+        session |= random & ((uint32_t{ 1 } << SESSION_RANDOM_BITS) - 1);
+      }
+#endif
+
+      uint64_t previous = last.load();
+      while (!last.compare_exchange_weak(previous, std::max(session, previous + 1)))
+      {
+      }
+      return std::max(session, previous + 1);
+    }
+  }  // namespace
+
+  const char* to_string(TunnelCipher cipher) noexcept
+  {
+    switch (cipher)
+    {
+      case TunnelCipher::Aes256Gcm:
+        return "aes-256-gcm";
+      case TunnelCipher::ChaCha20Poly1305:
+        return "chacha20-poly1305";
+      default:
+        return "unknown";
+    }
+  }
+
+  std::optional<TunnelCipher> parse_tunnel_cipher(std::string_view name) noexcept
+  {
+    if (name == "aes-256-gcm")
+    {
+      return TunnelCipher::Aes256Gcm;
+    }
+    if (name == "chacha20-poly1305")
+    {
+      return TunnelCipher::ChaCha20Poly1305;
+    }
+    return std::nullopt;
+  }
+
+  const char* to_string(TunnelError error) noexcept
+  {
+    switch (error)
+    {
+      case TunnelError::Unsupported:
+        return "Encryption is not compiled in (needs OpenSSL)";
+      case TunnelError::InvalidKey:
+        return "Malformed tunnel key (expected '<id> <64 hex digits>')";
+      case TunnelError::DuplicateKey:
+        return "Tunnel key id listed twice";
+      case TunnelError::KeyFileFailed:
+        return "Failed to read the key file";
+      case TunnelError::CipherFailed:
+        return "Cipher operation failed";
+      case TunnelError::UnknownKey:
+        return "Datagram sealed with an unknown key";
+      case TunnelError::Malformed:
+        return "Datagram too short to be sealed";
+      case TunnelError::AuthenticationFailed:
+        return "Datagram failed authentication";
+      case TunnelError::Replayed:
+        return "Datagram replayed or from an old session";
+      case TunnelError::BufferTooSmall:
+        return "Buffer too small for the sealed datagram";
+      default:
+        return "Unknown tunnel error";
+    }
+  }
+
+  expected<std::vector<TunnelKey>, TunnelError> parse_tunnel_keys(std::string_view text)
+  {
+    std::vector<TunnelKey> keys;
+    while (!text.empty())
+    {
+      const size_t newline = text.find('\n');
+      std::string_view line = trim(text.substr(0, newline));
+      text = newline == std::string_view::npos ? std::string_view() : text.substr(newline + 1);
+      if (line.empty() || line.front() == '#')
+      {
+        continue;
+      }
+
+      TunnelKey key;
+      const char* end = line.data() + line.size();
+      auto [ptr, ec] = std::from_chars(line.data(), end, key.id);
+      if (ec != std::errc() || key.id == TUNNEL_NO_KEY || ptr == end || (*ptr != ' ' && *ptr != '\t'))
+      {
+        return unexpected(TunnelError::InvalidKey);
+      }
+      std::string_view hex = trim(std::string_view(ptr, static_cast<size_t>(end - ptr)));
+      if (hex.size() != 2 * TUNNEL_KEY_SIZE)
+      {
+        return unexpected(TunnelError::InvalidKey);
+      }
+      for (size_t i = 0; i < TUNNEL_KEY_SIZE; ++i)
+      {
+        const int high = hex_digit(hex[2 * i]);
+        const int low = hex_digit(hex[2 * i + 1]);
+        if (high < 0 || low < 0)
+        {
+          return unexpected(TunnelError::InvalidKey);
+        }
+        key.secret[i] = static_cast<uint8_t>((high << 4) | low);
+      }
+
+      if (std::any_of(keys.begin(), keys.end(), [&key](const TunnelKey& other) { return other.id == key.id; }))
+      {
+        return unexpected(TunnelError::DuplicateKey);
+      }
+      keys.push_back(key);
+    }
+    return keys;
+  }
+
+  expected<std::vector<TunnelKey>, TunnelError> load_tunnel_keys(const std::string& path)
+  {
+    FileDescriptor fd(::open(path.c_str(), O_RDONLY | O_CLOEXEC));
+    if (!fd)
+    {
+      return unexpected(TunnelError::KeyFileFailed);
+    }
+
+    std::string text;
+    char chunk[4096];
+    for (;;)
+    {
+      ssize_t n = ::read(fd.get(), chunk, sizeof(chunk));
+      if (n < 0 && errno == EINTR)
+      {
+        continue;
+      }
+      if (n < 0)
+      {
+        wipe(reinterpret_cast<uint8_t*>(text.data()), text.size());
+        return unexpected(TunnelError::KeyFileFailed);
+      }
+      if (n == 0)
+      {
+        break;
+      }
+      text.append(chunk, static_cast<size_t>(n));
+    }
+    wipe(reinterpret_cast<uint8_t*>(chunk), sizeof(chunk));
+
+    auto keys = parse_tunnel_keys(text);
+    wipe(reinterpret_cast<uint8_t*>(text.data()), text.size());
+    return keys;
+  }
+
+  // ReplayWindow implementation
+
+  bool ReplayWindow::accept(uint64_t sequence) noexcept
+  {
+    if (sequence >= next_)
+    {
+      // Slide forward, forgetting the slots the window moves past
+      if (sequence - next_ >= TUNNEL_REPLAY_WINDOW)
+      {
+        seen_.fill(0);
+      }
+      else
+      {
+        for (uint64_t slot = next_; slot <= sequence; ++slot)
+        {
+          seen_[(slot / 64) % WORDS] &= ~(uint64_t{ 1 } << (slot % 64));
+        }
+      }
+      next_ = sequence + 1;
+    }
+    else if (next_ - sequence > TUNNEL_REPLAY_WINDOW)
+    {
+      return false;  // Too far behind to tell
+    }
+
+    uint64_t& word = seen_[(sequence / 64) % WORDS];
+    const uint64_t bit = uint64_t{ 1 } << (sequence % 64);
+    if ((word & bit) != 0)
+    {
+      return false;
+    }
+    word |= bit;
+    return true;
+  }
+
+  // AeadCipher implementation
+
+  void AeadCipher::ContextDeleter::operator()(evp_cipher_ctx_st* context) const noexcept
+  {
+#if PROJECT_HAVE_OPENSSL
+    EVP_CIPHER_CTX_free(context);
+#else
+    static_cast<void>(context);
+#endif
+  }
+
+#if PROJECT_HAVE_OPENSSL
+  expected<AeadCipher, TunnelError> AeadCipher::create(TunnelCipher cipher, const uint8_t* key, bool encrypt)
+  {
+    AeadCipher result;
+    result.context_.reset(EVP_CIPHER_CTX_new());
+    EVP_CIPHER_CTX* context = result.context_.get();
+    const int enc = encrypt ? 1 : 0;
+    if (context == nullptr || EVP_CipherInit_ex(context, evp_cipher(cipher), nullptr, nullptr, nullptr, enc) != 1 ||
+        EVP_CIPHER_CTX_ctrl(context, EVP_CTRL_AEAD_SET_IVLEN, static_cast<int>(NONCE_SIZE), nullptr) != 1 ||
+        EVP_CipherInit_ex(context, nullptr, nullptr, key, nullptr, enc) != 1)
+    {
+      return unexpected(TunnelError::CipherFailed);
+    }
+    return result;
+  }
+
+  bool AeadCipher::seal(const uint8_t* nonce, const uint8_t* aad, size_t aad_size, const struct iovec* pieces,
+                        size_t count, uint8_t* out, uint8_t* tag) noexcept
+  {
+    EVP_CIPHER_CTX* context = context_.get();
+    int length = 0;
+    if (context == nullptr || EVP_CipherInit_ex(context, nullptr, nullptr, nullptr, nonce, -1) != 1 ||
+        EVP_CipherUpdate(context, nullptr, &length, aad, static_cast<int>(aad_size)) != 1)
+    {
+      return false;
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+      // Stream modes: every byte in comes straight out
+      if (EVP_CipherUpdate(context, out, &length, static_cast<const uint8_t*>(pieces[i].iov_base),
+                           static_cast<int>(pieces[i].iov_len)) != 1)
+      {
+        return false;
+      }
+      out += pieces[i].iov_len;
+    }
+    return EVP_CipherFinal_ex(context, out, &length) == 1 &&
+           EVP_CIPHER_CTX_ctrl(context, EVP_CTRL_AEAD_GET_TAG, static_cast<int>(TUNNEL_TAG_SIZE), tag) == 1;
+  }
+
+  bool AeadCipher::open(const uint8_t* nonce, const uint8_t* aad, size_t aad_size, const uint8_t* in, size_t size,
+                        uint8_t* out, const uint8_t* tag) noexcept
+  {
+    EVP_CIPHER_CTX* context = context_.get();
+    int length = 0;
+    return context != nullptr && EVP_CipherInit_ex(context, nullptr, nullptr, nullptr, nonce, -1) == 1 &&
+           EVP_CipherUpdate(context, nullptr, &length, aad, static_cast<int>(aad_size)) == 1 &&
+           EVP_CipherUpdate(context, out, &length, in, static_cast<int>(size)) == 1 &&
+           EVP_CIPHER_CTX_ctrl(context, EVP_CTRL_AEAD_SET_TAG, static_cast<int>(TUNNEL_TAG_SIZE),
+                               const_cast<uint8_t*>(tag)) == 1 &&
+           EVP_CipherFinal_ex(context, out + size, &length) == 1;
+  }
+#else
+  expected<AeadCipher, TunnelError> AeadCipher::create(TunnelCipher, const uint8_t*, bool)
+  {
+    return unexpected(TunnelError::Unsupported);
+  }
+
+  bool AeadCipher::seal(const uint8_t*, const uint8_t*, size_t, const struct iovec*, size_t, uint8_t*,
+                        uint8_t*) noexcept
+  {
+    return false;
+  }
+
+  bool AeadCipher::open(const uint8_t*, const uint8_t*, size_t, const uint8_t*, size_t, uint8_t*,
+                        const uint8_t*) noexcept
+  {
+    return false;
+  }
+#endif
+
+  // TunnelKeyring implementation
+
+  TunnelKeyring::TunnelKeyring(TunnelCipher cipher, TunnelRole role, uint64_t session)
+      : cipher_(cipher), role_(role), session_(session)
+  {
+  }
+
+  expected<std::unique_ptr<TunnelKeyring>, TunnelError> TunnelKeyring::create(TunnelCipher cipher, TunnelRole role,
+                                                                               const std::vector<TunnelKey>& keys)
+  {
+#if PROJECT_HAVE_OPENSSL
+    if (keys.empty())
+    {
+      return unexpected(TunnelError::InvalidKey);
+    }
+
+    std::unique_ptr<TunnelKeyring> keyring(new TunnelKeyring(cipher, role, new_session()));
+    for (const auto& key : keys)
+    {
+      if (key.id == TUNNEL_NO_KEY)
+      {
+        return unexpected(TunnelError::InvalidKey);
+      }
+      auto state = std::make_unique<KeyState>();
+      state->key = key;
+      if (!keyring->keys_.emplace(key.id, std::move(state)).second)
+      {
+        return unexpected(TunnelError::DuplicateKey);
+      }
+    }
+    return keyring;
+#else
+    static_cast<void>(cipher);
+    static_cast<void>(role);
+    static_cast<void>(keys);
+    return unexpected(TunnelError::Unsupported);
+#endif
+  }
+
+  bool TunnelKeyring::derive(uint32_t key_id, TunnelRole sender, uint64_t session, uint8_t* out) const noexcept
+  {
+#if PROJECT_HAVE_OPENSSL
+    auto it = keys_.find(key_id);
+    if (it == keys_.end())
+    {
+      return false;
+    }
+
+    // HKDF-Expand with the configured key as the PRK: one block, T(1) = HMAC(PRK, info | 0x01)
+    uint8_t info[sizeof(KDF_LABEL) + 1 + 8 + 1];
+    std::memcpy(info, KDF_LABEL, sizeof(KDF_LABEL));
+    info[sizeof(KDF_LABEL)] = static_cast<uint8_t>(sender);
+    put64(info + sizeof(KDF_LABEL) + 1, session);
+    info[sizeof(info) - 1] = 1;
+
+    unsigned int length = 0;
+    const auto& secret = it->second->key.secret;
+    return HMAC(EVP_sha256(), secret.data(), static_cast<int>(secret.size()), info, sizeof(info), out, &length) !=
+               nullptr &&
+           length == TUNNEL_KEY_SIZE;
+#else
+    static_cast<void>(key_id);
+    static_cast<void>(sender);
+    static_cast<void>(session);
+    static_cast<void>(out);
+    return false;
+#endif
+  }
+
+  uint64_t TunnelKeyring::next_sequence(uint32_t key_id) noexcept
+  {
+    return keys_.at(key_id)->next_sequence.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  bool TunnelKeyring::accept(uint32_t key_id, uint64_t session, uint64_t sequence) noexcept
+  {
+    auto it = keys_.find(key_id);
+    if (it == keys_.end())
+    {
+      return false;
+    }
+
+    KeyState& state = *it->second;
+    std::lock_guard<std::mutex> lock(state.receive_mutex);
+    if (session < state.receive_session)
+    {
+      return false;
+    }
+    if (session > state.receive_session)
+    {
+      // The peer restarted; whatever its old session sent is stale from now on
+      state.receive_session = session;
+      state.window = ReplayWindow();
+    }
+    return state.window.accept(sequence);
+  }
+
+  void TunnelKeyring::bind(const Endpoint& endpoint, uint32_t key_id)
+  {
+    std::lock_guard<std::mutex> lock(peers_mutex_);
+    auto [it, inserted] = peers_.emplace(endpoint, key_id);
+    if (inserted || it->second != key_id)
+    {
+      it->second = key_id;
+      peers_generation_.fetch_add(1, std::memory_order_acq_rel);
+    }
+  }
+
+  std::optional<uint32_t> TunnelKeyring::key_of(const Endpoint& endpoint) const
+  {
+    std::lock_guard<std::mutex> lock(peers_mutex_);
+    auto it = peers_.find(endpoint);
+    if (it == peers_.end())
+    {
+      return std::nullopt;
+    }
+    return it->second;
+  }
+
+  // TunnelContext implementation
+
+  expected<size_t, TunnelError> TunnelContext::seal(uint32_t key_id, const struct iovec* pieces, size_t count,
+                                                    uint8_t* out, size_t capacity)
+  {
+    if (keyring_ == nullptr || !keyring_->contains(key_id))
+    {
+      return unexpected(TunnelError::UnknownKey);
+    }
+
+    size_t size = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+      size += pieces[i].iov_len;
+    }
+    if (capacity < size + TUNNEL_OVERHEAD)
+    {
+      return unexpected(TunnelError::BufferTooSmall);
+    }
+
+    AeadCipher& cipher = senders_[key_id];
+    if (!cipher.is_valid())
+    {
+      uint8_t subkey[TUNNEL_KEY_SIZE];
+      if (!keyring_->derive(key_id, keyring_->role(), keyring_->session(), subkey))
+      {
+        return unexpected(TunnelError::CipherFailed);
+      }
+      auto created = AeadCipher::create(keyring_->cipher(), subkey, true);
+      wipe(subkey, sizeof(subkey));
+      if (!created)
+      {
+        return unexpected(created.error());
+      }
+      cipher = std::move(*created);
+    }
+
+    const uint64_t sequence = keyring_->next_sequence(key_id);
+    put32(out, key_id);
+    put64(out + 4, keyring_->session());
+    put64(out + 12, sequence);
+    uint8_t nonce[NONCE_SIZE];
+    make_nonce(sequence, nonce);
+    if (!cipher.seal(nonce, out, TUNNEL_HEADER_SIZE, pieces, count, out + TUNNEL_HEADER_SIZE,
+                     out + TUNNEL_HEADER_SIZE + size))
+    {
+      return unexpected(TunnelError::CipherFailed);
+    }
+    return size + TUNNEL_OVERHEAD;
+  }
+
+  expected<TunnelFrame, TunnelError> TunnelContext::open(uint8_t* datagram, size_t size)
+  {
+    if (size < TUNNEL_OVERHEAD)
+    {
+      return unexpected(TunnelError::Malformed);
+    }
+    const uint32_t key_id = get32(datagram);
+    if (keyring_ == nullptr || !keyring_->contains(key_id))
+    {
+      return unexpected(TunnelError::UnknownKey);
+    }
+    const uint64_t session = get64(datagram + 4);
+    const uint64_t sequence = get64(datagram + 12);
+
+    // A new session costs a key derivation, worth it only once the datagram is authentic
+    Receiver& receiver = receivers_[key_id];
+    if (receiver.cipher.is_valid() && session < receiver.session)
+    {
+      return unexpected(TunnelError::Replayed);
+    }
+    AeadCipher candidate;
+    AeadCipher* cipher = &receiver.cipher;
+    if (!receiver.cipher.is_valid() || session != receiver.session)
+    {
+      uint8_t subkey[TUNNEL_KEY_SIZE];
+      if (!keyring_->derive(key_id, peer_of(keyring_->role()), session, subkey))
+      {
+        return unexpected(TunnelError::CipherFailed);
+      }
+      auto created = AeadCipher::create(keyring_->cipher(), subkey, false);
+      wipe(subkey, sizeof(subkey));
+      if (!created)
+      {
+        return unexpected(created.error());
+      }
+      candidate = std::move(*created);
+      cipher = &candidate;
+    }
+
+    const size_t frame_size = size - TUNNEL_OVERHEAD;
+    uint8_t* frame = datagram + TUNNEL_HEADER_SIZE;
+    uint8_t nonce[NONCE_SIZE];
+    make_nonce(sequence, nonce);
+    if (!cipher->open(nonce, datagram, TUNNEL_HEADER_SIZE, frame, frame_size, frame, frame + frame_size))
+    {
+      return unexpected(TunnelError::AuthenticationFailed);
+    }
+    if (!keyring_->accept(key_id, session, sequence))
+    {
+      return unexpected(TunnelError::Replayed);
+    }
+
+    if (cipher == &candidate)
+    {
+      receiver.session = session;
+      receiver.cipher = std::move(candidate);
+    }
+    return TunnelFrame{ frame, frame_size, key_id };
+  }
+
+  size_t TunnelContext::open_batch(InboundDatagram* datagrams, size_t count, TunnelFrame* frames)
+  {
+    size_t opened = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+      frames[i] = TunnelFrame{};
+      if (datagrams[i].truncated)
+      {
+        continue;
+      }
+      auto frame = open(datagrams[i].data, datagrams[i].size);
+      if (frame)
+      {
+        frames[i] = *frame;
+        ++opened;
+      }
+    }
+    return opened;
+  }
+
+  size_t TunnelContext::seal_batch(OutboundDatagram* datagrams, const uint32_t* key_ids, size_t count, uint8_t* arena,
+                                   size_t stride)
+  {
+    size_t kept = 0;
+    struct iovec pieces[UDP_MAX_DATAGRAM_IOVECS];
+    for (size_t i = 0; i < count; ++i)
+    {
+      uint8_t* out = arena + i * stride;
+      const size_t piece_count = datagrams[i].to_iovecs(pieces);
+      auto sealed = seal(key_ids[i], pieces, piece_count, out, stride);
+      if (!sealed)
+      {
+        continue;
+      }
+      Endpoint destination = datagrams[i].destination;
+      datagrams[kept] = OutboundDatagram{ out, *sealed, destination };
+      ++kept;
+    }
+    return kept;
+  }
+
+}  // namespace project
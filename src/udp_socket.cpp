@@ -5,12 +5,43 @@
 
 #include "project/udp_socket.hpp"
 
+#include "project/packet_ring.hpp"
+
+#include <algorithm>
 #include <arpa/inet.h>
+#include <array>
+#include <cerrno>
+#include <chrono>
 #include <cstring>
+#include <fcntl.h>
+#include <limits>
 #include <netinet/in.h>
+#include <netinet/udp.h>
+#include <poll.h>
 #include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
+#ifdef __linux__
+// Older C libraries lack the UDP offload socket options (linux/udp.h)
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+// ... and the zero-copy send flags (Linux 4.14)
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+#include <linux/errqueue.h>
+#include <linux/filter.h>
+#endif
+
 namespace project
 {
   const char* to_string(UdpError error) noexcept
@@ -31,6 +62,10 @@ namespace project
         return "Failed to resolve address";
       case UdpError::InvalidSocket:
         return "Invalid socket";
+      case UdpError::SocketOptionFailed:
+        return "Failed to set socket option";
+      case UdpError::WouldBlock:
+        return "Socket not ready (non-blocking)";
       default:
         return "Unknown UDP error";
     }
@@ -38,9 +73,57 @@ namespace project
 
   // Endpoint implementation
 
+  Endpoint::Endpoint(std::string_view address, uint16_t port) noexcept : Endpoint()
+  {
+    addr_.v4.sin_port = htons(port);
+
+    // inet_pton needs a NUL-terminated string; addresses never exceed INET6_ADDRSTRLEN
+    char text[INET6_ADDRSTRLEN];
+    if (address.empty() || address.size() >= sizeof(text))
+    {
+      return;
+    }
+    std::memcpy(text, address.data(), address.size());
+    text[address.size()] = '\0';
+
+    if (inet_pton(AF_INET, text, &addr_.v4.sin_addr) == 1)
+    {
+      addr_.v4.sin_family = AF_INET;
+    }
+    else if (inet_pton(AF_INET6, text, &addr_.v6.sin6_addr) == 1)
+    {
+      addr_.v6.sin6_family = AF_INET6;
+    }
+    else
+    {
+      std::memset(&addr_.v6.sin6_addr, 0, sizeof(addr_.v6.sin6_addr));
+    }
+  }
+
+  std::string Endpoint::address() const
+  {
+    char text[INET6_ADDRSTRLEN];
+
+    if (family() == AF_INET && inet_ntop(AF_INET, &addr_.v4.sin_addr, text, sizeof(text)) != nullptr)
+    {
+      return text;
+    }
+
+    if (family() == AF_INET6 && inet_ntop(AF_INET6, &addr_.v6.sin6_addr, text, sizeof(text)) != nullptr)
+    {
+      return text;
+    }
+
+    return std::string();
+  }
+
   std::string Endpoint::to_string() const
   {
-    return address_ + ":" + std::to_string(port_);
+    if (family() == AF_INET6)
+    {
+      return "[" + address() + "]:" + std::to_string(port());
+    }
+    return address() + ":" + std::to_string(port());
   }
 
   std::ostream& operator<<(std::ostream& os, const Endpoint& endpoint)
@@ -51,6 +134,25 @@ namespace project
 
   // UdpSocket implementation
 
+  UdpSocket::UdpSocket() noexcept = default;
+
+  UdpSocket::UdpSocket(SocketHandle socket) noexcept : socket_(std::move(socket))
+  {
+  }
+
+  UdpSocket::UdpSocket(UdpSocket&& other) noexcept = default;
+
+  UdpSocket& UdpSocket::operator=(UdpSocket&& other) noexcept = default;
+
+  UdpSocket::~UdpSocket() = default;
+
+  void UdpSocket::close() noexcept
+  {
+    packet_ring_.reset();
+    socket_.close();
+    local_endpoint_ = Endpoint{};
+  }
+
   expected<UdpSocket, UdpError> UdpSocket::create()
   {
     int sockfd = ::socket(AF_INET, SOCK_DGRAM, 0);
@@ -62,71 +164,313 @@ namespace project
     return UdpSocket(SocketHandle(sockfd));
   }
 
-  expected<void, UdpError> UdpSocket::bind(std::string_view address, uint16_t port)
+  expected<UdpSocket, UdpError> UdpSocket::adopt(SocketHandle socket)
+  {
+    int type = 0;
+    socklen_t type_size = sizeof(type);
+    if (!socket || ::getsockopt(socket.get(), SOL_SOCKET, SO_TYPE, &type, &type_size) < 0 || type != SOCK_DGRAM)
+    {
+      return unexpected(UdpError::InvalidSocket);
+    }
+
+    const int flags = ::fcntl(socket.get(), F_GETFL);
+    if (flags < 0)
+    {
+      return unexpected(UdpError::InvalidSocket);
+    }
+
+    UdpSocket adopted(std::move(socket));
+    auto bound = adopted.bound_endpoint();
+    if (!bound || !bound->is_valid())
+    {
+      return unexpected(UdpError::InvalidSocket);
+    }
+    adopted.local_endpoint_ = *bound;
+    adopted.nonblocking_ = (flags & O_NONBLOCK) != 0;
+    return adopted;
+  }
+
+  expected<void, UdpError> UdpSocket::detach_socket_filter()
   {
     if (!is_valid())
     {
       return unexpected(UdpError::InvalidSocket);
     }
 
-    struct sockaddr_in addr;
-    std::memset(&addr, 0, sizeof(addr));
-    addr.sin_family = AF_INET;
-    addr.sin_port = htons(port);
+#ifdef __linux__
+    int unused = 0;
+    if (::setsockopt(socket_.get(), SOL_SOCKET, SO_DETACH_FILTER, &unused, sizeof(unused)) < 0 && errno != ENOENT)
+    {
+      return unexpected(UdpError::SocketOptionFailed);
+    }
+#endif
+    return expected<void, UdpError>();
+  }
+
+  expected<void, UdpError> UdpSocket::attach_packet_ring(PacketRing ring)
+  {
+    if (!is_valid() || !ring.is_valid())
+    {
+      return unexpected(UdpError::InvalidSocket);
+    }
+
+#ifdef __linux__
+    // The ring gets its own copy of every datagram; the socket's would only fill its buffer
+    struct sock_filter drop = BPF_STMT(BPF_RET | BPF_K, 0);
+    struct sock_fprog filter{};
+    filter.len = 1;
+    filter.filter = &drop;
+    if (::setsockopt(socket_.get(), SOL_SOCKET, SO_ATTACH_FILTER, &filter, sizeof(filter)) < 0)
+    {
+      return unexpected(UdpError::SocketOptionFailed);
+    }
+#endif
+
+    packet_ring_ = std::make_unique<PacketRing>(std::move(ring));
+    ring_fallback_.reserve(UDP_MAX_BATCH_SIZE);
+    return expected<void, UdpError>();
+  }
+
+  expected<void, UdpError> UdpSocket::bind(std::string_view address, uint16_t port)
+  {
+    if (!is_valid())
+    {
+      return unexpected(UdpError::InvalidSocket);
+    }
 
     // Convert address string to binary format
-    if (inet_pton(AF_INET, address.data(), &addr.sin_addr) != 1)
+    Endpoint local(address, port);
+    if (local.family() != AF_INET)
     {
       return unexpected(UdpError::AddressResolutionFailed);
     }
 
     // Bind the socket
-    if (::bind(socket_.get(), reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0)
+    if (::bind(socket_.get(), local.as_sockaddr(), local.sockaddr_size()) < 0)
     {
       return unexpected(UdpError::BindFailed);
     }
 
     // Store the local endpoint
-    local_endpoint_ = Endpoint(std::string(address), port);
+    local_endpoint_ = local;
 
     return expected<void, UdpError>();
   }
 
+  expected<void, UdpError> UdpSocket::set_reuse_port(bool enable)
+  {
+    if (!is_valid())
+    {
+      return unexpected(UdpError::InvalidSocket);
+    }
+
+    int value = enable ? 1 : 0;
+    if (::setsockopt(socket_.get(), SOL_SOCKET, SO_REUSEPORT, &value, sizeof(value)) < 0)
+    {
+      return unexpected(UdpError::SocketOptionFailed);
+    }
+
+    return expected<void, UdpError>();
+  }
+
+  expected<void, UdpError> UdpSocket::set_receive_timeout(std::chrono::microseconds timeout)
+  {
+    if (!is_valid())
+    {
+      return unexpected(UdpError::InvalidSocket);
+    }
+
+    struct timeval tv;
+    tv.tv_sec = timeout.count() / 1000000;
+    tv.tv_usec = timeout.count() % 1000000;
+    if (::setsockopt(socket_.get(), SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) < 0)
+    {
+      return unexpected(UdpError::SocketOptionFailed);
+    }
+    receive_timeout_ = timeout;
+
+    return expected<void, UdpError>();
+  }
+
+  expected<void, UdpError> UdpSocket::set_nonblocking(bool enable)
+  {
+    if (!is_valid())
+    {
+      return unexpected(UdpError::InvalidSocket);
+    }
+
+    if (!project::set_nonblocking(socket_.get(), enable))
+    {
+      return unexpected(UdpError::SocketOptionFailed);
+    }
+
+    nonblocking_ = enable;
+
+    return expected<void, UdpError>();
+  }
+
+  expected<void, UdpError> UdpSocket::set_receive_buffer_size(size_t bytes)
+  {
+    if (!is_valid())
+    {
+      return unexpected(UdpError::InvalidSocket);
+    }
+
+    int size = static_cast<int>(std::min(bytes, static_cast<size_t>(std::numeric_limits<int>::max())));
+    if (::setsockopt(socket_.get(), SOL_SOCKET, SO_RCVBUF, &size, sizeof(size)) < 0)
+    {
+      return unexpected(UdpError::SocketOptionFailed);
+    }
+
+    return expected<void, UdpError>();
+  }
+
+  expected<Endpoint, UdpError> UdpSocket::bound_endpoint() const
+  {
+    if (!is_valid())
+    {
+      return unexpected(UdpError::InvalidSocket);
+    }
+
+    Endpoint endpoint;
+    socklen_t length = Endpoint::sockaddr_capacity();
+    if (::getsockname(socket_.get(), endpoint.as_sockaddr(), &length) < 0)
+    {
+      return unexpected(UdpError::InvalidSocket);
+    }
+
+    return endpoint;
+  }
+
   expected<size_t, UdpError> UdpSocket::send_to(const std::vector<uint8_t>& data, const Endpoint& endpoint)
   {
     return send_to(data.data(), data.size(), endpoint);
   }
 
-  expected<size_t, UdpError> UdpSocket::send_to(const uint8_t* data, size_t size, const Endpoint& endpoint)
+  expected<void, UdpError> UdpSocket::set_gro(bool enable)
   {
     if (!is_valid())
     {
       return unexpected(UdpError::InvalidSocket);
     }
 
-    if (!endpoint.is_valid())
+#ifdef __linux__
+    int value = enable ? 1 : 0;
+    if (::setsockopt(socket_.get(), IPPROTO_UDP, UDP_GRO, &value, sizeof(value)) < 0)
     {
-      return unexpected(UdpError::InvalidEndpoint);
+      return unexpected(UdpError::SocketOptionFailed);
     }
+    return expected<void, UdpError>();
+#else
+    (void)enable;
+    return unexpected(UdpError::SocketOptionFailed);
+#endif
+  }
 
-    // Setup destination address
-    struct sockaddr_in dest_addr;
-    std::memset(&dest_addr, 0, sizeof(dest_addr));
-    dest_addr.sin_family = AF_INET;
-    dest_addr.sin_port = htons(endpoint.port());
+  expected<void, UdpError> UdpSocket::set_zerocopy(bool enable)
+  {
+    if (!is_valid())
+    {
+      return unexpected(UdpError::InvalidSocket);
+    }
 
-    if (inet_pton(AF_INET, endpoint.address().c_str(), &dest_addr.sin_addr) != 1)
+#ifdef __linux__
+    int value = enable ? 1 : 0;
+    if (::setsockopt(socket_.get(), SOL_SOCKET, SO_ZEROCOPY, &value, sizeof(value)) < 0)
     {
-      return unexpected(UdpError::AddressResolutionFailed);
+      return unexpected(UdpError::SocketOptionFailed);
+    }
+    zerocopy_ = enable;
+    return expected<void, UdpError>();
+#else
+    (void)enable;
+    return unexpected(UdpError::SocketOptionFailed);
+#endif
+  }
+
+  expected<size_t, UdpError> UdpSocket::reap_zerocopy(std::chrono::milliseconds timeout)
+  {
+    if (!is_valid())
+    {
+      return unexpected(UdpError::InvalidSocket);
+    }
+
+#ifdef __linux__
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (zerocopy_pending() > 0)
+    {
+      // Each notification covers a range of send numbers; the kernel merges consecutive ones
+      constexpr size_t control_size = CMSG_SPACE(sizeof(struct sock_extended_err) + sizeof(struct sockaddr_in6));
+      alignas(struct cmsghdr) std::array<char, control_size> control{};
+      struct msghdr msg{};
+      msg.msg_control = control.data();
+      msg.msg_controllen = control.size();
+
+      if (::recvmsg(socket_.get(), &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0)
+      {
+        if (errno == EINTR)
+        {
+          continue;
+        }
+        if (!would_block(errno))
+        {
+          return unexpected(UdpError::ReceiveFailed);
+        }
+
+        // Nothing queued yet: POLLERR signals the next notification
+        const auto left =
+            std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (left.count() <= 0)
+        {
+          break;
+        }
+        struct pollfd pfd{};
+        pfd.fd = socket_.get();
+        ::poll(&pfd, 1, static_cast<int>(left.count()));
+        continue;
+      }
+
+      for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg))
+      {
+        if ((cmsg->cmsg_level != SOL_IP || cmsg->cmsg_type != IP_RECVERR) &&
+            (cmsg->cmsg_level != SOL_IPV6 || cmsg->cmsg_type != IPV6_RECVERR))
+        {
+          continue;
+        }
+
+        struct sock_extended_err error;
+        std::memcpy(&error, CMSG_DATA(cmsg), sizeof(error));
+        if (error.ee_origin == SO_EE_ORIGIN_ZEROCOPY && error.ee_errno == 0)
+        {
+          zerocopy_completed_ += error.ee_data - error.ee_info + 1;
+        }
+      }
     }
+#else
+    (void)timeout;
+#endif
 
-    // Send the data
-    ssize_t sent = ::sendto(socket_.get(), data, size, 0, reinterpret_cast<struct sockaddr*>(&dest_addr),
-                            sizeof(dest_addr));
+    return zerocopy_pending();
+  }
+
+  expected<size_t, UdpError> UdpSocket::send_to(const uint8_t* data, size_t size, const Endpoint& endpoint)
+  {
+    if (!is_valid())
+    {
+      return unexpected(UdpError::InvalidSocket);
+    }
+
+    if (!endpoint.is_valid())
+    {
+      return unexpected(UdpError::InvalidEndpoint);
+    }
+
+    // Send the data straight to the pre-resolved destination address
+    ssize_t sent = ::sendto(socket_.get(), data, size, 0, endpoint.as_sockaddr(), endpoint.sockaddr_size());
 
     if (sent < 0)
     {
-      return unexpected(UdpError::SendFailed);
+      return unexpected(nonblocking_ && would_block(errno) ? UdpError::WouldBlock : UdpError::SendFailed);
     }
 
     return static_cast<size_t>(sent);
@@ -148,13 +492,13 @@ namespace project
 
     std::vector<uint8_t> buffer(max_size);
 
-    struct sockaddr_in sender_addr;
-    socklen_t sender_addr_len = sizeof(sender_addr);
-    std::memset(&sender_addr, 0, sizeof(sender_addr));
+    // The kernel writes the sender address directly into the endpoint
+    Endpoint sender_endpoint;
+    socklen_t sender_addr_len = Endpoint::sockaddr_capacity();
 
     // Receive data
-    ssize_t received = ::recvfrom(socket_.get(), buffer.data(), buffer.size(), 0,
-                                  reinterpret_cast<struct sockaddr*>(&sender_addr), &sender_addr_len);
+    ssize_t received =
+        ::recvfrom(socket_.get(), buffer.data(), buffer.size(), 0, sender_endpoint.as_sockaddr(), &sender_addr_len);
 
     if (received < 0)
     {
@@ -164,17 +508,478 @@ namespace project
     // Resize buffer to actual received size
     buffer.resize(static_cast<size_t>(received));
 
-    // Extract sender endpoint
-    char sender_ip[INET_ADDRSTRLEN];
-    if (inet_ntop(AF_INET, &sender_addr.sin_addr, sender_ip, INET_ADDRSTRLEN) == nullptr)
+    return std::make_pair(std::move(buffer), sender_endpoint);
+  }
+
+  expected<size_t, UdpError> UdpSocket::send_segments(const uint8_t* data, size_t size, size_t segment_size,
+                                                      const Endpoint& endpoint)
+  {
+    if (segment_size == 0 || size <= segment_size)
     {
-      return unexpected(UdpError::AddressResolutionFailed);
+      return send_to(data, size, endpoint);
+    }
+
+    if (!is_valid())
+    {
+      return unexpected(UdpError::InvalidSocket);
+    }
+
+    if (!endpoint.is_valid())
+    {
+      return unexpected(UdpError::InvalidEndpoint);
     }
 
-    Endpoint sender_endpoint(sender_ip, ntohs(sender_addr.sin_port));
+    // One GSO send must stay within a single (64 KiB) UDP datagram
+    constexpr size_t max_gso_bytes = 65000;
+    const size_t chunk_segments = std::max<size_t>(1, std::min(UDP_GSO_MAX_SEGMENTS, max_gso_bytes / segment_size));
+    const size_t chunk_bytes = chunk_segments * segment_size;
 
-    return std::make_pair(std::move(buffer), sender_endpoint);
+    size_t sent = 0;
+    while (sent < size)
+    {
+      const size_t chunk = std::min(chunk_bytes, size - sent);
+      bool segmented = false;
+
+#ifdef __linux__
+      if (chunk > segment_size)
+      {
+        struct iovec iov;
+        iov.iov_base = const_cast<uint8_t*>(data + sent);
+        iov.iov_len = chunk;
+
+        alignas(struct cmsghdr) std::array<char, CMSG_SPACE(sizeof(uint16_t))> control{};
+        struct msghdr msg{};
+        msg.msg_name = const_cast<struct sockaddr*>(endpoint.as_sockaddr());
+        msg.msg_namelen = endpoint.sockaddr_size();
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control.data();
+        msg.msg_controllen = control.size();
+
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = IPPROTO_UDP;
+        cmsg->cmsg_type = UDP_SEGMENT;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+        const auto gso_size = static_cast<uint16_t>(segment_size);
+        std::memcpy(CMSG_DATA(cmsg), &gso_size, sizeof(gso_size));
+
+        if (::sendmsg(socket_.get(), &msg, 0) >= 0)
+        {
+          segmented = true;
+        }
+        else if (errno != EINVAL && errno != EIO && errno != ENOPROTOOPT && errno != EMSGSIZE)
+        {
+          return unexpected(nonblocking_ && would_block(errno) ? UdpError::WouldBlock : UdpError::SendFailed);
+        }
+      }
+#endif
+
+      // No GSO (or a single datagram): the same datagrams, one syscall each
+      for (size_t offset = 0; !segmented && offset < chunk; offset += segment_size)
+      {
+        auto result = send_to(data + sent + offset, std::min(segment_size, chunk - offset), endpoint);
+        if (!result)
+        {
+          return unexpected(result.error());
+        }
+      }
+
+      sent += chunk;
+    }
+
+    return sent;
   }
 
-}  // namespace project
+  expected<Endpoint, UdpError> UdpSocket::receive_from(FrameBuffer& buffer, size_t& segment_size)
+  {
+#ifdef __linux__
+    if (!is_valid())
+    {
+      return unexpected(UdpError::InvalidSocket);
+    }
 
+    if (!buffer.is_valid())
+    {
+      return unexpected(UdpError::ReceiveFailed);
+    }
+
+    Endpoint sender_endpoint;
+    struct iovec iov;
+    iov.iov_base = buffer.data();
+    iov.iov_len = buffer.capacity();
+
+    alignas(struct cmsghdr) std::array<char, CMSG_SPACE(sizeof(int))> control{};
+    struct msghdr msg{};
+    msg.msg_name = sender_endpoint.as_sockaddr();
+    msg.msg_namelen = Endpoint::sockaddr_capacity();
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.data();
+    msg.msg_controllen = control.size();
+
+    ssize_t received = ::recvmsg(socket_.get(), &msg, 0);
+    if (received < 0)
+    {
+      buffer.set_size(0);
+      return unexpected(nonblocking_ && would_block(errno) ? UdpError::WouldBlock : UdpError::ReceiveFailed);
+    }
+
+    buffer.set_size(static_cast<size_t>(received));
+    segment_size = buffer.size();
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg))
+    {
+      if (cmsg->cmsg_level == IPPROTO_UDP && cmsg->cmsg_type == UDP_GRO)
+      {
+        int gso_size = 0;
+        std::memcpy(&gso_size, CMSG_DATA(cmsg), sizeof(gso_size));
+        if (gso_size > 0)
+        {
+          segment_size = static_cast<size_t>(gso_size);
+        }
+      }
+    }
+
+    return sender_endpoint;
+#else
+    auto result = receive_from(buffer);
+    segment_size = buffer.size();
+    return result;
+#endif
+  }
+
+  expected<Endpoint, UdpError> UdpSocket::receive_from(FrameBuffer& buffer)
+  {
+    if (!is_valid())
+    {
+      return unexpected(UdpError::InvalidSocket);
+    }
+
+    if (!buffer.is_valid())
+    {
+      return unexpected(UdpError::ReceiveFailed);
+    }
+
+    Endpoint sender_endpoint;
+    socklen_t sender_addr_len = Endpoint::sockaddr_capacity();
+
+    ssize_t received = ::recvfrom(socket_.get(), buffer.data(), buffer.capacity(), 0, sender_endpoint.as_sockaddr(),
+                                  &sender_addr_len);
+
+    if (received < 0)
+    {
+      buffer.set_size(0);
+      return unexpected(nonblocking_ && would_block(errno) ? UdpError::WouldBlock : UdpError::ReceiveFailed);
+    }
+
+    buffer.set_size(static_cast<size_t>(received));
+
+    return sender_endpoint;
+  }
+
+  expected<size_t, UdpError> UdpSocket::receive_batch(std::vector<InboundDatagram>& datagrams)
+  {
+    return receive_batch(datagrams.data(), datagrams.size());
+  }
+
+  expected<size_t, UdpError> UdpSocket::receive_batch(InboundDatagram* datagrams, size_t count)
+  {
+    if (!is_valid())
+    {
+      return unexpected(UdpError::InvalidSocket);
+    }
+
+    count = std::min(count, UDP_MAX_BATCH_SIZE);
+    if (count == 0)
+    {
+      return size_t{ 0 };
+    }
+
+    if (packet_ring_)
+    {
+      // Same contract as a timed-out recvmmsg(); whole milliseconds, rounded up
+      int timeout_ms = -1;
+      if (nonblocking_)
+      {
+        timeout_ms = 0;
+      }
+      else if (receive_timeout_.count() > 0)
+      {
+        timeout_ms = static_cast<int>(std::min<int64_t>((receive_timeout_.count() + 999) / 1000, INT32_MAX));
+      }
+      size_t filled = packet_ring_->receive(datagrams, count, timeout_ms);
+      if (filled == 0)
+      {
+        return unexpected(nonblocking_ ? UdpError::WouldBlock : UdpError::ReceiveFailed);
+      }
+      return filled;
+    }
+
+#ifdef __linux__
+    std::array<struct mmsghdr, UDP_MAX_BATCH_SIZE> msgs;
+    std::array<struct iovec, UDP_MAX_BATCH_SIZE> iovs;
+    std::memset(msgs.data(), 0, count * sizeof(struct mmsghdr));
+
+    for (size_t i = 0; i < count; ++i)
+    {
+      iovs[i].iov_base = datagrams[i].data;
+      iovs[i].iov_len = datagrams[i].capacity;
+      msgs[i].msg_hdr.msg_iov = &iovs[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+      msgs[i].msg_hdr.msg_name = datagrams[i].sender.as_sockaddr();
+      msgs[i].msg_hdr.msg_namelen = Endpoint::sockaddr_capacity();
+    }
+
+    // Block for the first datagram only, then drain whatever is already queued
+    int received;
+    do
+    {
+      received = ::recvmmsg(socket_.get(), msgs.data(), static_cast<unsigned int>(count), MSG_WAITFORONE, nullptr);
+    } while (received < 0 && errno == EINTR);
+
+    if (received < 0)
+    {
+      return unexpected(nonblocking_ && would_block(errno) ? UdpError::WouldBlock : UdpError::ReceiveFailed);
+    }
+
+    for (size_t i = 0; i < static_cast<size_t>(received); ++i)
+    {
+      datagrams[i].size = msgs[i].msg_len;
+      datagrams[i].truncated = (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) != 0;
+    }
+#else
+    // Portable fallback: one blocking recvfrom, then non-blocking drains
+    int received = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+      socklen_t addr_len = Endpoint::sockaddr_capacity();
+      ssize_t n = ::recvfrom(socket_.get(), datagrams[i].data, datagrams[i].capacity, i == 0 ? 0 : MSG_DONTWAIT,
+                             datagrams[i].sender.as_sockaddr(), &addr_len);
+      if (n < 0)
+      {
+        if (i == 0)
+        {
+          return unexpected(UdpError::ReceiveFailed);
+        }
+        break;
+      }
+
+      datagrams[i].size = static_cast<size_t>(n);
+      datagrams[i].truncated = false;
+      ++received;
+    }
+#endif
+
+    return static_cast<size_t>(received);
+  }
+
+  size_t OutboundDatagram::to_iovecs(struct iovec* iov) const noexcept
+  {
+    if (!spliced())
+    {
+      iov[0].iov_base = const_cast<uint8_t*>(data);
+      iov[0].iov_len = size;
+      return 1;
+    }
+
+    const size_t at = std::min<size_t>(splice_at, size);
+    const size_t resume = at + std::min<size_t>(splice_cut, size - at);
+    size_t count = 0;
+    if (at > 0)
+    {
+      iov[count].iov_base = const_cast<uint8_t*>(data);
+      iov[count++].iov_len = at;
+    }
+    if (splice_size > 0)
+    {
+      iov[count].iov_base = const_cast<uint8_t*>(splice_bytes.data());
+      iov[count++].iov_len = std::min<size_t>(splice_size, splice_bytes.size());
+    }
+    if (resume < size)
+    {
+      iov[count].iov_base = const_cast<uint8_t*>(data + resume);
+      iov[count++].iov_len = size - resume;
+    }
+    return count;
+  }
+
+  expected<size_t, UdpError> UdpSocket::send_batch(const std::vector<OutboundDatagram>& datagrams)
+  {
+    return send_batch(datagrams.data(), datagrams.size());
+  }
+
+  expected<size_t, UdpError> UdpSocket::send_batch(const OutboundDatagram* datagrams, size_t count)
+  {
+    if (!is_valid())
+    {
+      return unexpected(UdpError::InvalidSocket);
+    }
+
+    if (packet_ring_)
+    {
+      ring_fallback_.clear();
+      size_t sent = packet_ring_->send(datagrams, count, ring_fallback_);
+      if (!ring_fallback_.empty())
+      {
+        sent += send_batch_syscalls(ring_fallback_.data(), ring_fallback_.size());
+      }
+      return sent;
+    }
+    return send_batch_syscalls(datagrams, count);
+  }
+
+  size_t UdpSocket::send_batch_syscalls(const OutboundDatagram* datagrams, size_t count)
+  {
+    size_t sent = 0;
+
+#ifdef __linux__
+    std::array<struct mmsghdr, UDP_MAX_BATCH_SIZE> msgs;
+    std::array<struct iovec, UDP_MAX_BATCH_SIZE * UDP_MAX_DATAGRAM_IOVECS> iovs;
+
+    size_t next = 0;
+    while (next < count)
+    {
+      // Build the next chunk, skipping datagrams with unusable destinations
+      size_t chunk = 0;
+      for (; next < count && chunk < UDP_MAX_BATCH_SIZE; ++next)
+      {
+        const auto& datagram = datagrams[next];
+        if (!datagram.destination.is_valid())
+        {
+          continue;
+        }
+
+        struct iovec* iov = &iovs[chunk * UDP_MAX_DATAGRAM_IOVECS];
+        std::memset(&msgs[chunk], 0, sizeof(struct mmsghdr));
+        msgs[chunk].msg_hdr.msg_iov = iov;
+        msgs[chunk].msg_hdr.msg_iovlen = datagram.to_iovecs(iov);
+        msgs[chunk].msg_hdr.msg_name = const_cast<struct sockaddr*>(datagram.destination.as_sockaddr());
+        msgs[chunk].msg_hdr.msg_namelen = datagram.destination.sockaddr_size();
+        ++chunk;
+      }
+
+      // sendmmsg stops at the first failing message; drop it and carry on
+      size_t offset = 0;
+      while (offset < chunk)
+      {
+        int n = ::sendmmsg(socket_.get(), msgs.data() + offset, static_cast<unsigned int>(chunk - offset), 0);
+        if (n < 0)
+        {
+          if (errno != EINTR)
+          {
+            ++offset;
+          }
+          continue;
+        }
+
+        sent += static_cast<size_t>(n);
+        offset += static_cast<size_t>(n);
+      }
+    }
+#else
+    for (size_t i = 0; i < count; ++i)
+    {
+      const auto& datagram = datagrams[i];
+      if (!datagram.destination.is_valid())
+      {
+        continue;
+      }
+
+      struct iovec iov[UDP_MAX_DATAGRAM_IOVECS];
+      struct msghdr message{};
+      message.msg_name = const_cast<struct sockaddr*>(datagram.destination.as_sockaddr());
+      message.msg_namelen = datagram.destination.sockaddr_size();
+      message.msg_iov = iov;
+      message.msg_iovlen = static_cast<int>(datagram.to_iovecs(iov));
+      if (::sendmsg(socket_.get(), &message, 0) >= 0)
+      {
+        ++sent;
+      }
+    }
+#endif
+
+    return sent;
+  }
+
+  expected<size_t, UdpError> UdpSocket::send_to_many(const uint8_t* data, size_t size,
+                                                     const std::vector<Endpoint>& destinations)
+  {
+    return send_to_many(data, size, destinations.data(), destinations.size());
+  }
+
+  expected<size_t, UdpError> UdpSocket::send_to_many(const uint8_t* data, size_t size, const Endpoint* destinations,
+                                                     size_t count)
+  {
+    if (!is_valid())
+    {
+      return unexpected(UdpError::InvalidSocket);
+    }
+
+    size_t sent = 0;
+
+#ifdef __linux__
+    std::array<struct mmsghdr, UDP_MAX_BATCH_SIZE> msgs;
+    struct iovec iov;
+    iov.iov_base = const_cast<uint8_t*>(data);
+    iov.iov_len = size;
+    int flags = zerocopy_ && size >= UDP_ZEROCOPY_MIN_SIZE ? MSG_ZEROCOPY : 0;
+
+    size_t next = 0;
+    while (next < count)
+    {
+      // Build the next chunk, skipping unusable destinations; every message shares the one iovec
+      size_t chunk = 0;
+      for (; next < count && chunk < UDP_MAX_BATCH_SIZE; ++next)
+      {
+        const Endpoint& destination = destinations[next];
+        if (!destination.is_valid())
+        {
+          continue;
+        }
+
+        std::memset(&msgs[chunk], 0, sizeof(struct mmsghdr));
+        msgs[chunk].msg_hdr.msg_iov = &iov;
+        msgs[chunk].msg_hdr.msg_iovlen = 1;
+        msgs[chunk].msg_hdr.msg_name = const_cast<struct sockaddr*>(destination.as_sockaddr());
+        msgs[chunk].msg_hdr.msg_namelen = destination.sockaddr_size();
+        ++chunk;
+      }
+
+      size_t offset = 0;
+      while (offset < chunk)
+      {
+        int n = ::sendmmsg(socket_.get(), msgs.data() + offset, static_cast<unsigned int>(chunk - offset), flags);
+        if (n < 0)
+        {
+          if (errno == ENOBUFS && flags != 0)
+          {
+            flags = 0;  // Out of pinned-page budget (optmem_max): copy the rest
+          }
+          else if (errno != EINTR)
+          {
+            ++offset;
+          }
+          continue;
+        }
+
+        if (flags != 0)
+        {
+          zerocopy_issued_ += static_cast<uint32_t>(n);
+        }
+        sent += static_cast<size_t>(n);
+        offset += static_cast<size_t>(n);
+      }
+    }
+#else
+    for (size_t i = 0; i < count; ++i)
+    {
+      if (send_to(data, size, destinations[i]))
+      {
+        ++sent;
+      }
+    }
+#endif
+
+    return sent;
+  }
+
+}  // namespace project
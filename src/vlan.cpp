@@ -0,0 +1,330 @@
+/**
+ * @file vlan.cpp
+ * @brief Implementation of VLAN port membership
+ */
+
+#include "project/vlan.hpp"
+
+#include "project/ethernet_frame.hpp"
+
+#include <charconv>
+
+namespace project
+{
+  namespace
+  {
+    constexpr size_t TAG_OFFSET = 2 * MAC_ADDRESS_SIZE;  // The tag sits where the EtherType would
+    constexpr uint16_t PRIORITY_MASK = 0xf000;           // PCP and DEI bits of a TCI
+
+    uint16_t read16(const uint8_t* data) noexcept
+    {
+      return static_cast<uint16_t>((data[0] << 8) | data[1]);
+    }
+
+    bool is_tag(uint16_t ethertype) noexcept
+    {
+      return ethertype == EtherType::VLAN || ethertype == EtherType::QinQ;
+    }
+
+    expected<uint16_t, VlanError> parse_number(std::string_view text, uint16_t min, uint16_t max)
+    {
+      uint16_t value = 0;
+      const char* end = text.data() + text.size();
+      auto [ptr, ec] = std::from_chars(text.data(), end, value);
+      if (text.empty() || ec != std::errc() || ptr != end || value < min || value > max)
+      {
+        return unexpected(VlanError::InvalidVlanId);
+      }
+      return value;
+    }
+
+    /**
+     * @brief Parse "ADDRESS", "ADDRESS:PORT", "[ADDRESS]" or "[ADDRESS]:PORT"
+     */
+    expected<Endpoint, VlanError> parse_port_endpoint(std::string_view text)
+    {
+      std::string_view address = text;
+      std::string_view port;
+      if (!text.empty() && text.front() == '[')
+      {
+        size_t close = text.find(']');
+        if (close == std::string_view::npos)
+        {
+          return unexpected(VlanError::InvalidAddress);
+        }
+        address = text.substr(1, close - 1);
+        std::string_view rest = text.substr(close + 1);
+        if (!rest.empty())
+        {
+          if (rest.front() != ':')
+          {
+            return unexpected(VlanError::InvalidAddress);
+          }
+          port = rest.substr(1);
+        }
+      }
+      else if (size_t colon = text.find(':'); colon != std::string_view::npos && text.rfind(':') == colon)
+      {
+        // Exactly one colon: IPv4 with a port (a bare IPv6 address has several)
+        address = text.substr(0, colon);
+        port = text.substr(colon + 1);
+      }
+
+      uint16_t port_number = 0;
+      if (!port.empty())
+      {
+        auto [ptr, ec] = std::from_chars(port.data(), port.data() + port.size(), port_number);
+        if (ec != std::errc() || ptr != port.data() + port.size())
+        {
+          return unexpected(VlanError::InvalidAddress);
+        }
+      }
+
+      Endpoint endpoint(address, port_number);
+      if (endpoint.family() != AF_INET && endpoint.family() != AF_INET6)
+      {
+        return unexpected(VlanError::InvalidAddress);
+      }
+      return endpoint;
+    }
+
+    /**
+     * @brief Parse "all" (an empty list) or "10,20-29"
+     */
+    expected<std::vector<uint16_t>, VlanError> parse_vlan_list(std::string_view text)
+    {
+      std::vector<uint16_t> vlans;
+      if (text == "all")
+      {
+        return vlans;
+      }
+
+      while (true)
+      {
+        size_t comma = text.find(',');
+        std::string_view item = text.substr(0, comma);
+        size_t dash = item.find('-');
+        auto first = parse_vlan_id(item.substr(0, dash));
+        auto last = parse_vlan_id(dash == std::string_view::npos ? item : item.substr(dash + 1));
+        if (!first || !last || *last < *first)
+        {
+          return unexpected(VlanError::InvalidVlanId);
+        }
+        for (uint32_t vlan = *first; vlan <= *last; ++vlan)
+        {
+          vlans.push_back(static_cast<uint16_t>(vlan));
+        }
+
+        if (comma == std::string_view::npos)
+        {
+          return vlans;
+        }
+        text.remove_prefix(comma + 1);
+      }
+    }
+  }  // namespace
+
+  const char* to_string(VlanError error) noexcept
+  {
+    switch (error)
+    {
+      case VlanError::InvalidSpec:
+        return "Invalid VLAN port specification";
+      case VlanError::InvalidAddress:
+        return "Invalid VLAN port address";
+      case VlanError::InvalidVlanId:
+        return "Invalid VLAN ID";
+      case VlanError::DuplicatePort:
+        return "VLAN port configured twice";
+      default:
+        return "Unknown VLAN error";
+    }
+  }
+
+  expected<uint16_t, VlanError> parse_vlan_id(std::string_view text)
+  {
+    return parse_number(text, 1, VLAN_MAX_ID);
+  }
+
+  expected<VlanPortConfig, VlanError> parse_vlan_port(VlanMode mode, std::string_view spec)
+  {
+    size_t equals = spec.rfind('=');
+    if (equals == std::string_view::npos)
+    {
+      return unexpected(VlanError::InvalidSpec);
+    }
+
+    auto endpoint = parse_port_endpoint(spec.substr(0, equals));
+    if (!endpoint)
+    {
+      return unexpected(endpoint.error());
+    }
+
+    VlanPortConfig config;
+    config.endpoint = *endpoint;
+    config.mode = mode;
+    std::string_view vlans = spec.substr(equals + 1);
+
+    if (mode == VlanMode::Access)
+    {
+      auto vlan = parse_vlan_id(vlans);
+      if (!vlan)
+      {
+        return unexpected(vlan.error());
+      }
+      config.vlan = *vlan;
+      return config;
+    }
+
+    config.vlan = 0;
+    if (size_t slash = vlans.find('/'); slash != std::string_view::npos)
+    {
+      auto native = parse_vlan_id(vlans.substr(slash + 1));
+      if (!native)
+      {
+        return unexpected(native.error());
+      }
+      config.vlan = *native;
+      vlans = vlans.substr(0, slash);
+    }
+
+    auto allowed = parse_vlan_list(vlans);
+    if (!allowed)
+    {
+      return unexpected(allowed.error());
+    }
+    config.allowed = std::move(*allowed);
+    return config;
+  }
+
+  VlanPort VlanPort::access(uint16_t vlan) noexcept
+  {
+    VlanPort port;
+    port.untagged_ = vlan;
+    return port;
+  }
+
+  VlanPort VlanPort::trunk(uint16_t native, const std::vector<uint16_t>& allowed) noexcept
+  {
+    VlanPort port;
+    port.mode_ = VlanMode::Trunk;
+    port.untagged_ = native;
+    if (allowed.empty())
+    {
+      port.tagged_.set();
+      port.tagged_.reset(0);
+      port.tagged_.reset(VLAN_VID_MASK);
+    }
+    for (uint16_t vlan : allowed)
+    {
+      port.tagged_.set(vlan & VLAN_VID_MASK);
+    }
+    return port;
+  }
+
+  uint16_t VlanPort::ingress_vlan(const uint8_t* frame, size_t size) const noexcept
+  {
+    uint16_t vid = 0;
+    if (is_tag(read16(frame + TAG_OFFSET)))
+    {
+      if (size < ETHERNET_HEADER_SIZE + VLAN_TAG_SIZE)
+      {
+        return 0;
+      }
+      vid = read16(frame + TAG_OFFSET + 2) & VLAN_VID_MASK;
+    }
+
+    if (vid == 0)
+    {
+      return untagged_;  // 0 on a trunk without a native VLAN
+    }
+    return member(vid) ? vid : 0;
+  }
+
+  expected<VlanMap, VlanError> VlanMap::create(const std::vector<VlanPortConfig>& ports, uint16_t default_vlan)
+  {
+    if (default_vlan < 1 || default_vlan > VLAN_MAX_ID)
+    {
+      return unexpected(VlanError::InvalidVlanId);
+    }
+
+    VlanMap map;
+    map.default_port_ = VlanPort::access(default_vlan);
+    map.ports_.reserve(ports.size());
+
+    for (const auto& config : ports)
+    {
+      const bool access = config.mode == VlanMode::Access;
+      if (config.vlan > VLAN_MAX_ID || (access && config.vlan == 0))
+      {
+        return unexpected(VlanError::InvalidVlanId);
+      }
+      for (uint16_t vlan : config.allowed)
+      {
+        if (vlan < 1 || vlan > VLAN_MAX_ID)
+        {
+          return unexpected(VlanError::InvalidVlanId);
+        }
+      }
+
+      auto& index = config.endpoint.port() == 0 ? map.by_address_ : map.exact_;
+      if (!index.emplace(config.endpoint, map.ports_.size()).second)
+      {
+        return unexpected(VlanError::DuplicatePort);
+      }
+      map.ports_.push_back(access ? VlanPort::access(config.vlan) : VlanPort::trunk(config.vlan, config.allowed));
+    }
+    return map;
+  }
+
+  const VlanPort& VlanMap::port(const Endpoint& endpoint) const noexcept
+  {
+    if (!exact_.empty())
+    {
+      if (auto it = exact_.find(endpoint); it != exact_.end())
+      {
+        return ports_[it->second];
+      }
+    }
+    if (!by_address_.empty())
+    {
+      if (auto it = by_address_.find(endpoint.with_port(0)); it != by_address_.end())
+      {
+        return ports_[it->second];
+      }
+    }
+    return default_port_;
+  }
+
+  void set_vlan_egress(OutboundDatagram& datagram, uint16_t vlan, bool tagged) noexcept
+  {
+    const uint8_t* frame = datagram.data;
+    const bool frame_tagged = is_tag(read16(frame + TAG_OFFSET));
+    const uint16_t tci = frame_tagged ? read16(frame + TAG_OFFSET + 2) : 0;
+
+    if (!tagged)
+    {
+      if (frame_tagged)
+      {
+        datagram.splice_at = TAG_OFFSET;
+        datagram.splice_cut = VLAN_TAG_SIZE;
+      }
+      return;
+    }
+
+    if (frame_tagged && read16(frame + TAG_OFFSET) == EtherType::VLAN && (tci & VLAN_VID_MASK) == vlan)
+    {
+      return;  // Already tagged as it should be
+    }
+
+    const uint16_t out_tci = static_cast<uint16_t>((tci & PRIORITY_MASK) | (vlan & VLAN_VID_MASK));
+    datagram.splice_at = TAG_OFFSET;
+    datagram.splice_cut = frame_tagged ? VLAN_TAG_SIZE : 0;
+    datagram.splice_size = VLAN_TAG_SIZE;
+    datagram.splice_bytes[0] = static_cast<uint8_t>(EtherType::VLAN >> 8);
+    datagram.splice_bytes[1] = static_cast<uint8_t>(EtherType::VLAN);
+    datagram.splice_bytes[2] = static_cast<uint8_t>(out_tci >> 8);
+    datagram.splice_bytes[3] = static_cast<uint8_t>(out_tci);
+  }
+
+}  // namespace project
@@ -5,10 +5,57 @@
 
 #include "project/vport.hpp"
 
-#include <iostream>
+#include "project/logger.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <poll.h>
 
 namespace project
 {
+  namespace
+  {
+    uint64_t steady_now_ns() noexcept
+    {
+      return static_cast<uint64_t>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+              .count());
+    }
+  }  // namespace
+
+#if PROJECT_HAVE_IO_URING
+  namespace
+  {
+    // Request kinds in the CQE tags of the forwarder ring
+    constexpr uint8_t URING_TAP_READ = 1;
+    constexpr uint8_t URING_SOCKET_RECEIVE = 2;
+    constexpr uint8_t URING_SOCKET_SEND = 3;
+    constexpr uint8_t URING_TAP_WRITE = 4;
+    constexpr uint8_t URING_CANCEL = 5;
+
+    // Frames held by the kernel or in flight, across both directions
+    constexpr uint16_t URING_BUFFER_COUNT = 256;
+    constexpr uint32_t URING_SEND_SLOTS = 256;
+  }  // namespace
+
+  struct VPort::UringState
+  {
+    IoUring ring;
+    IoUringBufferRing buffers;
+    bool fixed_buffers = false;  // The buffer arena is also registered for IORING_OP_WRITE_FIXED
+    IoUringSendSlots slots{ URING_SEND_SLOTS };
+#if PROJECT_LATENCY_HISTOGRAMS
+    std::vector<uint64_t> rx_ticks = std::vector<uint64_t>(URING_BUFFER_COUNT);  // By buffer id
+#endif
+  };
+#else
+  struct VPort::UringState
+  {
+  };
+#endif
+
   const char* to_string(VPortError error) noexcept
   {
     switch (error)
@@ -23,6 +70,12 @@ namespace project
         return "VPort is already running";
       case VPortError::NotRunning:
         return "VPort is not running";
+      case VPortError::EventLoopFailed:
+        return "Failed to attach VPort to event loop";
+      case VPortError::EncryptionFailed:
+        return "Failed to set up tunnel encryption";
+      case VPortError::CoalescingFailed:
+        return "Failed to set up frame coalescing";
       default:
         return "Unknown VPort error";
     }
@@ -33,6 +86,9 @@ namespace project
         udp_socket_(std::move(udp_socket)),
         vswitch_endpoint_(std::move(vswitch_endpoint)),
         device_name_(std::move(device_name)),
+        frame_pool_(tap_device_.offloads_enabled() ? std::make_unique<FramePool>(3, OFFLOAD_BUFFER_SIZE)
+                                                   : std::make_unique<FramePool>(2)),
+        segment_buffer_(tap_device_.offloads_enabled() ? frame_pool_->acquire() : FrameBuffer()),
         running_(false)
   {
   }
@@ -42,10 +98,35 @@ namespace project
         udp_socket_(std::move(other.udp_socket_)),
         vswitch_endpoint_(std::move(other.vswitch_endpoint_)),
         device_name_(std::move(other.device_name_)),
+        frame_pool_(std::move(other.frame_pool_)),
+        segment_buffer_(std::move(other.segment_buffer_)),
+        tap_buffer_(std::move(other.tap_buffer_)),
+        switch_buffer_(std::move(other.switch_buffer_)),
+        event_loop_(other.event_loop_),
+        uring_(std::move(other.uring_)),
+        tunnel_(std::move(other.tunnel_)),
+        tunnel_key_id_(other.tunnel_key_id_),
+        tunnel_seal_(std::move(other.tunnel_seal_)),
+        tunnel_open_(std::move(other.tunnel_open_)),
+        coalesce_delay_(other.coalesce_delay_),
+        coalesce_buffer_(std::move(other.coalesce_buffer_)),  // Keeps its memory, so the coalescer stays valid
+        coalescer_(other.coalescer_),
+        coalesce_deadline_(other.coalesce_deadline_),
+#if PROJECT_LATENCY_HISTOGRAMS
+        coalesce_ticks_(other.coalesce_ticks_),
+#endif
+        failover_(std::move(other.failover_)),
+        tap_to_switch_counters_(other.tap_to_switch_counters_),
+        switch_to_tap_counters_(other.switch_to_tap_counters_),
+#if PROJECT_LATENCY_HISTOGRAMS
+        tap_to_switch_latency_(other.tap_to_switch_latency_),
+        switch_to_tap_latency_(other.switch_to_tap_latency_),
+#endif
         running_(other.running_.load()),
         tap_to_switch_thread_(std::move(other.tap_to_switch_thread_)),
         switch_to_tap_thread_(std::move(other.switch_to_tap_thread_))
   {
+    other.event_loop_ = nullptr;
   }
 
   VPort& VPort::operator=(VPort&& other) noexcept
@@ -60,21 +141,47 @@ namespace project
       running_.store(other.running_.load());
       tap_to_switch_thread_ = std::move(other.tap_to_switch_thread_);
       switch_to_tap_thread_ = std::move(other.switch_to_tap_thread_);
+      tap_buffer_ = std::move(other.tap_buffer_);  // Released into our old pool before it goes
+      switch_buffer_ = std::move(other.switch_buffer_);
+      segment_buffer_ = std::move(other.segment_buffer_);
+      frame_pool_ = std::move(other.frame_pool_);  // Our old threads (and their buffers) are joined by now
+      uring_ = std::move(other.uring_);
+      tunnel_seal_ = std::move(other.tunnel_seal_);  // Before the keyring they point into goes
+      tunnel_open_ = std::move(other.tunnel_open_);
+      tunnel_ = std::move(other.tunnel_);
+      tunnel_key_id_ = other.tunnel_key_id_;
+      coalesce_delay_ = other.coalesce_delay_;
+      coalesce_buffer_ = std::move(other.coalesce_buffer_);
+      coalescer_ = other.coalescer_;
+      coalesce_deadline_ = other.coalesce_deadline_;
+#if PROJECT_LATENCY_HISTOGRAMS
+      coalesce_ticks_ = other.coalesce_ticks_;
+#endif
+      failover_ = std::move(other.failover_);
+      event_loop_ = other.event_loop_;
+      other.event_loop_ = nullptr;
+      tap_to_switch_counters_ = other.tap_to_switch_counters_;
+      switch_to_tap_counters_ = other.switch_to_tap_counters_;
+#if PROJECT_LATENCY_HISTOGRAMS
+      tap_to_switch_latency_ = other.tap_to_switch_latency_;
+      switch_to_tap_latency_ = other.switch_to_tap_latency_;
+#endif
     }
     return *this;
   }
 
   expected<VPort, VPortError> VPort::create(std::string_view device_name, std::string_view vswitch_address,
-                                             uint16_t vswitch_port)
+                                             uint16_t vswitch_port, bool offloads)
   {
-    // Validate VSwitch endpoint
-    if (vswitch_address.empty() || vswitch_port == 0)
+    // Resolve and validate the VSwitch endpoint once, up front
+    Endpoint vswitch_endpoint(vswitch_address, vswitch_port);
+    if (!vswitch_endpoint.is_valid())
     {
       return unexpected(VPortError::InvalidVSwitchEndpoint);
     }
 
     // Create TAP device
-    auto tap_result = TapDevice::create(device_name);
+    auto tap_result = TapDevice::create(device_name, offloads);
     if (!tap_result)
     {
       return unexpected(VPortError::TapDeviceCreationFailed);
@@ -86,13 +193,15 @@ namespace project
     {
       return unexpected(VPortError::SocketCreationFailed);
     }
-
-    // Create VSwitch endpoint
-    Endpoint vswitch_endpoint(std::string(vswitch_address), vswitch_port);
+    if (offloads && !socket_result->set_gro(true))
+    {
+      PROJECT_LOG_WARN("[VPort] UDP_GRO unavailable, receiving frames one by one");
+    }
 
     std::string actual_device_name = tap_result->device_name();
 
-    std::cout << "[VPort] Created TAP device: " << actual_device_name << ", VSwitch: " << vswitch_endpoint << "\n";
+    PROJECT_LOG_INFO("[VPort] Created TAP device: %s, VSwitch: %s", actual_device_name.c_str(),
+                     vswitch_endpoint.to_string().c_str());
 
     // Construct VPort and wrap in expected
     VPort vport(std::move(*tap_result), std::move(*socket_result), std::move(vswitch_endpoint),
@@ -101,18 +210,106 @@ namespace project
     return expected<VPort, VPortError>(std::move(vport));
   }
 
+  expected<std::vector<VPort>, VPortError> VPort::create_multi_queue(std::string_view device_name,
+                                                                     std::string_view vswitch_address,
+                                                                     uint16_t vswitch_port, size_t queues,
+                                                                     bool offloads)
+  {
+    Endpoint vswitch_endpoint(vswitch_address, vswitch_port);
+    if (!vswitch_endpoint.is_valid())
+    {
+      return unexpected(VPortError::InvalidVSwitchEndpoint);
+    }
+
+    auto tap_result = TapDevice::create_multi_queue(device_name, queues, offloads);
+    if (!tap_result)
+    {
+      return unexpected(VPortError::TapDeviceCreationFailed);
+    }
+
+    std::vector<VPort> vports;
+    vports.reserve(tap_result->size());
+    for (TapDevice& queue : *tap_result)
+    {
+      auto socket_result = UdpSocket::create();
+      if (!socket_result)
+      {
+        return unexpected(VPortError::SocketCreationFailed);
+      }
+      if (offloads && !socket_result->set_gro(true))
+      {
+        PROJECT_LOG_WARN("[VPort] UDP_GRO unavailable, receiving frames one by one");
+      }
+
+      std::string actual_device_name = queue.device_name();
+      vports.push_back(VPort(std::move(queue), std::move(*socket_result), vswitch_endpoint, actual_device_name));
+    }
+
+    PROJECT_LOG_INFO("[VPort] Created TAP device: %s with %zu queues, VSwitch: %s", vports.front().device_name_.c_str(),
+                     vports.size(), vswitch_endpoint.to_string().c_str());
+
+    return expected<std::vector<VPort>, VPortError>(std::move(vports));
+  }
+
   VPort::~VPort()
   {
     stop();
   }
 
-  expected<void, VPortError> VPort::start()
+  expected<void, VPortError> VPort::start(IoBackend backend)
   {
     if (running_.load())
     {
       return unexpected(VPortError::AlreadyRunning);
     }
 
+#if PROJECT_LATENCY_HISTOGRAMS
+    static_cast<void>(latency_ns_per_tick());  // Calibrate the clock now rather than in a snapshot
+#endif
+
+    if (backend == IoBackend::IoUring && tap_device_.offloads_enabled())
+    {
+      PROJECT_LOG_WARN("[VPort] io_uring does not support TAP offloads, using forwarder threads");
+    }
+    else if (backend == IoBackend::IoUring && tunnel_)
+    {
+      PROJECT_LOG_WARN("[VPort] io_uring does not encrypt, using forwarder threads");
+    }
+    else if (backend == IoBackend::IoUring && coalescing_enabled())
+    {
+      PROJECT_LOG_WARN("[VPort] io_uring does not coalesce frames, using forwarder threads");
+    }
+    else if (backend == IoBackend::IoUring && failover_)
+    {
+      PROJECT_LOG_WARN("[VPort] io_uring does not fail over, using forwarder threads");
+    }
+    else if (backend == IoBackend::IoUring)
+    {
+#if PROJECT_HAVE_IO_URING
+      // The thread of a previous run may still be draining the old ring
+      tap_to_switch_thread_ = joining_thread();
+      uring_.reset();
+
+      auto ring = IoUring::create(256);
+      auto buffers = ring ? IoUringBufferRing::create(*ring, 0, URING_BUFFER_COUNT, FRAME_BUFFER_SIZE)
+                          : expected<IoUringBufferRing, IoUringError>(unexpected(ring.error()));
+      if (buffers)
+      {
+        uring_ = std::make_unique<UringState>(UringState{ std::move(*ring), std::move(*buffers) });
+        struct iovec arena = uring_->buffers.arena();
+        uring_->fixed_buffers = uring_->ring.register_buffers(&arena, 1).has_value();
+
+        running_.store(true);
+        tap_to_switch_thread_ = joining_thread([this]() { forward_uring(); });
+        PROJECT_LOG_INFO("[VPort] Started io_uring forwarder thread");
+        return expected<void, VPortError>();
+      }
+      PROJECT_LOG_WARN("[VPort] io_uring unavailable (%s), using forwarder threads", to_string(buffers.error()));
+#else
+      PROJECT_LOG_WARN("[VPort] io_uring support is not compiled in, using forwarder threads");
+#endif
+    }
+
     running_.store(true);
 
     // Start TAP → VSwitch forwarder thread
@@ -121,11 +318,162 @@ namespace project
     // Start VSwitch → TAP forwarder thread
     switch_to_tap_thread_ = joining_thread([this]() { forward_switch_to_tap(); });
 
-    std::cout << "[VPort] Started forwarder threads\n";
+    PROJECT_LOG_INFO("[VPort] Started forwarder threads");
 
     return expected<void, VPortError>();
   }
 
+  expected<void, VPortError> VPort::enable_encryption(TunnelCipher cipher, const TunnelKey& key)
+  {
+    if (running_.load())
+    {
+      return unexpected(VPortError::AlreadyRunning);
+    }
+    if (tap_device_.offloads_enabled())
+    {
+      PROJECT_LOG_ERROR("[VPort] Encryption is not available with TAP offloads");
+      return unexpected(VPortError::EncryptionFailed);
+    }
+
+    auto keyring = TunnelKeyring::create(cipher, TunnelRole::Port, { key });
+    if (!keyring)
+    {
+      PROJECT_LOG_ERROR("[VPort] %s", to_string(keyring.error()));
+      return unexpected(VPortError::EncryptionFailed);
+    }
+    tunnel_seal_ = TunnelContext(**keyring);
+    tunnel_open_ = TunnelContext(**keyring);
+    tunnel_ = std::move(*keyring);
+    tunnel_key_id_ = key.id;
+    reset_coalescer();  // Aggregates now need room for the tunnel
+    PROJECT_LOG_INFO("[VPort] Encrypting with %s under key %u", to_string(cipher), key.id);
+    return expected<void, VPortError>();
+  }
+
+  expected<void, VPortError> VPort::enable_coalescing(std::chrono::microseconds delay)
+  {
+    if (running_.load())
+    {
+      return unexpected(VPortError::AlreadyRunning);
+    }
+    if (tap_device_.offloads_enabled() && delay.count() > 0)
+    {
+      // Super-frames from the TAP device go out through UDP GSO and never reach the coalescer
+      PROJECT_LOG_ERROR("[VPort] Coalescing is not available with TAP offloads");
+      return unexpected(VPortError::CoalescingFailed);
+    }
+
+    coalesce_delay_ = std::max(delay, std::chrono::microseconds(0));
+    reset_coalescer();
+    if (coalescing_enabled())
+    {
+      PROJECT_LOG_INFO("[VPort] Coalescing frames of up to %zu bytes for up to %lld us", COALESCE_MAX_FRAME_SIZE,
+                       static_cast<long long>(coalesce_delay_.count()));
+    }
+    return expected<void, VPortError>();
+  }
+
+  expected<void, VPortError> VPort::enable_failover(std::vector<Endpoint> standby, std::chrono::milliseconds timeout)
+  {
+    if (running_.load())
+    {
+      return unexpected(VPortError::AlreadyRunning);
+    }
+    for (const auto& endpoint : standby)
+    {
+      if (!endpoint.is_valid())
+      {
+        return unexpected(VPortError::InvalidVSwitchEndpoint);
+      }
+    }
+
+    failover_.reset();
+    if (standby.empty())
+    {
+      return expected<void, VPortError>();
+    }
+
+    const size_t nodes = standby.size() + 1;
+    standby.insert(standby.begin(), vswitch_endpoint_);
+    failover_ = std::make_unique<VSwitchFailover>(std::move(standby), timeout);
+    PROJECT_LOG_INFO("[VPort] Failing over between %zu VSwitch nodes after %lld ms of silence", nodes,
+                     static_cast<long long>(timeout.count()));
+    return expected<void, VPortError>();
+  }
+
+  void VPort::reset_coalescer()
+  {
+    if (!coalescing_enabled())
+    {
+      coalesce_buffer_ = std::vector<uint8_t>();
+      coalescer_ = FrameCoalescer();
+      return;
+    }
+
+    // [tunnel header][aggregate][tag], the datagram as a whole within COALESCE_MAX_DATAGRAM_SIZE
+    coalesce_buffer_.assign(TUNNEL_HEADER_SIZE + COALESCE_MAX_DATAGRAM_SIZE, 0);
+    coalescer_ = FrameCoalescer(coalesce_buffer_.data() + TUNNEL_HEADER_SIZE,
+                                COALESCE_MAX_DATAGRAM_SIZE - (tunnel_ ? TUNNEL_OVERHEAD : 0));
+  }
+
+  expected<void, VPortError> VPort::attach(EventLoop& loop)
+  {
+    if (running_.load())
+    {
+      return unexpected(VPortError::AlreadyRunning);
+    }
+
+    if (!tap_device_.set_nonblocking(true) || !udp_socket_.set_nonblocking(true))
+    {
+      return unexpected(VPortError::EventLoopFailed);
+    }
+
+#if PROJECT_LATENCY_HISTOGRAMS
+    static_cast<void>(latency_ns_per_tick());  // Calibrate the clock now rather than in a snapshot
+#endif
+
+    tap_buffer_ = frame_pool_->acquire();
+    switch_buffer_ = frame_pool_->acquire();
+    event_loop_ = &loop;
+
+    // Level-triggered: whatever is left after the budget is picked up on the next round
+    auto tap_added = loop.add(tap_device_.get_fd(), EPOLLIN, [this](uint32_t) {
+      for (size_t i = 0; i < VPORT_EVENT_BUDGET && relay_tap_to_switch(tap_buffer_); ++i)
+      {
+      }
+      flush_coalesced();  // Nothing waits for the next event
+    });
+    auto socket_added = loop.add(udp_socket_.get_fd(), EPOLLIN, [this](uint32_t) {
+      for (size_t i = 0; i < VPORT_EVENT_BUDGET && relay_switch_to_tap(switch_buffer_); ++i)
+      {
+      }
+    });
+
+    running_.store(true);
+    if (!tap_added || !socket_added)
+    {
+      stop();
+      return unexpected(VPortError::EventLoopFailed);
+    }
+
+    PROJECT_LOG_INFO("[VPort] Attached %s to event loop", device_name_.c_str());
+
+    return expected<void, VPortError>();
+  }
+
+  void VPort::detach() noexcept
+  {
+    // Either registration may be missing if attach() failed halfway
+    [[maybe_unused]] auto tap_removed = event_loop_->remove(tap_device_.get_fd());
+    [[maybe_unused]] auto socket_removed = event_loop_->remove(udp_socket_.get_fd());
+    event_loop_ = nullptr;
+
+    [[maybe_unused]] auto tap_blocking = tap_device_.set_nonblocking(false);
+    [[maybe_unused]] auto socket_blocking = udp_socket_.set_nonblocking(false);
+    tap_buffer_.reset();
+    switch_buffer_.reset();
+  }
+
   void VPort::stop() noexcept
   {
     if (!running_.load())
@@ -133,7 +481,15 @@ namespace project
       return;
     }
 
-    std::cout << "[VPort] Stopping forwarder threads...\n";
+    if (event_loop_ != nullptr)
+    {
+      detach();
+      running_.store(false);
+      PROJECT_LOG_INFO("[VPort] Detached %s from event loop", device_name_.c_str());
+      return;
+    }
+
+    PROJECT_LOG_INFO("[VPort] Stopping forwarder threads...");
 
     running_.store(false);
 
@@ -141,90 +497,607 @@ namespace project
     // Note: In a production system, we might want to close the TAP device and socket
     // to interrupt blocking read/recv calls
 
-    std::cout << "[VPort] Stopped\n";
+    PROJECT_LOG_INFO("[VPort] Stopped");
   }
 
   void VPort::forward_tap_to_switch()
   {
-    std::cout << "[VPort] TAP → VSwitch forwarder started\n";
+    PROJECT_LOG_INFO("[VPort] TAP → VSwitch forwarder started");
+
+    FrameBuffer buffer = frame_pool_->acquire();
 
     while (running_.load())
     {
-      // Read Ethernet frame from TAP device
-      auto frame_result = tap_device_.read_frame();
-
-      if (!frame_result)
+      // Small frames wait for more only until the first of them is due
+      if (!coalescer_.empty() && !tap_readable_before(coalesce_deadline_))
       {
-        // Log error and continue (could be a temporary issue)
-        std::cerr << "[VPort] TAP read error: " << to_string(frame_result.error()) << "\n";
+        flush_coalesced();
         continue;
       }
+      relay_tap_to_switch(buffer);
+    }
+    flush_coalesced();
+
+    PROJECT_LOG_INFO("[VPort] TAP → VSwitch forwarder stopped");
+  }
 
-      const auto& frame_data = *frame_result;
+  void VPort::forward_switch_to_tap()
+  {
+    PROJECT_LOG_INFO("[VPort] VSwitch → TAP forwarder started");
 
-      // Parse the Ethernet frame for logging
-      auto frame = EthernetFrame::parse(frame_data);
+    FrameBuffer buffer = frame_pool_->acquire();
 
-      // Send frame to VSwitch via UDP
-      auto send_result = udp_socket_.send_to(frame_data, vswitch_endpoint_);
+    while (running_.load())
+    {
+      relay_switch_to_tap(buffer);
+    }
+
+    PROJECT_LOG_INFO("[VPort] VSwitch → TAP forwarder stopped");
+  }
+
+  void VPort::forward_uring()
+  {
+#if PROJECT_HAVE_IO_URING
+    PROJECT_LOG_INFO("[VPort] io_uring forwarder started");
 
-      if (!send_result)
+    IoUring& ring = uring_->ring;
+    IoUringBufferRing& buffers = uring_->buffers;
+    IoUringSendSlots& slots = uring_->slots;
+    const int tap_fd = tap_device_.get_fd();
+    const int socket_fd = udp_socket_.get_fd();
+
+    // Reads on a TAP device are single-shot, so one is re-posted after each frame
+    bool tap_read_armed = false;
+    bool socket_receive_armed = false;
+    size_t tap_writes_in_flight = 0;
+
+    auto arm_tap_read = [&]() {
+      io_uring_sqe* sqe = ring.get_sqe();
+      if (sqe != nullptr)
       {
-        std::cerr << "[VPort] UDP send error: " << to_string(send_result.error()) << "\n";
-        continue;
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = tap_fd;
+        sqe->len = static_cast<uint32_t>(buffers.buffer_size());
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = buffers.group();
+        sqe->user_data = io_uring_tag(URING_TAP_READ);
+        tap_read_armed = true;
+      }
+    };
+
+    auto arm_socket_receive = [&]() {
+      io_uring_sqe* sqe = ring.get_sqe();
+      if (sqe != nullptr)
+      {
+        sqe->opcode = IORING_OP_RECV;
+        sqe->fd = socket_fd;
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = buffers.group();
+        sqe->user_data = io_uring_tag(URING_SOCKET_RECEIVE);
+        socket_receive_armed = true;
+      }
+    };
+
+    // Each forward holds its receive buffer until the send or write completes
+    auto send_to_switch = [&](uint16_t id, size_t size) {
+      TrafficCounters::add(tap_to_switch_counters_.rx_frames, 1);
+      TrafficCounters::add(tap_to_switch_counters_.rx_bytes, size);
+
+      const uint32_t index = slots.acquire(buffers.buffer(id), size, vswitch_endpoint_, id);
+      io_uring_sqe* sqe = index == IoUringSendSlots::NONE ? nullptr : ring.get_sqe();
+      if (sqe == nullptr)
+      {
+        if (index != IoUringSendSlots::NONE)
+        {
+          slots.release(index);
+        }
+        TrafficCounters::add(tap_to_switch_counters_.send_errors, 1);
+        return;
       }
 
-      // Log the frame
-      log_frame("Sent to VSwitch", frame);
+      sqe->opcode = IORING_OP_SENDMSG;
+      sqe->fd = socket_fd;
+      sqe->addr = reinterpret_cast<uint64_t>(&slots[index].message);
+      sqe->len = 1;
+      sqe->user_data = io_uring_tag(URING_SOCKET_SEND, index);
+      buffers.hold(id);
+    };
+
+    auto write_to_tap = [&](uint16_t id, size_t size) {
+      TrafficCounters::add(switch_to_tap_counters_.rx_frames, 1);
+      TrafficCounters::add(switch_to_tap_counters_.rx_bytes, size);
+
+      io_uring_sqe* sqe = ring.get_sqe();
+      if (sqe == nullptr)
+      {
+        TrafficCounters::add(switch_to_tap_counters_.send_errors, 1);
+        return;
+      }
+
+      sqe->opcode = uring_->fixed_buffers ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+      sqe->fd = tap_fd;
+      sqe->addr = reinterpret_cast<uint64_t>(buffers.buffer(id));
+      sqe->len = static_cast<uint32_t>(size);
+      sqe->buf_index = 0;
+      sqe->user_data = io_uring_tag(URING_TAP_WRITE, (uint64_t{ size } << 16) | id);
+      buffers.hold(id);
+      ++tap_writes_in_flight;
+    };
+
+    auto handle_completion = [&](const io_uring_cqe& cqe) {
+      const uint64_t payload = io_uring_tag_payload(cqe.user_data);
+      const int buffer_id = IoUringBufferRing::buffer_id(cqe);
+
+      switch (io_uring_tag_kind(cqe.user_data))
+      {
+        case URING_TAP_READ:
+        case URING_SOCKET_RECEIVE:
+        {
+          const bool from_tap = io_uring_tag_kind(cqe.user_data) == URING_TAP_READ;
+          if (from_tap || (cqe.flags & IORING_CQE_F_MORE) == 0)
+          {
+            (from_tap ? tap_read_armed : socket_receive_armed) = false;
+          }
+
+          if (buffer_id < 0)
+          {
+            // -ENOBUFS: every buffer is in flight; the receive is re-posted after this round
+            if (cqe.res < 0 && cqe.res != -ECANCELED && cqe.res != -ENOBUFS)
+            {
+              PROJECT_LOG_WARN("[VPort] %s error: %s", from_tap ? "TAP read" : "UDP receive", std::strerror(-cqe.res));
+            }
+            break;
+          }
+
+          const auto id = static_cast<uint16_t>(buffer_id);
+          buffers.hold(id);
+          if (cqe.res > 0 && running_.load())
+          {
+#if PROJECT_LATENCY_HISTOGRAMS
+            uring_->rx_ticks[id] = latency_clock_ticks();
+#endif
+            const auto size = static_cast<size_t>(cqe.res);
+            if (from_tap)
+            {
+              send_to_switch(id, size);
+              log_frame("Sent to VSwitch", buffers.buffer(id), size);
+            }
+            else
+            {
+              write_to_tap(id, size);
+              log_frame("Forward to TAP device", buffers.buffer(id), size);
+            }
+          }
+          buffers.release(id);
+          break;
+        }
+        case URING_SOCKET_SEND:
+        {
+          const auto index = static_cast<uint32_t>(payload);
+          const uint16_t id = slots[index].buffer_id;
+          if (cqe.res < 0)
+          {
+            TrafficCounters::add(tap_to_switch_counters_.send_errors, 1);
+            PROJECT_LOG_WARN("[VPort] UDP send error: %s", std::strerror(-cqe.res));
+          }
+          else
+          {
+#if PROJECT_LATENCY_HISTOGRAMS
+            tap_to_switch_latency_.record(latency_clock_ticks() - uring_->rx_ticks[id]);
+#endif
+            TrafficCounters::add(tap_to_switch_counters_.tx_frames, 1);
+            TrafficCounters::add(tap_to_switch_counters_.tx_bytes, static_cast<uint64_t>(cqe.res));
+          }
+          slots.release(index);
+          buffers.release(id);
+          break;
+        }
+        case URING_TAP_WRITE:
+        {
+          const auto id = static_cast<uint16_t>(payload & 0xffff);
+          const uint64_t size = payload >> 16;
+          --tap_writes_in_flight;
+          if (cqe.res >= 0 && static_cast<uint64_t>(cqe.res) == size)
+          {
+#if PROJECT_LATENCY_HISTOGRAMS
+            switch_to_tap_latency_.record(latency_clock_ticks() - uring_->rx_ticks[id]);
+#endif
+            TrafficCounters::add(switch_to_tap_counters_.tx_frames, 1);
+            TrafficCounters::add(switch_to_tap_counters_.tx_bytes, size);
+          }
+          else
+          {
+            TrafficCounters::add(cqe.res >= 0 ? switch_to_tap_counters_.tap_partial_writes
+                                              : switch_to_tap_counters_.send_errors,
+                                 1);
+            PROJECT_LOG_WARN("[VPort] TAP write error: %s",
+                             cqe.res >= 0 ? to_string(TapError::PartialWrite) : std::strerror(-cqe.res));
+          }
+          buffers.release(id);
+          break;
+        }
+        default:
+          break;  // URING_CANCEL
+      }
+    };
+
+    while (running_.load())
+    {
+      if (!tap_read_armed)
+      {
+        arm_tap_read();
+      }
+      if (!socket_receive_armed)
+      {
+        arm_socket_receive();
+      }
+
+      if (auto waited = ring.submit_and_wait(VPORT_STOP_POLL_INTERVAL); !waited)
+      {
+        PROJECT_LOG_ERROR("[VPort] io_uring wait failed: %s", to_string(waited.error()));
+        break;
+      }
+      ring.for_each_completion(handle_completion);
     }
 
-    std::cout << "[VPort] TAP → VSwitch forwarder stopped\n";
+    // Nothing may still write into the buffers once they are freed
+    if (ring.cancel_all(io_uring_tag(URING_CANCEL)))
+    {
+      for (int attempt = 0;
+           attempt < 10 && (tap_read_armed || socket_receive_armed || slots.in_flight() > 0 || tap_writes_in_flight > 0);
+           ++attempt)
+      {
+        if (!ring.submit_and_wait(VPORT_STOP_POLL_INTERVAL))
+        {
+          break;
+        }
+        ring.for_each_completion(handle_completion);
+      }
+    }
+
+    PROJECT_LOG_INFO("[VPort] io_uring forwarder stopped");
+#endif
   }
 
-  void VPort::forward_switch_to_tap()
+  bool VPort::relay_tap_to_switch(FrameBuffer& buffer)
   {
-    std::cout << "[VPort] VSwitch → TAP forwarder started\n";
+    // Read Ethernet frame from TAP device straight into the pooled buffer. With encryption it
+    // goes behind room for the tunnel header and is sealed in place, so it is never copied
+    VnetHeader header;
+    const size_t headroom = tunnel_ ? TUNNEL_HEADER_SIZE : 0;
+    uint8_t* frame = buffer.data() + headroom;
+    auto frame_result = tap_device_.offloads_enabled()
+                            ? tap_device_.read_frame(buffer, header)
+                            : tap_device_.read_frame(frame, buffer.capacity() - (tunnel_ ? TUNNEL_OVERHEAD : 0));
 
-    while (running_.load())
+    if (!frame_result)
     {
-      // Receive Ethernet frame from VSwitch
-      auto recv_result = udp_socket_.receive_from(ETHER_MAX_LEN);
+      // Log error and continue (could be a temporary issue); an empty non-blocking device is not one
+      if (frame_result.error() != TapError::WouldBlock)
+      {
+        PROJECT_LOG_WARN("[VPort] TAP read error: %s", to_string(frame_result.error()));
+      }
+      return false;
+    }
+
+#if PROJECT_LATENCY_HISTOGRAMS
+    const uint64_t rx_ticks = latency_clock_ticks();
+#endif
+    const size_t size = *frame_result;
+    TrafficCounters::add(tap_to_switch_counters_.rx_frames, 1);
+    TrafficCounters::add(tap_to_switch_counters_.rx_bytes, size);
 
-      if (!recv_result)
+    if (failover_ && failover_->poll(steady_now_ns()))
+    {
+      vswitch_endpoint_ = failover_->active();
+      PROJECT_LOG_WARN("[VPort] VSwitch silent, failing over to %s", vswitch_endpoint_.to_string().c_str());
+    }
+
+    if (tap_device_.offloads_enabled())
+    {
+#if PROJECT_LATENCY_HISTOGRAMS
+      if (send_offloaded(buffer, header) > 0)
       {
-        // Log error and continue
-        std::cerr << "[VPort] UDP receive error: " << to_string(recv_result.error()) << "\n";
-        continue;
+        tap_to_switch_latency_.record(latency_clock_ticks() - rx_ticks);
+      }
+#else
+      send_offloaded(buffer, header);
+#endif
+      return true;
+    }
+
+    log_frame("Sent to VSwitch", frame, size);
+
+    if (coalescing_enabled() && size <= COALESCE_MAX_FRAME_SIZE)
+    {
+      coalesce(frame, size);
+      return true;
+    }
+
+    flush_coalesced();  // Smaller frames read before this one go first
+    if (send_to_switch(frame, size, 1))
+    {
+#if PROJECT_LATENCY_HISTOGRAMS
+      tap_to_switch_latency_.record(latency_clock_ticks() - rx_ticks);
+#endif
+    }
+    return true;
+  }
+
+  bool VPort::send_to_switch(uint8_t* frame, size_t size, size_t frames)
+  {
+    const uint8_t* datagram = frame;
+    size_t datagram_size = size;
+    if (tunnel_)
+    {
+      struct iovec piece = { frame, size };
+      auto sealed = tunnel_seal_.seal(tunnel_key_id_, &piece, 1, frame - TUNNEL_HEADER_SIZE, size + TUNNEL_OVERHEAD);
+      if (!sealed)
+      {
+        TrafficCounters::add(tap_to_switch_counters_.crypto_drops, frames);
+        PROJECT_LOG_WARN("[VPort] Failed to seal frame: %s", to_string(sealed.error()));
+        return false;
+      }
+      datagram = frame - TUNNEL_HEADER_SIZE;
+      datagram_size = *sealed;
+    }
+
+    // Send frame to VSwitch via UDP
+    auto send_result = udp_socket_.send_to(datagram, datagram_size, vswitch_endpoint_);
+
+    if (!send_result)
+    {
+      TrafficCounters::add(tap_to_switch_counters_.send_errors, frames);
+      PROJECT_LOG_WARN("[VPort] UDP send error: %s", to_string(send_result.error()));
+      return false;
+    }
+
+    TrafficCounters::add(tap_to_switch_counters_.tx_frames, frames);
+    TrafficCounters::add(tap_to_switch_counters_.tx_bytes, datagram_size);
+    return true;
+  }
+
+  void VPort::coalesce(const uint8_t* frame, size_t size)
+  {
+    if (!coalescer_.fits(size))
+    {
+      flush_coalesced();
+    }
+    if (coalescer_.empty())
+    {
+      coalesce_deadline_ = std::chrono::steady_clock::now() + coalesce_delay_;
+#if PROJECT_LATENCY_HISTOGRAMS
+      coalesce_ticks_ = latency_clock_ticks();
+#endif
+    }
+
+    static_cast<void>(coalescer_.add(frame, size));  // Fits an empty aggregate once flushed
+    if (coalescer_.full())
+    {
+      flush_coalesced();
+    }
+  }
+
+  void VPort::flush_coalesced()
+  {
+    if (coalescer_.empty())
+    {
+      return;
+    }
+
+    // The aggregate is written behind the tunnel header room, with room for the tag after it
+    uint8_t* aggregate = coalesce_buffer_.data() + TUNNEL_HEADER_SIZE;
+    const size_t frames = coalescer_.frames();
+    constexpr size_t FIRST_FRAME = COALESCE_HEADER_SIZE + COALESCE_RECORD_HEADER_SIZE;
+    const bool sent = frames == 1 ? send_to_switch(aggregate + FIRST_FRAME, coalescer_.size() - FIRST_FRAME, 1)
+                                  : send_to_switch(aggregate, coalescer_.size(), frames);
+    coalescer_.clear();
+
+#if PROJECT_LATENCY_HISTOGRAMS
+    if (sent)
+    {
+      tap_to_switch_latency_.record(latency_clock_ticks() - coalesce_ticks_);
+    }
+#else
+    static_cast<void>(sent);
+#endif
+  }
+
+  bool VPort::tap_readable_before(std::chrono::steady_clock::time_point deadline) const
+  {
+    const auto remaining =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - std::chrono::steady_clock::now()).count();
+    if (remaining <= 0)
+    {
+      return false;
+    }
+
+    struct timespec timeout = { remaining / 1'000'000'000, remaining % 1'000'000'000 };
+    struct pollfd descriptor = { tap_device_.get_fd(), POLLIN, 0 };
+    return ::ppoll(&descriptor, 1, &timeout, nullptr) > 0 && (descriptor.revents & POLLIN) != 0;
+  }
+
+  size_t VPort::send_offloaded(FrameBuffer& buffer, const VnetHeader& header)
+  {
+    // Super-frames become MSS-sized frames back to back, sent with a single UDP GSO call
+    const uint8_t* data = buffer.data();
+    size_t size = buffer.size();
+    size_t segment_size = size;
+    size_t frames = 1;
+    if ((header.gso_type & ~VNET_HDR_GSO_ECN) != VNET_HDR_GSO_NONE)
+    {
+      auto segmented = segment_frame(header, buffer.data(), buffer.size(), segment_buffer_.data(),
+                                     segment_buffer_.capacity());
+      if (!segmented)
+      {
+        TrafficCounters::add(tap_to_switch_counters_.send_errors, 1);
+        PROJECT_LOG_WARN("[VPort] Dropped TAP super-frame: %s", to_string(segmented.error()));
+        return 0;
       }
+      data = segment_buffer_.data();
+      size = segmented->size;
+      segment_size = segmented->segment_size;
+      frames = segmented->segments;
+    }
+    else if (auto completed = complete_checksum(header, buffer.data(), buffer.size()); !completed)
+    {
+      TrafficCounters::add(tap_to_switch_counters_.send_errors, 1);
+      PROJECT_LOG_WARN("[VPort] Dropped TAP frame: %s", to_string(completed.error()));
+      return 0;
+    }
 
-      auto& [frame_data, sender_endpoint] = *recv_result;
+    auto send_result = udp_socket_.send_segments(data, size, segment_size, vswitch_endpoint_);
+    if (!send_result)
+    {
+      TrafficCounters::add(tap_to_switch_counters_.send_errors, 1);
+      PROJECT_LOG_WARN("[VPort] UDP send error: %s", to_string(send_result.error()));
+      return 0;
+    }
 
-      // Parse the Ethernet frame for logging
-      auto frame = EthernetFrame::parse(frame_data);
+    TrafficCounters::add(tap_to_switch_counters_.tx_frames, frames);
+    TrafficCounters::add(tap_to_switch_counters_.tx_bytes, size);
 
-      // Write frame to TAP device
-      auto write_result = tap_device_.write_frame(frame_data);
+    log_frame("Sent to VSwitch", data, std::min(size, segment_size));
+    return frames;
+  }
+
+  bool VPort::relay_switch_to_tap(FrameBuffer& buffer)
+  {
+    // Receive Ethernet frames from VSwitch straight into the pooled buffer; with
+    // offloads, UDP_GRO may have coalesced several datagrams of segment_size each
+    size_t segment_size = 0;
+    auto recv_result = tap_device_.offloads_enabled() ? udp_socket_.receive_from(buffer, segment_size)
+                                                      : udp_socket_.receive_from(buffer);
+
+    if (!recv_result)
+    {
+      if (recv_result.error() != UdpError::WouldBlock)
+      {
+        PROJECT_LOG_WARN("[VPort] UDP receive error: %s", to_string(recv_result.error()));
+      }
+      return false;
+    }
+    if (!tap_device_.offloads_enabled())
+    {
+      segment_size = buffer.size();
+    }
+
+#if PROJECT_LATENCY_HISTOGRAMS
+    const uint64_t rx_ticks = latency_clock_ticks();
+#endif
+
+    // Sealed datagrams are opened in place; the frame is what lies between header and tag
+    const uint8_t* data = buffer.data();
+    size_t total = buffer.size();
+    if (tunnel_)
+    {
+      auto opened = tunnel_open_.open(buffer.data(), buffer.size());
+      if (!opened)
+      {
+        TrafficCounters::add(switch_to_tap_counters_.rx_frames, 1);
+        TrafficCounters::add(switch_to_tap_counters_.rx_bytes, buffer.size());
+        TrafficCounters::add(switch_to_tap_counters_.crypto_drops, 1);
+        PROJECT_LOG_DEBUG("[VPort] Dropped datagram: %s", to_string(opened.error()));
+        return true;
+      }
+      data = opened->data;
+      total = opened->size;
+      segment_size = total;
+    }
+    if (failover_)
+    {
+      failover_->heard(steady_now_ns());
+    }
+
+    size_t offset = 0;
+    do
+    {
+      const uint8_t* frame = data + offset;
+      const size_t size = std::min(segment_size, total - offset);
+      offset += size;
+
+      TrafficCounters::add(switch_to_tap_counters_.rx_frames, 1);
+      TrafficCounters::add(switch_to_tap_counters_.rx_bytes, size);
+
+      // Write frame to TAP device; a full non-blocking queue drops the frame like a full NIC ring
+      auto write_result = tap_device_.write_frame(frame, size);
 
       if (!write_result)
       {
-        std::cerr << "[VPort] TAP write error: " << to_string(write_result.error()) << "\n";
+        TrafficCounters::add(write_result.error() == TapError::PartialWrite
+                                 ? switch_to_tap_counters_.tap_partial_writes
+                                 : switch_to_tap_counters_.send_errors,
+                             1);
+        PROJECT_LOG_WARN("[VPort] TAP write error: %s", to_string(write_result.error()));
         continue;
       }
 
-      // Log the frame
-      log_frame("Forward to TAP device", frame);
-    }
+#if PROJECT_LATENCY_HISTOGRAMS
+      switch_to_tap_latency_.record(latency_clock_ticks() - rx_ticks);
+#endif
+      TrafficCounters::add(switch_to_tap_counters_.tx_frames, 1);
+      TrafficCounters::add(switch_to_tap_counters_.tx_bytes, size);
+
+      log_frame("Forward to TAP device", frame, size);
+    } while (offset < total);
 
-    std::cout << "[VPort] VSwitch → TAP forwarder stopped\n";
+    return true;
   }
 
-  void VPort::log_frame(std::string_view direction, const EthernetFrame& frame) const
+
+  LatencySnapshot VPort::tap_to_switch_latency() const
+  {
+#if PROJECT_LATENCY_HISTOGRAMS
+    return tap_to_switch_latency_.snapshot();
+#else
+    return LatencySnapshot();
+#endif
+  }
+
+  LatencySnapshot VPort::switch_to_tap_latency() const
+  {
+#if PROJECT_LATENCY_HISTOGRAMS
+    return switch_to_tap_latency_.snapshot();
+#else
+    return LatencySnapshot();
+#endif
+  }
+
+  std::string VPort::stats_prometheus() const
+  {
+    const std::string device = "device=\"" + device_name_ + "\"";
+    const std::string to_switch = device + ",direction=\"tap_to_switch\"";
+    const std::string to_tap = device + ",direction=\"switch_to_tap\"";
+
+    std::string out =
+        format_prometheus("vport", { { to_switch, tap_to_switch_stats() }, { to_tap, switch_to_tap_stats() } });
+#if PROJECT_LATENCY_HISTOGRAMS
+    out += format_prometheus_latency("vport",
+                                     { { to_switch, tap_to_switch_latency() }, { to_tap, switch_to_tap_latency() } });
+#endif
+    return out;
+  }
+
+  void VPort::log_frame([[maybe_unused]] const char* direction, [[maybe_unused]] const uint8_t* data,
+                        [[maybe_unused]] size_t size) const
   {
-    std::cout << "[VPort] " << direction << ": "
-              << "dst=" << frame.dst_mac() << " "
-              << "src=" << frame.src_mac() << " "
-              << "type=" << std::hex << frame.ethertype() << std::dec << " "
-              << "size=" << frame.size() << "\n";
+    // Only parse the header when per-frame tracing is compiled in and enabled
+    if constexpr (log_compiled_in(LogLevel::Trace))
+    {
+      if (!Logger::instance().enabled(LogLevel::Trace))
+      {
+        return;
+      }
+
+      EthernetFrameView frame(data, size);
+      if (frame.is_valid())
+      {
+        PROJECT_LOG_TRACE("[VPort] %s: dst=%s src=%s type=%x size=%zu", direction,
+                          frame.dst_mac().to_string().c_str(), frame.src_mac().to_string().c_str(),
+                          unsigned{ frame.ethertype() }, frame.size());
+      }
+    }
   }
 
 }  // namespace project
@@ -5,18 +5,48 @@
  * This application creates a TAP device and connects it to a remote VSwitch
  * via UDP, forwarding Ethernet frames bidirectionally.
  * 
- * Usage: vport <vswitch_ip> <vswitch_port> [tap_device_name]
+ * Usage: vport [--event-loop | --io-uring] [--queues N] [--offload] [--key-file FILE] [--cipher CIPHER]
+ *              [--coalesce USEC] [--backup IP:PORT]... [--failover-timeout MS]
+ *              <vswitch_ip> <vswitch_port> [tap_device_name...]
+ *
+ * By default each VPort runs two forwarder threads. With --event-loop, any
+ * number of TAP devices share one epoll loop on the main thread. With
+ * --io-uring, one thread drives the TAP device and socket through io_uring.
+ * With --queues N, each TAP device gets N queues, each forwarded by its own
+ * VPort with its own socket. With --offload, TCP super-frames from the TAP
+ * device are cut into frames only right before a single UDP GSO send. With
+ * --key-file, the i-th VPort (TAP devices in order, then queues) encrypts
+ * with the i-th key of the file, which the VSwitch must hold as well. With
+ * --coalesce USEC, small frames wait up to USEC microseconds to share a
+ * datagram to the VSwitch (not with --offload). With --backup, the VPorts
+ * move to the next node of a VSwitch cluster once the current one has been
+ * silent for --failover-timeout milliseconds.
+ *
+ * Send SIGUSR1 to print the traffic counters in Prometheus text format.
  */
 
+#include "project/cluster.hpp"
+#include "project/event_loop.hpp"
+#include "project/tunnel_crypto.hpp"
 #include "project/vport.hpp"
 
+#include <chrono>
 #include <csignal>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <memory>
+#include <vector>
 
-// Global VPort pointer for signal handler
-std::unique_ptr<project::VPort> g_vport;
+// Global VPorts (one per TAP queue) for signal handler
+std::vector<std::unique_ptr<project::VPort>> g_vports;
+
+// Set in --event-loop mode; the signal handler only wakes it and main() shuts down
+std::unique_ptr<project::EventLoop> g_loop;
+volatile std::sig_atomic_t g_shutdown = 0;
+
+// Set by SIGUSR1; the main loop prints the counters and clears it
+volatile std::sig_atomic_t g_dump_stats = 0;
 
 /**
  * @brief Signal handler for graceful shutdown
@@ -25,22 +55,38 @@ std::unique_ptr<project::VPort> g_vport;
  */
 void signal_handler(int signal)
 {
+  if (g_loop)
+  {
+    g_shutdown = 1;
+    g_loop->stop();
+    return;
+  }
+
   std::cout << "\n[VPort] Received signal " << signal << ", shutting down...\n";
-  if (g_vport)
+  for (auto& vport : g_vports)
   {
-    g_vport->stop();
-    g_vport.reset();
+    vport->stop();
   }
+  g_vports.clear();
   std::exit(0);
 }
 
 /**
- * @brief Setup signal handlers for graceful shutdown
+ * @brief Signal handler requesting a stats dump
+ */
+void stats_signal_handler(int)
+{
+  g_dump_stats = 1;
+}
+
+/**
+ * @brief Setup signal handlers for graceful shutdown and stats dumps
  */
 void setup_signal_handlers()
 {
   std::signal(SIGINT, signal_handler);
   std::signal(SIGTERM, signal_handler);
+  std::signal(SIGUSR1, stats_signal_handler);
 }
 
 /**
@@ -48,104 +94,455 @@ void setup_signal_handlers()
  */
 void print_usage(const char* program_name)
 {
-  std::cerr << "Usage: " << program_name << " <vswitch_ip> <vswitch_port> [tap_device_name]\n";
+  std::cerr << "Usage: " << program_name
+            << " [--event-loop | --io-uring] [--queues N] [--offload] [--key-file FILE] [--cipher CIPHER]\n"
+            << "       [--coalesce USEC] [--backup IP:PORT]... [--failover-timeout MS]\n"
+            << "       <vswitch_ip> <vswitch_port> [tap_device_name...]\n";
   std::cerr << "\n";
   std::cerr << "Arguments:\n";
   std::cerr << "  vswitch_ip        IP address of the VSwitch server\n";
   std::cerr << "  vswitch_port      Port number of the VSwitch server\n";
   std::cerr << "  tap_device_name   Optional TAP device name (default: auto-assigned)\n";
   std::cerr << "\n";
+  std::cerr << "Options:\n";
+  std::cerr << "  --event-loop      Serve all TAP devices from one epoll thread (allows several names)\n";
+  std::cerr << "  --io-uring        Forward through io_uring on one thread (falls back to threads)\n";
+  std::cerr << "  --queues N        Multi-queue TAP devices, one VPort and socket per queue (default 1)\n";
+  std::cerr << "  --offload         TAP checksum/TSO offload with UDP GSO/GRO (forwarder threads or event loop)\n";
+  std::cerr << "  --key-file F      Encrypt, each VPort with the next \"ID HEX64\" key of file F (no --offload)\n";
+  std::cerr << "  --cipher C        aes-256-gcm (default) or chacha20-poly1305, as the VSwitch uses\n";
+  std::cerr << "  --coalesce USEC   Send small frames together, each waiting at most USEC us\n";
+  std::cerr << "                    (no --offload or --io-uring)\n";
+  std::cerr << "  --backup IP:PORT  Another node of the VSwitch cluster to fail over to (repeatable, no --io-uring)\n";
+  std::cerr << "  --failover-timeout MS  Silence before moving to the next node (default "
+            << project::FAILOVER_DEFAULT_TIMEOUT.count() << ")\n";
+  std::cerr << "\n";
   std::cerr << "Examples:\n";
   std::cerr << "  " << program_name << " 127.0.0.1 8080\n";
   std::cerr << "  " << program_name << " 192.168.1.100 9000 tap0\n";
+  std::cerr << "  " << program_name << " --event-loop 192.168.1.100 9000 tap0 tap1 tap2\n";
+  std::cerr << "  " << program_name << " --queues 4 192.168.1.100 9000 tap0\n";
+  std::cerr << "  " << program_name << " --key-file /etc/vport/keys 192.168.1.100 9000 tap0\n";
+  std::cerr << "  " << program_name << " --coalesce 50 192.168.1.100 9000 tap0\n";
+  std::cerr << "  " << program_name << " --backup 192.168.1.101:9000 192.168.1.100 9000 tap0\n";
   std::cerr << "\n";
   std::cerr << "Note: This program requires root/sudo privileges to create TAP devices.\n";
 }
 
-int main(int argc, char* argv[])
+/**
+ * @brief Create the VPorts for one TAP device, one per queue, printing why if it fails
+ * @return The VPorts, or none on failure
+ */
+std::vector<std::unique_ptr<project::VPort>> create_cleartext_vports(const char* tap_device_name,
+                                                                     const char* vswitch_ip,
+                                                                     uint16_t vswitch_port,
+                                                                     size_t queues,
+                                                                     bool offloads,
+                                                                     const char* program_name)
 {
-  std::cout << "=== VPort - Virtual Port for VSwitch ===\n\n";
+  // A single queue keeps the plain TAP flags, so existing single-queue devices can be reused
+  std::vector<std::unique_ptr<project::VPort>> vports;
+  auto report = [&](project::VPortError error) {
+    std::cerr << "Error: Failed to create VPort: " << project::to_string(error) << "\n";
+
+    if (error == project::VPortError::TapDeviceCreationFailed)
+    {
+      std::cerr << "\nHint: Creating TAP devices requires root privileges.\n";
+      std::cerr << "      Try running with sudo: sudo " << program_name << " " << vswitch_ip << " " << vswitch_port
+                << "\n";
+    }
+  };
 
-  // Parse command-line arguments
-  if (argc < 3 || argc > 4)
+  if (queues == 1)
   {
-    print_usage(argv[0]);
-    return EXIT_FAILURE;
+    auto vport_result = project::VPort::create(tap_device_name, vswitch_ip, vswitch_port, offloads);
+    if (!vport_result)
+    {
+      report(vport_result.error());
+      return vports;
+    }
+    vports.push_back(std::make_unique<project::VPort>(std::move(*vport_result)));
+    return vports;
   }
 
-  const char* vswitch_ip = argv[1];
-  const char* vswitch_port_str = argv[2];
-  const char* tap_device_name = (argc == 4) ? argv[3] : "";
+  auto vports_result = project::VPort::create_multi_queue(tap_device_name, vswitch_ip, vswitch_port, queues, offloads);
+  if (!vports_result)
+  {
+    report(vports_result.error());
+    return vports;
+  }
+  for (project::VPort& vport : *vports_result)
+  {
+    vports.push_back(std::make_unique<project::VPort>(std::move(vport)));
+  }
+  return vports;
+}
 
-  // Parse port number
-  char* endptr;
-  long port_long = std::strtol(vswitch_port_str, &endptr, 10);
+/**
+ * @brief How the VPorts talk to the VSwitch: tunnel keys, handed out in creation order, coalescing and failover
+ */
+struct LinkOptions
+{
+  std::vector<project::TunnelKey> keys;
+  project::TunnelCipher cipher = project::TunnelCipher::Aes256Gcm;
+  size_t next = 0;
+  std::chrono::microseconds coalesce_delay{ 0 };
+  std::vector<project::Endpoint> backups;
+  std::chrono::milliseconds failover_timeout = project::FAILOVER_DEFAULT_TIMEOUT;
+};
 
-  if (*endptr != '\0' || port_long <= 0 || port_long > 65535)
+/**
+ * @brief Create the VPorts for one TAP device, giving each the next key when encrypting
+ * @param link Keys for the VPorts (empty: cleartext), the coalescing delay and the backup nodes
+ * @return The VPorts, or none on failure
+ */
+std::vector<std::unique_ptr<project::VPort>> create_vports(const char* tap_device_name,
+                                                           const char* vswitch_ip,
+                                                           uint16_t vswitch_port,
+                                                           size_t queues,
+                                                           bool offloads,
+                                                           LinkOptions& link,
+                                                           const char* program_name)
+{
+  auto vports = create_cleartext_vports(tap_device_name, vswitch_ip, vswitch_port, queues, offloads, program_name);
+  for (auto& vport : vports)
   {
-    std::cerr << "Error: Invalid port number '" << vswitch_port_str << "'\n";
-    std::cerr << "Port must be between 1 and 65535.\n";
-    return EXIT_FAILURE;
+    if (link.coalesce_delay.count() > 0)
+    {
+      auto coalescing = vport->enable_coalescing(link.coalesce_delay);
+      if (!coalescing)
+      {
+        std::cerr << "Error: Failed to enable coalescing: " << project::to_string(coalescing.error()) << "\n";
+        vports.clear();
+        break;
+      }
+    }
+    if (!link.backups.empty())
+    {
+      static_cast<void>(vport->enable_failover(link.backups, link.failover_timeout));  // Backups were validated
+    }
+    if (link.keys.empty())
+    {
+      continue;
+    }
+
+    if (link.next == link.keys.size())
+    {
+      std::cerr << "Error: The key file has only " << link.keys.size() << " key(s), one per VPort is needed\n";
+      vports.clear();
+      break;
+    }
+    auto enabled = vport->enable_encryption(link.cipher, link.keys[link.next++]);
+    if (!enabled)
+    {
+      std::cerr << "Error: Failed to enable encryption: " << project::to_string(enabled.error()) << "\n";
+      vports.clear();
+      break;
+    }
   }
+  return vports;
+}
 
-  uint16_t vswitch_port = static_cast<uint16_t>(port_long);
+/**
+ * @brief Run the VPorts of one TAP device, each on its own forwarder threads, until a signal arrives
+ */
+int run_threaded(const char* tap_device_name, const char* vswitch_ip, uint16_t vswitch_port, size_t queues,
+                 bool offloads, LinkOptions& link, project::IoBackend io_backend, const char* program_name)
+{
+  // Create VPort instances
+  std::cout << "Creating VPort...\n";
+  g_vports = create_vports(tap_device_name, vswitch_ip, vswitch_port, queues, offloads, link, program_name);
+  if (g_vports.empty())
+  {
+    return EXIT_FAILURE;
+  }
 
-  std::cout << "Configuration:\n";
-  std::cout << "  VSwitch Address: " << vswitch_ip << ":" << vswitch_port << "\n";
-  std::cout << "  TAP Device: " << (tap_device_name[0] ? tap_device_name : "auto-assign") << "\n";
+  std::cout << "\nVPort created successfully!\n";
+  std::cout << "  Device: " << g_vports.front()->device_name() << "\n";
+  std::cout << "  Queues: " << g_vports.size() << "\n";
+  std::cout << "  VSwitch: " << g_vports.front()->vswitch_endpoint() << "\n";
   std::cout << "\n";
 
-  try
+  // Start forwarder threads
+  std::cout << "Starting forwarder threads...\n";
+  for (auto& vport : g_vports)
   {
-    // Setup signal handlers for graceful shutdown
-    setup_signal_handlers();
-
-    // Create VPort instance
-    std::cout << "Creating VPort...\n";
-    auto vport_result = project::VPort::create(tap_device_name, vswitch_ip, vswitch_port);
+    auto start_result = vport->start(io_backend);
 
-    if (!vport_result)
+    if (!start_result)
     {
-      std::cerr << "Error: Failed to create VPort: " << project::to_string(vport_result.error()) << "\n";
+      std::cerr << "Error: Failed to start VPort: " << project::to_string(start_result.error()) << "\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::cout << "\nVPort is running! Press Ctrl+C to stop.\n";
+  std::cout << "===========================================\n\n";
 
-      if (vport_result.error() == project::VPortError::TapDeviceCreationFailed)
+  // Keep the main thread alive
+  // The forwarder threads are running in the background
+  while (!g_vports.empty() && g_vports.front()->is_running())
+  {
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    if (g_dump_stats != 0)
+    {
+      g_dump_stats = 0;
+      for (const auto& vport : g_vports)
       {
-        std::cerr << "\nHint: Creating TAP devices requires root privileges.\n";
-        std::cerr << "      Try running with sudo: sudo " << argv[0] << " " << vswitch_ip << " " << vswitch_port
-                  << "\n";
+        std::cout << vport->stats_prometheus();
       }
+      std::cout << std::flush;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
 
+/**
+ * @brief Serve every TAP device from one event loop on this thread until a signal arrives
+ */
+int run_event_loop(const std::vector<const char*>& tap_device_names,
+                   const char* vswitch_ip,
+                   uint16_t vswitch_port,
+                   size_t queues,
+                   bool offloads,
+                   LinkOptions& link,
+                   const char* program_name)
+{
+  auto loop_result = project::EventLoop::create();
+  if (!loop_result)
+  {
+    std::cerr << "Error: Failed to create event loop: " << project::to_string(loop_result.error()) << "\n";
+    return EXIT_FAILURE;
+  }
+  auto loop = std::make_unique<project::EventLoop>(std::move(*loop_result));
+
+  // Attached VPorts must not move, so each lives behind its own pointer
+  std::vector<std::unique_ptr<project::VPort>> vports;
+  std::cout << "Creating " << tap_device_names.size() << " VPort(s)...\n";
+
+  for (const char* tap_device_name : tap_device_names)
+  {
+    auto device_vports =
+        create_vports(tap_device_name, vswitch_ip, vswitch_port, queues, offloads, link, program_name);
+    if (device_vports.empty())
+    {
       return EXIT_FAILURE;
     }
 
-    // Move VPort to global pointer for signal handler
-    g_vport = std::make_unique<project::VPort>(std::move(*vport_result));
+    for (auto& vport : device_vports)
+    {
+      auto attach_result = vport->attach(*loop);
+      if (!attach_result)
+      {
+        std::cerr << "Error: Failed to attach VPort: " << project::to_string(attach_result.error()) << "\n";
+        return EXIT_FAILURE;
+      }
 
-    std::cout << "\nVPort created successfully!\n";
-    std::cout << "  Device: " << g_vport->device_name() << "\n";
-    std::cout << "  VSwitch: " << g_vport->vswitch_endpoint() << "\n";
-    std::cout << "\n";
+      std::cout << "  Device: " << vport->device_name() << " -> " << vport->vswitch_endpoint() << "\n";
+      vports.push_back(std::move(vport));
+    }
+  }
 
-    // Start forwarder threads
-    std::cout << "Starting forwarder threads...\n";
-    auto start_result = g_vport->start();
+  g_loop = std::move(loop);
 
-    if (!start_result)
+  std::cout << "\nVPorts are running on one event loop! Press Ctrl+C to stop.\n";
+  std::cout << "===========================================\n\n";
+
+  // Short waits so a SIGUSR1 is noticed even without traffic
+  int status = EXIT_SUCCESS;
+  while (g_shutdown == 0)
+  {
+    auto result = g_loop->run_once(std::chrono::milliseconds(100));
+    if (!result)
     {
-      std::cerr << "Error: Failed to start VPort: " << project::to_string(start_result.error()) << "\n";
-      return EXIT_FAILURE;
+      std::cerr << "Error: Event loop failed: " << project::to_string(result.error()) << "\n";
+      status = EXIT_FAILURE;
+      break;
+    }
+
+    if (g_dump_stats != 0)
+    {
+      g_dump_stats = 0;
+      for (const auto& vport : vports)
+      {
+        std::cout << vport->stats_prometheus();
+      }
+      std::cout << std::flush;
     }
+  }
+
+  std::cout << "\n[VPort] Shutting down...\n";
+  vports.clear();  // Each stop() detaches from the loop, which must outlive them
+  return status;
+}
 
-    std::cout << "\nVPort is running! Press Ctrl+C to stop.\n";
-    std::cout << "===========================================\n\n";
+int main(int argc, char* argv[])
+{
+  std::cout << "=== VPort - Virtual Port for VSwitch ===\n\n";
 
-    // Keep the main thread alive
-    // The forwarder threads are running in the background
-    while (g_vport && g_vport->is_running())
+  bool event_loop = false;
+  project::IoBackend io_backend = project::IoBackend::Syscalls;
+  size_t queues = 1;
+  bool offloads = false;
+  LinkOptions link;
+  int first = 1;
+  for (; first < argc && std::strncmp(argv[first], "--", 2) == 0; ++first)
+  {
+    if (std::strcmp(argv[first], "--event-loop") == 0 && io_backend == project::IoBackend::Syscalls)
+    {
+      event_loop = true;
+    }
+    else if (std::strcmp(argv[first], "--io-uring") == 0 && !event_loop)
+    {
+      io_backend = project::IoBackend::IoUring;
+    }
+    else if (std::strcmp(argv[first], "--offload") == 0)
+    {
+      offloads = true;
+    }
+    else if (std::strcmp(argv[first], "--queues") == 0 && first + 1 < argc)
+    {
+      char* endptr;
+      const char* queues_str = argv[++first];
+      long queues_long = std::strtol(queues_str, &endptr, 10);
+      if (*endptr != '\0' || queues_long < 1 || static_cast<size_t>(queues_long) > project::TAP_MAX_QUEUES)
+      {
+        std::cerr << "Error: Invalid queue count '" << queues_str << "'\n";
+        return EXIT_FAILURE;
+      }
+      queues = static_cast<size_t>(queues_long);
+    }
+    else if (std::strcmp(argv[first], "--key-file") == 0 && first + 1 < argc)
+    {
+      const char* path = argv[++first];
+      auto keys = project::load_tunnel_keys(path);
+      if (!keys || keys->empty())
+      {
+        std::cerr << "Error: Key file '" << path << "': "
+                  << (keys ? "no keys" : project::to_string(keys.error())) << "\n";
+        return EXIT_FAILURE;
+      }
+      link.keys = std::move(*keys);
+    }
+    else if (std::strcmp(argv[first], "--coalesce") == 0 && first + 1 < argc)
+    {
+      char* endptr;
+      const char* delay_str = argv[++first];
+      long delay_long = std::strtol(delay_str, &endptr, 10);
+      if (*endptr != '\0' || delay_long < 1 || delay_long > 1'000'000)
+      {
+        std::cerr << "Error: Invalid coalescing delay '" << delay_str << "'\n";
+        return EXIT_FAILURE;
+      }
+      link.coalesce_delay = std::chrono::microseconds(delay_long);
+    }
+    else if (std::strcmp(argv[first], "--backup") == 0 && first + 1 < argc)
+    {
+      const char* node_str = argv[++first];
+      auto node = project::parse_cluster_node(node_str);
+      if (!node)
+      {
+        std::cerr << "Error: Backup '" << node_str << "': " << project::to_string(node.error()) << "\n";
+        return EXIT_FAILURE;
+      }
+      link.backups.push_back(*node);
+    }
+    else if (std::strcmp(argv[first], "--failover-timeout") == 0 && first + 1 < argc)
+    {
+      char* endptr;
+      const char* timeout_str = argv[++first];
+      long timeout_long = std::strtol(timeout_str, &endptr, 10);
+      if (*endptr != '\0' || timeout_long < 1 || timeout_long > 3'600'000)
+      {
+        std::cerr << "Error: Invalid failover timeout '" << timeout_str << "'\n";
+        return EXIT_FAILURE;
+      }
+      link.failover_timeout = std::chrono::milliseconds(timeout_long);
+    }
+    else if (std::strcmp(argv[first], "--cipher") == 0 && first + 1 < argc)
+    {
+      const char* cipher_str = argv[++first];
+      auto cipher = project::parse_tunnel_cipher(cipher_str);
+      if (!cipher)
+      {
+        std::cerr << "Error: Invalid cipher '" << cipher_str << "'\n";
+        return EXIT_FAILURE;
+      }
+      link.cipher = *cipher;
+    }
+    else
     {
-      std::this_thread::sleep_for(std::chrono::seconds(1));
+      print_usage(argv[0]);
+      return EXIT_FAILURE;
     }
   }
+
+  // Parse command-line arguments; only the event loop hosts more than one TAP device
+  const int positional = argc - first;
+  if (positional < 2 || (!event_loop && positional > 3))
+  {
+    print_usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const char* vswitch_ip = argv[first];
+  const char* vswitch_port_str = argv[first + 1];
+  std::vector<const char*> tap_device_names(argv + first + 2, argv + argc);
+  if (tap_device_names.empty())
+  {
+    tap_device_names.push_back("");
+  }
+
+  // Parse port number
+  char* endptr;
+  long port_long = std::strtol(vswitch_port_str, &endptr, 10);
+
+  if (*endptr != '\0' || port_long <= 0 || port_long > 65535)
+  {
+    std::cerr << "Error: Invalid port number '" << vswitch_port_str << "'\n";
+    std::cerr << "Port must be between 1 and 65535.\n";
+    return EXIT_FAILURE;
+  }
+
+  uint16_t vswitch_port = static_cast<uint16_t>(port_long);
+
+  std::cout << "Configuration:\n";
+  std::cout << "  VSwitch Address: " << vswitch_ip << ":" << vswitch_port << "\n";
+  for (const char* tap_device_name : tap_device_names)
+  {
+    std::cout << "  TAP Device: " << (tap_device_name[0] ? tap_device_name : "auto-assign") << "\n";
+  }
+  std::cout << "  Queues: " << queues << (offloads ? " (offloads)" : "") << "\n";
+  if (!link.keys.empty())
+  {
+    std::cout << "  Encryption: " << project::to_string(link.cipher) << ", " << link.keys.size()
+              << " key(s)\n";
+  }
+  if (link.coalesce_delay.count() > 0)
+  {
+    std::cout << "  Coalescing: frames up to " << project::COALESCE_MAX_FRAME_SIZE << " bytes, "
+              << link.coalesce_delay.count() << " us\n";
+  }
+  for (const auto& backup : link.backups)
+  {
+    std::cout << "  Backup VSwitch: " << backup << " (after " << link.failover_timeout.count() << " ms of silence)\n";
+  }
+  std::cout << "  Mode: " << (event_loop ? "event loop" : "forwarder threads") << " (" << project::to_string(io_backend)
+            << ")\n";
+  std::cout << "\n";
+
+  int status = EXIT_SUCCESS;
+  try
+  {
+    // Setup signal handlers for graceful shutdown
+    setup_signal_handlers();
+
+    status = event_loop
+                 ? run_event_loop(tap_device_names, vswitch_ip, vswitch_port, queues, offloads, link, argv[0])
+                 : run_threaded(tap_device_names.front(), vswitch_ip, vswitch_port, queues, offloads, link,
+                                io_backend, argv[0]);
+  }
   catch (const std::exception& e)
   {
     std::cerr << "Fatal error: " << e.what() << "\n";
@@ -157,7 +554,9 @@ int main(int argc, char* argv[])
     return EXIT_FAILURE;
   }
 
-  std::cout << "\nVPort shut down successfully.\n";
-  return EXIT_SUCCESS;
+  if (status == EXIT_SUCCESS)
+  {
+    std::cout << "\nVPort shut down successfully.\n";
+  }
+  return status;
 }
-
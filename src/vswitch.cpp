@@ -5,10 +5,31 @@
 
 #include "project/vswitch.hpp"
 
-#include <iostream>
+#include "project/logger.hpp"
+#include "project/packet_ring.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <optional>
+#include <thread>
+
+#if PROJECT_HAVE_IO_URING
+#include <sys/socket.h>
+#endif
 
 namespace project
 {
+  namespace
+  {
+    uint64_t steady_now_ns() noexcept
+    {
+      return static_cast<uint64_t>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+              .count());
+    }
+  }  // namespace
+
   const char* to_string(VSwitchError error) noexcept
   {
     switch (error)
@@ -21,38 +42,371 @@ namespace project
         return "VSwitch is already running";
       case VSwitchError::NotRunning:
         return "VSwitch is not running";
+      case VSwitchError::InvalidVlanConfig:
+        return "Invalid VLAN port configuration";
+      case VSwitchError::HandoffFailed:
+        return "Failed to take over sockets from the running switch";
+      case VSwitchError::EncryptionFailed:
+        return "Failed to set up tunnel encryption";
+      case VSwitchError::InvalidClusterConfig:
+        return "Invalid cluster configuration";
       default:
         return "Unknown VSwitch error";
     }
   }
 
+  const char* to_string(FloodPolicy policy) noexcept
+  {
+    switch (policy)
+    {
+      case FloodPolicy::Drop:
+        return "drop";
+      case FloodPolicy::Flood:
+        return "flood";
+      default:
+        return "unknown";
+    }
+  }
+
+  std::optional<FloodPolicy> parse_flood_policy(std::string_view name) noexcept
+  {
+    for (FloodPolicy policy : { FloodPolicy::Drop, FloodPolicy::Flood })
+    {
+      if (name == to_string(policy))
+      {
+        return policy;
+      }
+    }
+    return std::nullopt;
+  }
+
   expected<VSwitch, VSwitchError> VSwitch::create(uint16_t port)
   {
-    // Create UDP socket
-    auto socket_result = UdpSocket::create();
-    if (!socket_result)
+    VSwitchConfig config;
+    config.port = port;
+    return create(config);
+  }
+
+  expected<VSwitch, VSwitchError> VSwitch::create(const VSwitchConfig& config)
+  {
+    size_t worker_count = std::max(config.workers, size_t{ 1 });
+    bool reuse_port = worker_count > 1;
+
+    std::vector<UdpSocket> sockets;
+    sockets.reserve(worker_count);
+
+    uint16_t bind_port = config.port;
+    for (size_t i = 0; i < worker_count; ++i)
+    {
+      // Create UDP socket
+      auto socket_result = UdpSocket::create();
+      if (!socket_result)
+      {
+        return unexpected(VSwitchError::SocketCreationFailed);
+      }
+
+      UdpSocket socket = std::move(*socket_result);
+
+      if (reuse_port && !socket.set_reuse_port(true))
+      {
+        return unexpected(VSwitchError::SocketCreationFailed);
+      }
+
+      // Wake up periodically so stop() is noticed without any traffic
+      if (!socket.set_receive_timeout(VSWITCH_STOP_POLL_INTERVAL))
+      {
+        return unexpected(VSwitchError::SocketCreationFailed);
+      }
+
+      // Bind to the specified port
+      auto bind_result = socket.bind("0.0.0.0", bind_port);
+      if (!bind_result)
+      {
+        return unexpected(VSwitchError::BindFailed);
+      }
+
+      // With an ephemeral port, the remaining workers join the port the first one got
+      if (bind_port == 0)
+      {
+        auto bound = socket.bound_endpoint();
+        if (!bound)
+        {
+          return unexpected(VSwitchError::BindFailed);
+        }
+        bind_port = bound->port();
+      }
+
+      if (config.zerocopy && !socket.set_zerocopy(true))
+      {
+        PROJECT_LOG_WARN("[VSwitch] Zero-copy sends are not supported here; copying instead");
+      }
+
+      sockets.push_back(std::move(socket));
+    }
+
+    auto vswitch = assemble(config, std::move(sockets), bind_port);
+    if (vswitch)
+    {
+      vswitch->restore_mac_snapshot();
+    }
+    return vswitch;
+  }
+
+  expected<VSwitch, VSwitchError> VSwitch::take_over(const VSwitchConfig& config, int channel)
+  {
+    auto handoff = receive_handoff(channel);
+    if (!handoff)
+    {
+      PROJECT_LOG_ERROR("[VSwitch] %s", to_string(handoff.error()));
+      return unexpected(VSwitchError::HandoffFailed);
+    }
+    if (handoff->sockets.empty())
+    {
+      PROJECT_LOG_ERROR("[VSwitch] The running switch handed over no sockets");
+      return unexpected(VSwitchError::HandoffFailed);
+    }
+
+    // The sockets come bound and shared; only the per-process settings need redoing
+    std::vector<UdpSocket> sockets;
+    sockets.reserve(handoff->sockets.size());
+    for (auto& handle : handoff->sockets)
+    {
+      auto socket = UdpSocket::adopt(std::move(handle));
+      if (!socket || !socket->set_nonblocking(false) || !socket->set_receive_timeout(VSWITCH_STOP_POLL_INTERVAL))
+      {
+        return unexpected(VSwitchError::SocketCreationFailed);
+      }
+      if (config.zerocopy && !socket->set_zerocopy(true))
+      {
+        PROJECT_LOG_WARN("[VSwitch] Zero-copy sends are not supported here; copying instead");
+      }
+      sockets.push_back(std::move(*socket));
+    }
+
+    const uint16_t port = sockets.front().local_endpoint().port();
+    if (config.port != 0 && config.port != port)
+    {
+      PROJECT_LOG_WARN("[VSwitch] Took over port %u rather than the configured %u", unsigned{ port },
+                       unsigned{ config.port });
+    }
+    if (std::max(config.workers, size_t{ 1 }) != sockets.size())
+    {
+      PROJECT_LOG_WARN("[VSwitch] Running the %zu worker(s) handed over rather than the configured %zu",
+                       sockets.size(), std::max(config.workers, size_t{ 1 }));
+    }
+
+    auto vswitch = assemble(config, std::move(sockets), port);
+    if (!vswitch)
+    {
+      return vswitch;
+    }
+
+    // The predecessor's table is fresher than any snapshot file
+    auto restored = restore_mac_table(handoff->state.data(), handoff->state.size(), vswitch->mac_table_,
+                                      vswitch->mac_aging_time_);
+    if (restored)
+    {
+      PROJECT_LOG_INFO("[VSwitch] Took over %zu socket(s) on port %u and %zu MAC addresses", vswitch->workers_.size(),
+                       unsigned{ port }, *restored);
+    }
+    else
+    {
+      PROJECT_LOG_WARN("[VSwitch] Handed-over MAC table: %s", to_string(restored.error()));
+      vswitch->restore_mac_snapshot();
+    }
+
+    if (auto acked = send_handoff_ack(channel); !acked)
+    {
+      PROJECT_LOG_ERROR("[VSwitch] %s", to_string(acked.error()));
+      return unexpected(VSwitchError::HandoffFailed);
+    }
+
+    // Acknowledged, the predecessor stops reading its packet rings; until now their drop filter kept the
+    // sockets from queueing a second copy of each datagram. A socket with a ring of its own keeps that filter
+    for (auto& worker : vswitch->workers_)
+    {
+      if (worker.socket.packet_ring_attached())
+      {
+        continue;
+      }
+      if (auto detached = worker.socket.detach_socket_filter(); !detached)
+      {
+        PROJECT_LOG_ERROR("[VSwitch] Reopening a handed-over socket: %s", to_string(detached.error()));
+        return unexpected(VSwitchError::SocketCreationFailed);
+      }
+    }
+    return vswitch;
+  }
+
+  expected<VSwitch, VSwitchError> VSwitch::assemble(const VSwitchConfig& config, std::vector<UdpSocket> sockets,
+                                                    uint16_t port)
+  {
+    auto vlans = VlanMap::create(config.vlan_ports, config.default_vlan);
+    if (!vlans)
+    {
+      PROJECT_LOG_ERROR("[VSwitch] %s", to_string(vlans.error()));
+      return unexpected(VSwitchError::InvalidVlanConfig);
+    }
+
+    for (const auto& peer : config.cluster_peers)
+    {
+      if (!peer.is_valid() || peer.family() != AF_INET)
+      {
+        PROJECT_LOG_ERROR("[VSwitch] Invalid cluster peer %s (expected an IPv4 address and a port)",
+                          peer.to_string().c_str());
+        return unexpected(VSwitchError::InvalidClusterConfig);
+      }
+    }
+    if (!config.cluster_peers.empty() && !config.tunnel_keys.empty())
+    {
+      PROJECT_LOG_ERROR("[VSwitch] Cluster peers cannot be combined with encryption");
+      return unexpected(VSwitchError::InvalidClusterConfig);
+    }
+
+    size_t batch_size = std::clamp(config.batch_size, size_t{ 1 }, UDP_MAX_BATCH_SIZE);
+    size_t max_frame_size = std::clamp(config.max_frame_size, FRAME_BUFFER_SIZE, VSWITCH_MAX_FRAME_SIZE);
+
+    std::unique_ptr<TunnelKeyring> tunnel;
+    if (!config.tunnel_keys.empty())
+    {
+      auto keyring = TunnelKeyring::create(config.tunnel_cipher, TunnelRole::Switch, config.tunnel_keys);
+      if (!keyring)
+      {
+        PROJECT_LOG_ERROR("[VSwitch] %s", to_string(keyring.error()));
+        return unexpected(VSwitchError::EncryptionFailed);
+      }
+      tunnel = std::move(*keyring);
+      if (config.io_backend == IoBackend::IoUring)
+      {
+        PROJECT_LOG_WARN("[VSwitch] The io_uring backend does not encrypt; workers use syscalls");
+      }
+      PROJECT_LOG_INFO("[VSwitch] Encrypting with %s for %zu VPort key(s)", to_string(config.tunnel_cipher),
+                       tunnel->size());
+    }
+    const size_t datagram_size = max_frame_size + (tunnel ? TUNNEL_OVERHEAD : 0);
+
+    if (!config.packet_ring_interface.empty() && config.io_backend == IoBackend::IoUring)
+    {
+      PROJECT_LOG_WARN("[VSwitch] Packet rings are not used with the io_uring backend");
+    }
+    else if (!config.packet_ring_interface.empty())
+    {
+      // All or nothing, so every worker takes its share of the fanout
+      std::vector<PacketRing> rings;
+      rings.reserve(sockets.size());
+      for (const auto& socket : sockets)
+      {
+        auto bound = socket.bound_endpoint();
+        auto ring = bound ? PacketRing::create(config.packet_ring_interface, *bound, datagram_size)
+                          : expected<PacketRing, PacketRingError>(unexpected(PacketRingError::BindFailed));
+        if (!ring)
+        {
+          PROJECT_LOG_WARN("[VSwitch] Packet ring on %s: %s; using sockets", config.packet_ring_interface.c_str(),
+                           to_string(ring.error()));
+          rings.clear();
+          break;
+        }
+        rings.push_back(std::move(*ring));
+      }
+      for (size_t index = 0; index < rings.size(); ++index)
+      {
+        if (!sockets[index].attach_packet_ring(std::move(rings[index])))
+        {
+          return unexpected(VSwitchError::SocketCreationFailed);
+        }
+      }
+      if (!rings.empty())
+      {
+        PROJECT_LOG_INFO("[VSwitch] Receiving and sending through %zu TPACKET_V3 ring(s) on %s", rings.size(),
+                         config.packet_ring_interface.c_str());
+      }
+    }
+
+    return VSwitch(std::move(sockets), port, batch_size, config.pin_cpus, config.mac_aging_time, config.io_backend,
+                   max_frame_size, std::move(*vlans), config, std::move(tunnel));
+  }
+
+  expected<void, HandoffError> VSwitch::hand_over(int channel)
+  {
+    std::vector<int> sockets;
+    sockets.reserve(workers_.size());
+    for (const auto& worker : workers_)
     {
-      return unexpected(VSwitchError::SocketCreationFailed);
+      sockets.push_back(worker.socket.get_fd());
     }
 
-    UdpSocket socket = std::move(*socket_result);
+    if (auto sent = send_handoff(channel, sockets, snapshot_mac_table(mac_table_)); !sent)
+    {
+      return sent;
+    }
 
-    // Bind to the specified port
-    auto bind_result = socket.bind("0.0.0.0", port);
-    if (!bind_result)
+    // Keep forwarding until the successor has the sockets; after that, what this process does not read waits for it
+    if (auto acked = wait_handoff_ack(channel); !acked)
     {
-      return unexpected(VSwitchError::BindFailed);
+      return acked;
     }
 
-    return VSwitch(std::move(socket), port);
+    PROJECT_LOG_INFO("[VSwitch] Handed %zu socket(s) and %zu MAC addresses to the successor", sockets.size(),
+                     mac_table_.size());
+    stop();
+    return expected<void, HandoffError>();
   }
 
-  VSwitch::VSwitch(UdpSocket socket, uint16_t port) noexcept : socket_(std::move(socket)), port_(port), running_(false)
+  VSwitch::VSwitch(std::vector<UdpSocket> sockets, uint16_t port, size_t batch_size, bool pin_cpus,
+                   std::chrono::seconds mac_aging_time, IoBackend io_backend, size_t max_frame_size,
+                   VlanMap vlans, const VSwitchConfig& config, std::unique_ptr<TunnelKeyring> tunnel)
+      : port_(port),
+        batch_size_(batch_size),
+        pin_cpus_(pin_cpus),
+        mac_aging_time_(mac_aging_time),
+        io_backend_(io_backend),
+        max_frame_size_(max_frame_size),
+        vlans_(std::move(vlans)),
+        unknown_unicast_(config.unknown_unicast),
+        multicast_snooping_(config.multicast_snooping),
+        unknown_multicast_(config.unknown_multicast),
+        ingress_rate_(config.ingress_rate),
+        ingress_burst_(config.ingress_burst),
+        priority_queues_(config.priority_queues),
+        mac_snapshot_path_(config.mac_snapshot_path),
+        mac_snapshot_interval_(config.mac_snapshot_interval),
+        tunnel_(std::move(tunnel)),
+        peers_(config.cluster_peers),
+        cluster_sync_interval_(std::max(config.cluster_sync_interval, std::chrono::milliseconds(1))),
+        running_(false)
   {
+    workers_.resize(sockets.size());
+    for (size_t i = 0; i < sockets.size(); ++i)
+    {
+      workers_[i].socket = std::move(sockets[i]);
+    }
   }
 
   VSwitch::VSwitch(VSwitch&& other) noexcept
-      : socket_(std::move(other.socket_)), mac_table_(std::move(other.mac_table_)), port_(other.port_), running_(other.running_.load())
+      : workers_(std::move(other.workers_)),
+        mac_table_(std::move(other.mac_table_)),
+        multicast_(std::move(other.multicast_)),
+        port_(other.port_),
+        batch_size_(other.batch_size_),
+        pin_cpus_(other.pin_cpus_),
+        mac_aging_time_(other.mac_aging_time_),
+        io_backend_(other.io_backend_),
+        max_frame_size_(other.max_frame_size_),
+        vlans_(std::move(other.vlans_)),
+        unknown_unicast_(other.unknown_unicast_),
+        multicast_snooping_(other.multicast_snooping_),
+        unknown_multicast_(other.unknown_multicast_),
+        ingress_rate_(other.ingress_rate_),
+        ingress_burst_(other.ingress_burst_),
+        priority_queues_(other.priority_queues_),
+        mac_snapshot_path_(std::move(other.mac_snapshot_path_)),
+        mac_snapshot_interval_(other.mac_snapshot_interval_),
+        tunnel_(std::move(other.tunnel_)),
+        peers_(std::move(other.peers_)),
+        cluster_sync_interval_(other.cluster_sync_interval_),
+        cluster_sync_(std::move(other.cluster_sync_)),
+        cluster_rounds_(other.cluster_rounds_),
+        running_(other.running_.load())
   {
   }
 
@@ -61,9 +415,29 @@ namespace project
     if (this != &other)
     {
       stop();
-      socket_ = std::move(other.socket_);
+      workers_ = std::move(other.workers_);
       mac_table_ = std::move(other.mac_table_);
+      multicast_ = std::move(other.multicast_);
       port_ = other.port_;
+      batch_size_ = other.batch_size_;
+      pin_cpus_ = other.pin_cpus_;
+      mac_aging_time_ = other.mac_aging_time_;
+      io_backend_ = other.io_backend_;
+      max_frame_size_ = other.max_frame_size_;
+      vlans_ = std::move(other.vlans_);
+      unknown_unicast_ = other.unknown_unicast_;
+      multicast_snooping_ = other.multicast_snooping_;
+      unknown_multicast_ = other.unknown_multicast_;
+      ingress_rate_ = other.ingress_rate_;
+      ingress_burst_ = other.ingress_burst_;
+      priority_queues_ = other.priority_queues_;
+      mac_snapshot_path_ = std::move(other.mac_snapshot_path_);
+      mac_snapshot_interval_ = other.mac_snapshot_interval_;
+      tunnel_ = std::move(other.tunnel_);
+      peers_ = std::move(other.peers_);
+      cluster_sync_interval_ = other.cluster_sync_interval_;
+      cluster_sync_ = std::move(other.cluster_sync_);
+      cluster_rounds_ = other.cluster_rounds_;
       running_.store(other.running_.load());
     }
     return *this;
@@ -81,112 +455,1131 @@ namespace project
       return unexpected(VSwitchError::AlreadyRunning);
     }
 
-    std::cout << "[VSwitch] Started at 0.0.0.0:" << port_ << "\n";
-    std::cout << "[VSwitch] Ready to receive frames from VPorts\n";
+    if (workers_.empty())
+    {
+      return unexpected(VSwitchError::NotRunning);  // Default-constructed: no sockets
+    }
+
+    PROJECT_LOG_INFO("[VSwitch] Started at 0.0.0.0:%u with %zu worker(s) using %s", unsigned{ port_ }, workers_.size(),
+                     to_string(io_backend_));
+    PROJECT_LOG_INFO("[VSwitch] Classifying bursts with %s", to_string(detected_simd_level()));
+    if (vlans_.enabled())
+    {
+      PROJECT_LOG_INFO("[VSwitch] VLAN-aware with %zu configured port(s)", vlans_.size());
+    }
+    PROJECT_LOG_INFO("[VSwitch] Multicast snooping %s; unknown unicast: %s, unknown multicast: %s",
+                     multicast_snooping_ ? "on" : "off", to_string(unknown_unicast_), to_string(unknown_multicast_));
+    if (ingress_rate_ > 0)
+    {
+      PROJECT_LOG_INFO("[VSwitch] Policing each port to %llu bytes/s (burst %llu bytes)",
+                       static_cast<unsigned long long>(ingress_rate_), static_cast<unsigned long long>(ingress_burst_));
+    }
+    if (priority_queues_)
+    {
+      PROJECT_LOG_INFO("[VSwitch] Sending in priority order (%zu classes, DRR)", QOS_CLASS_COUNT);
+    }
+    if (!peers_.empty())
+    {
+      PROJECT_LOG_INFO("[VSwitch] Clustered with %zu peer(s), syncing MACs every %lld ms", peers_.size(),
+                       static_cast<long long>(cluster_sync_interval_.count()));
+    }
+    PROJECT_LOG_INFO("[VSwitch] Ready to receive frames from VPorts");
 
     running_.store(true);
 
-    while (running_.load())
+#if PROJECT_LATENCY_HISTOGRAMS
+    static_cast<void>(latency_ns_per_tick());  // Calibrate the clock now rather than in a snapshot
+#endif
+
+    if (mac_aging_time_.count() > 0)
     {
-      // Receive Ethernet frame from VPort
-      auto recv_result = socket_.receive_from();
+      // Sweep a few times per aging period so entries outlive it by at most a quarter
+      auto interval = std::clamp<std::chrono::milliseconds>(mac_aging_time_ / 4, std::chrono::seconds(1),
+                                                            std::chrono::seconds(60));
+      sweeper_ = std::make_unique<AgingSweeper>(interval, [this]() { expire_macs(); });
+    }
 
-      if (!recv_result)
-      {
-        // Log error and continue (could be a temporary issue)
-        continue;
-      }
+    if (multicast_snooping_)
+    {
+      group_sweeper_ = std::make_unique<AgingSweeper>(std::chrono::seconds(1), [this]() { expire_groups(); });
+    }
+
+    if (!mac_snapshot_path_.empty() && mac_snapshot_interval_.count() > 0)
+    {
+      snapshot_writer_ = std::make_unique<AgingSweeper>(mac_snapshot_interval_, [this]() { write_mac_snapshot(); });
+    }
+
+    if (!peers_.empty())
+    {
+      cluster_rounds_ = 0;  // The first round announces everything
+      cluster_syncer_ = std::make_unique<AgingSweeper>(cluster_sync_interval_, [this]() { sync_cluster(); });
+    }
+
+    worker_threads_.clear();
+    worker_threads_.reserve(workers_.size() - 1);
+    for (size_t i = 1; i < workers_.size(); ++i)
+    {
+      worker_threads_.emplace_back([this, i]() { run_worker(i); });
+    }
 
-      auto& [frame_data, sender_endpoint] = *recv_result;
+    run_worker(0);
 
-      // Process the frame (learn MAC, forward if applicable)
-      process_frame(frame_data, sender_endpoint);
+    // Join the other workers (they exit within one poll interval of stop())
+    worker_threads_.clear();
+    sweeper_.reset();
+    group_sweeper_.reset();
+    snapshot_writer_.reset();
+    cluster_syncer_.reset();
+
+    if (!mac_snapshot_path_.empty())
+    {
+      write_mac_snapshot();
     }
 
     return expected<void, VSwitchError>();
   }
 
-  void VSwitch::stop() noexcept
+  expected<size_t, MacSnapshotError> VSwitch::save_mac_snapshot() const
   {
-    if (!running_.load())
+    if (mac_snapshot_path_.empty())
+    {
+      return unexpected(MacSnapshotError::OpenFailed);
+    }
+    return project::save_mac_snapshot(mac_snapshot_path_, mac_table_);
+  }
+
+  void VSwitch::write_mac_snapshot() const
+  {
+    auto saved = save_mac_snapshot();
+    if (saved)
+    {
+      PROJECT_LOG_DEBUG("[VSwitch] Saved %zu MAC addresses to %s", *saved, mac_snapshot_path_.c_str());
+    }
+    else
+    {
+      PROJECT_LOG_WARN("[VSwitch] %s: %s", mac_snapshot_path_.c_str(), to_string(saved.error()));
+    }
+  }
+
+  void VSwitch::restore_mac_snapshot()
+  {
+    if (mac_snapshot_path_.empty())
     {
       return;
     }
 
-    std::cout << "[VSwitch] Stopping...\n";
+    auto loaded = load_mac_snapshot(mac_snapshot_path_, mac_table_, mac_aging_time_);
+    if (loaded)
+    {
+      PROJECT_LOG_INFO("[VSwitch] Restored %zu MAC addresses from %s", *loaded, mac_snapshot_path_.c_str());
+    }
+    else if (loaded.error() == MacSnapshotError::OpenFailed && errno == ENOENT)
+    {
+      PROJECT_LOG_INFO("[VSwitch] No MAC snapshot at %s yet; starting cold", mac_snapshot_path_.c_str());
+    }
+    else
+    {
+      PROJECT_LOG_WARN("[VSwitch] %s: %s; starting cold", mac_snapshot_path_.c_str(), to_string(loaded.error()));
+    }
+  }
+
+  void VSwitch::sync_cluster()
+  {
+    // Refresh often enough that the peers' copies never age out between two announcements
+    auto refresh_interval = std::chrono::duration_cast<std::chrono::milliseconds>(CLUSTER_REFRESH_INTERVAL);
+    if (mac_aging_time_.count() > 0)
+    {
+      refresh_interval = std::min<std::chrono::milliseconds>(refresh_interval, mac_aging_time_ / 3);
+    }
+    const auto refresh_rounds = static_cast<size_t>(std::max<int64_t>(refresh_interval / cluster_sync_interval_, 1));
+    const bool refresh = cluster_rounds_++ % refresh_rounds == 0;
 
-    running_.store(false);
+    // Only what local VPorts sent is this node's to announce
+    std::vector<LearnedMac> owned = mac_table_.learned();
+    owned.erase(std::remove_if(owned.begin(), owned.end(),
+                               [this](const LearnedMac& entry) { return is_peer(entry.endpoint); }),
+                owned.end());
+    const std::vector<MacUpdate> updates = cluster_sync_.changes(owned, refresh);
+    if (updates.empty())
+    {
+      return;
+    }
 
-    std::cout << "[VSwitch] Stopped. Learned " << mac_table_.size() << " MAC addresses.\n";
+    // Any worker's socket will do: peers know this node by its port, which every worker shares
+    const auto datagrams = encode_mac_updates(updates);
+    UdpSocket& socket = workers_.front().socket;
+    for (const auto& peer : peers_)
+    {
+      for (const auto& datagram : datagrams)
+      {
+        if (auto sent = socket.send_to(datagram, peer); !sent)
+        {
+          PROJECT_LOG_DEBUG("[VSwitch] MAC update to %s: %s", peer.to_string().c_str(), to_string(sent.error()));
+        }
+      }
+    }
+    PROJECT_LOG_DEBUG("[VSwitch] Sent %zu MAC update(s) to %zu peer(s)%s", updates.size(), peers_.size(),
+                      refresh ? " (refresh)" : "");
   }
 
-  void VSwitch::process_frame(const std::vector<uint8_t>& frame_data, const Endpoint& sender_endpoint)
+  void VSwitch::apply_cluster_update(Worker& worker, const uint8_t* data, size_t size, const Endpoint& peer)
   {
-    // Parse Ethernet frame
-    auto frame = EthernetFrame::parse(frame_data);
+    auto count = decode_mac_updates(data, size, worker.cluster_updates);
+    if (!count)
+    {
+      PROJECT_LOG_TRACE("[VSwitch] Dropped MAC update from %s: %s", peer.to_string().c_str(),
+                        to_string(count.error()));
+      return;
+    }
 
-    // Log received frame
-    std::cout << "[VSwitch] Received frame from " << sender_endpoint << ": dst=" << frame.dst_mac()
-              << " src=" << frame.src_mac() << " size=" << frame_data.size() << "\n";
+    for (const auto& update : worker.cluster_updates)
+    {
+      if (update.kind == MacUpdateKind::Learn)
+      {
+        if (mac_table_.insert(update.vlan, update.mac, peer))
+        {
+          PROJECT_LOG_DEBUG("  [Learn] %s → %s (VLAN %u, from peer)", update.mac.to_string().c_str(),
+                            peer.to_string().c_str(), unsigned{ update.vlan });
+        }
+      }
+      else if (mac_table_.lookup(update.vlan, update.mac) == peer)
+      {
+        // Only if it still points there: the station may have moved here since
+        mac_table_.remove(update.vlan, update.mac);
+      }
+    }
+  }
 
-    // 1. Learn source MAC → sender endpoint mapping
-    bool is_new = mac_table_.insert(frame.src_mac(), sender_endpoint);
-    if (is_new)
+  void VSwitch::expire_groups()
+  {
+    size_t expired = multicast_.expire();
+    if (expired > 0)
     {
-      std::cout << "  [Learn] " << frame.src_mac() << " → " << sender_endpoint << "\n";
+      PROJECT_LOG_DEBUG("[VSwitch] %zu multicast subscription(s) lapsed", expired);
     }
+  }
 
-    // 2. Forward based on destination MAC
-    const auto& dst_mac = frame.dst_mac();
+  void VSwitch::expire_macs()
+  {
+    size_t evicted = mac_table_.expire(mac_aging_time_);
+    if (evicted > 0)
+    {
+      PROJECT_LOG_INFO("[VSwitch] Aged out %zu MAC addresses", evicted);
+    }
+  }
 
-    // Check if destination is known
-    auto dst_endpoint = mac_table_.lookup(dst_mac);
+  void VSwitch::run_worker(size_t index)
+  {
+    Worker& worker = workers_[index];
 
-    if (dst_endpoint.has_value())
+    if (pin_cpus_)
     {
-      // Unicast forward
-      auto send_result = socket_.send_to(frame_data, *dst_endpoint);
-      if (send_result)
+      unsigned int cpus = std::max(std::thread::hardware_concurrency(), 1U);
+      if (!pin_current_thread(index % cpus))
       {
-        log_frame(frame, sender_endpoint, "Forwarded to", dst_mac.to_string());
+        PROJECT_LOG_WARN("[VSwitch] Failed to pin worker %zu to CPU %zu", index, index % cpus);
       }
     }
-    else if (dst_mac.is_broadcast())
+
+    worker.policer = IngressPolicer(ingress_rate_, ingress_burst_);
+    worker.rx_records.resize(COALESCE_MAX_FRAMES);
+    worker.rx_record_sizes.resize(COALESCE_MAX_FRAMES);
+    worker.rx_record_keys.resize(COALESCE_MAX_FRAMES);
+
+    if (io_backend_ == IoBackend::IoUring && !tunnel_ && run_worker_uring(worker))
+    {
+      return;
+    }
+
+    // Take the burst buffers from a pool once; the loop below reuses them
+    worker.rx_buffers.clear();
+    worker.rx_pool = std::make_unique<FramePool>(batch_size_, max_frame_size_ + (tunnel_ ? TUNNEL_OVERHEAD : 0));
+    worker.rx_batch.resize(batch_size_);
+    worker.rx_frames.resize(batch_size_);
+    worker.rx_sizes.resize(batch_size_);
+    worker.rx_keys.resize(batch_size_);
+    for (size_t i = 0; i < batch_size_; ++i)
+    {
+      worker.rx_buffers.push_back(worker.rx_pool->acquire());
+      worker.rx_batch[i].data = worker.rx_buffers[i].data();
+      worker.rx_batch[i].capacity = worker.rx_buffers[i].capacity();
+      worker.rx_frames[i] = worker.rx_batch[i].data;
+    }
+    worker.tx_batch.clear();
+    worker.tx_batch.reserve(batch_size_);
+    if (tunnel_)
+    {
+      worker.tunnel = TunnelContext(*tunnel_);
+      worker.rx_opened.resize(batch_size_);
+    }
+
+    while (running_.load())
     {
-      // Broadcast to all known endpoints except source
-      auto all_endpoints = mac_table_.get_all_endpoints_except(frame.src_mac());
+      // Receive a burst of Ethernet frames from VPorts
+      auto recv_result = worker.socket.receive_batch(worker.rx_batch);
+
+      if (!recv_result)
+      {
+        // Timed out or temporary error: re-check the stop flag
+        continue;
+      }
+
+#if PROJECT_LATENCY_HISTOGRAMS
+      const uint64_t rx_ticks = latency_clock_ticks();
+      uint64_t forwarded = 0;
+#endif
+      worker.rx_time_ns = steady_now_ns();
+
+      // Classify the whole burst's headers at once; truncated datagrams come out as runts
+      const size_t received = *recv_result;
+      if (tunnel_)
+      {
+        open_rx_batch(worker, received);
+      }
+      else
+      {
+        for (size_t i = 0; i < received; ++i)
+        {
+          worker.rx_sizes[i] = worker.rx_batch[i].truncated ? 0 : worker.rx_batch[i].size;
+        }
+      }
+      classify_frames(worker.rx_frames.data(), worker.rx_sizes.data(), received, worker.rx_keys.data());
 
-      int sent_count = 0;
-      for (const auto& endpoint : all_endpoints)
+      // Process the burst (learn MACs, queue forwards), then send everything at once
+      for (size_t i = 0; i < received; ++i)
       {
-        auto send_result = socket_.send_to(frame_data, endpoint);
-        if (send_result)
+        const auto& datagram = worker.rx_batch[i];
+        TrafficCounters::add(worker.counters.rx_frames, 1);
+        TrafficCounters::add(worker.counters.rx_bytes, datagram.size);
+        if (datagram.truncated || (tunnel_ && worker.rx_sizes[i] == 0))
         {
-          sent_count++;
+          // Larger than max_frame_size, or not sealed by a VPort: drop rather than forward it
+          continue;
+        }
+#if PROJECT_LATENCY_HISTOGRAMS
+        const size_t queued = worker.tx_batch.size();
+        process_datagram(worker, worker.rx_frames[i], worker.rx_sizes[i], worker.rx_keys[i], datagram.sender);
+        if (worker.tx_batch.size() != queued)
+        {
+          ++forwarded;
         }
+#else
+        process_datagram(worker, worker.rx_frames[i], worker.rx_sizes[i], worker.rx_keys[i], datagram.sender);
+#endif
       }
 
-      if (sent_count > 0)
+      flush_tx_batch(worker);
+
+#if PROJECT_LATENCY_HISTOGRAMS
+      if (forwarded > 0)
       {
-        log_frame(frame, sender_endpoint, "Broadcasted to", std::to_string(sent_count) + " endpoints");
+        worker.latency.record(latency_clock_ticks() - rx_ticks, forwarded);
       }
-    }
-    else
-    {
-      // Unknown unicast - discard
-      log_frame(frame, sender_endpoint, "Discarded", "unknown MAC address");
+#endif
     }
   }
 
-  void VSwitch::log_frame(const EthernetFrame&, const Endpoint&, std::string_view action,
-                          std::string_view details) const
+#if PROJECT_HAVE_IO_URING
+  namespace
   {
-    std::cout << "  [" << action << "]";
-    if (!details.empty())
+    // Request kinds in the CQE tags of a worker ring
+    constexpr uint8_t URING_RECEIVE = 1;
+    constexpr uint8_t URING_SEND = 2;
+    constexpr uint8_t URING_CANCEL = 3;
+
+    // Receive buffers per worker and sends in flight per worker
+    constexpr uint16_t URING_BUFFER_COUNT = 1024;
+    constexpr uint32_t URING_SEND_SLOTS = 2048;
+  }  // namespace
+
+  bool VSwitch::run_worker_uring(Worker& worker)
+  {
+    auto ring = IoUring::create(256);
+    if (!ring)
+    {
+      PROJECT_LOG_WARN("[VSwitch] io_uring unavailable (%s), falling back to system calls", to_string(ring.error()));
+      return false;
+    }
+
+    // A multishot recvmsg writes a header and the sender address ahead of each payload
+    const size_t headroom = sizeof(struct io_uring_recvmsg_out) + Endpoint::sockaddr_capacity();
+    auto buffers = IoUringBufferRing::create(*ring, 0, URING_BUFFER_COUNT, headroom + max_frame_size_);
+    if (!buffers)
+    {
+      PROJECT_LOG_WARN("[VSwitch] io_uring buffer ring unavailable (%s), falling back to system calls",
+                       to_string(buffers.error()));
+      return false;
+    }
+
+    IoUringSendSlots slots(URING_SEND_SLOTS);
+    const int fd = worker.socket.get_fd();
+    struct msghdr receive_layout{};
+    receive_layout.msg_namelen = Endpoint::sockaddr_capacity();
+
+    bool receive_armed = false;
+    bool received_any = false;
+    bool receive_unsupported = false;
+
+    auto arm_receive = [&]() {
+      io_uring_sqe* sqe = ring->get_sqe();
+      if (sqe != nullptr)
+      {
+        sqe->opcode = IORING_OP_RECVMSG;
+        sqe->fd = fd;
+        sqe->addr = reinterpret_cast<uint64_t>(&receive_layout);
+        sqe->len = 1;
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = buffers->group();
+        sqe->user_data = io_uring_tag(URING_RECEIVE);
+        receive_armed = true;
+      }
+    };
+
+    // Queue one send per copy the switch decided on; each holds the receive buffer until it completes
+    auto queue_sends = [&](uint16_t buffer_id) {
+      for (const auto& datagram : worker.tx_batch)
+      {
+        uint32_t index = slots.acquire(datagram, buffer_id);
+        io_uring_sqe* sqe = index == IoUringSendSlots::NONE ? nullptr : ring->get_sqe();
+        if (sqe == nullptr)
+        {
+          // Full TX ring: drop the copy, as a NIC would
+          if (index != IoUringSendSlots::NONE)
+          {
+            slots.release(index);
+          }
+          TrafficCounters::add(worker.counters.send_errors, 1);
+          continue;
+        }
+
+        sqe->opcode = IORING_OP_SENDMSG;
+        sqe->fd = fd;
+        sqe->addr = reinterpret_cast<uint64_t>(&slots[index].message);
+        sqe->len = 1;
+        sqe->user_data = io_uring_tag(URING_SEND, index);
+        buffers->hold(buffer_id);
+      }
+      worker.tx_batch.clear();
+    };
+
+#if PROJECT_LATENCY_HISTOGRAMS
+    uint64_t forwarded = 0;
+#endif
+
+    auto handle_completion = [&](const io_uring_cqe& cqe) {
+      switch (io_uring_tag_kind(cqe.user_data))
+      {
+        case URING_SEND:
+        {
+          auto index = static_cast<uint32_t>(io_uring_tag_payload(cqe.user_data));
+          if (cqe.res < 0)
+          {
+            TrafficCounters::add(worker.counters.send_errors, 1);
+          }
+          else
+          {
+            TrafficCounters::add(worker.counters.tx_frames, 1);
+            TrafficCounters::add(worker.counters.tx_bytes, static_cast<uint64_t>(cqe.res));
+          }
+          buffers->release(slots[index].buffer_id);
+          slots.release(index);
+          break;
+        }
+        case URING_RECEIVE:
+        {
+          if ((cqe.flags & IORING_CQE_F_MORE) == 0)
+          {
+            receive_armed = false;  // Re-armed after this round (e.g., after -ENOBUFS)
+          }
+
+          const int buffer_id = IoUringBufferRing::buffer_id(cqe);
+          if (cqe.res < 0 || buffer_id < 0)
+          {
+            receive_unsupported = cqe.res == -EINVAL && !received_any;
+            break;
+          }
+          received_any = true;
+
+          const auto id = static_cast<uint16_t>(buffer_id);
+          buffers->hold(id);
+          const uint8_t* base = buffers->buffer(id);
+          struct io_uring_recvmsg_out out;
+          std::memcpy(&out, base, sizeof(out));
+
+          if (running_.load())
+          {
+            TrafficCounters::add(worker.counters.rx_frames, 1);
+            TrafficCounters::add(worker.counters.rx_bytes, out.payloadlen);
+          }
+
+          // Truncated datagrams are larger than max_frame_size: drop them
+          if (running_.load() && (out.flags & MSG_TRUNC) == 0)
+          {
+            Endpoint sender;
+            std::memcpy(sender.as_sockaddr(), base + sizeof(out),
+                        std::min<size_t>(out.namelen, Endpoint::sockaddr_capacity()));
+            const uint8_t* frame = base + headroom;
+            process_datagram(worker, frame, out.payloadlen, classify_frame(frame, out.payloadlen), sender);
+#if PROJECT_LATENCY_HISTOGRAMS
+            forwarded += worker.tx_batch.empty() ? 0 : 1;
+#endif
+            queue_sends(id);
+          }
+          buffers->release(id);
+          break;
+        }
+        default:
+          break;  // URING_CANCEL
+      }
+    };
+
+    arm_receive();
+    while (running_.load())
+    {
+      if (auto waited = ring->submit_and_wait(VSWITCH_STOP_POLL_INTERVAL); !waited)
+      {
+        PROJECT_LOG_ERROR("[VSwitch] io_uring wait failed: %s", to_string(waited.error()));
+        break;
+      }
+
+#if PROJECT_LATENCY_HISTOGRAMS
+      const uint64_t rx_ticks = latency_clock_ticks();
+      forwarded = 0;
+#endif
+      worker.rx_time_ns = steady_now_ns();
+      ring->for_each_completion(handle_completion);
+#if PROJECT_LATENCY_HISTOGRAMS
+      if (forwarded > 0)
+      {
+        worker.latency.record(latency_clock_ticks() - rx_ticks, forwarded);
+      }
+#endif
+
+      if (receive_unsupported)
+      {
+        PROJECT_LOG_WARN("[VSwitch] Kernel lacks multishot recvmsg, falling back to system calls");
+        return false;
+      }
+
+      if (!receive_armed)
+      {
+        arm_receive();
+      }
+    }
+
+    // Nothing may still write into the buffers once they are freed
+    if (ring->cancel_all(io_uring_tag(URING_CANCEL)))
+    {
+      for (int attempt = 0; attempt < 10 && (receive_armed || slots.in_flight() > 0); ++attempt)
+      {
+        if (!ring->submit_and_wait(VSWITCH_STOP_POLL_INTERVAL))
+        {
+          break;
+        }
+        ring->for_each_completion(handle_completion);
+      }
+    }
+    return true;
+  }
+#else
+  bool VSwitch::run_worker_uring(Worker&)
+  {
+    PROJECT_LOG_WARN("[VSwitch] io_uring support is not compiled in, using system calls");
+    return false;
+  }
+#endif
+
+  void VSwitch::stop() noexcept
+  {
+    if (!running_.load())
+    {
+      return;
+    }
+
+    PROJECT_LOG_INFO("[VSwitch] Stopping...");
+
+    running_.store(false);
+
+    PROJECT_LOG_INFO("[VSwitch] Stopped. Learned %zu MAC addresses.", mac_table_.size());
+  }
+
+  void VSwitch::process_frame(Worker& worker, const uint8_t* frame_data, size_t frame_size, const FrameKeys& keys,
+                              const Endpoint& sender_endpoint)
+  {
+    if (keys.kind == FrameClass::Runt)
+    {
+      return;  // Too short to be an Ethernet frame
+    }
+
+    PROJECT_LOG_TRACE("[VSwitch] Received frame from %s: dst=%s src=%s size=%zu", sender_endpoint.to_string().c_str(),
+                      keys.dst_mac().to_string().c_str(), keys.src_mac().to_string().c_str(), frame_size);
+
+    // Drop what the sender sends beyond its rate before it costs anything more; a peer carries many VPorts
+    const bool from_peer = is_peer(sender_endpoint);
+    if (!from_peer && !worker.policer.admit(sender_endpoint, frame_size, worker.rx_time_ns))
+    {
+      TrafficCounters::add(worker.counters.policed_drops, 1);
+      PROJECT_LOG_TRACE("  [Policed] %s over its ingress rate", sender_endpoint.to_string().c_str());
+      return;
+    }
+
+    // 0. Find the frame's VLAN (0 everywhere when the switch is not VLAN-aware)
+    uint16_t vlan = 0;
+    if (vlans_.enabled())
+    {
+      vlan = vlans_.port(sender_endpoint).ingress_vlan(frame_data, frame_size);
+      if (vlan == 0)
+      {
+        TrafficCounters::add(worker.counters.vlan_drops, 1);
+        PROJECT_LOG_TRACE("  [Discarded] not in a VLAN of %s", sender_endpoint.to_string().c_str());
+        return;
+      }
+    }
+
+    // 1. A unicast flow already seen this second was learned then and knows where it goes
+    const uint64_t generation = mac_table_.generation();
+    const MacTimestamp now = mac_timestamp_at(worker.rx_time_ns);
+    if (keys.kind == FrameClass::Unicast)
+    {
+      if (const Endpoint* egress = worker.flows.find(vlan, keys.src, keys.dst, sender_endpoint, generation, now))
+      {
+        enqueue(worker, frame_data, frame_size, *egress, vlan);
+        PROJECT_LOG_TRACE("  [Forwarded to] %s (cached)", keys.dst_mac().to_string().c_str());
+        return;
+      }
+    }
+
+    // 2. Learn source MAC → sender endpoint mapping
+    const MacAddress src_mac = keys.src_mac();
+    bool is_new = mac_table_.insert(vlan, src_mac, sender_endpoint, now);
+    if (is_new)
+    {
+      PROJECT_LOG_DEBUG("  [Learn] %s → %s (VLAN %u)", src_mac.to_string().c_str(), sender_endpoint.to_string().c_str(),
+                        unsigned{ vlan });
+    }
+
+    // 3. Forward based on destination MAC; only unicast needs the table
+    if (keys.kind == FrameClass::Broadcast)
+    {
+      // Broadcast once to every known port except the one it came from
+      size_t sent_count = flood(worker, frame_data, frame_size, vlan, sender_endpoint);
+      PROJECT_LOG_TRACE("  [Broadcasted to] %zu endpoints", sent_count);
+      return;
+    }
+
+    if (keys.kind == FrameClass::Multicast)
+    {
+      forward_multicast(worker, frame_data, frame_size, keys.dst_mac(), vlan, sender_endpoint);
+      return;
+    }
+
+    std::optional<Endpoint> dst_endpoint = mac_table_.lookup(vlan, keys.dst_mac());
+    if (dst_endpoint.has_value() && from_peer && is_peer(*dst_endpoint))
+    {
+      // The nodes disagree for the moment; never pass a frame on between peers
+      TrafficCounters::add(worker.counters.unknown_unicast_drops, 1);
+      PROJECT_LOG_TRACE("  [Discarded] %s is behind another peer", keys.dst_mac().to_string().c_str());
+    }
+    else if (dst_endpoint.has_value())
+    {
+      // Unicast forward; a change to the table since generation was read makes the entry stale
+      worker.flows.store(vlan, keys.src, keys.dst, sender_endpoint, *dst_endpoint, generation, now);
+      enqueue(worker, frame_data, frame_size, *dst_endpoint, vlan);
+      PROJECT_LOG_TRACE("  [Forwarded to] %s", keys.dst_mac().to_string().c_str());
+    }
+    else if (unknown_unicast_ == FloodPolicy::Flood)
+    {
+      size_t sent_count = flood(worker, frame_data, frame_size, vlan, sender_endpoint);
+      PROJECT_LOG_TRACE("  [Flooded] unknown MAC address to %zu endpoints", sent_count);
+    }
+    else
+    {
+      // Unknown unicast - discard
+      TrafficCounters::add(worker.counters.unknown_unicast_drops, 1);
+      PROJECT_LOG_TRACE("  [Discarded] unknown MAC address");
+    }
+  }
+
+  void VSwitch::process_datagram(Worker& worker, const uint8_t* data, size_t size, const FrameKeys& keys,
+                                 const Endpoint& sender_endpoint)
+  {
+    if (is_cluster_update(keys))
+    {
+      if (is_peer(sender_endpoint))
+      {
+        apply_cluster_update(worker, data, size, sender_endpoint);
+      }
+      return;
+    }
+    if (!is_coalesced(keys))
+    {
+      process_frame(worker, data, size, keys, sender_endpoint);
+      return;
+    }
+
+    auto count = split_coalesced(data, size, worker.rx_records.data(), worker.rx_record_sizes.data(),
+                                 worker.rx_records.size());
+    if (!count)
+    {
+      PROJECT_LOG_TRACE("[VSwitch] Dropped aggregate from %s: %s", sender_endpoint.to_string().c_str(),
+                        to_string(count.error()));
+      return;
+    }
+
+    // The datagram was counted as one frame
+    TrafficCounters::add(worker.counters.rx_frames, *count - 1);
+    classify_frames(worker.rx_records.data(), worker.rx_record_sizes.data(), *count, worker.rx_record_keys.data());
+    for (size_t i = 0; i < *count; ++i)
+    {
+      process_frame(worker, worker.rx_records[i], worker.rx_record_sizes[i], worker.rx_record_keys[i],
+                    sender_endpoint);
+    }
+  }
+
+  void VSwitch::enqueue(Worker& worker, const uint8_t* frame_data, size_t frame_size, const Endpoint& destination,
+                        uint16_t vlan) const
+  {
+    worker.tx_batch.push_back({ frame_data, frame_size, destination });
+    if (vlan != 0)
+    {
+      set_vlan_egress(worker.tx_batch.back(), vlan, vlans_.port(destination).egress_tagged(vlan));
+    }
+  }
+
+  size_t VSwitch::flood(Worker& worker, const uint8_t* frame_data, size_t frame_size, uint16_t vlan,
+                        const Endpoint& sender_endpoint) const
+  {
+    // Split horizon: what a peer sent, it has flooded to the other peers itself
+    const bool from_peer = is_peer(sender_endpoint);
+    size_t sent_count = 0;
+    if (vlan == 0)
+    {
+      for (const auto& endpoint : cached_flood_list(worker))
+      {
+        if (endpoint != sender_endpoint && !(from_peer && is_peer(endpoint)))
+        {
+          worker.tx_batch.push_back({ frame_data, frame_size, endpoint });
+          sent_count++;
+        }
+      }
+    }
+    else
+    {
+      for (const auto& target : cached_vlan_flood_list(worker, vlan))
+      {
+        if (target.endpoint != sender_endpoint && !(from_peer && is_peer(target.endpoint)))
+        {
+          worker.tx_batch.push_back({ frame_data, frame_size, target.endpoint });
+          set_vlan_egress(worker.tx_batch.back(), vlan, target.tagged);
+          sent_count++;
+        }
+      }
+    }
+
+    if (sent_count > 0)
+    {
+      TrafficCounters::add(worker.counters.floods, 1);
+    }
+    return sent_count;
+  }
+
+  void VSwitch::forward_multicast(Worker& worker, const uint8_t* frame_data, size_t frame_size,
+                                  const MacAddress& group, uint16_t vlan, const Endpoint& sender_endpoint)
+  {
+    // Membership messages mostly go to link-local groups, so snoop before those are flooded
+    const GroupTargets* targets = nullptr;
+    bool report = false;
+    if (multicast_snooping_ && parse_snooping_message(frame_data, frame_size, worker.snooped))
+    {
+      if (worker.snooped.kind == SnoopingKind::Query)
+      {
+        // Hosts answer the querier, so everyone in the VLAN must hear the query
+        if (multicast_.add_router(vlan, sender_endpoint))
+        {
+          PROJECT_LOG_DEBUG("  [Snoop] router port %s (VLAN %u)", sender_endpoint.to_string().c_str(),
+                            unsigned{ vlan });
+        }
+        flood(worker, frame_data, frame_size, vlan, sender_endpoint);
+        return;
+      }
+
+      for (const auto& snooped : worker.snooped.groups)
+      {
+        if (snooped.join)
+        {
+          if (multicast_.join(vlan, snooped.group, sender_endpoint))
+          {
+            PROJECT_LOG_DEBUG("  [Snoop] %s joined %s (VLAN %u)", sender_endpoint.to_string().c_str(),
+                              snooped.group.to_string().c_str(), unsigned{ vlan });
+          }
+        }
+        else if (multicast_.leave(vlan, snooped.group, sender_endpoint))
+        {
+          PROJECT_LOG_DEBUG("  [Snoop] %s left %s (VLAN %u)", sender_endpoint.to_string().c_str(),
+                            snooped.group.to_string().c_str(), unsigned{ vlan });
+        }
+      }
+
+      // Reports go to the routers only: a host hearing another's report would suppress its own
+      report = true;
+      targets = &cached_group_targets(worker, vlan, MacAddress::from_u64(0));  // No such group: just the routers
+    }
+    else if (multicast_always_flooded(group))
+    {
+      flood(worker, frame_data, frame_size, vlan, sender_endpoint);
+      return;
+    }
+    else if (!multicast_snooping_)
+    {
+      if (unknown_multicast_ == FloodPolicy::Flood)
+      {
+        flood(worker, frame_data, frame_size, vlan, sender_endpoint);
+      }
+      else
+      {
+        TrafficCounters::add(worker.counters.multicast_drops, 1);
+      }
+      return;
+    }
+    else
+    {
+      targets = &cached_group_targets(worker, vlan, group);
+      if (!targets->registered && unknown_multicast_ == FloodPolicy::Flood)
+      {
+        flood(worker, frame_data, frame_size, vlan, sender_endpoint);
+        return;
+      }
+    }
+
+    // Peers get everything from local ports, so that they can serve the members behind them, and nothing else
+    size_t sent_count = 0;
+    for (const auto& target : targets->targets)
+    {
+      if (target.endpoint != sender_endpoint && !is_peer(target.endpoint))
+      {
+        worker.tx_batch.push_back({ frame_data, frame_size, target.endpoint });
+        if (vlan != 0)
+        {
+          set_vlan_egress(worker.tx_batch.back(), vlan, target.tagged);
+        }
+        sent_count++;
+      }
+    }
+    if (!is_peer(sender_endpoint))
+    {
+      for (const auto& peer : peers_)
+      {
+        if (vlan == 0 || vlans_.port(peer).member(vlan))
+        {
+          enqueue(worker, frame_data, frame_size, peer, vlan);
+          sent_count++;
+        }
+      }
+    }
+
+    if (sent_count == 0 && !report)
+    {
+      TrafficCounters::add(worker.counters.multicast_drops, 1);
+    }
+    PROJECT_LOG_TRACE("  [Multicast to] %zu endpoints", sent_count);
+  }
+
+  const VSwitch::GroupTargets& VSwitch::cached_group_targets(Worker& worker, uint16_t vlan,
+                                                             const MacAddress& group) const
+  {
+    uint64_t generation = multicast_.generation();
+    if (worker.group_generation != generation)
+    {
+      worker.group_targets.clear();
+      worker.group_generation = generation;
+    }
+
+    uint64_t key = (uint64_t{ vlan } << 48) | group.to_u64();
+    auto [it, inserted] = worker.group_targets.try_emplace(key);
+    if (inserted)
+    {
+      it->second.registered = multicast_.members(vlan, group, worker.group_members);
+      for (const auto& endpoint : worker.group_members)
+      {
+        it->second.targets.push_back({ endpoint, vlans_.port(endpoint).egress_tagged(vlan) });
+      }
+    }
+    return it->second;
+  }
+
+  const std::vector<Endpoint>& VSwitch::cached_flood_list(Worker& worker) const
+  {
+    // Refetch only when an endpoint was added or removed since the last copy
+    if (worker.flood_generation != mac_table_.flood_generation())
+    {
+      worker.flood_list = mac_table_.flood_endpoints(worker.flood_generation);
+      for (const auto& peer : peers_)
+      {
+        if (std::find(worker.flood_list.begin(), worker.flood_list.end(), peer) == worker.flood_list.end())
+        {
+          worker.flood_list.push_back(peer);  // Peers hear broadcasts before any MAC was learned behind them
+        }
+      }
+      worker.vlan_flood_lists.clear();
+    }
+    return worker.flood_list;
+  }
+
+  const std::vector<VSwitch::FloodTarget>& VSwitch::cached_vlan_flood_list(Worker& worker, uint16_t vlan) const
+  {
+    const auto& flood_list = cached_flood_list(worker);
+    auto [it, inserted] = worker.vlan_flood_lists.try_emplace(vlan);
+    if (inserted)
+    {
+      for (const auto& endpoint : flood_list)
+      {
+        const VlanPort& port = vlans_.port(endpoint);
+        if (port.member(vlan))
+        {
+          it->second.push_back({ endpoint, port.egress_tagged(vlan) });
+        }
+      }
+    }
+    return it->second;
+  }
+
+  void VSwitch::flush_tx_batch(Worker& worker) const
+  {
+    if (worker.tx_batch.empty())
+    {
+      return;
+    }
+
+    if (priority_queues_)
+    {
+      worker.egress.schedule(worker.tx_batch);
+    }
+    if (tunnel_)
+    {
+      seal_tx_batch(worker);
+      if (worker.tx_batch.empty())
+      {
+        return;
+      }
+    }
+
+    size_t queued = worker.tx_batch.size();
+    size_t queued_bytes = 0;
+    for (const auto& datagram : worker.tx_batch)
+    {
+      queued_bytes += datagram.wire_size();
+    }
+
+    size_t sent = 0;
+    if (worker.socket.zerocopy_enabled() && !tunnel_)
+    {
+      sent = send_tx_batch_zerocopy(worker);
+    }
+    else
+    {
+      auto send_result = worker.socket.send_batch(worker.tx_batch);
+      sent = send_result ? *send_result : 0;
+    }
+    worker.tx_batch.clear();
+
+    // send_batch() does not say which datagrams failed; when some did, tx_bytes is prorated
+    TrafficCounters::add(worker.counters.tx_frames, sent);
+    TrafficCounters::add(worker.counters.tx_bytes, sent == queued ? queued_bytes : queued_bytes / queued * sent);
+    TrafficCounters::add(worker.counters.send_errors, queued - sent);
+  }
+
+  void VSwitch::open_rx_batch(Worker& worker, size_t received) const
+  {
+    worker.tunnel.open_batch(worker.rx_batch.data(), received, worker.rx_opened.data());
+
+    if (worker.tunnel_peer_generation != tunnel_->peers_generation())
+    {
+      worker.tunnel_peers.clear();
+      worker.tunnel_peer_generation = tunnel_->peers_generation();
+    }
+    for (size_t i = 0; i < received; ++i)
+    {
+      const TunnelFrame& frame = worker.rx_opened[i];
+      if (frame.data == nullptr)
+      {
+        worker.rx_sizes[i] = 0;
+        if (!worker.rx_batch[i].truncated)
+        {
+          TrafficCounters::add(worker.counters.crypto_drops, 1);
+        }
+        continue;
+      }
+      worker.rx_frames[i] = frame.data;
+      worker.rx_sizes[i] = frame.size;
+
+      // Binding takes the keyring's lock, so only when this worker saw the sender with another key
+      const Endpoint& sender = worker.rx_batch[i].sender;
+      auto cached = worker.tunnel_peers.find(sender);
+      if (cached == worker.tunnel_peers.end() || cached->second != frame.key_id)
+      {
+        tunnel_->bind(sender, frame.key_id);
+        worker.tunnel_peers[sender] = frame.key_id;
+      }
+    }
+  }
+
+  void VSwitch::seal_tx_batch(Worker& worker) const
+  {
+    if (worker.tunnel_peer_generation != tunnel_->peers_generation())
+    {
+      worker.tunnel_peers.clear();
+      worker.tunnel_peer_generation = tunnel_->peers_generation();
+    }
+
+    // Every copy gets its own slot: copies of one frame to different VPorts are sealed with different keys
+    const size_t count = worker.tx_batch.size();
+    const size_t stride = (max_frame_size_ + VLAN_TAG_SIZE + TUNNEL_OVERHEAD + 63) / 64 * 64;
+    worker.tx_keys.resize(count);
+    if (worker.tx_sealed.size() < count * stride)
+    {
+      worker.tx_sealed.resize(count * stride);
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+      const Endpoint& destination = worker.tx_batch[i].destination;
+      auto cached = worker.tunnel_peers.find(destination);
+      if (cached == worker.tunnel_peers.end())
+      {
+        // Cached as TUNNEL_NO_KEY too, which seal() refuses like any unknown key
+        auto key = tunnel_->key_of(destination);
+        cached = worker.tunnel_peers.emplace(destination, key ? *key : TUNNEL_NO_KEY).first;
+      }
+      worker.tx_keys[i] = cached->second;
+    }
+
+    size_t kept =
+        worker.tunnel.seal_batch(worker.tx_batch.data(), worker.tx_keys.data(), count, worker.tx_sealed.data(), stride);
+    worker.tx_batch.resize(kept);
+    TrafficCounters::add(worker.counters.crypto_drops, count - kept);
+  }
+
+  size_t VSwitch::send_tx_batch_zerocopy(Worker& worker) const
+  {
+    const auto& batch = worker.tx_batch;
+    size_t sent = 0;
+    size_t unsent = 0;  // First datagram not handed to the kernel yet
+
+    for (size_t i = 0; i < batch.size();)
+    {
+      if (batch[i].size < UDP_ZEROCOPY_MIN_SIZE || batch[i].spliced())
+      {
+        ++i;
+        continue;
+      }
+
+      // Everything queued before this run goes first, keeping per-destination order
+      if (unsent < i)
+      {
+        sent += worker.socket.send_batch(batch.data() + unsent, i - unsent).value_or(0);
+      }
+
+      // process_frame() queues the copies of a frame back to back
+      worker.tx_destinations.clear();
+      size_t end = i;
+      for (; end < batch.size() && batch[end].data == batch[i].data && batch[end].size == batch[i].size &&
+             !batch[end].spliced();
+           ++end)
+      {
+        worker.tx_destinations.push_back(batch[end].destination);
+      }
+      sent += worker.socket.send_to_many(batch[i].data, batch[i].size, worker.tx_destinations).value_or(0);
+      i = unsent = end;
+    }
+
+    if (unsent < batch.size())
+    {
+      sent += worker.socket.send_batch(batch.data() + unsent, batch.size() - unsent).value_or(0);
+    }
+
+    // The next burst is received into the same buffers, so none may be reused while the kernel still reads it
+    bool reported = false;
+    while (worker.socket.zerocopy_pending() > 0 && running_.load())
+    {
+      auto pending = worker.socket.reap_zerocopy(VSWITCH_STOP_POLL_INTERVAL);
+      if (pending && *pending == 0)
+      {
+        break;
+      }
+      if (!reported)
+      {
+        PROJECT_LOG_WARN("[VSwitch] Zero-copy sends still pending (%s); waiting for their buffers",
+                         pending ? "slow completions" : to_string(pending.error()));
+        reported = true;
+      }
+      if (!pending)
+      {
+        std::this_thread::sleep_for(VSWITCH_STOP_POLL_INTERVAL);  // The error queue failed at once; do not spin
+      }
+    }
+
+    return sent;
+  }
+
+  std::vector<TrafficStats> VSwitch::worker_stats() const
+  {
+    std::vector<TrafficStats> result;
+    result.reserve(workers_.size());
+    for (const auto& worker : workers_)
+    {
+      result.push_back(worker.counters.snapshot());
+    }
+    return result;
+  }
+
+  TrafficStats VSwitch::stats() const
+  {
+    TrafficStats total;
+    for (const auto& worker : workers_)
+    {
+      total += worker.counters.snapshot();
+    }
+    return total;
+  }
+
+  LatencySnapshot VSwitch::latency() const
+  {
+    LatencySnapshot total;
+#if PROJECT_LATENCY_HISTOGRAMS
+    for (const auto& worker : workers_)
+    {
+      total += worker.latency.snapshot();
+    }
+#endif
+    return total;
+  }
+
+  std::string VSwitch::stats_prometheus() const
+  {
+    std::vector<std::pair<std::string, TrafficStats>> series;
+    std::vector<TrafficStats> per_worker = worker_stats();
+    for (size_t i = 0; i < per_worker.size(); ++i)
+    {
+      series.emplace_back("worker=\"" + std::to_string(i) + "\"", per_worker[i]);
+    }
+
+    std::string out = format_prometheus("vswitch", series);
+    out += "# HELP vswitch_learned_macs MAC addresses currently in the table\n";
+    out += "# TYPE vswitch_learned_macs gauge\n";
+    out += "vswitch_learned_macs " + std::to_string(mac_table_.size()) + "\n";
+    out += "# HELP vswitch_multicast_groups Multicast groups with at least one subscribed port\n";
+    out += "# TYPE vswitch_multicast_groups gauge\n";
+    out += "vswitch_multicast_groups " + std::to_string(multicast_.group_count()) + "\n";
+
+#if PROJECT_LATENCY_HISTOGRAMS
+    std::vector<std::pair<std::string, LatencySnapshot>> latency_series;
+    for (size_t i = 0; i < workers_.size(); ++i)
     {
-      std::cout << " " << details;
+      latency_series.emplace_back(series[i].first, workers_[i].latency.snapshot());
     }
-    std::cout << "\n";
+    out += format_prometheus_latency("vswitch", latency_series);
+#endif
+    return out;
   }
 
 }  // namespace project
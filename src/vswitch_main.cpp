@@ -7,20 +7,50 @@
  * - Learns MAC addresses from incoming frames
  * - Forwards frames based on MAC table
  * - Handles broadcast frames
+ * - Sends multicast only where IGMP/MLD subscribed it
  * 
- * Usage: vswitch <port>
+ * Usage: vswitch <port> [--workers N] [--pin-cpus] [--io-uring] [--mac-aging SECONDS]
+ *               [--max-frame BYTES] [--zerocopy] [--packet-ring IFACE] [--access ADDR[:PORT]=VLAN]
+ *               [--trunk ADDR[:PORT]=VLANS[/NATIVE]] [--default-vlan VLAN]
+ *               [--unknown-unicast drop|flood] [--unknown-multicast drop|flood]
+ *               [--no-multicast-snooping] [--ingress-rate MBIT] [--ingress-burst KB]
+ *               [--priority-queues] [--mac-snapshot FILE] [--snapshot-interval SECONDS]
+ *               [--key-file FILE] [--cipher CIPHER] [--handoff SOCKET] [--peer IP:PORT]...
+ *               [--sync-interval MS] [--log-level LEVEL]
+ *
+ * Send SIGUSR1 to print the traffic counters in Prometheus text format.
+ *
+ * With --handoff, an upgrade is starting the new binary with the same
+ * arguments: it takes the sockets and MAC table over from the running
+ * process listening on SOCKET, which then exits, and listens there itself.
+ *
+ * With --peer, several VSwitch processes form one switch: each tells the
+ * others which MACs it learned behind its VPorts, every --sync-interval
+ * milliseconds, and frames for those MACs cross over to the node serving them.
  */
 
+#include "project/cluster.hpp"
+#include "project/logger.hpp"
+#include "project/socket_handoff.hpp"
 #include "project/vswitch.hpp"
 
+#include <atomic>
 #include <csignal>
 #include <cstdlib>
 #include <iostream>
+#include <cstring>
 #include <memory>
+#include <string>
+#include <thread>
+
+#include <unistd.h>
 
 // Global VSwitch pointer for signal handler
 std::unique_ptr<project::VSwitch> g_vswitch;
 
+// Set by SIGUSR1; the stats thread prints the counters and clears it
+volatile std::sig_atomic_t g_dump_stats = 0;
+
 /**
  * @brief Signal handler for graceful shutdown
  */
@@ -29,19 +59,27 @@ void signal_handler(int signal)
   std::cout << "\n[VSwitch] Received signal " << signal << ", shutting down...\n";
   if (g_vswitch)
   {
+    // start() returns once every worker has noticed the flag and been joined
     g_vswitch->stop();
-    g_vswitch.reset();
   }
-  std::exit(0);
 }
 
 /**
- * @brief Setup signal handlers for graceful shutdown
+ * @brief Signal handler requesting a stats dump
+ */
+void stats_signal_handler(int)
+{
+  g_dump_stats = 1;
+}
+
+/**
+ * @brief Setup signal handlers for graceful shutdown and stats dumps
  */
 void setup_signal_handlers()
 {
   std::signal(SIGINT, signal_handler);
   std::signal(SIGTERM, signal_handler);
+  std::signal(SIGUSR1, stats_signal_handler);
 }
 
 /**
@@ -49,20 +87,71 @@ void setup_signal_handlers()
  */
 void print_usage(const char* program_name)
 {
-  std::cerr << "Usage: " << program_name << " <port>\n";
+  std::cerr << "Usage: " << program_name
+            << " <port> [--workers N] [--pin-cpus] [--io-uring] [--mac-aging SECONDS] [--max-frame BYTES]\n"
+            << "       [--zerocopy] [--packet-ring IFACE] [--access ADDR[:PORT]=VLAN]\n"
+            << "       [--trunk ADDR[:PORT]=VLANS[/NATIVE]]\n"
+            << "       [--default-vlan VLAN] [--unknown-unicast drop|flood] [--unknown-multicast drop|flood]\n"
+            << "       [--no-multicast-snooping] [--ingress-rate MBIT] [--ingress-burst KB] [--priority-queues]\n"
+            << "       [--mac-snapshot FILE] [--snapshot-interval SECONDS] [--key-file FILE] [--cipher CIPHER]\n"
+            << "       [--handoff SOCKET] [--peer IP:PORT]... [--sync-interval MS] [--log-level LEVEL]\n";
   std::cerr << "\n";
   std::cerr << "Arguments:\n";
-  std::cerr << "  port     UDP port to listen on (0 for ephemeral)\n";
+  std::cerr << "  port           UDP port to listen on (0 for ephemeral)\n";
+  std::cerr << "\n";
+  std::cerr << "Options:\n";
+  std::cerr << "  --workers N    Forwarding threads sharing the port via SO_REUSEPORT (default 1)\n";
+  std::cerr << "  --pin-cpus     Pin worker i to CPU i\n";
+  std::cerr << "  --io-uring     Receive and send through io_uring (falls back to syscalls)\n";
+  std::cerr << "  --mac-aging S  Forget MACs not seen for S seconds (default 300, 0 disables)\n";
+  std::cerr << "  --max-frame B  Largest frame forwarded, e.g. 9216 for jumbo frames (default 2048)\n";
+  std::cerr << "  --zerocopy     Send frames of 8 KiB and more with MSG_ZEROCOPY\n";
+  std::cerr << "  --packet-ring I  Receive and send the IPv4 underlay through TPACKET_V3 rings on interface I\n";
+  std::cerr << "                   (needs CAP_NET_RAW; falls back to sockets)\n";
+  std::cerr << "  --access A=V   Make the VPort at address A (any port unless given) an access port in VLAN V\n";
+  std::cerr << "  --trunk A=L/N  Make it a trunk carrying VLANs L tagged (\"10,20-29\" or \"all\") and\n";
+  std::cerr << "                 native VLAN N untagged (optional; untagged frames are dropped without)\n";
+  std::cerr << "  --default-vlan V  VLAN of VPorts not configured with --access or --trunk (default 1)\n";
+  std::cerr << "  --unknown-unicast P    drop or flood frames to MACs not learned yet (default drop)\n";
+  std::cerr << "  --unknown-multicast P  drop or flood multicast no VPort subscribed to (default drop;\n";
+  std::cerr << "                         multicast routers, found by their queries, get it either way)\n";
+  std::cerr << "  --no-multicast-snooping  Ignore IGMP/MLD: all multicast follows --unknown-multicast\n";
+  std::cerr << "  --ingress-rate M   Drop what each VPort sends beyond M Mbit/s (default 0: unlimited)\n";
+  std::cerr << "  --ingress-burst K  Let a VPort send K KiB at once within its rate (default 64)\n";
+  std::cerr << "  --priority-queues  Send each batch by 802.1p/DSCP priority, interleaved by DRR\n";
+  std::cerr << "  --mac-snapshot F   Restore learned MACs from file F at startup and save them on exit\n";
+  std::cerr << "  --snapshot-interval S  Also save the MAC snapshot every S seconds (default 0: on exit only)\n";
+  std::cerr << "  --key-file F   Accept only VPorts encrypting with a key in file F, one \"ID HEX64\" per line\n";
+  std::cerr << "  --cipher C     aes-256-gcm (default) or chacha20-poly1305, as the VPorts use\n";
+  std::cerr << "  --handoff S    Take the port and MAC table over from the VSwitch listening on Unix socket S,\n";
+  std::cerr << "                 if any, then listen on S to hand them to the next one (live upgrade)\n";
+  std::cerr << "  --peer N       Another node of the same switch at IPv4 address N (\"IP:PORT\", repeatable;\n";
+  std::cerr << "                 every node lists all others, no --key-file)\n";
+  std::cerr << "  --sync-interval MS  Time between MAC updates to the peers (default "
+            << project::CLUSTER_DEFAULT_SYNC_INTERVAL.count() << ")\n";
+  std::cerr << "  --log-level L  trace, debug, info, warn, error or off (default info;\n";
+  std::cerr << "                 trace needs a build with -DProject_LOG_LEVEL=TRACE)\n";
   std::cerr << "\n";
   std::cerr << "Examples:\n";
   std::cerr << "  " << program_name << " 8080\n";
   std::cerr << "  " << program_name << " 0\n";
+  std::cerr << "  " << program_name << " 8080 --workers 4 --pin-cpus\n";
+  std::cerr << "  " << program_name << " 8080 --max-frame 9216 --zerocopy\n";
+  std::cerr << "  " << program_name << " 8080 --workers 4 --packet-ring eth0\n";
+  std::cerr << "  " << program_name << " 8080 --access 10.0.0.2=10 --access 10.0.0.3=20 --trunk 10.0.0.4=10,20\n";
+  std::cerr << "  " << program_name << " 8080 --ingress-rate 100 --priority-queues\n";
+  std::cerr << "  " << program_name << " 8080 --mac-snapshot /var/lib/vswitch/macs --snapshot-interval 60\n";
+  std::cerr << "  " << program_name << " 8080 --key-file /etc/vswitch/keys\n";
+  std::cerr << "  " << program_name << " 8080 --workers 4 --handoff /run/vswitch.sock\n";
+  std::cerr << "  " << program_name << " 8080 --peer 10.0.0.11:8080 --peer 10.0.0.12:8080\n";
   std::cerr << "\n";
   std::cerr << "The VSwitch will:\n";
   std::cerr << "  - Learn MAC addresses from incoming frames\n";
   std::cerr << "  - Forward unicast frames to known destinations\n";
   std::cerr << "  - Broadcast frames to all known endpoints (except source)\n";
   std::cerr << "  - Discard unknown unicast frames\n";
+  std::cerr << "  - Send multicast to the endpoints that joined its group with IGMP or MLD\n";
+  std::cerr << "  - With --access or --trunk, do all of that per VLAN\n";
 }
 
 int main(int argc, char* argv[])
@@ -70,7 +159,7 @@ int main(int argc, char* argv[])
   std::cout << "=== VSwitch - Virtual Switch for Layer 2 Networking ===\n\n";
 
   // Parse command-line arguments
-  if (argc != 2)
+  if (argc < 2)
   {
     print_usage(argv[0]);
     return EXIT_FAILURE;
@@ -89,10 +178,260 @@ int main(int argc, char* argv[])
     return EXIT_FAILURE;
   }
 
-  uint16_t port = static_cast<uint16_t>(port_long);
+  project::VSwitchConfig config;
+  config.port = static_cast<uint16_t>(port_long);
+  std::string handoff_path;
+
+  // Parse options
+  for (int i = 2; i < argc; ++i)
+  {
+    if (std::strcmp(argv[i], "--workers") == 0 && i + 1 < argc)
+    {
+      const char* workers_str = argv[++i];
+      long workers_long = std::strtol(workers_str, &endptr, 10);
+      if (*endptr != '\0' || workers_long < 1 || workers_long > 1024)
+      {
+        std::cerr << "Error: Invalid worker count '" << workers_str << "'\n";
+        return EXIT_FAILURE;
+      }
+      config.workers = static_cast<size_t>(workers_long);
+    }
+    else if (std::strcmp(argv[i], "--mac-aging") == 0 && i + 1 < argc)
+    {
+      const char* aging_str = argv[++i];
+      long aging_long = std::strtol(aging_str, &endptr, 10);
+      if (*endptr != '\0' || aging_long < 0)
+      {
+        std::cerr << "Error: Invalid MAC aging time '" << aging_str << "'\n";
+        return EXIT_FAILURE;
+      }
+      config.mac_aging_time = std::chrono::seconds(aging_long);
+    }
+    else if (std::strcmp(argv[i], "--max-frame") == 0 && i + 1 < argc)
+    {
+      const char* frame_str = argv[++i];
+      long frame_long = std::strtol(frame_str, &endptr, 10);
+      if (*endptr != '\0' || frame_long < static_cast<long>(project::FRAME_BUFFER_SIZE) ||
+          frame_long > static_cast<long>(project::VSWITCH_MAX_FRAME_SIZE))
+      {
+        std::cerr << "Error: Invalid maximum frame size '" << frame_str << "'\n";
+        return EXIT_FAILURE;
+      }
+      config.max_frame_size = static_cast<size_t>(frame_long);
+    }
+    else if ((std::strcmp(argv[i], "--access") == 0 || std::strcmp(argv[i], "--trunk") == 0) && i + 1 < argc)
+    {
+      auto mode = argv[i][2] == 'a' ? project::VlanMode::Access : project::VlanMode::Trunk;
+      const char* spec = argv[++i];
+      auto vlan_port = project::parse_vlan_port(mode, spec);
+      if (!vlan_port)
+      {
+        std::cerr << "Error: " << project::to_string(vlan_port.error()) << " '" << spec << "'\n";
+        return EXIT_FAILURE;
+      }
+      config.vlan_ports.push_back(std::move(*vlan_port));
+    }
+    else if (std::strcmp(argv[i], "--default-vlan") == 0 && i + 1 < argc)
+    {
+      const char* vlan_str = argv[++i];
+      auto vlan = project::parse_vlan_id(vlan_str);
+      if (!vlan)
+      {
+        std::cerr << "Error: Invalid VLAN ID '" << vlan_str << "'\n";
+        return EXIT_FAILURE;
+      }
+      config.default_vlan = *vlan;
+    }
+    else if ((std::strcmp(argv[i], "--unknown-unicast") == 0 || std::strcmp(argv[i], "--unknown-multicast") == 0) &&
+             i + 1 < argc)
+    {
+      bool unicast = argv[i][10] == 'u';
+      const char* policy_str = argv[++i];
+      auto policy = project::parse_flood_policy(policy_str);
+      if (!policy)
+      {
+        std::cerr << "Error: Invalid flood policy '" << policy_str << "' (drop or flood)\n";
+        return EXIT_FAILURE;
+      }
+      (unicast ? config.unknown_unicast : config.unknown_multicast) = *policy;
+    }
+    else if ((std::strcmp(argv[i], "--ingress-rate") == 0 || std::strcmp(argv[i], "--ingress-burst") == 0) &&
+             i + 1 < argc)
+    {
+      bool rate = argv[i][10] == 'r';
+      const char* value_str = argv[++i];
+      unsigned long long value = std::strtoull(value_str, &endptr, 10);
+      if (*endptr != '\0' || value_str[0] == '-' || value > (rate ? 1'000'000ULL : 1'048'576ULL) ||
+          (!rate && value == 0))
+      {
+        std::cerr << "Error: Invalid ingress " << (rate ? "rate" : "burst") << " '" << value_str << "'\n";
+        return EXIT_FAILURE;
+      }
+      if (rate)
+      {
+        config.ingress_rate = value * 1'000'000 / 8;  // Mbit/s to bytes/s
+      }
+      else
+      {
+        config.ingress_burst = value * 1024;
+      }
+    }
+    else if (std::strcmp(argv[i], "--mac-snapshot") == 0 && i + 1 < argc)
+    {
+      config.mac_snapshot_path = argv[++i];
+    }
+    else if (std::strcmp(argv[i], "--snapshot-interval") == 0 && i + 1 < argc)
+    {
+      const char* interval_str = argv[++i];
+      long interval_long = std::strtol(interval_str, &endptr, 10);
+      if (*endptr != '\0' || interval_long < 0)
+      {
+        std::cerr << "Error: Invalid snapshot interval '" << interval_str << "'\n";
+        return EXIT_FAILURE;
+      }
+      config.mac_snapshot_interval = std::chrono::seconds(interval_long);
+    }
+    else if (std::strcmp(argv[i], "--packet-ring") == 0 && i + 1 < argc)
+    {
+      config.packet_ring_interface = argv[++i];
+    }
+    else if (std::strcmp(argv[i], "--key-file") == 0 && i + 1 < argc)
+    {
+      const char* path = argv[++i];
+      auto keys = project::load_tunnel_keys(path);
+      if (!keys || keys->empty())
+      {
+        std::cerr << "Error: Key file '" << path << "': "
+                  << (keys ? "no keys" : project::to_string(keys.error())) << "\n";
+        return EXIT_FAILURE;
+      }
+      config.tunnel_keys = std::move(*keys);
+    }
+    else if (std::strcmp(argv[i], "--cipher") == 0 && i + 1 < argc)
+    {
+      const char* cipher_str = argv[++i];
+      auto cipher = project::parse_tunnel_cipher(cipher_str);
+      if (!cipher)
+      {
+        std::cerr << "Error: Invalid cipher '" << cipher_str << "'\n";
+        return EXIT_FAILURE;
+      }
+      config.tunnel_cipher = *cipher;
+    }
+    else if (std::strcmp(argv[i], "--handoff") == 0 && i + 1 < argc)
+    {
+      handoff_path = argv[++i];
+    }
+    else if (std::strcmp(argv[i], "--peer") == 0 && i + 1 < argc)
+    {
+      const char* peer_str = argv[++i];
+      auto peer = project::parse_cluster_node(peer_str);
+      if (!peer)
+      {
+        std::cerr << "Error: Peer '" << peer_str << "': " << project::to_string(peer.error()) << "\n";
+        return EXIT_FAILURE;
+      }
+      config.cluster_peers.push_back(*peer);
+    }
+    else if (std::strcmp(argv[i], "--sync-interval") == 0 && i + 1 < argc)
+    {
+      const char* interval_str = argv[++i];
+      long interval_long = std::strtol(interval_str, &endptr, 10);
+      if (*endptr != '\0' || interval_long < 1 || interval_long > 60'000)
+      {
+        std::cerr << "Error: Invalid sync interval '" << interval_str << "'\n";
+        return EXIT_FAILURE;
+      }
+      config.cluster_sync_interval = std::chrono::milliseconds(interval_long);
+    }
+    else if (std::strcmp(argv[i], "--log-level") == 0 && i + 1 < argc)
+    {
+      const char* level_str = argv[++i];
+      auto level = project::parse_log_level(level_str);
+      if (!level)
+      {
+        std::cerr << "Error: Invalid log level '" << level_str << "'\n";
+        return EXIT_FAILURE;
+      }
+      project::Logger::instance().set_level(*level);
+    }
+    else if (std::strcmp(argv[i], "--pin-cpus") == 0)
+    {
+      config.pin_cpus = true;
+    }
+    else if (std::strcmp(argv[i], "--io-uring") == 0)
+    {
+      config.io_backend = project::IoBackend::IoUring;
+    }
+    else if (std::strcmp(argv[i], "--zerocopy") == 0)
+    {
+      config.zerocopy = true;
+    }
+    else if (std::strcmp(argv[i], "--no-multicast-snooping") == 0)
+    {
+      config.multicast_snooping = false;
+    }
+    else if (std::strcmp(argv[i], "--priority-queues") == 0)
+    {
+      config.priority_queues = true;
+    }
+    else
+    {
+      print_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  uint16_t port = config.port;
 
   std::cout << "Configuration:\n";
   std::cout << "  Port: " << port << (port == 0 ? " (ephemeral)" : "") << "\n";
+  std::cout << "  Workers: " << config.workers << (config.pin_cpus ? " (pinned)" : "") << "\n";
+  std::cout << "  I/O: " << project::to_string(config.io_backend) << "\n";
+  std::cout << "  MAC aging: " << config.mac_aging_time.count() << "s\n";
+  std::cout << "  Max frame: " << config.max_frame_size << " bytes" << (config.zerocopy ? " (zero-copy)" : "") << "\n";
+  if (!config.packet_ring_interface.empty())
+  {
+    std::cout << "  Packet ring: " << config.packet_ring_interface << "\n";
+  }
+  if (!config.vlan_ports.empty())
+  {
+    std::cout << "  VLAN ports: " << config.vlan_ports.size() << " (others in VLAN " << config.default_vlan << ")\n";
+  }
+  std::cout << "  Multicast snooping: " << (config.multicast_snooping ? "on" : "off") << "\n";
+  std::cout << "  Unknown unicast: " << project::to_string(config.unknown_unicast)
+            << ", unknown multicast: " << project::to_string(config.unknown_multicast) << "\n";
+  if (config.ingress_rate > 0)
+  {
+    std::cout << "  Ingress rate: " << config.ingress_rate * 8 / 1'000'000 << " Mbit/s per VPort (burst "
+              << config.ingress_burst / 1024 << " KiB)\n";
+  }
+  if (!config.mac_snapshot_path.empty())
+  {
+    std::cout << "  MAC snapshot: " << config.mac_snapshot_path;
+    if (config.mac_snapshot_interval.count() > 0)
+    {
+      std::cout << " (every " << config.mac_snapshot_interval.count() << "s)";
+    }
+    std::cout << "\n";
+  }
+  if (config.priority_queues)
+  {
+    std::cout << "  Priority queues: " << project::QOS_CLASS_COUNT << " classes\n";
+  }
+  if (!config.tunnel_keys.empty())
+  {
+    std::cout << "  Encryption: " << project::to_string(config.tunnel_cipher) << ", " << config.tunnel_keys.size()
+              << " VPort key(s)\n";
+  }
+  if (!handoff_path.empty())
+  {
+    std::cout << "  Handoff socket: " << handoff_path << "\n";
+  }
+  for (const auto& peer : config.cluster_peers)
+  {
+    std::cout << "  Cluster peer: " << peer << " (updates every " << config.cluster_sync_interval.count() << " ms)\n";
+  }
   std::cout << "\n";
 
   try
@@ -100,9 +439,20 @@ int main(int argc, char* argv[])
     // Setup signal handlers for graceful shutdown
     setup_signal_handlers();
 
-    // Create VSwitch instance
-    std::cout << "Creating VSwitch...\n";
-    auto vswitch_result = project::VSwitch::create(port);
+    // Take over from a running VSwitch if one listens on the handoff socket, else create one
+    project::SocketHandle predecessor;
+    if (!handoff_path.empty())
+    {
+      if (auto channel = project::connect_handoff(handoff_path))
+      {
+        predecessor = std::move(*channel);
+      }
+    }
+
+    std::cout << (predecessor ? "Taking over from the running VSwitch...\n" : "Creating VSwitch...\n");
+    auto vswitch_result =
+        predecessor ? project::VSwitch::take_over(config, predecessor.get()) : project::VSwitch::create(config);
+    predecessor.close();
 
     if (!vswitch_result)
     {
@@ -124,9 +474,67 @@ int main(int argc, char* argv[])
     std::cout << "  Port: " << g_vswitch->port() << "\n";
     std::cout << "\n";
 
+    // Listen for a successor; a failure here only rules out the next live upgrade
+    project::HandoffListener listener;
+    if (!handoff_path.empty())
+    {
+      auto listener_result = project::HandoffListener::create(handoff_path);
+      if (listener_result)
+      {
+        listener = std::move(*listener_result);
+      }
+      else
+      {
+        std::cerr << "Warning: " << handoff_path << ": " << project::to_string(listener_result.error()) << "\n";
+      }
+    }
+
+    // Print the counters whenever SIGUSR1 arrives; the workers never see this
+    std::atomic<bool> done{ false };
+    project::joining_thread stats_thread([&done]() {
+      while (!done.load())
+      {
+        std::this_thread::sleep_for(project::VSWITCH_STOP_POLL_INTERVAL);
+        if (g_dump_stats != 0)
+        {
+          g_dump_stats = 0;
+          std::cout << g_vswitch->stats_prometheus() << std::flush;
+        }
+      }
+    });
+
+    // A successor that takes the sockets over ends start() like a signal would
+    project::joining_thread handoff_thread;
+    if (listener.is_valid())
+    {
+      handoff_thread = project::joining_thread([&done, &listener]() {
+        while (!done.load())
+        {
+          auto channel = listener.accept(project::VSWITCH_STOP_POLL_INTERVAL);
+          if (!channel)
+          {
+            if (channel.error() != project::HandoffError::Timeout)
+            {
+              std::cerr << "Warning: Handoff: " << project::to_string(channel.error()) << "\n";
+            }
+            continue;
+          }
+
+          auto handed = g_vswitch->hand_over(channel->get());
+          if (handed)
+          {
+            return;
+          }
+          std::cerr << "Warning: Handoff failed, still running: " << project::to_string(handed.error()) << "\n";
+        }
+      });
+    }
+
     // Start processing
     std::cout << "Starting frame processing...\n";
+    std::cout << "Send SIGUSR1 (kill -USR1 " << ::getpid() << ") to print traffic counters.\n";
     auto start_result = g_vswitch->start();
+    done.store(true);
 
     if (!start_result)
     {
@@ -0,0 +1,150 @@
+/**
+ * @file cluster_test.cpp
+ * @brief Unit tests for MAC updates between VSwitch nodes and VPort failover
+ */
+
+#include "project/cluster.hpp"
+#include "project/vlan.hpp"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using namespace project;
+
+namespace
+{
+  LearnedMac owned_mac(uint16_t vlan, uint64_t mac)
+  {
+    LearnedMac entry;
+    entry.vlan = vlan;
+    entry.mac = MacAddress::from_u64(mac);
+    entry.endpoint = Endpoint("127.0.0.1", 4000);
+    return entry;
+  }
+}  // namespace
+
+TEST(ClusterTest, EncodesAndDecodesUpdates)
+{
+  EXPECT_TRUE(encode_mac_updates({}).empty());
+
+  std::vector<MacUpdate> updates;
+  for (uint64_t i = 0; i < CLUSTER_MAX_RECORDS + 3; ++i)
+  {
+    updates.push_back({ i % 2 == 0 ? MacUpdateKind::Learn : MacUpdateKind::Withdraw, static_cast<uint16_t>(i),
+                        MacAddress::from_u64(0x020000000000 + i) });
+  }
+  auto datagrams = encode_mac_updates(updates);
+  ASSERT_EQ(datagrams.size(), 2u);
+  EXPECT_EQ(datagrams[0].size(), CLUSTER_HEADER_SIZE + CLUSTER_MAX_RECORDS * CLUSTER_RECORD_SIZE);
+  EXPECT_LE(datagrams[0].size(), CLUSTER_MAX_DATAGRAM_SIZE);
+
+  // To the classifier an update is a unicast frame to and from nobody
+  const uint8_t* frames[] = { datagrams[1].data() };
+  const size_t sizes[] = { datagrams[1].size() };
+  FrameKeys keys;
+  classify_frames(frames, sizes, 1, &keys);
+  EXPECT_TRUE(is_cluster_update(keys));
+
+  std::vector<MacUpdate> decoded;
+  auto count = decode_mac_updates(datagrams[1].data(), datagrams[1].size(), decoded);
+  ASSERT_TRUE(count.has_value());
+  ASSERT_EQ(*count, 3u);
+  const MacUpdate& last = decoded.back();
+  EXPECT_EQ(last.kind, updates.back().kind);
+  EXPECT_EQ(last.vlan, updates.back().vlan);
+  EXPECT_EQ(last.mac, updates.back().mac);
+
+  // A record of an unknown kind is skipped; a cut record or another format is rejected
+  std::vector<uint8_t> unknown = datagrams[1];
+  unknown[CLUSTER_HEADER_SIZE] = 7;
+  EXPECT_EQ(decode_mac_updates(unknown.data(), unknown.size(), decoded).value_or(0), 2u);
+  EXPECT_EQ(decode_mac_updates(unknown.data(), unknown.size() - 1, decoded).error(), ClusterError::Malformed);
+  unknown[13] = 0xb5;
+  EXPECT_EQ(decode_mac_updates(unknown.data(), unknown.size(), decoded).error(), ClusterError::NotAnUpdate);
+}
+
+TEST(ClusterTest, SkipsRecordsForVlansOutOfRange)
+{
+  const MacAddress mac = MacAddress::from_u64(0x0200000000b1);
+  std::vector<MacUpdate> updates;
+  for (uint16_t vlan : { uint16_t{ 0 }, VLAN_MAX_ID, uint16_t{ 4095 }, uint16_t{ 4097 }, uint16_t{ 0xffff } })
+  {
+    updates.push_back({ MacUpdateKind::Learn, vlan, mac });
+  }
+  auto datagrams = encode_mac_updates(updates);
+  ASSERT_EQ(datagrams.size(), 1u);
+
+  // Masked to 12 bits, 4097 and 0xffff would otherwise be learned on VLANs 1 and 4095
+  std::vector<MacUpdate> decoded;
+  auto count = decode_mac_updates(datagrams[0].data(), datagrams[0].size(), decoded);
+  ASSERT_TRUE(count.has_value());
+  ASSERT_EQ(*count, 2u);
+  EXPECT_EQ(decoded[0].vlan, 0);
+  EXPECT_EQ(decoded[1].vlan, VLAN_MAX_ID);
+}
+
+TEST(ClusterTest, TracksWhatChanged)
+{
+  MacSyncTracker tracker;
+  auto first = tracker.changes({ owned_mac(0, 0x0200000000a1), owned_mac(10, 0x0200000000a2) }, false);
+  ASSERT_EQ(first.size(), 2u);
+  EXPECT_EQ(first[0].kind, MacUpdateKind::Learn);
+  EXPECT_EQ(tracker.announced(), 2u);
+
+  // Nothing new, nothing to say; one gone and one new
+  EXPECT_TRUE(tracker.changes({ owned_mac(0, 0x0200000000a1), owned_mac(10, 0x0200000000a2) }, false).empty());
+  auto second = tracker.changes({ owned_mac(0, 0x0200000000a1), owned_mac(0, 0x0200000000a3) }, false);
+  ASSERT_EQ(second.size(), 2u);
+  EXPECT_EQ(second[0].kind, MacUpdateKind::Learn);
+  EXPECT_EQ(second[0].mac, MacAddress::from_u64(0x0200000000a3));
+  EXPECT_EQ(second[1].kind, MacUpdateKind::Withdraw);
+  EXPECT_EQ(second[1].vlan, 10);
+  EXPECT_EQ(second[1].mac, MacAddress::from_u64(0x0200000000a2));
+
+  // A refresh repeats everything
+  EXPECT_EQ(tracker.changes({ owned_mac(0, 0x0200000000a1), owned_mac(0, 0x0200000000a3) }, true).size(), 2u);
+  EXPECT_EQ(tracker.changes({}, false).size(), 2u);
+  EXPECT_EQ(tracker.announced(), 0u);
+}
+
+TEST(ClusterTest, ParsesNodeAddresses)
+{
+  auto v4 = parse_cluster_node("10.0.0.2:8080");
+  ASSERT_TRUE(v4.has_value());
+  EXPECT_EQ(*v4, Endpoint("10.0.0.2", 8080));
+
+  // The sockets are IPv4, so an IPv6 node could never be reached
+  for (const char* bad : { "10.0.0.2", "10.0.0.2:0", "10.0.0.2:x", "::1:9000", "[::1]:9000", "host:80", ":80" })
+  {
+    EXPECT_EQ(parse_cluster_node(bad).error(), ClusterError::InvalidNode) << bad;
+  }
+}
+
+TEST(ClusterTest, FailsOverAfterSilence)
+{
+  const uint64_t ms = 1'000'000;
+  VSwitchFailover single({ Endpoint("127.0.0.1", 1) }, std::chrono::milliseconds(10));
+  EXPECT_FALSE(single.poll(1 * ms));
+  EXPECT_FALSE(single.poll(100 * ms));
+
+  VSwitchFailover failover({ Endpoint("127.0.0.1", 1), Endpoint("127.0.0.1", 2) }, std::chrono::milliseconds(10));
+  EXPECT_EQ(failover.active().port(), 1);
+  EXPECT_FALSE(failover.poll(1 * ms));  // Starts the clock
+  EXPECT_FALSE(failover.poll(5 * ms));
+  failover.heard(8 * ms);
+  EXPECT_FALSE(failover.poll(15 * ms));
+
+  EXPECT_TRUE(failover.poll(19 * ms));
+  EXPECT_EQ(failover.active().port(), 2);
+  EXPECT_FALSE(failover.poll(25 * ms));  // The new node gets a full timeout
+
+  EXPECT_TRUE(failover.poll(30 * ms));
+  EXPECT_EQ(failover.active().port(), 1);  // And round again
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
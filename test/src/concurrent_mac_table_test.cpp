@@ -0,0 +1,379 @@
+/**
+ * @file concurrent_mac_table_test.cpp
+ * @brief Unit tests for the lock-free-read MAC table
+ */
+
+#include "project/concurrent_mac_table.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace project;
+
+namespace
+{
+  MacAddress make_mac(uint32_t n)
+  {
+    return MacAddress({ 0x02, 0x00, static_cast<uint8_t>(n >> 24), static_cast<uint8_t>(n >> 16),
+                        static_cast<uint8_t>(n >> 8), static_cast<uint8_t>(n) });
+  }
+
+  Endpoint make_endpoint(uint32_t n)
+  {
+    return Endpoint("10.0.0.1", static_cast<uint16_t>(1000 + n % 60000));
+  }
+}  // namespace
+
+TEST(ConcurrentMacTableTest, DefaultConstruction)
+{
+  ConcurrentMacTable table;
+  EXPECT_TRUE(table.empty());
+  EXPECT_EQ(table.size(), 0);
+  EXPECT_EQ(table.capacity(), CONCURRENT_MAC_TABLE_INITIAL_CAPACITY);
+}
+
+TEST(ConcurrentMacTableTest, InsertLookupUpdate)
+{
+  ConcurrentMacTable table;
+  MacAddress mac({ 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 });
+  Endpoint ep1("192.168.1.100", 8080);
+  Endpoint ep2("192.168.1.101", 8080);
+
+  EXPECT_TRUE(table.insert(mac, ep1));
+  EXPECT_FALSE(table.insert(mac, ep1));  // Unchanged
+  EXPECT_EQ(table.size(), 1);
+
+  auto result = table.lookup(mac);
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(*result, ep1);
+
+  EXPECT_FALSE(table.insert(mac, ep2));  // Station moved
+  EXPECT_EQ(table.size(), 1);
+  EXPECT_EQ(*table.lookup(mac), ep2);
+
+  EXPECT_FALSE(table.contains(MacAddress({ 0x00, 0x11, 0x22, 0x33, 0x44, 0x56 })));
+}
+
+TEST(ConcurrentMacTableTest, VlansAreSeparateAddressSpaces)
+{
+  ConcurrentMacTable table;
+  MacAddress mac({ 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 });
+  Endpoint ep10("192.168.1.10", 8080);
+  Endpoint ep20("192.168.1.20", 8080);
+
+  // The same station behind different ports in two VLANs
+  EXPECT_TRUE(table.insert(10, mac, ep10));
+  EXPECT_TRUE(table.insert(20, mac, ep20));
+  EXPECT_EQ(table.size(), 2);
+  EXPECT_EQ(*table.lookup(10, mac), ep10);
+  EXPECT_EQ(*table.lookup(20, mac), ep20);
+  EXPECT_FALSE(table.lookup(30, mac).has_value());
+  EXPECT_FALSE(table.lookup(mac).has_value());  // VLAN 0 is the VLAN-less space
+
+  EXPECT_TRUE(table.remove(10, mac));
+  EXPECT_FALSE(table.lookup(10, mac).has_value());
+  EXPECT_EQ(*table.lookup(20, mac), ep20);
+  EXPECT_EQ(table.get_all_entries().at(mac), ep20);
+}
+
+TEST(ConcurrentMacTableTest, LearnedListsVlanAndAge)
+{
+  ConcurrentMacTable table;
+  MacAddress mac({ 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 });
+  Endpoint ep("192.168.1.10", 8080);
+  table.insert(4094, mac, ep, 1234);
+
+  auto learned = table.learned();
+  ASSERT_EQ(learned.size(), 1u);
+  EXPECT_EQ(learned[0].vlan, 4094);
+  EXPECT_EQ(learned[0].mac, mac);
+  EXPECT_EQ(learned[0].endpoint, ep);
+  EXPECT_EQ(learned[0].last_seen, 1234u);
+}
+
+TEST(ConcurrentMacTableTest, GrowsAndKeepsEntries)
+{
+  ConcurrentMacTable table(8);
+  constexpr uint32_t COUNT = 1000;
+
+  for (uint32_t i = 0; i < COUNT; ++i)
+  {
+    EXPECT_TRUE(table.insert(make_mac(i), make_endpoint(i)));
+  }
+
+  EXPECT_EQ(table.size(), COUNT);
+  EXPECT_GE(table.capacity() * 3, COUNT * 4);
+
+  for (uint32_t i = 0; i < COUNT; ++i)
+  {
+    auto result = table.lookup(make_mac(i));
+    ASSERT_TRUE(result.has_value()) << i;
+    EXPECT_EQ(*result, make_endpoint(i));
+  }
+}
+
+TEST(ConcurrentMacTableTest, RemoveKeepsProbeChainsIntact)
+{
+  // Small table so probe runs are long and wrap around
+  ConcurrentMacTable table(64);
+  constexpr uint32_t COUNT = 40;
+
+  for (uint32_t i = 0; i < COUNT; ++i)
+  {
+    table.insert(make_mac(i), make_endpoint(i));
+  }
+
+  for (uint32_t i = 0; i < COUNT; i += 2)
+  {
+    EXPECT_TRUE(table.remove(make_mac(i)));
+  }
+  EXPECT_FALSE(table.remove(make_mac(0)));
+  EXPECT_EQ(table.size(), COUNT / 2);
+
+  for (uint32_t i = 0; i < COUNT; ++i)
+  {
+    EXPECT_EQ(table.contains(make_mac(i)), i % 2 == 1) << i;
+  }
+}
+
+TEST(ConcurrentMacTableTest, GetAllEndpoints)
+{
+  ConcurrentMacTable table;
+  MacAddress mac1({ 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 });
+  MacAddress mac2({ 0x00, 0x11, 0x22, 0x33, 0x44, 0x66 });
+  Endpoint ep1("192.168.1.1", 8080);
+  Endpoint ep2("192.168.1.2", 8080);
+
+  table.insert(mac1, ep1);
+  table.insert(mac2, ep2);
+
+  EXPECT_EQ(table.get_all_endpoints().size(), 2);
+
+  auto except = table.get_all_endpoints_except(mac1);
+  ASSERT_EQ(except.size(), 1);
+  EXPECT_EQ(except[0], ep2);
+
+  auto entries = table.get_all_entries();
+  ASSERT_EQ(entries.size(), 2);
+  EXPECT_EQ(entries.at(mac1), ep1);
+  EXPECT_EQ(entries.at(mac2), ep2);
+}
+
+TEST(ConcurrentMacTableTest, ClearAndMove)
+{
+  ConcurrentMacTable table;
+  MacAddress mac({ 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 });
+  table.insert(mac, Endpoint("192.168.1.1", 8080));
+
+  ConcurrentMacTable moved(std::move(table));
+  EXPECT_TRUE(moved.contains(mac));
+  EXPECT_TRUE(table.empty());
+  EXPECT_FALSE(table.contains(mac));
+
+  // A moved-from table is usable again
+  EXPECT_TRUE(table.insert(mac, Endpoint("192.168.1.2", 8080)));
+
+  moved.clear();
+  EXPECT_TRUE(moved.empty());
+  EXPECT_FALSE(moved.contains(mac));
+}
+
+TEST(ConcurrentMacTableTest, ExpireEvictsStaleEntries)
+{
+  ConcurrentMacTable table(16);
+  constexpr std::chrono::seconds AGING{ 300 };
+
+  for (uint32_t i = 0; i < 20; ++i)
+  {
+    table.insert(make_mac(i), make_endpoint(i), 1000);
+  }
+
+  // Refreshing on the fast path (same endpoint) keeps half of them alive
+  for (uint32_t i = 0; i < 20; i += 2)
+  {
+    EXPECT_FALSE(table.insert(make_mac(i), make_endpoint(i), 1250));
+  }
+
+  EXPECT_EQ(table.expire(AGING, 1300), 0);  // Nothing older than 300s yet
+  EXPECT_EQ(table.expire(AGING, 1400), 10);
+  EXPECT_EQ(table.size(), 10);
+
+  for (uint32_t i = 0; i < 20; ++i)
+  {
+    EXPECT_EQ(table.contains(make_mac(i)), i % 2 == 0) << i;
+  }
+
+  EXPECT_EQ(table.expire(AGING, 1600), 10);
+  EXPECT_TRUE(table.empty());
+}
+
+TEST(ConcurrentMacTableTest, ExpireHandlesTimestampWrap)
+{
+  ConcurrentMacTable table;
+  MacAddress mac({ 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 });
+  table.insert(mac, Endpoint("192.168.1.1", 8080), 0xfffffff0u);
+
+  EXPECT_EQ(table.expire(std::chrono::seconds(300), 0x00000010u), 0);
+  EXPECT_EQ(table.expire(std::chrono::seconds(300), 0x00000200u), 1);
+}
+
+TEST(ConcurrentMacTableTest, FloodListIsDeduplicated)
+{
+  ConcurrentMacTable table;
+  Endpoint port_a("10.0.0.1", 5000);
+  Endpoint port_b("10.0.0.2", 5000);
+  constexpr MacTimestamp NOW = 900;
+
+  uint64_t generation = 0;
+  EXPECT_TRUE(table.flood_endpoints(generation).empty());
+
+  // Three MACs behind port A, one behind port B
+  table.insert(make_mac(1), port_a, NOW);
+  table.insert(make_mac(2), port_a, NOW);
+  table.insert(make_mac(3), port_a, NOW);
+  table.insert(make_mac(4), port_b, NOW);
+
+  auto flood = table.flood_endpoints(generation);
+  ASSERT_EQ(flood.size(), 2);
+  EXPECT_NE(std::find(flood.begin(), flood.end(), port_a), flood.end());
+  EXPECT_NE(std::find(flood.begin(), flood.end(), port_b), flood.end());
+  EXPECT_EQ(generation, table.flood_generation());
+
+  // More MACs behind a known port, refreshes and partial removals leave the list alone
+  table.insert(make_mac(5), port_a, NOW);
+  table.insert(make_mac(1), port_a, NOW);
+  table.remove(make_mac(2));
+  EXPECT_EQ(table.flood_generation(), generation);
+
+  // Moving the only MAC of port B away removes B
+  table.insert(make_mac(4), port_a, NOW);
+  EXPECT_NE(table.flood_generation(), generation);
+  flood = table.flood_endpoints(generation);
+  ASSERT_EQ(flood.size(), 1);
+  EXPECT_EQ(flood[0], port_a);
+
+  // Expiry and clear keep the list in sync
+  table.insert(make_mac(6), port_b, 0);
+  EXPECT_EQ(table.flood_endpoints(generation).size(), 2);
+  table.expire(std::chrono::seconds(300), 1000);
+  EXPECT_EQ(table.flood_endpoints(generation).size(), 1);
+
+  table.clear();
+  EXPECT_TRUE(table.flood_endpoints(generation).empty());
+}
+
+TEST(ConcurrentMacTableTest, GenerationMovesOnlyWhenMappingsChange)
+{
+  ConcurrentMacTable table(8);
+  Endpoint port_a("10.0.0.1", 5000);
+  Endpoint port_b("10.0.0.2", 5000);
+  constexpr MacTimestamp NOW = 900;
+
+  uint64_t generation = table.generation();
+  table.insert(make_mac(1), port_a, NOW);
+  EXPECT_NE(table.generation(), generation);
+
+  // Refreshing an age, growing the table or missing a removal leaves it alone
+  generation = table.generation();
+  table.insert(make_mac(1), port_a, NOW + 1);
+  EXPECT_FALSE(table.remove(make_mac(2)));
+  EXPECT_EQ(table.generation(), generation);
+  for (uint32_t i = 2; i < 16; ++i)
+  {
+    table.insert(make_mac(i), port_a, NOW);
+  }
+  generation = table.generation();
+  table.insert(make_mac(1), port_a, NOW + 2);
+  EXPECT_EQ(table.generation(), generation);
+
+  // A move, a removal, an expiry and a clear each move it
+  table.insert(make_mac(1), port_b, NOW);
+  EXPECT_NE(table.generation(), generation);
+  generation = table.generation();
+  EXPECT_TRUE(table.remove(make_mac(2)));
+  EXPECT_NE(table.generation(), generation);
+  generation = table.generation();
+  EXPECT_GT(table.expire(std::chrono::seconds(300), NOW + 1000), 0u);
+  EXPECT_NE(table.generation(), generation);
+  generation = table.generation();
+  table.insert(make_mac(1), port_b, NOW);
+  table.clear();
+  EXPECT_NE(table.generation(), generation);
+
+  // Moving keeps the generation with the entries and moves the one left behind
+  table.insert(make_mac(1), port_a, NOW);
+  generation = table.generation();
+  ConcurrentMacTable moved(std::move(table));
+  EXPECT_EQ(moved.generation(), generation);
+  EXPECT_NE(table.generation(), generation);
+  ConcurrentMacTable assigned;
+  assigned = std::move(moved);
+  EXPECT_GT(assigned.generation(), generation);
+}
+
+TEST(ConcurrentMacTableTest, ConcurrentReadersSeeStableEntries)
+{
+  ConcurrentMacTable table(16);
+  constexpr uint32_t STABLE = 64;
+  for (uint32_t i = 0; i < STABLE; ++i)
+  {
+    table.insert(make_mac(i), make_endpoint(i));
+  }
+
+  std::atomic<bool> done{ false };
+  std::atomic<size_t> failures{ 0 };
+
+  std::vector<std::thread> readers;
+  for (int r = 0; r < 3; ++r)
+  {
+    readers.emplace_back(
+        [&]()
+        {
+          while (!done.load())
+          {
+            for (uint32_t i = 0; i < STABLE; ++i)
+            {
+              auto result = table.lookup(make_mac(i));
+              if (!result || *result != make_endpoint(i))
+              {
+                failures.fetch_add(1);
+              }
+            }
+          }
+        });
+  }
+
+  // Churn other entries: growth, updates and backward-shift removals
+  for (uint32_t round = 0; round < 20; ++round)
+  {
+    for (uint32_t i = STABLE; i < STABLE + 500; ++i)
+    {
+      table.insert(make_mac(i), make_endpoint(i + round));
+    }
+    for (uint32_t i = STABLE; i < STABLE + 500; ++i)
+    {
+      table.remove(make_mac(i));
+    }
+  }
+
+  done.store(true);
+  for (auto& reader : readers)
+  {
+    reader.join();
+  }
+
+  EXPECT_EQ(failures.load(), 0);
+  EXPECT_EQ(table.size(), STABLE);
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -124,6 +124,14 @@ TEST(MacAddressTest, IsBroadcast)
   EXPECT_FALSE(almost_broadcast.is_broadcast());
 }
 
+TEST(MacAddressTest, PackedRoundTrip)
+{
+  MacAddress mac({0x00, 0x11, 0x22, 0x33, 0x44, 0x55});
+  EXPECT_EQ(mac.to_u64(), 0x001122334455ULL);
+  EXPECT_EQ(MacAddress::from_u64(mac.to_u64()), mac);
+  EXPECT_EQ(MacAddress::from_u64(0xffff001122334455ULL), mac);  // High bits ignored
+}
+
 TEST(MacAddressTest, DataPointer)
 {
   MacAddress mac({0x00, 0x11, 0x22, 0x33, 0x44, 0x55});
@@ -312,6 +320,91 @@ TEST(EthernetFrameTest, EmptyPayload)
   EXPECT_EQ(serialized.size(), ETHERNET_HEADER_SIZE);
 }
 
+// ============================================================================
+// EthernetFrameView Tests
+// ============================================================================
+
+TEST(EthernetFrameViewTest, DefaultIsInvalid)
+{
+  EthernetFrameView view;
+  EXPECT_FALSE(view.is_valid());
+  EXPECT_EQ(view.size(), 0);
+}
+
+TEST(EthernetFrameViewTest, TooShort)
+{
+  uint8_t data[ETHERNET_HEADER_SIZE - 1] = {};
+  EthernetFrameView view(data, sizeof(data));
+  EXPECT_FALSE(view.is_valid());
+}
+
+TEST(EthernetFrameViewTest, UntaggedHeader)
+{
+  MacAddress dst({0x00, 0x11, 0x22, 0x33, 0x44, 0x55});
+  MacAddress src({0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff});
+  std::vector<uint8_t> payload = {0x01, 0x02, 0x03};
+  std::vector<uint8_t> data = EthernetFrame(dst, src, EtherType::IPv4, payload).serialize();
+
+  EthernetFrameView view(data);
+  ASSERT_TRUE(view.is_valid());
+  EXPECT_EQ(view.data(), data.data());  // No copy
+  EXPECT_EQ(view.dst_mac(), dst);
+  EXPECT_EQ(view.src_mac(), src);
+  EXPECT_EQ(view.ethertype(), EtherType::IPv4);
+  EXPECT_FALSE(view.has_vlan_tag());
+  EXPECT_EQ(view.vlan_id(), 0);
+  EXPECT_EQ(view.header_size(), ETHERNET_HEADER_SIZE);
+  EXPECT_EQ(view.payload_size(), payload.size());
+  EXPECT_EQ(view.payload()[0], 0x01);
+  EXPECT_FALSE(view.is_broadcast());
+  EXPECT_FALSE(view.is_multicast());
+}
+
+TEST(EthernetFrameViewTest, VlanTaggedHeader)
+{
+  // dst, src, TPID 0x8100, TCI (PCP 5, VID 100), EtherType ARP, payload
+  uint16_t tci = static_cast<uint16_t>((5 << 13) | 100);
+  std::vector<uint8_t> data = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x02, 0x00, 0x00, 0x00, 0x00, 0x01,
+                               0x81, 0x00, static_cast<uint8_t>(tci >> 8), static_cast<uint8_t>(tci & 0xff),
+                               0x08, 0x06, 0xde, 0xad};
+
+  EthernetFrameView view(data);
+  ASSERT_TRUE(view.is_valid());
+  EXPECT_TRUE(view.has_vlan_tag());
+  EXPECT_EQ(view.vlan_id(), 100);
+  EXPECT_EQ(view.priority(), 5);
+  EXPECT_EQ(view.ethertype(), EtherType::ARP);
+  EXPECT_EQ(view.header_size(), ETHERNET_HEADER_SIZE + VLAN_TAG_SIZE);
+  EXPECT_EQ(view.payload_size(), 2);
+  EXPECT_EQ(view.payload()[0], 0xde);
+  EXPECT_TRUE(view.is_broadcast());
+  EXPECT_TRUE(view.is_multicast());
+}
+
+TEST(EthernetFrameViewTest, MulticastIsNotBroadcast)
+{
+  MacAddress dst({0x01, 0x00, 0x5e, 0x00, 0x00, 0xfb});
+  MacAddress src({0x02, 0x00, 0x00, 0x00, 0x00, 0x01});
+  std::vector<uint8_t> data = EthernetFrame(dst, src, EtherType::IPv4).serialize();
+
+  EthernetFrameView view(data);
+  EXPECT_TRUE(view.is_multicast());
+  EXPECT_FALSE(view.is_broadcast());
+}
+
+TEST(EthernetFrameViewTest, ToFrameCopies)
+{
+  MacAddress dst({0x00, 0x11, 0x22, 0x33, 0x44, 0x55});
+  MacAddress src({0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff});
+  std::vector<uint8_t> data = EthernetFrame(dst, src, EtherType::IPv6, { 0x42 }).serialize();
+
+  EthernetFrame frame = EthernetFrameView(data).to_frame();
+  EXPECT_EQ(frame.dst_mac(), dst);
+  EXPECT_EQ(frame.src_mac(), src);
+  EXPECT_EQ(frame.ethertype(), EtherType::IPv6);
+  EXPECT_EQ(frame.payload(), std::vector<uint8_t>{ 0x42 });
+}
+
 int main(int argc, char** argv)
 {
   ::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,180 @@
+/**
+ * @file event_loop_test.cpp
+ * @brief Unit tests for the epoll event loop
+ */
+
+#include "project/event_loop.hpp"
+#include "project/udp_socket.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+using namespace project;
+
+namespace
+{
+  /**
+   * @brief A non-blocking socket bound to an ephemeral loopback port
+   */
+  UdpSocket make_socket()
+  {
+    auto socket = UdpSocket::create();
+    EXPECT_TRUE(socket.has_value());
+    EXPECT_TRUE(socket->bind("127.0.0.1", 0));
+    EXPECT_TRUE(socket->set_nonblocking(true));
+    return std::move(*socket);
+  }
+
+  void send_one(UdpSocket& receiver)
+  {
+    auto sender = UdpSocket::create();
+    ASSERT_TRUE(sender.has_value());
+    auto endpoint = receiver.bound_endpoint();
+    ASSERT_TRUE(endpoint.has_value());
+    ASSERT_TRUE(sender->send_to(std::vector<uint8_t>{ 1, 2, 3 }, *endpoint));
+  }
+}  // namespace
+
+TEST(EventLoopTest, Create)
+{
+  auto loop = EventLoop::create();
+  ASSERT_TRUE(loop.has_value());
+  EXPECT_TRUE(loop->is_valid());
+  EXPECT_EQ(loop->size(), 0u);
+}
+
+TEST(EventLoopTest, TimesOutWithNothingReady)
+{
+  auto loop = EventLoop::create();
+  ASSERT_TRUE(loop.has_value());
+
+  auto dispatched = loop->run_once(std::chrono::milliseconds(10));
+  ASSERT_TRUE(dispatched.has_value());
+  EXPECT_EQ(*dispatched, 0u);
+}
+
+TEST(EventLoopTest, DispatchesReadableDescriptor)
+{
+  auto loop = EventLoop::create();
+  ASSERT_TRUE(loop.has_value());
+  UdpSocket socket = make_socket();
+
+  int calls = 0;
+  size_t bytes = 0;
+  ASSERT_TRUE(loop->add(socket.get_fd(), EPOLLIN, [&](uint32_t events) {
+    EXPECT_NE(events & EPOLLIN, 0u);
+    ++calls;
+    auto datagram = socket.receive_from();
+    if (datagram)
+    {
+      bytes += datagram->first.size();
+    }
+  }));
+  EXPECT_EQ(loop->size(), 1u);
+
+  send_one(socket);
+  auto dispatched = loop->run_once(std::chrono::milliseconds(1000));
+  ASSERT_TRUE(dispatched.has_value());
+  EXPECT_EQ(*dispatched, 1u);
+  EXPECT_EQ(calls, 1);
+  EXPECT_EQ(bytes, 3u);
+
+  // Drained, so nothing more to do
+  dispatched = loop->run_once(std::chrono::milliseconds(10));
+  ASSERT_TRUE(dispatched.has_value());
+  EXPECT_EQ(*dispatched, 0u);
+}
+
+TEST(EventLoopTest, RegistrationErrors)
+{
+  auto loop = EventLoop::create();
+  ASSERT_TRUE(loop.has_value());
+  UdpSocket socket = make_socket();
+
+  ASSERT_TRUE(loop->add(socket.get_fd(), EPOLLIN, [](uint32_t) {}));
+  EXPECT_EQ(loop->add(socket.get_fd(), EPOLLIN, [](uint32_t) {}).error(), EventLoopError::AlreadyRegistered);
+  EXPECT_EQ(loop->add(-1, EPOLLIN, [](uint32_t) {}).error(), EventLoopError::AddFailed);
+
+  ASSERT_TRUE(loop->remove(socket.get_fd()));
+  EXPECT_EQ(loop->remove(socket.get_fd()).error(), EventLoopError::NotRegistered);
+  EXPECT_EQ(loop->size(), 0u);
+}
+
+TEST(EventLoopTest, RemovedHandlerIsNotCalledLaterInTheSameRound)
+{
+  auto loop = EventLoop::create();
+  ASSERT_TRUE(loop.has_value());
+  UdpSocket first = make_socket();
+  UdpSocket second = make_socket();
+
+  // Whichever handler runs first removes the other, whose event is already collected
+  int calls = 0;
+  ASSERT_TRUE(loop->add(first.get_fd(), EPOLLIN, [&](uint32_t) {
+    ++calls;
+    [[maybe_unused]] auto removed = loop->remove(second.get_fd());
+  }));
+  ASSERT_TRUE(loop->add(second.get_fd(), EPOLLIN, [&](uint32_t) {
+    ++calls;
+    [[maybe_unused]] auto removed = loop->remove(first.get_fd());
+  }));
+
+  send_one(first);
+  send_one(second);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));  // Both ready before the wait
+
+  auto dispatched = loop->run_once(std::chrono::milliseconds(1000));
+  ASSERT_TRUE(dispatched.has_value());
+  EXPECT_EQ(*dispatched, 1u);
+  EXPECT_EQ(calls, 1);
+  EXPECT_EQ(loop->size(), 1u);
+}
+
+TEST(EventLoopTest, StopWakesABlockedLoop)
+{
+  auto loop = EventLoop::create();
+  ASSERT_TRUE(loop.has_value());
+
+  std::thread stopper([&loop]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    loop->stop();
+  });
+
+  auto start = std::chrono::steady_clock::now();
+  auto result = loop->run();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  stopper.join();
+
+  EXPECT_TRUE(result.has_value());
+  EXPECT_LT(elapsed, std::chrono::seconds(5));
+}
+
+TEST(EventLoopTest, StopBeforeRunReturnsImmediatelyOnce)
+{
+  auto loop = EventLoop::create();
+  ASSERT_TRUE(loop.has_value());
+
+  loop->stop();
+  EXPECT_TRUE(loop->run().has_value());
+
+  // The request was consumed: the next run() blocks until another stop()
+  std::thread stopper([&loop]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    loop->stop();
+  });
+  EXPECT_TRUE(loop->run().has_value());
+  stopper.join();
+}
+
+TEST(EventLoopTest, ErrorToString)
+{
+  EXPECT_STREQ(to_string(EventLoopError::AlreadyRegistered), "Descriptor is already watched");
+  EXPECT_STREQ(to_string(EventLoopError::WaitFailed), "Failed to wait for events");
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
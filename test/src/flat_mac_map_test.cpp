@@ -0,0 +1,156 @@
+/**
+ * @file flat_mac_map_test.cpp
+ * @brief Unit tests for the flat open-addressing MAC map
+ */
+
+#include "project/flat_mac_map.hpp"
+
+#include <gtest/gtest.h>
+
+#include <set>
+#include <unordered_map>
+
+using namespace project;
+
+namespace
+{
+  // Same OUI, sequential NIC part: the pattern that clustered with the old hash
+  MacAddress make_mac(uint32_t n)
+  {
+    return MacAddress({ 0x52, 0x54, 0x00, static_cast<uint8_t>(n >> 16), static_cast<uint8_t>(n >> 8),
+                        static_cast<uint8_t>(n) });
+  }
+}  // namespace
+
+TEST(FlatMacMapTest, InsertFindErase)
+{
+  FlatMacMap<int> map;
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(map.find(make_mac(1)), nullptr);
+
+  EXPECT_TRUE(map.insert_or_assign(make_mac(1), 10));
+  EXPECT_FALSE(map.insert_or_assign(make_mac(1), 11));
+  EXPECT_EQ(map.size(), 1);
+  ASSERT_NE(map.find(make_mac(1)), nullptr);
+  EXPECT_EQ(*map.find(make_mac(1)), 11);
+
+  EXPECT_TRUE(map.erase(make_mac(1)));
+  EXPECT_FALSE(map.erase(make_mac(1)));
+  EXPECT_FALSE(map.contains(make_mac(1)));
+  EXPECT_TRUE(map.empty());
+}
+
+TEST(FlatMacMapTest, GrowsPastLoadFactor)
+{
+  FlatMacMap<uint32_t> map;
+  constexpr uint32_t COUNT = 20000;
+
+  for (uint32_t i = 0; i < COUNT; ++i)
+  {
+    ASSERT_TRUE(map.insert_or_assign(make_mac(i), i));
+  }
+
+  EXPECT_EQ(map.size(), COUNT);
+  EXPECT_GE(map.capacity() * 3, COUNT * 4);
+
+  for (uint32_t i = 0; i < COUNT; ++i)
+  {
+    const uint32_t* value = map.find(make_mac(i));
+    ASSERT_NE(value, nullptr) << i;
+    EXPECT_EQ(*value, i);
+  }
+}
+
+TEST(FlatMacMapTest, EraseMatchesReference)
+{
+  FlatMacMap<uint32_t> map(64);
+  std::unordered_map<MacAddress, uint32_t> reference;
+
+  // Interleaved inserts and erases exercise backward-shift deletion
+  for (uint32_t i = 0; i < 5000; ++i)
+  {
+    MacAddress mac = make_mac((i * 7919) % 300);
+    if (i % 3 == 0)
+    {
+      EXPECT_EQ(map.erase(mac), reference.erase(mac) == 1);
+    }
+    else
+    {
+      EXPECT_EQ(map.insert_or_assign(mac, i), reference.count(mac) == 0);
+      reference[mac] = i;
+    }
+  }
+
+  EXPECT_EQ(map.size(), reference.size());
+  for (uint32_t n = 0; n < 300; ++n)
+  {
+    auto it = reference.find(make_mac(n));
+    const uint32_t* value = map.find(make_mac(n));
+    if (it == reference.end())
+    {
+      EXPECT_EQ(value, nullptr) << n;
+    }
+    else
+    {
+      ASSERT_NE(value, nullptr) << n;
+      EXPECT_EQ(*value, it->second);
+    }
+  }
+}
+
+TEST(FlatMacMapTest, ForEachAndClear)
+{
+  FlatMacMap<int> map;
+  map.insert_or_assign(make_mac(1), 1);
+  map.insert_or_assign(make_mac(2), 2);
+
+  std::set<uint64_t> seen;
+  int sum = 0;
+  map.for_each(
+      [&](const MacAddress& mac, int value)
+      {
+        seen.insert(mac.to_u64());
+        sum += value;
+      });
+  EXPECT_EQ(seen.size(), 2);
+  EXPECT_EQ(sum, 3);
+
+  size_t capacity = map.capacity();
+  map.clear();
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(map.capacity(), capacity);
+  EXPECT_FALSE(map.contains(make_mac(1)));
+}
+
+TEST(FlatMacMapTest, MoveLeavesSourceUsable)
+{
+  FlatMacMap<int> map;
+  map.insert_or_assign(make_mac(1), 1);
+
+  FlatMacMap<int> moved(std::move(map));
+  EXPECT_EQ(moved.size(), 1);
+  EXPECT_TRUE(map.empty());
+  EXPECT_FALSE(map.contains(make_mac(1)));
+
+  EXPECT_TRUE(map.insert_or_assign(make_mac(2), 2));
+  EXPECT_TRUE(map.contains(make_mac(2)));
+}
+
+TEST(FlatMacMapTest, HashSpreadsSharedOui)
+{
+  // With the identity-like hash, these all collided in the low bits
+  std::hash<MacAddress> hasher;
+  std::set<size_t> buckets;
+  for (uint32_t i = 0; i < 256; ++i)
+  {
+    MacAddress mac({ static_cast<uint8_t>(i), 0x54, 0x00, 0x12, 0x34, 0x56 });
+    buckets.insert(hasher(mac) & 255);
+  }
+  EXPECT_GT(buckets.size(), 128);
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
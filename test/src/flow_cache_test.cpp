@@ -0,0 +1,64 @@
+/**
+ * @file flow_cache_test.cpp
+ * @brief Unit tests for the flow cache
+ */
+
+#include "project/flow_cache.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace project;
+
+TEST(FlowCacheTest, HitsOnlyTheSameFlowInTheSameGenerationAndSecond)
+{
+  FlowCache cache;
+  const Endpoint a("127.0.0.1", 4001);
+  const Endpoint b("127.0.0.1", 4002);
+  const uint64_t src = 0x02000000000a;
+  const uint64_t dst = 0x02000000000b;
+  EXPECT_EQ(cache.find(1, src, dst, a, 0, 100), nullptr);
+
+  cache.store(1, src, dst, a, b, 7, 100);
+  const Endpoint* egress = cache.find(1, src, dst, a, 7, 100);
+  ASSERT_NE(egress, nullptr);
+  EXPECT_EQ(*egress, b);
+
+  // Another VLAN, direction, sender, generation or second is a miss
+  EXPECT_EQ(cache.find(2, src, dst, a, 7, 100), nullptr);
+  EXPECT_EQ(cache.find(1, dst, src, a, 7, 100), nullptr);
+  EXPECT_EQ(cache.find(1, src, dst, b, 7, 100), nullptr);
+  EXPECT_EQ(cache.find(1, src, dst, a, 8, 100), nullptr);
+  EXPECT_EQ(cache.find(1, src, dst, a, 7, 101), nullptr);
+}
+
+TEST(FlowCacheTest, CollidingFlowsReplaceEachOther)
+{
+  FlowCache cache;
+  const Endpoint a("127.0.0.1", 4001);
+  const Endpoint b("127.0.0.1", 4002);
+
+  // More flows than entries: the last ones stored are found, none is ever wrong
+  const uint64_t flows = FLOW_CACHE_SIZE * 4;
+  for (uint64_t i = 0; i < flows; ++i)
+  {
+    cache.store(0, 0x020000000000 + i, 0x02000000ffff, a, i % 2 == 0 ? a : b, 1, 5);
+  }
+  size_t hits = 0;
+  for (uint64_t i = 0; i < flows; ++i)
+  {
+    if (const Endpoint* egress = cache.find(0, 0x020000000000 + i, 0x02000000ffff, a, 1, 5))
+    {
+      EXPECT_EQ(*egress, i % 2 == 0 ? a : b);
+      ++hits;
+    }
+  }
+  EXPECT_GT(hits, 0u);
+  EXPECT_LE(hits, FLOW_CACHE_SIZE);
+  ASSERT_NE(cache.find(0, 0x020000000000 + flows - 1, 0x02000000ffff, a, 1, 5), nullptr);
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,123 @@
+/**
+ * @file frame_classifier_test.cpp
+ * @brief Unit tests for the burst frame classifier
+ */
+
+#include "project/frame_classifier.hpp"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+using namespace project;
+
+namespace
+{
+  constexpr SimdLevel ALL_LEVELS[] = { SimdLevel::Scalar, SimdLevel::Ssse3, SimdLevel::Avx2, SimdLevel::Neon };
+
+  std::vector<uint8_t> make_frame(MacAddress dst, MacAddress src, uint16_t ethertype, size_t size = 64)
+  {
+    EthernetFrame frame(dst, src, ethertype, std::vector<uint8_t>(size - ETHERNET_HEADER_SIZE, 0xee));
+    return frame.serialize();
+  }
+}  // namespace
+
+TEST(FrameClassifierTest, ClassifiesOneFrame)
+{
+  const MacAddress dst({ 0x02, 0x11, 0x22, 0x33, 0x44, 0x55 });
+  const MacAddress src({ 0x02, 0xaa, 0xbb, 0xcc, 0xdd, 0xee });
+  auto frame = make_frame(dst, src, EtherType::IPv4);
+
+  FrameKeys keys = classify_frame(frame.data(), frame.size());
+  EXPECT_EQ(keys.kind, FrameClass::Unicast);
+  EXPECT_EQ(keys.dst, dst.to_u64());
+  EXPECT_EQ(keys.src, src.to_u64());
+  EXPECT_EQ(keys.dst_mac(), dst);
+  EXPECT_EQ(keys.src_mac(), src);
+  EXPECT_EQ(keys.ethertype, EtherType::IPv4);
+
+  EXPECT_EQ(classify_frame(make_frame(MacAddress::broadcast(), src, EtherType::ARP).data(), 64).kind,
+            FrameClass::Broadcast);
+  EXPECT_EQ(classify_frame(make_frame(MacAddress({ 0x01, 0x00, 0x5e, 0x00, 0x00, 0xfb }), src, EtherType::IPv4).data(),
+                           64)
+                .kind,
+            FrameClass::Multicast);
+  EXPECT_EQ(classify_frame(frame.data(), ETHERNET_HEADER_SIZE - 1).kind, FrameClass::Runt);
+  EXPECT_EQ(classify_frame(nullptr, 0).kind, FrameClass::Runt);
+}
+
+TEST(FrameClassifierTest, EveryLevelMatchesScalar)
+{
+  // Random headers biased towards the interesting cases, at sizes around the 16-byte vector load
+  std::mt19937 rng(7);
+  std::vector<std::vector<uint8_t>> storage;
+  for (size_t i = 0; i < 67; ++i)
+  {
+    std::array<uint8_t, MAC_ADDRESS_SIZE> dst;
+    std::array<uint8_t, MAC_ADDRESS_SIZE> src;
+    for (size_t b = 0; b < MAC_ADDRESS_SIZE; ++b)
+    {
+      dst[b] = static_cast<uint8_t>(rng());
+      src[b] = static_cast<uint8_t>(rng());
+    }
+    MacAddress destination(dst);
+    if (i % 5 == 0)
+    {
+      destination = MacAddress::broadcast();
+    }
+    else if (i % 7 == 0)
+    {
+      dst[5] = 0xfe;  // All ones but the last byte: not broadcast
+      dst[0] = dst[1] = dst[2] = dst[3] = dst[4] = 0xff;
+      destination = MacAddress(dst);
+    }
+    storage.push_back(make_frame(destination, MacAddress(src), static_cast<uint16_t>(rng()), 64));
+  }
+
+  std::vector<const uint8_t*> frames;
+  std::vector<size_t> sizes;
+  for (size_t i = 0; i < storage.size(); ++i)
+  {
+    frames.push_back(storage[i].data());
+    sizes.push_back(i % 11 == 3 ? 14 + i % 3 : (i % 13 == 4 ? 0 : storage[i].size()));  // A few short and empty
+  }
+
+  std::vector<FrameKeys> expected(frames.size());
+  classify_frames(SimdLevel::Scalar, frames.data(), sizes.data(), frames.size(), expected.data());
+
+  for (SimdLevel level : ALL_LEVELS)
+  {
+    std::vector<FrameKeys> keys(frames.size());
+    classify_frames(level, frames.data(), sizes.data(), frames.size(), keys.data());
+    for (size_t i = 0; i < frames.size(); ++i)
+    {
+      EXPECT_EQ(keys[i].kind, expected[i].kind) << to_string(level) << " frame " << i;
+      EXPECT_EQ(keys[i].dst, expected[i].dst) << to_string(level) << " frame " << i;
+      EXPECT_EQ(keys[i].src, expected[i].src) << to_string(level) << " frame " << i;
+      EXPECT_EQ(keys[i].ethertype, expected[i].ethertype) << to_string(level) << " frame " << i;
+    }
+  }
+
+  std::vector<FrameKeys> dispatched(frames.size());
+  classify_frames(frames.data(), sizes.data(), frames.size(), dispatched.data());
+  for (size_t i = 0; i < frames.size(); ++i)
+  {
+    EXPECT_EQ(dispatched[i].dst, expected[i].dst);
+    EXPECT_EQ(dispatched[i].kind, expected[i].kind);
+  }
+}
+
+TEST(FrameClassifierTest, DetectedLevelIsSupported)
+{
+  EXPECT_TRUE(simd_level_supported(SimdLevel::Scalar));
+  EXPECT_TRUE(simd_level_supported(detected_simd_level()));
+  EXPECT_STREQ(to_string(SimdLevel::Avx2), "avx2");
+  EXPECT_STREQ(to_string(SimdLevel::Scalar), "scalar");
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,130 @@
+/**
+ * @file frame_coalescing_test.cpp
+ * @brief Unit tests for frame aggregates
+ */
+
+#include "project/frame_coalescing.hpp"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using namespace project;
+
+namespace
+{
+  std::vector<uint8_t> test_frame(size_t size, uint8_t fill)
+  {
+    std::vector<uint8_t> frame(size, fill);
+    frame[0] = 0x02;  // A unicast destination
+    return frame;
+  }
+}  // namespace
+
+TEST(FrameCoalescingTest, BuildsAndSplitsAggregates)
+{
+  std::vector<uint8_t> buffer(COALESCE_MAX_DATAGRAM_SIZE);
+  FrameCoalescer coalescer(buffer.data(), buffer.size());
+  EXPECT_TRUE(coalescer.empty());
+  EXPECT_EQ(coalescer.size(), 0u);
+
+  const auto ack = test_frame(66, 0xa1);
+  const auto arp = test_frame(42, 0xb2);
+  ASSERT_TRUE(coalescer.add(ack.data(), ack.size()));
+  ASSERT_TRUE(coalescer.add(arp.data(), arp.size()));
+  EXPECT_EQ(coalescer.frames(), 2u);
+  EXPECT_EQ(coalescer.size(), COALESCE_HEADER_SIZE + 2 * COALESCE_RECORD_HEADER_SIZE + ack.size() + arp.size());
+
+  // To the classifier an aggregate is a unicast frame to and from nobody
+  const uint8_t* frames[] = { coalescer.data() };
+  const size_t sizes[] = { coalescer.size() };
+  FrameKeys keys;
+  classify_frames(frames, sizes, 1, &keys);
+  EXPECT_TRUE(is_coalesced(keys));
+
+  std::vector<const uint8_t*> split(COALESCE_MAX_FRAMES);
+  std::vector<size_t> split_sizes(COALESCE_MAX_FRAMES);
+  auto count = split_coalesced(coalescer.data(), coalescer.size(), split.data(), split_sizes.data(), split.size());
+  ASSERT_TRUE(count.has_value());
+  ASSERT_EQ(*count, 2u);
+  EXPECT_EQ(std::vector<uint8_t>(split[0], split[0] + split_sizes[0]), ack);
+  EXPECT_EQ(std::vector<uint8_t>(split[1], split[1] + split_sizes[1]), arp);
+  EXPECT_EQ(split[0], coalescer.data() + COALESCE_HEADER_SIZE + COALESCE_RECORD_HEADER_SIZE);  // In place
+
+  coalescer.clear();
+  EXPECT_TRUE(coalescer.empty());
+  EXPECT_EQ(coalescer.size(), 0u);
+}
+
+TEST(FrameCoalescingTest, StopsAtTheSizeAndFrameLimits)
+{
+  std::vector<uint8_t> buffer(COALESCE_MAX_DATAGRAM_SIZE);
+  FrameCoalescer coalescer(buffer.data(), buffer.size());
+  const auto frame = test_frame(COALESCE_MAX_FRAME_SIZE, 0x11);
+  size_t added = 0;
+  while (coalescer.add(frame.data(), frame.size()))
+  {
+    ++added;
+  }
+  EXPECT_EQ(added, 2u);  // 15 + 3 * 514 would be over 1472
+  EXPECT_LE(coalescer.size(), COALESCE_MAX_DATAGRAM_SIZE);
+  EXPECT_FALSE(coalescer.fits(frame.size()));
+  EXPECT_TRUE(coalescer.fits(COALESCE_MAX_DATAGRAM_SIZE - coalescer.size() - COALESCE_RECORD_HEADER_SIZE));
+  EXPECT_EQ(coalescer.frames(), 2u);
+
+  std::vector<uint8_t> large(70'000);
+  FrameCoalescer tiny(large.data(), large.size());
+  const auto runt = test_frame(1, 0);
+  for (size_t i = 0; i < COALESCE_MAX_FRAMES; ++i)
+  {
+    ASSERT_TRUE(tiny.add(runt.data(), runt.size()));
+  }
+  EXPECT_TRUE(tiny.full());
+  EXPECT_FALSE(tiny.add(runt.data(), runt.size()));
+  EXPECT_FALSE(tiny.fits(0));
+
+  FrameCoalescer none;
+  EXPECT_FALSE(none.add(runt.data(), runt.size()));
+}
+
+TEST(FrameCoalescingTest, RejectsMalformedAggregates)
+{
+  std::vector<uint8_t> buffer(COALESCE_MAX_DATAGRAM_SIZE);
+  FrameCoalescer coalescer(buffer.data(), buffer.size());
+  const auto frame = test_frame(60, 0x22);
+  ASSERT_TRUE(coalescer.add(frame.data(), frame.size()));
+  std::vector<uint8_t> aggregate(coalescer.data(), coalescer.data() + coalescer.size());
+
+  const uint8_t* frames[2];
+  size_t sizes[2];
+  auto split = [&](const std::vector<uint8_t>& data, size_t capacity = 2) {
+    return split_coalesced(data.data(), data.size(), frames, sizes, capacity);
+  };
+  ASSERT_TRUE(split(aggregate).has_value());
+
+  // An ordinary frame, another version, a record running past the end or cut short, nothing at all
+  EXPECT_EQ(split(frame).error(), CoalesceError::NotAnAggregate);
+  std::vector<uint8_t> other_version = aggregate;
+  other_version[14] = 2;
+  EXPECT_EQ(split(other_version).error(), CoalesceError::NotAnAggregate);
+  std::vector<uint8_t> overlong = aggregate;
+  overlong[COALESCE_HEADER_SIZE + 1] += 1;
+  EXPECT_EQ(split(overlong).error(), CoalesceError::Malformed);
+  std::vector<uint8_t> cut = aggregate;
+  cut.push_back(0);
+  EXPECT_EQ(split(cut).error(), CoalesceError::Malformed);
+  std::vector<uint8_t> empty(aggregate.begin(), aggregate.begin() + COALESCE_HEADER_SIZE);
+  EXPECT_EQ(split(empty).error(), CoalesceError::Malformed);
+
+  std::vector<uint8_t> three = aggregate;
+  three.insert(three.end(), aggregate.begin() + COALESCE_HEADER_SIZE, aggregate.end());
+  three.insert(three.end(), aggregate.begin() + COALESCE_HEADER_SIZE, aggregate.end());
+  EXPECT_EQ(split(three).error(), CoalesceError::TooManyFrames);
+  EXPECT_STRNE(to_string(CoalesceError::TooManyFrames), "");
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,153 @@
+/**
+ * @file frame_pool_test.cpp
+ * @brief Unit tests for the frame buffer pool
+ */
+
+#include "project/frame_pool.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace project;
+
+TEST(FramePoolTest, Construction)
+{
+  FramePool pool(4);
+  EXPECT_EQ(pool.slot_count(), 4);
+  EXPECT_EQ(pool.available(), 4);
+  EXPECT_GE(pool.slot_size(), FRAME_BUFFER_SIZE);
+}
+
+TEST(FramePoolTest, SlotSizeRoundedToCacheLine)
+{
+  FramePool pool(1, 100);
+  EXPECT_EQ(pool.slot_size(), 128);
+}
+
+TEST(FramePoolTest, AcquireAndRelease)
+{
+  FramePool pool(2);
+
+  {
+    FrameBuffer buffer = pool.acquire();
+    ASSERT_TRUE(buffer.is_valid());
+    EXPECT_TRUE(static_cast<bool>(buffer));
+    EXPECT_EQ(buffer.size(), 0);
+    EXPECT_EQ(buffer.capacity(), pool.slot_size());
+    EXPECT_EQ(pool.available(), 1);
+  }
+
+  // Slot is recycled when the handle goes out of scope
+  EXPECT_EQ(pool.available(), 2);
+}
+
+TEST(FramePoolTest, Exhaustion)
+{
+  FramePool pool(2);
+
+  FrameBuffer a = pool.acquire();
+  FrameBuffer b = pool.acquire();
+  FrameBuffer c = pool.acquire();
+
+  EXPECT_TRUE(a.is_valid());
+  EXPECT_TRUE(b.is_valid());
+  EXPECT_FALSE(c.is_valid());
+  EXPECT_EQ(c.capacity(), 0);
+  EXPECT_EQ(pool.available(), 0);
+
+  a.reset();
+  EXPECT_FALSE(a.is_valid());
+  EXPECT_EQ(pool.available(), 1);
+
+  FrameBuffer d = pool.acquire();
+  EXPECT_TRUE(d.is_valid());
+}
+
+TEST(FramePoolTest, DistinctSlots)
+{
+  FramePool pool(8);
+  std::vector<FrameBuffer> buffers;
+  std::set<const uint8_t*> addresses;
+
+  for (size_t i = 0; i < pool.slot_count(); ++i)
+  {
+    buffers.push_back(pool.acquire());
+    addresses.insert(buffers.back().data());
+  }
+
+  EXPECT_EQ(addresses.size(), pool.slot_count());
+}
+
+TEST(FramePoolTest, SetSizeClampsToCapacity)
+{
+  FramePool pool(1, 64);
+  FrameBuffer buffer = pool.acquire();
+
+  buffer.set_size(10);
+  EXPECT_EQ(buffer.size(), 10);
+
+  buffer.set_size(1000);
+  EXPECT_EQ(buffer.size(), buffer.capacity());
+}
+
+TEST(FramePoolTest, MoveSemantics)
+{
+  FramePool pool(2);
+
+  FrameBuffer a = pool.acquire();
+  std::memset(a.data(), 0xab, 4);
+  a.set_size(4);
+  const uint8_t* slot = a.data();
+
+  FrameBuffer b(std::move(a));
+  EXPECT_FALSE(a.is_valid());
+  EXPECT_EQ(b.data(), slot);
+  EXPECT_EQ(b.size(), 4);
+  EXPECT_EQ(b.data()[3], 0xab);
+
+  FrameBuffer c = pool.acquire();
+  EXPECT_EQ(pool.available(), 0);
+
+  // Move assignment releases the slot previously held by c
+  c = std::move(b);
+  EXPECT_EQ(pool.available(), 1);
+  EXPECT_EQ(c.data(), slot);
+}
+
+TEST(FramePoolTest, ConcurrentAcquireRelease)
+{
+  FramePool pool(16);
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t)
+  {
+    threads.emplace_back([&pool]() {
+      for (int i = 0; i < 1000; ++i)
+      {
+        FrameBuffer buffer = pool.acquire();
+        if (buffer)
+        {
+          buffer.data()[0] = static_cast<uint8_t>(i);
+          buffer.set_size(1);
+        }
+      }
+    });
+  }
+
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+
+  EXPECT_EQ(pool.available(), pool.slot_count());
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
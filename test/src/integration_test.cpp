@@ -9,16 +9,27 @@
  * - Broadcast frames work correctly
  */
 
+#include "project/cluster.hpp"
 #include "project/ethernet_frame.hpp"
+#include "project/event_loop.hpp"
+#include "project/frame_coalescing.hpp"
+#include "project/io_uring.hpp"
 #include "project/mac_table.hpp"
+#include "project/socket_handoff.hpp"
+#include "project/tunnel_crypto.hpp"
 #include "project/udp_socket.hpp"
 #include "project/vport.hpp"
 #include "project/vswitch.hpp"
 
 #include <gtest/gtest.h>
 
+#include <array>
+#include <chrono>
+#include <cstdio>
 #include <thread>
 
+#include <unistd.h>
+
 using namespace project;
 
 // Helper function to create a simple test Ethernet frame
@@ -60,6 +71,1261 @@ TEST(IntegrationTest, VSwitchMacLearning)
   // Full integration test would require VSwitch::start() and actual UDP frames.
 }
 
+TEST(IntegrationTest, VSwitchForwardsFrames)
+{
+  VSwitchConfig config;
+  config.port = 20010;
+  config.batch_size = 8;
+
+  auto vswitch_result = VSwitch::create(config);
+  if (!vswitch_result.has_value())
+  {
+    config.port = 20011;
+    vswitch_result = VSwitch::create(config);
+  }
+  ASSERT_TRUE(vswitch_result.has_value());
+  VSwitch vswitch = std::move(*vswitch_result);
+
+  std::thread switch_thread([&vswitch]() { [[maybe_unused]] auto result = vswitch.start(); });
+
+  // Two "VPorts" as plain sockets
+  auto port_a_result = UdpSocket::create();
+  auto port_b_result = UdpSocket::create();
+  ASSERT_TRUE(port_a_result.has_value());
+  ASSERT_TRUE(port_b_result.has_value());
+  UdpSocket port_a = std::move(*port_a_result);
+  UdpSocket port_b = std::move(*port_b_result);
+  ASSERT_TRUE(port_a.bind("127.0.0.1", 20012).has_value());
+  ASSERT_TRUE(port_b.bind("127.0.0.1", 20013).has_value());
+
+  Endpoint switch_endpoint("127.0.0.1", config.port);
+  MacAddress mac_a({0x02, 0x00, 0x00, 0x00, 0x00, 0x0a});
+  MacAddress mac_b({0x02, 0x00, 0x00, 0x00, 0x00, 0x0b});
+
+  // A announces itself with a broadcast (nobody else is known yet)
+  ASSERT_TRUE(port_a.send_to(create_test_frame(MacAddress::broadcast(), mac_a, EtherType::ARP), switch_endpoint));
+
+  // B broadcasts; the switch must flood it to A
+  auto broadcast = create_test_frame(MacAddress::broadcast(), mac_b, EtherType::ARP);
+  ASSERT_TRUE(port_b.send_to(broadcast, switch_endpoint));
+
+  auto flooded = port_a.receive_from(1024);
+  ASSERT_TRUE(flooded.has_value());
+  EXPECT_EQ(flooded->first, broadcast);
+
+  // A replies with unicast to B
+  auto unicast = create_test_frame(mac_b, mac_a, EtherType::IPv4, {0xca, 0xfe});
+  ASSERT_TRUE(port_a.send_to(unicast, switch_endpoint));
+
+  auto forwarded = port_b.receive_from(1024);
+  ASSERT_TRUE(forwarded.has_value());
+  EXPECT_EQ(forwarded->first, unicast);
+  EXPECT_EQ(vswitch.learned_macs(), 2);
+
+  // Stop, then wake the blocking receive with one last datagram
+  vswitch.stop();
+  ASSERT_TRUE(port_a.send_to(unicast, switch_endpoint));
+  switch_thread.join();
+}
+
+TEST(IntegrationTest, VSwitchWorkerPool)
+{
+  VSwitchConfig config;
+  config.port = 0;
+  config.workers = 3;
+
+  auto vswitch_result = VSwitch::create(config);
+  ASSERT_TRUE(vswitch_result.has_value());
+  VSwitch vswitch = std::move(*vswitch_result);
+  EXPECT_EQ(vswitch.worker_count(), 3);
+  ASSERT_NE(vswitch.port(), 0);
+
+  std::thread switch_thread([&vswitch]() { [[maybe_unused]] auto result = vswitch.start(); });
+
+  // Several "VPorts" so the kernel spreads their flows across workers
+  constexpr size_t PORTS = 4;
+  std::vector<UdpSocket> ports;
+  std::vector<MacAddress> macs;
+  for (size_t i = 0; i < PORTS; ++i)
+  {
+    auto socket_result = UdpSocket::create();
+    ASSERT_TRUE(socket_result.has_value());
+    ASSERT_TRUE(socket_result->bind("127.0.0.1", 0).has_value());
+    ASSERT_TRUE(socket_result->set_receive_timeout(std::chrono::seconds(2)).has_value());
+    ports.push_back(std::move(*socket_result));
+    macs.push_back(MacAddress({ 0x02, 0x00, 0x00, 0x00, 0x01, static_cast<uint8_t>(i) }));
+  }
+
+  Endpoint switch_endpoint("127.0.0.1", vswitch.port());
+
+  // Every port announces itself; learning happens on whichever worker gets the flow
+  for (size_t i = 0; i < PORTS; ++i)
+  {
+    ASSERT_TRUE(ports[i].send_to(create_test_frame(MacAddress::broadcast(), macs[i], EtherType::ARP), switch_endpoint));
+  }
+
+  // Wait until all announcements are learned (earlier ones are flooded to later ports)
+  for (int attempt = 0; attempt < 200 && vswitch.learned_macs() < PORTS; ++attempt)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  ASSERT_EQ(vswitch.learned_macs(), PORTS);
+
+  // Unicast from the first port to the last, across whatever workers own the flows
+  auto unicast = create_test_frame(macs[PORTS - 1], macs[0], EtherType::IPv4, { 0xbe, 0xef });
+  ASSERT_TRUE(ports[0].send_to(unicast, switch_endpoint));
+
+  bool delivered = false;
+  for (size_t attempt = 0; attempt < PORTS && !delivered; ++attempt)
+  {
+    auto received = ports[PORTS - 1].receive_from(1024);
+    ASSERT_TRUE(received.has_value());
+    delivered = received->first == unicast;
+  }
+  EXPECT_TRUE(delivered);
+
+  // stop() alone must be enough: workers wake up on their receive timeout
+  vswitch.stop();
+  switch_thread.join();
+  EXPECT_FALSE(vswitch.is_running());
+}
+
+TEST(IntegrationTest, VSwitchFloodsOncePerPort)
+{
+  auto vswitch_result = VSwitch::create(0);
+  ASSERT_TRUE(vswitch_result.has_value());
+  VSwitch vswitch = std::move(*vswitch_result);
+
+  std::thread switch_thread([&vswitch]() { [[maybe_unused]] auto result = vswitch.start(); });
+
+  auto port_a_result = UdpSocket::create();
+  auto port_b_result = UdpSocket::create();
+  ASSERT_TRUE(port_a_result.has_value());
+  ASSERT_TRUE(port_b_result.has_value());
+  UdpSocket port_a = std::move(*port_a_result);
+  UdpSocket port_b = std::move(*port_b_result);
+  ASSERT_TRUE(port_a.bind("127.0.0.1", 0).has_value());
+  ASSERT_TRUE(port_b.bind("127.0.0.1", 0).has_value());
+  ASSERT_TRUE(port_a.set_receive_timeout(std::chrono::milliseconds(200)).has_value());
+
+  Endpoint switch_endpoint("127.0.0.1", vswitch.port());
+
+  // Port A hosts three MACs (e.g., several VMs behind one VPort)
+  for (uint8_t i = 0; i < 3; ++i)
+  {
+    MacAddress mac({ 0x02, 0x00, 0x00, 0x00, 0x0a, i });
+    MacAddress nobody({ 0x02, 0x00, 0x00, 0x00, 0xff, 0xff });  // Unknown unicast: learned, then dropped
+    ASSERT_TRUE(port_a.send_to(create_test_frame(nobody, mac, EtherType::IPv4), switch_endpoint));
+  }
+  for (int attempt = 0; attempt < 200 && vswitch.learned_macs() < 3; ++attempt)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  ASSERT_EQ(vswitch.learned_macs(), 3);
+
+  // A broadcast from B must reach A exactly once
+  auto broadcast = create_test_frame(MacAddress::broadcast(), MacAddress({ 0x02, 0x00, 0x00, 0x00, 0x0b, 0x00 }),
+                                     EtherType::ARP);
+  ASSERT_TRUE(port_b.send_to(broadcast, switch_endpoint));
+
+  auto first = port_a.receive_from(1024);
+  ASSERT_TRUE(first.has_value());
+  EXPECT_EQ(first->first, broadcast);
+  EXPECT_FALSE(port_a.receive_from(1024).has_value());
+
+  vswitch.stop();
+  switch_thread.join();
+
+  // Three unknown unicasts dropped, one broadcast flooded as one copy
+  TrafficStats stats = vswitch.stats();
+  EXPECT_EQ(stats.rx_frames, 4u);
+  EXPECT_EQ(stats.unknown_unicast_drops, 3u);
+  EXPECT_EQ(stats.floods, 1u);
+  EXPECT_EQ(stats.tx_frames, 1u);
+  EXPECT_EQ(stats.tx_bytes, broadcast.size());
+  EXPECT_EQ(stats.send_errors, 0u);
+
+  std::string text = vswitch.stats_prometheus();
+  EXPECT_NE(text.find("vswitch_floods_total{worker=\"0\"} 1\n"), std::string::npos);
+  EXPECT_NE(text.find("vswitch_learned_macs 4\n"), std::string::npos);
+
+  // Only the flooded frame was forwarded; dropped frames have no send time
+  LatencySnapshot latency = vswitch.latency();
+  EXPECT_EQ(latency.count, PROJECT_LATENCY_HISTOGRAMS ? 1u : 0u);
+}
+
+// Insert an 802.1Q tag into an untagged frame
+std::vector<uint8_t> tag_frame(std::vector<uint8_t> frame, uint16_t vlan)
+{
+  const uint8_t tag[VLAN_TAG_SIZE] = { 0x81, 0x00, static_cast<uint8_t>(vlan >> 8), static_cast<uint8_t>(vlan) };
+  frame.insert(frame.begin() + 2 * MAC_ADDRESS_SIZE, tag, tag + VLAN_TAG_SIZE);
+  return frame;
+}
+
+TEST(IntegrationTest, VSwitchKeepsVlansApart)
+{
+  // Access ports A and B in VLAN 10, C in VLAN 20, and a trunk T carrying both without a native VLAN
+  std::vector<UdpSocket> ports;
+  for (size_t i = 0; i < 4; ++i)
+  {
+    auto port = UdpSocket::create();
+    ASSERT_TRUE(port.has_value());
+    ASSERT_TRUE(port->bind("127.0.0.1", 0).has_value());
+    ASSERT_TRUE(port->set_receive_timeout(std::chrono::milliseconds(200)).has_value());
+    ports.push_back(std::move(*port));
+  }
+  UdpSocket& port_a = ports[0];
+  UdpSocket& port_b = ports[1];
+  UdpSocket& port_c = ports[2];
+  UdpSocket& trunk = ports[3];
+
+  VSwitchConfig config;
+  const uint16_t access_vlans[] = { 10, 10, 20 };
+  for (size_t i = 0; i < 3; ++i)
+  {
+    VlanPortConfig access;
+    access.endpoint = *ports[i].bound_endpoint();
+    access.vlan = access_vlans[i];
+    config.vlan_ports.push_back(access);
+  }
+  VlanPortConfig trunk_config;
+  trunk_config.endpoint = *trunk.bound_endpoint();
+  trunk_config.mode = VlanMode::Trunk;
+  trunk_config.vlan = 0;
+  trunk_config.allowed = { 10, 20 };
+  config.vlan_ports.push_back(trunk_config);
+
+  auto vswitch_result = VSwitch::create(config);
+  ASSERT_TRUE(vswitch_result.has_value());
+  VSwitch vswitch = std::move(*vswitch_result);
+  std::thread switch_thread([&vswitch]() { [[maybe_unused]] auto result = vswitch.start(); });
+  Endpoint switch_endpoint("127.0.0.1", vswitch.port());
+
+  // Every port announces one MAC (T in VLAN 20)
+  std::vector<MacAddress> macs;
+  MacAddress nobody({ 0x02, 0x00, 0x00, 0x00, 0xff, 0xff });
+  for (uint8_t i = 0; i < 4; ++i)
+  {
+    macs.emplace_back(std::array<uint8_t, 6>{ 0x02, 0x00, 0x00, 0x00, 0x0d, i });
+    auto hello = create_test_frame(nobody, macs[i], EtherType::IPv4);
+    ASSERT_TRUE(ports[i].send_to(i == 3 ? tag_frame(hello, 20) : hello, switch_endpoint));
+  }
+  for (int attempt = 0; attempt < 200 && vswitch.learned_macs() < 4; ++attempt)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  ASSERT_EQ(vswitch.learned_macs(), 4);
+
+  // A broadcast in VLAN 10 reaches B as sent and T tagged, but not C
+  auto broadcast = create_test_frame(MacAddress::broadcast(), macs[0], EtherType::ARP);
+  ASSERT_TRUE(port_a.send_to(broadcast, switch_endpoint));
+  auto at_b = port_b.receive_from(1024);
+  ASSERT_TRUE(at_b.has_value());
+  EXPECT_EQ(at_b->first, broadcast);
+  auto at_trunk = trunk.receive_from(1024);
+  ASSERT_TRUE(at_trunk.has_value());
+  EXPECT_EQ(at_trunk->first, tag_frame(broadcast, 10));
+  EXPECT_FALSE(port_c.receive_from(1024).has_value());
+
+  // A tagged unicast from the trunk reaches C untagged; C is unknown in VLAN 10
+  auto unicast = create_test_frame(macs[2], macs[3], EtherType::IPv4, { 0xca, 0xfe });
+  ASSERT_TRUE(trunk.send_to(tag_frame(unicast, 20), switch_endpoint));
+  auto at_c = port_c.receive_from(1024);
+  ASSERT_TRUE(at_c.has_value());
+  EXPECT_EQ(at_c->first, unicast);
+  ASSERT_TRUE(port_a.send_to(create_test_frame(macs[2], macs[0], EtherType::IPv4), switch_endpoint));
+
+  // Untagged on a trunk without a native VLAN, or with a tag on an access port: dropped
+  ASSERT_TRUE(trunk.send_to(unicast, switch_endpoint));
+  ASSERT_TRUE(port_a.send_to(tag_frame(create_test_frame(macs[1], macs[0], EtherType::IPv4), 20), switch_endpoint));
+  EXPECT_FALSE(port_c.receive_from(1024).has_value());
+  EXPECT_FALSE(port_b.receive_from(1024).has_value());
+
+  vswitch.stop();
+  switch_thread.join();
+
+  TrafficStats stats = vswitch.stats();
+  EXPECT_EQ(stats.vlan_drops, 2u);
+  EXPECT_EQ(stats.unknown_unicast_drops, 5u);
+  EXPECT_EQ(stats.tx_frames, 3u);
+  EXPECT_EQ(stats.tx_bytes, 2 * broadcast.size() + VLAN_TAG_SIZE + unicast.size());
+}
+
+// An IGMPv2 membership report for a group, as a host sends it (IPv4 checksum left zero)
+std::vector<uint8_t> igmp_report_frame(MacAddress src, const std::array<uint8_t, 4>& group)
+{
+  MacAddress group_mac({ 0x01, 0x00, 0x5e, static_cast<uint8_t>(group[1] & 0x7f), group[2], group[3] });
+  std::vector<uint8_t> packet = { 0x46, 0xc0, 0, 32, 0, 0, 0, 0, 1, 2, 0, 0, 10, 0, 0, 2 };
+  packet.insert(packet.end(), group.begin(), group.end());
+  packet.insert(packet.end(), { 0x94, 0x04, 0, 0, 0x16, 0, 0, 0 });  // Router alert, then IGMP
+  packet.insert(packet.end(), group.begin(), group.end());
+  return create_test_frame(group_mac, src, EtherType::IPv4, packet);
+}
+
+TEST(IntegrationTest, VSwitchSnoopsMulticastGroups)
+{
+  auto vswitch_result = VSwitch::create(0);
+  ASSERT_TRUE(vswitch_result.has_value());
+  VSwitch vswitch = std::move(*vswitch_result);
+
+  std::thread switch_thread([&vswitch]() { [[maybe_unused]] auto result = vswitch.start(); });
+
+  std::vector<UdpSocket> ports;
+  for (size_t i = 0; i < 3; ++i)
+  {
+    auto socket = UdpSocket::create();
+    ASSERT_TRUE(socket.has_value());
+    ASSERT_TRUE(socket->bind("127.0.0.1", 0).has_value());
+    ASSERT_TRUE(socket->set_receive_timeout(std::chrono::milliseconds(200)).has_value());
+    ports.push_back(std::move(*socket));
+  }
+  Endpoint switch_endpoint("127.0.0.1", vswitch.port());
+  const MacAddress macs[3] = { MacAddress({ 0x02, 0, 0, 0, 0, 0x0a }), MacAddress({ 0x02, 0, 0, 0, 0, 0x0b }),
+                               MacAddress({ 0x02, 0, 0, 0, 0, 0x0c }) };
+
+  // Every port announces itself; B then joins 239.1.2.3
+  for (size_t i = 0; i < 3; ++i)
+  {
+    ASSERT_TRUE(ports[i].send_to(create_test_frame(MacAddress::broadcast(), macs[i], EtherType::ARP), switch_endpoint));
+  }
+  ASSERT_TRUE(ports[1].send_to(igmp_report_frame(macs[1], { 239, 1, 2, 3 }), switch_endpoint));
+  for (int attempt = 0; attempt < 200 && vswitch.multicast_groups() < 1; ++attempt)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  ASSERT_EQ(vswitch.multicast_groups(), 1u);
+  for (auto& port : ports)
+  {
+    while (port.receive_from(1024).has_value())
+    {
+    }
+  }
+
+  // Group traffic reaches B alone, an unsubscribed group nobody, a link-local group everyone
+  auto group_frame = create_test_frame(MacAddress({ 0x01, 0x00, 0x5e, 0x01, 0x02, 0x03 }), macs[0], EtherType::IPv4);
+  auto unsubscribed = create_test_frame(MacAddress({ 0x01, 0x00, 0x5e, 0x01, 0x02, 0x04 }), macs[0], EtherType::IPv4);
+  auto mdns = create_test_frame(MacAddress({ 0x01, 0x00, 0x5e, 0x00, 0x00, 0xfb }), macs[0], EtherType::IPv4);
+  ASSERT_TRUE(ports[0].send_to(group_frame, switch_endpoint));
+  ASSERT_TRUE(ports[0].send_to(unsubscribed, switch_endpoint));
+  ASSERT_TRUE(ports[0].send_to(mdns, switch_endpoint));
+
+  auto received = ports[1].receive_from(1024);
+  ASSERT_TRUE(received.has_value());
+  EXPECT_EQ(received->first, group_frame);
+  received = ports[1].receive_from(1024);
+  ASSERT_TRUE(received.has_value());
+  EXPECT_EQ(received->first, mdns);
+  received = ports[2].receive_from(1024);
+  ASSERT_TRUE(received.has_value());
+  EXPECT_EQ(received->first, mdns);
+  EXPECT_FALSE(ports[2].receive_from(1024).has_value());
+
+  vswitch.stop();
+  switch_thread.join();
+
+  TrafficStats stats = vswitch.stats();
+  EXPECT_EQ(stats.multicast_drops, 1u);
+  EXPECT_EQ(stats.floods, 3u);  // B's and C's announcements (A's had nowhere to go) and mDNS
+  EXPECT_NE(vswitch.stats_prometheus().find("vswitch_multicast_groups 1\n"), std::string::npos);
+}
+
+TEST(IntegrationTest, VSwitchFloodsUnknownUnicastWhenConfigured)
+{
+  VSwitchConfig config;
+  config.port = 0;
+  config.unknown_unicast = FloodPolicy::Flood;
+  auto vswitch_result = VSwitch::create(config);
+  ASSERT_TRUE(vswitch_result.has_value());
+  VSwitch vswitch = std::move(*vswitch_result);
+
+  std::thread switch_thread([&vswitch]() { [[maybe_unused]] auto result = vswitch.start(); });
+
+  auto port_a_result = UdpSocket::create();
+  auto port_b_result = UdpSocket::create();
+  ASSERT_TRUE(port_a_result.has_value());
+  ASSERT_TRUE(port_b_result.has_value());
+  UdpSocket port_a = std::move(*port_a_result);
+  UdpSocket port_b = std::move(*port_b_result);
+  ASSERT_TRUE(port_a.bind("127.0.0.1", 0).has_value());
+  ASSERT_TRUE(port_b.bind("127.0.0.1", 0).has_value());
+  ASSERT_TRUE(port_a.set_receive_timeout(std::chrono::milliseconds(200)).has_value());
+
+  Endpoint switch_endpoint("127.0.0.1", vswitch.port());
+  MacAddress mac_a({ 0x02, 0, 0, 0, 0, 0x0a });
+  MacAddress mac_b({ 0x02, 0, 0, 0, 0, 0x0b });
+  MacAddress nobody({ 0x02, 0, 0, 0, 0xff, 0xff });
+
+  // A is known once it sent something; B's frame to an unlearned MAC then reaches it
+  ASSERT_TRUE(port_a.send_to(create_test_frame(nobody, mac_a, EtherType::IPv4), switch_endpoint));
+  for (int attempt = 0; attempt < 200 && vswitch.learned_macs() < 1; ++attempt)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  auto unknown = create_test_frame(nobody, mac_b, EtherType::IPv4, { 0xab });
+  ASSERT_TRUE(port_b.send_to(unknown, switch_endpoint));
+
+  auto flooded = port_a.receive_from(1024);
+  ASSERT_TRUE(flooded.has_value());
+  EXPECT_EQ(flooded->first, unknown);
+
+  vswitch.stop();
+  switch_thread.join();
+
+  TrafficStats stats = vswitch.stats();
+  EXPECT_EQ(stats.unknown_unicast_drops, 0u);
+  EXPECT_EQ(stats.floods, 1u);  // B's frame; A's had nowhere to go
+}
+
+TEST(IntegrationTest, VSwitchPolicesNoisyPorts)
+{
+  VSwitchConfig config;
+  config.port = 0;
+  config.ingress_rate = 1;  // A trickle: the burst is all a port gets during the test
+  config.ingress_burst = 600;
+  config.priority_queues = true;
+  auto vswitch_result = VSwitch::create(config);
+  ASSERT_TRUE(vswitch_result.has_value());
+  VSwitch vswitch = std::move(*vswitch_result);
+
+  std::thread switch_thread([&vswitch]() { [[maybe_unused]] auto result = vswitch.start(); });
+
+  auto port_a_result = UdpSocket::create();
+  auto port_b_result = UdpSocket::create();
+  ASSERT_TRUE(port_a_result.has_value());
+  ASSERT_TRUE(port_b_result.has_value());
+  UdpSocket port_a = std::move(*port_a_result);
+  UdpSocket port_b = std::move(*port_b_result);
+  ASSERT_TRUE(port_a.bind("127.0.0.1", 0).has_value());
+  ASSERT_TRUE(port_b.bind("127.0.0.1", 0).has_value());
+  ASSERT_TRUE(port_b.set_receive_timeout(std::chrono::milliseconds(200)).has_value());
+
+  Endpoint switch_endpoint("127.0.0.1", vswitch.port());
+  MacAddress mac_a({ 0x02, 0, 0, 0, 0, 0x0a });
+  MacAddress mac_b({ 0x02, 0, 0, 0, 0, 0x0b });
+
+  // B makes itself known; A then sends 20 frames of 100 bytes where its bucket holds 6
+  ASSERT_TRUE(port_b.send_to(create_test_frame(MacAddress::broadcast(), mac_b, EtherType::ARP), switch_endpoint));
+  for (int attempt = 0; attempt < 200 && vswitch.learned_macs() < 1; ++attempt)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  auto frame = create_test_frame(mac_b, mac_a, EtherType::IPv4, std::vector<uint8_t>(86, 0x5a));
+  ASSERT_EQ(frame.size(), 100u);
+  for (int i = 0; i < 20; ++i)
+  {
+    ASSERT_TRUE(port_a.send_to(frame, switch_endpoint));
+  }
+
+  size_t delivered = 0;
+  while (port_b.receive_from(1024).has_value())
+  {
+    ++delivered;
+  }
+
+  vswitch.stop();
+  switch_thread.join();
+
+  EXPECT_EQ(delivered, 6u);
+  TrafficStats stats = vswitch.stats();
+  EXPECT_EQ(stats.policed_drops, 14u);
+  EXPECT_EQ(stats.rx_frames, 21u);
+}
+
+TEST(IntegrationTest, VSwitchForwardsOnlyAuthenticFrames)
+{
+  TunnelKey key_a;
+  key_a.id = 1;
+  key_a.secret.fill(0xa1);
+  TunnelKey key_b;
+  key_b.id = 2;
+  key_b.secret.fill(0xb2);
+
+  VSwitchConfig config;
+  config.port = 0;
+  config.tunnel_keys = { key_a, key_b };
+  config.tunnel_cipher = TunnelCipher::ChaCha20Poly1305;
+  auto vswitch_result = VSwitch::create(config);
+  if (!vswitch_result && vswitch_result.error() == VSwitchError::EncryptionFailed)
+  {
+    GTEST_SKIP() << "Built without OpenSSL";
+  }
+  ASSERT_TRUE(vswitch_result.has_value());
+  VSwitch vswitch = std::move(*vswitch_result);
+
+  std::thread switch_thread([&vswitch]() { [[maybe_unused]] auto result = vswitch.start(); });
+
+  // Two VPorts, each sealing with its own key
+  auto keyring_a = TunnelKeyring::create(config.tunnel_cipher, TunnelRole::Port, { key_a });
+  auto keyring_b = TunnelKeyring::create(config.tunnel_cipher, TunnelRole::Port, { key_b });
+  ASSERT_TRUE(keyring_a.has_value());
+  ASSERT_TRUE(keyring_b.has_value());
+  TunnelContext tunnel_a(**keyring_a);
+  TunnelContext tunnel_b(**keyring_b);
+  auto seal = [](TunnelContext& tunnel, uint32_t key_id, std::vector<uint8_t> frame) {
+    std::vector<uint8_t> datagram(frame.size() + TUNNEL_OVERHEAD);
+    struct iovec piece = { frame.data(), frame.size() };
+    EXPECT_TRUE(tunnel.seal(key_id, &piece, 1, datagram.data(), datagram.size()).has_value());
+    return datagram;
+  };
+
+  auto port_a_result = UdpSocket::create();
+  auto port_b_result = UdpSocket::create();
+  ASSERT_TRUE(port_a_result.has_value());
+  ASSERT_TRUE(port_b_result.has_value());
+  UdpSocket port_a = std::move(*port_a_result);
+  UdpSocket port_b = std::move(*port_b_result);
+  ASSERT_TRUE(port_a.bind("127.0.0.1", 0).has_value());
+  ASSERT_TRUE(port_b.bind("127.0.0.1", 0).has_value());
+  ASSERT_TRUE(port_a.set_receive_timeout(std::chrono::milliseconds(200)).has_value());
+  ASSERT_TRUE(port_b.set_receive_timeout(std::chrono::milliseconds(200)).has_value());
+
+  Endpoint switch_endpoint("127.0.0.1", vswitch.port());
+  MacAddress mac_a({ 0x02, 0, 0, 0, 0, 0x0a });
+  MacAddress mac_b({ 0x02, 0, 0, 0, 0, 0x0b });
+
+  // B announces itself
+  auto hello = create_test_frame(MacAddress::broadcast(), mac_b, EtherType::ARP);
+  ASSERT_TRUE(port_b.send_to(seal(tunnel_b, key_b.id, hello), switch_endpoint));
+  for (int attempt = 0; attempt < 200 && vswitch.learned_macs() < 1; ++attempt)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  ASSERT_EQ(vswitch.learned_macs(), 1);
+
+  // Cleartext is dropped, a sealed frame reaches B sealed with B's key
+  auto unicast = create_test_frame(mac_b, mac_a, EtherType::IPv4, { 0xca, 0xfe });
+  ASSERT_TRUE(port_a.send_to(unicast, switch_endpoint));
+  std::vector<uint8_t> sealed = seal(tunnel_a, key_a.id, unicast);
+  std::vector<uint8_t> replayed = sealed;
+  ASSERT_TRUE(port_a.send_to(sealed, switch_endpoint));
+
+  auto forwarded = port_b.receive_from(1024);
+  ASSERT_TRUE(forwarded.has_value());
+  EXPECT_EQ(forwarded->first.size(), unicast.size() + TUNNEL_OVERHEAD);
+  auto opened = tunnel_b.open(forwarded->first.data(), forwarded->first.size());
+  ASSERT_TRUE(opened.has_value());
+  EXPECT_EQ(opened->key_id, key_b.id);
+  EXPECT_EQ(std::vector<uint8_t>(opened->data, opened->data + opened->size), unicast);
+
+  // A replay or a forgery goes nowhere
+  ASSERT_TRUE(port_a.send_to(replayed, switch_endpoint));
+  std::vector<uint8_t> forged = seal(tunnel_a, key_a.id, unicast);
+  forged.back() ^= 1;
+  ASSERT_TRUE(port_a.send_to(forged, switch_endpoint));
+  EXPECT_FALSE(port_b.receive_from(1024).has_value());
+
+  // B answers A, which the switch now seals with A's key
+  auto answer = create_test_frame(mac_a, mac_b, EtherType::IPv4, { 0xbe, 0xef });
+  ASSERT_TRUE(port_b.send_to(seal(tunnel_b, key_b.id, answer), switch_endpoint));
+  auto answered = port_a.receive_from(1024);
+  ASSERT_TRUE(answered.has_value());
+  auto opened_answer = tunnel_a.open(answered->first.data(), answered->first.size());
+  ASSERT_TRUE(opened_answer.has_value());
+  EXPECT_EQ(std::vector<uint8_t>(opened_answer->data, opened_answer->data + opened_answer->size), answer);
+
+  vswitch.stop();
+  switch_thread.join();
+
+  TrafficStats stats = vswitch.stats();
+  EXPECT_EQ(stats.crypto_drops, 3u);
+  EXPECT_EQ(stats.tx_frames, 2u);
+}
+
+TEST(IntegrationTest, VSwitchSplitsCoalescedFrames)
+{
+  VSwitchConfig config;
+  config.port = 0;
+  auto vswitch_result = VSwitch::create(config);
+  ASSERT_TRUE(vswitch_result.has_value());
+  VSwitch vswitch = std::move(*vswitch_result);
+
+  std::thread switch_thread([&vswitch]() { [[maybe_unused]] auto result = vswitch.start(); });
+
+  auto port_a_result = UdpSocket::create();
+  auto port_b_result = UdpSocket::create();
+  ASSERT_TRUE(port_a_result.has_value());
+  ASSERT_TRUE(port_b_result.has_value());
+  UdpSocket port_a = std::move(*port_a_result);
+  UdpSocket port_b = std::move(*port_b_result);
+  ASSERT_TRUE(port_a.bind("127.0.0.1", 0).has_value());
+  ASSERT_TRUE(port_b.bind("127.0.0.1", 0).has_value());
+  ASSERT_TRUE(port_b.set_receive_timeout(std::chrono::milliseconds(200)).has_value());
+
+  Endpoint switch_endpoint("127.0.0.1", vswitch.port());
+  MacAddress mac_a({ 0x02, 0, 0, 0, 0, 0x0a });
+  MacAddress mac_b({ 0x02, 0, 0, 0, 0, 0x0b });
+
+  // B announces itself
+  ASSERT_TRUE(port_b.send_to(create_test_frame(MacAddress::broadcast(), mac_b, EtherType::ARP), switch_endpoint));
+  for (int attempt = 0; attempt < 200 && vswitch.learned_macs() < 1; ++attempt)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  ASSERT_EQ(vswitch.learned_macs(), 1);
+
+  // A sends three frames to B in one datagram; B gets them one by one, in order
+  std::vector<std::vector<uint8_t>> frames;
+  std::vector<uint8_t> aggregate(COALESCE_MAX_DATAGRAM_SIZE);
+  FrameCoalescer coalescer(aggregate.data(), aggregate.size());
+  for (uint8_t i = 0; i < 3; ++i)
+  {
+    frames.push_back(create_test_frame(mac_b, mac_a, EtherType::IPv4, { i, i }));
+    ASSERT_TRUE(coalescer.add(frames.back().data(), frames.back().size()));
+  }
+  aggregate.resize(coalescer.size());
+  ASSERT_TRUE(port_a.send_to(aggregate, switch_endpoint));
+  for (const auto& frame : frames)
+  {
+    auto forwarded = port_b.receive_from(1024);
+    ASSERT_TRUE(forwarded.has_value());
+    EXPECT_EQ(forwarded->first, frame);
+  }
+
+  // A damaged aggregate is dropped whole
+  aggregate[COALESCE_HEADER_SIZE + 1] ^= 0x40;
+  ASSERT_TRUE(port_a.send_to(aggregate, switch_endpoint));
+  EXPECT_FALSE(port_b.receive_from(1024).has_value());
+  EXPECT_EQ(vswitch.learned_macs(), 2);  // A, learned from the frames inside
+
+  vswitch.stop();
+  switch_thread.join();
+
+  TrafficStats stats = vswitch.stats();
+  EXPECT_EQ(stats.tx_frames, 3u);
+}
+
+TEST(IntegrationTest, VSwitchFollowsStationsThatMove)
+{
+  auto vswitch_result = VSwitch::create(0);
+  ASSERT_TRUE(vswitch_result.has_value());
+  VSwitch vswitch = std::move(*vswitch_result);
+
+  std::thread switch_thread([&vswitch]() { [[maybe_unused]] auto result = vswitch.start(); });
+
+  std::vector<UdpSocket> ports;
+  for (int i = 0; i < 3; ++i)
+  {
+    auto port_result = UdpSocket::create();
+    ASSERT_TRUE(port_result.has_value());
+    ports.push_back(std::move(*port_result));
+    ASSERT_TRUE(ports.back().bind("127.0.0.1", 0).has_value());
+    ASSERT_TRUE(ports.back().set_receive_timeout(std::chrono::milliseconds(200)).has_value());
+  }
+
+  Endpoint switch_endpoint("127.0.0.1", vswitch.port());
+  MacAddress mac_a({ 0x02, 0, 0, 0, 0, 0x0a });
+  MacAddress mac_b({ 0x02, 0, 0, 0, 0, 0x0b });
+  auto announce_b = create_test_frame(MacAddress::broadcast(), mac_b, EtherType::ARP);
+
+  // B is behind port 1; a flow of frames from A goes there, the later ones on the worker's cached answer
+  ASSERT_TRUE(ports[1].send_to(announce_b, switch_endpoint));
+  for (int attempt = 0; attempt < 200 && vswitch.learned_macs() < 1; ++attempt)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  ASSERT_EQ(vswitch.learned_macs(), 1);
+  auto unicast = create_test_frame(mac_b, mac_a, EtherType::IPv4, { 0xca, 0xfe });
+  for (int i = 0; i < 3; ++i)
+  {
+    ASSERT_TRUE(ports[0].send_to(unicast, switch_endpoint));
+    auto forwarded = ports[1].receive_from(1024);
+    ASSERT_TRUE(forwarded.has_value());
+    EXPECT_EQ(forwarded->first, unicast);
+  }
+
+  // B moves to port 2 (port 0 hears the broadcast); the same flow follows it at once
+  ASSERT_TRUE(ports[2].send_to(announce_b, switch_endpoint));
+  ASSERT_TRUE(ports[0].receive_from(1024).has_value());
+  ASSERT_TRUE(ports[0].send_to(unicast, switch_endpoint));
+  auto moved = ports[2].receive_from(1024);
+  ASSERT_TRUE(moved.has_value());
+  EXPECT_EQ(moved->first, unicast);
+
+  vswitch.stop();
+  switch_thread.join();
+}
+
+TEST(IntegrationTest, VSwitchSharesMacsWithClusterPeers)
+{
+  // The peer node is played by a plain socket
+  auto peer_result = UdpSocket::create();
+  ASSERT_TRUE(peer_result.has_value());
+  UdpSocket peer = std::move(*peer_result);
+  ASSERT_TRUE(peer.bind("127.0.0.1", 0).has_value());
+  ASSERT_TRUE(peer.set_receive_timeout(std::chrono::milliseconds(200)).has_value());
+  auto peer_endpoint = peer.bound_endpoint();
+  ASSERT_TRUE(peer_endpoint.has_value());
+
+  VSwitchConfig config;
+  config.port = 0;
+  config.cluster_peers = { *peer_endpoint };
+  config.cluster_sync_interval = std::chrono::milliseconds(20);
+  auto vswitch_result = VSwitch::create(config);
+  ASSERT_TRUE(vswitch_result.has_value());
+  VSwitch vswitch = std::move(*vswitch_result);
+  ASSERT_EQ(vswitch.cluster_peers().size(), 1u);
+
+  std::thread switch_thread([&vswitch]() { [[maybe_unused]] auto result = vswitch.start(); });
+
+  auto port_a_result = UdpSocket::create();
+  ASSERT_TRUE(port_a_result.has_value());
+  UdpSocket port_a = std::move(*port_a_result);
+  ASSERT_TRUE(port_a.bind("127.0.0.1", 0).has_value());
+  ASSERT_TRUE(port_a.set_receive_timeout(std::chrono::milliseconds(200)).has_value());
+
+  Endpoint switch_endpoint("127.0.0.1", vswitch.port());
+  MacAddress mac_a({ 0x02, 0, 0, 0, 0, 0x0a });
+  MacAddress mac_p({ 0x02, 0, 0, 0, 0, 0x0c });
+
+  // The peer hears from the switch's port; frames and MAC updates come mixed
+  std::vector<MacUpdate> updates;
+  auto next_frame = [&]() -> std::vector<uint8_t> {
+    for (int attempt = 0; attempt < 50; ++attempt)
+    {
+      auto received = peer.receive_from(2048);
+      if (!received)
+      {
+        break;
+      }
+      EXPECT_EQ(received->second, switch_endpoint);
+      if (!decode_mac_updates(received->first.data(), received->first.size(), updates))
+      {
+        return received->first;
+      }
+    }
+    return {};
+  };
+  auto next_update = [&](MacUpdateKind kind, const MacAddress& mac) -> const MacUpdate* {
+    for (int attempt = 0; attempt < 50; ++attempt)
+    {
+      auto received = peer.receive_from(2048);
+      if (received && decode_mac_updates(received->first.data(), received->first.size(), updates))
+      {
+        for (const auto& update : updates)
+        {
+          if (update.kind == kind && update.mac == mac)
+          {
+            return &update;
+          }
+        }
+      }
+    }
+    return nullptr;
+  };
+
+  // A local broadcast reaches the peer, and the peer learns where A is
+  auto broadcast = create_test_frame(MacAddress::broadcast(), mac_a, EtherType::ARP);
+  ASSERT_TRUE(port_a.send_to(broadcast, switch_endpoint));
+  EXPECT_EQ(next_frame(), broadcast);
+  const MacUpdate* learned = next_update(MacUpdateKind::Learn, mac_a);
+  ASSERT_NE(learned, nullptr);
+  const uint16_t vlan = learned->vlan;
+
+  // The peer announces P; frames for it cross over
+  ASSERT_FALSE(encode_mac_updates({ { MacUpdateKind::Learn, vlan, mac_p } }).empty());
+  ASSERT_TRUE(peer.send_to(encode_mac_updates({ { MacUpdateKind::Learn, vlan, mac_p } }).front(), switch_endpoint));
+  for (int attempt = 0; attempt < 200 && vswitch.learned_macs() < 2; ++attempt)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  ASSERT_EQ(vswitch.learned_macs(), 2);
+  auto unicast = create_test_frame(mac_p, mac_a, EtherType::IPv4, { 0xca, 0xfe });
+  ASSERT_TRUE(port_a.send_to(unicast, switch_endpoint));
+  EXPECT_EQ(next_frame(), unicast);
+
+  // A broadcast from the peer reaches A but never goes back to a peer
+  auto peer_broadcast = create_test_frame(MacAddress::broadcast(), mac_p, EtherType::ARP);
+  ASSERT_TRUE(peer.send_to(peer_broadcast, switch_endpoint));
+  auto flooded = port_a.receive_from(1024);
+  ASSERT_TRUE(flooded.has_value());
+  EXPECT_EQ(flooded->first, peer_broadcast);
+  EXPECT_TRUE(next_frame().empty());
+
+  // Withdrawn, P is unknown again; A stays this node's own
+  ASSERT_TRUE(
+      peer.send_to(encode_mac_updates({ { MacUpdateKind::Withdraw, vlan, mac_p } }).front(), switch_endpoint));
+  for (int attempt = 0; attempt < 200 && vswitch.learned_macs() > 1; ++attempt)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  EXPECT_EQ(vswitch.learned_macs(), 1);
+
+  vswitch.stop();
+  switch_thread.join();
+}
+
+TEST(IntegrationTest, VSwitchRejectsInvalidClusterConfig)
+{
+  VSwitchConfig config;
+  config.port = 0;
+  config.cluster_peers = { Endpoint() };
+  EXPECT_EQ(VSwitch::create(config).error(), VSwitchError::InvalidClusterConfig);
+  config.cluster_peers = { Endpoint("::1", 9) };  // The switch's sockets are IPv4
+  EXPECT_EQ(VSwitch::create(config).error(), VSwitchError::InvalidClusterConfig);
+
+  config.cluster_peers = { Endpoint("127.0.0.1", 9) };
+  config.tunnel_keys = { TunnelKey{} };
+  config.tunnel_keys.front().id = 1;
+  auto encrypted = VSwitch::create(config);
+  ASSERT_FALSE(encrypted.has_value());
+  EXPECT_EQ(encrypted.error(), VSwitchError::InvalidClusterConfig);
+}
+
+TEST(IntegrationTest, VSwitchRestartsWarmFromSnapshot)
+{
+  VSwitchConfig config;
+  config.port = 0;
+  config.mac_snapshot_path = ::testing::TempDir() + "vswitch_snapshot_" + std::to_string(::getpid());
+  std::remove(config.mac_snapshot_path.c_str());
+
+  {
+    auto vswitch_result = VSwitch::create(config);
+    ASSERT_TRUE(vswitch_result.has_value());
+    VSwitch vswitch = std::move(*vswitch_result);
+    EXPECT_EQ(vswitch.learned_macs(), 0);
+
+    std::thread switch_thread([&vswitch]() { [[maybe_unused]] auto result = vswitch.start(); });
+
+    auto port_result = UdpSocket::create();
+    ASSERT_TRUE(port_result.has_value());
+    UdpSocket port = std::move(*port_result);
+    ASSERT_TRUE(port.bind("127.0.0.1", 0).has_value());
+    MacAddress mac({ 0x02, 0, 0, 0, 0, 0x0a });
+    ASSERT_TRUE(port.send_to(create_test_frame(MacAddress::broadcast(), mac, EtherType::ARP),
+                             Endpoint("127.0.0.1", vswitch.port())));
+    for (int attempt = 0; attempt < 200 && vswitch.learned_macs() < 1; ++attempt)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    ASSERT_EQ(vswitch.learned_macs(), 1);
+
+    // Shutting down writes the snapshot
+    vswitch.stop();
+    switch_thread.join();
+  }
+
+  auto restarted = VSwitch::create(config);
+  ASSERT_TRUE(restarted.has_value());
+  EXPECT_EQ(restarted->learned_macs(), 1);
+  std::remove(config.mac_snapshot_path.c_str());
+}
+
+TEST(IntegrationTest, VSwitchHandsOverToSuccessor)
+{
+  VSwitchConfig config;
+  config.workers = 2;
+  auto predecessor_result = VSwitch::create(config);
+  ASSERT_TRUE(predecessor_result.has_value());
+  VSwitch predecessor = std::move(*predecessor_result);
+  const Endpoint switch_endpoint("127.0.0.1", predecessor.port());
+
+  const std::string path = ::testing::TempDir() + "vswitch_handoff_" + std::to_string(::getpid());
+  auto listener = HandoffListener::create(path);
+  ASSERT_TRUE(listener.has_value());
+
+  std::thread predecessor_thread([&predecessor]() { [[maybe_unused]] auto result = predecessor.start(); });
+
+  MacAddress mac_a({ 0x02, 0x00, 0x00, 0x00, 0x0d, 0x0a });
+  MacAddress mac_b({ 0x02, 0x00, 0x00, 0x00, 0x0d, 0x0b });
+  std::array<UdpSocket, 2> ports;
+  for (size_t i = 0; i < ports.size(); ++i)
+  {
+    auto port = UdpSocket::create();
+    ASSERT_TRUE(port.has_value());
+    ASSERT_TRUE(port->bind("127.0.0.1", 0).has_value());
+    ASSERT_TRUE(port->set_receive_timeout(std::chrono::milliseconds(500)).has_value());
+    ports[i] = std::move(*port);
+  }
+  // One at a time: with two workers, A's announcement could otherwise be flooded to B after B is learned and
+  // queue ahead of the unicast port 1 waits for
+  const std::array<MacAddress, 2> macs{ mac_a, mac_b };
+  for (size_t i = 0; i < ports.size(); ++i)
+  {
+    ASSERT_TRUE(ports[i].send_to(create_test_frame(MacAddress::broadcast(), macs[i], EtherType::ARP), switch_endpoint));
+    for (int attempt = 0; attempt < 200 && predecessor.learned_macs() < i + 1; ++attempt)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    ASSERT_EQ(predecessor.learned_macs(), i + 1);
+  }
+
+  // The predecessor answers on its own thread with the switch running, like vswitch_main
+  expected<void, HandoffError> handed = unexpected(HandoffError::Timeout);
+  std::thread handoff_thread([&]() {
+    auto channel = listener->accept(std::chrono::seconds(2));
+    if (channel)
+    {
+      handed = predecessor.hand_over(channel->get());
+    }
+  });
+
+  auto channel = connect_handoff(path);
+  ASSERT_TRUE(channel.has_value());
+  config.workers = 1;  // Overridden by what is handed over
+  auto successor_result = VSwitch::take_over(config, channel->get());
+  handoff_thread.join();
+  predecessor_thread.join();
+  ASSERT_TRUE(successor_result.has_value());
+  ASSERT_TRUE(handed.has_value());
+  EXPECT_FALSE(predecessor.is_running());
+
+  VSwitch successor = std::move(*successor_result);
+  EXPECT_EQ(successor.port(), switch_endpoint.port());
+  EXPECT_EQ(successor.worker_count(), 2u);
+  EXPECT_EQ(successor.learned_macs(), 2);
+
+  // Sent while neither switch reads: queued in the shared sockets, then forwarded by the successor
+  auto unicast = create_test_frame(mac_b, mac_a, EtherType::IPv4, { 1, 2, 3 });
+  ASSERT_TRUE(ports[0].send_to(unicast, switch_endpoint));
+
+  std::thread successor_thread([&successor]() { [[maybe_unused]] auto result = successor.start(); });
+  auto received = ports[1].receive_from(2048);
+  ASSERT_TRUE(received.has_value());
+  EXPECT_EQ(received->first, unicast);
+
+  successor.stop();
+  successor_thread.join();
+}
+
+TEST(IntegrationTest, VSwitchFloodsJumboFramesZeroCopy)
+{
+  VSwitchConfig config;
+  config.max_frame_size = 9216;
+  config.zerocopy = true;
+  auto vswitch_result = VSwitch::create(config);
+  ASSERT_TRUE(vswitch_result.has_value());
+  VSwitch vswitch = std::move(*vswitch_result);
+
+  std::thread switch_thread([&vswitch]() { [[maybe_unused]] auto result = vswitch.start(); });
+
+  Endpoint switch_endpoint("127.0.0.1", vswitch.port());
+  std::vector<UdpSocket> ports;
+  for (uint8_t i = 0; i < 3; ++i)
+  {
+    auto port = UdpSocket::create();
+    ASSERT_TRUE(port.has_value());
+    ASSERT_TRUE(port->bind("127.0.0.1", 0).has_value());
+    ASSERT_TRUE(port->set_receive_timeout(std::chrono::milliseconds(500)).has_value());
+    MacAddress nobody({ 0x02, 0x00, 0x00, 0x00, 0xff, 0xff });
+    ASSERT_TRUE(port->send_to(create_test_frame(nobody, MacAddress({ 0x02, 0x00, 0x00, 0x00, 0x0c, i }),
+                                                EtherType::IPv4),
+                              switch_endpoint));
+    ports.push_back(std::move(*port));
+  }
+  for (int attempt = 0; attempt < 200 && vswitch.learned_macs() < 3; ++attempt)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  ASSERT_EQ(vswitch.learned_macs(), 3);
+
+  // A 9000-byte broadcast from port 0 reaches the other two intact
+  auto jumbo = create_test_frame(MacAddress::broadcast(), MacAddress({ 0x02, 0x00, 0x00, 0x00, 0x0c, 0 }),
+                                 EtherType::IPv4, std::vector<uint8_t>(9000 - ETHERNET_HEADER_SIZE, 0xa5));
+  ASSERT_TRUE(ports[0].send_to(jumbo, switch_endpoint));
+  for (size_t i = 1; i < ports.size(); ++i)
+  {
+    auto received = ports[i].receive_from(jumbo.size() + 1);
+    ASSERT_TRUE(received.has_value());
+    EXPECT_EQ(received->first, jumbo);
+  }
+
+  vswitch.stop();
+  switch_thread.join();
+
+  TrafficStats stats = vswitch.stats();
+  EXPECT_EQ(stats.floods, 1u);
+  EXPECT_EQ(stats.tx_frames, 2u);
+  EXPECT_EQ(stats.tx_bytes, 2 * jumbo.size());
+}
+
+TEST(IntegrationTest, VSwitchIoUringBackendForwards)
+{
+  if (!io_uring_available())
+  {
+    GTEST_SKIP() << "io_uring is not available on this kernel";
+  }
+
+  VSwitchConfig config;
+  config.io_backend = IoBackend::IoUring;
+  auto vswitch_result = VSwitch::create(config);
+  ASSERT_TRUE(vswitch_result.has_value());
+  VSwitch vswitch = std::move(*vswitch_result);
+
+  std::thread switch_thread([&vswitch]() { [[maybe_unused]] auto result = vswitch.start(); });
+
+  std::vector<UdpSocket> ports;
+  std::vector<MacAddress> macs;
+  for (uint8_t i = 0; i < 3; ++i)
+  {
+    auto socket_result = UdpSocket::create();
+    ASSERT_TRUE(socket_result.has_value());
+    ASSERT_TRUE(socket_result->bind("127.0.0.1", 0).has_value());
+    ASSERT_TRUE(socket_result->set_receive_timeout(std::chrono::seconds(2)).has_value());
+    ports.push_back(std::move(*socket_result));
+    macs.push_back(MacAddress({ 0x02, 0x00, 0x00, 0x00, 0x0c, i }));
+  }
+  Endpoint switch_endpoint("127.0.0.1", vswitch.port());
+
+  // Unknown unicasts teach the switch every port without flooding anything
+  MacAddress nobody({ 0x02, 0x00, 0x00, 0x00, 0xff, 0xff });
+  for (size_t i = 0; i < ports.size(); ++i)
+  {
+    ASSERT_TRUE(ports[i].send_to(create_test_frame(nobody, macs[i], EtherType::IPv4), switch_endpoint));
+  }
+  for (int attempt = 0; attempt < 200 && vswitch.learned_macs() < 3; ++attempt)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  ASSERT_EQ(vswitch.learned_macs(), 3u);
+
+  // One unicast and one broadcast: the broadcast shares its receive buffer between two sends
+  auto unicast = create_test_frame(macs[2], macs[0], EtherType::IPv4, { 0xbe, 0xef });
+  auto broadcast = create_test_frame(MacAddress::broadcast(), macs[1], EtherType::ARP);
+  ASSERT_TRUE(ports[0].send_to(unicast, switch_endpoint));
+  ASSERT_TRUE(ports[1].send_to(broadcast, switch_endpoint));
+
+  auto first = ports[2].receive_from(1024);
+  auto second = ports[2].receive_from(1024);
+  auto flooded = ports[0].receive_from(1024);
+  ASSERT_TRUE(first.has_value());
+  ASSERT_TRUE(second.has_value());
+  ASSERT_TRUE(flooded.has_value());
+  EXPECT_EQ(first->first, unicast);
+  EXPECT_EQ(second->first, broadcast);
+  EXPECT_EQ(flooded->first, broadcast);
+
+  vswitch.stop();
+  switch_thread.join();
+
+  TrafficStats stats = vswitch.stats();
+  EXPECT_EQ(stats.rx_frames, 5u);
+  EXPECT_EQ(stats.unknown_unicast_drops, 3u);
+  EXPECT_EQ(stats.tx_frames, 3u);
+  EXPECT_EQ(stats.tx_bytes, unicast.size() + 2 * broadcast.size());
+  EXPECT_EQ(stats.send_errors, 0u);
+}
+
+TEST(IntegrationTest, VPortsShareAnEventLoop)
+{
+  auto loop_result = EventLoop::create();
+  ASSERT_TRUE(loop_result.has_value());
+  EventLoop loop = std::move(*loop_result);
+
+  auto first_result = VPort::create("", "127.0.0.1", 9);
+  auto second_result = VPort::create("", "127.0.0.1", 9);
+  if (!first_result || !second_result)
+  {
+    GTEST_SKIP() << "Skipping event loop test (TAP devices need root privileges)";
+  }
+  VPort first = std::move(*first_result);
+  VPort second = std::move(*second_result);
+
+  ASSERT_TRUE(first.attach(loop).has_value());
+  ASSERT_TRUE(second.attach(loop).has_value());
+  EXPECT_TRUE(first.is_running());
+  EXPECT_EQ(loop.size(), 4u);  // A TAP device and a socket per VPort
+  EXPECT_EQ(first.attach(loop).error(), VPortError::AlreadyRunning);
+  EXPECT_EQ(first.start().error(), VPortError::AlreadyRunning);
+
+  // One thread serves both ports until told to stop
+  std::thread loop_thread([&loop]() { EXPECT_TRUE(loop.run().has_value()); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  loop.stop();
+  loop_thread.join();
+
+  first.stop();
+  EXPECT_FALSE(first.is_running());
+  EXPECT_EQ(loop.size(), 2u);
+  second.stop();
+  EXPECT_EQ(loop.size(), 0u);
+
+  // Detached ports can be attached again
+  ASSERT_TRUE(first.attach(loop).has_value());
+  first.stop();
+  EXPECT_EQ(loop.size(), 0u);
+}
+
+TEST(IntegrationTest, VPortIoUringBackendStartsAndStops)
+{
+  if (!io_uring_available())
+  {
+    GTEST_SKIP() << "io_uring is not available on this kernel";
+  }
+
+  auto vport_result = VPort::create("", "127.0.0.1", 9);
+  if (!vport_result)
+  {
+    GTEST_SKIP() << "Skipping io_uring test (TAP devices need root privileges)";
+  }
+  VPort vport = std::move(*vport_result);
+
+  ASSERT_TRUE(vport.start(IoBackend::IoUring).has_value());
+  EXPECT_TRUE(vport.is_running());
+  EXPECT_EQ(vport.start(IoBackend::IoUring).error(), VPortError::AlreadyRunning);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+  // stop() must get the forwarder out of its wait, and the port must start again
+  auto begin = std::chrono::steady_clock::now();
+  vport.stop();
+  EXPECT_FALSE(vport.is_running());
+  ASSERT_TRUE(vport.start(IoBackend::IoUring).has_value());
+  vport.stop();
+  EXPECT_LT(std::chrono::steady_clock::now() - begin, std::chrono::seconds(5));
+  EXPECT_EQ(vport.tap_to_switch_stats().send_errors, 0u);
+}
+
+TEST(IntegrationTest, VPortPipelinePerTapQueue)
+{
+  auto loop_result = EventLoop::create();
+  ASSERT_TRUE(loop_result.has_value());
+  EventLoop loop = std::move(*loop_result);
+
+  EXPECT_EQ(VPort::create_multi_queue("", "", 9, 2).error(), VPortError::InvalidVSwitchEndpoint);
+  auto vports_result = VPort::create_multi_queue("", "127.0.0.1", 9, 3);
+  if (!vports_result)
+  {
+    GTEST_SKIP() << "Skipping multi-queue test (TAP devices need root privileges)";
+  }
+  std::vector<VPort> vports = std::move(*vports_result);
+  ASSERT_EQ(vports.size(), 3u);
+
+  // One interface, but a TAP queue and a socket of its own per pipeline
+  for (VPort& vport : vports)
+  {
+    EXPECT_EQ(vport.device_name(), vports.front().device_name());
+    ASSERT_TRUE(vport.attach(loop).has_value());
+  }
+  EXPECT_EQ(loop.size(), 6u);
+
+  for (VPort& vport : vports)
+  {
+    vport.stop();
+  }
+  EXPECT_EQ(loop.size(), 0u);
+}
+
+TEST(IntegrationTest, VPortWithOffloadsAttaches)
+{
+  auto loop_result = EventLoop::create();
+  ASSERT_TRUE(loop_result.has_value());
+  EventLoop loop = std::move(*loop_result);
+
+  auto vport_result = VPort::create("", "127.0.0.1", 9, true);
+  if (!vport_result)
+  {
+    GTEST_SKIP() << "Skipping offload test (TAP devices need root privileges)";
+  }
+  VPort vport = std::move(*vport_result);
+
+  ASSERT_TRUE(vport.attach(loop).has_value());
+  auto dispatched = loop.run_once(std::chrono::milliseconds(10));
+  ASSERT_TRUE(dispatched.has_value());
+  vport.stop();
+  EXPECT_EQ(loop.size(), 0u);
+  EXPECT_EQ(vport.tap_to_switch_stats().send_errors, 0u);
+}
+
+TEST(IntegrationTest, VPortEnablesEncryptionBeforeStarting)
+{
+  TunnelKey key;
+  key.id = 3;
+  key.secret.fill(0x33);
+
+  auto offloaded_result = VPort::create("", "127.0.0.1", 9, true);
+  if (!offloaded_result)
+  {
+    GTEST_SKIP() << "Skipping encryption test (TAP devices need root privileges)";
+  }
+  EXPECT_EQ(offloaded_result->enable_encryption(TunnelCipher::Aes256Gcm, key).error(), VPortError::EncryptionFailed);
+  EXPECT_FALSE(offloaded_result->encryption_enabled());
+
+  auto vport_result = VPort::create("", "127.0.0.1", 9);
+  ASSERT_TRUE(vport_result.has_value());
+  VPort vport = std::move(*vport_result);
+  auto enabled = vport.enable_encryption(TunnelCipher::Aes256Gcm, key);
+  if (!enabled)
+  {
+    GTEST_SKIP() << "Built without OpenSSL";
+  }
+  EXPECT_TRUE(vport.encryption_enabled());
+
+  auto loop_result = EventLoop::create();
+  ASSERT_TRUE(loop_result.has_value());
+  EventLoop loop = std::move(*loop_result);
+  ASSERT_TRUE(vport.attach(loop).has_value());
+  EXPECT_EQ(vport.enable_encryption(TunnelCipher::Aes256Gcm, key).error(), VPortError::AlreadyRunning);
+  ASSERT_TRUE(loop.run_once(std::chrono::milliseconds(10)).has_value());
+  vport.stop();
+  EXPECT_EQ(vport.switch_to_tap_stats().crypto_drops, 0u);
+}
+
+TEST(IntegrationTest, VPortEnablesCoalescingBeforeStarting)
+{
+  auto vport_result = VPort::create("", "127.0.0.1", 9);
+  if (!vport_result)
+  {
+    GTEST_SKIP() << "Skipping coalescing test (TAP devices need root privileges)";
+  }
+  VPort vport = std::move(*vport_result);
+  EXPECT_FALSE(vport.coalescing_enabled());
+
+  // Offloaded super-frames bypass the coalescer, so it is refused rather than silently idle
+  auto offloaded_result = VPort::create("", "127.0.0.1", 9, true);
+  ASSERT_TRUE(offloaded_result.has_value());
+  EXPECT_EQ(offloaded_result->enable_coalescing(std::chrono::microseconds(50)).error(), VPortError::CoalescingFailed);
+  EXPECT_FALSE(offloaded_result->coalescing_enabled());
+  EXPECT_TRUE(offloaded_result->enable_coalescing(std::chrono::microseconds(0)).has_value());
+
+  ASSERT_TRUE(vport.enable_coalescing(std::chrono::microseconds(50)).has_value());
+  EXPECT_TRUE(vport.coalescing_enabled());
+
+  // Still set up after a move
+  VPort moved = std::move(vport);
+  EXPECT_TRUE(moved.coalescing_enabled());
+
+  auto loop_result = EventLoop::create();
+  ASSERT_TRUE(loop_result.has_value());
+  EventLoop loop = std::move(*loop_result);
+  ASSERT_TRUE(moved.attach(loop).has_value());
+  EXPECT_EQ(moved.enable_coalescing(std::chrono::microseconds(0)).error(), VPortError::AlreadyRunning);
+  ASSERT_TRUE(loop.run_once(std::chrono::milliseconds(10)).has_value());
+  moved.stop();
+  EXPECT_EQ(moved.tap_to_switch_stats().send_errors, 0u);
+
+  ASSERT_TRUE(moved.enable_coalescing(std::chrono::microseconds(0)).has_value());
+  EXPECT_FALSE(moved.coalescing_enabled());
+}
+
+TEST(IntegrationTest, VPortEnablesFailoverBeforeStarting)
+{
+  auto vport_result = VPort::create("", "127.0.0.1", 9);
+  if (!vport_result)
+  {
+    GTEST_SKIP() << "Skipping failover test (TAP devices need root privileges)";
+  }
+  VPort vport = std::move(*vport_result);
+  EXPECT_FALSE(vport.failover_enabled());
+  EXPECT_EQ(vport.enable_failover({ Endpoint() }).error(), VPortError::InvalidVSwitchEndpoint);
+  EXPECT_FALSE(vport.failover_enabled());
+  ASSERT_TRUE(vport.enable_failover({ Endpoint("127.0.0.1", 10) }, std::chrono::milliseconds(50)).has_value());
+  EXPECT_TRUE(vport.failover_enabled());
+  EXPECT_EQ(vport.vswitch_endpoint(), Endpoint("127.0.0.1", 9));  // The first node stays active
+
+  VPort moved = std::move(vport);
+  EXPECT_TRUE(moved.failover_enabled());
+
+  auto loop_result = EventLoop::create();
+  ASSERT_TRUE(loop_result.has_value());
+  EventLoop loop = std::move(*loop_result);
+  ASSERT_TRUE(moved.attach(loop).has_value());
+  EXPECT_EQ(moved.enable_failover({}).error(), VPortError::AlreadyRunning);
+  ASSERT_TRUE(loop.run_once(std::chrono::milliseconds(10)).has_value());
+  moved.stop();
+
+  ASSERT_TRUE(moved.enable_failover({}).has_value());
+  EXPECT_FALSE(moved.failover_enabled());
+}
+
 TEST(IntegrationTest, MacTableEndpointsRetrieval)
 {
   MacTable mac_table;
@@ -0,0 +1,219 @@
+/**
+ * @file io_uring_test.cpp
+ * @brief Unit tests for the io_uring wrapper
+ */
+
+#include "project/io_uring.hpp"
+#include "project/udp_socket.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using namespace project;
+
+TEST(IoUringTest, ToString)
+{
+  EXPECT_STREQ(to_string(IoBackend::Syscalls), "syscalls");
+  EXPECT_STREQ(to_string(IoBackend::IoUring), "io_uring");
+  EXPECT_STREQ(to_string(IoUringError::Unsupported), "io_uring is not supported");
+}
+
+#if PROJECT_HAVE_IO_URING
+namespace
+{
+  /**
+   * @brief Wait for CQEs until count arrived or attempts run out
+   */
+  std::vector<io_uring_cqe> reap(IoUring& ring, size_t count)
+  {
+    std::vector<io_uring_cqe> completions;
+    for (int attempt = 0; attempt < 20 && completions.size() < count; ++attempt)
+    {
+      EXPECT_TRUE(ring.submit_and_wait(std::chrono::milliseconds(50)).has_value());
+      ring.for_each_completion([&](const io_uring_cqe& cqe) { completions.push_back(cqe); });
+    }
+    return completions;
+  }
+}  // namespace
+
+TEST(IoUringTest, NopCompletesWithItsTag)
+{
+  if (!io_uring_available())
+  {
+    GTEST_SKIP() << "io_uring is not available on this kernel";
+  }
+
+  auto ring = IoUring::create(8);
+  ASSERT_TRUE(ring.has_value());
+  EXPECT_TRUE(ring->is_valid());
+
+  io_uring_sqe* sqe = ring->get_sqe();
+  ASSERT_NE(sqe, nullptr);
+  sqe->opcode = IORING_OP_NOP;
+  sqe->user_data = io_uring_tag(7, 42);
+
+  auto completions = reap(*ring, 1);
+  ASSERT_EQ(completions.size(), 1u);
+  EXPECT_EQ(completions[0].res, 0);
+  EXPECT_EQ(io_uring_tag_kind(completions[0].user_data), 7);
+  EXPECT_EQ(io_uring_tag_payload(completions[0].user_data), 42u);
+}
+
+TEST(IoUringTest, FullSubmissionQueueIsSubmittedTransparently)
+{
+  if (!io_uring_available())
+  {
+    GTEST_SKIP() << "io_uring is not available on this kernel";
+  }
+
+  auto ring = IoUring::create(4);
+  ASSERT_TRUE(ring.has_value());
+
+  // Twice the queue size: get_sqe() flushes the first half itself
+  for (int i = 0; i < 8; ++i)
+  {
+    io_uring_sqe* sqe = ring->get_sqe();
+    ASSERT_NE(sqe, nullptr);
+    sqe->opcode = IORING_OP_NOP;
+  }
+  EXPECT_EQ(reap(*ring, 8).size(), 8u);
+}
+
+TEST(IoUringTest, MultishotReceiveFillsProvidedBuffers)
+{
+  if (!io_uring_available())
+  {
+    GTEST_SKIP() << "io_uring is not available on this kernel";
+  }
+
+  auto ring = IoUring::create(8);
+  ASSERT_TRUE(ring.has_value());
+  auto buffers = IoUringBufferRing::create(*ring, 3, 4, 256);
+  ASSERT_TRUE(buffers.has_value());
+  EXPECT_EQ(buffers->count(), 4u);
+
+  auto receiver = UdpSocket::create();
+  auto sender = UdpSocket::create();
+  ASSERT_TRUE(receiver.has_value());
+  ASSERT_TRUE(sender.has_value());
+  ASSERT_TRUE(receiver->bind("127.0.0.1", 0));
+  auto endpoint = receiver->bound_endpoint();
+  ASSERT_TRUE(endpoint.has_value());
+
+  io_uring_sqe* sqe = ring->get_sqe();
+  ASSERT_NE(sqe, nullptr);
+  sqe->opcode = IORING_OP_RECV;
+  sqe->fd = receiver->get_fd();
+  sqe->ioprio = IORING_RECV_MULTISHOT;
+  sqe->flags = IOSQE_BUFFER_SELECT;
+  sqe->buf_group = buffers->group();
+  ASSERT_TRUE(ring->submit());
+
+  for (uint8_t i = 0; i < 3; ++i)
+  {
+    ASSERT_TRUE(sender->send_to(std::vector<uint8_t>{ i, i, i }, *endpoint));
+  }
+
+  auto completions = reap(*ring, 3);
+  ASSERT_EQ(completions.size(), 3u);
+  std::vector<int> ids;
+  for (size_t i = 0; i < completions.size(); ++i)
+  {
+    const io_uring_cqe& cqe = completions[i];
+    ASSERT_EQ(cqe.res, 3);
+    EXPECT_NE(cqe.flags & IORING_CQE_F_MORE, 0u);  // Still armed
+
+    int id = IoUringBufferRing::buffer_id(cqe);
+    ASSERT_GE(id, 0);
+    EXPECT_EQ(buffers->buffer(static_cast<uint16_t>(id))[0], i);
+    ids.push_back(id);
+  }
+  EXPECT_NE(ids[0], ids[1]);
+  EXPECT_NE(ids[1], ids[2]);
+
+  // Returning the buffers keeps the receive going past the ring size
+  for (int id : ids)
+  {
+    buffers->hold(static_cast<uint16_t>(id));
+    buffers->release(static_cast<uint16_t>(id));
+  }
+  for (uint8_t i = 0; i < 3; ++i)
+  {
+    ASSERT_TRUE(sender->send_to(std::vector<uint8_t>{ i }, *endpoint));
+  }
+  EXPECT_EQ(reap(*ring, 3).size(), 3u);
+}
+
+TEST(IoUringTest, BufferRingRejectsBadSizes)
+{
+  if (!io_uring_available())
+  {
+    GTEST_SKIP() << "io_uring is not available on this kernel";
+  }
+
+  auto ring = IoUring::create(8);
+  ASSERT_TRUE(ring.has_value());
+  EXPECT_FALSE(IoUringBufferRing::create(*ring, 0, 3, 256).has_value());  // Not a power of 2
+  EXPECT_FALSE(IoUringBufferRing::create(*ring, 0, 0, 256).has_value());
+  EXPECT_FALSE(IoUringBufferRing::create(*ring, 0, 4, 0).has_value());
+}
+
+TEST(IoUringTest, SendSlotsAreBounded)
+{
+  IoUringSendSlots slots(2);
+  const uint8_t data[4] = { 1, 2, 3, 4 };
+  Endpoint destination("127.0.0.1", 9);
+
+  uint32_t first = slots.acquire(data, sizeof(data), destination, 5);
+  uint32_t second = slots.acquire(data, 2, destination, 6);
+  ASSERT_NE(first, IoUringSendSlots::NONE);
+  ASSERT_NE(second, IoUringSendSlots::NONE);
+  EXPECT_EQ(slots.acquire(data, 1, destination, 7), IoUringSendSlots::NONE);
+  EXPECT_EQ(slots.in_flight(), 2u);
+
+  EXPECT_EQ(slots[first].buffer_id, 5u);
+  EXPECT_EQ(slots[second].iov[0].iov_len, 2u);
+  EXPECT_EQ(slots[first].message.msg_name, slots[first].destination.as_sockaddr());
+
+  slots.release(first);
+  EXPECT_EQ(slots.in_flight(), 1u);
+  EXPECT_EQ(slots.acquire(data, 1, destination, 8), first);
+}
+
+TEST(IoUringTest, SendSlotsKeepTheirOwnSplice)
+{
+  IoUringSendSlots slots(1);
+  const uint8_t data[6] = { 1, 2, 3, 4, 5, 6 };
+
+  auto datagram = std::make_unique<OutboundDatagram>();
+  datagram->data = data;
+  datagram->size = sizeof(data);
+  datagram->destination = Endpoint("127.0.0.1", 9);
+  datagram->splice_at = 2;
+  datagram->splice_cut = 1;
+  datagram->splice_size = 2;
+  datagram->splice_bytes[0] = 0xaa;
+  datagram->splice_bytes[1] = 0xbb;
+
+  uint32_t index = slots.acquire(*datagram, 3);
+  ASSERT_NE(index, IoUringSendSlots::NONE);
+  datagram.reset();  // send_batch() entries are gone before the send completes
+
+  const IoUringSendSlot& slot = slots[index];
+  ASSERT_EQ(slot.message.msg_iovlen, 3u);
+  EXPECT_EQ(slot.iov[0].iov_len, 2u);
+  EXPECT_EQ(slot.iov[1].iov_base, slot.splice.data());
+  EXPECT_EQ(slot.splice[1], 0xbb);
+  EXPECT_EQ(slot.iov[2].iov_base, data + 3);
+  EXPECT_EQ(slot.iov[2].iov_len, 3u);
+}
+#endif  // PROJECT_HAVE_IO_URING
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,140 @@
+/**
+ * @file latency_histogram_test.cpp
+ * @brief Unit tests for latency histograms
+ */
+
+#include "project/latency_histogram.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+using namespace project;
+
+TEST(LatencyHistogramTest, SmallValuesHaveExactBuckets)
+{
+  for (uint64_t ticks = 0; ticks < 32; ++ticks)
+  {
+    EXPECT_EQ(latency_bucket_index(ticks), ticks);
+    EXPECT_EQ(latency_bucket_upper_bound(latency_bucket_index(ticks)), ticks);
+  }
+  EXPECT_EQ(latency_bucket_index(32), 32u);
+  EXPECT_EQ(latency_bucket_index(63), 63u);
+  EXPECT_EQ(latency_bucket_index(64), 64u);  // First bucket two ticks wide
+  EXPECT_EQ(latency_bucket_index(65), 64u);
+}
+
+TEST(LatencyHistogramTest, BucketsCoverTheRangeWithBoundedError)
+{
+  EXPECT_EQ(latency_bucket_index(~uint64_t{ 0 }), LATENCY_BUCKET_COUNT - 1);
+  EXPECT_EQ(latency_bucket_upper_bound(LATENCY_BUCKET_COUNT - 1), ~uint64_t{ 0 });
+
+  for (uint64_t ticks : { uint64_t{ 100 }, uint64_t{ 1000 }, uint64_t{ 123456 }, uint64_t{ 987654321 },
+                          uint64_t{ 1 } << 40 })
+  {
+    uint64_t upper = latency_bucket_upper_bound(latency_bucket_index(ticks));
+    EXPECT_GE(upper, ticks);
+    EXPECT_LE(static_cast<double>(upper - ticks), static_cast<double>(ticks) / 32.0);
+  }
+
+  // Indices are monotonic in the value
+  size_t previous = 0;
+  for (uint64_t ticks = 1; ticks < (uint64_t{ 1 } << 20); ticks = ticks * 3 / 2 + 1)
+  {
+    size_t index = latency_bucket_index(ticks);
+    EXPECT_GE(index, previous);
+    previous = index;
+  }
+}
+
+TEST(LatencyHistogramTest, Percentiles)
+{
+  LatencyHistogram histogram;
+  histogram.record(10, 90);
+  histogram.record(20, 9);
+  histogram.record(5000, 1);
+
+  LatencySnapshot snapshot = histogram.snapshot();
+  EXPECT_EQ(snapshot.count, 100u);
+  EXPECT_EQ(snapshot.percentile_ticks(50), 10u);
+  EXPECT_EQ(snapshot.percentile_ticks(90), 10u);
+  EXPECT_EQ(snapshot.percentile_ticks(99), 20u);
+  EXPECT_GE(snapshot.percentile_ticks(100), 5000u);
+  EXPECT_LE(snapshot.percentile_ticks(100), 5000u + 5000u / 32);
+}
+
+TEST(LatencyHistogramTest, EmptySnapshot)
+{
+  LatencySnapshot empty;
+  EXPECT_EQ(empty.percentile_ticks(99), 0u);
+
+  LatencySnapshot merged;
+  merged += empty;
+  EXPECT_TRUE(merged.counts.empty());
+  EXPECT_EQ(merged.count, 0u);
+}
+
+TEST(LatencyHistogramTest, SnapshotsMergeAcrossThreads)
+{
+  LatencyHistogram first;
+  LatencyHistogram second;
+
+  std::thread a([&first]() {
+    for (int i = 0; i < 1000; ++i)
+    {
+      first.record(100);
+    }
+  });
+  std::thread b([&second]() {
+    for (int i = 0; i < 1000; ++i)
+    {
+      second.record(10000);
+    }
+  });
+  a.join();
+  b.join();
+
+  LatencySnapshot merged;
+  merged += first.snapshot();
+  merged += second.snapshot();
+  EXPECT_EQ(merged.count, 2000u);
+  EXPECT_LE(merged.percentile_ticks(50), 103u);
+  EXPECT_GE(merged.percentile_ticks(51), 10000u);
+}
+
+TEST(LatencyHistogramTest, CopyTakesCurrentCounts)
+{
+  LatencyHistogram histogram;
+  histogram.record(42, 3);
+  LatencyHistogram copy(histogram);
+  EXPECT_EQ(copy.snapshot().count, 3u);
+}
+
+TEST(LatencyHistogramTest, ClockAdvancesAndConverts)
+{
+  uint64_t start = latency_clock_ticks();
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  uint64_t elapsed = latency_clock_ticks() - start;
+
+  double ns = static_cast<double>(elapsed) * latency_ns_per_tick();
+  EXPECT_GT(ns, 5e6);  // Coarse clocks may tick every few milliseconds
+  EXPECT_LT(ns, 5e9);
+}
+
+TEST(LatencyHistogramTest, PrometheusSummary)
+{
+  LatencyHistogram histogram;
+  histogram.record(0, 10);
+
+  std::string text = format_prometheus_latency("vswitch", { { "worker=\"0\"", histogram.snapshot() } });
+  EXPECT_NE(text.find("# TYPE vswitch_latency_seconds summary\n"), std::string::npos);
+  EXPECT_NE(text.find("vswitch_latency_seconds{worker=\"0\",quantile=\"0.99\"} 0.000000000\n"), std::string::npos);
+  EXPECT_NE(text.find("vswitch_latency_seconds_count{worker=\"0\"} 10\n"), std::string::npos);
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,208 @@
+/**
+ * @file load_generator_test.cpp
+ * @brief Unit tests for the RFC 2544 load generator, run against an in-process VSwitch
+ */
+
+#include "project/load_generator.hpp"
+#include "project/logger.hpp"
+#include "project/vswitch.hpp"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+using namespace project;
+
+namespace
+{
+  /**
+   * @brief Short trials so the whole file runs in a few seconds
+   */
+  LoadgenConfig quick_config(const Endpoint& vswitch)
+  {
+    LoadgenConfig config;
+    config.vswitch = vswitch;
+    config.ports = 4;
+    config.macs_per_port = 8;
+    config.max_rate = 2000.0;
+    config.trial_duration = std::chrono::milliseconds(100);
+    config.drain_time = std::chrono::milliseconds(100);
+    config.learning_time = std::chrono::milliseconds(50);
+    return config;
+  }
+
+  /**
+   * @brief A VSwitch running on its own thread for the lifetime of the fixture
+   */
+  class LoadGeneratorTest : public ::testing::Test
+  {
+  protected:
+    void SetUp() override
+    {
+      Logger::instance().set_level(LogLevel::Warn);
+
+      auto vswitch_result = VSwitch::create(0);
+      ASSERT_TRUE(vswitch_result.has_value());
+      vswitch_ = std::move(*vswitch_result);
+      switch_thread_ = std::thread([this]() { [[maybe_unused]] auto result = vswitch_.start(); });
+    }
+
+    void TearDown() override
+    {
+      vswitch_.stop();
+      if (switch_thread_.joinable())
+      {
+        switch_thread_.join();
+      }
+      Logger::instance().set_level(LogLevel::Info);
+    }
+
+    Endpoint endpoint() const
+    {
+      return Endpoint("127.0.0.1", vswitch_.port());
+    }
+
+    VSwitch vswitch_;
+    std::thread switch_thread_;
+  };
+}  // namespace
+
+TEST(LoadGeneratorConfigTest, RejectsInvalidConfigs)
+{
+  LoadgenConfig config = quick_config(Endpoint("127.0.0.1", 9));
+
+  config.ports = 3;
+  EXPECT_EQ(LoadGenerator::create(config).error(), LoadgenError::InvalidConfig);
+
+  config.ports = 2;
+  config.macs_per_port = 0;
+  EXPECT_EQ(LoadGenerator::create(config).error(), LoadgenError::InvalidConfig);
+
+  config.macs_per_port = 1;
+  config.vswitch = Endpoint();
+  EXPECT_EQ(LoadGenerator::create(config).error(), LoadgenError::InvalidConfig);
+
+  config.vswitch = Endpoint("127.0.0.1", 9);
+  config.bind_address = "not-an-address";
+  EXPECT_EQ(LoadGenerator::create(config).error(), LoadgenError::BindFailed);
+}
+
+TEST(LoadGeneratorConfigTest, RejectsOutOfRangeFrameSizes)
+{
+  auto generator = LoadGenerator::create(quick_config(Endpoint("127.0.0.1", 9)));
+  ASSERT_TRUE(generator.has_value());
+
+  EXPECT_EQ(generator->run_trial(LOADGEN_MIN_FRAME_SIZE - 1, 1000.0).error(), LoadgenError::InvalidFrameSize);
+  EXPECT_EQ(generator->run_trial(LOADGEN_MAX_FRAME_SIZE + 1, 1000.0).error(), LoadgenError::InvalidFrameSize);
+}
+
+TEST(LoadGeneratorConfigTest, EmulatedMacsAreDistinctAndUnicast)
+{
+  LoadgenConfig config = quick_config(Endpoint("127.0.0.1", 9));
+  config.ports = 2;
+  config.macs_per_port = 3;
+  auto generator = LoadGenerator::create(config);
+  ASSERT_TRUE(generator.has_value());
+
+  EXPECT_NE(generator->mac_address(0, 2), generator->mac_address(1, 0));
+  EXPECT_EQ(generator->mac_address(1, 0).to_u64(), generator->mac_address(0, 2).to_u64() + 1);
+  EXPECT_EQ(generator->mac_address(1, 2).bytes()[0] & 0x01, 0);  // Unicast, never flooded
+}
+
+TEST(LoadGeneratorConfigTest, TrialResultArithmetic)
+{
+  TrialResult trial;
+  EXPECT_FALSE(trial.passed(0.0));  // Nothing sent proves nothing
+
+  trial.frames_sent = 1000;
+  trial.frames_received = 990;
+  trial.send_time = std::chrono::milliseconds(500);
+  EXPECT_DOUBLE_EQ(trial.loss_ratio(), 0.01);
+  EXPECT_DOUBLE_EQ(trial.achieved_rate(), 2000.0);
+  EXPECT_FALSE(trial.passed(0.0));
+  EXPECT_TRUE(trial.passed(0.01));
+
+  BackToBackResult back_to_back;
+  EXPECT_EQ(back_to_back.mean(), 0.0);
+  back_to_back.bursts = { 100, 200 };
+  EXPECT_DOUBLE_EQ(back_to_back.mean(), 150.0);
+}
+
+TEST(LoadGeneratorConfigTest, NothingComesBackFromABlackHole)
+{
+  // A bound socket that never forwards anything
+  auto sink = UdpSocket::create();
+  ASSERT_TRUE(sink.has_value());
+  ASSERT_TRUE(sink->bind("127.0.0.1", 0));
+  auto sink_endpoint = sink->bound_endpoint();
+  ASSERT_TRUE(sink_endpoint.has_value());
+
+  auto generator = LoadGenerator::create(quick_config(*sink_endpoint));
+  ASSERT_TRUE(generator.has_value());
+
+  auto trial = generator->run_trial(64, 1000.0);
+  ASSERT_TRUE(trial.has_value());
+  EXPECT_GT(trial->frames_sent, 0u);
+  EXPECT_EQ(trial->frames_received, 0u);
+  EXPECT_DOUBLE_EQ(trial->loss_ratio(), 1.0);
+  EXPECT_FALSE(trial->passed(0.0));
+}
+
+TEST_F(LoadGeneratorTest, PacedTrialIsDeliveredToThePeerPorts)
+{
+  auto generator = LoadGenerator::create(quick_config(endpoint()));
+  ASSERT_TRUE(generator.has_value());
+
+  auto trial = generator->run_trial(128, 1000.0);
+  ASSERT_TRUE(trial.has_value());
+
+  // 100 ms at 1000 frames/s; the schedule may round up to one more batch
+  EXPECT_GE(trial->frames_sent, 90u);
+  EXPECT_LE(trial->frames_sent, 140u);
+  EXPECT_EQ(trial->frames_received, trial->frames_sent);
+  EXPECT_EQ(trial->frames_misdelivered, 0u);
+  EXPECT_EQ(trial->latency.count, trial->frames_received);
+  EXPECT_TRUE(trial->passed(0.0));
+  EXPECT_EQ(vswitch_.learned_macs(), 32u);
+}
+
+TEST_F(LoadGeneratorTest, BurstOfExactLength)
+{
+  auto generator = LoadGenerator::create(quick_config(endpoint()));
+  ASSERT_TRUE(generator.has_value());
+
+  auto trial = generator->run_trial(1518, 0.0, 50);
+  ASSERT_TRUE(trial.has_value());
+  EXPECT_EQ(trial->frames_sent, 50u);
+  EXPECT_EQ(trial->frames_received, 50u);
+}
+
+TEST_F(LoadGeneratorTest, FrameLossStopsAfterTwoCleanTrials)
+{
+  auto generator = LoadGenerator::create(quick_config(endpoint()));
+  ASSERT_TRUE(generator.has_value());
+
+  // 2000 frames/s is well within what the switch forwards on loopback
+  auto trials = generator->frame_loss(64);
+  ASSERT_TRUE(trials.has_value());
+  ASSERT_EQ(trials->size(), 2u);
+  EXPECT_DOUBLE_EQ((*trials)[0].offered_rate, 2000.0);
+  EXPECT_DOUBLE_EQ((*trials)[1].offered_rate, 1800.0);
+}
+
+TEST_F(LoadGeneratorTest, ThroughputPassesAtFullRate)
+{
+  auto generator = LoadGenerator::create(quick_config(endpoint()));
+  ASSERT_TRUE(generator.has_value());
+
+  auto trial = generator->throughput(256);
+  ASSERT_TRUE(trial.has_value());
+  EXPECT_TRUE(trial->passed(0.0));
+  EXPECT_DOUBLE_EQ(trial->offered_rate, 2000.0);
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,192 @@
+/**
+ * @file logger_test.cpp
+ * @brief Unit tests for the asynchronous logger
+ */
+
+#include "project/logger.hpp"
+
+#include <gtest/gtest.h>
+
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace project;
+
+namespace
+{
+  /**
+   * @brief Sink that records every message it is handed
+   */
+  struct CapturingSink
+  {
+    std::mutex mutex;
+    std::vector<std::pair<LogLevel, std::string>> messages;
+
+    LogSink sink()
+    {
+      return [this](LogLevel level, std::string_view message) {
+        std::lock_guard lock(mutex);
+        messages.emplace_back(level, std::string(message));
+      };
+    }
+
+    size_t size()
+    {
+      std::lock_guard lock(mutex);
+      return messages.size();
+    }
+  };
+}  // namespace
+
+TEST(LoggerTest, LevelNames)
+{
+  EXPECT_STREQ(to_string(LogLevel::Trace), "trace");
+  EXPECT_STREQ(to_string(LogLevel::Error), "error");
+  EXPECT_EQ(parse_log_level("debug"), LogLevel::Debug);
+  EXPECT_EQ(parse_log_level("off"), LogLevel::Off);
+  EXPECT_FALSE(parse_log_level("verbose").has_value());
+}
+
+TEST(LoggerTest, TraceIsCompiledOutByDefault)
+{
+  EXPECT_EQ(log_compiled_in(LogLevel::Trace), PROJECT_LOG_MIN_LEVEL == 0);
+  EXPECT_TRUE(log_compiled_in(LogLevel::Error));
+  EXPECT_FALSE(log_compiled_in(LogLevel::Off));
+  EXPECT_FALSE(Logger::instance().enabled(LogLevel::Trace));
+}
+
+TEST(LoggerTest, FormatsAndDeliversInOrder)
+{
+  CapturingSink capture;
+  {
+    Logger logger(16, capture.sink());
+    EXPECT_TRUE(logger.log(LogLevel::Info, "first %d", 1));
+    EXPECT_TRUE(logger.log(LogLevel::Error, "second %s", "two"));
+    logger.flush();
+
+    ASSERT_EQ(capture.size(), 2u);
+    EXPECT_EQ(capture.messages[0].first, LogLevel::Info);
+    EXPECT_EQ(capture.messages[0].second, "first 1");
+    EXPECT_EQ(capture.messages[1].first, LogLevel::Error);
+    EXPECT_EQ(capture.messages[1].second, "second two");
+  }
+}
+
+TEST(LoggerTest, RuntimeLevelFilters)
+{
+  Logger logger(16, [](LogLevel, std::string_view) {});
+  EXPECT_TRUE(logger.enabled(LogLevel::Info));
+  EXPECT_FALSE(logger.enabled(LogLevel::Debug));
+
+  logger.set_level(LogLevel::Warn);
+  EXPECT_EQ(logger.level(), LogLevel::Warn);
+  EXPECT_FALSE(logger.enabled(LogLevel::Info));
+  EXPECT_TRUE(logger.enabled(LogLevel::Error));
+
+  logger.set_level(LogLevel::Off);
+  EXPECT_FALSE(logger.enabled(LogLevel::Error));
+}
+
+TEST(LoggerTest, LongMessagesAreTruncated)
+{
+  CapturingSink capture;
+  Logger logger(16, capture.sink());
+
+  std::string long_text(LOG_MAX_MESSAGE_SIZE * 2, 'x');
+  logger.log(LogLevel::Info, "%s", long_text.c_str());
+  logger.flush();
+
+  ASSERT_EQ(capture.size(), 1u);
+  EXPECT_EQ(capture.messages[0].second.size(), LOG_MAX_MESSAGE_SIZE - 1);
+}
+
+TEST(LoggerTest, DropsWhenFullInsteadOfBlocking)
+{
+  std::mutex gate;
+  std::unique_lock hold(gate);
+  size_t delivered = 0;
+
+  // The sink blocks until the gate opens, so nothing is released while we log
+  Logger logger(4, [&](LogLevel, std::string_view) {
+    std::lock_guard wait(gate);
+    ++delivered;
+  });
+
+  size_t accepted = 0;
+  for (int i = 0; i < 64; ++i)
+  {
+    if (logger.log(LogLevel::Info, "message %d", i))
+    {
+      ++accepted;
+    }
+  }
+
+  EXPECT_EQ(accepted, 4u);  // The slot being drained is not released until the sink returns
+  EXPECT_EQ(logger.dropped(), 64u - accepted);
+
+  hold.unlock();
+  logger.flush();
+  EXPECT_EQ(delivered, accepted);
+}
+
+TEST(LoggerTest, ConcurrentProducersLoseNothingWhileNotFull)
+{
+  constexpr int THREADS = 4;
+  constexpr int PER_THREAD = 200;
+
+  CapturingSink capture;
+  {
+    Logger logger(THREADS * PER_THREAD, capture.sink());
+
+    std::vector<std::thread> producers;
+    for (int t = 0; t < THREADS; ++t)
+    {
+      producers.emplace_back([&logger, t]() {
+        for (int i = 0; i < PER_THREAD; ++i)
+        {
+          logger.log(LogLevel::Info, "thread %d message %d", t, i);
+        }
+      });
+    }
+    for (auto& producer : producers)
+    {
+      producer.join();
+    }
+
+    logger.flush();
+    EXPECT_EQ(logger.dropped(), 0u);
+  }
+
+  EXPECT_EQ(capture.size(), static_cast<size_t>(THREADS * PER_THREAD));
+}
+
+TEST(LoggerTest, DestructorDrainsPendingMessages)
+{
+  CapturingSink capture;
+  {
+    Logger logger(16, capture.sink());
+    logger.log(LogLevel::Warn, "pending");
+  }
+  ASSERT_EQ(capture.size(), 1u);
+  EXPECT_EQ(capture.messages[0].second, "pending");
+}
+
+TEST(LoggerTest, MacrosSkipDisabledLevels)
+{
+  int evaluated = 0;
+  auto count = [&evaluated]() { return ++evaluated; };
+
+  Logger::instance().set_level(LogLevel::Error);
+  PROJECT_LOG_INFO("not recorded %d", count());
+  PROJECT_LOG_TRACE("compiled out %d", count());
+  EXPECT_EQ(evaluated, 0);
+  Logger::instance().set_level(LogLevel::Info);
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
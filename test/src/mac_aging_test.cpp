@@ -0,0 +1,66 @@
+/**
+ * @file mac_aging_test.cpp
+ * @brief Unit tests for MAC aging helpers
+ */
+
+#include "project/mac_aging.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace project;
+
+TEST(MacAgingTest, EntryExpired)
+{
+  constexpr std::chrono::seconds AGING{ 300 };
+  EXPECT_FALSE(mac_entry_expired(1000, 1000, AGING));
+  EXPECT_FALSE(mac_entry_expired(1000, 1300, AGING));
+  EXPECT_TRUE(mac_entry_expired(1000, 1301, AGING));
+
+  // Unsigned difference survives the 32-bit wrap
+  EXPECT_FALSE(mac_entry_expired(0xffffff00u, 0x00000010u, AGING));
+  EXPECT_TRUE(mac_entry_expired(0xffffff00u, 0x00000100u, AGING));
+}
+
+TEST(MacAgingTest, TimestampIsMonotonic)
+{
+  MacTimestamp first = mac_timestamp_now();
+  MacTimestamp second = mac_timestamp_now();
+  MacTimestamp elapsed = second - first;
+  EXPECT_LE(elapsed, 1u);
+}
+
+TEST(MacAgingTest, SweeperRunsPeriodically)
+{
+  std::atomic<int> sweeps{ 0 };
+  AgingSweeper sweeper(std::chrono::milliseconds(5), [&sweeps]() { sweeps.fetch_add(1); });
+
+  for (int attempt = 0; attempt < 400 && sweeps.load() < 3; ++attempt)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  EXPECT_GE(sweeps.load(), 3);
+
+  sweeper.stop();
+  int after_stop = sweeps.load();
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_EQ(sweeps.load(), after_stop);
+}
+
+TEST(MacAgingTest, SweeperStopsWithoutWaitingForInterval)
+{
+  auto start = std::chrono::steady_clock::now();
+  {
+    AgingSweeper sweeper(std::chrono::hours(1), []() {});
+  }
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,133 @@
+/**
+ * @file mac_snapshot_test.cpp
+ * @brief Unit tests for MAC table snapshots
+ */
+
+#include "project/mac_snapshot.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace project;
+
+namespace
+{
+  const MacAddress MAC_A({ 0x02, 0x00, 0x00, 0x00, 0x00, 0x0a });
+  const MacAddress MAC_B({ 0x02, 0x00, 0x00, 0x00, 0x00, 0x0b });
+
+  std::string snapshot_path(const char* name)
+  {
+    return ::testing::TempDir() + "mac_snapshot_" + name + "_" + std::to_string(::getpid());
+  }
+}  // namespace
+
+TEST(MacSnapshotTest, EncodesCompactRecords)
+{
+  std::vector<LearnedMac> entries = { { 10, MAC_A, Endpoint("192.168.1.2", 5000), 95 },
+                                      { 0, MAC_B, Endpoint("fd00::2", 6000), 100 } };
+  auto snapshot = encode_mac_snapshot(entries, 100, 1'000'000);
+  ASSERT_EQ(snapshot.size(), MAC_SNAPSHOT_HEADER_SIZE + 2 * MAC_SNAPSHOT_RECORD_SIZE);
+
+  // Ten seconds later, at a coarse clock that restarted from 7
+  auto decoded = decode_mac_snapshot(snapshot.data(), snapshot.size(), 7, 1'000'010);
+  ASSERT_TRUE(decoded.has_value());
+  ASSERT_EQ(decoded->size(), 2u);
+  EXPECT_EQ((*decoded)[0].vlan, 10);
+  EXPECT_EQ((*decoded)[0].mac, MAC_A);
+  EXPECT_EQ((*decoded)[0].endpoint, Endpoint("192.168.1.2", 5000));
+  EXPECT_EQ(MacTimestamp{ 7 } - (*decoded)[0].last_seen, 15u);
+  EXPECT_EQ((*decoded)[1].endpoint, Endpoint("fd00::2", 6000));
+  EXPECT_EQ(MacTimestamp{ 7 } - (*decoded)[1].last_seen, 10u);
+}
+
+TEST(MacSnapshotTest, EncodesEntriesSeenAfterNowAsJustSeen)
+{
+  // Refreshed while the table was copied, a second after the snapshot's now
+  std::vector<LearnedMac> entries = { { 1, MAC_A, Endpoint("10.0.0.1", 5000), 101 } };
+  auto snapshot = encode_mac_snapshot(entries, 100, 1'000'000);
+
+  auto decoded = decode_mac_snapshot(snapshot.data(), snapshot.size(), 50, 1'000'000);
+  ASSERT_TRUE(decoded.has_value());
+  ASSERT_EQ(decoded->size(), 1u);
+  EXPECT_EQ((*decoded)[0].last_seen, 50u);
+  EXPECT_FALSE(mac_entry_expired((*decoded)[0].last_seen, 50, MAC_DEFAULT_AGING_TIME));
+}
+
+TEST(MacSnapshotTest, RejectsDamagedSnapshots)
+{
+  std::vector<LearnedMac> entries = { { 1, MAC_A, Endpoint("10.0.0.1", 5000), 0 } };
+  auto snapshot = encode_mac_snapshot(entries, 0, 0);
+
+  auto flipped = snapshot;
+  flipped[MAC_SNAPSHOT_HEADER_SIZE + 3] ^= 1;
+  EXPECT_FALSE(decode_mac_snapshot(flipped.data(), flipped.size(), 0, 0).has_value());
+
+  auto truncated = snapshot;
+  truncated.pop_back();
+  EXPECT_FALSE(decode_mac_snapshot(truncated.data(), truncated.size(), 0, 0).has_value());
+
+  auto wrong_magic = snapshot;
+  wrong_magic[0] = 'X';
+  auto result = decode_mac_snapshot(wrong_magic.data(), wrong_magic.size(), 0, 0);
+  ASSERT_FALSE(result.has_value());
+  EXPECT_EQ(result.error(), MacSnapshotError::BadFormat);
+}
+
+TEST(MacSnapshotTest, SavesAndLoadsTables)
+{
+  const std::string path = snapshot_path("round_trip");
+  const MacTimestamp now = mac_timestamp_now();
+
+  ConcurrentMacTable table;
+  table.insert(10, MAC_A, Endpoint("10.0.0.1", 5000), now);
+  table.insert(20, MAC_A, Endpoint("10.0.0.2", 5000), now);
+  table.insert(MAC_B, Endpoint("10.0.0.3", 5000), now - 400);  // Older than the aging time
+
+  auto saved = save_mac_snapshot(path, table);
+  ASSERT_TRUE(saved.has_value());
+  EXPECT_EQ(*saved, 3u);
+
+  ConcurrentMacTable restored;
+  auto loaded = load_mac_snapshot(path, restored, std::chrono::seconds(300));
+  ASSERT_TRUE(loaded.has_value());
+  EXPECT_EQ(*loaded, 2u);
+  EXPECT_EQ(restored.lookup(10, MAC_A), Endpoint("10.0.0.1", 5000));
+  EXPECT_EQ(restored.lookup(20, MAC_A), Endpoint("10.0.0.2", 5000));
+  EXPECT_FALSE(restored.lookup(MAC_B).has_value());
+
+  // Without aging every entry comes back
+  ConcurrentMacTable unaged;
+  EXPECT_EQ(load_mac_snapshot(path, unaged, std::chrono::seconds(0)).value_or(0), 3u);
+
+  std::remove(path.c_str());
+}
+
+TEST(MacSnapshotTest, ReportsMissingAndMalformedFiles)
+{
+  ConcurrentMacTable table;
+  auto missing = load_mac_snapshot(snapshot_path("missing"), table, std::chrono::seconds(300));
+  ASSERT_FALSE(missing.has_value());
+  EXPECT_EQ(missing.error(), MacSnapshotError::OpenFailed);
+
+  const std::string path = snapshot_path("garbage");
+  std::ofstream(path) << "not a snapshot, but long enough to have a header";
+  auto garbage = load_mac_snapshot(path, table, std::chrono::seconds(300));
+  ASSERT_FALSE(garbage.has_value());
+  EXPECT_EQ(garbage.error(), MacSnapshotError::BadFormat);
+  EXPECT_TRUE(table.empty());
+  std::remove(path.c_str());
+
+  EXPECT_FALSE(save_mac_snapshot("/nonexistent-directory/snapshot", table).has_value());
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
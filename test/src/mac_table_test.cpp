@@ -8,6 +8,7 @@
 #include <gtest/gtest.h>
 
 #include <array>
+#include <chrono>
 #include <thread>
 
 using namespace project;
@@ -238,6 +239,22 @@ TEST(MacTableTest, MoveSemantics)
   EXPECT_EQ(table3.size(), 2);
 }
 
+TEST(MacTableTest, Expire)
+{
+  MacTable table;
+  MacAddress mac1({0x00, 0x11, 0x22, 0x33, 0x44, 0x55});
+  MacAddress mac2({0x00, 0x11, 0x22, 0x33, 0x44, 0x66});
+
+  table.insert(mac1, Endpoint("192.168.1.1", 8080), 100);
+  table.insert(mac2, Endpoint("192.168.1.2", 8080), 100);
+  table.insert(mac2, Endpoint("192.168.1.2", 8080), 300);  // Refresh
+
+  EXPECT_EQ(table.expire(std::chrono::seconds(150), 300), 1);
+  EXPECT_FALSE(table.contains(mac1));
+  EXPECT_TRUE(table.contains(mac2));
+  EXPECT_EQ(table.size(), 1);
+}
+
 int main(int argc, char** argv)
 {
   ::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,234 @@
+/**
+ * @file multicast_snooping_test.cpp
+ * @brief Unit tests for IGMP/MLD snooping
+ */
+
+#include "project/multicast_snooping.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+using namespace project;
+
+namespace
+{
+  const MacAddress GROUP_A({ 0x01, 0x00, 0x5e, 0x01, 0x02, 0x03 });  // 239.1.2.3 (and 224.129.2.3)
+  const MacAddress GROUP_B({ 0x01, 0x00, 0x5e, 0x0a, 0x00, 0x01 });
+
+  std::vector<uint8_t> ethernet_header(uint16_t ethertype, uint16_t vlan = 0)
+  {
+    std::vector<uint8_t> frame = { 0x01, 0x00, 0x5e, 0x00, 0x00, 0x16, 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 };
+    if (vlan != 0)
+    {
+      frame.insert(frame.end(), { 0x81, 0x00, static_cast<uint8_t>(vlan >> 8), static_cast<uint8_t>(vlan) });
+    }
+    frame.push_back(static_cast<uint8_t>(ethertype >> 8));
+    frame.push_back(static_cast<uint8_t>(ethertype));
+    return frame;
+  }
+
+  /**
+   * @brief An IPv4 packet with a router alert option, padded out like a minimum-size frame
+   */
+  std::vector<uint8_t> igmp_frame(const std::vector<uint8_t>& igmp, uint16_t vlan = 0, uint16_t fragment = 0)
+  {
+    std::vector<uint8_t> frame = ethernet_header(EtherType::IPv4, vlan);
+    const size_t total = 24 + igmp.size();
+    frame.insert(frame.end(), { 0x46, 0xc0, static_cast<uint8_t>(total >> 8), static_cast<uint8_t>(total), 0, 0,
+                                static_cast<uint8_t>(fragment >> 8), static_cast<uint8_t>(fragment), 1, 2, 0, 0,
+                                10, 0, 0, 1, 224, 0, 0, 22, 0x94, 0x04, 0, 0 });
+    frame.insert(frame.end(), igmp.begin(), igmp.end());
+    frame.resize(std::max<size_t>(frame.size(), 60), 0);
+    return frame;
+  }
+
+  /**
+   * @brief An IPv6 packet with a hop-by-hop header (router alert), as MLD requires
+   */
+  std::vector<uint8_t> mld_frame(const std::vector<uint8_t>& mld)
+  {
+    std::vector<uint8_t> frame = ethernet_header(EtherType::IPv6);
+    const size_t payload = 8 + mld.size();
+    frame.insert(frame.end(), { 0x60, 0, 0, 0, static_cast<uint8_t>(payload >> 8), static_cast<uint8_t>(payload), 0, 1 });
+    frame.insert(frame.end(), 32, 0);  // Addresses
+    frame.insert(frame.end(), { 58, 0, 0x05, 0x02, 0, 0, 0x01, 0x00 });
+    frame.insert(frame.end(), mld.begin(), mld.end());
+    return frame;
+  }
+
+  std::vector<uint8_t> ipv6_group(uint8_t b12, uint8_t b13, uint8_t b14, uint8_t b15)
+  {
+    return { 0xff, 0x0e, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, b12, b13, b14, b15 };
+  }
+
+  SnoopingMessage parse(const std::vector<uint8_t>& frame)
+  {
+    SnoopingMessage message;
+    parse_snooping_message(frame.data(), frame.size(), message);
+    return message;
+  }
+}  // namespace
+
+TEST(MulticastSnoopingTest, ParsesIgmpV2ReportsAndLeaves)
+{
+  auto report = parse(igmp_frame({ 0x16, 0, 0, 0, 239, 1, 2, 3 }));
+  EXPECT_EQ(report.kind, SnoopingKind::Report);
+  ASSERT_EQ(report.groups.size(), 1u);
+  EXPECT_EQ(report.groups[0].group, GROUP_A);
+  EXPECT_TRUE(report.groups[0].join);
+
+  auto leave = parse(igmp_frame({ 0x17, 0, 0, 0, 239, 1, 2, 3 }, 10));
+  EXPECT_EQ(leave.kind, SnoopingKind::Report);
+  ASSERT_EQ(leave.groups.size(), 1u);
+  EXPECT_FALSE(leave.groups[0].join);
+
+  EXPECT_EQ(parse(igmp_frame({ 0x11, 100, 0, 0, 0, 0, 0, 0 })).kind, SnoopingKind::Query);
+}
+
+TEST(MulticastSnoopingTest, ParsesIgmpV3Records)
+{
+  // EXCLUDE{} joins, TO_INCLUDE{} leaves, ALLOW with a source joins, BLOCK and 224.0.0.251 are skipped
+  auto message = parse(igmp_frame({ 0x22, 0, 0, 0, 0, 0, 0, 5,     //
+                                    2, 0, 0, 0, 239, 1, 2, 3,       //
+                                    3, 0, 0, 0, 239, 10, 0, 1,      //
+                                    5, 0, 0, 1, 239, 9, 9, 9, 10, 0, 0, 7,  //
+                                    6, 0, 0, 1, 239, 8, 8, 8, 10, 0, 0, 7,  //
+                                    4, 0, 0, 0, 224, 0, 0, 251 }));
+  EXPECT_EQ(message.kind, SnoopingKind::Report);
+  ASSERT_EQ(message.groups.size(), 3u);
+  EXPECT_EQ(message.groups[0].group, GROUP_A);
+  EXPECT_TRUE(message.groups[0].join);
+  EXPECT_EQ(message.groups[1].group, GROUP_B);
+  EXPECT_FALSE(message.groups[1].join);
+  EXPECT_EQ(message.groups[2].group, MacAddress({ 0x01, 0x00, 0x5e, 0x09, 0x09, 0x09 }));
+  EXPECT_TRUE(message.groups[2].join);
+}
+
+TEST(MulticastSnoopingTest, ParsesMldBehindHopByHop)
+{
+  std::vector<uint8_t> v1 = { 131, 0, 0, 0, 0, 0, 0, 0 };
+  auto group = ipv6_group(0x80, 0, 0, 0x42);
+  v1.insert(v1.end(), group.begin(), group.end());
+  auto report = parse(mld_frame(v1));
+  EXPECT_EQ(report.kind, SnoopingKind::Report);
+  ASSERT_EQ(report.groups.size(), 1u);
+  EXPECT_EQ(report.groups[0].group, MacAddress({ 0x33, 0x33, 0x80, 0x00, 0x00, 0x42 }));
+  EXPECT_TRUE(report.groups[0].join);
+
+  v1[0] = 132;
+  auto done = parse(mld_frame(v1));
+  ASSERT_EQ(done.groups.size(), 1u);
+  EXPECT_FALSE(done.groups[0].join);
+
+  std::vector<uint8_t> v2 = { 143, 0, 0, 0, 0, 0, 0, 1, 4, 0, 0, 0 };
+  v2.insert(v2.end(), group.begin(), group.end());
+  auto v2_report = parse(mld_frame(v2));
+  ASSERT_EQ(v2_report.groups.size(), 1u);
+  EXPECT_TRUE(v2_report.groups[0].join);
+
+  std::vector<uint8_t> query(24, 0);
+  query[0] = 130;
+  EXPECT_EQ(parse(mld_frame(query)).kind, SnoopingKind::Query);
+}
+
+TEST(MulticastSnoopingTest, IgnoresOtherTraffic)
+{
+  SnoopingMessage message;
+  auto udp = igmp_frame({ 0x16, 0, 0, 0, 239, 1, 2, 3 });
+  udp[23] = 17;  // Protocol: UDP
+  EXPECT_FALSE(parse_snooping_message(udp.data(), udp.size(), message));
+
+  auto fragment = igmp_frame({ 0x16, 0, 0, 0, 239, 1, 2, 3 }, 0, 0x2000);
+  EXPECT_FALSE(parse_snooping_message(fragment.data(), fragment.size(), message));
+
+  std::vector<uint8_t> neighbor_solicitation(24, 0);
+  neighbor_solicitation[0] = 135;
+  auto ns = mld_frame(neighbor_solicitation);
+  EXPECT_FALSE(parse_snooping_message(ns.data(), ns.size(), message));
+  EXPECT_FALSE(parse_snooping_message(ns.data(), 20, message));
+}
+
+TEST(MulticastSnoopingTest, LinkLocalGroupsAreAlwaysFlooded)
+{
+  EXPECT_TRUE(multicast_always_flooded(MacAddress({ 0x01, 0x00, 0x5e, 0x00, 0x00, 0xfb })));  // mDNS
+  EXPECT_TRUE(multicast_always_flooded(MacAddress({ 0x33, 0x33, 0x00, 0x00, 0x00, 0x01 })));  // All nodes
+  EXPECT_FALSE(multicast_always_flooded(GROUP_A));
+  EXPECT_FALSE(multicast_always_flooded(MacAddress({ 0x33, 0x33, 0xff, 0x00, 0x00, 0x01 })));  // Solicited node
+
+  // Reports for them are not recorded
+  EXPECT_TRUE(parse(igmp_frame({ 0x16, 0, 0, 0, 224, 0, 0, 251 })).groups.empty());
+}
+
+TEST(MulticastGroupTableTest, JoinLeaveAndExpire)
+{
+  MulticastGroupTable table(std::chrono::seconds(10));
+  const Endpoint a("10.0.0.1", 5000);
+  const Endpoint b("10.0.0.2", 5000);
+  std::vector<Endpoint> members;
+
+  EXPECT_FALSE(table.members(1, GROUP_A, members));
+  EXPECT_TRUE(members.empty());
+
+  uint64_t generation = table.generation();
+  EXPECT_TRUE(table.join(1, GROUP_A, a, 100));
+  EXPECT_TRUE(table.join(1, GROUP_A, b, 100));
+  EXPECT_NE(table.generation(), generation);
+
+  // Refreshing does not disturb the caches
+  generation = table.generation();
+  EXPECT_FALSE(table.join(1, GROUP_A, a, 105));
+  EXPECT_EQ(table.generation(), generation);
+
+  EXPECT_TRUE(table.members(1, GROUP_A, members));
+  EXPECT_EQ(members.size(), 2u);
+  EXPECT_FALSE(table.members(2, GROUP_A, members));  // Other VLAN
+  EXPECT_EQ(table.group_count(), 1u);
+
+  // b leaves and lapses after the leave latency; a lapses after the membership time
+  EXPECT_TRUE(table.leave(1, GROUP_A, b, 106));
+  EXPECT_EQ(table.expire(107), 0u);
+  EXPECT_EQ(table.expire(109), 1u);
+  ASSERT_TRUE(table.members(1, GROUP_A, members));
+  EXPECT_EQ(members, std::vector<Endpoint>{ a });
+
+  EXPECT_EQ(table.expire(116), 1u);
+  EXPECT_FALSE(table.members(1, GROUP_A, members));
+  EXPECT_EQ(table.group_count(), 0u);
+}
+
+TEST(MulticastGroupTableTest, RouterPortsGetEveryGroup)
+{
+  MulticastGroupTable table(std::chrono::seconds(10));
+  const Endpoint host("10.0.0.1", 5000);
+  const Endpoint router("10.0.0.254", 5000);
+  std::vector<Endpoint> members;
+
+  EXPECT_TRUE(table.add_router(1, router, 100));
+  EXPECT_FALSE(table.add_router(1, router, 101));
+
+  EXPECT_FALSE(table.members(1, GROUP_B, members));
+  EXPECT_EQ(members, std::vector<Endpoint>{ router });
+
+  // A router that also subscribed is listed once
+  table.join(1, GROUP_A, router, 101);
+  table.join(1, GROUP_A, host, 101);
+  EXPECT_TRUE(table.members(1, GROUP_A, members));
+  EXPECT_EQ(members.size(), 2u);
+
+  table.routers(1, members);
+  EXPECT_EQ(members, std::vector<Endpoint>{ router });
+  table.routers(2, members);
+  EXPECT_TRUE(members.empty());
+
+  EXPECT_EQ(table.expire(112), 3u);
+  table.routers(1, members);
+  EXPECT_TRUE(members.empty());
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
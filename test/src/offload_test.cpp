@@ -0,0 +1,232 @@
+/**
+ * @file offload_test.cpp
+ * @brief Unit tests for the segmentation and checksum offload helpers
+ */
+
+#include "project/offload.hpp"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using namespace project;
+
+namespace
+{
+  constexpr size_t L3 = 14;
+  constexpr size_t IPV4_L4 = L3 + 20;
+  constexpr size_t IPV6_L4 = L3 + 40;
+  constexpr size_t TCP_HEADER = 20;
+
+  uint16_t read16(const uint8_t* data)
+  {
+    return static_cast<uint16_t>((data[0] << 8) | data[1]);
+  }
+
+  uint32_t read32(const uint8_t* data)
+  {
+    return (uint32_t{ data[0] } << 24) | (uint32_t{ data[1] } << 16) | (uint32_t{ data[2] } << 8) | data[3];
+  }
+
+  void write16(uint8_t* data, size_t value)
+  {
+    data[0] = static_cast<uint8_t>(value >> 8);
+    data[1] = static_cast<uint8_t>(value);
+  }
+
+  uint32_t sum16(const uint8_t* data, size_t size, uint32_t sum = 0)
+  {
+    for (size_t i = 0; i + 1 < size; i += 2)
+    {
+      sum += read16(data + i);
+    }
+    if ((size & 1) != 0)
+    {
+      sum += uint32_t{ data[size - 1] } << 8;
+    }
+    return sum;
+  }
+
+  uint16_t fold(uint32_t sum)
+  {
+    while ((sum >> 16) != 0)
+    {
+      sum = (sum & 0xffff) + (sum >> 16);
+    }
+    return static_cast<uint16_t>(sum);
+  }
+
+  /**
+   * @brief Whether the TCP checksum of a frame verifies (the folded sum is all ones)
+   */
+  bool tcp_checksum_ok(const uint8_t* frame, size_t size, bool ipv4)
+  {
+    const size_t l4 = ipv4 ? IPV4_L4 : IPV6_L4;
+    uint32_t sum = ipv4 ? sum16(frame + L3 + 12, 8) : sum16(frame + L3 + 8, 32);
+    sum += 6 + static_cast<uint32_t>(size - l4);
+    return fold(sum16(frame + l4, size - l4, sum)) == 0xffff;
+  }
+
+  /**
+   * @brief A TCP frame as a GSO-capable stack hands it over, with only the pseudo-header summed
+   */
+  std::vector<uint8_t> make_tcp_frame(bool ipv4, size_t payload, uint8_t flags)
+  {
+    const size_t l4 = ipv4 ? IPV4_L4 : IPV6_L4;
+    std::vector<uint8_t> frame(l4 + TCP_HEADER + payload, 0);
+    write16(&frame[12], ipv4 ? 0x0800 : 0x86DD);
+    if (ipv4)
+    {
+      frame[L3] = 0x45;
+      write16(&frame[L3 + 4], 0x1234);  // Identification
+      frame[L3 + 8] = 64;
+      frame[L3 + 9] = 6;
+      const uint8_t addresses[8] = { 10, 0, 0, 1, 10, 0, 0, 2 };
+      std::copy(addresses, addresses + 8, &frame[L3 + 12]);
+    }
+    else
+    {
+      frame[L3] = 0x60;
+      frame[L3 + 6] = 6;
+      frame[L3 + 7] = 64;
+      frame[L3 + 8] = 0xfd;
+      frame[L3 + 39] = 2;
+    }
+
+    uint8_t* tcp = &frame[l4];
+    write16(tcp, 40000);
+    write16(tcp + 2, 80);
+    tcp[4] = 0x10;  // Sequence 0x10000000
+    tcp[12] = 5 << 4;
+    tcp[13] = flags;
+    for (size_t i = 0; i < payload; ++i)
+    {
+      frame[l4 + TCP_HEADER + i] = static_cast<uint8_t>(i);
+    }
+
+    const uint32_t pseudo = (ipv4 ? sum16(&frame[L3 + 12], 8) : sum16(&frame[L3 + 8], 32)) + 6 +
+                            static_cast<uint32_t>(TCP_HEADER + payload);
+    write16(tcp + 16, fold(pseudo));
+    return frame;
+  }
+
+  VnetHeader gso_header(uint8_t gso_type, uint16_t gso_size, bool ipv4)
+  {
+    VnetHeader header;
+    header.flags = VNET_HDR_F_NEEDS_CSUM;
+    header.gso_type = gso_type;
+    header.gso_size = gso_size;
+    header.csum_start = static_cast<uint16_t>(ipv4 ? IPV4_L4 : IPV6_L4);
+    header.csum_offset = 16;
+    return header;
+  }
+}  // namespace
+
+TEST(OffloadTest, CompletesAPartialChecksum)
+{
+  auto frame = make_tcp_frame(true, 101, 0x18);
+  EXPECT_FALSE(tcp_checksum_ok(frame.data(), frame.size(), true));
+
+  VnetHeader header = gso_header(VNET_HDR_GSO_NONE, 0, true);
+  ASSERT_TRUE(complete_checksum(header, frame.data(), frame.size()));
+  EXPECT_TRUE(tcp_checksum_ok(frame.data(), frame.size(), true));
+
+  // Nothing to do without NEEDS_CSUM; offsets past the end are refused
+  auto untouched = frame;
+  EXPECT_TRUE(complete_checksum(VnetHeader(), untouched.data(), untouched.size()));
+  EXPECT_EQ(untouched, frame);
+  header.csum_offset = static_cast<uint16_t>(frame.size());
+  EXPECT_EQ(complete_checksum(header, frame.data(), frame.size()).error(), OffloadError::Truncated);
+}
+
+TEST(OffloadTest, SegmentsTcpv4SuperFrame)
+{
+  auto frame = make_tcp_frame(true, 2500, 0x19 | 0x80);  // FIN, PSH, ACK and CWR
+  std::vector<uint8_t> out(OFFLOAD_BUFFER_SIZE);
+
+  auto result = segment_frame(gso_header(VNET_HDR_GSO_TCPV4 | VNET_HDR_GSO_ECN, 1000, true), frame.data(),
+                              frame.size(), out.data(), out.size());
+  ASSERT_TRUE(result.has_value()) << to_string(result.error());
+  EXPECT_EQ(result->segments, 3u);
+  EXPECT_EQ(result->segment_size, IPV4_L4 + TCP_HEADER + 1000);
+  EXPECT_EQ(result->size, 3 * (IPV4_L4 + TCP_HEADER) + 2500);
+
+  size_t offset = 0;
+  for (size_t i = 0; i < result->segments; ++i)
+  {
+    const uint8_t* segment = &out[offset];
+    const size_t payload = i < 2 ? 1000 : 500;
+    const size_t size = IPV4_L4 + TCP_HEADER + payload;
+
+    EXPECT_EQ(read16(segment + L3 + 2), size - L3);
+    EXPECT_EQ(read16(segment + L3 + 4), 0x1234 + i);
+    EXPECT_EQ(fold(sum16(segment + L3, 20)), 0xffff);  // IPv4 header checksum
+    EXPECT_EQ(read32(segment + IPV4_L4 + 4), 0x10000000u + i * 1000);
+    EXPECT_TRUE(tcp_checksum_ok(segment, size, true)) << "segment " << i;
+    EXPECT_EQ(segment[IPV4_L4 + TCP_HEADER], static_cast<uint8_t>(i * 1000));
+
+    const uint8_t flags = segment[IPV4_L4 + 13];
+    EXPECT_EQ((flags & 0x09) != 0, i == 2);  // FIN and PSH on the last segment only
+    EXPECT_EQ((flags & 0x80) != 0, i == 0);  // CWR on the first only
+    EXPECT_NE(flags & 0x10, 0);
+    offset += size;
+  }
+}
+
+TEST(OffloadTest, SegmentsTcpv6SuperFrame)
+{
+  auto frame = make_tcp_frame(false, 3000, 0x10);
+  std::vector<uint8_t> out(OFFLOAD_BUFFER_SIZE);
+
+  auto result =
+      segment_frame(gso_header(VNET_HDR_GSO_TCPV6, 1440, false), frame.data(), frame.size(), out.data(), out.size());
+  ASSERT_TRUE(result.has_value());
+  ASSERT_EQ(result->segments, 3u);
+
+  const size_t last = 2 * result->segment_size;
+  EXPECT_EQ(read16(&out[L3 + 4]), TCP_HEADER + 1440);
+  EXPECT_EQ(read16(&out[last + L3 + 4]), TCP_HEADER + 120);
+  EXPECT_TRUE(tcp_checksum_ok(&out[0], result->segment_size, false));
+  EXPECT_TRUE(tcp_checksum_ok(&out[last], result->size - last, false));
+}
+
+TEST(OffloadTest, SmallFrameComesOutWhole)
+{
+  auto frame = make_tcp_frame(true, 100, 0x18);
+  std::vector<uint8_t> out(OFFLOAD_BUFFER_SIZE);
+
+  auto result =
+      segment_frame(gso_header(VNET_HDR_GSO_TCPV4, 1448, true), frame.data(), frame.size(), out.data(), out.size());
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(result->segments, 1u);
+  EXPECT_EQ(result->size, frame.size());
+  EXPECT_EQ(result->segment_size, frame.size());
+  EXPECT_TRUE(tcp_checksum_ok(out.data(), result->size, true));
+}
+
+TEST(OffloadTest, RejectsWhatItCannotSegment)
+{
+  auto frame = make_tcp_frame(true, 3000, 0x10);
+  std::vector<uint8_t> out(OFFLOAD_BUFFER_SIZE);
+
+  EXPECT_EQ(segment_frame(gso_header(3, 1000, true), frame.data(), frame.size(), out.data(), out.size()).error(),
+            OffloadError::UnsupportedGso);  // UDP fragmentation offload
+  EXPECT_EQ(
+      segment_frame(gso_header(VNET_HDR_GSO_TCPV6, 1000, true), frame.data(), frame.size(), out.data(), out.size())
+          .error(),
+      OffloadError::UnsupportedGso);  // Not an IPv6 frame
+  EXPECT_EQ(segment_frame(gso_header(VNET_HDR_GSO_TCPV4, 1000, true), frame.data(), 40, out.data(), out.size())
+                .error(),
+            OffloadError::Truncated);
+  EXPECT_EQ(segment_frame(gso_header(VNET_HDR_GSO_TCPV4, 1000, true), frame.data(), frame.size(), out.data(),
+                          frame.size())
+                .error(),
+            OffloadError::BufferTooSmall);
+  EXPECT_STREQ(to_string(OffloadError::UnsupportedGso), "Unsupported GSO frame");
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
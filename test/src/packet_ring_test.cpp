@@ -0,0 +1,174 @@
+/**
+ * @file packet_ring_test.cpp
+ * @brief Unit tests for the TPACKET_V3 underlay rings
+ */
+
+#include "project/packet_ring.hpp"
+
+#include "project/udp_socket.hpp"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using namespace project;
+
+namespace
+{
+  constexpr std::chrono::milliseconds SHORT{ 500 };
+
+  /**
+   * @brief A UDP socket on loopback with a ring attached, or nothing without CAP_NET_RAW
+   */
+  struct RingSocket
+  {
+    UdpSocket socket;
+    Endpoint bound;
+    bool attached = false;
+    PacketRingError error = PacketRingError::Unsupported;
+  };
+
+  RingSocket ring_socket()
+  {
+    RingSocket result;
+    auto socket = UdpSocket::create();
+    EXPECT_TRUE(socket.has_value());
+    EXPECT_TRUE(socket->bind("127.0.0.1", 0).has_value());
+    EXPECT_TRUE(socket->set_receive_timeout(SHORT).has_value());
+    result.socket = std::move(*socket);
+    result.bound = *result.socket.bound_endpoint();
+
+    auto ring = PacketRing::create("lo", result.bound, FRAME_BUFFER_SIZE);
+    if (!ring)
+    {
+      result.error = ring.error();
+      return result;
+    }
+    EXPECT_TRUE(result.socket.attach_packet_ring(std::move(*ring)).has_value());
+    result.attached = result.socket.packet_ring_attached();
+    return result;
+  }
+}  // namespace
+
+TEST(PacketRingTest, ErrorStrings)
+{
+  EXPECT_STREQ(to_string(PacketRingError::Unsupported), "Packet rings are not supported on this platform");
+  EXPECT_STRNE(to_string(PacketRingError::InterfaceNotFound), "");
+  EXPECT_STRNE(to_string(PacketRingError::FanoutFailed), "");
+}
+
+TEST(PacketRingTest, RejectsUnusableSetups)
+{
+  // IPv6 is not handled, and the port must be known
+  EXPECT_FALSE(PacketRing::create("lo", Endpoint("::1", 9), FRAME_BUFFER_SIZE).has_value());
+  EXPECT_FALSE(PacketRing::create("lo", Endpoint(), FRAME_BUFFER_SIZE).has_value());
+  auto missing = PacketRing::create("no-such-if0", Endpoint("127.0.0.1", 9), FRAME_BUFFER_SIZE);
+  ASSERT_FALSE(missing.has_value());
+  EXPECT_NE(missing.error(), PacketRingError::SocketFailed);
+
+  auto ring = PacketRing::create("lo", Endpoint("127.0.0.1", 9), FRAME_BUFFER_SIZE);
+  if (!ring)
+  {
+    GTEST_SKIP() << "No packet ring: " << to_string(ring.error());
+  }
+  UdpSocket closed;
+  EXPECT_FALSE(closed.attach_packet_ring(std::move(*ring)).has_value());
+}
+
+TEST(PacketRingTest, ReceivesAndAnswersThroughTheRing)
+{
+  RingSocket ring = ring_socket();
+  if (!ring.attached)
+  {
+    GTEST_SKIP() << "No packet ring: " << to_string(ring.error);
+  }
+
+  // Frames for 127.0.0.1 injected on lo are martians to the IP layer, so the peer reads its own ring too
+  RingSocket peer = ring_socket();
+  ASSERT_TRUE(peer.attached);
+
+  const std::vector<uint8_t> hello = { 'h', 'e', 'l', 'l', 'o' };
+  ASSERT_TRUE(peer.socket.send_to(hello, ring.bound).has_value());
+
+  std::vector<uint8_t> buffer(FRAME_BUFFER_SIZE);
+  std::vector<InboundDatagram> slots(2);
+  slots[0].data = buffer.data();
+  slots[0].capacity = buffer.size();
+  auto received = ring.socket.receive_batch(slots.data(), 1);
+  ASSERT_TRUE(received.has_value());
+  ASSERT_EQ(*received, 1u);
+  EXPECT_EQ(std::vector<uint8_t>(buffer.data(), buffer.data() + slots[0].size), hello);
+  EXPECT_EQ(slots[0].sender, peer.bound);
+  EXPECT_FALSE(slots[0].truncated);
+
+  // Nothing else arrived: a timed-out wait, as with recvmmsg()
+  auto idle = ring.socket.receive_batch(slots.data(), 1);
+  ASSERT_FALSE(idle.has_value());
+  EXPECT_EQ(idle.error(), UdpError::ReceiveFailed);
+
+  // The peer was heard from, so the answer is written into the send ring
+  const std::vector<uint8_t> reply = { 'w', 'o', 'r', 'l', 'd' };
+  std::vector<OutboundDatagram> batch(2);
+  batch[0].data = reply.data();
+  batch[0].size = reply.size();
+  batch[0].destination = peer.bound;
+  batch[1] = batch[0];
+  auto sent = ring.socket.send_batch(batch);
+  ASSERT_TRUE(sent.has_value());
+  EXPECT_EQ(*sent, 2u);
+
+  std::vector<uint8_t> second(FRAME_BUFFER_SIZE);
+  slots[1].data = second.data();
+  slots[1].capacity = second.size();
+  size_t answers = 0;
+  while (answers < 2)
+  {
+    auto answer = peer.socket.receive_batch(slots.data() + answers, 2 - answers);
+    ASSERT_TRUE(answer.has_value());
+    answers += *answer;
+  }
+  for (const auto& slot : slots)
+  {
+    EXPECT_EQ(std::vector<uint8_t>(slot.data, slot.data + slot.size), reply);
+    EXPECT_EQ(slot.sender, ring.bound);
+  }
+}
+
+TEST(PacketRingTest, SendsToUnknownPeersThroughTheSocket)
+{
+  RingSocket ring = ring_socket();
+  if (!ring.attached)
+  {
+    GTEST_SKIP() << "No packet ring: " << to_string(ring.error);
+  }
+
+  auto stranger = UdpSocket::create();
+  ASSERT_TRUE(stranger.has_value());
+  ASSERT_TRUE(stranger->bind("127.0.0.1", 0).has_value());
+  ASSERT_TRUE(stranger->set_receive_timeout(SHORT).has_value());
+
+  // No datagram from the stranger yet, so no next hop for it: the socket sends instead
+  const std::vector<uint8_t> payload(600, 0x5a);
+  auto sent = ring.socket.send_to(payload, *stranger->bound_endpoint());
+  ASSERT_TRUE(sent.has_value());
+  std::vector<OutboundDatagram> batch(1);
+  batch[0].data = payload.data();
+  batch[0].size = payload.size();
+  batch[0].destination = *stranger->bound_endpoint();
+  auto batched = ring.socket.send_batch(batch);
+  ASSERT_TRUE(batched.has_value());
+  EXPECT_EQ(*batched, 1u);
+
+  for (int copy = 0; copy < 2; ++copy)
+  {
+    auto received = stranger->receive_from(FRAME_BUFFER_SIZE);
+    ASSERT_TRUE(received.has_value());
+    EXPECT_EQ(received->first, payload);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
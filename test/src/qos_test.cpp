@@ -0,0 +1,173 @@
+/**
+ * @file qos_test.cpp
+ * @brief Unit tests for ingress policing and egress scheduling
+ */
+
+#include "project/qos.hpp"
+
+#include "project/ethernet_frame.hpp"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using namespace project;
+
+namespace
+{
+  constexpr uint64_t MS = 1'000'000;
+
+  std::vector<uint8_t> ipv4_frame(uint8_t tos, size_t size = 60)
+  {
+    std::vector<uint8_t> frame(size, 0);
+    frame[12] = 0x08;
+    frame[14] = 0x45;
+    frame[15] = tos;
+    return frame;
+  }
+}  // namespace
+
+TEST(QosTest, ReadsPriorityFromTagOrDscp)
+{
+  std::vector<uint8_t> tagged(64, 0);
+  tagged[12] = 0x81;
+  tagged[14] = 0xa0;  // PCP 5, VID 10
+  tagged[15] = 0x0a;
+  EXPECT_EQ(frame_priority(tagged.data(), tagged.size()), 5);
+
+  auto ef = ipv4_frame(46 << 2);
+  EXPECT_EQ(frame_priority(ef.data(), ef.size()), 5);
+  auto cs1 = ipv4_frame(8 << 2);
+  EXPECT_EQ(frame_priority(cs1.data(), cs1.size()), 1);
+
+  std::vector<uint8_t> ipv6(60, 0);
+  ipv6[12] = 0x86;
+  ipv6[13] = 0xdd;
+  ipv6[14] = 0x6c;  // Traffic class 0xc0: CS6
+  EXPECT_EQ(frame_priority(ipv6.data(), ipv6.size()), 6);
+
+  std::vector<uint8_t> arp(60, 0);
+  arp[12] = 0x08;
+  arp[13] = 0x06;
+  EXPECT_EQ(frame_priority(arp.data(), arp.size()), 0);
+  EXPECT_EQ(frame_priority(arp.data(), 10), 0);
+
+  // Background ranks below best effort
+  EXPECT_LT(priority_class(1), priority_class(0));
+  EXPECT_EQ(priority_class(0), priority_class(3));
+  EXPECT_EQ(priority_class(7), QOS_CLASS_COUNT - 1);
+}
+
+TEST(QosTest, PolicerEnforcesRateAndBurst)
+{
+  IngressPolicer policer(100'000, 3000);  // 100 kB/s, 3000 byte bursts
+  const Endpoint noisy("10.0.0.1", 5000);
+  const Endpoint quiet("10.0.0.2", 5000);
+  EXPECT_TRUE(policer.enabled());
+
+  EXPECT_TRUE(policer.admit(noisy, 1500, 0));
+  EXPECT_TRUE(policer.admit(noisy, 1500, 0));
+  EXPECT_FALSE(policer.admit(noisy, 1500, 0));
+
+  // Every endpoint has its own bucket
+  EXPECT_TRUE(policer.admit(quiet, 1500, 0));
+
+  // 10 ms refill 1000 bytes, 15 ms 1500
+  EXPECT_FALSE(policer.admit(noisy, 1500, 10 * MS));
+  EXPECT_TRUE(policer.admit(noisy, 1500, 15 * MS));
+
+  // Idle refills up to the burst only
+  EXPECT_TRUE(policer.admit(noisy, 3000, 10'000 * MS));
+  EXPECT_FALSE(policer.admit(noisy, 1, 10'000 * MS));
+
+  IngressPolicer off;
+  EXPECT_FALSE(off.enabled());
+  EXPECT_TRUE(off.admit(noisy, 65'000, 0));
+}
+
+TEST(QosTest, PolicerRecyclesLeastRecentlySeenPorts)
+{
+  IngressPolicer policer(1000, 1000, 4);  // One set
+  const Endpoint first("10.0.0.1", 1);
+  EXPECT_TRUE(policer.admit(first, 1000, 0));
+  EXPECT_FALSE(policer.admit(first, 1000, 0));
+
+  for (uint16_t port = 2; port <= 5; ++port)
+  {
+    EXPECT_TRUE(policer.admit(Endpoint("10.0.0.1", port), 1000, port));
+  }
+
+  // The first endpoint was evicted and starts over with a full bucket
+  EXPECT_TRUE(policer.admit(first, 1000, 6));
+}
+
+TEST(QosTest, SchedulerInterleavesClassesByWeight)
+{
+  std::vector<std::vector<uint8_t>> bulk;
+  for (int i = 0; i < 20; ++i)
+  {
+    bulk.push_back(ipv4_frame(0, 1514));
+  }
+  auto voice = ipv4_frame(46 << 2, 200);
+  const Endpoint destination("10.0.0.9", 9);
+
+  std::vector<OutboundDatagram> batch;
+  for (const auto& frame : bulk)
+  {
+    batch.push_back({ frame.data(), frame.size(), destination });
+  }
+  batch.push_back({ voice.data(), voice.size(), destination });
+  batch.push_back({ voice.data(), voice.size(), Endpoint("10.0.0.10", 9) });
+
+  EgressScheduler scheduler;
+  scheduler.schedule(batch);
+  ASSERT_EQ(batch.size(), 22u);
+
+  // Both copies of the high-priority frame go first, then bulk keeps its order
+  EXPECT_EQ(batch[0].data, voice.data());
+  EXPECT_EQ(batch[1].data, voice.data());
+  EXPECT_EQ(batch[1].destination, Endpoint("10.0.0.10", 9));
+  for (size_t i = 0; i < bulk.size(); ++i)
+  {
+    EXPECT_EQ(batch[2 + i].data, bulk[i].data());
+  }
+}
+
+TEST(QosTest, SchedulerDoesNotStarveLowClasses)
+{
+  std::vector<std::vector<uint8_t>> frames;
+  for (int i = 0; i < 40; ++i)
+  {
+    frames.push_back(ipv4_frame(i < 20 ? 0xe0 : 0x20, 1000));  // Network control, then background
+  }
+  const Endpoint destination("10.0.0.9", 9);
+  std::vector<OutboundDatagram> batch;
+  for (const auto& frame : frames)
+  {
+    batch.push_back({ frame.data(), frame.size(), destination });
+  }
+
+  EgressScheduler scheduler;
+  scheduler.schedule(batch);
+
+  // Weight 8 against 1: a background frame gets out after every dozen or so control frames
+  size_t first_background = 0;
+  while (first_background < batch.size() && batch[first_background].data[15] != 0x20)
+  {
+    ++first_background;
+  }
+  EXPECT_LT(first_background, 20u);
+
+  // Single-class batches are left as they are
+  std::vector<OutboundDatagram> single = { { frames[0].data(), frames[0].size(), destination },
+                                           { frames[1].data(), frames[1].size(), destination } };
+  scheduler.schedule(single);
+  EXPECT_EQ(single[0].data, frames[0].data());
+  EXPECT_EQ(single[1].data, frames[1].data());
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,202 @@
+/**
+ * @file socket_handoff_test.cpp
+ * @brief Unit tests for socket handoff between processes
+ */
+
+#include "project/socket_handoff.hpp"
+
+#include "project/udp_socket.hpp"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include <linux/filter.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace project;
+
+namespace
+{
+  constexpr std::chrono::milliseconds SHORT{ 200 };
+
+  std::string listener_path(const char* name)
+  {
+    return ::testing::TempDir() + "handoff_" + name + "_" + std::to_string(::getpid());
+  }
+
+  bool exists(const std::string& path)
+  {
+    struct stat info{};
+    return ::stat(path.c_str(), &info) == 0;
+  }
+
+  struct Channel
+  {
+    SocketHandle predecessor;
+    SocketHandle successor;
+  };
+
+  Channel channel()
+  {
+    int fds[2];
+    EXPECT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    return { SocketHandle(fds[0]), SocketHandle(fds[1]) };
+  }
+}  // namespace
+
+TEST(SocketHandoffTest, PassesBoundSocketsAndState)
+{
+  auto original = UdpSocket::create();
+  ASSERT_TRUE(original.has_value());
+  ASSERT_TRUE(original->bind("127.0.0.1", 0).has_value());
+  const Endpoint bound = *original->bound_endpoint();
+
+  Channel ends = channel();
+  const std::vector<uint8_t> state = { 1, 2, 3, 4, 5 };
+  ASSERT_TRUE(send_handoff(ends.predecessor.get(), { original->get_fd() }, state).has_value());
+
+  auto handoff = receive_handoff(ends.successor.get(), SHORT);
+  ASSERT_TRUE(handoff.has_value());
+  ASSERT_EQ(handoff->sockets.size(), 1u);
+  EXPECT_EQ(handoff->state, state);
+
+  auto adopted = UdpSocket::adopt(std::move(handoff->sockets[0]));
+  ASSERT_TRUE(adopted.has_value());
+  EXPECT_EQ(adopted->local_endpoint(), bound);
+  ASSERT_TRUE(adopted->set_receive_timeout(SHORT).has_value());
+
+  // The same kernel socket: the copy receives what is sent to the original's port
+  auto sender = UdpSocket::create();
+  ASSERT_TRUE(sender.has_value());
+  ASSERT_TRUE(sender->send_to(std::vector<uint8_t>{ 42 }, bound).has_value());
+  original->close();
+  auto received = adopted->receive_from(16);
+  ASSERT_TRUE(received.has_value());
+  EXPECT_EQ(received->first, std::vector<uint8_t>{ 42 });
+
+  ASSERT_TRUE(send_handoff_ack(ends.successor.get()).has_value());
+  EXPECT_TRUE(wait_handoff_ack(ends.predecessor.get(), SHORT).has_value());
+}
+
+TEST(SocketHandoffTest, KeepsAPacketRingsFilterUntilDetached)
+{
+  auto original = UdpSocket::create();
+  ASSERT_TRUE(original.has_value());
+  ASSERT_TRUE(original->bind("127.0.0.1", 0).has_value());
+  const Endpoint bound = *original->bound_endpoint();
+
+  // The drop-all filter a predecessor's packet ring puts on its socket
+  struct sock_filter drop = BPF_STMT(BPF_RET | BPF_K, 0);
+  struct sock_fprog filter{};
+  filter.len = 1;
+  filter.filter = &drop;
+  ASSERT_EQ(::setsockopt(original->get_fd(), SOL_SOCKET, SO_ATTACH_FILTER, &filter, sizeof(filter)), 0);
+
+  auto adopted = UdpSocket::adopt(SocketHandle(::dup(original->get_fd())));
+  ASSERT_TRUE(adopted.has_value());
+  ASSERT_TRUE(adopted->set_receive_timeout(SHORT).has_value());
+  auto sender = UdpSocket::create();
+  ASSERT_TRUE(sender.has_value());
+
+  // Adopting leaves it in place while the predecessor may still read its ring
+  ASSERT_TRUE(sender->send_to(std::vector<uint8_t>{ 1 }, bound).has_value());
+  EXPECT_FALSE(adopted->receive_from(16).has_value());
+
+  ASSERT_TRUE(adopted->detach_socket_filter().has_value());
+  ASSERT_TRUE(sender->send_to(std::vector<uint8_t>{ 2 }, bound).has_value());
+  auto received = adopted->receive_from(16);
+  ASSERT_TRUE(received.has_value());
+  EXPECT_EQ(received->first, std::vector<uint8_t>{ 2 });
+  EXPECT_TRUE(adopted->detach_socket_filter().has_value());  // Nothing left to detach
+}
+
+TEST(SocketHandoffTest, RejectsMalformedMessages)
+{
+  Channel garbage = channel();
+  const char text[] = "definitely not a handoff header";
+  ASSERT_EQ(::write(garbage.predecessor.get(), text, sizeof(text)), static_cast<ssize_t>(sizeof(text)));
+  auto bad = receive_handoff(garbage.successor.get(), SHORT);
+  ASSERT_FALSE(bad.has_value());
+  EXPECT_EQ(bad.error(), HandoffError::BadMessage);
+
+  // The connection closing before a (further) handoff arrives
+  Channel truncated = channel();
+  ASSERT_TRUE(send_handoff(truncated.predecessor.get(), {}, {}).has_value());
+  truncated.predecessor.close();
+  auto empty = receive_handoff(truncated.successor.get(), SHORT);
+  ASSERT_TRUE(empty.has_value());
+  EXPECT_TRUE(empty->sockets.empty());
+  auto closed = receive_handoff(truncated.successor.get(), SHORT);
+  ASSERT_FALSE(closed.has_value());
+  EXPECT_EQ(closed.error(), HandoffError::ReceiveFailed);
+
+  // A successor that never acknowledges
+  Channel silent = channel();
+  auto ack = wait_handoff_ack(silent.predecessor.get(), std::chrono::milliseconds(20));
+  ASSERT_FALSE(ack.has_value());
+  EXPECT_EQ(ack.error(), HandoffError::Timeout);
+
+  std::vector<int> too_many(HANDOFF_MAX_SOCKETS + 1, silent.predecessor.get());
+  auto sent = send_handoff(silent.predecessor.get(), too_many, {});
+  ASSERT_FALSE(sent.has_value());
+  EXPECT_EQ(sent.error(), HandoffError::TooManySockets);
+
+  // Only bound UDP sockets can be adopted
+  EXPECT_FALSE(UdpSocket::adopt(std::move(silent.successor)).has_value());
+  auto unbound = UdpSocket::create();
+  ASSERT_TRUE(unbound.has_value());
+  EXPECT_FALSE(UdpSocket::adopt(SocketHandle(::dup(unbound->get_fd()))).has_value());
+}
+
+TEST(SocketHandoffTest, ListenerAcceptsSuccessors)
+{
+  const std::string path = listener_path("listener");
+  EXPECT_FALSE(connect_handoff(path).has_value());
+
+  {
+    auto listener = HandoffListener::create(path);
+    ASSERT_TRUE(listener.has_value());
+    EXPECT_TRUE(exists(path));
+
+    auto idle = listener->accept(std::chrono::milliseconds(10));
+    ASSERT_FALSE(idle.has_value());
+    EXPECT_EQ(idle.error(), HandoffError::Timeout);
+
+    auto client = connect_handoff(path);
+    ASSERT_TRUE(client.has_value());
+    auto server = listener->accept(SHORT);
+    ASSERT_TRUE(server.has_value());
+    ASSERT_TRUE(send_handoff(server->get(), {}, { 7 }).has_value());
+    auto handoff = receive_handoff(client->get(), SHORT);
+    ASSERT_TRUE(handoff.has_value());
+    EXPECT_EQ(handoff->state, std::vector<uint8_t>{ 7 });
+  }
+  EXPECT_FALSE(exists(path));
+}
+
+TEST(SocketHandoffTest, SuccessorListenerOutlivesPredecessor)
+{
+  const std::string path = listener_path("successor");
+  auto predecessor = HandoffListener::create(path);
+  ASSERT_TRUE(predecessor.has_value());
+
+  // The successor binds the same path before the predecessor has exited
+  auto successor = HandoffListener::create(path);
+  ASSERT_TRUE(successor.has_value());
+  *predecessor = HandoffListener();
+  EXPECT_TRUE(exists(path));
+
+  auto client = connect_handoff(path);
+  ASSERT_TRUE(client.has_value());
+  EXPECT_TRUE(successor->accept(SHORT).has_value());
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
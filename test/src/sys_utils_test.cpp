@@ -8,6 +8,7 @@
 #include <gtest/gtest.h>
 
 #include <fcntl.h>
+#include <sys/mman.h>
 #include <unistd.h>
 
 using namespace project;
@@ -224,6 +225,32 @@ TEST(SocketHandleTest, Reset)
   ::close(pipe_fds2[1]);
 }
 
+TEST(MemoryMappingTest, AnonymousMappingIsZeroedAndMovable)
+{
+  MemoryMapping mapping = MemoryMapping::anonymous(8192);
+  ASSERT_TRUE(mapping.is_valid());
+  EXPECT_EQ(mapping.size(), 8192u);
+
+  auto* bytes = static_cast<uint8_t*>(mapping.data());
+  EXPECT_EQ(bytes[0], 0);
+  bytes[8191] = 0x5a;
+
+  MemoryMapping moved(std::move(mapping));
+  EXPECT_FALSE(mapping.is_valid());
+  EXPECT_EQ(static_cast<uint8_t*>(moved.data())[8191], 0x5a);
+
+  moved.unmap();
+  EXPECT_FALSE(moved.is_valid());
+  EXPECT_EQ(moved.size(), 0u);
+}
+
+TEST(MemoryMappingTest, FailedMmapIsEmpty)
+{
+  MemoryMapping mapping(MAP_FAILED, 4096);
+  EXPECT_FALSE(static_cast<bool>(mapping));
+  EXPECT_EQ(mapping.size(), 0u);
+}
+
 TEST(SystemExceptionTest, Construction)
 {
   SystemException ex("Test error", 42);
@@ -159,6 +159,60 @@ TEST(TapDeviceTest, ErrorToString)
   EXPECT_STREQ(to_string(TapError::WriteFailed), "Failed to write to TAP device");
   EXPECT_STREQ(to_string(TapError::InvalidDevice), "Invalid TAP device");
   EXPECT_STREQ(to_string(TapError::PartialWrite), "Partial write to TAP device");
+  EXPECT_STREQ(to_string(TapError::InvalidQueueCount), "Invalid number of TAP queues");
+}
+
+TEST(TapDeviceTest, OffloadsCarryAVnetHeader)
+{
+  TapDevice plain;
+  EXPECT_FALSE(plain.offloads_enabled());
+
+  auto result = TapDevice::create("", true);
+  if (!result)
+  {
+    GTEST_SKIP() << "Offload TAP creation failed (expected without root): " << to_string(result.error());
+  }
+  EXPECT_TRUE(result->offloads_enabled());
+
+  // The header is reset even when nothing could be read
+  ASSERT_TRUE(result->set_nonblocking(true).has_value());
+  FramePool pool(1, OFFLOAD_BUFFER_SIZE);
+  FrameBuffer buffer = pool.acquire();
+  VnetHeader header;
+  header.gso_type = VNET_HDR_GSO_TCPV4;
+  EXPECT_EQ(result->read_frame(buffer, header).error(), TapError::WouldBlock);
+  EXPECT_EQ(header.gso_type, VNET_HDR_GSO_NONE);
+}
+
+TEST(TapDeviceTest, MultiQueueRejectsBadQueueCounts)
+{
+  EXPECT_EQ(TapDevice::create_multi_queue("", 0).error(), TapError::InvalidQueueCount);
+  EXPECT_EQ(TapDevice::create_multi_queue("", TAP_MAX_QUEUES + 1).error(), TapError::InvalidQueueCount);
+}
+
+TEST(TapDeviceTest, MultiQueueSharesOneInterface)
+{
+  auto result = TapDevice::create_multi_queue("", 4);
+  if (!result)
+  {
+    GTEST_SKIP() << "Multi-queue TAP creation failed (expected without root): " << to_string(result.error());
+  }
+
+  ASSERT_EQ(result->size(), 4u);
+  const std::string& name = result->front().device_name();
+  EXPECT_FALSE(name.empty());
+  for (size_t i = 0; i < result->size(); ++i)
+  {
+    EXPECT_TRUE((*result)[i].is_valid());
+    EXPECT_EQ((*result)[i].device_name(), name);
+    if (i > 0)
+    {
+      EXPECT_NE((*result)[i].get_fd(), (*result)[i - 1].get_fd());
+    }
+  }
+
+  // A single-queue device cannot take the name while the queues hold it
+  EXPECT_FALSE(TapDevice::create(name).has_value());
 }
 
 TEST(TapDeviceTest, CheckRootPrivileges)
@@ -0,0 +1,128 @@
+/**
+ * @file traffic_stats_test.cpp
+ * @brief Unit tests for traffic counters and their Prometheus export
+ */
+
+#include "project/traffic_stats.hpp"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+using namespace project;
+
+TEST(TrafficStatsTest, CountersFillWholeCacheLines)
+{
+  EXPECT_EQ(alignof(TrafficCounters), 64u);
+  EXPECT_EQ(sizeof(TrafficCounters), 128u);
+
+  // Adjacent per-thread blocks never share a line
+  std::vector<TrafficCounters> per_thread(2);
+  auto first = reinterpret_cast<uintptr_t>(&per_thread[0]);
+  auto second = reinterpret_cast<uintptr_t>(&per_thread[1]);
+  EXPECT_EQ(first % 64, 0u);
+  EXPECT_EQ(second - first, sizeof(TrafficCounters));
+}
+
+TEST(TrafficStatsTest, AddAndSnapshot)
+{
+  TrafficCounters counters;
+  TrafficCounters::add(counters.rx_frames, 1);
+  TrafficCounters::add(counters.rx_bytes, 60);
+  TrafficCounters::add(counters.rx_frames, 1);
+  TrafficCounters::add(counters.rx_bytes, 1514);
+  TrafficCounters::add(counters.tap_partial_writes, 1);
+
+  TrafficStats stats = counters.snapshot();
+  EXPECT_EQ(stats.rx_frames, 2u);
+  EXPECT_EQ(stats.rx_bytes, 1574u);
+  EXPECT_EQ(stats.tx_frames, 0u);
+  EXPECT_EQ(stats.tap_partial_writes, 1u);
+}
+
+TEST(TrafficStatsTest, CopyTakesCurrentValues)
+{
+  TrafficCounters counters;
+  TrafficCounters::add(counters.floods, 7);
+
+  TrafficCounters copy(counters);
+  EXPECT_EQ(copy.snapshot().floods, 7u);
+
+  TrafficCounters assigned;
+  assigned = counters;
+  EXPECT_EQ(assigned.snapshot().floods, 7u);
+}
+
+TEST(TrafficStatsTest, SnapshotsMerge)
+{
+  TrafficStats a;
+  a.rx_frames = 3;
+  a.send_errors = 1;
+  TrafficStats b;
+  b.rx_frames = 4;
+  b.unknown_unicast_drops = 2;
+
+  a += b;
+  EXPECT_EQ(a.rx_frames, 7u);
+  EXPECT_EQ(a.send_errors, 1u);
+  EXPECT_EQ(a.unknown_unicast_drops, 2u);
+}
+
+TEST(TrafficStatsTest, ReadersSeeSingleWriterProgress)
+{
+  constexpr uint64_t FRAMES = 100000;
+  TrafficCounters counters;
+
+  std::thread writer([&counters]() {
+    for (uint64_t i = 0; i < FRAMES; ++i)
+    {
+      TrafficCounters::add(counters.rx_frames, 1);
+    }
+  });
+
+  // Concurrent snapshots are monotonic and never exceed the final value
+  uint64_t last = 0;
+  for (int i = 0; i < 1000; ++i)
+  {
+    uint64_t now = counters.snapshot().rx_frames;
+    EXPECT_GE(now, last);
+    EXPECT_LE(now, FRAMES);
+    last = now;
+  }
+
+  writer.join();
+  EXPECT_EQ(counters.snapshot().rx_frames, FRAMES);
+}
+
+TEST(TrafficStatsTest, PrometheusFormat)
+{
+  TrafficStats worker0;
+  worker0.rx_frames = 5;
+  TrafficStats worker1;
+  worker1.rx_frames = 6;
+
+  std::string text = format_prometheus("vswitch", { { "worker=\"0\"", worker0 }, { "worker=\"1\"", worker1 } });
+
+  EXPECT_NE(text.find("# TYPE vswitch_rx_frames_total counter\n"), std::string::npos);
+  EXPECT_NE(text.find("vswitch_rx_frames_total{worker=\"0\"} 5\n"), std::string::npos);
+  EXPECT_NE(text.find("vswitch_rx_frames_total{worker=\"1\"} 6\n"), std::string::npos);
+  EXPECT_NE(text.find("vswitch_tap_partial_writes_total{worker=\"1\"} 0\n"), std::string::npos);
+
+  // The TYPE line of a family precedes its samples
+  EXPECT_LT(text.find("# TYPE vswitch_tx_bytes_total"), text.find("vswitch_tx_bytes_total{"));
+}
+
+TEST(TrafficStatsTest, PrometheusWithoutLabels)
+{
+  TrafficStats stats;
+  stats.tx_bytes = 42;
+  std::string text = format_prometheus("vport", { { "", stats } });
+  EXPECT_NE(text.find("\nvport_tx_bytes_total 42\n"), std::string::npos);
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
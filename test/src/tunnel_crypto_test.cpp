@@ -0,0 +1,291 @@
+/**
+ * @file tunnel_crypto_test.cpp
+ * @brief Unit tests for tunnel encryption
+ */
+
+#include "project/tunnel_crypto.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace project;
+
+namespace
+{
+  const char KEYS[] =
+      "# VPort keys\n"
+      "1 000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f\n"
+      "\n"
+      "  7\tFFEEDDCCBBAA99887766554433221100ffeeddccbbaa99887766554433221100  \r\n";
+
+  std::vector<TunnelKey> test_keys()
+  {
+    auto keys = parse_tunnel_keys(KEYS);
+    EXPECT_TRUE(keys.has_value());
+    return keys ? *keys : std::vector<TunnelKey>();
+  }
+
+  /**
+   * @brief Both ends of a tunnel, or nothing when built without OpenSSL
+   */
+  struct Tunnel
+  {
+    std::unique_ptr<TunnelKeyring> port;
+    std::unique_ptr<TunnelKeyring> vswitch;
+  };
+
+  Tunnel tunnel(TunnelCipher cipher)
+  {
+    Tunnel result;
+    auto port = TunnelKeyring::create(cipher, TunnelRole::Port, test_keys());
+    auto vswitch = TunnelKeyring::create(cipher, TunnelRole::Switch, test_keys());
+    if (port && vswitch)
+    {
+      result.port = std::move(*port);
+      result.vswitch = std::move(*vswitch);
+    }
+    return result;
+  }
+
+  std::vector<uint8_t> seal(TunnelContext& context, uint32_t key_id, const std::vector<uint8_t>& frame)
+  {
+    std::vector<uint8_t> datagram(frame.size() + TUNNEL_OVERHEAD);
+    struct iovec piece = { const_cast<uint8_t*>(frame.data()), frame.size() };
+    auto sealed = context.seal(key_id, &piece, 1, datagram.data(), datagram.size());
+    EXPECT_TRUE(sealed.has_value());
+    EXPECT_EQ(sealed.value_or(0), datagram.size());
+    return datagram;
+  }
+}  // namespace
+
+TEST(TunnelCryptoTest, ParsesKeyFiles)
+{
+  auto keys = parse_tunnel_keys(KEYS);
+  ASSERT_TRUE(keys.has_value());
+  ASSERT_EQ(keys->size(), 2u);
+  EXPECT_EQ((*keys)[0].id, 1u);
+  EXPECT_EQ((*keys)[0].secret[0], 0x00);
+  EXPECT_EQ((*keys)[0].secret[31], 0x1f);
+  EXPECT_EQ((*keys)[1].id, 7u);
+  EXPECT_EQ((*keys)[1].secret[0], 0xff);
+  EXPECT_EQ((*keys)[1].secret[31], 0x00);
+
+  EXPECT_EQ(parse_tunnel_keys("1 0011").error(), TunnelError::InvalidKey);
+  EXPECT_EQ(parse_tunnel_keys("0 000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f").error(),
+            TunnelError::InvalidKey);
+  EXPECT_EQ(parse_tunnel_keys("x 000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f").error(),
+            TunnelError::InvalidKey);
+  EXPECT_EQ(parse_tunnel_keys("1 000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1g").error(),
+            TunnelError::InvalidKey);
+  EXPECT_EQ(parse_tunnel_keys(std::string(KEYS) + "1 " + std::string(64, 'a') + "\n").error(),
+            TunnelError::DuplicateKey);
+  EXPECT_TRUE(parse_tunnel_keys("# nothing here\n")->empty());
+
+  const std::string path = ::testing::TempDir() + "tunnel_keys_" + std::to_string(::getpid());
+  EXPECT_EQ(load_tunnel_keys(path).error(), TunnelError::KeyFileFailed);
+  FILE* file = std::fopen(path.c_str(), "w");
+  ASSERT_NE(file, nullptr);
+  std::fputs(KEYS, file);
+  std::fclose(file);
+  auto loaded = load_tunnel_keys(path);
+  ::unlink(path.c_str());
+  ASSERT_TRUE(loaded.has_value());
+  EXPECT_EQ(loaded->size(), 2u);
+
+  EXPECT_EQ(parse_tunnel_cipher("chacha20-poly1305"), TunnelCipher::ChaCha20Poly1305);
+  EXPECT_STREQ(to_string(*parse_tunnel_cipher("aes-256-gcm")), "aes-256-gcm");
+  EXPECT_FALSE(parse_tunnel_cipher("rot13").has_value());
+}
+
+TEST(TunnelCryptoTest, ReplayWindowAcceptsEachSequenceOnce)
+{
+  ReplayWindow window;
+  EXPECT_TRUE(window.accept(0));
+  EXPECT_FALSE(window.accept(0));
+  EXPECT_TRUE(window.accept(5));
+  EXPECT_TRUE(window.accept(3));  // Late, but within the window
+  EXPECT_FALSE(window.accept(3));
+  EXPECT_TRUE(window.accept(4));
+
+  EXPECT_TRUE(window.accept(5 + TUNNEL_REPLAY_WINDOW));
+  EXPECT_FALSE(window.accept(5));  // Fell behind
+  EXPECT_TRUE(window.accept(4 + TUNNEL_REPLAY_WINDOW));
+  EXPECT_TRUE(window.accept(10'000));
+  EXPECT_FALSE(window.accept(10'000));
+  EXPECT_TRUE(window.accept(10'000 - TUNNEL_REPLAY_WINDOW + 1));
+  EXPECT_FALSE(window.accept(10'000 - TUNNEL_REPLAY_WINDOW));
+}
+
+TEST(TunnelCryptoTest, SealsAndOpensBothWays)
+{
+  for (TunnelCipher cipher : { TunnelCipher::Aes256Gcm, TunnelCipher::ChaCha20Poly1305 })
+  {
+    Tunnel ends = tunnel(cipher);
+    if (!ends.port)
+    {
+      GTEST_SKIP() << "Built without OpenSSL";
+    }
+    TunnelContext port(*ends.port);
+    TunnelContext vswitch(*ends.vswitch);
+
+    const std::vector<uint8_t> frame(60, 0xab);
+    std::vector<uint8_t> datagram = seal(port, 7, frame);
+    EXPECT_NE(std::memcmp(datagram.data() + TUNNEL_HEADER_SIZE, frame.data(), frame.size()), 0);
+
+    auto opened = vswitch.open(datagram.data(), datagram.size());
+    ASSERT_TRUE(opened.has_value()) << to_string(cipher);
+    EXPECT_EQ(opened->key_id, 7u);
+    EXPECT_EQ(opened->data, datagram.data() + TUNNEL_HEADER_SIZE);
+    EXPECT_EQ(std::vector<uint8_t>(opened->data, opened->data + opened->size), frame);
+
+    // Each direction has its own keys: a datagram cannot be reflected back at its sender
+    std::vector<uint8_t> reflected = seal(port, 7, frame);
+    EXPECT_EQ(port.open(reflected.data(), reflected.size()).error(), TunnelError::AuthenticationFailed);
+
+    std::vector<uint8_t> answer = seal(vswitch, 1, frame);
+    auto received = port.open(answer.data(), answer.size());
+    ASSERT_TRUE(received.has_value());
+    EXPECT_EQ(received->key_id, 1u);
+  }
+}
+
+TEST(TunnelCryptoTest, SealsInPlace)
+{
+  Tunnel ends = tunnel(TunnelCipher::Aes256Gcm);
+  if (!ends.port)
+  {
+    GTEST_SKIP() << "Built without OpenSSL";
+  }
+  TunnelContext port(*ends.port);
+  TunnelContext vswitch(*ends.vswitch);
+
+  // The frame sits behind headroom for the header, and the tag goes behind it
+  std::vector<uint8_t> buffer(TUNNEL_OVERHEAD + 100);
+  for (size_t i = 0; i < 100; ++i)
+  {
+    buffer[TUNNEL_HEADER_SIZE + i] = static_cast<uint8_t>(i);
+  }
+  struct iovec piece = { buffer.data() + TUNNEL_HEADER_SIZE, 100 };
+  auto sealed = port.seal(1, &piece, 1, buffer.data(), buffer.size());
+  ASSERT_TRUE(sealed.has_value());
+  EXPECT_EQ(*sealed, buffer.size());
+
+  auto opened = vswitch.open(buffer.data(), buffer.size());
+  ASSERT_TRUE(opened.has_value());
+  ASSERT_EQ(opened->size, 100u);
+  for (size_t i = 0; i < 100; ++i)
+  {
+    EXPECT_EQ(opened->data[i], static_cast<uint8_t>(i));
+  }
+
+  EXPECT_EQ(port.seal(1, &piece, 1, buffer.data(), buffer.size() - 1).error(), TunnelError::BufferTooSmall);
+  EXPECT_EQ(port.seal(2, &piece, 1, buffer.data(), buffer.size()).error(), TunnelError::UnknownKey);
+}
+
+TEST(TunnelCryptoTest, RejectsForgeriesAndReplays)
+{
+  Tunnel ends = tunnel(TunnelCipher::ChaCha20Poly1305);
+  if (!ends.port)
+  {
+    GTEST_SKIP() << "Built without OpenSSL";
+  }
+  TunnelContext port(*ends.port);
+  TunnelContext vswitch(*ends.vswitch);
+  const std::vector<uint8_t> frame(64, 0x11);
+
+  std::vector<uint8_t> first = seal(port, 1, frame);
+  std::vector<uint8_t> copy = first;
+  ASSERT_TRUE(vswitch.open(first.data(), first.size()).has_value());
+  EXPECT_EQ(vswitch.open(copy.data(), copy.size()).error(), TunnelError::Replayed);
+
+  std::vector<uint8_t> tampered = seal(port, 1, frame);
+  tampered[TUNNEL_HEADER_SIZE + 3] ^= 1;
+  EXPECT_EQ(vswitch.open(tampered.data(), tampered.size()).error(), TunnelError::AuthenticationFailed);
+
+  std::vector<uint8_t> header = seal(port, 1, frame);
+  // The session is authenticated too; a newer one gets past the stale-session check to reach it
+  size_t byte = 11;
+  while (++header[byte] == 0 && byte > 4)
+  {
+    --byte;  // Carry into the next byte of the big-endian session
+  }
+  EXPECT_EQ(vswitch.open(header.data(), header.size()).error(), TunnelError::AuthenticationFailed);
+
+  std::vector<uint8_t> unknown = seal(port, 1, frame);
+  unknown[3] = 9;
+  EXPECT_EQ(vswitch.open(unknown.data(), unknown.size()).error(), TunnelError::UnknownKey);
+  EXPECT_EQ(vswitch.open(unknown.data(), TUNNEL_OVERHEAD - 1).error(), TunnelError::Malformed);
+
+  // A restarted VPort seals in a newer session; the old one's datagrams are then stale
+  std::vector<uint8_t> old_session = seal(port, 1, frame);
+  auto restarted = TunnelKeyring::create(TunnelCipher::ChaCha20Poly1305, TunnelRole::Port, test_keys());
+  ASSERT_TRUE(restarted.has_value());
+  EXPECT_GT((*restarted)->session(), ends.port->session());
+  TunnelContext new_port(**restarted);
+  std::vector<uint8_t> new_session = seal(new_port, 1, frame);
+  std::vector<uint8_t> resent = new_session;
+  ASSERT_TRUE(vswitch.open(new_session.data(), new_session.size()).has_value());
+  EXPECT_EQ(vswitch.open(old_session.data(), old_session.size()).error(), TunnelError::Replayed);
+
+  // Another thread's context shares the windows
+  TunnelContext other(*ends.vswitch);
+  EXPECT_EQ(other.open(resent.data(), resent.size()).error(), TunnelError::Replayed);
+}
+
+TEST(TunnelCryptoTest, SealsAndOpensBursts)
+{
+  Tunnel ends = tunnel(TunnelCipher::Aes256Gcm);
+  if (!ends.port)
+  {
+    GTEST_SKIP() << "Built without OpenSSL";
+  }
+  TunnelContext port(*ends.port);
+  TunnelContext vswitch(*ends.vswitch);
+
+  // A spliced copy (a VLAN tag pushed) is sealed with its splice applied
+  const std::vector<uint8_t> frame(80, 0x42);
+  std::vector<OutboundDatagram> burst(3);
+  const Endpoint destination("127.0.0.1", 9000);
+  for (auto& datagram : burst)
+  {
+    datagram.data = frame.data();
+    datagram.size = frame.size();
+    datagram.destination = destination;
+  }
+  burst[1].splice_at = 12;
+  burst[1].splice_size = 4;
+  const uint32_t keys[] = { 1, 99, 7 };
+
+  const size_t stride = 128 + TUNNEL_OVERHEAD;
+  std::vector<uint8_t> arena(burst.size() * stride);
+  size_t kept = vswitch.seal_batch(burst.data(), keys, burst.size(), arena.data(), stride);
+  ASSERT_EQ(kept, 2u);  // Key 99 is unknown
+  EXPECT_EQ(burst[0].data, arena.data());
+  EXPECT_EQ(burst[1].data, arena.data() + 2 * stride);
+  EXPECT_EQ(burst[1].destination, destination);
+
+  std::vector<InboundDatagram> received(3);
+  for (size_t i = 0; i < kept; ++i)
+  {
+    received[i].data = const_cast<uint8_t*>(burst[i].data);
+    received[i].size = burst[i].size;
+  }
+  received[2] = received[0];
+  received[2].truncated = true;
+  std::vector<TunnelFrame> frames(3);
+  EXPECT_EQ(port.open_batch(received.data(), received.size(), frames.data()), 2u);
+  EXPECT_EQ(frames[0].key_id, 1u);
+  EXPECT_EQ(frames[0].size, frame.size());
+  EXPECT_EQ(frames[1].key_id, 7u);
+  EXPECT_EQ(frames[2].data, nullptr);
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
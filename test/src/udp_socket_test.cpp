@@ -7,6 +7,7 @@
 
 #include <gtest/gtest.h>
 
+#include <chrono>
 #include <sstream>
 #include <thread>
 
@@ -71,6 +72,53 @@ TEST(EndpointTest, IsValid)
   EXPECT_FALSE(invalid_both.is_valid());
 }
 
+TEST(EndpointTest, UnparseableAddressIsInvalid)
+{
+  Endpoint hostname("invalid.address", 8080);
+  EXPECT_FALSE(hostname.is_valid());
+  EXPECT_EQ(hostname.family(), AF_UNSPEC);
+  EXPECT_EQ(hostname.address(), "");
+  EXPECT_EQ(hostname.port(), 8080);
+}
+
+TEST(EndpointTest, Ipv6)
+{
+  Endpoint endpoint("::1", 9000);
+  EXPECT_TRUE(endpoint.is_valid());
+  EXPECT_EQ(endpoint.family(), AF_INET6);
+  EXPECT_EQ(endpoint.address(), "::1");
+  EXPECT_EQ(endpoint.to_string(), "[::1]:9000");
+  EXPECT_EQ(endpoint.sockaddr_size(), sizeof(struct sockaddr_in6));
+  EXPECT_NE(endpoint, Endpoint("127.0.0.1", 9000));
+}
+
+TEST(EndpointTest, BinarySockaddr)
+{
+  Endpoint endpoint("10.1.2.3", 4321);
+  ASSERT_EQ(endpoint.family(), AF_INET);
+  ASSERT_EQ(endpoint.sockaddr_size(), sizeof(struct sockaddr_in));
+
+  const auto* addr = reinterpret_cast<const struct sockaddr_in*>(endpoint.as_sockaddr());
+  EXPECT_EQ(ntohs(addr->sin_port), 4321);
+  EXPECT_EQ(ntohl(addr->sin_addr.s_addr), 0x0a010203u);
+
+  // Round trip through a kernel-style sockaddr
+  EXPECT_EQ(Endpoint(*addr), endpoint);
+}
+
+TEST(EndpointTest, Hash)
+{
+  std::hash<Endpoint> hasher;
+  Endpoint ep1("192.168.1.1", 8080);
+  Endpoint ep2("192.168.1.1", 8080);
+  Endpoint ep3("192.168.1.1", 8081);
+  Endpoint ep4("192.168.1.2", 8080);
+
+  EXPECT_EQ(hasher(ep1), hasher(ep2));
+  EXPECT_NE(hasher(ep1), hasher(ep3));
+  EXPECT_NE(hasher(ep1), hasher(ep4));
+}
+
 // ============================================================================
 // UdpSocket Tests
 // ============================================================================
@@ -271,6 +319,362 @@ TEST(UdpSocketTest, SendAndReceiveWithPointer)
   }
 }
 
+TEST(UdpSocketTest, SendBatchAndReceiveBatch)
+{
+  auto sender_result = UdpSocket::create();
+  ASSERT_TRUE(sender_result.has_value());
+  UdpSocket sender = std::move(*sender_result);
+
+  auto receiver_result = UdpSocket::create();
+  ASSERT_TRUE(receiver_result.has_value());
+  UdpSocket receiver = std::move(*receiver_result);
+
+  uint16_t test_port = 20003;
+  auto bind_result = receiver.bind("127.0.0.1", test_port);
+  if (!bind_result.has_value())
+  {
+    test_port = 20004;
+    bind_result = receiver.bind("127.0.0.1", test_port);
+  }
+  ASSERT_TRUE(bind_result.has_value());
+
+  // Three datagrams, two of which share one buffer, plus one with no destination
+  uint8_t first[] = {0x01, 0x02, 0x03};
+  uint8_t second[] = {0x04, 0x05};
+  Endpoint dest("127.0.0.1", test_port);
+  std::vector<OutboundDatagram> outgoing = {
+      {first, sizeof(first), dest}, {second, sizeof(second), dest}, {first, sizeof(first), Endpoint{}},
+      {first, sizeof(first), dest}};
+
+  auto send_result = sender.send_batch(outgoing);
+  ASSERT_TRUE(send_result.has_value());
+  EXPECT_EQ(*send_result, 3);  // The invalid destination is skipped
+
+  std::vector<std::vector<uint8_t>> storage(8, std::vector<uint8_t>(1024));
+  std::vector<InboundDatagram> incoming(storage.size());
+  for (size_t i = 0; i < storage.size(); ++i)
+  {
+    incoming[i].data = storage[i].data();
+    incoming[i].capacity = storage[i].size();
+  }
+
+  size_t total = 0;
+  while (total < 3)
+  {
+    auto recv_result = receiver.receive_batch(incoming.data() + total, incoming.size() - total);
+    ASSERT_TRUE(recv_result.has_value());
+    ASSERT_GT(*recv_result, 0);
+    total += *recv_result;
+  }
+
+  ASSERT_EQ(total, 3);
+  EXPECT_EQ(incoming[0].size, sizeof(first));
+  EXPECT_EQ(incoming[1].size, sizeof(second));
+  EXPECT_EQ(incoming[2].size, sizeof(first));
+  EXPECT_EQ(incoming[1].data[0], 0x04);
+  EXPECT_EQ(incoming[0].sender.address(), "127.0.0.1");
+}
+
+TEST(UdpSocketTest, SendBatchAppliesSplices)
+{
+  auto sender = UdpSocket::create();
+  auto receiver = UdpSocket::create();
+  ASSERT_TRUE(sender.has_value() && receiver.has_value());
+  ASSERT_TRUE(receiver->bind("127.0.0.1", 0).has_value());
+  ASSERT_TRUE(receiver->set_receive_timeout(std::chrono::milliseconds(1000)));
+  Endpoint dest = *receiver->bound_endpoint();
+
+  // One shared buffer: sent as is, with two bytes inserted, and with two bytes cut
+  const uint8_t frame[] = { 1, 2, 3, 4, 5, 6 };
+  std::vector<OutboundDatagram> outgoing(3, OutboundDatagram{ frame, sizeof(frame), dest });
+  outgoing[1].splice_at = 2;
+  outgoing[1].splice_size = 2;
+  outgoing[1].splice_bytes[0] = 0xaa;
+  outgoing[1].splice_bytes[1] = 0xbb;
+  outgoing[2].splice_at = 1;
+  outgoing[2].splice_cut = 2;
+  EXPECT_EQ(outgoing[1].wire_size(), 8u);
+  EXPECT_EQ(outgoing[2].wire_size(), 4u);
+
+  auto send_result = sender->send_batch(outgoing);
+  ASSERT_TRUE(send_result.has_value());
+  EXPECT_EQ(*send_result, 3u);
+
+  const std::vector<std::vector<uint8_t>> expected = {
+    { 1, 2, 3, 4, 5, 6 }, { 1, 2, 0xaa, 0xbb, 3, 4, 5, 6 }, { 1, 4, 5, 6 }
+  };
+  for (const auto& want : expected)
+  {
+    auto received = receiver->receive_from();
+    ASSERT_TRUE(received.has_value());
+    EXPECT_EQ(received->first, want);
+  }
+}
+
+TEST(UdpSocketTest, ReceiveIntoPooledBuffer)
+{
+  auto sender_result = UdpSocket::create();
+  ASSERT_TRUE(sender_result.has_value());
+  UdpSocket sender = std::move(*sender_result);
+
+  auto receiver_result = UdpSocket::create();
+  ASSERT_TRUE(receiver_result.has_value());
+  UdpSocket receiver = std::move(*receiver_result);
+
+  uint16_t test_port = 20005;
+  auto bind_result = receiver.bind("127.0.0.1", test_port);
+  if (!bind_result.has_value())
+  {
+    test_port = 20006;
+    bind_result = receiver.bind("127.0.0.1", test_port);
+  }
+  ASSERT_TRUE(bind_result.has_value());
+
+  std::vector<uint8_t> test_data = {0x10, 0x20, 0x30};
+  ASSERT_TRUE(sender.send_to(test_data, Endpoint("127.0.0.1", test_port)).has_value());
+
+  FramePool pool(1);
+  FrameBuffer buffer = pool.acquire();
+  auto recv_result = receiver.receive_from(buffer);
+  ASSERT_TRUE(recv_result.has_value());
+  EXPECT_EQ(recv_result->address(), "127.0.0.1");
+  ASSERT_EQ(buffer.size(), test_data.size());
+  EXPECT_EQ(std::vector<uint8_t>(buffer.data(), buffer.data() + buffer.size()), test_data);
+
+  // An invalid buffer cannot be filled
+  FrameBuffer empty;
+  auto empty_result = receiver.receive_from(empty);
+  EXPECT_FALSE(empty_result.has_value());
+}
+
+TEST(UdpSocketTest, ReusePortAndBoundEndpoint)
+{
+  auto first_result = UdpSocket::create();
+  auto second_result = UdpSocket::create();
+  ASSERT_TRUE(first_result.has_value());
+  ASSERT_TRUE(second_result.has_value());
+  UdpSocket first = std::move(*first_result);
+  UdpSocket second = std::move(*second_result);
+
+  ASSERT_TRUE(first.set_reuse_port(true).has_value());
+  ASSERT_TRUE(second.set_reuse_port(true).has_value());
+  ASSERT_TRUE(first.bind("127.0.0.1", 0).has_value());
+
+  // The kernel-assigned port is visible through bound_endpoint()
+  auto bound = first.bound_endpoint();
+  ASSERT_TRUE(bound.has_value());
+  EXPECT_NE(bound->port(), 0);
+  EXPECT_EQ(bound->address(), "127.0.0.1");
+
+  // A second SO_REUSEPORT socket can share the same port
+  EXPECT_TRUE(second.bind("127.0.0.1", bound->port()).has_value());
+}
+
+TEST(UdpSocketTest, ReceiveTimeout)
+{
+  auto socket_result = UdpSocket::create();
+  ASSERT_TRUE(socket_result.has_value());
+  UdpSocket socket = std::move(*socket_result);
+  ASSERT_TRUE(socket.bind("127.0.0.1", 0).has_value());
+  ASSERT_TRUE(socket.set_receive_timeout(std::chrono::milliseconds(20)).has_value());
+
+  auto result = socket.receive_from(64);
+  ASSERT_FALSE(result.has_value());
+  EXPECT_EQ(result.error(), UdpError::ReceiveFailed);
+}
+
+TEST(UdpSocketTest, NonBlockingReceiveWouldBlock)
+{
+  auto socket_result = UdpSocket::create();
+  ASSERT_TRUE(socket_result.has_value());
+  UdpSocket socket = std::move(*socket_result);
+  ASSERT_TRUE(socket.bind("127.0.0.1", 0).has_value());
+  ASSERT_TRUE(socket.set_nonblocking(true).has_value());
+
+  FramePool pool(1);
+  FrameBuffer buffer = pool.acquire();
+  auto result = socket.receive_from(buffer);
+  ASSERT_FALSE(result.has_value());
+  EXPECT_EQ(result.error(), UdpError::WouldBlock);
+
+  std::vector<InboundDatagram> datagrams(1);
+  datagrams[0].data = buffer.data();
+  datagrams[0].capacity = buffer.capacity();
+  auto batch = socket.receive_batch(datagrams);
+  ASSERT_FALSE(batch.has_value());
+  EXPECT_EQ(batch.error(), UdpError::WouldBlock);
+
+  // Back to blocking: the receive timeout applies again
+  ASSERT_TRUE(socket.set_nonblocking(false).has_value());
+  ASSERT_TRUE(socket.set_receive_timeout(std::chrono::milliseconds(20)).has_value());
+  EXPECT_EQ(socket.receive_from(buffer).error(), UdpError::ReceiveFailed);
+}
+
+TEST(UdpSocketTest, SegmentedSendArrivesAsSeparateDatagrams)
+{
+  auto sender_result = UdpSocket::create();
+  auto receiver_result = UdpSocket::create();
+  ASSERT_TRUE(sender_result.has_value());
+  ASSERT_TRUE(receiver_result.has_value());
+  UdpSocket sender = std::move(*sender_result);
+  UdpSocket receiver = std::move(*receiver_result);
+  ASSERT_TRUE(receiver.bind("127.0.0.1", 0).has_value());
+  ASSERT_TRUE(receiver.set_receive_timeout(std::chrono::milliseconds(500)).has_value());
+  auto destination = receiver.bound_endpoint();
+  ASSERT_TRUE(destination.has_value());
+
+  // Two full datagrams and a short one in one buffer
+  std::vector<uint8_t> data(250);
+  for (size_t i = 0; i < data.size(); ++i)
+  {
+    data[i] = static_cast<uint8_t>(i / 100);
+  }
+  auto sent = sender.send_segments(data.data(), data.size(), 100, *destination);
+  ASSERT_TRUE(sent.has_value());
+  EXPECT_EQ(*sent, data.size());
+
+  FramePool pool(1);
+  FrameBuffer buffer = pool.acquire();
+  for (size_t i = 0; i < 3; ++i)
+  {
+    size_t segment_size = 0;
+    ASSERT_TRUE(receiver.receive_from(buffer, segment_size).has_value());
+    EXPECT_EQ(buffer.size(), i < 2 ? 100u : 50u);
+    EXPECT_EQ(segment_size, buffer.size());  // Without UDP_GRO nothing is coalesced
+    EXPECT_EQ(buffer.data()[0], i);
+  }
+}
+
+TEST(UdpSocketTest, GroReportsTheSegmentSize)
+{
+  auto sender_result = UdpSocket::create();
+  auto receiver_result = UdpSocket::create();
+  ASSERT_TRUE(sender_result.has_value());
+  ASSERT_TRUE(receiver_result.has_value());
+  UdpSocket sender = std::move(*sender_result);
+  UdpSocket receiver = std::move(*receiver_result);
+  ASSERT_TRUE(receiver.bind("127.0.0.1", 0).has_value());
+  if (!receiver.set_gro(true))
+  {
+    GTEST_SKIP() << "UDP_GRO is not supported by this kernel";
+  }
+  ASSERT_TRUE(receiver.set_receive_timeout(std::chrono::milliseconds(500)).has_value());
+  auto destination = receiver.bound_endpoint();
+  ASSERT_TRUE(destination.has_value());
+
+  std::vector<uint8_t> data(300, 7);
+  ASSERT_TRUE(sender.send_segments(data.data(), data.size(), 120, *destination).has_value());
+
+  // Loopback delivers the GSO send whole to a GRO socket; elsewhere it may come apart
+  FramePool pool(1, 1024);
+  FrameBuffer buffer = pool.acquire();
+  size_t received = 0;
+  while (received < data.size())
+  {
+    size_t segment_size = 0;
+    ASSERT_TRUE(receiver.receive_from(buffer, segment_size).has_value());
+    EXPECT_EQ(segment_size, std::min<size_t>(120, buffer.size()));
+    received += buffer.size();
+  }
+  EXPECT_EQ(received, data.size());
+}
+
+TEST(UdpSocketTest, SendToManySharesOneDatagram)
+{
+  auto sender_result = UdpSocket::create();
+  ASSERT_TRUE(sender_result.has_value());
+  UdpSocket sender = std::move(*sender_result);
+
+  std::vector<UdpSocket> receivers;
+  std::vector<Endpoint> destinations;
+  for (int i = 0; i < 3; ++i)
+  {
+    auto receiver = UdpSocket::create();
+    ASSERT_TRUE(receiver.has_value());
+    ASSERT_TRUE(receiver->bind("127.0.0.1", 0).has_value());
+    ASSERT_TRUE(receiver->set_receive_timeout(std::chrono::milliseconds(500)).has_value());
+    auto endpoint = receiver->bound_endpoint();
+    ASSERT_TRUE(endpoint.has_value());
+    destinations.push_back(*endpoint);
+    receivers.push_back(std::move(*receiver));
+  }
+  destinations.insert(destinations.begin() + 1, Endpoint());  // Skipped, not fatal
+
+  std::vector<uint8_t> data = { 9, 8, 7, 6 };
+  auto sent = sender.send_to_many(data.data(), data.size(), destinations);
+  ASSERT_TRUE(sent.has_value());
+  EXPECT_EQ(*sent, 3u);
+  EXPECT_EQ(sender.zerocopy_pending(), 0u);
+
+  for (auto& receiver : receivers)
+  {
+    auto received = receiver.receive_from();
+    ASSERT_TRUE(received.has_value());
+    EXPECT_EQ(received->first, data);
+  }
+}
+
+TEST(UdpSocketTest, ZerocopySendIsReaped)
+{
+  auto sender_result = UdpSocket::create();
+  auto receiver_result = UdpSocket::create();
+  ASSERT_TRUE(sender_result.has_value());
+  ASSERT_TRUE(receiver_result.has_value());
+  UdpSocket sender = std::move(*sender_result);
+  UdpSocket receiver = std::move(*receiver_result);
+  if (!sender.set_zerocopy(true))
+  {
+    GTEST_SKIP() << "SO_ZEROCOPY is not supported by this kernel";
+  }
+  EXPECT_TRUE(sender.zerocopy_enabled());
+  ASSERT_TRUE(receiver.bind("127.0.0.1", 0).has_value());
+  ASSERT_TRUE(receiver.set_receive_timeout(std::chrono::milliseconds(500)).has_value());
+  auto destination = receiver.bound_endpoint();
+  ASSERT_TRUE(destination.has_value());
+
+  // A jumbo frame to the same port twice: both sends pin the one buffer
+  std::vector<uint8_t> jumbo(9000, 0x5a);
+  std::vector<Endpoint> destinations = { *destination, *destination };
+  auto sent = sender.send_to_many(jumbo.data(), jumbo.size(), destinations);
+  ASSERT_TRUE(sent.has_value());
+  EXPECT_EQ(*sent, 2u);
+
+  auto pending = sender.reap_zerocopy(std::chrono::milliseconds(1000));
+  ASSERT_TRUE(pending.has_value());
+  EXPECT_EQ(*pending, 0u);
+
+  for (int i = 0; i < 2; ++i)
+  {
+    auto received = receiver.receive_from(jumbo.size());
+    ASSERT_TRUE(received.has_value());
+    EXPECT_EQ(received->first, jumbo);
+  }
+
+  // Below UDP_ZEROCOPY_MIN_SIZE the payload is copied and nothing is left to reap
+  std::vector<uint8_t> small(64, 1);
+  ASSERT_TRUE(sender.send_to_many(small.data(), small.size(), destinations.data(), 1).has_value());
+  EXPECT_EQ(sender.zerocopy_pending(), 0u);
+}
+
+TEST(UdpSocketTest, BatchOnInvalidSocket)
+{
+  UdpSocket socket;
+  std::vector<InboundDatagram> incoming(1);
+  std::vector<OutboundDatagram> outgoing(1);
+
+  auto recv_result = socket.receive_batch(incoming);
+  EXPECT_FALSE(recv_result.has_value());
+  EXPECT_EQ(recv_result.error(), UdpError::InvalidSocket);
+
+  auto send_result = socket.send_batch(outgoing);
+  EXPECT_FALSE(send_result.has_value());
+  EXPECT_EQ(send_result.error(), UdpError::InvalidSocket);
+
+  const uint8_t byte = 0;
+  EXPECT_EQ(socket.send_to_many(&byte, 1, std::vector<Endpoint>(1)).error(), UdpError::InvalidSocket);
+  EXPECT_EQ(socket.reap_zerocopy(std::chrono::milliseconds(0)).error(), UdpError::InvalidSocket);
+}
+
 TEST(UdpSocketTest, ReceiveFromInvalidSocket)
 {
   UdpSocket socket;
@@ -0,0 +1,159 @@
+/**
+ * @file vlan_test.cpp
+ * @brief Unit tests for VLAN port membership
+ */
+
+#include "project/vlan.hpp"
+
+#include "project/ethernet_frame.hpp"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using namespace project;
+
+namespace
+{
+  std::vector<uint8_t> make_frame(uint16_t tpid = 0, uint16_t tci = 0)
+  {
+    std::vector<uint8_t> frame(tpid != 0 ? 64 : 60, 0);
+    frame[0] = 0xff;
+    size_t offset = 12;
+    if (tpid != 0)
+    {
+      frame[offset++] = static_cast<uint8_t>(tpid >> 8);
+      frame[offset++] = static_cast<uint8_t>(tpid);
+      frame[offset++] = static_cast<uint8_t>(tci >> 8);
+      frame[offset++] = static_cast<uint8_t>(tci);
+    }
+    frame[offset] = 0x08;  // IPv4
+    return frame;
+  }
+
+  /**
+   * @brief The bytes a datagram puts on the wire
+   */
+  std::vector<uint8_t> wire_bytes(const OutboundDatagram& datagram)
+  {
+    struct iovec iov[UDP_MAX_DATAGRAM_IOVECS];
+    std::vector<uint8_t> bytes;
+    for (size_t i = 0, count = datagram.to_iovecs(iov); i < count; ++i)
+    {
+      const auto* base = static_cast<const uint8_t*>(iov[i].iov_base);
+      bytes.insert(bytes.end(), base, base + iov[i].iov_len);
+    }
+    return bytes;
+  }
+
+  OutboundDatagram egress(const std::vector<uint8_t>& frame, uint16_t vlan, bool tagged)
+  {
+    OutboundDatagram datagram{ frame.data(), frame.size(), Endpoint("127.0.0.1", 9) };
+    set_vlan_egress(datagram, vlan, tagged);
+    return datagram;
+  }
+}  // namespace
+
+TEST(VlanTest, ParsesAccessAndTrunkPorts)
+{
+  auto access = parse_vlan_port(VlanMode::Access, "10.0.0.2=10");
+  ASSERT_TRUE(access.has_value());
+  EXPECT_EQ(access->endpoint, Endpoint("10.0.0.2", 0));
+  EXPECT_EQ(access->mode, VlanMode::Access);
+  EXPECT_EQ(access->vlan, 10);
+
+  auto trunk = parse_vlan_port(VlanMode::Trunk, "10.0.0.3:4000=10,20-22/1");
+  ASSERT_TRUE(trunk.has_value());
+  EXPECT_EQ(trunk->endpoint, Endpoint("10.0.0.3", 4000));
+  EXPECT_EQ(trunk->vlan, 1);
+  EXPECT_EQ(trunk->allowed, (std::vector<uint16_t>{ 10, 20, 21, 22 }));
+
+  auto all = parse_vlan_port(VlanMode::Trunk, "[::1]:5000=all");
+  ASSERT_TRUE(all.has_value());
+  EXPECT_EQ(all->endpoint, Endpoint("::1", 5000));
+  EXPECT_EQ(all->vlan, 0);
+  EXPECT_TRUE(all->allowed.empty());
+  EXPECT_EQ(parse_vlan_port(VlanMode::Access, "fd00::2=7")->endpoint, Endpoint("fd00::2", 0));
+
+  EXPECT_EQ(parse_vlan_port(VlanMode::Access, "10.0.0.2").error(), VlanError::InvalidSpec);
+  EXPECT_EQ(parse_vlan_port(VlanMode::Access, "nowhere=10").error(), VlanError::InvalidAddress);
+  EXPECT_EQ(parse_vlan_port(VlanMode::Access, "10.0.0.2=4095").error(), VlanError::InvalidVlanId);
+  EXPECT_EQ(parse_vlan_port(VlanMode::Trunk, "10.0.0.2=20-10").error(), VlanError::InvalidVlanId);
+  EXPECT_STREQ(to_string(VlanError::InvalidVlanId), "Invalid VLAN ID");
+}
+
+TEST(VlanTest, AccessPortAcceptsOnlyItsVlan)
+{
+  VlanPort port = VlanPort::access(10);
+  EXPECT_EQ(port.ingress_vlan(make_frame().data(), 64), 10);
+  EXPECT_EQ(port.ingress_vlan(make_frame(EtherType::VLAN, 0x6000).data(), 64), 10);  // Priority-tagged
+  EXPECT_EQ(port.ingress_vlan(make_frame(EtherType::VLAN, 20).data(), 64), 0);
+  EXPECT_TRUE(port.member(10));
+  EXPECT_FALSE(port.member(20));
+  EXPECT_FALSE(port.egress_tagged(10));
+}
+
+TEST(VlanTest, TrunkCarriesItsAllowedVlansTagged)
+{
+  VlanPort port = VlanPort::trunk(1, { 10, 20 });
+  EXPECT_EQ(port.ingress_vlan(make_frame(EtherType::VLAN, 0xa014).data(), 64), 20);
+  EXPECT_EQ(port.ingress_vlan(make_frame(EtherType::QinQ, 10).data(), 64), 10);
+  EXPECT_EQ(port.ingress_vlan(make_frame(EtherType::VLAN, 30).data(), 64), 0);
+  EXPECT_EQ(port.ingress_vlan(make_frame().data(), 64), 1);  // Native
+  EXPECT_EQ(port.ingress_vlan(make_frame(EtherType::VLAN, 10).data(), ETHERNET_HEADER_SIZE), 0);
+  EXPECT_TRUE(port.egress_tagged(10));
+  EXPECT_FALSE(port.egress_tagged(1));
+
+  VlanPort no_native = VlanPort::trunk(0, {});
+  EXPECT_EQ(no_native.ingress_vlan(make_frame().data(), 64), 0);
+  EXPECT_EQ(no_native.ingress_vlan(make_frame(EtherType::VLAN, 4094).data(), 64), 4094);
+  EXPECT_TRUE(no_native.member(2));
+}
+
+TEST(VlanTest, MapResolvesExactThenAddressThenDefault)
+{
+  std::vector<VlanPortConfig> ports(2);
+  ports[0].endpoint = Endpoint("10.0.0.2", 0);
+  ports[0].vlan = 10;
+  ports[1].endpoint = Endpoint("10.0.0.2", 4000);
+  ports[1].mode = VlanMode::Trunk;
+  ports[1].vlan = 0;
+
+  auto map = VlanMap::create(ports, 5);
+  ASSERT_TRUE(map.has_value());
+  EXPECT_TRUE(map->enabled());
+  EXPECT_EQ(map->port(Endpoint("10.0.0.2", 4000)).mode(), VlanMode::Trunk);
+  EXPECT_TRUE(map->port(Endpoint("10.0.0.2", 4001)).member(10));
+  EXPECT_TRUE(map->port(Endpoint("10.0.0.3", 4000)).member(5));
+  EXPECT_FALSE(VlanMap().enabled());
+
+  ports.push_back(ports[0]);
+  EXPECT_EQ(VlanMap::create(ports).error(), VlanError::DuplicatePort);
+  EXPECT_EQ(VlanMap::create({}, 0).error(), VlanError::InvalidVlanId);
+}
+
+TEST(VlanTest, EgressPushesPopsAndRewritesTags)
+{
+  const auto untagged = make_frame();
+  const auto tagged10 = make_frame(EtherType::VLAN, 0xa00a);  // PCP 5, VID 10
+
+  // Untagged out of an access port, and already-right tags: data goes out as is
+  EXPECT_FALSE(egress(untagged, 10, false).spliced());
+  EXPECT_FALSE(egress(tagged10, 10, true).spliced());
+
+  // Push onto an untagged frame
+  auto pushed = egress(untagged, 10, true);
+  EXPECT_EQ(pushed.wire_size(), untagged.size() + VLAN_TAG_SIZE);
+  EXPECT_EQ(wire_bytes(pushed), make_frame(EtherType::VLAN, 10));
+
+  // Pop, and rewrite the VID keeping the priority
+  EXPECT_EQ(wire_bytes(egress(tagged10, 10, false)), untagged);
+  EXPECT_EQ(wire_bytes(egress(tagged10, 20, true)), make_frame(EtherType::VLAN, 0xa014));
+  EXPECT_EQ(wire_bytes(egress(make_frame(EtherType::QinQ, 10), 10, true)), make_frame(EtherType::VLAN, 10));
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}